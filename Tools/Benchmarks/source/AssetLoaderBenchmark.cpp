@@ -0,0 +1,303 @@
+// Asset loader benchmark.
+//
+// Prefetches tilesets of a map with AssetLoader and uploads them with a per-frame time budget, checking that handles
+// only move from loading to ready. Cancels a texture while it is being decoded and another while it is queued, and
+// checks they stay cancelled and can be requested again. Checks that a texture requested twice is cancelled only
+// by both requests and that the same file with another transparent color is another texture. Finally loads the map with TmxMap::setAssetLoader, which
+// must use the prefetched textures, and compares load times to loading without prefetch and without the loader.
+#include "Benchmarks.h"
+#include <AssetLoader.h>
+#include <Map.h>
+#include <Tileset.h>
+#include <SpriteSheet.h>
+#include <Thread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int MAP_SIZE = 64;
+	const int NUM_TILESETS = 4;
+	const int TILE_SIZE = 32;
+	const int TILESET_SIZE = 1024;
+	const int LARGE_TEXTURE_SIZE = 2048;
+	const char* const MAP_FILE_NAME = "assets_map.tmx";
+	const char* const LARGE_TEXTURE_FILE_NAME = "assets_large.png";
+	const char* const QUEUED_TEXTURE_FILE_NAME = "assets_queued.png";
+	const float UPDATE_BUDGET = 1.0f; // Milliseconds per frame for AssetLoader::update.
+	const int MAX_FRAMES = 10000;
+
+	std::string getTilesetFileName(int index)
+	{
+		char fileName[64];
+		sprintf(fileName, "assets_tiles_%d.png", index);
+		return fileName;
+	}
+
+	/** Writes map with ground layer using tiles of all tilesets. */
+	bool writeMap()
+	{
+		FILE* file = fopen(MAP_FILE_NAME, "wb");
+		if( file == 0 )
+		{
+			return false;
+		}
+
+		const int tilesPerSet = (TILESET_SIZE/TILE_SIZE)*(TILESET_SIZE/TILE_SIZE);
+		fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+		fprintf(file, "<map version=\"1.0\" orientation=\"orthogonal\" width=\"%d\" height=\"%d\" tilewidth=\"%d\" tileheight=\"%d\">\n",
+			MAP_SIZE, MAP_SIZE, TILE_SIZE, TILE_SIZE);
+		for( int i=0; i<NUM_TILESETS; ++i )
+		{
+			fprintf(file, " <tileset firstgid=\"%d\" name=\"tiles%d\" tilewidth=\"%d\" tileheight=\"%d\">\n", 1 + i*tilesPerSet, i, TILE_SIZE, TILE_SIZE);
+			fprintf(file, "  <image source=\"%s\" width=\"%d\" height=\"%d\"/>\n", getTilesetFileName(i).c_str(), TILESET_SIZE, TILESET_SIZE);
+			fprintf(file, " </tileset>\n");
+		}
+		fprintf(file, " <layer name=\"Ground\" width=\"%d\" height=\"%d\">\n  <data encoding=\"csv\">\n", MAP_SIZE, MAP_SIZE);
+		for( int i=0; i<MAP_SIZE*MAP_SIZE; ++i )
+		{
+			fprintf(file, "%d%s", 1 + (i*7) % (NUM_TILESETS*tilesPerSet), (i < MAP_SIZE*MAP_SIZE-1) ? "," : "\n");
+		}
+		fprintf(file, "  </data>\n </layer>\n</map>\n");
+		fclose(file);
+		return true;
+	}
+
+	/** Records states of handles and counts transitions other than from loading to ready. */
+	struct StateTracker
+	{
+		std::vector< Ref<AssetHandle> >		handles;
+		std::vector<AssetHandle::State>		states;
+		int									numInvalidTransitions;
+
+		void add(AssetHandle* handle)
+		{
+			for( size_t i=0; i<handles.size(); ++i )
+			{
+				if( handles[i].ptr() == handle )
+				{
+					return;
+				}
+			}
+			handles.push_back(handle);
+			states.push_back(handle->getState());
+		}
+
+		void check()
+		{
+			for( size_t i=0; i<handles.size(); ++i )
+			{
+				AssetHandle::State state = handles[i]->getState();
+				if( state != states[i] && (states[i] != AssetHandle::STATE_LOADING || state != AssetHandle::STATE_READY) )
+				{
+					++numInvalidTransitions;
+				}
+				states[i] = state;
+			}
+		}
+	};
+
+	/** Returns true, if textures of tilesets are same as textures of dependencies of prefetch handle. */
+	bool usesTextures(TmxMap* map, AssetHandle* prefetch)
+	{
+		if( map->getNumTilesets() != prefetch->getNumDependencies() )
+		{
+			return false;
+		}
+
+		for( int i=0; i<map->getNumTilesets(); ++i )
+		{
+			if( map->getTileset(i)->getSpriteSheet()->getTexture() != prefetch->getDependency(i)->getTexture() )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** Loads map with given asset loader, clearing its cache first if requested, or without loader if it is 0. */
+	struct MapLoad
+	{
+		AssetLoader* loader;
+		bool clearCache;
+		bool loaded;
+
+		void operator()()
+		{
+			static DefaultComponentFactory componentFactory;
+			if( loader != 0 && clearCache )
+			{
+				loader->clearCache();
+			}
+
+			Ref<TmxMap> map = new TmxMap();
+			map->setAssetLoader(loader);
+			loaded = map->loadMapFile(MAP_FILE_NAME, &componentFactory);
+		}
+	};
+
+	/**
+	 * Requests large texture, cancels it while a loader thread decodes it and cancels another texture while it
+	 * is queued behind it. Returns false, if decoding could not be caught or checks failed.
+	 */
+	bool cancelDuringDecode(bool& cancelledWhileQueued, bool& requestedAgain)
+	{
+		Ref<AssetLoader> loader = new AssetLoader(1);
+		for( int attempt=0; attempt<10; ++attempt )
+		{
+			Ref<AssetHandle> decoding = loader->loadTexture(LARGE_TEXTURE_FILE_NAME);
+			Thread::sleep(2);
+			Ref<AssetHandle> queued = loader->loadTexture(QUEUED_TEXTURE_FILE_NAME);
+			decoding->cancel();
+			const bool wasDecoding = loader->getNumPending() == 2;
+			queued->cancel();
+			cancelledWhileQueued = loader->getNumPending() == (wasDecoding ? 1 : 0) && queued->getState() == AssetHandle::STATE_CANCELLED;
+
+			// Decoded result of cancelled texture is thrown away in update.
+			StateTracker tracker = StateTracker();
+			tracker.add(decoding);
+			tracker.add(queued);
+			while( loader->getNumPending() > 0 || loader->getNumDecoded() > 0 )
+			{
+				loader->update(UPDATE_BUDGET);
+				tracker.check();
+				Thread::sleep(1);
+			}
+
+			const bool stayedCancelled = tracker.numInvalidTransitions == 0 && decoding->getState() == AssetHandle::STATE_CANCELLED
+				&& decoding->getTexture() == 0 && decoding->isDone() && !decoding->isReady();
+			if( !wasDecoding )
+			{
+				continue;
+			}
+
+			// Cancelled texture is not cached, so it is loaded again.
+			Ref<AssetHandle> again = loader->loadTexture(LARGE_TEXTURE_FILE_NAME);
+			loader->finish(again);
+			requestedAgain = again.ptr() != decoding.ptr() && again->isReady() && again->getTexture() != 0;
+			return stayedCancelled;
+		}
+		return false;
+	}
+
+	/** Returns true, if shared texture handle is cancelled only after all its requests and options are part of cache key. */
+	bool cancelSharedRequest()
+	{
+		Ref<AssetLoader> loader = new AssetLoader(1);
+		Ref<AssetHandle> first = loader->loadTexture(QUEUED_TEXTURE_FILE_NAME);
+		Ref<AssetHandle> second = loader->loadTexture(QUEUED_TEXTURE_FILE_NAME);
+		Ref<AssetHandle> other = loader->loadTexture(QUEUED_TEXTURE_FILE_NAME, AssetLoader::PRIORITY_NORMAL, Texture::FORMAT_DEFAULT, false, "ff00ff");
+		bool valid = first.ptr() == second.ptr() && other.ptr() != first.ptr();
+
+		// State changes only in update, cancel and finish, so the texture is still loading after the first cancel.
+		first->cancel();
+		valid = valid && second->getState() == AssetHandle::STATE_LOADING;
+		second->cancel();
+		valid = valid && second->getState() == AssetHandle::STATE_CANCELLED && other->getState() == AssetHandle::STATE_LOADING;
+		loader->finish(other);
+		return valid && other->isReady();
+	}
+}
+
+
+namespace benchmarks
+{
+	void runAssetLoaderBenchmark(int repeatCount)
+	{
+		bool filesWritten = writeTilesetPng(LARGE_TEXTURE_FILE_NAME, LARGE_TEXTURE_SIZE, TILE_SIZE)
+			&& writeTilesetPng(QUEUED_TEXTURE_FILE_NAME, TILESET_SIZE, TILE_SIZE) && writeMap();
+		for( int i=0; i<NUM_TILESETS && filesWritten; ++i )
+		{
+			filesWritten = writeTilesetPng(getTilesetFileName(i).c_str(), TILESET_SIZE, TILE_SIZE);
+		}
+
+		if( !filesWritten )
+		{
+			printf("  Asset files could not be written to current working directory%s\n", checkResult("assets/files", false));
+			return;
+		}
+
+		static DefaultComponentFactory componentFactory;
+		float bestPrefetchTime = -1.0f;
+		float bestMaxUpdate = -1.0f;
+		int numFrames = 0;
+		bool valid = true;
+		for( int repeat=0; repeat<repeatCount; ++repeat )
+		{
+			// Prefetch tilesets and upload them during frames with time budget.
+			Ref<AssetLoader> loader = new AssetLoader();
+			yam2d::ElapsedTimer timer;
+			yam2d::ElapsedTimer updateTimer;
+			timer.reset();
+			Ref<AssetHandle> prefetch = loader->prefetchMapTilesets(MAP_FILE_NAME);
+			StateTracker tracker = StateTracker();
+			tracker.add(prefetch);
+			float maxUpdate = 0.0f;
+			numFrames = 0;
+			while( !prefetch->isDone() && numFrames < MAX_FRAMES )
+			{
+				updateTimer.reset();
+				loader->update(UPDATE_BUDGET);
+				float time = 1000.0f*updateTimer.getTime();
+				maxUpdate = time > maxUpdate ? time : maxUpdate;
+				++numFrames;
+				for( int i=0; i<prefetch->getNumDependencies(); ++i )
+				{
+					tracker.add(prefetch->getDependency(i));
+				}
+				tracker.check();
+				Thread::sleep(1);
+			}
+			float prefetchTime = 1000.0f*timer.getTime();
+			valid = valid && prefetch->isReady() && prefetch->getNumDependencies() == NUM_TILESETS && tracker.numInvalidTransitions == 0;
+
+			// Map uses the prefetched textures without loading anything.
+			Ref<TmxMap> map = new TmxMap();
+			map->setAssetLoader(loader);
+			valid = valid && map->loadMapFile(MAP_FILE_NAME, &componentFactory) && usesTextures(map, prefetch) && loader->getNumPending() == 0;
+
+			if( bestPrefetchTime < 0.0f || prefetchTime < bestPrefetchTime )
+			{
+				bestPrefetchTime = prefetchTime;
+			}
+			if( bestMaxUpdate < 0.0f || maxUpdate < bestMaxUpdate )
+			{
+				bestMaxUpdate = maxUpdate;
+			}
+		}
+
+		// Load times with prefetched textures, with the loader finishing textures not prefetched and without the loader.
+		Ref<AssetLoader> loader = new AssetLoader();
+		Ref<AssetHandle> prefetch = loader->prefetchMapTilesets(MAP_FILE_NAME);
+		loader->finish(prefetch);
+		MapLoad mapLoad = MapLoad();
+		mapLoad.loader = loader;
+		float prefetchedLoad = measure(repeatCount, mapLoad);
+		mapLoad.clearCache = true;
+		float finishedLoad = measure(repeatCount, mapLoad);
+		mapLoad.loader = 0;
+		mapLoad.clearCache = false;
+		float syncLoad = measure(repeatCount, mapLoad);
+		valid = valid && mapLoad.loaded;
+
+		bool cancelledWhileQueued = false;
+		bool requestedAgain = false;
+		const bool cancelledWhileDecoding = cancelDuringDecode(cancelledWhileQueued, requestedAgain);
+		const bool cancelledShared = cancelSharedRequest();
+		valid = valid && cancelledWhileDecoding && cancelledWhileQueued && requestedAgain && cancelledShared;
+
+		printf("  prefetch %9.3f ms in %d frames, update %9.3f ms max (budget %.1f ms)\n", bestPrefetchTime, numFrames, bestMaxUpdate, UPDATE_BUDGET);
+		printf("  map load %9.3f ms prefetched %9.3f ms finished by loader %9.3f ms without loader\n", prefetchedLoad, finishedLoad, syncLoad);
+		printf("  cancel %s while decoding, %s while queued, %s again, %s shared%s\n", cancelledWhileDecoding ? "ok" : "FAILED",
+			cancelledWhileQueued ? "ok" : "FAILED", requestedAgain ? "loaded" : "NOT LOADED", cancelledShared ? "ok" : "FAILED",
+			checkResult("assets", valid));
+		addResult("assets/prefetch", bestPrefetchTime, "ms");
+		addResult("assets/max update", bestMaxUpdate, "ms");
+		addResult("assets/map load prefetched", prefetchedLoad, "ms");
+		addResult("assets/map load", syncLoad, "ms");
+	}
+}
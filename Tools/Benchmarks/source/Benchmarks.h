@@ -0,0 +1,115 @@
+// Benchmarks for yam2d engine.
+//
+// Each benchmark prints its results to standard output. Benchmarks create their
+// input data (synthetic maps etc.) to current working directory. Results added with
+// addResult can be written to JSON file and compared to a baseline, see main.cpp.
+// Correctness checks are recorded with checkResult, so that failing runs can be detected.
+#ifndef BENCHMARKS_H_
+#define BENCHMARKS_H_
+
+#include <ElapsedTimer.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+	/** Runs func repeatCount times and returns fastest run time in milliseconds. */
+	template<typename Func>
+	float measure(int repeatCount, Func& func)
+	{
+		yam2d::ElapsedTimer timer;
+		float best = -1.0f;
+		for( int i=0; i<repeatCount; ++i )
+		{
+			timer.reset();
+			func();
+			float time = 1000.0f*timer.getTime();
+			if( best < 0.0f || time < best )
+			{
+				best = time;
+			}
+		}
+		return best;
+	}
+
+	/** Returns number of bytes currently allocated with operator new. */
+	long long getAllocatedBytes();
+
+	/** Writes PNG tileset of size x size pixels with tiles of different colors. Returns false, if file could not be written. */
+	bool writeTilesetPng(const char* fileName, int size, int tileSize);
+
+	/** Adds result, which is written with writeResults and compared with compareResults. Smaller values must be better. */
+	void addResult(const std::string& name, double value, const char* unit);
+
+	/** 
+	 * Records correctness check of given name. Returns text to append to printed result: empty, if valid, otherwise 
+	 * "  INVALID RESULT". Benchmarks exits with code 3, if any check failed, see main.cpp.
+	 */
+	const char* checkResult(const std::string& name, bool valid);
+
+	/** Returns names of checks, which failed. */
+	const std::vector<std::string>& getFailedChecks();
+
+	/** Writes added results to JSON file. Returns false, if file could not be written. */
+	bool writeResults(const char* fileName);
+
+	/** 
+	 * Compares added results to results written earlier to baseline file and prints them. Returns number of results, 
+	 * which are larger than in baseline by more than thresholdPercent, or -1 if baseline could not be read.
+	 */
+	int compareResults(const char* baselineFileName, float thresholdPercent);
+
+	/** Decodes synthetic TMX maps of over million tiles with TmxReader and tmx-parser. */
+	void runTmxDecodeBenchmark(int repeatCount);
+
+	/** Measures broadphase building, moving and queries with 1k, 10k and 100k game objects. */
+	void runBroadphaseBenchmark(int repeatCount);
+
+	/** Tests small boxes against 10k and 100k game objects with GameObject::collidesTo and ExtentsBuffer. */
+	void runExtentsBenchmark(int repeatCount);
+
+	/** Compares collision tests against TileGrid and solid tile game objects, and measures raycasts. */
+	void runTileGridBenchmark(int repeatCount);
+
+	/** Compares path costs and search times of jump point search and hierarchical search to plain A*. */
+	void runPathfindingBenchmark(int repeatCount);
+
+	/** Compares steering agents with a shared flow field to searching a path for each agent. */
+	void runFlowFieldBenchmark(int repeatCount);
+
+	/** Compares Box2D static geometry of tile level as body per tile and merged with StaticTileBody. */
+	void runTilePhysicsBenchmark(int repeatCount);
+
+	/** Updates PhysicsWorld with different frame rates and measures updates with awake and sleeping bodies. */
+	void runPhysicsWorldBenchmark(int repeatCount);
+
+	/** Updates 20k game objects every frame and with UpdateScheduler distance bands. */
+	void runUpdateLodBenchmark(int repeatCount);
+
+	/** Runs parallel for, task graphs and recursively spawned jobs with JobSystem and checks results. */
+	void runJobSystemBenchmark(int repeatCount);
+
+	/** Updates parallel components of 20k game objects with different numbers of threads and checks results are equal. */
+	void runParallelUpdateBenchmark(int repeatCount);
+
+	/** Publishes render snapshots of 10k sprites and hands them over to render thread with different update and render rates. */
+	void runRenderSnapshotBenchmark(int repeatCount);
+
+	/** Measures cost of profiling zones and profiles parallel update of 20k game objects to Chrome trace. */
+	void runProfilerBenchmark(int repeatCount);
+
+	/** Loads synthetic tile maps, sprites, HUD texts and physics objects and measures load, update, batching and memory. */
+	void runScenarioBenchmark(int repeatCount);
+
+	/** Records input of a scripted session on headless Linux platform, replays it and measures frame times of the replay. */
+	void runReplayBenchmark(int repeatCount);
+
+	/** Walks camera across a streaming map and checks game objects survive eviction, reload and failed region writes. */
+	void runStreamingBenchmark(int repeatCount);
+
+	/** Prefetches map tilesets with AssetLoader under per-frame budget, cancels textures while decoding and loads the map with prefetched textures. */
+	void runAssetLoaderBenchmark(int repeatCount);
+}
+
+#endif // BENCHMARKS_H_
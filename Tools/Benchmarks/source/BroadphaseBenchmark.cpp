@@ -0,0 +1,237 @@
+// Broadphase benchmark.
+//
+// Scatters 1k, 10k and 100k game objects evenly to the world and measures cost of building,
+// moving and querying SpatialHashGrid and DynamicAabbTree. Brute force testing of every object
+// is measured for comparison.
+#include "Benchmarks.h"
+#include <GameObject.h>
+#include <SpatialHashGrid.h>
+#include <DynamicAabbTree.h>
+#include <math.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int NUM_QUERIES = 1000;
+	const float OBJECTS_PER_TILE = 0.05f;
+	const float QUERY_SIZE = 8.0f;
+	const int MAX_RESULTS = 1024;
+
+	typedef std::vector< Ref<GameObject> > GameObjectList;
+
+	struct Random
+	{
+		uint32_t state;
+
+		Random() : state(12345) {}
+
+		float next(float minValue, float maxValue)
+		{
+			state = state*1103515245u + 12345u;
+			return minValue + (maxValue - minValue) * float((state >> 8) & 0xffff) / 65535.0f;
+		}
+	};
+
+	// Counts overlapping pairs.
+	struct PairCounter : public Broadphase::PairCallback
+	{
+		int numPairs;
+
+		PairCounter() : numPairs(0) {}
+
+		virtual void onOverlap(GameObject*, GameObject*)
+		{
+			++numPairs;
+		}
+	};
+
+	struct Scene
+	{
+		GameObjectList gameObjects;
+		std::vector<vec2> queryPositions;
+		float worldSize;
+	};
+
+	void createScene(Scene& scene, int numObjects)
+	{
+		Random random;
+		scene.worldSize = sqrtf(float(numObjects) / OBJECTS_PER_TILE);
+		scene.gameObjects.clear();
+		for( int i=0; i<numObjects; ++i )
+		{
+			const vec2 position(random.next(0.0f, scene.worldSize), random.next(0.0f, scene.worldSize));
+			const vec2 size(random.next(0.5f, 2.0f), random.next(0.5f, 2.0f));
+			scene.gameObjects.push_back(new GameObject(0, 0, position, size));
+		}
+
+		scene.queryPositions.clear();
+		for( int i=0; i<NUM_QUERIES; ++i )
+		{
+			scene.queryPositions.push_back(vec2(random.next(0.0f, scene.worldSize), random.next(0.0f, scene.worldSize)));
+		}
+	}
+
+	// Brute force versions of broadphase queries.
+	int bruteForceQuery(const Scene& scene, const vec2& topLeft, const vec2& bottomRight)
+	{
+		int numResults = 0;
+		for( size_t i=0; i<scene.gameObjects.size(); ++i )
+		{
+			const GameObject* gameObject = scene.gameObjects[i].ptr();
+			if( gameObject->getLeft() <= bottomRight.x && topLeft.x <= gameObject->getRight() 
+				&& gameObject->getTop() <= bottomRight.y && topLeft.y <= gameObject->getBottom() )
+			{
+				++numResults;
+			}
+		}
+		return numResults;
+	}
+
+	int bruteForcePairs(Scene& scene)
+	{
+		int numPairs = 0;
+		for( size_t i=0; i<scene.gameObjects.size(); ++i )
+		{
+			for( size_t j=i+1; j<scene.gameObjects.size(); ++j )
+			{
+				if( scene.gameObjects[i].ptr()->collidesTo(scene.gameObjects[j].ptr()) )
+				{
+					++numPairs;
+				}
+			}
+		}
+		return numPairs;
+	}
+
+	struct Result
+	{
+		float buildMs;
+		float moveMs;
+		float aabbQueryUs;
+		float pointQueryUs;
+		float pairsMs;
+		int numQueryResults;
+		int numPairs;
+	};
+
+	void printResult(const char* name, const Result& result)
+	{
+		if( result.numPairs < 0 )
+		{
+			printf("  %-16s %9.3f %9.3f %11.3f %11.3f %11s %10d %9s\n", name, result.buildMs, result.moveMs, 
+				result.aabbQueryUs, result.pointQueryUs, "-", result.numQueryResults, "-");
+			return;
+		}
+
+		printf("  %-16s %9.3f %9.3f %11.3f %11.3f %11.3f %10d %9d\n", name, result.buildMs, result.moveMs, 
+			result.aabbQueryUs, result.pointQueryUs, result.pairsMs, result.numQueryResults, result.numPairs);
+	}
+
+	Result runBruteForce(Scene& scene, bool findPairs)
+	{
+		Result result;
+		ElapsedTimer timer;
+		result.buildMs = 0.0f;
+		result.moveMs = 0.0f;
+
+		timer.reset();
+		result.numQueryResults = 0;
+		for( int i=0; i<NUM_QUERIES; ++i )
+		{
+			const vec2& position = scene.queryPositions[i];
+			result.numQueryResults += bruteForceQuery(scene, position, position + vec2(QUERY_SIZE));
+		}
+		result.aabbQueryUs = 1000000.0f*timer.getTime() / float(NUM_QUERIES);
+
+		timer.reset();
+		for( int i=0; i<NUM_QUERIES; ++i )
+		{
+			bruteForceQuery(scene, scene.queryPositions[i], scene.queryPositions[i]);
+		}
+		result.pointQueryUs = 1000000.0f*timer.getTime() / float(NUM_QUERIES);
+
+		timer.reset();
+		result.numPairs = findPairs ? bruteForcePairs(scene) : -1;
+		result.pairsMs = findPairs ? 1000.0f*timer.getTime() : 0.0f;
+		return result;
+	}
+
+	Result runBroadphase(Scene& scene, Broadphase* broadphase)
+	{
+		Result result;
+		ElapsedTimer timer;
+		std::vector<GameObject*> results(MAX_RESULTS);
+
+		timer.reset();
+		for( size_t i=0; i<scene.gameObjects.size(); ++i )
+		{
+			broadphase->addGameObject(scene.gameObjects[i]);
+		}
+		result.buildMs = 1000.0f*timer.getTime();
+
+		// Move each object a bit and back, like objects moving during a frame.
+		timer.reset();
+		for( size_t i=0; i<scene.gameObjects.size(); ++i )
+		{
+			GameObject* gameObject = scene.gameObjects[i];
+			const vec2 position = gameObject->getPosition();
+			gameObject->setPosition(position + vec2(0.3f, 0.2f));
+			gameObject->setPosition(position);
+		}
+		result.moveMs = 1000.0f*timer.getTime();
+
+		timer.reset();
+		result.numQueryResults = 0;
+		for( int i=0; i<NUM_QUERIES; ++i )
+		{
+			const vec2& position = scene.queryPositions[i];
+			result.numQueryResults += broadphase->queryAabb(position, position + vec2(QUERY_SIZE), &results[0], MAX_RESULTS);
+		}
+		result.aabbQueryUs = 1000000.0f*timer.getTime() / float(NUM_QUERIES);
+
+		timer.reset();
+		for( int i=0; i<NUM_QUERIES; ++i )
+		{
+			broadphase->queryPoint(scene.queryPositions[i], &results[0], MAX_RESULTS);
+		}
+		result.pointQueryUs = 1000000.0f*timer.getTime() / float(NUM_QUERIES);
+
+		timer.reset();
+		PairCounter counter;
+		broadphase->findOverlappingPairs(&counter);
+		result.pairsMs = 1000.0f*timer.getTime();
+		result.numPairs = counter.numPairs;
+
+		broadphase->clear();
+		return result;
+	}
+}
+
+
+namespace benchmarks
+{
+	void runBroadphaseBenchmark(int repeatCount)
+	{
+		(void)repeatCount;
+		const int objectCounts[] = { 1000, 10000, 100000 };
+		for( int c=0; c<3; ++c )
+		{
+			Scene scene;
+			createScene(scene, objectCounts[c]);
+			printf("  %d objects, world %.0fx%.0f tiles, %d queries of %.0fx%.0f tiles\n", objectCounts[c], scene.worldSize, scene.worldSize, 
+				NUM_QUERIES, QUERY_SIZE, QUERY_SIZE);
+			printf("  %-16s %9s %9s %11s %11s %11s %10s %9s\n", "", "build ms", "move ms", "aabb us/q", "point us/q", "pairs ms", "hits", "pairs");
+
+			// Brute force pair test is too slow for largest scene.
+			printResult("brute force", runBruteForce(scene, objectCounts[c] <= 10000));
+
+			Ref<Broadphase> grid = new SpatialHashGrid(4.0f);
+			printResult("SpatialHashGrid", runBroadphase(scene, grid));
+
+			Ref<Broadphase> tree = new DynamicAabbTree();
+			printResult("DynamicAabbTree", runBroadphase(scene, tree));
+		}
+	}
+}
@@ -0,0 +1,204 @@
+// Extents buffer benchmark.
+//
+// Tests small boxes, like bullets, against 10k and 100k game objects. One box at a time with
+// GameObject::collidesTo is compared to ExtentsBuffer::testOverlap, and batches of boxes to
+// ExtentsBuffer::testOverlaps.
+#include "Benchmarks.h"
+#include <GameObject.h>
+#include <ExtentsBuffer.h>
+#include <math.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	typedef std::vector< Ref<GameObject> > GameObjectList;
+
+	const int NUM_BOXES = 256;
+	const int BOXES_PER_BATCH = 8;
+	const float OBJECTS_PER_TILE = 0.05f;
+	const float BOX_SIZE = 2.0f;
+
+	struct Random
+	{
+		uint32_t state;
+
+		Random() : state(54321) {}
+
+		float next(float minValue, float maxValue)
+		{
+			state = state*1103515245u + 12345u;
+			return minValue + (maxValue - minValue) * float((state >> 8) & 0xffff) / 65535.0f;
+		}
+	};
+
+	struct Scene
+	{
+		GameObjectList gameObjects;
+		GameObjectList boxes;
+		std::vector<vec2> topLefts;
+		std::vector<vec2> bottomRights;
+	};
+
+	void createScene(Scene& scene, int numObjects)
+	{
+		Random random;
+		float worldSize = sqrtf(float(numObjects) / OBJECTS_PER_TILE);
+		for( int i=0; i<numObjects; ++i )
+		{
+			const vec2 position(random.next(0.0f, worldSize), random.next(0.0f, worldSize));
+			const vec2 size(random.next(0.5f, 2.0f), random.next(0.5f, 2.0f));
+			scene.gameObjects.push_back(new GameObject(0, 0, position, size));
+		}
+
+		for( int i=0; i<NUM_BOXES; ++i )
+		{
+			const vec2 position(random.next(0.0f, worldSize), random.next(0.0f, worldSize));
+			GameObject* box = new GameObject(0, 0, position, vec2(BOX_SIZE));
+			scene.boxes.push_back(box);
+			scene.topLefts.push_back(vec2(box->getLeft(), box->getTop()));
+			scene.bottomRights.push_back(vec2(box->getRight(), box->getBottom()));
+		}
+	}
+
+	/** Tests each box against each game object with GameObject::collidesTo. */
+	struct CollidesToTest
+	{
+		Scene* scene;
+		int numHits;
+		float checksum;
+
+		void operator()()
+		{
+			numHits = 0;
+			checksum = 0.0f;
+			for( size_t b=0; b<scene->boxes.size(); ++b )
+			{
+				GameObject* box = scene->boxes[b].ptr();
+				for( size_t i=0; i<scene->gameObjects.size(); ++i )
+				{
+					vec2 normal;
+					if( box->collidesTo(scene->gameObjects[i].ptr(), &normal) )
+					{
+						++numHits;
+						checksum += normal.x + normal.y;
+					}
+				}
+			}
+		}
+	};
+
+	/** Tests one box at a time with ExtentsBuffer::testOverlap. */
+	struct TestOverlapTest
+	{
+		Scene* scene;
+		ExtentsBuffer* buffer;
+		bool computeNormals;
+		std::vector<uint32_t> masks;
+		std::vector<vec2> normals;
+		int numHits;
+		float checksum;
+
+		void operator()()
+		{
+			numHits = 0;
+			checksum = 0.0f;
+			masks.resize(buffer->getNumMaskWords());
+			normals.resize(buffer->getNumExtents());
+			for( size_t b=0; b<scene->boxes.size(); ++b )
+			{
+				if( !computeNormals )
+				{
+					numHits += buffer->testOverlap(scene->topLefts[b], scene->bottomRights[b], &masks[0]);
+					continue;
+				}
+
+				numHits += buffer->testOverlap(scene->topLefts[b], scene->bottomRights[b], &masks[0], &normals[0]);
+				for( size_t w=0; w<masks.size(); ++w )
+				{
+					for( int bit=0; masks[w] != 0 && bit<32; ++bit )
+					{
+						if( masks[w] & (1u << bit) )
+						{
+							const vec2& normal = normals[w*32 + bit];
+							checksum += normal.x + normal.y;
+						}
+					}
+				}
+			}
+		}
+	};
+
+	/** Tests boxes in batches with ExtentsBuffer::testOverlaps. */
+	struct TestOverlapsTest
+	{
+		Scene* scene;
+		ExtentsBuffer* buffer;
+		std::vector<uint32_t> masks;
+		int numHits;
+
+		void operator()()
+		{
+			numHits = 0;
+			masks.resize(buffer->getNumMaskWords()*BOXES_PER_BATCH);
+			for( int b=0; b<NUM_BOXES; b += BOXES_PER_BATCH )
+			{
+				numHits += buffer->testOverlaps(&scene->topLefts[b], &scene->bottomRights[b], BOXES_PER_BATCH, &masks[0]);
+			}
+		}
+	};
+
+	void printResult(const char* name, float milliseconds, int numTests, int numHits, int expectedHits)
+	{
+		printf("  %-26s %9.3f ms %7.3f ns/test %8d hits%s\n", name, milliseconds, 1000000.0f*milliseconds / float(numTests), 
+			numHits, benchmarks::checkResult(std::string("extents/") + name, numHits == expectedHits));
+	}
+}
+
+
+namespace benchmarks
+{
+	void runExtentsBenchmark(int repeatCount)
+	{
+		const int objectCounts[] = { 10000, 100000 };
+		for( int c=0; c<2; ++c )
+		{
+			Scene scene;
+			createScene(scene, objectCounts[c]);
+			Ref<ExtentsBuffer> buffer = new ExtentsBuffer();
+			for( size_t i=0; i<scene.gameObjects.size(); ++i )
+			{
+				buffer->addGameObject(scene.gameObjects[i]);
+			}
+
+			const int numTests = objectCounts[c]*NUM_BOXES;
+			printf("  %d objects, %d boxes of %.0fx%.0f tiles\n", objectCounts[c], NUM_BOXES, BOX_SIZE, BOX_SIZE);
+
+			CollidesToTest collidesTo = CollidesToTest();
+			collidesTo.scene = &scene;
+			float time = measure(repeatCount, collidesTo);
+			printResult("collidesTo", time, numTests, collidesTo.numHits, collidesTo.numHits);
+
+			TestOverlapTest testOverlap = TestOverlapTest();
+			testOverlap.scene = &scene;
+			testOverlap.buffer = buffer;
+			testOverlap.computeNormals = false;
+			time = measure(repeatCount, testOverlap);
+			printResult("testOverlap", time, numTests, testOverlap.numHits, collidesTo.numHits);
+
+			testOverlap.computeNormals = true;
+			time = measure(repeatCount, testOverlap);
+			printResult("testOverlap with normals", time, numTests, testOverlap.numHits, collidesTo.numHits);
+			printf("  normal checksum %.4f (collidesTo %.4f)\n", testOverlap.checksum, collidesTo.checksum);
+
+			TestOverlapsTest testOverlaps = TestOverlapsTest();
+			testOverlaps.scene = &scene;
+			testOverlaps.buffer = buffer;
+			time = measure(repeatCount, testOverlaps);
+			printResult("testOverlaps, 8 boxes", time, numTests, testOverlaps.numHits, collidesTo.numHits);
+
+			buffer->clear();
+		}
+	}
+}
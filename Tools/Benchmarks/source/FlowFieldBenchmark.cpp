@@ -0,0 +1,232 @@
+// Flow field benchmark.
+//
+// Builds flow field over 512x512 tile level and compares steering thousands of agents with it to searching
+// a path for each agent with Pathfinder. Distances of the flow field are checked against jump point search
+// and directions are checked by following them to the target.
+#include "Benchmarks.h"
+#include <FlowField.h>
+#include <Pathfinder.h>
+#include <math.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int MAP_SIZE = 512;
+	const int NUM_AGENTS = 10000;
+	const int NUM_SEARCHED_AGENTS = 200;
+	const float DIAGONAL_COST = 1.41421356f;
+
+	struct Random
+	{
+		uint32_t state;
+
+		Random() : state(13579) {}
+
+		int next(int maxValue)
+		{
+			state = state*1103515245u + 12345u;
+			return int((state >> 8) % uint32_t(maxValue));
+		}
+	};
+
+	struct Level
+	{
+		Ref<TileGrid> tileGrid;
+		vec2 target;
+		std::vector<vec2> agents;
+	};
+
+	void createLevel(Level& level)
+	{
+		Random random;
+		level.tileGrid = new TileGrid(MAP_SIZE, MAP_SIZE);
+		for( int i=0; i<MAP_SIZE*MAP_SIZE/40; ++i )
+		{
+			int x0 = random.next(MAP_SIZE-8);
+			int y0 = random.next(MAP_SIZE-8);
+			int w = 1 + random.next(8);
+			int h = 1 + random.next(8);
+			for( int y=y0; y<y0+h; ++y )
+			{
+				for( int x=x0; x<x0+w; ++x )
+				{
+					level.tileGrid->setSolid(x, y, true);
+				}
+			}
+		}
+
+		level.target = vec2(float(MAP_SIZE/2) + 0.5f, float(MAP_SIZE/2) + 0.5f);
+		level.tileGrid->setSolid(MAP_SIZE/2, MAP_SIZE/2, false);
+		while( (int)level.agents.size() < NUM_AGENTS )
+		{
+			int x = random.next(MAP_SIZE);
+			int y = random.next(MAP_SIZE);
+			if( !level.tileGrid->isSolid(x, y) )
+			{
+				level.agents.push_back(vec2(float(x) + 0.5f, float(y) + 0.5f));
+			}
+		}
+	}
+
+	/** Builds the flow field at once. */
+	struct BuildTest
+	{
+		FlowField* flowField;
+		Level* level;
+
+		void operator()()
+		{
+			// Moving target to other cell and back forces rebuild.
+			flowField->setTarget(level->target + vec2(1.0f, 0.0f));
+			flowField->setTarget(level->target);
+			flowField->build();
+		}
+	};
+
+	/** Moves all agents one step along the flow field. */
+	struct SteeringTest
+	{
+		FlowField* flowField;
+		Level* level;
+		vec2 sum;
+
+		void operator()()
+		{
+			sum = vec2(0.0f);
+			for( int i=0; i<NUM_AGENTS; ++i )
+			{
+				sum += flowField->getDirection(level->agents[i]);
+			}
+		}
+	};
+
+	/** Searches path from each agent to the target. */
+	struct PathSearchTest
+	{
+		Pathfinder* pathfinder;
+		Level* level;
+		int numFound;
+
+		void operator()()
+		{
+			numFound = 0;
+			std::vector<vec2> path;
+			for( int i=0; i<NUM_SEARCHED_AGENTS; ++i )
+			{
+				numFound += pathfinder->findPath(level->agents[i], level->target, path) ? 1 : 0;
+			}
+		}
+	};
+
+	float getPathCost(const vec2& start, const std::vector<vec2>& path)
+	{
+		float cost = 0.0f;
+		vec2 previous = start;
+		for( size_t i=0; i<path.size(); ++i )
+		{
+			int dx = abs(int(floorf(path[i].x)) - int(floorf(previous.x)));
+			int dy = abs(int(floorf(path[i].y)) - int(floorf(previous.y)));
+			cost += dx < dy ? DIAGONAL_COST*float(dx) + float(dy - dx) : DIAGONAL_COST*float(dy) + float(dx - dy);
+			previous = path[i];
+		}
+		return cost;
+	}
+
+	/** Compares distances to jump point search and follows directions to the target. Returns number of errors. */
+	int validate(FlowField* flowField, Level& level)
+	{
+		int numErrors = 0;
+		Ref<Pathfinder> pathfinder = new Pathfinder(level.tileGrid, 0);
+		std::vector<vec2> path;
+		for( int i=0; i<NUM_SEARCHED_AGENTS; ++i )
+		{
+			const vec2& agent = level.agents[i];
+			bool found = pathfinder->findPath(agent, level.target, path);
+			float distance = flowField->getDistance(agent);
+			if( found != (distance >= 0.0f) || (found && fabsf(distance - getPathCost(agent, path)) > 0.01f) )
+			{
+				++numErrors;
+				continue;
+			}
+
+			// Follow directions cell by cell. Cost must match the distance.
+			vec2 position = agent;
+			float cost = 0.0f;
+			for( int step=0; found && step<4*MAP_SIZE; ++step )
+			{
+				vec2 direction = flowField->getDirection(position);
+				if( direction.x == 0.0f && direction.y == 0.0f )
+				{
+					break;
+				}
+				int dx = direction.x > 0.1f ? 1 : (direction.x < -0.1f ? -1 : 0);
+				int dy = direction.y > 0.1f ? 1 : (direction.y < -0.1f ? -1 : 0);
+				position += vec2(float(dx), float(dy));
+				cost += (dx != 0 && dy != 0) ? DIAGONAL_COST : 1.0f;
+				if( level.tileGrid->isSolidAt(position) )
+				{
+					break;
+				}
+			}
+
+			if( found && (floorf(position.x) != floorf(level.target.x) || floorf(position.y) != floorf(level.target.y) || fabsf(cost - distance) > 0.01f) )
+			{
+				++numErrors;
+			}
+		}
+		return numErrors;
+	}
+}
+
+
+namespace benchmarks
+{
+	void runFlowFieldBenchmark(int repeatCount)
+	{
+		Level level;
+		createLevel(level);
+		printf("  Map %dx%d tiles, %d agents\n", MAP_SIZE, MAP_SIZE, NUM_AGENTS);
+
+		Ref<FlowField> flowField = new FlowField(level.tileGrid);
+		BuildTest build;
+		build.flowField = flowField;
+		build.level = &level;
+		float time = measure(repeatCount, build);
+		int numErrors = validate(flowField, level);
+		printf("  %-30s %9.3f ms %8.3f ms build time%s\n", "build", time, flowField->getBuildTime(), checkResult("flowfield/build", numErrors == 0));
+
+		// Target moves to other cell and agents keep steering with previous field during the build.
+		flowField->setTarget(level.target + vec2(0.0f, 1.0f));
+		int numUpdates = 1;
+		while( !flowField->update(2.0f) )
+		{
+			++numUpdates;
+		}
+		printf("  %-30s %9d updates %7.3f ms build time\n", "build, 2 ms budget", numUpdates, flowField->getBuildTime());
+		flowField->setTarget(level.target);
+		flowField->build();
+
+		SteeringTest steering;
+		steering.flowField = flowField;
+		steering.level = &level;
+		time = measure(repeatCount, steering);
+		printf("  %-30s %9.3f ms %8.1f ns/agent\n", "steering, flow field", time, 1000000.0f*time/NUM_AGENTS);
+
+		Ref<Pathfinder> pathfinder = new Pathfinder(level.tileGrid, 16);
+		pathfinder->setMaxCachedPaths(0);
+		PathSearchTest search;
+		search.pathfinder = pathfinder;
+		search.level = &level;
+		search();
+		time = measure(repeatCount, search);
+		printf("  %-30s %9.3f ms %8.1f us/agent %5d found\n", "path per agent, hierarchical", time, 1000.0f*time/NUM_SEARCHED_AGENTS, search.numFound);
+
+		// Shared fields: all agents with same target get the same field.
+		Ref<FlowFieldCache> cache = new FlowFieldCache(level.tileGrid);
+		Ref<FlowField> first = cache->getFlowField(level.target);
+		Ref<FlowField> second = cache->getFlowField(level.target + vec2(0.25f, 0.25f));
+		printf("  %-30s %9d fields%s\n", "cache, same target cell", cache->getNumFlowFields(), checkResult("flowfield/cache", first == second));
+	}
+}
@@ -0,0 +1,350 @@
+// Job system benchmark.
+//
+// Runs parallel for, task graphs and recursively spawned jobs with different numbers of worker threads. Results 
+// must be the same as serial results, parallel for must visit every index of an unaligned range exactly once and 
+// task graph jobs must start only after all their dependencies have finished. Time per job shows overhead of 
+// queues, stealing and dependency counters. Processor time of a thread waiting a sleeping job shows, that waiting
+// does not spin.
+#include "Benchmarks.h"
+#include <JobSystem.h>
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int NUM_ITEMS = 1 << 20;
+	const int GRAIN_SIZE = 4096;
+	const int GRAPH_WIDTH = 64;
+	const int GRAPH_DEPTH = 64;
+	const int SPLIT_SIZE = 1024;
+
+	struct Random
+	{
+		uint32_t state;
+
+		Random() : state(13579) {}
+
+		int next(int maxValue)
+		{
+			state = state*1103515245u + 12345u;
+			return int((state >> 8) % uint32_t(maxValue));
+		}
+	};
+
+	float process(float value)
+	{
+		return sqrtf(value) * sinf(value);
+	}
+
+	/** Processes items in serial. */
+	struct SerialTest
+	{
+		const std::vector<float>* input;
+		std::vector<float>* output;
+
+		void operator()()
+		{
+			for( int i=0; i<NUM_ITEMS; ++i )
+			{
+				(*output)[i] = process((*input)[i]);
+			}
+		}
+	};
+
+	struct ProcessRange : public JobSystem::RangeFunction
+	{
+		const std::vector<float>* input;
+		std::vector<float>* output;
+
+		virtual void execute(int begin, int end)
+		{
+			for( int i=begin; i<end; ++i )
+			{
+				(*output)[i] = process((*input)[i]);
+			}
+		}
+	};
+
+	struct VisitRange : public JobSystem::RangeFunction
+	{
+		std::vector<AtomicInt>* visits;
+
+		virtual void execute(int begin, int end)
+		{
+			for( int i=begin; i<end; ++i )
+			{
+				(*visits)[i].increment();
+			}
+		}
+	};
+
+	/** Returns true, if parallelFor visits every index of range, which is not aligned to grain size, exactly once. */
+	bool isEachIndexVisitedOnce(JobSystem* jobSystem)
+	{
+		const int begin = 3;
+		const int end = NUM_ITEMS - 5;
+		std::vector<AtomicInt> visits(NUM_ITEMS);
+		VisitRange function;
+		function.visits = &visits;
+		jobSystem->parallelFor(begin, end, GRAIN_SIZE - 1, &function);
+		for( int i=0; i<NUM_ITEMS; ++i )
+		{
+			if( visits[i].get() != ((i >= begin && i < end) ? 1 : 0) )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/** Processes items with parallelFor. */
+	struct ParallelForTest
+	{
+		JobSystem* jobSystem;
+		ProcessRange function;
+
+		void operator()()
+		{
+			jobSystem->parallelFor(0, NUM_ITEMS, GRAIN_SIZE, &function);
+		}
+	};
+
+	/** Graph job, which records order of its start and finish. */
+	class StampJob : public Job
+	{
+	public:
+		StampJob() : Job(), clock(0), startStamp(-1), finishStamp(-1) {}
+
+		virtual void execute()
+		{
+			startStamp = clock->increment();
+			finishStamp = clock->increment();
+		}
+
+		AtomicInt*	clock;
+		int			startStamp;
+		int			finishStamp;
+	};
+
+	/** Layered task graph, where each job depends on two jobs of previous layer. */
+	struct GraphTest
+	{
+		JobSystem* jobSystem;
+		std::vector<StampJob> jobs;
+		std::vector<int> dependencies; // Two per job
+		AtomicInt clock;
+
+		GraphTest() : jobs(GRAPH_WIDTH*GRAPH_DEPTH), dependencies(2*GRAPH_WIDTH*GRAPH_DEPTH, -1)
+		{
+			Random random;
+			for( int i=GRAPH_WIDTH; i<GRAPH_WIDTH*GRAPH_DEPTH; ++i )
+			{
+				int layerStart = (i/GRAPH_WIDTH - 1)*GRAPH_WIDTH;
+				dependencies[2*i+0] = layerStart + random.next(GRAPH_WIDTH);
+				dependencies[2*i+1] = layerStart + random.next(GRAPH_WIDTH);
+			}
+		}
+
+		void operator()()
+		{
+			clock.set(0);
+			for( size_t i=0; i<jobs.size(); ++i )
+			{
+				jobs[i].clock = &clock;
+				jobs[i].startStamp = -1;
+				jobs[i].finishStamp = -1;
+				for( int j=0; j<2; ++j )
+				{
+					if( dependencies[2*i+j] >= 0 )
+					{
+						jobs[i].addDependency(&jobs[dependencies[2*i+j]]);
+					}
+				}
+			}
+
+			// Last layer first, so jobs are queued by dependency counters and not by order of run calls.
+			JobCounter counter;
+			for( size_t i=jobs.size(); i>0; --i )
+			{
+				jobSystem->run(&jobs[i-1], &counter);
+			}
+			jobSystem->wait(&counter);
+		}
+
+		bool isValid() const
+		{
+			for( size_t i=0; i<jobs.size(); ++i )
+			{
+				for( int j=0; j<2; ++j )
+				{
+					int dependency = dependencies[2*i+j];
+					if( jobs[i].startStamp < 0 || (dependency >= 0 && jobs[dependency].finishStamp > jobs[i].startStamp) )
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+	};
+
+	/** Sums range by splitting it to two jobs until it is small, like recursive algorithms do. */
+	class SumJob : public Job
+	{
+	public:
+		SumJob() : Job(), jobSystem(0), values(0), begin(0), end(0), sum(0.0) {}
+
+		virtual void execute()
+		{
+			if( end - begin <= SPLIT_SIZE )
+			{
+				sum = 0.0;
+				for( int i=begin; i<end; ++i )
+				{
+					sum += (*values)[i];
+				}
+				return;
+			}
+
+			int middle = (begin + end) / 2;
+			SumJob left;
+			SumJob right;
+			left.init(jobSystem, values, begin, middle);
+			right.init(jobSystem, values, middle, end);
+			JobCounter counter;
+			jobSystem->run(&left, &counter);
+			jobSystem->run(&right, &counter);
+			jobSystem->wait(&counter);
+			sum = left.sum + right.sum;
+		}
+
+		void init(JobSystem* jobSystem, const std::vector<float>* values, int begin, int end)
+		{
+			this->jobSystem = jobSystem;
+			this->values = values;
+			this->begin = begin;
+			this->end = end;
+		}
+
+		JobSystem* jobSystem;
+		const std::vector<float>* values;
+		int begin;
+		int end;
+		double sum;
+	};
+
+	/** Job, which sleeps in a worker thread. */
+	class SleepJob : public Job
+	{
+	public:
+		virtual void execute()
+		{
+			Thread::sleep(20);
+		}
+	};
+
+	/** Returns milliseconds of processor time, which the process used while waiting a sleeping job. */
+	float getWaitProcessorTime(JobSystem* jobSystem)
+	{
+		SleepJob job;
+		JobCounter counter;
+		clock_t start = clock();
+		jobSystem->run(&job, &counter);
+		jobSystem->wait(&counter);
+		return 1000.0f*float(clock() - start)/float(CLOCKS_PER_SEC);
+	}
+
+	struct SpawnTest
+	{
+		JobSystem* jobSystem;
+		const std::vector<float>* values;
+		double sum;
+
+		void operator()()
+		{
+			SumJob root;
+			root.init(jobSystem, values, 0, NUM_ITEMS);
+			JobCounter counter;
+			jobSystem->run(&root, &counter);
+			jobSystem->wait(&counter);
+			sum = root.sum;
+		}
+	};
+
+	void run(int repeatCount, int numWorkers, const std::vector<float>& input, const std::vector<float>& expectedOutput, double expectedSum)
+	{
+		Ref<JobSystem> jobSystem = new JobSystem(numWorkers);
+		char name[64];
+
+		std::vector<float> output(NUM_ITEMS, 0.0f);
+		ParallelForTest parallelFor;
+		parallelFor.jobSystem = jobSystem;
+		parallelFor.function.input = &input;
+		parallelFor.function.output = &output;
+		float time = benchmarks::measure(repeatCount, parallelFor);
+		sprintf(name, "parallel for, %d workers", jobSystem->getNumWorkers());
+		printf("  %-32s %9.3f ms%s\n", name, time, 
+			benchmarks::checkResult(std::string("jobs/") + name, output == expectedOutput && isEachIndexVisitedOnce(jobSystem)));
+
+		GraphTest graph;
+		graph.jobSystem = jobSystem;
+		time = benchmarks::measure(repeatCount, graph);
+		sprintf(name, "task graph, %d workers", jobSystem->getNumWorkers());
+		printf("  %-32s %9.3f ms %6.0f ns/job%s\n", name, time, 1000000.0f*time/float(GRAPH_WIDTH*GRAPH_DEPTH), 
+			benchmarks::checkResult(std::string("jobs/") + name, graph.isValid()));
+
+		SpawnTest spawn = SpawnTest();
+		spawn.jobSystem = jobSystem;
+		spawn.values = &input;
+		time = benchmarks::measure(repeatCount, spawn);
+		sprintf(name, "recursive spawn, %d workers", jobSystem->getNumWorkers());
+		printf("  %-32s %9.3f ms%s\n", name, time, benchmarks::checkResult(std::string("jobs/") + name, spawn.sum == expectedSum));
+
+		if( jobSystem->getNumWorkers() > 0 )
+		{
+			// Waiting thread sleeps, so only few milliseconds of the 20 ms are used.
+			time = getWaitProcessorTime(jobSystem);
+			sprintf(name, "waiting 20 ms job, %d workers", jobSystem->getNumWorkers());
+			printf("  %-32s %9.3f ms processor time%s\n", name, time, benchmarks::checkResult(std::string("jobs/") + name, time < 10.0f));
+		}
+	}
+}
+
+
+namespace benchmarks
+{
+	void runJobSystemBenchmark(int repeatCount)
+	{
+		std::vector<float> input(NUM_ITEMS);
+		for( int i=0; i<NUM_ITEMS; ++i )
+		{
+			input[i] = float(i % 1000);
+		}
+
+		std::vector<float> expectedOutput(NUM_ITEMS);
+		SerialTest serial;
+		serial.input = &input;
+		serial.output = &expectedOutput;
+		float time = measure(repeatCount, serial);
+		printf("  %-32s %9.3f ms\n", "serial for", time);
+
+		// Recursive sum adds same ranges in same order regardless of threads.
+		SumJob sum;
+		Ref<JobSystem> serialJobSystem = new JobSystem(0);
+		sum.init(serialJobSystem, &input, 0, NUM_ITEMS);
+		sum.execute();
+
+		printf("  %d processors\n", Thread::getNumProcessors());
+		run(repeatCount, 0, input, expectedOutput, sum.sum);
+		run(repeatCount, 1, input, expectedOutput, sum.sum);
+		run(repeatCount, 3, input, expectedOutput, sum.sum);
+		if( Thread::getNumProcessors() > 4 )
+		{
+			run(repeatCount, -1, input, expectedOutput, sum.sum);
+		}
+	}
+}
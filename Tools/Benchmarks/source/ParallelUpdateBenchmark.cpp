@@ -0,0 +1,369 @@
+// Parallel update benchmark.
+//
+// Updates a map of 20k game objects, whose components implement ParallelUpdatable, with UpdateScheduler using 
+// different numbers of worker threads and broadphases. When objects run out of lifetime, they delete themselves, 
+// spawn replacements and move objects to another layer through command buffers. Some objects query the layer 
+// broadphase for neighbours, which speed them up. Map must end up in the same state regardless of number of 
+// threads, and broadphases must contain every game object at its final extents.
+#include "Benchmarks.h"
+#include <Map.h>
+#include <Layer.h>
+#include <UpdateScheduler.h>
+#include <SpatialHashGrid.h>
+#include <DynamicAabbTree.h>
+#include <ExtentsBuffer.h>
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int NUM_OBJECTS = 20000;
+	const int NUM_FRAMES = 120;
+	const float WORLD_SIZE = 256.0f;
+	const float DELTA_TIME = 1.0f/60.0f;
+	const int QUERY_INTERVAL = 50; // Every 50th object queries broadphase for neighbours.
+	const int MAX_NEIGHBOURS = 16;
+
+	enum BroadphaseType
+	{
+		NO_BROADPHASE,
+		GRID,
+		TREE,
+		EXTENTS,
+		NUM_BROADPHASE_TYPES
+	};
+
+	const char* const broadphaseNames[NUM_BROADPHASE_TYPES] = { "no broadphase", "grid", "tree", "extents" };
+
+	/** Returns pseudo random value between 0 and 1 for given seed. */
+	float hash(uint32_t seed)
+	{
+		seed = (seed ^ 61u) ^ (seed >> 16);
+		seed *= 9u;
+		seed = seed ^ (seed >> 4);
+		seed *= 0x27d4eb2du;
+		seed = seed ^ (seed >> 15);
+		return float(seed & 0xffff) / 65535.0f;
+	}
+
+	/** Not thread safe, so updated serially. Counts updates of every 10th initial object. */
+	class UpdateCounter : public Component, public Updatable
+	{
+	public:
+		UpdateCounter(GameObject* owner, int* counter)
+			: Component(owner, Component::getDefaultProperties())
+			, m_counter(counter)
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			++(*m_counter);
+		}
+
+	private:
+		int*	m_counter;
+	};
+
+	/** Marks game objects moved to graveyard layer. */
+	class Tombstone : public Component
+	{
+	public:
+		Tombstone(GameObject* owner)
+			: Component(owner, Component::getDefaultProperties())
+		{
+		}
+	};
+
+	/** Adds replacement for an Orbiter and tombstone to buried game object, when commands are applied. */
+	class Respawn : public CommandBuffer::Function
+	{
+	public:
+		Respawn(GameObject* buried, uint32_t seed)
+			: m_buried(buried)
+			, m_seed(seed)
+		{
+		}
+
+		virtual void execute(Map* map);
+
+	private:
+		GameObject*	m_buried;
+		uint32_t	m_seed;
+	};
+
+	/** Orbits around a point and, when lifetime ends, replaces itself with a new game object. */
+	class Orbiter : public Component, public ParallelUpdatable
+	{
+	public:
+		Orbiter(GameObject* owner, Map* map, uint32_t seed)
+			: Component(owner, Component::getDefaultProperties())
+			, m_map(map)
+			, m_seed(seed)
+			, m_center(hash(seed)*WORLD_SIZE, hash(seed+1)*WORLD_SIZE)
+			, m_radius(1.0f + 4.0f*hash(seed+2))
+			, m_speed(0.5f + hash(seed+3))
+			, m_lifetime(0.5f + 3.0f*hash(seed+4))
+			, m_time(0.0f)
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			GameObject* gameObject = (GameObject*)getOwner();
+			float speedUp = 1.0f;
+			Broadphase* broadphase = gameObject->getBroadphase();
+			if( broadphase != 0 && m_seed % QUERY_INTERVAL == 0 )
+			{
+				// Broadphase is not modified during parallel update, so queries see positions of previous frame.
+				GameObject* neighbours[MAX_NEIGHBOURS];
+				const vec2& position = gameObject->getPosition();
+				int numNeighbours = broadphase->queryAabb(position - vec2(2.0f), position + vec2(2.0f), neighbours, MAX_NEIGHBOURS);
+				speedUp += 0.05f*float(numNeighbours);
+			}
+			m_time += speedUp*deltaTime;
+
+			// Some math standing for game logic.
+			float angle = m_speed*m_time;
+			vec2 offset(0.0f);
+			for( int i=1; i<=8; ++i )
+			{
+				offset.x += cosf(angle*float(i)) / float(i);
+				offset.y += sinf(angle*float(i)) / float(i);
+			}
+			gameObject->setPosition(m_center + m_radius*offset);
+			gameObject->setRotation(atan2f(offset.y, offset.x));
+
+			if( m_time < m_lifetime )
+			{
+				return;
+			}
+
+			m_time = 0.0f;
+			CommandBuffer* commandBuffer = m_map->getCommandBuffer();
+			GameObject* buried = 0;
+			if( hash(m_seed+5) < 0.1f )
+			{
+				// Moves to graveyard instead of being deleted.
+				commandBuffer->moveGameObject(gameObject, m_map->getLayer(1));
+				buried = gameObject;
+				m_lifetime = 1.0e30f;
+			}
+			else
+			{
+				commandBuffer->deleteGameObject(gameObject);
+			}
+
+			// Game objects and components can not be created in parallel, so they are created by function.
+			commandBuffer->addFunction(new Respawn(buried, m_seed*7919u + 17u));
+		}
+
+		static GameObject* create(Layer* layer, Map* map, uint32_t seed, int* counter)
+		{
+			GameObject* gameObject = new GameObject(layer, 0, vec2(0.0f), vec2(1.0f));
+			gameObject->addComponent(new Orbiter(gameObject, map, seed));
+			if( counter != 0 )
+			{
+				gameObject->addComponent(new UpdateCounter(gameObject, counter));
+			}
+			return gameObject;
+		}
+
+	private:
+		Map*		m_map;
+		uint32_t	m_seed;
+		vec2		m_center;
+		float		m_radius;
+		float		m_speed;
+		float		m_lifetime;
+		float		m_time;
+	};
+
+	void Respawn::execute(Map* map)
+	{
+		if( m_buried != 0 )
+		{
+			m_buried->addComponent(new Tombstone(m_buried));
+		}
+
+		Layer* layer = map->getLayer(0);
+		layer->addGameObject(Orbiter::create(layer, map, m_seed, 0));
+	}
+
+	struct Scene
+	{
+		Ref<Map> map;
+		Ref<UpdateScheduler> scheduler;
+		int counter;
+	};
+
+	Broadphase* createBroadphase(BroadphaseType type)
+	{
+		switch( type )
+		{
+		case GRID:
+			return new SpatialHashGrid(4.0f);
+		case TREE:
+			return new DynamicAabbTree();
+		case EXTENTS:
+			return new ExtentsBuffer();
+		default:
+			return 0;
+		}
+	}
+
+	void createScene(Scene& scene, JobSystem* jobSystem, BroadphaseType broadphaseType)
+	{
+		scene.counter = 0;
+		scene.map = new Map(1.0f, 1.0f);
+		scene.map->addLayer(0, new Layer(scene.map, "objects", 1.0f, true, false));
+		scene.map->addLayer(1, new Layer(scene.map, "graveyard", 1.0f, true, false));
+		scene.map->getLayer(0)->setBroadphase(createBroadphase(broadphaseType));
+		scene.map->getLayer(1)->setBroadphase(createBroadphase(broadphaseType));
+		scene.scheduler = new UpdateScheduler();
+		scene.scheduler->setJobSystem(jobSystem);
+		scene.map->setUpdateScheduler(scene.scheduler);
+
+		Layer* layer = scene.map->getLayer(0);
+		for( int i=0; i<NUM_OBJECTS; ++i )
+		{
+			layer->addGameObject(Orbiter::create(layer, scene.map, uint32_t(i), (i % 10 == 0) ? &scene.counter : 0));
+		}
+	}
+
+	/** Hash of positions of game objects in their layer order and number of tombstones. */
+	uint32_t getChecksum(Map* map)
+	{
+		uint32_t checksum = 0;
+		for( int l=0; l<2; ++l )
+		{
+			Layer::GameObjectList& gameObjects = map->getLayer(l)->getGameObjects();
+			for( size_t i=0; i<gameObjects.size(); ++i )
+			{
+				const vec2& position = gameObjects[i]->getPosition();
+				uint32_t x = uint32_t(int(position.x*1000.0f));
+				uint32_t y = uint32_t(int(position.y*1000.0f));
+				checksum = checksum*31u + x;
+				checksum = checksum*31u + y;
+				checksum = checksum*31u + (gameObjects[i]->getComponent<Tombstone>() != 0 ? 1u : 0u);
+			}
+		}
+		return checksum;
+	}
+
+	/** 
+	 * Returns true, if broadphases of layers contain each game object of the layer at its current extents: number 
+	 * of objects found by queries of a grid of boxes over the world must match testing each object.
+	 */
+	bool isBroadphaseValid(Map* map)
+	{
+		const int NUM_BOXES = 32;
+		const float BOX_SIZE = WORLD_SIZE/float(NUM_BOXES);
+		for( int l=0; l<2; ++l )
+		{
+			Layer* layer = map->getLayer(l);
+			Broadphase* broadphase = layer->getBroadphase();
+			if( broadphase == 0 )
+			{
+				continue;
+			}
+
+			Layer::GameObjectList& gameObjects = layer->getGameObjects();
+			if( broadphase->getNumGameObjects() != (int)gameObjects.size() )
+			{
+				return false;
+			}
+
+			for( int y=0; y<NUM_BOXES; ++y )
+			{
+				for( int x=0; x<NUM_BOXES; ++x )
+				{
+					const vec2 topLeft(float(x)*BOX_SIZE, float(y)*BOX_SIZE);
+					const vec2 bottomRight = topLeft + vec2(BOX_SIZE);
+					int expected = 0;
+					for( size_t i=0; i<gameObjects.size(); ++i )
+					{
+						const GameObject* o = gameObjects[i];
+						if( o->getLeft() <= bottomRight.x && topLeft.x <= o->getRight() && o->getTop() <= bottomRight.y && topLeft.y <= o->getBottom() )
+						{
+							++expected;
+						}
+					}
+
+					if( broadphase->queryAabb(topLeft, bottomRight, 0, 0) != expected )
+					{
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	struct UpdateTest
+	{
+		Map* map;
+
+		void operator()()
+		{
+			map->update(DELTA_TIME);
+		}
+	};
+}
+
+
+namespace benchmarks
+{
+	void runParallelUpdateBenchmark(int repeatCount)
+	{
+		printf("  %d processors\n", Thread::getNumProcessors());
+		for( int b=0; b<NUM_BROADPHASE_TYPES; ++b )
+		{
+			uint32_t expectedChecksum = 0;
+			int expectedCounter = 0;
+			const int numWorkers[] = { -2, 0, 1, 3, -1 };
+			for( int i=0; i<5; ++i )
+			{
+				if( numWorkers[i] == -1 && Thread::getNumProcessors() <= 4 )
+				{
+					continue;
+				}
+
+				// -2 means updating without job system.
+				Ref<JobSystem> jobSystem = (numWorkers[i] >= -1) ? new JobSystem(numWorkers[i]) : 0;
+				Scene scene;
+				createScene(scene, jobSystem, BroadphaseType(b));
+				UpdateTest update = UpdateTest();
+				update.map = scene.map;
+				for( int j=0; j<NUM_FRAMES; ++j )
+				{
+					update();
+				}
+
+				uint32_t checksum = getChecksum(scene.map);
+				expectedChecksum = (i == 0) ? checksum : expectedChecksum;
+				expectedCounter = (i == 0) ? scene.counter : expectedCounter;
+				bool valid = checksum == expectedChecksum && scene.counter == expectedCounter && isBroadphaseValid(scene.map);
+
+				int numObjects = (int)scene.map->getLayer(0)->getGameObjects().size();
+				int numMoved = (int)scene.map->getLayer(1)->getGameObjects().size();
+				float time = measure(repeatCount, update);
+				char name[64];
+				if( jobSystem != 0 )
+				{
+					sprintf(name, "%s, %d workers", broadphaseNames[b], jobSystem->getNumWorkers());
+				}
+				else
+				{
+					sprintf(name, "%s, no job system", broadphaseNames[b]);
+				}
+				printf("  %-32s %9.3f ms/frame %6d objects %6d moved  checksum %08x%s\n", name, time, numObjects, numMoved, 
+					checksum, benchmarks::checkResult(std::string("parallelupdate/") + name, valid));
+				scene.map->setUpdateScheduler(0);
+			}
+		}
+	}
+}
@@ -0,0 +1,368 @@
+// Pathfinding benchmark.
+//
+// Builds 512x512 tile level with random solid blocks and searches paths between random cells with
+// plain A*, jump point search and hierarchical search. Path costs of the Pathfinder are compared to
+// plain A*, which gives shortest paths. Cached paths, time budgeted requests and worker threads are
+// measured too.
+#include "Benchmarks.h"
+#include <Pathfinder.h>
+#include <Thread.h>
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int MAP_SIZE = 512;
+	const int NUM_PATHS = 200;
+	const float DIAGONAL_COST = 1.41421356f;
+
+	struct Random
+	{
+		uint32_t state;
+
+		Random() : state(24680) {}
+
+		int next(int maxValue)
+		{
+			state = state*1103515245u + 12345u;
+			return int((state >> 8) % uint32_t(maxValue));
+		}
+	};
+
+	struct Level
+	{
+		Ref<TileGrid> tileGrid;
+		std::vector<vec2> starts;
+		std::vector<vec2> goals;
+	};
+
+	float octileDistance(int dx, int dy)
+	{
+		dx = abs(dx);
+		dy = abs(dy);
+		return dx < dy ? DIAGONAL_COST*float(dx) + float(dy - dx) : DIAGONAL_COST*float(dy) + float(dx - dy);
+	}
+
+	void createLevel(Level& level)
+	{
+		Random random;
+		level.tileGrid = new TileGrid(MAP_SIZE, MAP_SIZE);
+
+		// Solid blocks of 1-8 tiles and some long walls.
+		for( int i=0; i<MAP_SIZE*MAP_SIZE/40; ++i )
+		{
+			int x0 = random.next(MAP_SIZE-8);
+			int y0 = random.next(MAP_SIZE-8);
+			int w = 1 + random.next(8);
+			int h = 1 + random.next(8);
+			for( int y=y0; y<y0+h; ++y )
+			{
+				for( int x=x0; x<x0+w; ++x )
+				{
+					level.tileGrid->setSolid(x, y, true);
+				}
+			}
+		}
+
+		for( int i=0; i<MAP_SIZE/4; ++i )
+		{
+			int x0 = random.next(MAP_SIZE);
+			int y0 = random.next(MAP_SIZE);
+			int length = 16 + random.next(64);
+			bool horizontal = random.next(2) == 0;
+			for( int j=0; j<length; ++j )
+			{
+				int x = horizontal ? x0 + j : x0;
+				int y = horizontal ? y0 : y0 + j;
+				if( x < MAP_SIZE && y < MAP_SIZE )
+				{
+					level.tileGrid->setSolid(x, y, true);
+				}
+			}
+		}
+
+		while( (int)level.starts.size() < NUM_PATHS )
+		{
+			int x0 = random.next(MAP_SIZE);
+			int y0 = random.next(MAP_SIZE);
+			int x1 = random.next(MAP_SIZE);
+			int y1 = random.next(MAP_SIZE);
+			if( !level.tileGrid->isSolid(x0, y0) && !level.tileGrid->isSolid(x1, y1) )
+			{
+				level.starts.push_back(vec2(float(x0) + 0.5f, float(y0) + 0.5f));
+				level.goals.push_back(vec2(float(x1) + 0.5f, float(y1) + 0.5f));
+			}
+		}
+	}
+
+	/** Returns cost of path returned by Pathfinder, or -1 if path was not found. */
+	float getPathCost(const vec2& start, const std::vector<vec2>& path, bool found)
+	{
+		if( !found )
+		{
+			return -1.0f;
+		}
+
+		float cost = 0.0f;
+		vec2 previous = start;
+		for( size_t i=0; i<path.size(); ++i )
+		{
+			cost += octileDistance(int(floorf(path[i].x)) - int(floorf(previous.x)), int(floorf(path[i].y)) - int(floorf(previous.y)));
+			previous = path[i];
+		}
+		return cost;
+	}
+
+	/** Plain A* over all cells, which is used as reference for path costs. */
+	struct AStarTest
+	{
+		struct Node
+		{
+			float f;
+			int cell;
+			bool operator<(const Node& other) const { return f > other.f; }
+		};
+
+		Level* level;
+		std::vector<float> costs;
+		std::vector<float> g;
+		std::vector<uint8_t> closed;
+		std::vector<Node> open;
+
+		float search(int startX, int startY, int goalX, int goalY)
+		{
+			const TileGrid* grid = level->tileGrid;
+			g.assign(MAP_SIZE*MAP_SIZE, FLT_MAX);
+			closed.assign(MAP_SIZE*MAP_SIZE, 0);
+			open.clear();
+			const int goalCell = goalY*MAP_SIZE + goalX;
+			g[startY*MAP_SIZE + startX] = 0.0f;
+			Node startNode = { octileDistance(goalX - startX, goalY - startY), startY*MAP_SIZE + startX };
+			open.push_back(startNode);
+			while( !open.empty() )
+			{
+				const int cell = open.front().cell;
+				std::pop_heap(open.begin(), open.end());
+				open.pop_back();
+				if( closed[cell] )
+				{
+					continue;
+				}
+				closed[cell] = 1;
+				if( cell == goalCell )
+				{
+					return g[cell];
+				}
+
+				const int x = cell % MAP_SIZE;
+				const int y = cell / MAP_SIZE;
+				for( int dy=-1; dy<=1; ++dy )
+				{
+					for( int dx=-1; dx<=1; ++dx )
+					{
+						const int nx = x + dx;
+						const int ny = y + dy;
+						if( (dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= MAP_SIZE || ny >= MAP_SIZE || grid->isSolid(nx, ny) )
+						{
+							continue;
+						}
+
+						if( dx != 0 && dy != 0 && (grid->isSolid(nx, y) || grid->isSolid(x, ny)) )
+						{
+							continue;
+						}
+
+						const float cost = g[cell] + (dx != 0 && dy != 0 ? DIAGONAL_COST : 1.0f);
+						if( cost < g[ny*MAP_SIZE + nx] )
+						{
+							g[ny*MAP_SIZE + nx] = cost;
+							Node node = { cost + octileDistance(goalX - nx, goalY - ny), ny*MAP_SIZE + nx };
+							open.push_back(node);
+							std::push_heap(open.begin(), open.end());
+						}
+					}
+				}
+			}
+			return -1.0f;
+		}
+
+		void operator()()
+		{
+			costs.resize(NUM_PATHS);
+			for( int i=0; i<NUM_PATHS; ++i )
+			{
+				costs[i] = search(int(level->starts[i].x), int(level->starts[i].y), int(level->goals[i].x), int(level->goals[i].y));
+			}
+		}
+	};
+
+	/** Searches all paths with findPath. */
+	struct FindPathTest
+	{
+		Level* level;
+		Pathfinder* pathfinder;
+		std::vector<float> costs;
+		std::vector<vec2> path;
+
+		void operator()()
+		{
+			costs.resize(NUM_PATHS);
+			for( int i=0; i<NUM_PATHS; ++i )
+			{
+				bool found = pathfinder->findPath(level->starts[i], level->goals[i], path);
+				costs[i] = getPathCost(level->starts[i], path, found);
+			}
+		}
+	};
+
+	/** Requests all paths and calls update with time budget until all are done. */
+	struct RequestTest
+	{
+		Level* level;
+		Pathfinder* pathfinder;
+		float maxMilliseconds;
+		int sleepMilliseconds;		// Sleep between updates, when requests are searched by worker threads.
+		int numUpdates;
+		int numFound;
+
+		void operator()()
+		{
+			std::vector< Ref<PathRequest> > requests;
+			for( int i=0; i<NUM_PATHS; ++i )
+			{
+				requests.push_back(pathfinder->requestPath(level->starts[i], level->goals[i]));
+			}
+
+			numUpdates = 0;
+			int numDone = 0;
+			while( numDone < NUM_PATHS )
+			{
+				numDone += pathfinder->update(maxMilliseconds);
+				++numUpdates;
+				if( numDone < NUM_PATHS && sleepMilliseconds > 0 )
+				{
+					Thread::sleep(sleepMilliseconds);
+				}
+			}
+
+			numFound = 0;
+			for( int i=0; i<NUM_PATHS; ++i )
+			{
+				numFound += requests[i]->getState() == PathRequest::STATE_READY ? 1 : 0;
+			}
+		}
+	};
+
+	void printCostComparison(const char* name, float time, const std::vector<float>& costs, const std::vector<float>& reference)
+	{
+		int numMismatches = 0;
+		float sumCost = 0.0f;
+		float sumReference = 0.0f;
+		float worstRatio = 1.0f;
+		for( int i=0; i<NUM_PATHS; ++i )
+		{
+			if( (costs[i] < 0.0f) != (reference[i] < 0.0f) || costs[i] < reference[i] - 0.01f )
+			{
+				++numMismatches;
+			}
+			else if( reference[i] > 0.0f )
+			{
+				sumCost += costs[i];
+				sumReference += reference[i];
+				worstRatio = std::max(worstRatio, costs[i] / reference[i]);
+			}
+		}
+
+		printf("  %-30s %9.3f ms %8.1f us/path  cost %.3fx (worst %.3fx)%s\n", name, time, 1000.0f*time/NUM_PATHS, 
+			sumReference > 0.0f ? sumCost/sumReference : 1.0f, worstRatio, 
+			benchmarks::checkResult(std::string("pathfinding/") + name, numMismatches == 0));
+	}
+}
+
+
+namespace benchmarks
+{
+	void runPathfindingBenchmark(int repeatCount)
+	{
+		Level level;
+		createLevel(level);
+
+		AStarTest aStar;
+		aStar.level = &level;
+		float time = measure(1, aStar);
+		int numFound = int(NUM_PATHS - std::count(aStar.costs.begin(), aStar.costs.end(), -1.0f));
+		printf("  Map %dx%d tiles, %d paths, %d reachable\n", MAP_SIZE, MAP_SIZE, NUM_PATHS, numFound);
+		printf("  %-30s %9.3f ms %8.1f us/path\n", "plain A*", time, 1000.0f*time/NUM_PATHS);
+
+		Ref<Pathfinder> jps = new Pathfinder(level.tileGrid, 0);
+		jps->setMaxCachedPaths(0);
+		FindPathTest jpsTest;
+		jpsTest.level = &level;
+		jpsTest.pathfinder = jps;
+		time = measure(repeatCount, jpsTest);
+		printCostComparison("jump point search", time, jpsTest.costs, aStar.costs);
+
+		// First search includes building clusters.
+		ElapsedTimer timer;
+		timer.reset();
+		Ref<Pathfinder> hpa = new Pathfinder(level.tileGrid, 16);
+		std::vector<vec2> path;
+		hpa->findPath(level.starts[0], level.starts[0], path);
+		printf("  %-30s %9.3f ms\n", "build clusters", 1000.0f*timer.getTime());
+
+		hpa->setMaxCachedPaths(0);
+		FindPathTest hpaTest;
+		hpaTest.level = &level;
+		hpaTest.pathfinder = hpa;
+		time = measure(repeatCount, hpaTest);
+		printCostComparison("hierarchical, clusters 16", time, hpaTest.costs, aStar.costs);
+
+		hpa->setMaxCachedPaths(1024);
+		hpaTest();
+		time = measure(repeatCount, hpaTest);
+		printCostComparison("hierarchical, cached", time, hpaTest.costs, aStar.costs);
+
+		// Changing a tile invalidates only cached paths through its cluster.
+		const int numSearches = hpa->getNumSearches();
+		for( int i=0; i<16; ++i )
+		{
+			int x = (i*97) % MAP_SIZE;
+			int y = (i*193) % MAP_SIZE;
+			level.tileGrid->setSolid(x, y, !level.tileGrid->isSolid(x, y));
+		}
+		timer.reset();
+		hpaTest();
+		time = 1000.0f*timer.getTime();
+		printf("  %-30s %9.3f ms %8d paths searched again\n", "after 16 tile changes", time, hpa->getNumSearches() - numSearches);
+		aStar();
+		hpa->setMaxCachedPaths(0);
+		time = measure(repeatCount, hpaTest);
+		printCostComparison("hierarchical, changed tiles", time, hpaTest.costs, aStar.costs);
+
+		RequestTest budgeted;
+		budgeted.level = &level;
+		budgeted.pathfinder = hpa;
+		budgeted.maxMilliseconds = 2.0f;
+		budgeted.sleepMilliseconds = 0;
+		time = measure(repeatCount, budgeted);
+		printf("  %-30s %9.3f ms %8d updates %5d found\n", "requests, 2 ms budget", time, budgeted.numUpdates, budgeted.numFound);
+
+		int numThreads = std::max(1, Thread::getNumProcessors() - 1);
+		Ref<Pathfinder> threaded = new Pathfinder(level.tileGrid, 16, numThreads);
+		threaded->setMaxCachedPaths(0);
+		RequestTest async;
+		async.level = &level;
+		async.pathfinder = threaded;
+		async.maxMilliseconds = 0.0f;
+		async.sleepMilliseconds = 1;
+		async();
+		time = measure(repeatCount, async);
+		char name[64];
+		sprintf(name, "requests, %d threads", numThreads);
+		printf("  %-30s %9.3f ms %8d updates %5d found\n", name, time, async.numUpdates, async.numFound);
+	}
+}
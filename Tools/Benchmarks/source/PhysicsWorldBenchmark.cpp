@@ -0,0 +1,156 @@
+// Physics world benchmark.
+//
+// Drops 1000 dynamic bodies on a tile level and updates PhysicsWorld with different frame rates. Simulation
+// must give identical bodies after same number of fixed steps regardless of frame rate. Update time is
+// measured while bodies are falling and after they have fallen asleep, when they are not synced. World owned by
+// a map must be stepped by Map::update and its stats must be recorded to RenderStats of the frame.
+#include "Benchmarks.h"
+#include <Map.h>
+#include <RenderStats.h>
+#include <PhysicsWorld.h>
+#include <PhysicsBody.h>
+#include <StaticTileBody.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	typedef std::vector< Ref<GameObject> > GameObjectList;
+
+	const int MAP_WIDTH = 512;
+	const int MAP_HEIGHT = 64;
+	const int NUM_BODIES = 1000;
+	const int NUM_STEPS = 240;
+
+	struct Scene
+	{
+		Ref<Entity> owner;
+		Ref<PhysicsWorld> physicsWorld;
+		Ref<TileGrid> tileGrid;
+		Ref<StaticTileBody> level;
+		GameObjectList gameObjects;
+
+		~Scene()
+		{
+			// Bodies refer to the world, so they are released first.
+			gameObjects.clear();
+			level = 0;
+		}
+	};
+
+	/** Creates scene with world owned by given entity or, if it is 0, by new game object. */
+	void createScene(Scene& scene, Entity* owner = 0)
+	{
+		scene.owner = owner != 0 ? owner : new GameObject(0);
+		scene.physicsWorld = new PhysicsWorld(scene.owner);
+		scene.tileGrid = new TileGrid(MAP_WIDTH, MAP_HEIGHT);
+		for( int x=0; x<MAP_WIDTH; ++x )
+		{
+			for( int y=MAP_HEIGHT-4; y<MAP_HEIGHT; ++y )
+			{
+				scene.tileGrid->setSolid(x, y, true);
+			}
+		}
+		for( int y=0; y<MAP_HEIGHT; ++y )
+		{
+			scene.tileGrid->setSolid(0, y, true);
+			scene.tileGrid->setSolid(MAP_WIDTH-1, y, true);
+		}
+		scene.level = new StaticTileBody(scene.physicsWorld->getWorld(), scene.tileGrid);
+
+		for( int i=0; i<NUM_BODIES; ++i )
+		{
+			// Bodies fall to separate small stacks, which can fall asleep.
+			const int numColumns = (MAP_WIDTH-4)/2;
+			vec2 position(2.0f + 2.0f*float(i % numColumns), 2.0f + 1.5f*float(i / numColumns));
+			GameObject* gameObject = new GameObject(0, 0, position, vec2(1.0f));
+			PhysicsBody* body = new PhysicsBody(gameObject, scene.physicsWorld, 0.1f, 0.1f);
+			body->setBoxFixture(vec2(0.8f), vec2(0.0f), 0.0f, false, 1.0f, 0.1f, 0.5f);
+			gameObject->addComponent(body);
+			scene.gameObjects.push_back(gameObject);
+		}
+	}
+
+	/** Updates the world with given frame time until given number of steps has been taken. */
+	int runSteps(PhysicsWorld* physicsWorld, float deltaTime, int numSteps)
+	{
+		int numUpdates = 0;
+		int numStepsTaken = 0;
+		while( numStepsTaken < numSteps )
+		{
+			physicsWorld->update(deltaTime);
+			numStepsTaken += physicsWorld->getStats().numSteps;
+			++numUpdates;
+		}
+		return numStepsTaken == numSteps ? numUpdates : -1;
+	}
+
+	/** Updates map, which owns the world, for two steps and returns true, if RenderStats of the frame match the world. */
+	bool isMapWorldRecorded()
+	{
+		Ref<Map> map = new Map(1.0f, 1.0f);
+		Scene scene;
+		createScene(scene, map);
+		map->addComponent(scene.physicsWorld);
+		RenderStats::clear();
+		map->update(scene.physicsWorld->getTimeStep());
+		map->update(scene.physicsWorld->getTimeStep());
+		RenderStats::endFrame();
+
+		RenderStats::FrameStats frame;
+		const PhysicsWorld::Stats& stats = scene.physicsWorld->getStats();
+		bool res = RenderStats::getFrame(0, frame) && frame.physics.numSteps == 2 && frame.physics.numBodies == stats.numBodies 
+			&& frame.physics.numAwakeBodies == NUM_BODIES && frame.physics.numContacts == stats.numContacts && frame.physics.stepTime > 0.0f;
+		RenderStats::clear();
+		return res;
+	}
+
+	/** Updates the world one frame. */
+	struct UpdateTest
+	{
+		PhysicsWorld* physicsWorld;
+
+		void operator()()
+		{
+			physicsWorld->update(physicsWorld->getTimeStep());
+		}
+	};
+}
+
+
+namespace benchmarks
+{
+	void runPhysicsWorldBenchmark(int repeatCount)
+	{
+		// Same number of steps with 30 and 144 Hz frames must give same result.
+		Scene scene30;
+		createScene(scene30);
+		int numUpdates30 = runSteps(scene30.physicsWorld, 1.0f/30.0f, NUM_STEPS);
+		Scene scene144;
+		createScene(scene144);
+		int numUpdates144 = runSteps(scene144.physicsWorld, 1.0f/144.0f, NUM_STEPS);
+		bool identical = numUpdates30 > 0 && numUpdates144 > 0;
+		for( int i=0; i<NUM_BODIES && identical; ++i )
+		{
+			const b2Body* a = scene30.gameObjects[i]->getComponent<PhysicsBody>()->getBody();
+			const b2Body* b = scene144.gameObjects[i]->getComponent<PhysicsBody>()->getBody();
+			identical = a->GetPosition().x == b->GetPosition().x && a->GetPosition().y == b->GetPosition().y && a->GetAngle() == b->GetAngle();
+		}
+		printf("  %d bodies, %d steps: %d updates at 30 Hz, %d updates at 144 Hz%s\n", NUM_BODIES, NUM_STEPS, numUpdates30, numUpdates144, 
+			checkResult("physicsworld/frame rates", identical));
+		printf("  world of map stepped by map update and recorded to render stats%s\n", checkResult("physicsworld/map", isMapWorldRecorded()));
+
+		Scene scene;
+		createScene(scene);
+		UpdateTest update;
+		update.physicsWorld = scene.physicsWorld;
+		float time = measure(repeatCount, update);
+		const PhysicsWorld::Stats& stats = scene.physicsWorld->getStats();
+		printf("  %-24s %9.3f ms/update %6d awake %6d contacts %6d proxies\n", "falling", time, stats.numAwakeBodies, stats.numContacts, stats.numProxies);
+
+		runSteps(scene.physicsWorld, 1.0f/60.0f, 60*20);
+		time = measure(repeatCount, update);
+		printf("  %-24s %9.3f ms/update %6d awake %6d contacts %6d proxies\n", "after 20 seconds", time, stats.numAwakeBodies, stats.numContacts, stats.numProxies);
+	}
+}
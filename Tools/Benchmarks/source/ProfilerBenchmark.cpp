@@ -0,0 +1,227 @@
+// Profiler benchmark.
+//
+// Measures cost of a profiling zone, when profiler is enabled and disabled. Then updates a map of 20k game objects
+// with parallel and serial components for some frames with profiler disabled and enabled, prints rolling summary
+// of zones and writes Chrome trace of the frames to profiler_trace.json. Disabled and enabled runs are interleaved
+// after warm-up runs and their medians are compared, so that caches, clock rate and the map changing over time 
+// affect both the same way.
+#include "Benchmarks.h"
+#include <Map.h>
+#include <Layer.h>
+#include <UpdateScheduler.h>
+#include <Profiler.h>
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int NUM_OBJECTS = 20000;
+	const int NUM_ZONES = 100000;
+	const float WORLD_SIZE = 256.0f;
+	const float DELTA_TIME = 1.0f/60.0f;
+	const int NUM_WARMUP_RUNS = 3;
+	const int MIN_SAMPLES = 11;
+
+	/** Returns pseudo random value between 0 and 1 for given seed. */
+	float hash(uint32_t seed)
+	{
+		seed = (seed ^ 61u) ^ (seed >> 16);
+		seed *= 9u;
+		seed = seed ^ (seed >> 4);
+		seed *= 0x27d4eb2du;
+		seed = seed ^ (seed >> 15);
+		return float(seed & 0xffff) / 65535.0f;
+	}
+
+	/** Orbits around a point. */
+	class Orbiter : public Component, public ParallelUpdatable
+	{
+	public:
+		Orbiter(GameObject* owner, uint32_t seed)
+			: Component(owner, Component::getDefaultProperties())
+			, m_center(hash(seed)*WORLD_SIZE, hash(seed+1)*WORLD_SIZE)
+			, m_radius(1.0f + 4.0f*hash(seed+2))
+			, m_speed(0.5f + hash(seed+3))
+			, m_time(0.0f)
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			GameObject* gameObject = (GameObject*)getOwner();
+			m_time += deltaTime;
+			float angle = m_speed*m_time;
+			gameObject->setPosition(m_center + m_radius*vec2(cosf(angle), sinf(angle)));
+		}
+
+	private:
+		vec2	m_center;
+		float	m_radius;
+		float	m_speed;
+		float	m_time;
+	};
+
+	/** Serially updated component, which is instrumented like user components would be. */
+	class Tracker : public Component, public Updatable
+	{
+	public:
+		Tracker(GameObject* owner)
+			: Component(owner, Component::getDefaultProperties())
+			, m_distance(0.0f)
+			, m_previousPosition(owner->getPosition())
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			YAM2D_PROFILE_ZONE("Tracker::update");
+			const vec2& position = ((GameObject*)getOwner())->getPosition();
+			m_distance += length(position - m_previousPosition);
+			m_previousPosition = position;
+		}
+
+	private:
+		float	m_distance;
+		vec2	m_previousPosition;
+	};
+
+	float getMedian(std::vector<float>& times)
+	{
+		std::sort(times.begin(), times.end());
+		const size_t middle = times.size()/2;
+		return (times.size() % 2 == 1) ? times[middle] : 0.5f*(times[middle-1] + times[middle]);
+	}
+
+	/**
+	 * Runs test with profiler disabled and enabled in turns, swapping which goes first each round, after warm-up 
+	 * runs of both. Returns number of samples and median milliseconds of both variants. Profiler is left enabled.
+	 */
+	template<class Func>
+	int measureInterleaved(int repeatCount, Func& func, float& disabledTime, float& enabledTime)
+	{
+		const int numSamples = repeatCount > MIN_SAMPLES ? repeatCount : MIN_SAMPLES;
+		for( int i=0; i<NUM_WARMUP_RUNS; ++i )
+		{
+			Profiler::setEnabled(false);
+			func();
+			Profiler::setEnabled(true);
+			func();
+		}
+
+		yam2d::ElapsedTimer timer;
+		std::vector<float> times[2];
+		for( int i=0; i<numSamples; ++i )
+		{
+			for( int j=0; j<2; ++j )
+			{
+				const int variant = (i + j) % 2; // 0 is disabled, 1 is enabled.
+				Profiler::setEnabled(variant == 1);
+				timer.reset();
+				func();
+				times[variant].push_back(1000.0f*timer.getTime());
+			}
+		}
+
+		Profiler::setEnabled(true);
+		disabledTime = getMedian(times[0]);
+		enabledTime = getMedian(times[1]);
+		return numSamples;
+	}
+
+	struct ZoneTest
+	{
+		int* counter;
+
+		void operator()()
+		{
+			for( int i=0; i<NUM_ZONES; ++i )
+			{
+				YAM2D_PROFILE_ZONE("ZoneTest");
+				++(*counter);
+			}
+		}
+	};
+
+	struct FrameTest
+	{
+		Map* map;
+
+		void operator()()
+		{
+			map->update(DELTA_TIME);
+			YAM2D_PROFILE_FRAME();
+		}
+	};
+}
+
+
+namespace benchmarks
+{
+	void runProfilerBenchmark(int repeatCount)
+	{
+		int counter = 0;
+		ZoneTest zones;
+		zones.counter = &counter;
+		float disabledTime = 0.0f;
+		float enabledTime = 0.0f;
+		int numSamples = measureInterleaved(repeatCount, zones, disabledTime, enabledTime);
+		Profiler::clear();
+		printf("  %-24s %9.1f ns/zone   median of %d\n", "disabled zone", 1.0e6f*disabledTime/float(NUM_ZONES), numSamples);
+		printf("  %-24s %9.1f ns/zone   median of %d\n", "enabled zone", 1.0e6f*enabledTime/float(NUM_ZONES), numSamples);
+
+		Ref<JobSystem> jobSystem = new JobSystem();
+		Ref<UpdateScheduler> scheduler = new UpdateScheduler();
+		scheduler->setJobSystem(jobSystem);
+		Ref<Map> map = new Map(1.0f, 1.0f);
+		map->addLayer(0, new Layer(map, "objects", 1.0f, true, false));
+		map->setUpdateScheduler(scheduler);
+		Layer* layer = map->getLayer(0);
+		for( int i=0; i<NUM_OBJECTS; ++i )
+		{
+			GameObject* gameObject = new GameObject(layer, 0, vec2(0.0f), vec2(1.0f));
+			gameObject->addComponent(new Orbiter(gameObject, uint32_t(i)));
+			if( i % 100 == 0 )
+			{
+				gameObject->addComponent(new Tracker(gameObject));
+			}
+			layer->addGameObject(gameObject);
+		}
+
+		FrameTest frame;
+		frame.map = map;
+		float frameTime = 0.0f;
+		float profiledFrameTime = 0.0f;
+		numSamples = measureInterleaved(repeatCount, frame, frameTime, profiledFrameTime);
+		printf("  %-24s %9.3f ms/frame median of %d\n", "update", frameTime, numSamples);
+		printf("  %-24s %9.3f ms/frame median of %d  %+.1f %%\n", "profiled update", profiledFrameTime, numSamples,
+			100.0f*(profiledFrameTime - frameTime)/frameTime);
+
+		// Frame zones span from the previous frame, so summary and trace are recorded from profiled frames only.
+		Profiler::clear();
+		for( int i=0; i<numSamples; ++i )
+		{
+			frame();
+		}
+
+		std::vector<Profiler::ZoneSummary> summary;
+		Profiler::getSummary(summary);
+		for( size_t i=0; i<summary.size(); ++i )
+		{
+			const Profiler::ZoneSummary& zone = summary[i];
+			printf("  %*s%-*s min %8.3f avg %8.3f max %8.3f ms %8.1f calls\n", 2*zone.depth, "", 36 - 2*zone.depth,
+				zone.name, zone.minTime, zone.averageTime, zone.maxTime, zone.averageCalls);
+		}
+
+		if( !Profiler::writeChromeTrace("profiler_trace.json") )
+		{
+			printf("  TRACE NOT WRITTEN%s\n", checkResult("profiler/trace", false));
+		}
+
+		Profiler::clear();
+		map->setUpdateScheduler(0);
+	}
+}
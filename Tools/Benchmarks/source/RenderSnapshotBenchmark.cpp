@@ -0,0 +1,244 @@
+// Render snapshot benchmark.
+//
+// Measures cost of publishing render snapshots of a map with 10k moving sprites and a static layer, and cost of
+// batching them on render thread. Then runs update and render on separate threads with different update and
+// render rates and reports how snapshots were handed over. Drawing is measured only on headless Linux platform,
+// where GL calls go to the null backend, because on other platforms benchmarks do not have graphics context.
+#include "Benchmarks.h"
+#include <Map.h>
+#include <Layer.h>
+#include <Camera.h>
+#include <Sprite.h>
+#include <RenderSnapshot.h>
+#include <Thread.h>
+#include <math.h>
+#include <stdint.h>
+#if defined(YAM2D_LINUX)
+#include <es_util_linux.h>
+#endif
+
+using namespace yam2d;
+
+namespace
+{
+	const int NUM_SPRITES = 10000;
+	const int NUM_STATIC_SPRITES = 4096;
+	const float WORLD_SIZE = 128.0f;
+	const float DELTA_TIME = 1.0f/60.0f;
+
+	/** Returns pseudo random value between 0 and 1 for given seed. */
+	float hash(uint32_t seed)
+	{
+		seed = (seed ^ 61u) ^ (seed >> 16);
+		seed *= 9u;
+		seed = seed ^ (seed >> 4);
+		seed *= 0x27d4eb2du;
+		seed = seed ^ (seed >> 15);
+		return float(seed & 0xffff) / 65535.0f;
+	}
+
+	/** Moves game object around a circle. */
+	class Mover : public Component, public Updatable
+	{
+	public:
+		Mover(GameObject* owner, uint32_t seed)
+			: Component(owner, Component::getDefaultProperties())
+			, m_center(hash(seed)*WORLD_SIZE, hash(seed+1)*WORLD_SIZE)
+			, m_radius(1.0f + 4.0f*hash(seed+2))
+			, m_speed(0.5f + hash(seed+3))
+			, m_time(0.0f)
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			GameObject* gameObject = (GameObject*)getOwner();
+			m_time += deltaTime;
+			float angle = m_speed*m_time;
+			gameObject->setPosition(m_center + m_radius*vec2(cosf(angle), sinf(angle)));
+			gameObject->setRotation(angle);
+		}
+
+	private:
+		vec2	m_center;
+		float	m_radius;
+		float	m_speed;
+		float	m_time;
+	};
+
+	Map* createMap()
+	{
+		Map* map = new Map(32.0f, 32.0f);
+		map->getCamera()->setScreenSize(1280, 720);
+		map->addLayer(Map::BACKGROUND0, new Layer(map, "static", 1.0f, true, true));
+		map->addLayer(Map::MAPLAYER0, new Layer(map, "objects", 1.0f, true, false));
+
+		Layer* layer = map->getLayer(Map::BACKGROUND0);
+		for( int i=0; i<NUM_STATIC_SPRITES; ++i )
+		{
+			GameObject* gameObject = new GameObject(layer, 0, vec2(float(i%64), float(i/64)), vec2(1.0f));
+			gameObject->addComponent(new Sprite(gameObject));
+			layer->addGameObject(gameObject);
+		}
+
+		layer = map->getLayer(Map::MAPLAYER0);
+		for( int i=0; i<NUM_SPRITES; ++i )
+		{
+			GameObject* gameObject = new GameObject(layer, 0, vec2(0.0f), vec2(1.0f));
+			Sprite* sprite = new Sprite(gameObject);
+			sprite->setColor(hash(i), hash(i+1), hash(i+2));
+			gameObject->addComponent(sprite);
+			gameObject->addComponent(new Mover(gameObject, uint32_t(i)));
+			layer->addGameObject(gameObject);
+		}
+
+		return map;
+	}
+
+	struct UpdateTest
+	{
+		Map* map;
+
+		void operator()()
+		{
+			map->update(DELTA_TIME);
+		}
+	};
+
+	struct BatchTest
+	{
+		RenderSnapshotBuffer* buffer;
+
+		void operator()()
+		{
+			buffer->acquire();
+			buffer->batch();
+		}
+	};
+
+	struct RenderTest
+	{
+		Map* map;
+
+		void operator()()
+		{
+			map->render();
+		}
+	};
+
+	/** Renders map with and without snapshot buffer and reports draw cost and GL calls of one frame. */
+	void runDraw(Map* map, RenderSnapshotBuffer* buffer, int repeatCount)
+	{
+#if defined(YAM2D_LINUX)
+		RenderTest render;
+		render.map = map;
+		for( int i=0; i<2; ++i )
+		{
+			map->setRenderSnapshotBuffer(i == 0 ? 0 : buffer);
+			map->update(DELTA_TIME);
+			render();
+			nullGLResetStats();
+			render();
+			NullGLStats stats = nullGLGetStats();
+			float time = benchmarks::measure(repeatCount, render);
+			printf("  %-28s %9.3f ms/frame %6d draw calls %7d vertices %5d state changes %5d redundant %5d binds\n",
+				i == 0 ? "render" : "render snapshot", time, stats.numDrawCalls, stats.numVertices, stats.numStateChanges,
+				stats.numRedundantStateChanges, stats.numTextureBinds);
+		}
+#endif
+	}
+
+	/** Updates map with fixed rate until given number of updates have been done. */
+	class UpdateThread : public Thread
+	{
+	public:
+		UpdateThread(Map* map, int numUpdates, int sleepTime)
+			: Thread()
+			, m_map(map)
+			, m_numUpdates(numUpdates)
+			, m_sleepTime(sleepTime)
+			, m_done(0)
+		{
+		}
+
+		bool isDone() const { return m_done.get() != 0; }
+
+	protected:
+		virtual void run()
+		{
+			for( int i=0; i<m_numUpdates; ++i )
+			{
+				m_map->update(DELTA_TIME);
+				Thread::sleep(m_sleepTime);
+			}
+			m_done.set(1);
+		}
+
+	private:
+		Map*		m_map;
+		int			m_numUpdates;
+		int			m_sleepTime;
+		AtomicInt	m_done;
+	};
+
+	void runThreaded(Map* map, RenderSnapshotBuffer* buffer, int updateSleepTime, int renderSleepTime)
+	{
+		const int NUM_UPDATES = 200;
+		buffer->resetStats();
+		Ref<UpdateThread> updateThread = new UpdateThread(map, NUM_UPDATES, updateSleepTime);
+		int numInvalid = 0;
+		yam2d::ElapsedTimer timer;
+		timer.reset();
+		updateThread->start();
+		while( !updateThread->isDone() )
+		{
+			const RenderSnapshot* snapshot = buffer->acquire();
+			buffer->batch();
+			if( snapshot->getSequence() != 0 && snapshot->getNumSprites() != NUM_SPRITES )
+			{
+				++numInvalid;
+			}
+			Thread::sleep(renderSleepTime);
+		}
+		updateThread->join();
+		float time = 1000.0f*timer.getTime();
+
+		char name[64];
+		sprintf(name, "update %d ms, render %d ms", updateSleepTime, renderSleepTime);
+		printf("  %-28s %7.1f ms/update %5d published %5d acquired %5d repeated %5d dropped  depth avg %.2f max %d%s\n",
+			name, time/float(NUM_UPDATES), buffer->getNumPublished(), buffer->getNumAcquired(), buffer->getNumRepeated(),
+			buffer->getNumDropped(), buffer->getAverageQueueDepth(), buffer->getMaxQueueDepth(),
+			benchmarks::checkResult(std::string("rendersnapshot/") + name, numInvalid == 0));
+	}
+}
+
+
+namespace benchmarks
+{
+	void runRenderSnapshotBenchmark(int repeatCount)
+	{
+		Ref<Map> map = createMap();
+		UpdateTest update;
+		update.map = map;
+		float updateTime = measure(repeatCount, update);
+		printf("  %-28s %9.3f ms/frame\n", "update", updateTime);
+
+		Ref<RenderSnapshotBuffer> buffer = new RenderSnapshotBuffer();
+		map->setRenderSnapshotBuffer(buffer);
+		float publishTime = measure(repeatCount, update);
+		printf("  %-28s %9.3f ms/frame  %.3f ms for snapshot\n", "update and publish", publishTime, publishTime - updateTime);
+
+		BatchTest batch;
+		batch.buffer = buffer;
+		float batchTime = measure(repeatCount, batch);
+		printf("  %-28s %9.3f ms/frame\n", "acquire and batch", batchTime);
+		runDraw(map, buffer, repeatCount);
+		map->setRenderSnapshotBuffer(buffer);
+
+		// Update faster, in step with and slower than render.
+		runThreaded(map, buffer, 2, 8);
+		runThreaded(map, buffer, 8, 8);
+		runThreaded(map, buffer, 8, 2);
+		map->setRenderSnapshotBuffer(0);
+	}
+}
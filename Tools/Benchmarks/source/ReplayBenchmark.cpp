@@ -0,0 +1,268 @@
+// Replay benchmark.
+//
+// Plays a scripted session of 300 frames of game objects, which are steered with keys and spawned with mouse clicks, through 
+// esMainLoop of the headless Linux platform, and records its input and frame times with esStartInputRecording. Then 
+// replays the recording with linuxSetInputReplay, checks that the replayed session ends in the same state and 
+// prints frame times of the replay. Sessions recorded from a game can be replayed as repeatable benchmarks the same 
+// way. Frame times are written to replay_frame_times.csv.
+#include "Benchmarks.h"
+#if defined(YAM2D_LINUX)
+#include <es_util_linux.h>
+#include <InputRecording.h>
+#include <Input.h>
+#include <Map.h>
+#include <Layer.h>
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int NUM_OBJECTS = 5000;
+	const int NUM_SPAWNED_OBJECTS = 100;
+	const int NUM_FRAMES = 300;
+	const float TIME_STEP = 1.0f/60.0f;
+	const float WORLD_SIZE = 256.0f;
+	const char* const RECORDING_FILE_NAME = "replay_session.yinp";
+	const char* const TIMING_FILE_NAME = "replay_frame_times.csv";
+
+	/** Returns pseudo random value between 0 and 1 for given seed. */
+	float hash(uint32_t seed)
+	{
+		seed = (seed ^ 61u) ^ (seed >> 16);
+		seed *= 9u;
+		seed = seed ^ (seed >> 4);
+		seed *= 0x27d4eb2du;
+		seed = seed ^ (seed >> 15);
+		return float(seed & 0xffff) / 65535.0f;
+	}
+
+	/** Orbits around a center, which follows the target. Orbits faster, when space is held down. */
+	class Follower : public Component, public Updatable
+	{
+	public:
+		Follower(GameObject* owner, GameObject* target, const vec2& center, uint32_t seed)
+			: Component(owner, Component::getDefaultProperties())
+			, m_target(target)
+			, m_center(center)
+			, m_radius(1.0f + 4.0f*hash(seed))
+			, m_speed(0.5f + hash(seed+1))
+			, m_angle(6.28f*hash(seed+2))
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			m_center += 0.1f*deltaTime*(m_target->getPosition() - m_center);
+			m_angle += (getKeyState(KEY_SPACE) ? 4.0f : 1.0f)*m_speed*deltaTime;
+			((GameObject*)getOwner())->setPosition(m_center + m_radius*vec2(cosf(m_angle), sinf(m_angle)));
+		}
+
+	private:
+		GameObject*	m_target;
+		vec2		m_center;
+		float		m_radius;
+		float		m_speed;
+		float		m_angle;
+	};
+
+	struct Session
+	{
+		Ref<Map>	map;
+		GameObject*	player;
+		bool		isScripted;
+		int			numFrames;
+		int			numSpawned;
+		double		checksum;
+	};
+
+	Session session;
+
+	void addFollower(Layer* layer, const vec2& center, uint32_t seed)
+	{
+		GameObject* gameObject = new GameObject(layer, 0, center, vec2(1.0f));
+		gameObject->addComponent(new Follower(gameObject, session.player, center, seed));
+		layer->addGameObject(gameObject);
+	}
+
+	/** Sets input of the scripted session for given frame. */
+	void scriptInput(int frame)
+	{
+		keyState(KEY_RIGHT, (frame / 60) % 2 == 0);
+		keyState(KEY_DOWN, (frame / 90) % 2 == 1);
+		keyState(KEY_SPACE, frame % 100 < 10);
+		mouseState(frame % 45 == 0, false, false, (frame*7) % 256, (frame*3) % 256);
+		if( frame % 120 == 60 )
+		{
+			mouseWheel(1);
+		}
+	}
+
+	bool init(ESContext* esContext)
+	{
+		session.map = new Map(1.0f, 1.0f);
+		session.map->addLayer(0, new Layer(session.map, "objects", 1.0f, true, false));
+		Layer* layer = session.map->getLayer(0);
+		session.player = new GameObject(layer, 0, vec2(0.5f*WORLD_SIZE), vec2(1.0f));
+		layer->addGameObject(session.player);
+		for( int i=0; i<NUM_OBJECTS; ++i )
+		{
+			addFollower(layer, vec2(hash(3*i)*WORLD_SIZE, hash(3*i+1)*WORLD_SIZE), uint32_t(i));
+		}
+		session.numFrames = 0;
+		session.numSpawned = 0;
+		if( session.isScripted )
+		{
+			scriptInput(0);
+		}
+		return true;
+	}
+
+	void update(ESContext* esContext, float deltaTime)
+	{
+		const float speed = 10.0f + 5.0f*float(getMouseWheelDelta());
+		vec2 direction(float(getKeyState(KEY_RIGHT) - getKeyState(KEY_LEFT)), float(getKeyState(KEY_DOWN) - getKeyState(KEY_UP)));
+		session.player->setPosition(session.player->getPosition() + speed*deltaTime*direction);
+
+		if( isMouseButtonPressed(MOUSE_LEFT) )
+		{
+			Layer* layer = session.map->getLayer(0);
+			const vec2 position = vec2(float(getMouseAxisX()), float(getMouseAxisY()));
+			for( int i=0; i<NUM_SPAWNED_OBJECTS; ++i )
+			{
+				addFollower(layer, position, uint32_t(NUM_OBJECTS + session.numSpawned++));
+			}
+		}
+
+		session.map->update(deltaTime);
+	}
+
+	void draw(ESContext* esContext)
+	{
+		// Scripted input of the next frame is set after this frame has been updated, like events between frames.
+		++session.numFrames;
+		if( session.isScripted )
+		{
+			scriptInput(session.numFrames);
+		}
+		session.map->render();
+	}
+
+	void deinit(ESContext* esContext)
+	{
+		session.checksum = 0.0;
+		Layer::GameObjectList& gameObjects = session.map->getLayer(0)->getGameObjects();
+		for( size_t i=0; i<gameObjects.size(); ++i )
+		{
+			session.checksum += double(gameObjects[i]->getPosition().x) + double(gameObjects[i]->getPosition().y);
+		}
+		session.player = 0;
+		session.map = 0;
+	}
+
+	/** Runs session through esMainLoop. Session is scripted and recorded, or replayed from recording. */
+	bool runSession(bool isRecording)
+	{
+		ESContext esContext;
+		esInitContext(&esContext);
+		esCreateWindow(&esContext, "Replay", 1280, 720, ES_WINDOW_DEFAULT);
+		esRegisterInitFunc(&esContext, init);
+		esRegisterUpdateFunc(&esContext, update);
+		esRegisterDrawFunc(&esContext, draw);
+		esRegisterDeinitFunc(&esContext, deinit);
+		esSetFixedTimestep(&esContext, TIME_STEP);
+		session.isScripted = isRecording;
+		if( isRecording )
+		{
+			// Recorded session runs at the target frame rate like a game would.
+			esSetTargetFrameRate(&esContext, 1.0f/TIME_STEP);
+			linuxSetMaxFrames(&esContext, NUM_FRAMES);
+			if( !esStartInputRecording(&esContext, RECORDING_FILE_NAME) )
+			{
+				return false;
+			}
+		}
+		else if( !linuxSetInputReplay(&esContext, RECORDING_FILE_NAME, TIMING_FILE_NAME) )
+		{
+			return false;
+		}
+
+		// Input state is left from the previous session, so start from nothing pressed.
+		for( int i=0; i<InputFrame::NUM_KEYS; ++i )
+		{
+			keyState(KeyCodes(i), false);
+		}
+		mouseState(false, false, false, 0, 0);
+		clearInput();
+
+		esMainLoop(&esContext);
+		return true;
+	}
+}
+
+
+namespace benchmarks
+{
+	void runReplayBenchmark(int repeatCount)
+	{
+		(void)repeatCount;
+		if( !runSession(true) )
+		{
+			printf("  RECORDING FAILED%s\n", checkResult("replay/record", false));
+			return;
+		}
+
+		const double recordedChecksum = session.checksum;
+		const int recordedFrames = session.numFrames;
+		FILE* file = fopen(RECORDING_FILE_NAME, "rb");
+		long recordingSize = 0;
+		if( file != 0 )
+		{
+			fseek(file, 0, SEEK_END);
+			recordingSize = ftell(file);
+			fclose(file);
+		}
+
+		if( !runSession(false) )
+		{
+			printf("  REPLAY FAILED%s\n", checkResult("replay/replay", false));
+			return;
+		}
+
+		std::vector<float> frameTimes = linuxGetReplayFrameTimes();
+		std::sort(frameTimes.begin(), frameTimes.end());
+		float total = 0.0f;
+		for( size_t i=0; i<frameTimes.size(); ++i )
+		{
+			total += frameTimes[i];
+		}
+		const int last = int(frameTimes.size()) - 1;
+		const float average = (last >= 0) ? total/float(frameTimes.size()) : 0.0f;
+		const float percentile95 = (last >= 0) ? frameTimes[(last*95)/100] : 0.0f;
+
+		printf("  %-24s %9d frames %9ld bytes %9.1f bytes/frame\n", "recording", recordedFrames, recordingSize,
+			float(recordingSize)/float(recordedFrames));
+		printf("  %-24s %9d frames %9.3f ms avg %9.3f ms 95%% %9.3f ms max\n", "replay", int(frameTimes.size()), average, 
+			percentile95, (last >= 0) ? frameTimes[last] : 0.0f);
+		printf("  %-24s %s\n", "replayed state", (session.checksum == recordedChecksum && session.numFrames == recordedFrames) 
+			? "equal" : "DIFFERENT");
+		addResult("replay/frame", average, "ms");
+		addResult("replay/frame 95%", percentile95, "ms");
+	}
+}
+
+#else
+
+namespace benchmarks
+{
+	void runReplayBenchmark(int repeatCount)
+	{
+		(void)repeatCount;
+		printf("  Replay needs the headless Linux platform\n");
+	}
+}
+
+#endif
@@ -0,0 +1,244 @@
+// Benchmark results.
+//
+// Keeps results added by benchmarks, writes them to a JSON file and compares them to a baseline file written
+// earlier. Also replaces global operator new and delete to count heap memory allocated by the engine.
+#include "Benchmarks.h"
+#include <PropertySet.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <new>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace
+{
+	struct Result
+	{
+		std::string name;
+		double value;
+		std::string unit;
+	};
+
+	std::vector<Result>& getResults()
+	{
+		static std::vector<Result> results;
+		return results;
+	}
+
+	std::vector<std::string>& getFailures()
+	{
+		static std::vector<std::string> failures;
+		return failures;
+	}
+
+	// Changes of times smaller than this are timer and scheduling noise and not reported as regressions.
+	const double MIN_TIME_CHANGE = 0.05;
+
+	// Allocation header keeps the size of each allocation. Header is 16 bytes to keep allocations aligned for SSE.
+	const size_t HEADER_SIZE = 16;
+
+	volatile long long allocatedBytes = 0;
+
+	void addAllocatedBytes(long long bytes)
+	{
+#if defined(_WIN32)
+		InterlockedExchangeAdd64(&allocatedBytes, bytes);
+#else
+		__sync_add_and_fetch(&allocatedBytes, bytes);
+#endif
+	}
+
+	void* allocate(size_t size)
+	{
+		void* block = malloc(size + HEADER_SIZE);
+		if( block == 0 )
+		{
+			return 0;
+		}
+
+		*(size_t*)block = size;
+		addAllocatedBytes((long long)size);
+		return (char*)block + HEADER_SIZE;
+	}
+
+	void deallocate(void* ptr)
+	{
+		if( ptr == 0 )
+		{
+			return;
+		}
+
+		// Address is computed as integer, so that compiler does not check header access against the bounds of
+		// the object, which is deleted.
+		void* block = (void*)((uintptr_t)ptr - HEADER_SIZE);
+		addAllocatedBytes(-(long long)*(size_t*)block);
+		free(block);
+	}
+
+	/** Reads whole file to string. Returns false, if file can not be read. */
+	bool readFile(const char* fileName, std::string& text)
+	{
+		FILE* file = fopen(fileName, "rb");
+		if( file == 0 )
+		{
+			return false;
+		}
+
+		char buffer[4096];
+		size_t numRead = 0;
+		while( (numRead = fread(buffer, 1, sizeof(buffer), file)) > 0 )
+		{
+			text.append(buffer, numRead);
+		}
+		fclose(file);
+		return true;
+	}
+}
+
+
+void* operator new(size_t size)
+{
+	void* ptr = allocate(size);
+	if( ptr == 0 )
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+	return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+	return allocate(size);
+}
+
+void operator delete(void* ptr) throw()
+{
+	deallocate(ptr);
+}
+
+void operator delete[](void* ptr) throw()
+{
+	deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) throw()
+{
+	deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) throw()
+{
+	deallocate(ptr);
+}
+
+
+namespace benchmarks
+{
+	long long getAllocatedBytes()
+	{
+#if defined(_WIN32)
+		return InterlockedExchangeAdd64(&allocatedBytes, 0);
+#else
+		return __sync_add_and_fetch(&allocatedBytes, 0);
+#endif
+	}
+
+	void addResult(const std::string& name, double value, const char* unit)
+	{
+		Result result;
+		result.name = name;
+		result.value = value;
+		result.unit = unit;
+		getResults().push_back(result);
+	}
+
+	const char* checkResult(const std::string& name, bool valid)
+	{
+		if( valid )
+		{
+			return "";
+		}
+
+		getFailures().push_back(name);
+		return "  INVALID RESULT";
+	}
+
+	const std::vector<std::string>& getFailedChecks()
+	{
+		return getFailures();
+	}
+
+	bool writeResults(const char* fileName)
+	{
+		FILE* file = fopen(fileName, "wb");
+		if( file == 0 )
+		{
+			printf("Results file \"%s\" could not be written\n", fileName);
+			return false;
+		}
+
+		// Flat object, whose keys are result names with units, so that it can be read with PropertySet.
+		const std::vector<Result>& results = getResults();
+		fprintf(file, "{\n");
+		for( size_t i=0; i<results.size(); ++i )
+		{
+			fprintf(file, "\t\"%s %s\": %.4f%s\n", results[i].name.c_str(), results[i].unit.c_str(), results[i].value,
+				(i+1 < results.size()) ? "," : "");
+		}
+		fprintf(file, "}\n");
+		fclose(file);
+		return true;
+	}
+
+	int compareResults(const char* baselineFileName, float thresholdPercent)
+	{
+		std::string json;
+		if( !readFile(baselineFileName, json) )
+		{
+			printf("Baseline file \"%s\" could not be read\n", baselineFileName);
+			return -1;
+		}
+
+		const yam2d::PropertySet baseline = yam2d::PropertySet::createFromJson(json);
+		const std::vector<Result>& results = getResults();
+		printf("Comparing %d results to baseline \"%s\", threshold %.1f %%\n", int(results.size()), baselineFileName, thresholdPercent);
+		int numRegressions = 0;
+		for( size_t i=0; i<results.size(); ++i )
+		{
+			const std::string key = results[i].name + " " + results[i].unit;
+			if( !baseline.hasProperty(key) )
+			{
+				printf("  %-56s %12.4f %-6s  not in baseline\n", results[i].name.c_str(), results[i].value, results[i].unit.c_str());
+				continue;
+			}
+
+			// Smaller is better for all results, so only increases are regressions.
+			const double baselineValue = baseline[key].get<float>();
+			const double change = (baselineValue > 0.0) ? 100.0*(results[i].value - baselineValue)/baselineValue : 0.0;
+			const bool isNoise = results[i].unit == "ms" && results[i].value - baselineValue < MIN_TIME_CHANGE;
+			const bool regressed = change > thresholdPercent && !isNoise;
+			if( regressed )
+			{
+				++numRegressions;
+			}
+			printf("  %-56s %12.4f %-6s %+7.1f %%%s\n", results[i].name.c_str(), results[i].value, results[i].unit.c_str(),
+				change, regressed ? "  REGRESSION" : "");
+		}
+
+		printf("%d regressions\n", numRegressions);
+		return numRegressions;
+	}
+}
@@ -0,0 +1,488 @@
+// Scenario benchmark.
+//
+// Generates synthetic game scenarios: tile maps of increasing size loaded from TMX files, animated sprites,
+// a text heavy HUD and dynamic objects colliding with a tile level. For each scenario load time, heap memory
+// after load and memory accounted by MemoryStats, Map::update, publishing and batching of render snapshots with number of sprites batched from
+// RenderStats and, on headless Linux platform, rendering and drawing to null GL backend are measured. Results are added with addResult, so that they can be compared
+// to a baseline.
+#include "Benchmarks.h"
+#include <Map.h>
+#include <Layer.h>
+#include <Camera.h>
+#include <Sprite.h>
+#include <SpriteSheet.h>
+#include <AnimatedSpriteComponent.h>
+#include <TextComponent.h>
+#include <Texture.h>
+#include <RenderSnapshot.h>
+#include <RenderStats.h>
+#include <PhysicsWorld.h>
+#include <PhysicsBody.h>
+#include <StaticTileBody.h>
+#include <lpng1513/png.h>
+#include <math.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#if defined(YAM2D_LINUX)
+#include <es_util_linux.h>
+#endif
+
+using namespace yam2d;
+
+namespace
+{
+	const int NUM_FRAMES = 10;
+	const int TILE_SIZE = 32;
+	const int TILESET_SIZE = 256;
+	const float DELTA_TIME = 1.0f/60.0f;
+	const char* const TILESET_FILE_NAME = "scenario_tiles.png";
+
+	/** Returns pseudo random value between 0 and 1 for given seed. */
+	float hash(uint32_t seed)
+	{
+		seed = (seed ^ 61u) ^ (seed >> 16);
+		seed *= 9u;
+		seed = seed ^ (seed >> 4);
+		seed *= 0x27d4eb2du;
+		seed = seed ^ (seed >> 15);
+		return float(seed & 0xffff) / 65535.0f;
+	}
+
+	/** Generates RGBA image of cells with different colors. */
+	std::vector<unsigned char> createImage(int width, int height, int cellSize)
+	{
+		std::vector<unsigned char> pixels(width*height*4);
+		for( int y=0; y<height; ++y )
+		{
+			for( int x=0; x<width; ++x )
+			{
+				const uint32_t cell = uint32_t((y/cellSize)*(width/cellSize) + x/cellSize);
+				unsigned char* pixel = &pixels[(y*width + x)*4];
+				pixel[0] = (unsigned char)(255.0f*hash(cell));
+				pixel[1] = (unsigned char)(255.0f*hash(cell+1));
+				pixel[2] = (unsigned char)(255.0f*hash(cell+2));
+				pixel[3] = 255;
+			}
+		}
+		return pixels;
+	}
+
+	bool writePng(const char* fileName, int width, int height, const std::vector<unsigned char>& pixels)
+	{
+		FILE* file = fopen(fileName, "wb");
+		if( file == 0 )
+		{
+			return false;
+		}
+
+		png_structp pngPtr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+		png_infop infoPtr = png_create_info_struct(pngPtr);
+		if( setjmp(png_jmpbuf(pngPtr)) )
+		{
+			png_destroy_write_struct(&pngPtr, &infoPtr);
+			fclose(file);
+			return false;
+		}
+
+		png_init_io(pngPtr, file);
+		png_set_IHDR(pngPtr, infoPtr, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+			PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+		png_write_info(pngPtr, infoPtr);
+		for( int y=0; y<height; ++y )
+		{
+			png_write_row(pngPtr, (png_bytep)&pixels[y*width*4]);
+		}
+		png_write_end(pngPtr, NULL);
+		png_destroy_write_struct(&pngPtr, &infoPtr);
+		fclose(file);
+		return true;
+	}
+
+	void writeLayer(FILE* file, const char* name, int size, bool isStatic, int emptyTileRatio, uint32_t seed)
+	{
+		const int numTiles = (TILESET_SIZE/TILE_SIZE)*(TILESET_SIZE/TILE_SIZE);
+		fprintf(file, " <layer name=\"%s\" width=\"%d\" height=\"%d\">\n", name, size, size);
+		fprintf(file, "  <properties>\n   <property name=\"static\" value=\"%s\"/>\n  </properties>\n", isStatic ? "true" : "false");
+		fprintf(file, "  <data encoding=\"csv\">\n");
+		for( int y=0; y<size; ++y )
+		{
+			for( int x=0; x<size; ++x )
+			{
+				const uint32_t tile = seed + uint32_t(y*size + x);
+				const bool isEmpty = int(hash(tile)*float(emptyTileRatio)) != 0;
+				fprintf(file, "%d%s", isEmpty ? 0 : 1 + int(hash(tile+1)*float(numTiles-1)), (y < size-1 || x < size-1) ? "," : "");
+			}
+			fprintf(file, "\n");
+		}
+		fprintf(file, "  </data>\n </layer>\n");
+	}
+
+	/** Writes map of size x size tiles with static ground layer and dynamic layer of sparse decoration tiles. */
+	bool writeTileMap(const std::string& fileName, int size)
+	{
+		FILE* file = fopen(fileName.c_str(), "wb");
+		if( file == 0 )
+		{
+			return false;
+		}
+
+		fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+		fprintf(file, "<map version=\"1.0\" orientation=\"orthogonal\" width=\"%d\" height=\"%d\" tilewidth=\"%d\" tileheight=\"%d\">\n",
+			size, size, TILE_SIZE, TILE_SIZE);
+		fprintf(file, " <tileset firstgid=\"1\" name=\"tiles\" tilewidth=\"%d\" tileheight=\"%d\">\n", TILE_SIZE, TILE_SIZE);
+		fprintf(file, "  <image source=\"%s\" width=\"%d\" height=\"%d\"/>\n", TILESET_FILE_NAME, TILESET_SIZE, TILESET_SIZE);
+		fprintf(file, " </tileset>\n");
+		writeLayer(file, "Ground", size, true, 1, 0);
+		writeLayer(file, "Decoration", size, false, 16, 7919);
+		fprintf(file, "</map>\n");
+		fclose(file);
+		return true;
+	}
+
+	/** Map of a scenario and objects, which must be released before the map. */
+	struct Scenario
+	{
+		Ref<Map> map;
+		Ref<StaticTileBody> level;
+
+		~Scenario()
+		{
+			release();
+		}
+
+		void release()
+		{
+			// Level refers to Box2D world of the map.
+			level = 0;
+			map = 0;
+		}
+	};
+
+	typedef void (*CreateFunc)(Scenario& scenario, int size);
+
+	Map* createMap()
+	{
+		Map* map = new Map(float(TILE_SIZE), float(TILE_SIZE));
+		map->getCamera()->setScreenSize(1280, 720);
+		return map;
+	}
+
+	void loadTileMap(Scenario& scenario, int size)
+	{
+		static DefaultComponentFactory componentFactory;
+		char fileName[64];
+		sprintf(fileName, "scenario_tilemap_%d.tmx", size);
+		TmxMap* map = new TmxMap();
+		scenario.map = map;
+		if( !map->loadMapFile(fileName, &componentFactory) )
+		{
+			printf("  Map %s could not be loaded%s\n", fileName, benchmarks::checkResult(std::string("scenarios/") + fileName, false));
+			return;
+		}
+		map->getCamera()->setScreenSize(1280, 720);
+		map->getCamera()->setPosition(vec2(float(size/2)));
+	}
+
+	/** Moves game object around a circle. */
+	class Mover : public Component, public Updatable
+	{
+	public:
+		Mover(GameObject* owner, float worldSize, uint32_t seed)
+			: Component(owner, Component::getDefaultProperties())
+			, m_center(hash(seed)*worldSize, hash(seed+1)*worldSize)
+			, m_radius(1.0f + 4.0f*hash(seed+2))
+			, m_speed(0.5f + hash(seed+3))
+			, m_time(0.0f)
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			GameObject* gameObject = (GameObject*)getOwner();
+			m_time += deltaTime;
+			float angle = m_speed*m_time;
+			gameObject->setPosition(m_center + m_radius*vec2(cosf(angle), sinf(angle)));
+		}
+
+	private:
+		vec2	m_center;
+		float	m_radius;
+		float	m_speed;
+		float	m_time;
+	};
+
+	void createSprites(Scenario& scenario, int numSprites)
+	{
+		scenario.map = createMap();
+		scenario.map->addLayer(Map::MAPLAYER0, new Layer(scenario.map, "sprites", 1.0f, true, false));
+		Layer* layer = scenario.map->getLayer(Map::MAPLAYER0);
+		const std::vector<unsigned char> pixels = createImage(TILESET_SIZE, TILESET_SIZE, TILE_SIZE);
+		Ref<Texture> texture = new Texture(&pixels[0], TILESET_SIZE, TILESET_SIZE, 4);
+		Ref<SpriteSheet> spriteSheet = SpriteSheet::generateSpriteSheet(texture, TILE_SIZE, TILE_SIZE, 0, 0, 0, 0);
+		const float worldSize = sqrtf(float(numSprites));
+		for( int i=0; i<numSprites; ++i )
+		{
+			GameObject* gameObject = new GameObject(layer, 0, vec2(0.0f), vec2(1.0f));
+			AnimatedSpriteComponent* animatedSprite = new AnimatedSpriteComponent(gameObject, spriteSheet);
+			animatedSprite->addAnimation(0, SpriteAnimation::SpriteAnimationClip(spriteSheet, 8.0f + 8.0f*hash(i), 1.0f, true));
+			animatedSprite->setActiveAnimation(0);
+			gameObject->addComponent(animatedSprite);
+			gameObject->addComponent(new Mover(gameObject, worldSize, uint32_t(i)));
+			layer->addGameObject(gameObject);
+		}
+	}
+
+	/** Prints changing score and timer to text. */
+	class HudCounter : public Component, public Updatable
+	{
+	public:
+		HudCounter(GameObject* owner, Text* text, int index)
+			: Component(owner, Component::getDefaultProperties())
+			, m_text(text)
+			, m_index(index)
+			, m_frame(0)
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			++m_frame;
+			char str[64];
+			sprintf(str, "Player %3d  Score %08d  Time %7.2f", m_index, m_frame*(m_index+1)*10, float(m_frame)*deltaTime);
+			m_text->setText(str);
+		}
+
+	private:
+		Ref<Text>	m_text;
+		int			m_index;
+		int			m_frame;
+	};
+
+	void createHud(Scenario& scenario, int numTexts)
+	{
+		scenario.map = createMap();
+		scenario.map->addLayer(Map::GUILAYER0, new Layer(scenario.map, "hud", 1.0f, true, false));
+		Layer* layer = scenario.map->getLayer(Map::GUILAYER0);
+
+		// Font of 256 characters 16x16 pixels each.
+		const std::vector<unsigned char> pixels = createImage(TILESET_SIZE, TILESET_SIZE, 16);
+		Ref<Texture> texture = new Texture(&pixels[0], TILESET_SIZE, TILESET_SIZE, 4);
+		Ref<SpriteSheet> font = SpriteSheet::generateSpriteSheet(texture, 16, 16, 0, 0, 0, 0);
+		for( int i=0; i<numTexts; ++i )
+		{
+			GameObject* gameObject = new GameObject(layer, 0, vec2(float(i%4)*10.0f, float(i/4)), vec2(1.0f));
+			TextComponent* textComponent = new TextComponent(gameObject, font);
+			gameObject->addComponent(textComponent);
+			gameObject->addComponent(new HudCounter(gameObject, textComponent->getText(), i));
+			layer->addGameObject(gameObject);
+		}
+	}
+
+	void createPhysics(Scenario& scenario, int numBodies)
+	{
+		scenario.map = createMap();
+		scenario.map->addLayer(Map::MAPLAYER0, new Layer(scenario.map, "bodies", 1.0f, true, false));
+		PhysicsWorld* physicsWorld = new PhysicsWorld(scenario.map);
+		scenario.map->addComponent(physicsWorld);
+
+		// Bodies fall on the floor of a box.
+		const int width = 256;
+		const int height = 32 + numBodies/64;
+		Ref<TileGrid> tileGrid = new TileGrid(width, height);
+		for( int x=0; x<width; ++x )
+		{
+			tileGrid->setSolid(x, height-1, true);
+		}
+		for( int y=0; y<height; ++y )
+		{
+			tileGrid->setSolid(0, y, true);
+			tileGrid->setSolid(width-1, y, true);
+		}
+		scenario.level = new StaticTileBody(physicsWorld->getWorld(), tileGrid);
+
+		Layer* layer = scenario.map->getLayer(Map::MAPLAYER0);
+		for( int i=0; i<numBodies; ++i )
+		{
+			vec2 position(2.0f + float(i % 126)*2.0f + hash(i), 2.0f + float(i / 126)*1.5f);
+			GameObject* gameObject = new GameObject(layer, 0, position, vec2(1.0f));
+			PhysicsBody* body = new PhysicsBody(gameObject, physicsWorld, 0.1f, 0.1f);
+			body->setBoxFixture(vec2(0.8f), vec2(0.0f), 0.0f, false, 1.0f, 0.1f, 0.5f);
+			gameObject->addComponent(body);
+			gameObject->addComponent(new Sprite(gameObject));
+			layer->addGameObject(gameObject);
+		}
+	}
+
+	struct UpdateTest
+	{
+		Map* map;
+
+		void operator()()
+		{
+			for( int i=0; i<NUM_FRAMES; ++i )
+			{
+				map->update(DELTA_TIME);
+			}
+		}
+	};
+
+	struct BatchTest
+	{
+		RenderSnapshotBuffer* buffer;
+
+		void operator()()
+		{
+			for( int i=0; i<NUM_FRAMES; ++i )
+			{
+				buffer->acquire();
+				buffer->batch();
+			}
+		}
+	};
+
+	struct RenderTest
+	{
+		Map* map;
+
+		void operator()()
+		{
+			for( int i=0; i<NUM_FRAMES; ++i )
+			{
+				map->render();
+			}
+		}
+	};
+
+	struct DrawTest
+	{
+		RenderSnapshotBuffer* buffer;
+
+		void operator()()
+		{
+			for( int i=0; i<NUM_FRAMES; ++i )
+			{
+				buffer->draw();
+			}
+		}
+	};
+
+	void runScenario(const char* scenarioName, CreateFunc create, int size, int repeatCount)
+	{
+		const std::string name = std::string("scenarios/") + scenarioName;
+		Scenario scenario;
+
+		// Best load time. Previous map is released before next load, so memory is of one loaded scenario.
+		const long long allocatedBytes = benchmarks::getAllocatedBytes();
+		const int accountedBytes = MemoryStats::getTotalBytes();
+		yam2d::ElapsedTimer timer;
+		float loadTime = -1.0f;
+		for( int i=0; i<repeatCount; ++i )
+		{
+			scenario.release();
+			timer.reset();
+			create(scenario, size);
+			float time = 1000.0f*timer.getTime();
+			loadTime = (loadTime < 0.0f || time < loadTime) ? time : loadTime;
+		}
+		const double memory = double(benchmarks::getAllocatedBytes() - allocatedBytes);
+		const double accountedMemory = double(MemoryStats::getTotalBytes() - accountedBytes);
+		Map* map = scenario.map;
+
+		UpdateTest update;
+		update.map = map;
+		const float updateTime = benchmarks::measure(repeatCount, update)/float(NUM_FRAMES);
+
+		float renderTime = 0.0f;
+		int numDrawCalls = 0;
+		int numVertices = 0;
+#if defined(YAM2D_LINUX)
+		RenderTest render;
+		render.map = map;
+		renderTime = benchmarks::measure(repeatCount, render)/float(NUM_FRAMES);
+		nullGLResetStats();
+		map->render();
+		numDrawCalls = nullGLGetStats().numDrawCalls;
+		numVertices = nullGLGetStats().numVertices;
+#endif
+
+		Ref<RenderSnapshotBuffer> buffer = new RenderSnapshotBuffer();
+		map->setRenderSnapshotBuffer(buffer);
+		const float publishTime = benchmarks::measure(repeatCount, update)/float(NUM_FRAMES);
+		BatchTest batch;
+		batch.buffer = buffer;
+		const float batchTime = benchmarks::measure(repeatCount, batch)/float(NUM_FRAMES);
+		RenderStats::clear();
+		buffer->batch();
+		RenderStats::endFrame();
+		RenderStats::FrameStats frame;
+		RenderStats::getFrame(0, frame);
+		const int numSpritesBatched = frame.total.numSpritesBatched;
+
+		float drawTime = 0.0f;
+#if defined(YAM2D_LINUX)
+		DrawTest draw;
+		draw.buffer = buffer;
+		drawTime = benchmarks::measure(repeatCount, draw)/float(NUM_FRAMES);
+#endif
+		map->setRenderSnapshotBuffer(0);
+
+		printf("  %-20s %9.2f %9.2f %9.2f %9.3f %9.3f %9.3f %7d %9.3f %9.3f %7d %9d\n", scenarioName, loadTime, memory/(1024.0*1024.0),
+			accountedMemory/(1024.0*1024.0), updateTime, publishTime, batchTime, numSpritesBatched, renderTime, drawTime, numDrawCalls, numVertices);
+		benchmarks::addResult(name + "/load", loadTime, "ms");
+		benchmarks::addResult(name + "/memory", memory, "bytes");
+		benchmarks::addResult(name + "/accounted memory", accountedMemory, "bytes");
+		benchmarks::addResult(name + "/update", updateTime, "ms");
+		benchmarks::addResult(name + "/update and publish", publishTime, "ms");
+		benchmarks::addResult(name + "/batch", batchTime, "ms");
+		benchmarks::addResult(name + "/sprites batched", numSpritesBatched, "sprites");
+#if defined(YAM2D_LINUX)
+		benchmarks::addResult(name + "/render", renderTime, "ms");
+		benchmarks::addResult(name + "/draw", drawTime, "ms");
+		benchmarks::addResult(name + "/draw calls", numDrawCalls, "calls");
+		benchmarks::addResult(name + "/vertices", numVertices, "vertices");
+#endif
+	}
+}
+
+
+namespace benchmarks
+{
+	bool writeTilesetPng(const char* fileName, int size, int tileSize)
+	{
+		return writePng(fileName, size, size, createImage(size, size, tileSize));
+	}
+
+	void runScenarioBenchmark(int repeatCount)
+	{
+		const int mapSizes[] = { 64, 256, 512 };
+		const int numMapSizes = sizeof(mapSizes)/sizeof(mapSizes[0]);
+		bool filesWritten = writePng(TILESET_FILE_NAME, TILESET_SIZE, TILESET_SIZE, createImage(TILESET_SIZE, TILESET_SIZE, TILE_SIZE));
+		for( int i=0; i<numMapSizes && filesWritten; ++i )
+		{
+			char fileName[64];
+			sprintf(fileName, "scenario_tilemap_%d.tmx", mapSizes[i]);
+			filesWritten = writeTileMap(fileName, mapSizes[i]);
+		}
+
+		if( !filesWritten )
+		{
+			printf("  Scenario files could not be written to current working directory%s\n", checkResult("scenarios/files", false));
+			return;
+		}
+
+		printf("  %-20s %9s %9s %9s %9s %9s %9s %7s %9s %9s %7s %9s\n", "ms/frame", "load ms", "memory MB", "stats MB", "update", "publish",
+			"batch", "sprites", "render", "draw", "draws", "vertices");
+		for( int i=0; i<numMapSizes; ++i )
+		{
+			char name[64];
+			sprintf(name, "tilemap %dx%d", mapSizes[i], mapSizes[i]);
+			runScenario(name, loadTileMap, mapSizes[i], repeatCount);
+		}
+		runScenario("sprites 1000", createSprites, 1000, repeatCount);
+		runScenario("sprites 10000", createSprites, 10000, repeatCount);
+		runScenario("hud 256 texts", createHud, 256, repeatCount);
+		runScenario("physics 500", createPhysics, 500, repeatCount);
+		runScenario("physics 2000", createPhysics, 2000, repeatCount);
+	}
+}
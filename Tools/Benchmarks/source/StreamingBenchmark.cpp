@@ -0,0 +1,274 @@
+// Streaming benchmark.
+//
+// Walks camera across a streaming map of 256x256 tiles and 2000 tile objects, of which every 4th moves each frame.
+// Regions are cached to disk and evicted behind the camera. Object records of the start region are made unwritable 
+// for a while, so its eviction fails and the region must stay resident. Each frame positions of instantiated 
+// objects are compared to their last known positions, and finally all regions are loaded and every tile and object
+// must exist. Frame times of streaming updates are measured.
+#include "Benchmarks.h"
+#include <StreamingMap.h>
+#include <Layer.h>
+#include <Camera.h>
+#include <Logger.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace yam2d;
+
+namespace
+{
+	const int MAP_SIZE = 256;
+	const int REGION_SIZE = 32;
+	const int NUM_OBJECTS = 2000;
+	const int TILE_SIZE = 32;
+	const int TILESET_SIZE = 128;
+	const char* const TILESET_FILE_NAME = "streaming_tiles.png";
+	const char* const MAP_FILE_NAME = "streaming_map.tmx";
+	const char* const CACHE_DIRECTORY = "streaming_cache";
+	const float DELTA_TIME = 1.0f/60.0f;
+	const vec2 VELOCITY(0.01f, 0.005f); // Tiles per frame of moving objects.
+
+	/** Returns pseudo random value between 0 and 1 for given seed. */
+	float hash(uint32_t seed)
+	{
+		seed = (seed ^ 61u) ^ (seed >> 16);
+		seed *= 9u;
+		seed = seed ^ (seed >> 4);
+		seed *= 0x27d4eb2du;
+		seed = seed ^ (seed >> 15);
+		return float(seed & 0xffff) / 65535.0f;
+	}
+
+	void makeDirectory(const char* path)
+	{
+#if defined(_WIN32)
+		_mkdir(path);
+#else
+		mkdir(path, 0755);
+#endif
+	}
+
+	void removeDirectory(const char* path)
+	{
+#if defined(_WIN32)
+		_rmdir(path);
+#else
+		rmdir(path);
+#endif
+	}
+
+	/** Writes map with ground tile layer and object layer of tile objects named by their index. */
+	bool writeMap()
+	{
+		FILE* file = fopen(MAP_FILE_NAME, "wb");
+		if( file == 0 )
+		{
+			return false;
+		}
+
+		const int numTiles = (TILESET_SIZE/TILE_SIZE)*(TILESET_SIZE/TILE_SIZE);
+		fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+		fprintf(file, "<map version=\"1.0\" orientation=\"orthogonal\" width=\"%d\" height=\"%d\" tilewidth=\"%d\" tileheight=\"%d\">\n",
+			MAP_SIZE, MAP_SIZE, TILE_SIZE, TILE_SIZE);
+		fprintf(file, " <tileset firstgid=\"1\" name=\"tiles\" tilewidth=\"%d\" tileheight=\"%d\">\n", TILE_SIZE, TILE_SIZE);
+		fprintf(file, "  <image source=\"%s\" width=\"%d\" height=\"%d\"/>\n", TILESET_FILE_NAME, TILESET_SIZE, TILESET_SIZE);
+		fprintf(file, " </tileset>\n");
+		fprintf(file, " <layer name=\"Ground\" width=\"%d\" height=\"%d\">\n  <data encoding=\"csv\">\n", MAP_SIZE, MAP_SIZE);
+		for( int i=0; i<MAP_SIZE*MAP_SIZE; ++i )
+		{
+			fprintf(file, "%d%s", 1 + int(hash(uint32_t(i))*float(numTiles-1)), (i < MAP_SIZE*MAP_SIZE-1) ? "," : "\n");
+		}
+		fprintf(file, "  </data>\n </layer>\n");
+		fprintf(file, " <objectgroup name=\"Objects\">\n");
+		for( int i=0; i<NUM_OBJECTS; ++i )
+		{
+			// Moving objects must stay inside the map during the walk.
+			const int x = int((8.0f + hash(uint32_t(2*i + 100000))*float(MAP_SIZE-48))*float(TILE_SIZE));
+			const int y = int((8.0f + hash(uint32_t(2*i + 100001))*float(MAP_SIZE-48))*float(TILE_SIZE));
+			fprintf(file, "  <object name=\"%d\" gid=\"1\" x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\"/>\n", i, x, y, TILE_SIZE, TILE_SIZE);
+		}
+		fprintf(file, " </objectgroup>\n</map>\n");
+		fclose(file);
+		return true;
+	}
+
+	/** Last known positions of objects by name and number of position mismatches. */
+	struct Objects
+	{
+		std::map<std::string, vec2>	positions;
+		int							numMismatches;
+		int							numTiles;
+		int							numObjects;
+	};
+
+	/** 
+	 * Compares positions of instantiated objects to their last known positions, records positions of new ones 
+	 * and moves every 4th object.
+	 */
+	void checkAndMoveObjects(Map* map, Objects& objects)
+	{
+		objects.numTiles = 0;
+		objects.numObjects = 0;
+		for( Map::LayerMap::iterator it = map->getLayers().begin(); it != map->getLayers().end(); ++it )
+		{
+			if( it->second == 0 )
+			{
+				continue;
+			}
+
+			Layer::GameObjectList& gameObjects = it->second->getGameObjects();
+			for( size_t i=0; i<gameObjects.size(); ++i )
+			{
+				GameObject* gameObject = gameObjects[i];
+				const std::string& name = gameObject->getName();
+				if( name.empty() )
+				{
+					++objects.numTiles;
+					continue;
+				}
+
+				++objects.numObjects;
+				std::map<std::string, vec2>::iterator known = objects.positions.find(name);
+				if( known == objects.positions.end() )
+				{
+					known = objects.positions.insert(std::make_pair(name, gameObject->getPosition())).first;
+				}
+				else if( fabsf(known->second.x - gameObject->getPosition().x) > 0.01f || fabsf(known->second.y - gameObject->getPosition().y) > 0.01f )
+				{
+					++objects.numMismatches;
+				}
+
+				if( atoi(name.c_str()) % 4 == 0 )
+				{
+					gameObject->setPosition(gameObject->getPosition() + VELOCITY);
+					known->second = gameObject->getPosition();
+				}
+			}
+		}
+	}
+
+	/** Counts game objects in given region. */
+	int getNumObjectsInRegion(Map* map, int regionX, int regionY)
+	{
+		int res = 0;
+		for( Map::LayerMap::iterator it = map->getLayers().begin(); it != map->getLayers().end(); ++it )
+		{
+			if( it->second == 0 )
+			{
+				continue;
+			}
+
+			Layer::GameObjectList& gameObjects = it->second->getGameObjects();
+			for( size_t i=0; i<gameObjects.size(); ++i )
+			{
+				const vec2& position = gameObjects[i]->getPosition();
+				if( int(position.x + 0.5f) / REGION_SIZE == regionX && int(position.y + 0.5f) / REGION_SIZE == regionY )
+				{
+					++res;
+				}
+			}
+		}
+		return res;
+	}
+}
+
+
+namespace benchmarks
+{
+	void runStreamingBenchmark(int repeatCount)
+	{
+		(void)repeatCount; // Walk is run once, because it changes state of the map.
+		makeDirectory(CACHE_DIRECTORY);
+		if( !writeTilesetPng(TILESET_FILE_NAME, TILESET_SIZE, TILE_SIZE) || !writeMap() )
+		{
+			printf("  Streaming files could not be written to current working directory%s\n", checkResult("streaming/files", false));
+			return;
+		}
+
+		static DefaultComponentFactory componentFactory;
+		Ref<StreamingTmxMap> map = new StreamingTmxMap(REGION_SIZE);
+		map->setRegionCacheDirectory(CACHE_DIRECTORY);
+		map->setEntityBudget(1024);
+		if( !map->loadMapFile(MAP_FILE_NAME, &componentFactory) )
+		{
+			printf("  Map %s could not be loaded%s\n", MAP_FILE_NAME, checkResult("streaming/load", false));
+			return;
+		}
+
+		Objects objects;
+		objects.numMismatches = 0;
+		Camera* camera = map->getCamera();
+		camera->setPosition(vec2(16.0f));
+		map->preloadRegions();
+
+		// Replace object records of the start region with a directory, so that they can not be written. Warnings of 
+		// failed writes are expected meanwhile.
+		std::string blockedFileName = std::string(CACHE_DIRECTORY) + "/region_0_0.objects";
+		remove(blockedFileName.c_str());
+		makeDirectory(blockedFileName.c_str());
+		Logger::setCategoryEnabled(Logger::CATEGORY_ASSETS, false);
+		bool keptResident = true;
+		bool evictedAfterUnblock = true;
+
+		// Walk rows of regions back and forth, one tile per frame, and then back to start.
+		yam2d::ElapsedTimer timer;
+		float totalTime = 0.0f;
+		float maxTime = 0.0f;
+		int numFrames = 0;
+		int maxResidentRegions = 0;
+		for( int row=0; row<MAP_SIZE/REGION_SIZE + 1; ++row )
+		{
+			const bool isLastRow = row == MAP_SIZE/REGION_SIZE;
+			const float y = isLastRow ? 16.0f : float(row*REGION_SIZE + REGION_SIZE/2);
+			for( int step=0; step<MAP_SIZE - REGION_SIZE; ++step )
+			{
+				const float x = float(REGION_SIZE/2 + ((row % 2 == 0) ? step : MAP_SIZE - REGION_SIZE - 1 - step));
+				camera->setPosition(vec2(isLastRow ? float(MAP_SIZE - REGION_SIZE/2 - step) : x, y));
+				timer.reset();
+				map->update(DELTA_TIME);
+				float time = 1000.0f*timer.getTime();
+				totalTime += time;
+				maxTime = time > maxTime ? time : maxTime;
+				++numFrames;
+				maxResidentRegions = map->getNumResidentRegions() > maxResidentRegions ? map->getNumResidentRegions() : maxResidentRegions;
+				checkAndMoveObjects(map, objects);
+
+				if( row == 1 && step == 0 )
+				{
+					// Start region is far behind the camera, but its records could not be written.
+					keptResident = getNumObjectsInRegion(map, 0, 0) > 0;
+					removeDirectory(blockedFileName.c_str());
+					Logger::setCategoryEnabled(Logger::CATEGORY_ASSETS, true);
+				}
+				else if( row == 1 && step == 1 )
+				{
+					evictedAfterUnblock = getNumObjectsInRegion(map, 0, 0) == 0;
+				}
+			}
+		}
+
+		// Load whole map and check every tile and object exists.
+		map->setRegionRadius(MAP_SIZE/REGION_SIZE, MAP_SIZE/REGION_SIZE + 1);
+		map->preloadRegions();
+		checkAndMoveObjects(map, objects);
+		const bool valid = keptResident && evictedAfterUnblock && objects.numMismatches == 0 
+			&& objects.numTiles == MAP_SIZE*MAP_SIZE && objects.numObjects == NUM_OBJECTS && (int)objects.positions.size() == NUM_OBJECTS;
+		printf("  %d frames %9.3f ms/frame avg %9.3f ms/frame max %3d resident regions max\n", numFrames, totalTime/float(numFrames), 
+			maxTime, maxResidentRegions);
+		printf("  %d tiles %d objects %d position mismatches, start region %s while blocked, %s after unblock%s\n", 
+			objects.numTiles, objects.numObjects, objects.numMismatches, keptResident ? "resident" : "EVICTED", 
+			evictedAfterUnblock ? "evicted" : "NOT EVICTED", checkResult("streaming", valid));
+		addResult("streaming/update", totalTime/float(numFrames), "ms");
+		addResult("streaming/max update", maxTime, "ms");
+	}
+}
@@ -0,0 +1,234 @@
+// Tile grid benchmark.
+//
+// Builds 512x512 tile level, where about 30% of tiles are solid, and compares collision tests
+// against TileGrid to testing solid tile game objects through SpatialHashGrid. Raycasts and
+// batched line of sight tests of agents are measured too.
+#include "Benchmarks.h"
+#include <GameObject.h>
+#include <SpatialHashGrid.h>
+#include <TileGrid.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	typedef std::vector< Ref<GameObject> > GameObjectList;
+
+	const int MAP_SIZE = 512;
+	const int NUM_BOXES = 100000;
+	const int NUM_RAYS = 100000;
+	const int NUM_AGENTS = 500;
+	const float MAX_RAY_LENGTH = 32.0f;
+
+	struct Random
+	{
+		uint32_t state;
+
+		Random() : state(98765) {}
+
+		float next(float minValue, float maxValue)
+		{
+			state = state*1103515245u + 12345u;
+			return minValue + (maxValue - minValue) * float((state >> 8) & 0xffff) / 65535.0f;
+		}
+	};
+
+	struct Level
+	{
+		Ref<TileGrid> tileGrid;
+		GameObjectList tiles;
+		Ref<SpatialHashGrid> broadphase;
+		std::vector<vec2> topLefts;
+		std::vector<vec2> bottomRights;
+		std::vector<vec2> rayStarts;
+		std::vector<vec2> rayEnds;
+	};
+
+	void createLevel(Level& level)
+	{
+		Random random;
+		level.tileGrid = new TileGrid(MAP_SIZE, MAP_SIZE);
+		level.broadphase = new SpatialHashGrid(1.0f, MAP_SIZE*MAP_SIZE);
+
+		// Solid blocks of 1-4 tiles.
+		for( int i=0; i<MAP_SIZE*MAP_SIZE/10; ++i )
+		{
+			int x0 = int(random.next(0.0f, float(MAP_SIZE-4)));
+			int y0 = int(random.next(0.0f, float(MAP_SIZE-4)));
+			int w = 1 + int(random.next(0.0f, 3.0f));
+			int h = 1 + int(random.next(0.0f, 3.0f));
+			for( int y=y0; y<y0+h; ++y )
+			{
+				for( int x=x0; x<x0+w; ++x )
+				{
+					level.tileGrid->setSolid(x, y, true);
+				}
+			}
+		}
+
+		for( int y=0; y<MAP_SIZE; ++y )
+		{
+			for( int x=0; x<MAP_SIZE; ++x )
+			{
+				if( level.tileGrid->isSolid(x, y) )
+				{
+					GameObject* tile = new GameObject(0, 0, vec2(float(x)+0.5f, float(y)+0.5f), vec2(1.0f));
+					level.tiles.push_back(tile);
+					level.broadphase->addGameObject(tile);
+				}
+			}
+		}
+
+		for( int i=0; i<NUM_BOXES; ++i )
+		{
+			vec2 topLeft(random.next(0.0f, float(MAP_SIZE)), random.next(0.0f, float(MAP_SIZE)));
+			level.topLefts.push_back(topLeft);
+			level.bottomRights.push_back(topLeft + vec2(random.next(0.5f, 2.0f), random.next(0.5f, 2.0f)));
+		}
+
+		for( int i=0; i<NUM_RAYS; ++i )
+		{
+			vec2 start(random.next(0.0f, float(MAP_SIZE)), random.next(0.0f, float(MAP_SIZE)));
+			level.rayStarts.push_back(start);
+			level.rayEnds.push_back(start + vec2(random.next(-MAX_RAY_LENGTH, MAX_RAY_LENGTH), random.next(-MAX_RAY_LENGTH, MAX_RAY_LENGTH)));
+		}
+	}
+
+	/** Tests boxes against solid tile game objects using broadphase query and collidesTo. */
+	struct BroadphaseOverlapTest
+	{
+		Level* level;
+		int numHits;
+
+		void operator()()
+		{
+			numHits = 0;
+			GameObject* results[64];
+			for( int i=0; i<NUM_BOXES; ++i )
+			{
+				const vec2& topLeft = level->topLefts[i];
+				const vec2& bottomRight = level->bottomRights[i];
+				int numResults = level->broadphase->queryAabb(topLeft, bottomRight, results, 64);
+				for( int r=0; r<numResults && r<64; ++r )
+				{
+					// Touching tiles are not counted, like in TileGrid.
+					if( results[r]->getLeft() < bottomRight.x && topLeft.x < results[r]->getRight()
+						&& results[r]->getTop() < bottomRight.y && topLeft.y < results[r]->getBottom() )
+					{
+						++numHits;
+						break;
+					}
+				}
+			}
+		}
+	};
+
+	/** Tests boxes against TileGrid. */
+	struct TileGridOverlapTest
+	{
+		Level* level;
+		int numHits;
+
+		void operator()()
+		{
+			numHits = 0;
+			for( int i=0; i<NUM_BOXES; ++i )
+			{
+				if( level->tileGrid->overlapsSolid(level->topLefts[i], level->bottomRights[i]) )
+				{
+					++numHits;
+				}
+			}
+		}
+	};
+
+	/** Moves boxes with TileGrid::sweepAabb. */
+	struct TileGridSweepTest
+	{
+		Level* level;
+		float checksum;
+
+		void operator()()
+		{
+			checksum = 0.0f;
+			for( int i=0; i<NUM_BOXES; ++i )
+			{
+				const vec2 delta = level->rayEnds[i] - level->rayStarts[i];
+				const vec2 movement = level->tileGrid->sweepAabb(level->topLefts[i], level->bottomRights[i], delta*0.1f);
+				checksum += movement.x + movement.y;
+			}
+		}
+	};
+
+	/** Casts all rays one at a time. */
+	struct RaycastTest
+	{
+		Level* level;
+		std::vector<TileGrid::RaycastHit> hits;
+		int numHits;
+
+		void operator()()
+		{
+			hits.resize(NUM_RAYS);
+			numHits = level->tileGrid->raycast(&level->rayStarts[0], &level->rayEnds[0], NUM_RAYS, &hits[0]);
+		}
+	};
+
+	/** Tests line of sight from each agent to every other agent. */
+	struct LineOfSightTest
+	{
+		Level* level;
+		std::vector<uint8_t> visible;
+		int numVisible;
+
+		void operator()()
+		{
+			visible.resize(NUM_AGENTS);
+			numVisible = 0;
+			for( int i=0; i<NUM_AGENTS; ++i )
+			{
+				numVisible += level->tileGrid->hasLineOfSight(level->rayStarts[i], &level->rayEnds[0], NUM_AGENTS, &visible[0]);
+			}
+		}
+	};
+}
+
+
+namespace benchmarks
+{
+	void runTileGridBenchmark(int repeatCount)
+	{
+		Level level;
+		createLevel(level);
+		printf("  Map %dx%d tiles, %d solid tiles\n", MAP_SIZE, MAP_SIZE, (int)level.tiles.size());
+
+		BroadphaseOverlapTest broadphaseOverlap = BroadphaseOverlapTest();
+		broadphaseOverlap.level = &level;
+		float time = measure(repeatCount, broadphaseOverlap);
+		printf("  %-30s %9.3f ms %8.1f ns/box %8d hits\n", "overlap, SpatialHashGrid", time, 1000000.0f*time/NUM_BOXES, broadphaseOverlap.numHits);
+
+		TileGridOverlapTest tileGridOverlap = TileGridOverlapTest();
+		tileGridOverlap.level = &level;
+		time = measure(repeatCount, tileGridOverlap);
+		printf("  %-30s %9.3f ms %8.1f ns/box %8d hits%s\n", "overlap, TileGrid", time, 1000000.0f*time/NUM_BOXES, tileGridOverlap.numHits,
+			checkResult("tilegrid/overlap", tileGridOverlap.numHits == broadphaseOverlap.numHits));
+
+		TileGridSweepTest sweep = TileGridSweepTest();
+		sweep.level = &level;
+		time = measure(repeatCount, sweep);
+		printf("  %-30s %9.3f ms %8.1f ns/box\n", "sweepAabb, TileGrid", time, 1000000.0f*time/NUM_BOXES);
+
+		RaycastTest raycast = RaycastTest();
+		raycast.level = &level;
+		time = measure(repeatCount, raycast);
+		printf("  %-30s %9.3f ms %8.1f ns/ray %8d hits\n", "raycast, TileGrid", time, 1000000.0f*time/NUM_RAYS, raycast.numHits);
+
+		LineOfSightTest lineOfSight = LineOfSightTest();
+		lineOfSight.level = &level;
+		time = measure(repeatCount, lineOfSight);
+		printf("  %-30s %9.3f ms %8.1f ns/ray %8d visible\n", "line of sight, 500x500 agents", time, 1000000.0f*time/(NUM_AGENTS*NUM_AGENTS), lineOfSight.numVisible);
+
+		level.broadphase->clear();
+	}
+}
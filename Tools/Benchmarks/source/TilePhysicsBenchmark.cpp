@@ -0,0 +1,244 @@
+// Tile physics benchmark.
+//
+// Builds Box2D collision geometry of 256x128 tile level as one static body per solid tile, like tutorials
+// do for collision objects, and with StaticTileBody using merged rectangles and outlines. Dynamic bodies
+// are dropped on the level and stepped. Greedy meshing and outlines are checked to cover exactly the
+// solid cells.
+#include "Benchmarks.h"
+#include <StaticTileBody.h>
+#include <math.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int MAP_WIDTH = 256;
+	const int MAP_HEIGHT = 128;
+	const int NUM_DYNAMIC_BODIES = 500;
+	const int NUM_STEPS = 120;
+	const float TIME_STEP = 1.0f / 60.0f;
+
+	struct Random
+	{
+		uint32_t state;
+
+		Random() : state(11223) {}
+
+		int next(int maxValue)
+		{
+			state = state*1103515245u + 12345u;
+			return int((state >> 8) % uint32_t(maxValue));
+		}
+	};
+
+	void createLevel(TileGrid* tileGrid)
+	{
+		Random random;
+
+		// Ground, walls, platforms and some rubble.
+		for( int x=0; x<MAP_WIDTH; ++x )
+		{
+			for( int y=MAP_HEIGHT-8; y<MAP_HEIGHT; ++y )
+			{
+				tileGrid->setSolid(x, y, true);
+			}
+		}
+
+		for( int y=0; y<MAP_HEIGHT; ++y )
+		{
+			tileGrid->setSolid(0, y, true);
+			tileGrid->setSolid(MAP_WIDTH-1, y, true);
+		}
+
+		for( int i=0; i<300; ++i )
+		{
+			int x0 = 1 + random.next(MAP_WIDTH-20);
+			int y0 = 16 + random.next(MAP_HEIGHT-30);
+			int length = 3 + random.next(16);
+			int thickness = 1 + random.next(3);
+			for( int y=y0; y<y0+thickness; ++y )
+			{
+				for( int x=x0; x<x0+length; ++x )
+				{
+					tileGrid->setSolid(x, y, true);
+				}
+			}
+		}
+
+		for( int i=0; i<2000; ++i )
+		{
+			tileGrid->setSolid(1 + random.next(MAP_WIDTH-2), 16 + random.next(MAP_HEIGHT-16), true);
+		}
+	}
+
+	/** Creates world with static geometry of given type. Type -1 means one body per tile. */
+	struct StaticGeometryTest
+	{
+		TileGrid* tileGrid;
+		int shapeType;
+		Ref<b2World> world;
+		Ref<StaticTileBody> tileBody;
+
+		void operator()()
+		{
+			tileBody = 0;
+			world = new b2World(b2Vec2(0.0f, 9.81f));
+			if( shapeType >= 0 )
+			{
+				tileBody = new StaticTileBody(world, tileGrid, StaticTileBody::ShapeType(shapeType));
+				return;
+			}
+
+			for( int y=0; y<tileGrid->getHeight(); ++y )
+			{
+				for( int x=0; x<tileGrid->getWidth(); ++x )
+				{
+					if( tileGrid->isSolid(x, y) )
+					{
+						b2BodyDef bodyDef;
+						bodyDef.type = b2_staticBody;
+						bodyDef.position.Set(float(x) + 0.5f, float(y) + 0.5f);
+						b2Body* body = world->CreateBody(&bodyDef);
+						b2PolygonShape shape;
+						shape.SetAsBox(0.5f, 0.5f);
+						body->CreateFixture(&shape, 0.0f);
+					}
+				}
+			}
+		}
+	};
+
+	/** Drops dynamic bodies to the world and steps it. */
+	struct StepTest
+	{
+		b2World* world;
+		int maxContacts;
+
+		void operator()()
+		{
+			Random random;
+			std::vector<b2Body*> bodies;
+			for( int i=0; i<NUM_DYNAMIC_BODIES; ++i )
+			{
+				b2BodyDef bodyDef;
+				bodyDef.type = b2_dynamicBody;
+				bodyDef.position.Set(2.0f + float(random.next(MAP_WIDTH-4)), 2.0f + float(random.next(MAP_HEIGHT-20)));
+				b2Body* body = world->CreateBody(&bodyDef);
+				if( i % 2 == 0 )
+				{
+					b2CircleShape shape;
+					shape.m_radius = 0.45f;
+					body->CreateFixture(&shape, 1.0f);
+				}
+				else
+				{
+					b2PolygonShape shape;
+					shape.SetAsBox(0.4f, 0.4f);
+					body->CreateFixture(&shape, 1.0f);
+				}
+				bodies.push_back(body);
+			}
+
+			maxContacts = 0;
+			for( int i=0; i<NUM_STEPS; ++i )
+			{
+				world->Step(TIME_STEP, 8, 3);
+				maxContacts = world->GetContactCount() > maxContacts ? world->GetContactCount() : maxContacts;
+			}
+
+			for( size_t i=0; i<bodies.size(); ++i )
+			{
+				world->DestroyBody(bodies[i]);
+			}
+		}
+	};
+
+	int countSolidCells(const TileGrid* tileGrid)
+	{
+		int numSolid = 0;
+		for( int y=0; y<tileGrid->getHeight(); ++y )
+		{
+			for( int x=0; x<tileGrid->getWidth(); ++x )
+			{
+				numSolid += tileGrid->isSolid(x, y) ? 1 : 0;
+			}
+		}
+		return numSolid;
+	}
+
+	/** Checks that rectangles cover each solid cell once and outlines enclose area of solid cells. */
+	bool validateGeometry(const TileGrid* tileGrid)
+	{
+		std::vector<TileGrid::CellRect> rectangles;
+		tileGrid->getSolidRectangles(rectangles);
+		std::vector<int> coverage(tileGrid->getWidth()*tileGrid->getHeight(), 0);
+		for( size_t i=0; i<rectangles.size(); ++i )
+		{
+			for( int y=rectangles[i].y; y<rectangles[i].y+rectangles[i].height; ++y )
+			{
+				for( int x=rectangles[i].x; x<rectangles[i].x+rectangles[i].width; ++x )
+				{
+					++coverage[y*tileGrid->getWidth() + x];
+				}
+			}
+		}
+
+		for( int y=0; y<tileGrid->getHeight(); ++y )
+		{
+			for( int x=0; x<tileGrid->getWidth(); ++x )
+			{
+				if( coverage[y*tileGrid->getWidth() + x] != (tileGrid->isSolid(x, y) ? 1 : 0) )
+				{
+					return false;
+				}
+			}
+		}
+
+		// Signed area of clockwise (on screen) outlines is positive and holes are negative.
+		std::vector< std::vector<vec2> > outlines;
+		tileGrid->getSolidOutlines(outlines);
+		float area = 0.0f;
+		for( size_t i=0; i<outlines.size(); ++i )
+		{
+			const std::vector<vec2>& outline = outlines[i];
+			for( size_t j=0; j<outline.size(); ++j )
+			{
+				const vec2& a = outline[j];
+				const vec2& b = outline[(j + 1) % outline.size()];
+				area += a.x*b.y - b.x*a.y;
+			}
+		}
+		return fabsf(0.5f*area - float(countSolidCells(tileGrid))) < 0.5f;
+	}
+}
+
+
+namespace benchmarks
+{
+	void runTilePhysicsBenchmark(int repeatCount)
+	{
+		Ref<TileGrid> tileGrid = new TileGrid(MAP_WIDTH, MAP_HEIGHT);
+		createLevel(tileGrid);
+		printf("  Map %dx%d tiles, %d solid tiles, %d dynamic bodies, %d steps%s\n", MAP_WIDTH, MAP_HEIGHT, countSolidCells(tileGrid),
+			NUM_DYNAMIC_BODIES, NUM_STEPS, checkResult("tilephysics/geometry", validateGeometry(tileGrid)));
+
+		const char* names[3] = { "body per tile", "merged rectangles", "outlines" };
+		for( int shapeType=-1; shapeType<=StaticTileBody::SHAPE_OUTLINES; ++shapeType )
+		{
+			StaticGeometryTest geometry;
+			geometry.tileGrid = tileGrid;
+			geometry.shapeType = shapeType;
+			float buildTime = measure(repeatCount, geometry);
+			int numStaticProxies = geometry.world->GetProxyCount();
+
+			StepTest step = StepTest();
+			step.world = geometry.world;
+			float stepTime = measure(repeatCount, step);
+			printf("  %-20s build %8.3f ms %7d proxies  step %8.3f ms/step %6d contacts\n", names[shapeType + 1], buildTime,
+				numStaticProxies, stepTime/NUM_STEPS, step.maxContacts);
+
+			geometry.tileBody = 0;
+		}
+	}
+}
@@ -0,0 +1,276 @@
+// Tile layer decoding benchmark.
+//
+// Writes synthetic 1024x1024 tile maps (over million tiles) with each tile layer data
+// encoding supported by Tiled and measures how fast the tiles are decoded and resolved
+// to tilesets with the streaming TmxReader and with tmx-parser.
+#include "Benchmarks.h"
+#include <TmxReader.h>
+#include <tmx-parser/Tmx.h>
+#include <tmx-parser/base64/base64.h>
+#include <zlib-1.2.7/zlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int MAP_WIDTH = 1024;
+	const int MAP_HEIGHT = 1024;
+	const int NUM_TILESETS = 3;
+	const int TILES_PER_TILESET = 256;
+
+	enum Encoding
+	{
+		ENCODING_CSV = 0,
+		ENCODING_BASE64,
+		ENCODING_ZLIB,
+		ENCODING_GZIP,
+		NUM_ENCODINGS
+	};
+
+	const char* const encodingNames[NUM_ENCODINGS] = { "csv", "base64", "zlib", "gzip" };
+
+	/** Returns checksum of one decoded tile. Same checksum is calculated from the results of both parsers. */
+	unsigned tileChecksum(int tilesetIndex, unsigned id, bool flipH, bool flipV, bool flipD)
+	{
+		return unsigned(tilesetIndex)*7919u + id*31u + (flipH ? 1u : 0u) + (flipV ? 2u : 0u) + (flipD ? 4u : 0u);
+	}
+
+	/** Generates gids of the map. About every tenth tile is empty and some tiles are flipped. Returns checksum of the tiles. */
+	unsigned generateGids(std::vector<uint32_t>& gids)
+	{
+		gids.resize(MAP_WIDTH*MAP_HEIGHT);
+		unsigned checksum = 0;
+		uint32_t random = 12345;
+		for( size_t i=0; i<gids.size(); ++i )
+		{
+			random = random*1103515245u + 12345u;
+			const uint32_t r = random >> 8;
+			if( (r % 10) == 0 )
+			{
+				gids[i] = 0;
+				continue;
+			}
+
+			const int tilesetIndex = int((r >> 4) % NUM_TILESETS);
+			const unsigned id = (r >> 8) % TILES_PER_TILESET;
+			const uint32_t flags = ((r >> 16) & 1) ? TmxReader::FLIPPED_HORIZONTALLY_FLAG : 0;
+			gids[i] = (1 + tilesetIndex*TILES_PER_TILESET + id) | flags;
+			checksum += tileChecksum(tilesetIndex, id, flags != 0, false, false);
+		}
+		return checksum;
+	}
+
+	std::string compress(const std::vector<uint32_t>& gids, bool gzip)
+	{
+		// Gids are stored as little endian 32 bit integers.
+		std::vector<unsigned char> bytes(gids.size()*4);
+		for( size_t i=0; i<gids.size(); ++i )
+		{
+			bytes[4*i+0] = (unsigned char)(gids[i]);
+			bytes[4*i+1] = (unsigned char)(gids[i] >> 8);
+			bytes[4*i+2] = (unsigned char)(gids[i] >> 16);
+			bytes[4*i+3] = (unsigned char)(gids[i] >> 24);
+		}
+
+		std::vector<unsigned char> output(compressBound(uLong(bytes.size())) + 32);
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY);
+		stream.next_in = &bytes[0];
+		stream.avail_in = uInt(bytes.size());
+		stream.next_out = &output[0];
+		stream.avail_out = uInt(output.size());
+		deflate(&stream, Z_FINISH);
+		const size_t size = output.size() - stream.avail_out;
+		deflateEnd(&stream);
+		return base64_encode(&output[0], unsigned(size));
+	}
+
+	std::string encodeData(const std::vector<uint32_t>& gids, Encoding encoding)
+	{
+		if( encoding == ENCODING_CSV )
+		{
+			std::string text;
+			text.reserve(gids.size()*5);
+			char number[16];
+			for( int y=0; y<MAP_HEIGHT; ++y )
+			{
+				text += "\n";
+				for( int x=0; x<MAP_WIDTH; ++x )
+				{
+					sprintf(number, "%u", gids[y*MAP_WIDTH+x]);
+					text += number;
+					if( y < MAP_HEIGHT-1 || x < MAP_WIDTH-1 )
+					{
+						text += ",";
+					}
+				}
+			}
+			return text + "\n";
+		}
+
+		if( encoding == ENCODING_BASE64 )
+		{
+			std::vector<unsigned char> bytes(gids.size()*4);
+			for( size_t i=0; i<gids.size(); ++i )
+			{
+				for( int b=0; b<4; ++b )
+				{
+					bytes[4*i+b] = (unsigned char)(gids[i] >> (8*b));
+				}
+			}
+			return "\n   " + base64_encode(&bytes[0], unsigned(bytes.size())) + "\n  ";
+		}
+
+		return "\n   " + compress(gids, encoding == ENCODING_GZIP) + "\n  ";
+	}
+
+	bool writeMap(const std::string& fileName, const std::vector<uint32_t>& gids, Encoding encoding)
+	{
+		FILE* file = fopen(fileName.c_str(), "wb");
+		if( file == 0 )
+		{
+			return false;
+		}
+
+		fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+		fprintf(file, "<map version=\"1.0\" orientation=\"orthogonal\" width=\"%d\" height=\"%d\" tilewidth=\"32\" tileheight=\"32\">\n", MAP_WIDTH, MAP_HEIGHT);
+		for( int i=0; i<NUM_TILESETS; ++i )
+		{
+			fprintf(file, " <tileset firstgid=\"%d\" name=\"tiles%d\" tilewidth=\"32\" tileheight=\"32\">\n", 1 + i*TILES_PER_TILESET, i);
+			fprintf(file, "  <image source=\"tiles%d.png\" width=\"512\" height=\"512\"/>\n", i);
+			fprintf(file, " </tileset>\n");
+		}
+		fprintf(file, " <layer name=\"Ground\" width=\"%d\" height=\"%d\">\n", MAP_WIDTH, MAP_HEIGHT);
+		if( encoding == ENCODING_CSV )
+		{
+			fprintf(file, "  <data encoding=\"csv\">");
+		}
+		else if( encoding == ENCODING_BASE64 )
+		{
+			fprintf(file, "  <data encoding=\"base64\">");
+		}
+		else
+		{
+			fprintf(file, "  <data encoding=\"base64\" compression=\"%s\">", encodingNames[encoding]);
+		}
+
+		const std::string data = encodeData(gids, encoding);
+		fwrite(data.c_str(), 1, data.length(), file);
+		fprintf(file, "</data>\n </layer>\n</map>\n");
+		fclose(file);
+		return true;
+	}
+
+	/** Decodes map with TmxReader. */
+	struct TmxReaderDecode
+	{
+		std::string fileName;
+		unsigned checksum;
+
+		void operator()()
+		{
+			checksum = 0;
+			TmxReader reader;
+			if( !reader.open(fileName) )
+			{
+				return;
+			}
+
+			const std::vector<TmxReader::Tileset>& tilesets = reader.getTilesets();
+			for( TmxReader::Event event = reader.next(); event != TmxReader::EVENT_END && event != TmxReader::EVENT_ERROR; event = reader.next() )
+			{
+				if( event != TmxReader::EVENT_TILES )
+				{
+					continue;
+				}
+
+				const std::vector<uint32_t>& tiles = reader.getTiles();
+				for( size_t i=0; i<tiles.size(); ++i )
+				{
+					const uint32_t gid = tiles[i];
+					const int tilesetIndex = reader.findTilesetIndex(gid);
+					if( tilesetIndex >= 0 )
+					{
+						checksum += tileChecksum(tilesetIndex, (gid & TmxReader::GID_MASK) - tilesets[tilesetIndex].firstGid,
+							(gid & TmxReader::FLIPPED_HORIZONTALLY_FLAG) != 0, (gid & TmxReader::FLIPPED_VERTICALLY_FLAG) != 0, (gid & TmxReader::FLIPPED_DIAGONALLY_FLAG) != 0);
+					}
+				}
+			}
+		}
+	};
+
+	/** Decodes map with tmx-parser. */
+	struct TmxParserDecode
+	{
+		std::string fileName;
+		unsigned checksum;
+
+		void operator()()
+		{
+			checksum = 0;
+			Tmx::Map map;
+			map.ParseFile(fileName);
+			if( map.HasError() || map.GetNumLayers() == 0 )
+			{
+				return;
+			}
+
+			const Tmx::TileLayer* layer = (const Tmx::TileLayer*)map.GetLayer(0);
+			for( int y=0; y<layer->GetHeight(); ++y )
+			{
+				for( int x=0; x<layer->GetWidth(); ++x )
+				{
+					const Tmx::MapTile& tile = layer->GetTile(x, y);
+					if( tile.tilesetId >= 0 )
+					{
+						checksum += tileChecksum(tile.tilesetId, tile.id, tile.flippedHorizontally, tile.flippedVertically, tile.flippedDiagonally);
+					}
+				}
+			}
+		}
+	};
+
+	void printResult(const char* parserName, const char* encodingName, float milliseconds, bool valid)
+	{
+		const float megaTilesPerSecond = float(MAP_WIDTH*MAP_HEIGHT) / (1000.0f*milliseconds);
+		printf("  %-12s %-8s %9.2f ms %9.2f Mtiles/s%s\n", parserName, encodingName, milliseconds, megaTilesPerSecond, 
+			benchmarks::checkResult(std::string("tmx/") + parserName + " " + encodingName, valid));
+	}
+}
+
+
+namespace benchmarks
+{
+	void runTmxDecodeBenchmark(int repeatCount)
+	{
+		std::vector<uint32_t> gids;
+		const unsigned expectedChecksum = generateGids(gids);
+		printf("  Map size %dx%d (%d tiles), %d tilesets\n", MAP_WIDTH, MAP_HEIGHT, MAP_WIDTH*MAP_HEIGHT, NUM_TILESETS);
+
+		for( int e=0; e<NUM_ENCODINGS; ++e )
+		{
+			const std::string fileName = std::string("tmx_benchmark_") + encodingNames[e] + ".tmx";
+			if( !writeMap(fileName, gids, Encoding(e)) )
+			{
+				printf("  Could not write %s%s\n", fileName.c_str(), checkResult("tmx/" + fileName, false));
+				continue;
+			}
+
+			TmxReaderDecode reader;
+			reader.fileName = fileName;
+			float time = measure(repeatCount, reader);
+			printResult("TmxReader", encodingNames[e], time, reader.checksum == expectedChecksum);
+
+			TmxParserDecode parser;
+			parser.fileName = fileName;
+			time = measure(repeatCount, parser);
+			printResult("tmx-parser", encodingNames[e], time, parser.checksum == expectedChecksum);
+
+			remove(fileName.c_str());
+		}
+	}
+}
@@ -0,0 +1,226 @@
+// Update LOD benchmark.
+//
+// Updates a layer of 20k moving game objects every frame and with UpdateScheduler, which updates far away 
+// objects every 2nd, 4th and 8th frame. Updates of each band must be spread evenly over frames and objects must
+// get all elapsed time, only delayed by at most interval of their band. Last run deletes the first object of the
+// layer and adds a new one every frame, which must not make other objects miss their turn.
+#include "Benchmarks.h"
+#include <UpdateScheduler.h>
+#include <Map.h>
+#include <Layer.h>
+#include <Camera.h>
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	const int WORLD_SIZE = 256;
+	const int NUM_OBJECTS = 20000;
+	const int NUM_FRAMES = 240;
+	const float DELTA_TIME = 1.0f/60.0f;
+
+	struct Random
+	{
+		uint32_t state;
+
+		Random() : state(24680) {}
+
+		float next(float minValue, float maxValue)
+		{
+			state = state*1103515245u + 12345u;
+			return minValue + (maxValue - minValue) * float((state >> 8) & 0xffff) / 65535.0f;
+		}
+	};
+
+	/** Moves and bounces its game object inside the world. Stands for typical game logic of background objects. */
+	class Wanderer : public Component, public LodUpdatable
+	{
+	public:
+		Wanderer(GameObject* owner, const vec2& velocity)
+			: Component(owner, Component::getDefaultProperties())
+			, m_velocity(velocity)
+			, m_totalTime(0.0f)
+			, m_maxDeltaTime(0.0f)
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			GameObject* gameObject = (GameObject*)getOwner();
+			vec2 position = gameObject->getPosition() + deltaTime*m_velocity;
+			if( position.x < 0.0f || position.x > float(WORLD_SIZE) )
+			{
+				m_velocity.x = -m_velocity.x;
+			}
+			if( position.y < 0.0f || position.y > float(WORLD_SIZE) )
+			{
+				m_velocity.y = -m_velocity.y;
+			}
+			gameObject->setRotation(atan2f(m_velocity.y, m_velocity.x));
+			gameObject->setPosition(position);
+			m_totalTime += deltaTime;
+			m_maxDeltaTime = deltaTime > m_maxDeltaTime ? deltaTime : m_maxDeltaTime;
+		}
+
+		float getTotalTime() const { return m_totalTime; }
+
+		float getMaxDeltaTime() const { return m_maxDeltaTime; }
+
+	private:
+		vec2	m_velocity;
+		float	m_totalTime;
+		float	m_maxDeltaTime;
+	};
+
+	/** Updated every frame, like gameplay critical components. */
+	class FrameCounter : public Component, public Updatable
+	{
+	public:
+		FrameCounter(GameObject* owner)
+			: Component(owner, Component::getDefaultProperties())
+			, m_numFrames(0)
+		{
+		}
+
+		virtual void update(float deltaTime)
+		{
+			++m_numFrames;
+		}
+
+		int getNumFrames() const { return m_numFrames; }
+
+	private:
+		int		m_numFrames;
+	};
+
+	struct Scene
+	{
+		Ref<Map> map;
+		Ref<Layer> layer;
+		std::vector<Wanderer*> wanderers;
+		std::vector<FrameCounter*> frameCounters;
+		std::vector< Ref<GameObject> > deletedObjects; // Keeps deleted objects alive for checking results.
+		Random random;
+	};
+
+	GameObject* addWanderer(Scene& scene)
+	{
+		vec2 position(scene.random.next(0.0f, float(WORLD_SIZE)), scene.random.next(0.0f, float(WORLD_SIZE)));
+		vec2 velocity(scene.random.next(-2.0f, 2.0f), scene.random.next(-2.0f, 2.0f));
+		GameObject* gameObject = new GameObject(scene.layer, 0, position, vec2(1.0f));
+		Wanderer* wanderer = new Wanderer(gameObject, velocity);
+		gameObject->addComponent(wanderer);
+		scene.wanderers.push_back(wanderer);
+		return gameObject;
+	}
+
+	void createScene(Scene& scene)
+	{
+		scene.map = new Map(1.0f, 1.0f);
+		scene.map->getCamera()->setPosition(float(WORLD_SIZE/2), float(WORLD_SIZE/2));
+		scene.layer = new Layer(scene.map, "objects", 1.0f, true, false);
+
+		for( int i=0; i<NUM_OBJECTS; ++i )
+		{
+			GameObject* gameObject = addWanderer(scene);
+			if( i % 100 == 0 )
+			{
+				FrameCounter* frameCounter = new FrameCounter(gameObject);
+				gameObject->addComponent(frameCounter);
+				scene.frameCounters.push_back(frameCounter);
+			}
+			scene.layer->addGameObject(gameObject);
+		}
+	}
+
+	struct UpdateTest
+	{
+		UpdateScheduler* scheduler;
+		Scene* scene;
+		bool churn;
+
+		void operator()()
+		{
+			if( churn )
+			{
+				// Deleting the first object shifts indices of all other objects in the layer.
+				std::vector<GameObject*> deleted(1, scene->layer->getGameObjects()[0].ptr());
+				scene->deletedObjects.push_back(deleted[0]);
+				scene->layer->removeGameObjects(deleted);
+				scene->layer->addGameObject(addWanderer(*scene));
+			}
+
+			scheduler->beginFrame(scene->map->getCamera());
+			scheduler->updateLayer(scene->layer, DELTA_TIME);
+		}
+	};
+
+	void run(int repeatCount, const char* name, UpdateScheduler* scheduler, bool churn)
+	{
+		Scene scene;
+		createScene(scene);
+		UpdateTest update;
+		update.scheduler = scheduler;
+		update.scene = &scene;
+		update.churn = churn;
+
+		int minUpdated = NUM_OBJECTS;
+		int maxUpdated = 0;
+		for( int i=0; i<NUM_FRAMES; ++i )
+		{
+			update();
+			if( i >= 8 )
+			{
+				minUpdated = scheduler->getNumUpdated() < minUpdated ? scheduler->getNumUpdated() : minUpdated;
+				maxUpdated = scheduler->getNumUpdated() > maxUpdated ? scheduler->getNumUpdated() : maxUpdated;
+			}
+		}
+
+		// Every object must have got all time except at most 7 delayed frames, and critical components every frame.
+		// Objects must never wait more than 8 frames between updates. Objects deleted or added during the run are
+		// only checked for the wait.
+		const size_t numDeleted = scene.deletedObjects.size();
+		float maxLag = 0.0f;
+		bool valid = true;
+		for( size_t i=numDeleted; i<scene.wanderers.size(); ++i )
+		{
+			valid = valid && scene.wanderers[i]->getMaxDeltaTime() < 8.5f*DELTA_TIME;
+			if( i >= size_t(NUM_OBJECTS) )
+			{
+				continue;
+			}
+
+			float lag = float(NUM_FRAMES)*DELTA_TIME - scene.wanderers[i]->getTotalTime();
+			maxLag = lag > maxLag ? lag : maxLag;
+			valid = valid && lag > -0.001f && lag < 7.5f*DELTA_TIME;
+		}
+		for( size_t i=0; i<scene.frameCounters.size(); ++i )
+		{
+			valid = valid && (100*i < numDeleted || scene.frameCounters[i]->getNumFrames() == NUM_FRAMES);
+		}
+
+		float time = benchmarks::measure(repeatCount, update);
+		printf("  %-24s %9.3f ms/frame %6d-%d objects/frame  max lag %d frames%s\n", name, time, minUpdated, maxUpdated, 
+			int(maxLag/DELTA_TIME + 0.5f), benchmarks::checkResult(std::string("updatelod/") + name, valid));
+	}
+}
+
+
+namespace benchmarks
+{
+	void runUpdateLodBenchmark(int repeatCount)
+	{
+		Ref<UpdateScheduler> everyFrame = new UpdateScheduler();
+		run(repeatCount, "every frame", everyFrame, false);
+
+		Ref<UpdateScheduler> bands = new UpdateScheduler();
+		bands->addBand(32.0f, 2);
+		bands->addBand(64.0f, 4);
+		bands->addBand(96.0f, 8);
+		run(repeatCount, "bands 32/64/96 tiles", bands, false);
+		run(repeatCount, "bands, add and delete", bands, true);
+	}
+}
@@ -0,0 +1,143 @@
+// Benchmarks for yam2d engine.
+//
+// Usage: Benchmarks [benchmark name] [repeat count] [--json file] [--baseline file] [--threshold percent]
+// Without arguments all benchmarks are run. Name "all" runs all benchmarks with a repeat count.
+//
+// --json writes results of benchmarks, which add them (currently "scenarios" and "replay"), to JSON file. 
+// --baseline compares results to JSON file written earlier with --json. If any result is larger than 
+// in baseline by more than threshold percent (default 10), the run fails with exit code 2.
+// If any correctness check of benchmarks failed (see checkResult), the run fails with exit code 3.
+#include "Benchmarks.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+	struct Benchmark
+	{
+		const char* name;
+		void (*run)(int repeatCount);
+	};
+
+	const Benchmark benchmarkList[] = 
+	{
+		{ "tmx", benchmarks::runTmxDecodeBenchmark },
+		{ "broadphase", benchmarks::runBroadphaseBenchmark },
+		{ "extents", benchmarks::runExtentsBenchmark },
+		{ "tilegrid", benchmarks::runTileGridBenchmark },
+		{ "pathfinding", benchmarks::runPathfindingBenchmark },
+		{ "flowfield", benchmarks::runFlowFieldBenchmark },
+		{ "tilephysics", benchmarks::runTilePhysicsBenchmark },
+		{ "physicsworld", benchmarks::runPhysicsWorldBenchmark },
+		{ "updatelod", benchmarks::runUpdateLodBenchmark },
+		{ "jobs", benchmarks::runJobSystemBenchmark },
+		{ "parallelupdate", benchmarks::runParallelUpdateBenchmark },
+		{ "rendersnapshot", benchmarks::runRenderSnapshotBenchmark },
+		{ "profiler", benchmarks::runProfilerBenchmark },
+		{ "scenarios", benchmarks::runScenarioBenchmark },
+		{ "replay", benchmarks::runReplayBenchmark },
+		{ "streaming", benchmarks::runStreamingBenchmark },
+		{ "assets", benchmarks::runAssetLoaderBenchmark },
+	};
+
+	const int numBenchmarks = sizeof(benchmarkList)/sizeof(benchmarkList[0]);
+}
+
+
+int main ( int argc, char *argv[] )
+{
+	const char* name = 0;
+	const char* repeatCountArg = 0;
+	const char* jsonFileName = 0;
+	const char* baselineFileName = 0;
+	float threshold = 10.0f;
+	for( int i=1; i<argc; ++i )
+	{
+		if( strncmp(argv[i], "--", 2) == 0 && i+1 >= argc )
+		{
+			printf("Option %s needs a value\n", argv[i]);
+			return 1;
+		}
+
+		if( strcmp(argv[i], "--json") == 0 )
+		{
+			jsonFileName = argv[++i];
+		}
+		else if( strcmp(argv[i], "--baseline") == 0 )
+		{
+			baselineFileName = argv[++i];
+		}
+		else if( strcmp(argv[i], "--threshold") == 0 )
+		{
+			threshold = float(atof(argv[++i]));
+		}
+		else if( name == 0 )
+		{
+			name = argv[i];
+		}
+		else
+		{
+			repeatCountArg = argv[i];
+		}
+	}
+
+	if( name != 0 && strcmp(name, "all") == 0 )
+	{
+		name = 0;
+	}
+
+	int repeatCount = (repeatCountArg != 0) ? atoi(repeatCountArg) : 5;
+	if( repeatCount < 1 )
+	{
+		repeatCount = 1;
+	}
+
+	bool found = false;
+	for( int i=0; i<numBenchmarks; ++i )
+	{
+		if( name == 0 || strcmp(name, benchmarkList[i].name) == 0 )
+		{
+			printf("Running benchmark \"%s\"\n", benchmarkList[i].name);
+			benchmarkList[i].run(repeatCount);
+			found = true;
+		}
+	}
+
+	if( !found )
+	{
+		printf("Unknown benchmark \"%s\". Available benchmarks:\n", name);
+		for( int i=0; i<numBenchmarks; ++i )
+		{
+			printf("  %s\n", benchmarkList[i].name);
+		}
+		return 1;
+	}
+
+	if( jsonFileName != 0 && !benchmarks::writeResults(jsonFileName) )
+	{
+		return 1;
+	}
+
+	int numRegressions = 0;
+	if( baselineFileName != 0 )
+	{
+		numRegressions = benchmarks::compareResults(baselineFileName, threshold);
+		if( numRegressions < 0 )
+		{
+			return 1;
+		}
+	}
+
+	const std::vector<std::string>& failedChecks = benchmarks::getFailedChecks();
+	if( !failedChecks.empty() )
+	{
+		printf("%d checks failed:\n", int(failedChecks.size()));
+		for( size_t i=0; i<failedChecks.size(); ++i )
+		{
+			printf("  %s\n", failedChecks[i].c_str());
+		}
+		return 3;
+	}
+
+	return numRegressions > 0 ? 2 : 0;
+}
@@ -0,0 +1,279 @@
+// Job system tests.
+//
+// Runs each test with 0, 1 and 3 worker threads. Parallel for must visit every index of a range exactly once,
+// task graph jobs must start only after their dependencies have finished, idle workers must steal jobs spawned by
+// another worker, finished jobs must run again and jobs must be able to wait other jobs.
+#include "Tests.h"
+#include <JobSystem.h>
+#include <vector>
+
+using namespace yam2d;
+
+namespace
+{
+	struct VisitRange : public JobSystem::RangeFunction
+	{
+		std::vector<AtomicInt>* visits;
+		int offset;
+
+		virtual void execute(int begin, int end)
+		{
+			for( int i=begin; i<end; ++i )
+			{
+				(*visits)[i - offset].increment();
+			}
+		}
+	};
+
+	void testParallelFor(JobSystem* jobSystem)
+	{
+		// Ranges, which are empty, smaller than grain size, not aligned to it and start from negative index.
+		const int ranges[][3] =
+		{
+			{ 0, 0, 16 }, { 5, 4, 16 }, { 0, 1, 16 }, { 0, 10, 16 }, { 3, 10000, 7 }, { -100, 100, 1 }, { 0, 100000, 4096 }
+		};
+
+		for( size_t r=0; r<sizeof(ranges)/sizeof(ranges[0]); ++r )
+		{
+			const int begin = ranges[r][0];
+			const int end = ranges[r][1];
+			const int size = end > begin ? end - begin : 0;
+			std::vector<AtomicInt> visits(size + 2);
+			VisitRange function;
+			function.visits = &visits;
+			function.offset = begin - 1; // Index before begin and at end must stay unvisited.
+			jobSystem->parallelFor(begin, end, ranges[r][2], &function);
+
+			bool visitedOnce = visits[0].get() == 0 && visits[size+1].get() == 0;
+			for( int i=1; i<=size; ++i )
+			{
+				visitedOnce = visitedOnce && visits[i].get() == 1;
+			}
+			TEST_CHECK( visitedOnce );
+		}
+	}
+
+	/** Job, which records order of its start and finish and how many times it has run. */
+	class StampJob : public Job
+	{
+	public:
+		StampJob() : Job(), clock(0), startStamp(-1), finishStamp(-1), numRuns(0) {}
+
+		virtual void execute()
+		{
+			startStamp = clock->increment();
+			Thread::sleep(0);
+			finishStamp = clock->increment();
+			++numRuns;
+		}
+
+		AtomicInt*	clock;
+		int			startStamp;
+		int			finishStamp;
+		int			numRuns;
+	};
+
+	/** Runs graph, where jobs of each layer depend on two jobs of previous layer, and checks order of jobs. */
+	void runGraph(JobSystem* jobSystem, std::vector<StampJob>& jobs, int width)
+	{
+		AtomicInt clock;
+		for( size_t i=0; i<jobs.size(); ++i )
+		{
+			jobs[i].clock = &clock;
+			jobs[i].startStamp = -1;
+			jobs[i].finishStamp = -1;
+			if( int(i) >= width )
+			{
+				const int layerStart = (int(i)/width - 1)*width;
+				jobs[i].addDependency(&jobs[layerStart + (int(i)*7) % width]);
+				jobs[i].addDependency(&jobs[layerStart + (int(i)*13 + 1) % width]);
+			}
+		}
+
+		// Last layer first, so jobs are queued by dependency counters and not by order of run calls.
+		JobCounter counter;
+		for( size_t i=jobs.size(); i>0; --i )
+		{
+			jobSystem->run(&jobs[i-1], &counter);
+		}
+		jobSystem->wait(&counter);
+		TEST_CHECK( counter.isDone() );
+
+		for( size_t i=0; i<jobs.size(); ++i )
+		{
+			TEST_CHECK( jobs[i].startStamp >= 0 && jobs[i].finishStamp > jobs[i].startStamp );
+			if( int(i) >= width )
+			{
+				const int layerStart = (int(i)/width - 1)*width;
+				TEST_CHECK( jobs[layerStart + (int(i)*7) % width].finishStamp < jobs[i].startStamp );
+				TEST_CHECK( jobs[layerStart + (int(i)*13 + 1) % width].finishStamp < jobs[i].startStamp );
+			}
+		}
+	}
+
+	void testDependencies(JobSystem* jobSystem)
+	{
+		const int width = 16;
+		std::vector<StampJob> jobs(width*16);
+		runGraph(jobSystem, jobs, width);
+
+		// Graph runs again after it has finished, with dependencies added again.
+		runGraph(jobSystem, jobs, width);
+		for( size_t i=0; i<jobs.size(); ++i )
+		{
+			TEST_CHECK( jobs[i].numRuns == 2 );
+		}
+	}
+
+	void testRunAgain(JobSystem* jobSystem)
+	{
+		AtomicInt clock;
+		StampJob job;
+		job.clock = &clock;
+		JobCounter counter;
+		for( int i=0; i<100; ++i )
+		{
+			// Job and counter are used again as soon as the previous run has been waited.
+			jobSystem->run(&job, &counter);
+			jobSystem->wait(&counter);
+			TEST_CHECK( job.numRuns == i+1 && counter.isDone() );
+		}
+	}
+
+	/** Job, which records thread it ran in. */
+	class ThreadIndexJob : public Job
+	{
+	public:
+		ThreadIndexJob() : Job(), jobSystem(0), threadIndex(-1) {}
+
+		virtual void execute()
+		{
+			threadIndex = jobSystem->getCurrentThreadIndex();
+			Thread::sleep(2);
+		}
+
+		JobSystem*	jobSystem;
+		int			threadIndex;
+	};
+
+	/** Job, which spawns jobs to its own queue and waits them. */
+	class SpawnJob : public Job
+	{
+	public:
+		SpawnJob() : Job(), jobSystem(0), threadIndex(-1), children(32) {}
+
+		virtual void execute()
+		{
+			threadIndex = jobSystem->getCurrentThreadIndex();
+			JobCounter counter;
+			for( size_t i=0; i<children.size(); ++i )
+			{
+				children[i].jobSystem = jobSystem;
+				jobSystem->run(&children[i], &counter);
+			}
+			jobSystem->wait(&counter);
+		}
+
+		JobSystem*						jobSystem;
+		int								threadIndex;
+		std::vector<ThreadIndexJob>		children;
+	};
+
+	void testStealing(JobSystem* jobSystem)
+	{
+		SpawnJob spawn;
+		spawn.jobSystem = jobSystem;
+		JobCounter counter;
+		jobSystem->run(&spawn, &counter);
+		jobSystem->wait(&counter);
+
+		// Children are in the queue of the spawning thread, so children run in other threads have been stolen.
+		int numStolen = 0;
+		for( size_t i=0; i<spawn.children.size(); ++i )
+		{
+			TEST_CHECK( spawn.children[i].threadIndex >= 0 && spawn.children[i].threadIndex <= jobSystem->getNumWorkers() );
+			numStolen += spawn.children[i].threadIndex != spawn.threadIndex ? 1 : 0;
+		}
+
+		if( jobSystem->getNumWorkers() > 1 )
+		{
+			TEST_CHECK( numStolen > 0 );
+		}
+		else if( jobSystem->getNumWorkers() == 0 )
+		{
+			TEST_CHECK( numStolen == 0 );
+		}
+	}
+
+	/** Sums range by splitting it to two jobs, which are waited inside this job, until it is small. */
+	class SumJob : public Job
+	{
+	public:
+		SumJob() : Job(), jobSystem(0), begin(0), end(0), sum(0) {}
+
+		virtual void execute()
+		{
+			if( end - begin <= 16 )
+			{
+				sum = 0;
+				for( int i=begin; i<end; ++i )
+				{
+					sum += i;
+				}
+				return;
+			}
+
+			const int middle = (begin + end) / 2;
+			SumJob left;
+			SumJob right;
+			left.init(jobSystem, begin, middle);
+			right.init(jobSystem, middle, end);
+			JobCounter counter;
+			jobSystem->run(&left, &counter);
+			jobSystem->run(&right, &counter);
+			jobSystem->wait(&counter);
+			sum = left.sum + right.sum;
+		}
+
+		void init(JobSystem* jobSystem, int begin, int end)
+		{
+			this->jobSystem = jobSystem;
+			this->begin = begin;
+			this->end = end;
+		}
+
+		JobSystem*	jobSystem;
+		int			begin;
+		int			end;
+		long long	sum;
+	};
+
+	void testWaitInsideJob(JobSystem* jobSystem)
+	{
+		const int n = 20000;
+		SumJob root;
+		root.init(jobSystem, 0, n);
+		JobCounter counter;
+		jobSystem->run(&root, &counter);
+		jobSystem->wait(&counter);
+		TEST_CHECK( root.sum == (long long)n*(n-1)/2 );
+	}
+}
+
+
+namespace tests
+{
+	void runJobSystemTests()
+	{
+		const int numWorkers[] = { 0, 1, 3 };
+		for( int i=0; i<3; ++i )
+		{
+			Ref<JobSystem> jobSystem = new JobSystem(numWorkers[i]);
+			testParallelFor(jobSystem);
+			testDependencies(jobSystem);
+			testRunAgain(jobSystem);
+			testStealing(jobSystem);
+			testWaitInsideJob(jobSystem);
+		}
+	}
+}
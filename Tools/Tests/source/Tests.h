@@ -0,0 +1,24 @@
+// Tests for yam2d engine.
+//
+// Each test suite checks results with TEST_CHECK, which records failed checks with their location. Tests exit
+// with non-zero exit code, if any check failed, see main.cpp.
+#ifndef TESTS_H_
+#define TESTS_H_
+
+#include <stdio.h>
+
+namespace tests
+{
+	/** Records failed check and prints its expression and location. */
+	void fail(const char* expression, const char* file, int line);
+
+	/** Returns number of failed checks. */
+	int getNumFailures();
+
+	/** Checks parallel for, task graph order, work stealing, running jobs again and waiting inside jobs of JobSystem. */
+	void runJobSystemTests();
+}
+
+#define TEST_CHECK(expression) ((expression) ? (void)0 : tests::fail(#expression, __FILE__, __LINE__))
+
+#endif // TESTS_H_
@@ -0,0 +1,74 @@
+// Tests for yam2d engine.
+//
+// Usage: Tests [test suite name]
+// Without arguments all test suites are run. Exit code is 1, if any check failed.
+#include "Tests.h"
+#include <string.h>
+
+namespace
+{
+	struct TestSuite
+	{
+		const char* name;
+		void (*run)();
+	};
+
+	const TestSuite testSuiteList[] = 
+	{
+		{ "jobs", tests::runJobSystemTests },
+	};
+
+	const int numTestSuites = sizeof(testSuiteList)/sizeof(testSuiteList[0]);
+
+	int numFailures = 0;
+}
+
+
+namespace tests
+{
+	void fail(const char* expression, const char* file, int line)
+	{
+		printf("  %s(%d): check failed: %s\n", file, line, expression);
+		++numFailures;
+	}
+
+	int getNumFailures()
+	{
+		return numFailures;
+	}
+}
+
+
+int main ( int argc, char *argv[] )
+{
+	const char* name = (argc > 1) ? argv[1] : 0;
+	bool found = false;
+	for( int i=0; i<numTestSuites; ++i )
+	{
+		if( name == 0 || strcmp(name, testSuiteList[i].name) == 0 )
+		{
+			printf("Running tests \"%s\"\n", testSuiteList[i].name);
+			const int numFailuresBefore = numFailures;
+			testSuiteList[i].run();
+			printf("  %s\n", numFailures == numFailuresBefore ? "passed" : "FAILED");
+			found = true;
+		}
+	}
+
+	if( !found )
+	{
+		printf("Unknown test suite \"%s\". Available test suites:\n", name);
+		for( int i=0; i<numTestSuites; ++i )
+		{
+			printf("  %s\n", testSuiteList[i].name);
+		}
+		return 1;
+	}
+
+	if( numFailures > 0 )
+	{
+		printf("%d checks failed\n", numFailures);
+		return 1;
+	}
+	return 0;
+}
@@ -115,7 +115,10 @@ void deinit ( ESContext *esContext )
 // Update game
 void update( ESContext* esContext, float deltaTime )
 {
-	
+	// Update map first. It stores transforms of GameObjects before they are moved, so that draw can 
+	// interpolate between them.
+	map->update(deltaTime);
+
 	map->getCamera()->setScreenSize(esContext->width,esContext->height, 720, 1280.0f/720.0f); 
 
 	// Read mouse values
@@ -135,9 +138,6 @@ void update( ESContext* esContext, float deltaTime )
 	// Move game object according to arrow keys.
 	moveGameObjectAccordingToKeypresses(gameObject,2.0f,deltaTime,true);
 	//moveGameObjectAccordingToKeypresses(gameObject,2.0f,deltaTime,false);
-	
-	// Update map. this will update all GameObjects inside a map layers.
-	map->update(deltaTime);
 }
 
 
@@ -153,7 +153,9 @@ void draw ( ESContext *esContext )
 	// Set screen size to camera.
 	map->getCamera()->setScreenSize(esContext->width,esContext->height, 720, 1280.0f/720.0f); 
 
-	// Render map and all of its layers containing GameObjects to screen.
+	// Render map and all of its layers containing GameObjects to screen. Updates run with fixed time step, so
+	// GameObjects are drawn between their last two updated positions.
+	map->setInterpolationAlpha(esGetInterpolationAlpha(esContext));
 	map->render();
 }
 
@@ -168,6 +170,7 @@ int main ( int argc, char *argv[] )
 	esRegisterDrawFunc( &esContext, draw );
 	esRegisterUpdateFunc( &esContext, update );
     esRegisterDeinitFunc( &esContext, deinit);
+	esSetFixedTimestep( &esContext, 1.0f/60.0f );
 
 	esMainLoop ( &esContext );
 	return 0;
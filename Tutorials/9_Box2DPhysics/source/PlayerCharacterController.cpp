@@ -23,7 +23,7 @@
 #include "PlayerCharacterController.h" // Include Player class header
 
 #include "Input.h"
-#include "PhysicsBody.h"
+#include <PhysicsBody.h>
 
 using namespace yam2d; // Use namespace yam3d implicitily.
 
@@ -3,7 +3,8 @@
 // Include map class
 #include <Map.h>
 #include "PlayerCharacterController.h"
-#include "PhysicsBody.h"
+#include <PhysicsWorld.h>
+#include <PhysicsBody.h>
 #include "PhysicsCollider.h"
 #include <TextComponent.h>
 // Camera class
@@ -35,7 +36,7 @@ namespace
 		yam2d::Ref<Texture> m_enemyTexture;
 		Map* m_map; // HACK. Player to set for each enemy
 
-		yam2d::Ref<b2World> m_world;
+		yam2d::Ref<PhysicsWorld> m_world;
 		yam2d::Ref<MyContactListener> m_contactListener;
 
 	public:
@@ -45,19 +46,23 @@ namespace
 			, m_enemyTexture()
 			, m_map(0)
 		{
-			m_world = new b2World(vec2(0,9.81f));
-			m_world->SetAllowSleeping(false);
 			m_contactListener = new MyContactListener();
-			m_world->SetContactListener(m_contactListener);
 		}
 
 		void setCurrentMap(Map* map)
 		{
 			m_map = map;
+
+			// Physics world is a component of the map and it is stepped, when the map is updated.
+			m_world = new PhysicsWorld(map, vec2(0,9.81f));
+			m_world->getWorld()->SetAllowSleeping(false);
+			m_world->getWorld()->SetContactListener(m_contactListener);
+			m_world->setIterations(10, 10);
+			map->addComponent(m_world);
 		}
 
 
-		b2World* getPhysicsWorld()
+		PhysicsWorld* getPhysicsWorld()
 		{
 			return m_world;
 		}
@@ -94,6 +99,8 @@ namespace
 				// Dynamic body				
 				
 				PhysicsBody* body = new PhysicsBody(gameObject, m_world, linearDamping, angularDamping );
+				body->setBullet(true);
+				body->setSleepingAllowed(false);
 				float density = 1.0f;
 				float friction = 1.0f;
 				// Make playes a bit smaller than actual for making physics work okay in the level.
@@ -110,6 +117,8 @@ namespace
 			
 				// Dynamic body
 				PhysicsBody* body = new PhysicsBody(gameObject, m_world, linearDamping, angularDamping);
+				body->setBullet(true);
+				body->setSleepingAllowed(false);
 				float density = 0.5f;
 				float friction = 0.5f;
 				vec2 center = yam2d::vec2(0, 0);
@@ -214,9 +223,7 @@ void update( ESContext* ctx, float deltaTime )
 	Camera* camera = map->getCamera();
 	camera->setPosition(camera->getPosition() + vec2(delta, 0));
 
-	componentFactory->getPhysicsWorld()->Step(deltaTime, 10, 10);
-	
-	// Update map. this will update all GameObjects inside a map layers.
+	// Update map. This steps the physics world and updates all GameObjects inside map layers.
 	map->update(deltaTime);
 
 	// Quit if excape pressed
@@ -35,6 +35,31 @@ LOCAL_SRC_FILES := \
 	$(ENGINE_SRC_PATH)/SpriteBatch.cpp \
 	$(ENGINE_SRC_PATH)/SpriteSheet.cpp \
 	$(ENGINE_SRC_PATH)/StreamTexture.cpp \
+	$(ENGINE_SRC_PATH)/InputRecording.cpp \
+	$(ENGINE_SRC_PATH)/Logger.cpp \
+	$(ENGINE_SRC_PATH)/MemoryStats.cpp \
+	$(ENGINE_SRC_PATH)/RenderStatsOverlay.cpp \
+	$(ENGINE_SRC_PATH)/RenderStats.cpp \
+	$(ENGINE_SRC_PATH)/Profiler.cpp \
+	$(ENGINE_SRC_PATH)/RenderSnapshot.cpp \
+	$(ENGINE_SRC_PATH)/CommandBuffer.cpp \
+	$(ENGINE_SRC_PATH)/JobSystem.cpp \
+	$(ENGINE_SRC_PATH)/UpdateScheduler.cpp \
+	$(ENGINE_SRC_PATH)/PhysicsWorld.cpp \
+	$(ENGINE_SRC_PATH)/PhysicsBody.cpp \
+	$(ENGINE_SRC_PATH)/StaticTileBody.cpp \
+	$(ENGINE_SRC_PATH)/FlowField.cpp \
+	$(ENGINE_SRC_PATH)/Pathfinder.cpp \
+	$(ENGINE_SRC_PATH)/TileGrid.cpp \
+	$(ENGINE_SRC_PATH)/ExtentsBuffer.cpp \
+	$(ENGINE_SRC_PATH)/DynamicAabbTree.cpp \
+	$(ENGINE_SRC_PATH)/SpatialHashGrid.cpp \
+	$(ENGINE_SRC_PATH)/Broadphase.cpp \
+	$(ENGINE_SRC_PATH)/TmxReader.cpp \
+	$(ENGINE_SRC_PATH)/AssetLoader.cpp \
+	$(ENGINE_SRC_PATH)/StreamingMap.cpp \
+	$(ENGINE_SRC_PATH)/Thread.cpp \
+	$(ENGINE_SRC_PATH)/TextureConverter.cpp \
 	$(ENGINE_SRC_PATH)/Text.cpp \
 	$(ENGINE_SRC_PATH)/Texture.cpp \
 	$(ENGINE_SRC_PATH)/Tileset.cpp \
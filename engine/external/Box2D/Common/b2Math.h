@@ -25,7 +25,7 @@
 #include <cfloat>
 #include <cstddef>
 #include <limits>
-#include <slm\vec2.h>
+#include <slm/vec2.h>
 
 /// This function is used to ensure that a floating point number is
 /// not a NaN or infinity.
@@ -29,6 +29,7 @@
 #include <zlib-1.2.7/zlib.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <vector>
 
 #include "TmxLayer.h"
 #include "TmxUtil.h"
@@ -37,6 +38,71 @@
 
 namespace Tmx 
 {
+	namespace
+	{
+		const unsigned MaxTilesetTableSize = 64 * 1024;
+
+		//-------------------------------------------------------------------------
+		// Table from gid to tileset index, so that the tilesets are not searched
+		// for every tile of the layer.
+		//-------------------------------------------------------------------------
+		class TilesetTable
+		{
+		public:
+			TilesetTable(const Map *_map)
+				: map(_map)
+				, table()
+			{
+				// Gids from the largest first gid onwards belong to the last tileset.
+				unsigned size = 0;
+				for (int i = 0; i < map->GetNumTilesets(); ++i)
+				{
+					const unsigned firstGid = (unsigned)map->GetTileset(i)->GetFirstGid();
+					if (firstGid + 1 > size)
+					{
+						size = firstGid + 1;
+					}
+				}
+				complete = size <= MaxTilesetTableSize;
+				table.resize(complete ? size : MaxTilesetTableSize);
+
+				for (unsigned gid = 0; gid < table.size(); ++gid)
+				{
+					table[gid] = map->FindTilesetIndex(gid);
+				}
+			}
+
+			// Convert a gid to a map tile.
+			MapTile GetTile(unsigned gid) const
+			{
+				const unsigned id = gid & ~(FlippedHorizontallyFlag | FlippedVerticallyFlag | FlippedDiagonallyFlag);
+				int tilesetIndex;
+				if (id < table.size())
+				{
+					tilesetIndex = table[id];
+				}
+				else
+				{
+					tilesetIndex = complete ? map->GetNumTilesets() - 1 : map->FindTilesetIndex(gid);
+				}
+
+				if (tilesetIndex != -1)
+				{
+					// If valid, set up the map tile with the tileset.
+					return MapTile(gid, map->GetTileset(tilesetIndex)->GetFirstGid(), tilesetIndex);
+				}
+
+				// Otherwise, make it null.
+				return MapTile(gid, 0, (unsigned int)-1);
+			}
+
+		private:
+			const Map *map;
+			std::vector<int> table;
+			bool complete;
+		};
+	}
+
 	Layer::Layer(const Map *_map) 
 		: map(_map)
 		, name() 
@@ -161,9 +227,11 @@ namespace Tmx
 	void TileLayer::ParseXML(const TiXmlNode *dataNode) 
 	{
 		const TiXmlNode *tileNode = dataNode->FirstChild("tile");
+		const TilesetTable tilesets(GetMap());
+		const size_t numTiles = GetWidth() * GetHeight();
 		size_t tileCount = 0;
 
-		while (tileNode) 
+		while (tileNode && tileCount < numTiles) 
 		{
 			const TiXmlElement *tileElem = tileNode->ToElement();
 			
@@ -173,22 +241,13 @@ namespace Tmx
 			const char* gidText = tileElem->Attribute("gid");
 
 			// Convert to an unsigned.
-			sscanf(gidText, "%u", &gid);
-
-			// Find the tileset index.
-			const int tilesetIndex = GetMap()->FindTilesetIndex(gid);
-			if (tilesetIndex != -1)
-			{
-				// If valid, set up the map tile with the tileset.
-				const Tmx::Tileset* tileset = GetMap()->GetTileset(tilesetIndex);
-				tile_map[tileCount] = MapTile(gid, tileset->GetFirstGid(), tilesetIndex);
-			}
-			else
+			if (gidText)
 			{
-				// Otherwise, make it null.
-				tile_map[tileCount] = MapTile(gid, 0, (unsigned int)-1);
+				gid = (unsigned)strtoul(gidText, NULL, 10);
 			}
 
+			tile_map[tileCount] = tilesets.GetTile(gid);
+
 			tileNode = dataNode->IterateChildren("tile", tileNode);
 			tileCount++;
 		}
@@ -197,105 +256,71 @@ namespace Tmx
 	void TileLayer::ParseBase64(const std::string &innerText) 
 	{
 		const std::string &text = Util::DecodeBase64(innerText);
+		const size_t numTiles = GetWidth() * GetHeight();
 
-		// Temporary array of gids to be converted to map tiles.
-		unsigned *out = 0;
+		// Little endian gids are read straight from the decoded or
+		// uncompressed bytes, without copying them to a temporary array.
+		const unsigned char *data = (const unsigned char *)text.data();
+		size_t dataSize = text.size();
+		std::vector<unsigned char> uncompressed;
+		char *gzipData = 0;
 
 		if (compression == TMX_COMPRESSION_ZLIB) 
 		{
-			// Use zlib to uncompress the layer into the temporary array of tiles.
-			uLongf outlen = GetWidth() * GetHeight() * 4;
-			out = (unsigned *)malloc(outlen);
-			uncompress(
-				(Bytef*)out, &outlen, 
-				(const Bytef*)text.c_str(), text.size());
-	
+			// Use zlib to uncompress the layer.
+			uLongf outlen = numTiles * 4;
+			uncompressed.resize(outlen);
+			if (outlen == 0 || uncompress(&uncompressed[0], &outlen, (const Bytef*)text.data(), text.size()) != Z_OK)
+			{
+				outlen = 0;
+			}
+			data = outlen > 0 ? &uncompressed[0] : 0;
+			dataSize = outlen;
 		} 
 		else if (compression == TMX_COMPRESSION_GZIP) 
 		{
 			// Use the utility class for decompressing (which uses zlib)
-			out = (unsigned *)Util::DecompressGZIP(
-				text.c_str(), 
-				text.size(), 
-				GetWidth() * GetWidth() * 4);
+			gzipData = Util::DecompressGZIP(text.data(), text.size(), numTiles * 4);
+			data = (const unsigned char *)gzipData;
+			dataSize = gzipData ? numTiles * 4 : 0;
 		} 
-		else 
-		{
-			out = (unsigned *)malloc(text.size());
-		
-			// Copy every gid into the temporary array since
-			// the decoded string is an array of 32-bit integers.
-			memcpy(out, text.c_str(), text.size());
-		}
 
 		// Convert the gids to map tiles.
-		for (int x = 0; x < GetWidth(); x++)
+		const TilesetTable tilesets(GetMap());
+		const size_t tileCount = dataSize / 4 < numTiles ? dataSize / 4 : numTiles;
+		for (size_t i = 0; i < tileCount; ++i)
 		{
-			for (int y = 0; y < GetHeight(); y++)
-			{
-				unsigned gid = out[y * GetWidth() + x];
-
-				// Find the tileset index.
-				const int tilesetIndex = GetMap()->FindTilesetIndex(gid);
-				if (tilesetIndex != -1)
-				{
-					// If valid, set up the map tile with the tileset.
-					const Tmx::Tileset* tileset = GetMap()->GetTileset(tilesetIndex);
-					tile_map[y * GetWidth() + x] = MapTile(gid, tileset->GetFirstGid(), tilesetIndex);
-				}
-				else
-				{
-					// Otherwise, make it null.
-					tile_map[y * GetWidth() + x] = MapTile(gid, 0, (unsigned int)-1);
-				}
-			}
+			const unsigned char *bytes = data + i * 4;
+			const unsigned gid = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned)bytes[3] << 24);
+			tile_map[i] = tilesets.GetTile(gid);
 		}
 
-		// Free the temporary array from memory.
-		free(out);
-	}
-
-	inline char* strdup(const char* s)
-	{
-#if defined(WIN32)
-		return _strdup(s);
-#else
-		return ::strdup(s);
-#endif
+		// Free the decompressed data from memory.
+		free(gzipData);
 	}
 
 	void TileLayer::ParseCSV(const std::string &innerText) 
 	{
-		// Duplicate the string for use with C stdio.
-		char *csv = strdup(innerText.c_str());
-		
-		// Iterate through every token of ';' in the CSV string.
-		char *pch = strtok(csv, ",");
+		const TilesetTable tilesets(GetMap());
+		const size_t numTiles = GetWidth() * GetHeight();
 		size_t tileCount = 0;
-		
-		while (pch) 
-		{
-			unsigned gid;
-			sscanf(pch, "%u", &gid);
 
-			// Find the tileset index.
-			const int tilesetIndex = GetMap()->FindTilesetIndex(gid);
-			if (tilesetIndex != -1)
-			{
-				// If valid, set up the map tile with the tileset.
-				const Tmx::Tileset* tileset = GetMap()->GetTileset(tilesetIndex);
-				tile_map[tileCount] = MapTile(gid, tileset->GetFirstGid(), tilesetIndex);
-			}
-			else
+		// Parse the numbers separated by ',' straight from the string.
+		const char *pch = innerText.c_str();
+		while (*pch && tileCount < numTiles) 
+		{
+			char *end = 0;
+			const unsigned gid = (unsigned)strtoul(pch, &end, 10);
+			if (end == pch)
 			{
-				// Otherwise, make it null.
-				tile_map[tileCount] = MapTile(gid, 0, (unsigned int)-1);
+				// Skip separators and whitespace.
+				++pch;
+				continue;
 			}
 
-			pch = strtok(NULL, ",");
+			tile_map[tileCount] = tilesets.GetTile(gid);
 			tileCount++;
+			pch = end;
 		}
-
-		free(csv);
 	}
 };
@@ -29,7 +29,7 @@
 
 #include <string>
 #include <vector>
-#include <tmx-parser\TmxLayer.h>
+#include <tmx-parser/TmxLayer.h>
 
 class TiXmlNode;
 
@@ -0,0 +1,236 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef ASSET_LOADER_H_
+#define ASSET_LOADER_H_
+
+#include <Object.h>
+#include <Ref.h>
+#include <Texture.h>
+#include <Thread.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace yam2d
+{
+
+class AssetLoader;
+class AssetLoaderThread;
+struct AssetJob;
+
+/**
+ * Class for AssetHandle.
+ *
+ * Handle to asset requested from AssetLoader. Handle is loading until the asset has been decoded on
+ * a loader thread and uploaded in AssetLoader::update on the main thread. Handle of map prefetch is
+ * ready, when the map and all of its tileset textures are ready.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class AssetHandle : public Object
+{
+public:
+	enum State
+	{
+		STATE_LOADING = 0,
+		STATE_READY,
+		STATE_FAILED,
+		STATE_CANCELLED
+	};
+
+	virtual ~AssetHandle();
+
+	/** Returns state of the asset itself, not including dependencies. */
+	State getState() const { return m_state; }
+
+	/** Returns true, if the asset and all of its dependencies are ready. */
+	bool isReady() const;
+
+	/** Returns true, if the asset and all of its dependencies are no longer loading (ready, failed or cancelled). */
+	bool isDone() const;
+
+	const std::string& getFileName() const { return m_fileName; }
+
+	int getPriority() const { return m_priority; }
+
+	/** Returns loaded texture or 0, if the asset is not a texture or it is not ready. */
+	Texture* getTexture() const { return m_texture.ptr(); }
+
+	/** Returns dependencies of the asset, for example tileset textures of prefetched map. */
+	int getNumDependencies() const { return (int)m_dependencies.size(); }
+	AssetHandle* getDependency(int index) const { return m_dependencies[index].ptr(); }
+
+	/** 
+	 * Cancels loading of the asset and its dependencies. Assets which are already ready are not affected. 
+	 * Decoding, which is already running on a loader thread, is finished but the result is thrown away.
+	 * Texture handles are shared by all requests of the same texture, so cancel withdraws only one request, and 
+	 * loading is cancelled when all requests of the texture have been cancelled. Call cancel once per request.
+	 */
+	void cancel();
+
+private:
+	friend class AssetLoader;
+
+	AssetHandle(AssetLoader* loader, const std::string& fileName, int priority);
+
+	AssetLoader*					m_loader;
+	AssetJob*						m_job;
+	State							m_state;
+	std::string						m_fileName;
+	int								m_priority;
+	int								m_numRequests;	// Requests, which have not cancelled.
+	bool							m_dependenciesCancelled;
+	Ref<Texture>					m_texture;
+	std::vector< Ref<AssetHandle> >	m_dependencies;
+
+	// Hidden
+	AssetHandle(const AssetHandle&);
+	AssetHandle& operator=(const AssetHandle&);
+};
+
+
+/**
+ * Class for AssetLoader.
+ *
+ * Loads assets asynchronously. Files are read and decoded on a pool of loader threads. Decoded assets are
+ * uploaded to GL on the main thread in update, which processes completed assets until given time budget
+ * per frame is used, so that loading does not cause hitches. Requests are processed in priority order 
+ * (higher first) and can be cancelled through the returned handle.
+ *
+ * Loaded textures are cached by file name, format, dither and transparent color, so requesting the same texture
+ * again returns the same handle (with priority raised, if the new request has higher priority). The same file
+ * requested with other options is loaded as another texture. Use release or clearCache to drop cached textures.
+ *
+ * Typical usage is to prefetch tilesets of the next area with prefetchMapTilesets and later load the map with
+ * TmxMap, which has this loader set with TmxMap::setAssetLoader.
+ *
+ * All methods must be called from the main (GL) thread.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class AssetLoader : public Object
+{
+public:
+	enum Priority
+	{
+		PRIORITY_PREFETCH = 0,
+		PRIORITY_NORMAL = 100,
+		PRIORITY_HIGHEST = 10000
+	};
+
+	/** 
+	 * Creates new asset loader and starts the loader threads. If numThreads is 0 or less, number of processors 
+	 * minus one (at least one) threads are created.
+	 */
+	AssetLoader(int numThreads = 0);
+
+	/** Stops and joins the loader threads. Handles which are still loading are cancelled. */
+	virtual ~AssetLoader();
+
+	/**
+	 * Requests PNG texture to be loaded.
+	 * @param fileName			Texture file name.
+	 * @param priority			Priority of the request. Higher priority requests are processed first.
+	 * @param format			GPU format of the texture (see Texture::setFormat).
+	 * @param dither			Dither texture when converting to reduced precision format.
+	 * @param transparentColor	Color, which is made transparent, as hex string ("ff00ff") or empty.
+	 */
+	AssetHandle* loadTexture(const std::string& fileName, int priority = PRIORITY_NORMAL, Texture::Format format = Texture::FORMAT_DEFAULT, 
+		bool dither = false, const std::string& transparentColor = "");
+
+	/**
+	 * Requests tileset textures of TMX map to be loaded. The map file is parsed on a loader thread and each 
+	 * tileset texture is requested with the same priority, format and transparent color as TmxMap::loadMapFile uses.
+	 */
+	AssetHandle* prefetchMapTilesets(const std::string& mapFileName, int priority = PRIORITY_PREFETCH);
+
+	/** 
+	 * Uploads decoded assets until maxMilliseconds has been spent. At least one asset is uploaded, if any is 
+	 * waiting. Returns number of processed assets.
+	 */
+	int update(float maxMilliseconds);
+
+	/** Finishes loading of the asset and its dependencies immediately, blocking the calling thread if needed. */
+	void finish(AssetHandle* handle);
+
+	/** Removes cached textures of given file name. Textures stay alive as long as they are referenced. */
+	void release(const std::string& fileName);
+
+	/** Removes all cached textures. */
+	void clearCache();
+
+	/** Returns number of requests, which are queued or being decoded. */
+	int getNumPending() const;
+
+	/** Returns number of decoded requests waiting for update. */
+	int getNumDecoded() const;
+
+	int getNumThreads() const { return (int)m_threads.size(); }
+
+private:
+	friend class AssetHandle;
+	friend class AssetLoaderThread;
+
+	/** Cache key of texture. */
+	struct TextureKey
+	{
+		std::string		fileName;
+		int				format;
+		bool			dither;
+		int				transparentColor; // RGB, or -1 for none.
+
+		bool operator<(const TextureKey& other) const;
+	};
+
+	typedef std::map< TextureKey, Ref<AssetHandle> > TextureCache;
+
+	void enqueue(AssetJob* job);
+	void cancel(AssetHandle* handle);
+	void runWorker();
+	void complete(AssetJob* job);
+	bool removeFromQueue(AssetJob* job);
+	void removeFromCache(AssetHandle* handle);
+
+	static void decode(AssetJob* job);
+
+	mutable Mutex								m_mutex;
+	ConditionVariable							m_workAvailable;
+	ConditionVariable							m_jobDone;
+	bool										m_stopping;
+	unsigned									m_nextSequence;
+	int											m_numPending;
+	std::vector<AssetJob*>						m_queue;		// Heap of queued jobs, highest priority first.
+	std::vector<AssetJob*>						m_decoded;		// Jobs waiting for update.
+	std::vector< Ref<AssetLoaderThread> >		m_threads;
+	TextureCache								m_textures;
+
+	// Hidden
+	AssetLoader(const AssetLoader&);
+	AssetLoader& operator=(const AssetLoader&);
+};
+
+}
+
+#endif // ASSET_LOADER_H_
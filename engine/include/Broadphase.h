@@ -0,0 +1,152 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef BROADPHASE_H_
+#define BROADPHASE_H_
+
+#include <Object.h>
+#include <vec2.h>
+
+namespace yam2d
+{
+
+class GameObject;
+
+/**
+ * Class for Broadphase.
+ *
+ * Broadphase is spatial index of GameObject extents, which is used to find overlapping objects without
+ * testing every object against every other object. When GameObject is added to broadphase, its extents
+ * (getLeft, getTop, getRight, getBottom) are kept up to date automatically each time the object is 
+ * moved or resized. 
+ *
+ * Queries write results to caller provided buffers and do not allocate memory. Query methods return
+ * total number of found objects, which may be larger than size of the result buffer. Overlap test is 
+ * same as in GameObject::collidesTo: touching objects are overlapping. Queries do not modify broadphase, so 
+ * they can be made from several threads, as long as no thread adds, removes or moves game objects.
+ *
+ * Moving game objects from several threads is allowed only while updates are deferred (see setDeferUpdates): 
+ * moved game objects are only marked, and their proxies are moved by flushGameObject afterwards. UpdateScheduler 
+ * defers updates of the layer broadphase while ParallelUpdatable components are updated, so queries made by them
+ * see extents of game objects from before the parallel update.
+ *
+ * Layer owns broadphase of its game objects, see Layer::setBroadphase.
+ *
+ * @see SpatialHashGrid, DynamicAabbTree
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class Broadphase : public Object
+{
+public:
+	/** Interface for receiving overlapping pairs from findOverlappingPairs. */
+	class PairCallback
+	{
+	public:
+		virtual ~PairCallback() {}
+		virtual void onOverlap(GameObject* a, GameObject* b) = 0;
+	};
+
+	Broadphase();
+
+	virtual ~Broadphase();
+
+	/** Adds game object to this broadphase. Game object can be in one broadphase at a time. */
+	void addGameObject(GameObject* gameObject);
+
+	/** Removes game object from this broadphase. */
+	void removeGameObject(GameObject* gameObject);
+
+	/** Removes all game objects from this broadphase. */
+	virtual void clear() = 0;
+
+	/** Returns number of game objects in this broadphase. */
+	int getNumGameObjects() const { return m_numGameObjects; }
+
+	/** 
+	 * Finds game objects overlapping with given area. At most maxResults objects are written to results. 
+	 * Returns total number of overlapping objects.
+	 */
+	virtual int queryAabb(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const = 0;
+
+	/** Finds game objects containing given point (see GameObject::isInside). Returns total number of found objects. */
+	int queryPoint(const vec2& position, GameObject** results, int maxResults) const
+	{
+		return queryAabb(position, position, results, maxResults);
+	}
+
+	/** Calls callback once for each pair of overlapping game objects. Objects must not be added, removed or moved during the call. */
+	virtual void findOverlappingPairs(PairCallback* callback) const = 0;
+
+	/** Called by GameObject, when its extents has changed. Typically this method is not needed to be called by game developer. */
+	void updateGameObject(GameObject* gameObject);
+
+	/** 
+	 * Sets, if updateGameObject only marks game object moved instead of moving its proxy. Each game object moved 
+	 * while updates are deferred must be passed to flushGameObject before updates are undeferred.
+	 */
+	void setDeferUpdates(bool deferUpdates) { m_deferUpdates = deferUpdates; }
+
+	bool getDeferUpdates() const { return m_deferUpdates; }
+
+	/** Moves proxy of game object, if the game object was moved while updates were deferred. */
+	void flushGameObject(GameObject* gameObject);
+
+protected:
+	/** Returns id for new proxy of game object with given extents. */
+	virtual int createProxy(GameObject* gameObject, const vec2& topLeft, const vec2& bottomRight) = 0;
+	virtual void destroyProxy(int proxyId) = 0;
+	virtual void moveProxy(int proxyId, const vec2& topLeft, const vec2& bottomRight) = 0;
+
+	/** Detaches game object from this broadphase without calling destroyProxy. Used by clear. */
+	void detachGameObject(GameObject* gameObject);
+
+	/** Changes proxy id of game object. Used by broadphases, which move proxies when other proxies are destroyed. */
+	static void setProxyId(GameObject* gameObject, int proxyId);
+
+	static bool overlaps(const vec2& topLeftA, const vec2& bottomRightA, const vec2& topLeftB, const vec2& bottomRightB)
+	{
+		return topLeftA.x <= bottomRightB.x && topLeftB.x <= bottomRightA.x 
+			&& topLeftA.y <= bottomRightB.y && topLeftB.y <= bottomRightA.y;
+	}
+
+	static void addResult(GameObject* gameObject, GameObject** results, int maxResults, int& numResults)
+	{
+		if( numResults < maxResults )
+		{
+			results[numResults] = gameObject;
+		}
+		++numResults;
+	}
+
+private:
+	int								m_numGameObjects;
+	bool							m_deferUpdates;
+
+	// Hidden
+	Broadphase(const Broadphase&);
+	Broadphase& operator=(const Broadphase&);
+};
+
+}
+
+#endif // BROADPHASE_H_
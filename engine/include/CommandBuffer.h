@@ -0,0 +1,142 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef COMMAND_BUFFER_H_
+#define COMMAND_BUFFER_H_
+
+#include <Object.h>
+#include <Ref.h>
+#include <vector>
+
+namespace yam2d
+{
+
+class Map;
+class Layer;
+class Entity;
+class Component;
+class GameObject;
+
+/**
+ * Class for CommandBuffer.
+ *
+ * CommandBuffer records structural changes of the map, like adding and deleting game objects, so that they can be
+ * made from components updated in parallel. Each thread records to a buffer of its own, see 
+ * UpdateScheduler::getCommandBuffer and Map::getCommandBuffer. Commands are applied at the end of Map::update.
+ *
+ * Each command gets sort key of the game object, which was being updated, when the command was recorded. 
+ * Commands of all buffers are applied ordered by sort key and then by recording order, so the result does not 
+ * depend on which threads updated which game objects.
+ *
+ * Reference counts and default properties of engine objects are not thread safe, so commands do not reference
+ * existing objects, and new game objects and components must not be created in parallel update. Record a Function
+ * instead, which creates them when commands are applied.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class CommandBuffer : public Object
+{
+public:
+	/**
+	 * Interface for functions called when commands are applied.
+	 */
+	class Function : public Object
+	{
+	public:
+		virtual ~Function() {}
+
+		/** Called from the thread, which updates the map, in order of commands. */
+		virtual void execute(Map* map) = 0;
+	};
+
+	/** Sort key of commands recorded outside of scheduled updates. They are applied last. */
+	static const unsigned UNSCHEDULED = 0xffffffff;
+
+	CommandBuffer();
+
+	virtual ~CommandBuffer();
+
+	/** Adds game object to layer. */
+	void addGameObject(Layer* layer, GameObject* gameObject);
+
+	/** Deletes game object from its layer. Deleted game objects are removed after other commands have been applied. */
+	void deleteGameObject(GameObject* gameObject);
+
+	/** Moves game object from its current layer to given layer. */
+	void moveGameObject(GameObject* gameObject, Layer* layer);
+
+	/** Adds component to entity. */
+	void addComponent(Entity* entity, Component* component);
+
+	/** Calls function, when commands are applied. */
+	void addFunction(Function* function);
+
+	bool isEmpty() const { return m_commands.empty(); }
+
+	int getNumCommands() const { return (int)m_commands.size(); }
+
+	/** Sets sort key for following commands. Called by UpdateScheduler before updating each game object. */
+	void setSortKey(unsigned sortKey) { m_sortKey = sortKey; }
+
+	/** Applies commands of given buffers to map in order of sort keys and clears the buffers. */
+	static void apply(Map* map, const std::vector< Ref<CommandBuffer> >& buffers);
+
+private:
+	enum CommandType
+	{
+		ADD_GAME_OBJECT,
+		DELETE_GAME_OBJECT,
+		MOVE_GAME_OBJECT,
+		ADD_COMPONENT,
+		CALL_FUNCTION
+	};
+
+	struct Command
+	{
+		CommandType			type;
+		unsigned			sortKey;
+		unsigned			sequence;
+		Entity*				entity;
+		Layer*				layer;
+		Ref<Component>		component; // Added component or game object. Referenced only by recording thread.
+		Ref<Function>		function;
+	};
+
+	struct CommandOrder
+	{
+		bool operator()(const Command* a, const Command* b) const
+		{
+			return a->sortKey != b->sortKey ? a->sortKey < b->sortKey : a->sequence < b->sequence;
+		}
+	};
+
+	void push(CommandType type, Entity* entity, Component* component, Layer* layer, Function* function);
+	static void execute(Map* map, Command& command);
+
+	std::vector<Command>	m_commands;
+	unsigned				m_sortKey;
+};
+
+}
+
+#endif // COMMAND_BUFFER_H_
@@ -0,0 +1,75 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef DYNAMIC_AABB_TREE_H_
+#define DYNAMIC_AABB_TREE_H_
+
+#include <Broadphase.h>
+#include <Box2D/Collision/b2DynamicTree.h>
+#include <vector>
+
+namespace yam2d
+{
+
+/**
+ * Class for DynamicAabbTree.
+ *
+ * Broadphase, which stores game objects to bounding volume hierarchy (Box2D b2DynamicTree). Tree nodes have
+ * slightly enlarged ("fat") extents, so small movements of objects do not change the tree. Unlike 
+ * SpatialHashGrid, tree does not need any tuning for object sizes, so it suits well for layers having both 
+ * small and large objects, or objects clustered to small areas. Actual extents of proxies are stored next to the 
+ * tree, so queries do not read game objects, which may be moved by other threads while updates are deferred.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class DynamicAabbTree : public Broadphase
+{
+public:
+	DynamicAabbTree();
+
+	virtual ~DynamicAabbTree();
+
+	virtual void clear();
+	virtual int queryAabb(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const;
+	virtual void findOverlappingPairs(PairCallback* callback) const;
+
+protected:
+	virtual int createProxy(GameObject* gameObject, const vec2& topLeft, const vec2& bottomRight);
+	virtual void destroyProxy(int proxyId);
+	virtual void moveProxy(int proxyId, const vec2& topLeft, const vec2& bottomRight);
+
+private:
+	b2DynamicTree*						m_tree;
+	std::vector<int>					m_proxyIds;		// Ids of all proxies in the tree.
+	std::vector<int>					m_proxyIndices;	// Index in m_proxyIds by proxy id.
+	std::vector<vec2>					m_topLefts;		// Actual extents by proxy id.
+	std::vector<vec2>					m_bottomRights;
+
+	// Hidden
+	DynamicAabbTree(const DynamicAabbTree&);
+	DynamicAabbTree& operator=(const DynamicAabbTree&);
+};
+
+}
+
+#endif // DYNAMIC_AABB_TREE_H_
@@ -37,7 +37,8 @@ namespace yam2d
  * how much time has been elapsed since last reset call.
  *
  * Elapsed timer uses Windows GetTime function for internal operation, so the resolution
- * of the timer is not best possible.
+ * of the timer is not best possible. On Linux monotonic clock_gettime clock with nanosecond
+ * resolution is used.
  *
  * @ingroup yam2d
  * @author Mikko Romppainen (mikko@kajakbros.com)
@@ -63,6 +64,8 @@ public:
 private:
 #if defined(_WIN32)
 	typedef __int64 YAM_TIME_TYPE;
+#elif defined(YAM2D_LINUX)
+	typedef long long YAM_TIME_TYPE;
 #else
 	typedef long YAM_TIME_TYPE;
 #endif
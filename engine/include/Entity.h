@@ -102,6 +102,8 @@ namespace yam2d
 	class Component : public yam2d::Object
 	{
 	public:
+		YAM2D_MEMORY_SUBSYSTEM(yam2d::MemoryStats::COMPONENTS)
+
 		Component(Entity* owner, const yam2d::PropertySet& properties);
 
 		virtual ~Component();
@@ -154,6 +156,8 @@ namespace yam2d
 	class Entity : public Component
 	{
 	public:
+		YAM2D_MEMORY_SUBSYSTEM(yam2d::MemoryStats::ENTITIES)
+
 		Entity(Entity* parent, ComponentFactory* componentFactory, const yam2d::PropertySet& properties);
 
 		virtual ~Entity();
@@ -261,6 +265,21 @@ namespace yam2d
 			return res;
 		}
 
+		/// Same as above, but writes components to given vector, so that it can be reused without allocations.
+		template<class Type>
+		void getComponentsOfInterface(std::vector<Type*>& result)
+		{
+			result.clear();
+			for (size_t i = 0; i < m_components.data().size(); ++i)
+			{
+				Type* component = dynamic_cast<Type*>(m_components.data()[i].ptr());
+				if (component != 0)
+				{
+					result.push_back(component);
+				}
+			}
+		}
+
 		virtual bool isModified() const;
 
 		void addChild(Entity* child);
@@ -0,0 +1,104 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef EXTENTS_BUFFER_H_
+#define EXTENTS_BUFFER_H_
+
+#include <Broadphase.h>
+#include <vector>
+#include <stdint.h>
+
+namespace yam2d
+{
+
+/**
+ * Class for ExtentsBuffer.
+ *
+ * Broadphase, which stores extents of game objects to structure of arrays (left, top, right and bottom values 
+ * in separate arrays). One box, or a small set of boxes, can be tested against all extents at once. Tests use
+ * SSE on x86 and NEON on ARM when the compiler has enabled them, otherwise plain C++ code.
+ *
+ * Extents are kept up to date automatically like in other broadphases, so after adding ExtentsBuffer to a layer,
+ * moving game objects only writes their new extents to the buffer. Removing game object moves last extents to 
+ * its place, so indices of extents may change, when objects are removed.
+ *
+ * ExtentsBuffer is fast for testing few boxes (for example bullets) against large group of objects. For many
+ * queries against big worlds, SpatialHashGrid is usually better.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class ExtentsBuffer : public Broadphase
+{
+public:
+	ExtentsBuffer();
+
+	virtual ~ExtentsBuffer();
+
+	/** Returns number of extents. Extents at index i belongs to getGameObject(i). */
+	int getNumExtents() const { return (int)m_gameObjects.size(); }
+
+	/** Returns number of 32 bit words needed for hit mask of one box. */
+	int getNumMaskWords() const { return (getNumExtents() + 31) / 32; }
+
+	/** Returns game object of extents at given index. */
+	GameObject* getGameObject(int index) const { return m_gameObjects[index]; }
+
+	/**
+	 * Tests given box against all extents. Bit (i%32) of hitMasks[i/32] is set, if extents i overlaps with the box.
+	 * hitMasks must have getNumMaskWords() words. If collisionNormalLikeOverlaps is given, it must have 
+	 * getNumExtents() elements, and value for each hit is written to it like in GameObject::collidesTo,
+	 * when box is the colliding object. Values of other elements are not changed. Returns number of hits.
+	 */
+	int testOverlap(const vec2& topLeft, const vec2& bottomRight, uint32_t* hitMasks, vec2* collisionNormalLikeOverlaps = 0) const;
+
+	/**
+	 * Tests several boxes against all extents. hitMasks must have getNumMaskWords() words for each box and 
+	 * masks are written one box after another. Extents are read once for every 8 boxes. Returns total number
+	 * of hits.
+	 */
+	int testOverlaps(const vec2* topLefts, const vec2* bottomRights, int numBoxes, uint32_t* hitMasks) const;
+
+	virtual void clear();
+	virtual int queryAabb(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const;
+	virtual void findOverlappingPairs(PairCallback* callback) const;
+
+protected:
+	virtual int createProxy(GameObject* gameObject, const vec2& topLeft, const vec2& bottomRight);
+	virtual void destroyProxy(int proxyId);
+	virtual void moveProxy(int proxyId, const vec2& topLeft, const vec2& bottomRight);
+
+private:
+	std::vector<float>					m_left;
+	std::vector<float>					m_top;
+	std::vector<float>					m_right;
+	std::vector<float>					m_bottom;
+	std::vector<GameObject*>			m_gameObjects;
+
+	// Hidden
+	ExtentsBuffer(const ExtentsBuffer&);
+	ExtentsBuffer& operator=(const ExtentsBuffer&);
+};
+
+}
+
+#endif // EXTENTS_BUFFER_H_
@@ -75,7 +75,7 @@ public:
 	
 
 private:
-#if defined(_WIN32)
+#if defined(_WIN32) || defined(YAM2D_LINUX)
 	typedef FILE* FileHandleType;
 #elif defined(ANDROID)
 	typedef AAsset* FileHandleType;
@@ -0,0 +1,171 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef FLOW_FIELD_H_
+#define FLOW_FIELD_H_
+
+#include <Object.h>
+#include <Ref.h>
+#include <TileGrid.h>
+#include <vec2.h>
+#include <vector>
+#include <stdint.h>
+
+namespace yam2d
+{
+
+/**
+ * Class for FlowField.
+ *
+ * FlowField guides any number of agents to the same target set. Integration field stores cost of the shortest 
+ * path from each cell to the nearest target, and direction field stores direction of the first step of that path,
+ * so agents steer with single lookup per frame instead of searching paths of their own. Solid cells of the 
+ * TileGrid are blocked. Moves and costs are the same as in Pathfinder: 8 directions without cutting corners, 
+ * straight moves cost 1 and diagonal moves sqrt(2).
+ *
+ * Fields are built in update with a time budget, so build of a large map is spread over several frames. Fields 
+ * are double buffered: while targets have moved or tiles have changed and new fields are being built, agents 
+ * keep steering with the previous fields. Moving targets inside the same cells does not cause rebuild.
+ *
+ * Use FlowFieldCache for sharing one flow field between all agents, which have the same target.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class FlowField : public Object, public TileGrid::ChangeListener
+{
+public:
+	FlowField(TileGrid* tileGrid);
+
+	virtual ~FlowField();
+
+	TileGrid* getTileGrid() const { return m_tileGrid.ptr(); }
+
+	/** Sets single target (in map coordinates). */
+	void setTarget(const vec2& target);
+
+	/** Sets target set. Agents are guided to the nearest target. Solid targets and targets outside of the grid are ignored. */
+	void setTargets(const vec2* targets, int numTargets);
+
+	const std::vector<vec2>& getTargets() const { return m_targets; }
+
+	/**
+	 * Continues building fields until maxMilliseconds has been spent. New fields are taken in use, when the 
+	 * build completes. Returns true, if fields are up to date.
+	 */
+	bool update(float maxMilliseconds);
+
+	/** Builds fields immediately. */
+	void build();
+
+	/** Returns true, if fields have been built at least once, so directions are available. */
+	bool isReady() const { return m_isReady; }
+
+	/** Returns true, if fields have been built with current targets and tiles. */
+	bool isUpToDate() const { return m_isReady && !m_needsBuild && !m_isBuilding; }
+
+	/** 
+	 * Returns unit direction of the first step of the shortest path from given position (in map coordinates)
+	 * to the nearest target. Returns zero vector in target cells and cells, from where targets can not be reached.
+	 */
+	vec2 getDirection(const vec2& position) const;
+
+	/** Returns cost of the shortest path from cell of given position to the nearest target, or -1 if unreachable. */
+	float getDistance(const vec2& position) const;
+
+	/** Returns milliseconds spent building the current fields, summed over all updates of the build. */
+	float getBuildTime() const { return m_buildTime; }
+
+	/** Returns number of completed builds. */
+	int getNumBuilds() const { return m_numBuilds; }
+
+	/** Called by TileGrid, when cell changes. */
+	virtual void onCellChanged(int x, int y, bool solid);
+
+private:
+	struct OpenNode
+	{
+		float		cost;
+		int			cell;
+	};
+
+	int getCell(const vec2& position) const;
+	void beginBuild();
+	bool continueBuild(float maxMilliseconds);
+
+	Ref<TileGrid>				m_tileGrid;
+	int							m_width;
+	int							m_height;
+	std::vector<vec2>			m_targets;
+	std::vector<int>			m_targetCells;
+
+	// Fields in use and fields being built. Directions are indices to direction table, NO_DIRECTION if none.
+	std::vector<float>			m_distances;
+	std::vector<uint8_t>		m_directions;
+	std::vector<float>			m_buildDistances;
+	std::vector<uint8_t>		m_buildDirections;
+	std::vector<OpenNode>		m_open;
+
+	bool						m_isReady;
+	bool						m_needsBuild;
+	bool						m_isBuilding;
+	float						m_buildTime;
+	float						m_pendingBuildTime;
+	int							m_numBuilds;
+};
+
+
+/**
+ * Class for FlowFieldCache.
+ *
+ * FlowFieldCache shares flow fields between agents: all agents asking flow field to the same target cell get 
+ * the same FlowField. Agents hold the returned field with Ref, and the cache releases fields, which are no longer
+ * referenced by anyone else. Fields are updated in update with a shared time budget.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class FlowFieldCache : public Object
+{
+public:
+	FlowFieldCache(TileGrid* tileGrid);
+
+	virtual ~FlowFieldCache();
+
+	/** Returns flow field to given target (in map coordinates), creating it if it does not exist. */
+	FlowField* getFlowField(const vec2& target);
+
+	/** Releases unused fields and updates others until maxMilliseconds has been spent. */
+	void update(float maxMilliseconds);
+
+	int getNumFlowFields() const { return (int)m_flowFields.size(); }
+
+private:
+	Ref<TileGrid>					m_tileGrid;
+	std::vector< Ref<FlowField> >	m_flowFields;
+	size_t							m_nextUpdate;
+};
+
+
+}
+
+#endif // FLOW_FIELD_H_
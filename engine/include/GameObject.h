@@ -32,6 +32,7 @@ namespace yam2d
 {
 
 class Layer;
+class Broadphase;
 
 /**
  * Class for GameObject. Game objects
@@ -80,11 +81,33 @@ public:
 
 	void setTileSize(const vec2& tileSize );
 
+	/** Returns broadphase, where this game object is, or 0. */
+	Broadphase* getBroadphase() const { return m_broadphase; }
+
+	/** Returns rendering order of this game object inside its layer. Objects with bigger value are rendered on top. */
+	int getLayerOrder() const { return m_layerOrder; }
+
+	/** 
+	 * Stores current position and rotation as start point of render interpolation. Map::update calls this for game
+	 * objects of dynamic layers before updating them. Call this also after moving game object to a new place, so 
+	 * that the jump is not interpolated.
+	 */
+	void storePreviousTransform();
+
+	/** Returns position between the stored and the current position. Alpha 0 gives the stored and 1 the current position. */
+	vec2 getInterpolatedPosition(float alpha) const;
+
+	/** Returns rotation between the stored and the current rotation, turning the shorter way. */
+	float getInterpolatedRotation(float alpha) const;
+
 	//void setOffset( const vec2& offset ) { m_offset = offset; recalcExtens(); }
 	//const vec2& getOffset() const { return m_offset; }
 protected:
 
 private:
+	friend class Broadphase;
+	friend class Layer;
+	friend class UpdateScheduler;
 	void recalcExtens();
 
 	GameObject();
@@ -97,9 +120,17 @@ private:
 	vec2			m_topLeft;
 	vec2			m_bottomRight;
 	float			m_rotation;
+	vec2			m_previousPosition; // Transform before the last update, for render interpolation.
+	float			m_previousRotation;
 	vec2			m_size;
 	vec2			m_tileScale;
 //	int				m_type;
+	Broadphase*		m_broadphase;
+	int				m_broadphaseProxy;
+	bool			m_broadphaseMoved; // Moved while updates of broadphase were deferred.
+	int				m_layerOrder;
+	float			m_delayedUpdateTime; // Time since previous update of LodUpdatable components.
+	unsigned		m_lodPhase; // Turn of LodUpdatable components in their band, 0 until first scheduled.
 };
 
 class Updatable
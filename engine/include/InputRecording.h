@@ -0,0 +1,158 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef INPUT_RECORDING_H_
+#define INPUT_RECORDING_H_
+
+#include <Object.h>
+#include <Input.h>
+#include <stdio.h>
+#include <vector>
+
+namespace yam2d
+{
+
+/**
+ * Input state of one frame, as seen by the functions of Input.h, and frame time given to esRunUpdates.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+struct InputFrame
+{
+	/** Number of key codes, whose state is recorded. */
+	static const int NUM_KEYS = 0xff;
+
+	/** Number of mouse buttons, whose state is recorded. */
+	static const int NUM_MOUSE_BUTTONS = 3;
+
+	InputFrame();
+
+	/** Sets frame to current state of the functions of Input.h. */
+	void capture(float frameTime);
+
+	bool isKeyDown(int keyCode) const { return (keys[keyCode >> 3] & (1 << (keyCode & 7))) != 0; }
+
+	void setKeyDown(int keyCode, bool down);
+
+	float				deltaTime;
+	unsigned char		keys[(NUM_KEYS + 7) / 8];
+	bool				mouseButtons[NUM_MOUSE_BUTTONS];
+	int					mouseX;
+	int					mouseY;
+	int					mouseWheelDelta;
+	std::vector<Touch>	touches;
+};
+
+
+/**
+ * Class for InputRecorder.
+ *
+ * Writes input frames to a compact binary file. Frame stores only the state, which changed since the previous 
+ * frame, so a frame without input changes takes one byte, or five, if frame time changed. Frame time is stored
+ * exactly, so that replay updates with the same time steps as the recorded session.
+ *
+ * Use esStartInputRecording for recording frames of esMainLoop. Recording is read with InputPlayback, and can be 
+ * replayed with linuxSetInputReplay on headless Linux platform.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class InputRecorder : public Object
+{
+public:
+	InputRecorder();
+	virtual ~InputRecorder();
+
+	/** Creates file and writes header. Returns false, if file could not be created. */
+	bool open(const char* fileName);
+
+	void close();
+
+	bool isOpen() const { return m_file != 0; }
+
+	/** Captures current input state with given frame time and writes it. */
+	void recordFrame(float deltaTime);
+
+	void writeFrame(const InputFrame& frame);
+
+	int getNumFrames() const { return m_numFrames; }
+
+	int getNumBytes() const { return m_numBytes; }
+
+private:
+	FILE*		m_file;
+	InputFrame	m_frame;
+	InputFrame	m_previousFrame;
+	int			m_numFrames;
+	int			m_numBytes;
+
+	void writeByte(int value);
+	void writeUnsigned(unsigned value);
+	void writeSigned(int value);
+
+	InputRecorder(const InputRecorder&);
+	InputRecorder& operator=(const InputRecorder&);
+};
+
+
+/**
+ * Class for InputPlayback. Reads frames written with InputRecorder.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class InputPlayback : public Object
+{
+public:
+	InputPlayback();
+	virtual ~InputPlayback();
+
+	/** Opens recording and reads header. Returns false, if file could not be opened or is not an input recording. */
+	bool open(const char* fileName);
+
+	void close();
+
+	bool isOpen() const { return m_file != 0; }
+
+	/** Reads next frame. Returns false at the end of recording, or if the file is corrupted. */
+	bool readFrame(InputFrame& frame);
+
+	/** Returns number of frames read. */
+	int getNumFrames() const { return m_numFrames; }
+
+private:
+	FILE*		m_file;
+	InputFrame	m_previousFrame;
+	int			m_numFrames;
+
+	bool readByte(int& value);
+	bool readUnsigned(unsigned& value);
+	bool readSigned(int& value);
+
+	InputPlayback(const InputPlayback&);
+	InputPlayback& operator=(const InputPlayback&);
+};
+
+}
+
+#endif // INPUT_RECORDING_H_
@@ -0,0 +1,190 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef JOB_SYSTEM_H_
+#define JOB_SYSTEM_H_
+
+#include <Object.h>
+#include <Ref.h>
+#include <Thread.h>
+#include <vector>
+#include <deque>
+
+namespace yam2d
+{
+
+class JobSystem;
+class JobCounter;
+
+/**
+ * Class for Job.
+ *
+ * Derive from Job and implement execute. Jobs are owned by the caller and must stay alive until they have 
+ * finished, which is known by waiting the JobCounter given to JobSystem::run. Job can be run again after it has 
+ * finished.
+ *
+ * Jobs form task graphs with addDependency: job is not started before all jobs it depends on have finished. 
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class Job
+{
+public:
+	Job();
+	virtual ~Job();
+
+	/** Does the work. Called from any thread of the job system. */
+	virtual void execute() = 0;
+
+	/** 
+	 * Makes this job wait until given job has finished. Must be called before either of the jobs has been given to
+	 * JobSystem::run (asserted), because dependency lists are not synchronized. Dependencies are removed when the 
+	 * job, which was waited, finishes.
+	 */
+	void addDependency(Job* job);
+
+private:
+	friend class JobSystem;
+
+	AtomicInt			m_numPending;	// Unfinished dependencies plus one until run has been called.
+	std::vector<Job*>	m_dependents;
+	JobCounter*			m_counter;
+	bool				m_submitted;	// From run until the job has finished.
+
+	Job(const Job&);
+	Job& operator=(const Job&);
+};
+
+
+/**
+ * Class for JobCounter. Counts unfinished jobs, which were given to JobSystem::run with this counter.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class JobCounter
+{
+public:
+	JobCounter() : m_count(0) {}
+
+	/** Returns true, if all jobs of this counter have finished. */
+	bool isDone() const { return m_count.get() == 0; }
+
+private:
+	friend class JobSystem;
+	AtomicInt m_count;
+
+	JobCounter(const JobCounter&);
+	JobCounter& operator=(const JobCounter&);
+};
+
+
+/**
+ * Class for JobSystem.
+ *
+ * JobSystem runs jobs with a fixed pool of worker threads. Each worker has a deque of its own: jobs run from a 
+ * worker go to its deque and the worker takes newest jobs first, while idle workers steal oldest jobs from the 
+ * others. Jobs run from other threads go to a shared deque. Workers without jobs sleep.
+ *
+ * Thread, which waits a counter, executes jobs while waiting, so jobs may wait other jobs and job system 
+ * without worker threads runs jobs in the waiting thread. When there are no queued jobs, waiting thread sleeps 
+ * like workers until a job is queued or the counter is done.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class JobSystem : public Object
+{
+public:
+	/**
+	 * Interface for parallelFor function.
+	 */
+	class RangeFunction
+	{
+	public:
+		virtual ~RangeFunction() {}
+
+		/** Processes items from begin to end, excluding end. Called from several threads at the same time. */
+		virtual void execute(int begin, int end) = 0;
+	};
+
+	/** 
+	 * Creates job system with given number of worker threads. Negative value creates one worker less than there 
+	 * are processors, because the thread, which waits jobs, runs them too.
+	 */
+	explicit JobSystem(int numWorkers = -1);
+
+	/** Stops worker threads. All jobs must have finished. */
+	virtual ~JobSystem();
+
+	int getNumWorkers() const { return (int)m_workers.size(); }
+
+	/** Returns index of calling thread: 1 to getNumWorkers() for worker threads of this job system, otherwise 0. */
+	int getCurrentThreadIndex() const;
+
+	/** 
+	 * Starts job. Job is queued, when all jobs it depends on have finished. If counter is given, it is incremented 
+	 * until the job has finished.
+	 */
+	void run(Job* job, JobCounter* counter = 0);
+
+	/** Executes jobs until all jobs of the counter have finished. Sleeps, while remaining jobs run in other threads. */
+	void wait(JobCounter* counter);
+
+	/**
+	 * Calls function for items from begin to end in ranges of at most grainSize items, in parallel, and returns 
+	 * when all items have been processed. Ranges are taken in order from shared counter, so threads, which finish 
+	 * early, take more ranges.
+	 */
+	void parallelFor(int begin, int end, int grainSize, RangeFunction* function);
+
+private:
+	class Worker;
+	friend class Worker;
+
+	struct Queue
+	{
+		Mutex				mutex;
+		std::deque<Job*>	jobs;
+	};
+
+	void push(Job* job);
+	Job* pop(int queueIndex);
+	void execute(Job* job);
+	void workerLoop(int queueIndex);
+
+	std::vector< Ref<Worker> >	m_workers;
+	std::vector<Queue*>			m_queues;	// Queue 0 is for threads, which are not workers.
+	AtomicInt					m_numQueued;
+	AtomicInt					m_numSleeping;
+	Mutex						m_sleepMutex;
+	ConditionVariable			m_wakeUp;
+	bool						m_quit;
+
+	JobSystem(const JobSystem&);
+	JobSystem& operator=(const JobSystem&);
+};
+
+}
+
+#endif // JOB_SYSTEM_H_
@@ -29,6 +29,7 @@
 #include "SpriteBatch.h"
 #include <Ref.h>
 #include <Entity.h>
+#include <Broadphase.h>
 
 namespace yam2d
 {
@@ -55,11 +56,13 @@ public:
 	 * @param opacity			Opacity of this layer, which is used in rendering.
 	 * @param visible			Is this map visible on screen.
 	 * @param isStaticLayer		Is this static layer. Static layer is layer, which is batched only once. Static layers are faster, but there is limitation, that objects can not be moved afterwards.
-	 * @param properties		Properties of this layer.
+	 * @param properties		Properties of this layer. Property "broadphase" with value "grid", "tree" or "extents" 
+	 *							creates broadphase for the layer (see setBroadphase). Cell size of grid is read from  
+	 *							property "broadphaseCellSize" (in tiles).
 	 */
 	Layer(Map* map, std::string name, float opacity, bool visible, bool isStaticLayer, const PropertySet& properties=PropertySet() );
 	
-	virtual ~Layer() {}
+	virtual ~Layer();
 
 	/** Adds given GameObject to this layer. */
 	void addGameObject(GameObject* gameObject);
@@ -69,12 +72,21 @@ public:
 	
 	void deleteGameObjectIfExist(GameObject* gameObject);
 
+	/** 
+	 * Removes given GameObjects from this layer immediately. Unlike deleteGameObject, this can be used also for static 
+	 * layers, but must not be called during layer update. Typically this method is not needed to be called by game developer.
+	 */
+	void removeGameObjects(const std::vector<GameObject*>& gameObjects);
+
 	/** Returns all GameObjects from this Layer. */
 	GameObjectList& getGameObjects();
 		
 	/** Returns batch of this Layer. */
 	SpriteBatchGroup* getBatch();
 
+	/** Replaces batch of this Layer. Used by Map, when render snapshot references the previous batch. Typically this method is not needed to be called by game developer. */
+	void setBatch(SpriteBatchGroup* batch);
+
 	/** Sets depth value to be used for this layer, when rendering. Typically this method is not needed to be called by game developer. */
 	void setDepth(float depth);
 	
@@ -117,8 +129,48 @@ public:
 	void disableUpdate() { m_isUpdatable = false; }
 	int getLayerIndex() const { return m_layerNumber; }
 
+	/** Returns topmost game object of this layer containing given position (in tiles), or 0 if there is none. */
 	GameObject* pick(const vec2& pos) const;
 
+	/**
+	 * Finds game objects of this layer containing given position (in tiles). Found objects are written to results
+	 * in z-order, topmost (last rendered) object first. At most maxResults objects are written. Returns total 
+	 * number of found objects. Uses broadphase of the layer, if set.
+	 */
+	int pick(const vec2& pos, GameObject** results, int maxResults) const;
+
+	/** Finds game objects of this layer overlapping given rectangle (in tiles). Results are ordered like in pick. */
+	int pickRect(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const;
+
+	/** 
+	 * Finds game objects of this layer overlapping given convex polygon (in tiles). Used for example for selecting
+	 * with screen rectangle on isometric maps. Results are ordered like in pick.
+	 */
+	int pickPolygon(const vec2* points, int numPoints, GameObject** results, int maxResults) const;
+
+	/** 
+	 * Sets broadphase to be used for collision queries of this layer. Game objects of this layer are added to the 
+	 * broadphase and are kept there until they are removed from the layer. Set 0 to remove broadphase.
+	 * Layers do not have broadphase by default. Typically SpatialHashGrid or DynamicAabbTree is used. ExtentsBuffer
+	 * keeps extents of the layer objects in arrays for batch overlap tests.
+	 */
+	void setBroadphase(Broadphase* broadphase);
+
+	/** Returns broadphase of this layer or 0. */
+	Broadphase* getBroadphase() const { return m_broadphase.ptr(); }
+
+	/**
+	 * Finds game objects of this layer overlapping with given area (in tiles). At most maxResults objects are
+	 * written to results. Returns total number of overlapping objects. Without broadphase, each object is tested.
+	 */
+	int queryAabb(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const;
+
+	/** Finds game objects of this layer containing given position. Returns total number of found objects. */
+	int queryPoint(const vec2& position, GameObject** results, int maxResults) const;
+
+	/** Calls callback once for each pair of overlapping game objects in this layer. */
+	void findOverlappingPairs(Broadphase::PairCallback* callback) const;
+
 	void reserve(size_t s) { m_gameObjects.reserve(s);  }
 private:
 	//Map*							m_map;
@@ -132,6 +184,11 @@ private:
 	bool m_isUpdatable;
 	int m_layerNumber;
 	GameObjectList					m_objectsToDelete;
+	Ref<Broadphase>					m_broadphase;
+	int								m_nextLayerOrder;
+	mutable std::vector<GameObject*>	m_pickBuffer;
+
+	int pickSorted(const vec2& topLeft, const vec2& bottomRight, const vec2* points, int numPoints, GameObject** results, int maxResults) const;
 
 	// Hidden
 	Layer();
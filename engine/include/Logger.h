@@ -0,0 +1,188 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+#include <config.h>
+#include <Thread.h>
+#include <stdarg.h>
+
+namespace yam2d
+{
+
+/**
+ * State of one log call site for rate limiting. YAM2D_LOG macros declare one for each call site.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+struct LogSite
+{
+	AtomicInt	second;
+	AtomicInt	numInSecond;
+	AtomicInt	numSuppressed;
+};
+
+
+/**
+ * Class for Logger.
+ *
+ * Logger writes log records to a lock-free ring buffer, from where a background thread writes them to the platform 
+ * log and to the file set with YAM_WRITING_LOGS_TO_FILE. When arguments of the format string are plain numbers, 
+ * pointers or short strings, they are copied to the record as is and the message is formatted in the background 
+ * thread. Other messages are formatted, when they are written. 
+ *
+ * Log with YAM2D_LOG_DEBUG, YAM2D_LOG_INFO, YAM2D_LOG_WARNING and YAM2D_LOG_ERROR macros. Levels below 
+ * YAM2D_LOG_MIN_LEVEL in config.h are removed from the build, and runtime level and categories are checked before 
+ * arguments are evaluated. Each call site logs at most getRateLimit messages per second, and number of suppressed 
+ * messages is reported with the next message of the site. 
+ *
+ * Errors are written before the logging call returns, after messages logged before them. If the ring buffer is full, 
+ * other messages are dropped, and number of dropped messages is logged, when there is room again. The background 
+ * thread sleeps, until a message is written. 
+ *
+ * esLogMessage, esLogEngineError and esLogEngineDebug log through Logger without a call site, so they are never rate 
+ * limited. They are meant for reports, like Profiler and RenderStats summaries, whose lines must not be suppressed,
+ * and for errors, which throw. Engine diagnostics use the macros.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class Logger
+{
+public:
+	enum Level
+	{
+		LEVEL_DEBUG,
+		LEVEL_INFO,
+		LEVEL_WARNING,
+		LEVEL_ERROR,
+		NUM_LEVELS
+	};
+
+	enum Category
+	{
+		CATEGORY_GENERAL,
+		CATEGORY_ENGINE,
+		CATEGORY_RENDER,
+		CATEGORY_ASSETS,
+		CATEGORY_PHYSICS,
+		CATEGORY_NETWORK,
+		CATEGORY_GAME,
+		NUM_CATEGORIES
+	};
+
+	/** Number of records in the ring buffer. Must be power of two. */
+	static const int BUFFER_SIZE = 1024;
+
+	/** Size of record data. Messages, whose arguments do not fit, are formatted when written. */
+	static const int RECORD_DATA_SIZE = 232;
+
+	static const char* getLevelName(Level level);
+
+	static const char* getCategoryName(Category category);
+
+	/** Sets lowest level, which is logged. Default is LEVEL_DEBUG, so only YAM2D_LOG_MIN_LEVEL removes messages. */
+	static void setLevel(Level level) { s_level = level; }
+
+	static Level getLevel() { return Level(s_level); }
+
+	/** Enables or disables logging of given category. All categories are enabled by default. */
+	static void setCategoryEnabled(Category category, bool enabled);
+
+	static bool isCategoryEnabled(Category category) { return (s_categoryMask & (1 << category)) != 0; }
+
+	/** Returns true, if message of given level and category is logged. */
+	static bool isEnabled(Level level, Category category) { return level >= s_level && isCategoryEnabled(category); }
+
+	/** Sets maximum number of messages per second from one call site. 0 disables rate limiting. Default is 20. */
+	static void setRateLimit(int messagesPerSecond) { s_rateLimit = messagesPerSecond; }
+
+	static int getRateLimit() { return s_rateLimit; }
+
+	/** Returns true, if call site may log now. Called by YAM2D_LOG macros. */
+	static bool allow(LogSite& site);
+
+	/** Writes message to the ring buffer. Site can be 0. Format must stay alive, so it should be a string literal. */
+	static void write(LogSite* site, Level level, Category category, const char* format, ...);
+
+	static void writeV(LogSite* site, Level level, Category category, const char* format, va_list args);
+
+	/** Writes messages in the ring buffer to the log from calling thread. Returns number of messages written. */
+	static int flush();
+
+	/** 
+	 * Stops background thread and writes remaining messages. Messages logged after this are written by the logging 
+	 * thread. Called at exit.
+	 */
+	static void shutdown();
+
+	/** Returns number of messages dropped, because the ring buffer was full. */
+	static int getNumDropped();
+
+private:
+	static volatile int s_level;
+	static volatile int s_categoryMask;
+	static volatile int s_rateLimit;
+};
+
+}
+
+#define YAM2D_LOG_CONCAT_IMPL(a, b) a##b
+#define YAM2D_LOG_CONCAT(a, b) YAM2D_LOG_CONCAT_IMPL(a, b)
+
+/** Logs printf style message with given level and category, if level and category are enabled and site is not rate limited. */
+#define YAM2D_LOG(level, category, ...) \
+	do \
+	{ \
+		if( yam2d::Logger::isEnabled(level, category) ) \
+		{ \
+			static yam2d::LogSite YAM2D_LOG_CONCAT(logSite, __LINE__); \
+			if( yam2d::Logger::allow(YAM2D_LOG_CONCAT(logSite, __LINE__)) ) \
+			{ \
+				yam2d::Logger::write(&YAM2D_LOG_CONCAT(logSite, __LINE__), level, category, __VA_ARGS__); \
+			} \
+		} \
+	} while(false)
+
+#if YAM2D_LOG_MIN_LEVEL <= 0
+#define YAM2D_LOG_DEBUG(category, ...) YAM2D_LOG(yam2d::Logger::LEVEL_DEBUG, category, __VA_ARGS__)
+#else
+#define YAM2D_LOG_DEBUG(category, ...) do {} while(false)
+#endif
+
+#if YAM2D_LOG_MIN_LEVEL <= 1
+#define YAM2D_LOG_INFO(category, ...) YAM2D_LOG(yam2d::Logger::LEVEL_INFO, category, __VA_ARGS__)
+#else
+#define YAM2D_LOG_INFO(category, ...) do {} while(false)
+#endif
+
+#if YAM2D_LOG_MIN_LEVEL <= 2
+#define YAM2D_LOG_WARNING(category, ...) YAM2D_LOG(yam2d::Logger::LEVEL_WARNING, category, __VA_ARGS__)
+#else
+#define YAM2D_LOG_WARNING(category, ...) do {} while(false)
+#endif
+
+#define YAM2D_LOG_ERROR(category, ...) YAM2D_LOG(yam2d::Logger::LEVEL_ERROR, category, __VA_ARGS__)
+
+#endif // LOGGER_H_
@@ -31,6 +31,9 @@
 #include <Ref.h>
 
 #include <Entity.h>
+#include <TileGrid.h>
+#include <UpdateScheduler.h>
+#include <RenderSnapshot.h>
 
 namespace Tmx
 {
@@ -45,7 +48,10 @@ class Tileset;
 class Layer;
 class Tile;
 class GameObject;
+class Updatable;
 class SpriteSheet;
+class AssetLoader;
+class TmxReader;
 
 class DefaultComponentFactory : public ComponentFactory
 {
@@ -132,12 +138,19 @@ public:
 	virtual ~Map();
 
 	/**
-	 * Renders all visible map layers to the screen.
+	 * Renders all visible map layers to the screen. If render snapshot buffer has been set, draws the latest 
+	 * published snapshot instead.
 	 */
 	void render();
 
 	/**
 	 * Updates all map layers and objects inside layer. Typically this is called once in a frame, before rendering.
+	 * Updatable components of the map itself, like PhysicsWorld, are updated first. Note that earlier versions 
+	 * did not update components of the map, so a map component, which is updated by the application, must not 
+	 * implement Updatable anymore or it is updated twice per frame.
+	 * If update scheduler has been set, it updates the game objects and its command buffers are applied after 
+	 * all layers have been updated. Transforms of game objects in dynamic layers are stored first, for render 
+	 * interpolation (see setInterpolationAlpha). If render snapshot buffer has been set, render snapshot is published last.
 	 *
 	 * @param deltaTime		Time since last update call, in seconds.
 	 */
@@ -204,9 +217,84 @@ public:
 	void deleteGameObject(GameObject* gameObject);
 
 	GameObject* findGameObjectByName(const std::string& name);
+
+	/** 
+	 * Sets tile grid used for collision queries against level geometry. TmxMap creates tile grid on load, if tilesets
+	 * have tiles with property "solid" set to true. Set 0 to remove tile grid.
+	 */
+	void setTileGrid(TileGrid* tileGrid);
+
+	/** Returns tile grid of this map, or 0 if map does not have solid tiles. */
+	TileGrid* getTileGrid() const { return m_tileGrid.ptr(); }
+
+	/** 
+	 * Sets update scheduler, which updates LodUpdatable components of far away game objects less often. Set 0 to
+	 * update all game objects every frame, which is the default.
+	 */
+	void setUpdateScheduler(UpdateScheduler* updateScheduler);
+
+	/** Returns update scheduler of this map, or 0. */
+	UpdateScheduler* getUpdateScheduler() const { return m_updateScheduler.ptr(); }
+
+	/** 
+	 * Returns command buffer of calling thread for recording structural changes, which are applied at the end of 
+	 * update. Returns 0, if update scheduler has not been set.
+	 */
+	CommandBuffer* getCommandBuffer() { return m_updateScheduler != 0 ? m_updateScheduler->getCommandBuffer() : 0; }
+
+	/**
+	 * Sets buffer for rendering from another thread than update. When set, update publishes snapshot of visible 
+	 * layers to the buffer at the end of each update, and render draws the latest published snapshot without 
+	 * accessing the map, so render can be called from render thread while update runs on its own thread. 
+	 * Set 0 to render the map directly, which is the default. Must not be changed while threads are running.
+	 */
+	void setRenderSnapshotBuffer(RenderSnapshotBuffer* renderSnapshotBuffer);
+
+	/** Returns render snapshot buffer of this map, or 0. */
+	RenderSnapshotBuffer* getRenderSnapshotBuffer() const { return m_renderSnapshotBuffer.ptr(); }
+
+	/**
+	 * Sets fraction of fixed time step elapsed since the last update, typically esGetInterpolationAlpha, before
+	 * render. Game objects of dynamic layers are then rendered between their transforms before and after the last
+	 * update, so movement is smooth although the frame rate differs from the update rate. Default is 1, which 
+	 * renders the current transforms. Not used, when render snapshot buffer has been set.
+	 */
+	void setInterpolationAlpha(float alpha) { m_interpolationAlpha = alpha; }
+
+	/** Returns fraction of fixed time step used for rendering game objects of dynamic layers. */
+	float getInterpolationAlpha() const { return m_interpolationAlpha; }
+
+	/**
+	 * Finds game objects containing given position (in map coordinates) from all visible layers. Found objects are
+	 * written to results in z-order, topmost object first. At most maxResults objects are written. Returns total
+	 * number of found objects. Layers with broadphase are queried through it.
+	 */
+	int pick(const vec2& mapPosition, GameObject** results, int maxResults);
+
+	/** Returns topmost game object containing given position (in map coordinates), or 0 if there is none. */
+	GameObject* pick(const vec2& mapPosition);
+
+	/** Finds game objects overlapping given rectangle (in map coordinates). Results are ordered like in pick. */
+	int pickRect(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults);
+
+	/** Same as pick, but position is given in screen coordinates and converted using screenToMapCoordinates. */
+	int pickScreen(const vec2& screenPosition, GameObject** results, int maxResults);
+
+	/** 
+	 * Finds game objects overlapping given screen rectangle, for example for box selection. On isometric maps the
+	 * rectangle is not axis aligned in map coordinates, so objects are tested against the converted corners. 
+	 * Results are ordered like in pick.
+	 */
+	int pickScreenRect(const vec2& screenTopLeft, const vec2& screenBottomRight, GameObject** results, int maxResults);
+
+protected:
+	/** Forces static layers to be batched again on next render call. Needed if objects of static layers are added or removed after first render. */
+	void invalidateStaticBatches() { m_needsBatching = true; }
+
 private:
 	bool isVisible(GameObject* go,Camera* cam);
 	void batchLayer(Layer* layer, bool cullInvisibleObjects);
+	void captureRenderSnapshot(RenderSnapshot* snapshot);
 
 	Ref<Camera>					m_mainCamera;
 protected:	
@@ -220,6 +308,11 @@ private:
 	LayerMap					m_layers;
 	PropertySet					m_properties;
 	bool						m_needsBatching;
+	Ref<TileGrid>				m_tileGrid;
+	Ref<UpdateScheduler>		m_updateScheduler;
+	Ref<RenderSnapshotBuffer>	m_renderSnapshotBuffer;
+	std::vector<Updatable*>		m_updatableComponents; // Reused by update, so that it does not allocate each frame.
+	float						m_interpolationAlpha;
 		
 	// Hidden
 	Map();
@@ -255,7 +348,7 @@ public:
 
 	virtual ~TmxMap();
 
-	/** Loads map file */
+	/** Loads map file. The file is read with streaming TmxReader, so each layer is created as soon as it has been read. */
 	bool loadMapFile(const std::string& mapFileName, ComponentFactory* componentFactory);
 
 	/** Returns map width in tiles. */
@@ -293,8 +386,43 @@ public:
 	//void registerMapCreateCallbacks(MapCreateCallbacks* callbacks);
 
 	const std::string& getLoadedMapFileName() const { return m_loadedMapFileName; }
+
+	/** 
+	 * Sets asset loader used for tileset textures. When set, loadMapFile uses textures already prefetched with
+	 * AssetLoader::prefetchMapTilesets and finishes loading of the rest immediately. Set to 0 to load textures
+	 * synchronously (default).
+	 */
+	void setAssetLoader(AssetLoader* assetLoader) { m_assetLoader = assetLoader; }
+
+	/** Returns number of tilesets. */
+	int getNumTilesets() const { return (int)m_tilesets.size(); }
+
+	/** Returns tileset by index. */
+	Tileset* getTileset(int index) const { return m_tilesets[index].ptr(); }
+
 protected:
-/*	/** Can be overwritten in derived class for create custom Tilesets. */
+	/** 
+	 * Called during loadMapFile for each non-empty tile of tile layers. Default implementation creates 
+	 * the tile game object immediately using createTileGameObject. Can be overridden in derived class
+	 * for example to defer creation of the tile.
+	 */
+	virtual void onTileLoaded(ComponentFactory* componentFactory, int layerIndex, int x, int y, int tilesetIndex, unsigned id, bool flippedHorizontally, bool flippedVertically, bool flippedDiagonally);
+
+	/** 
+	 * Called during loadMapFile for each object of object layers. Properties contains all object properties in 
+	 * yam2d coordinates. tilesetIndex is -1 for objects without tile. Default implementation creates the game 
+	 * object immediately using createObjectGameObject.
+	 */
+	virtual void onObjectLoaded(ComponentFactory* componentFactory, int layerIndex, const PropertySet& properties, int tilesetIndex);
+
+	/** Creates tile game object and adds it to given layer. Returns created game object or 0, if factory did not create it. */
+	GameObject* createTileGameObject(ComponentFactory* componentFactory, int layerIndex, int x, int y, int tilesetIndex, unsigned id, bool flippedHorizontally, bool flippedVertically, bool flippedDiagonally);
+
+	/** Creates game object from object properties and adds it to given layer. Returns created game object or 0, if factory did not create it. */
+	GameObject* createObjectGameObject(ComponentFactory* componentFactory, int layerIndex, const PropertySet& properties, int tilesetIndex);
+
+
+	/** Can be overwritten in derived class for create custom Tilesets. */
 //	static Tileset* createNewTileset(void* userData, const std::string& name, SpriteSheet* spriteSheet, float tileOffsetX, float tileOffsetY, const PropertySet& properties );
 
 	/** Can be overwritten in derived class for create custom Layers. */
@@ -304,6 +432,10 @@ protected:
 //	static Tile* createNewTile(void* userData, Map* map, Layer* layer, const vec2& position, Tileset* tileset, unsigned id, bool flippedHorizontally, bool flippedVertically, bool flippedDiagonally, const PropertySet& properties);
 
 private:
+	bool createTileset(const TmxReader& reader, const std::string& path);
+	void setSolidTile(int x, int y);
+	void loadObject(ComponentFactory* componentFactory, int layerIndex, const TmxReader& reader);
+
 	float						m_width;
 	float						m_height;
 	//void*						m_userData;
@@ -312,7 +444,11 @@ private:
 	//CreateNewTileFuncType		m_createNewTile;
 	//CreateNewGameObjectFuncType m_createNewGameObject;
 	std::vector< Ref<Tileset> > m_tilesets;
+	std::vector< vec2 >			m_tilesetTileSizes; // Tile size of each tileset in map tiles.
+	std::vector< std::map<unsigned, PropertySet> > m_tileProperties; // Properties of tileset tiles, which has properties.
+	std::vector< std::vector<bool> > m_solidTiles; // Tiles of each tileset, which has property "solid" set to true.
 	std::string					m_loadedMapFileName;
+	AssetLoader*				m_assetLoader;
 	// Hidden
 	TmxMap(const TmxMap&);
 	TmxMap& operator=(const TmxMap&);
@@ -323,4 +459,4 @@ private:
 }
 
 
-#endif
\ No newline at end of file
+#endif
@@ -1,17 +1,28 @@
 #ifndef MAP_CONTROLLER_H_
 #define MAP_CONTROLLER_H_
 
+#include <vec2.h>
+
 namespace yam2d
 {
 	class Layer;
 	class GameObject;
 	class Camera;
+	class Map;
+	class RenderSnapshot;
 
 	void renderCamera(Camera* camera, Layer* layer);
 
+	/** Sets projection and view of camera at given device position. Does not access any objects, so can be called from render thread. */
+	void renderCamera(int screenWidth, int screenHeight, float desiredAspectRatio, float screenUnitSize, const vec2& devicePosition);
+
+	/** Sets size of camera in tiles according to its screen unit size. */
+	void updateCameraSize(Camera* camera, Map* map);
+
 	void updateLayer(Layer* layer, float deltaTime);
 
-	void renderLayerObject(GameObject* gameObject, Layer* layer);
+	/** Adds sprites and texts of game object to render snapshot, if given, otherwise to batch of the layer. */
+	void renderLayerObject(GameObject* gameObject, Layer* layer, RenderSnapshot* snapshot = 0);
 
 }
 
@@ -0,0 +1,154 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef MEMORY_STATS_H_
+#define MEMORY_STATS_H_
+
+#include <string>
+#include <vector>
+
+namespace yam2d
+{
+
+/**
+ * Class for MemoryStats.
+ *
+ * MemoryStats accounts memory by subsystem. Buffers, which are not Objects, such as texture memory and vertex 
+ * arrays of sprite batches, are added with addBytes. Counters are atomic, so memory can be accounted on any thread.
+ *
+ * Each Object is counted to a subsystem, which is OTHER_OBJECTS unless the class sets another one with 
+ * Object::setMemorySubsystem. Objects allocated with new add their size to the subsystem given to operator new, see
+ * YAM2D_MEMORY_SUBSYSTEM in Object.h. Objects, which are members of other objects, are counted with zero bytes. 
+ * Other heap memory of objects, such as contents of their vectors and strings, is not accounted.
+ *
+ * With MEMORY_TRACKING defined in config.h, live Objects are kept in an intrusive list, so snapshots contain counts 
+ * and bytes of each type too.
+ *
+ * Snapshots of counters can be taken with takeSnapshot and compared with diff.
+ *
+ * High-water marks of subsystems are reset by beginLevelLoad. endLevelLoad stores difference of the load, which 
+ * can be read with getLastLevelLoad, and logs it, if enabled with setLevelLoadLogging. TmxMap::loadMapFile 
+ * reports its loads, use LevelLoadScope for other loading code.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class MemoryStats
+{
+public:
+	enum Subsystem
+	{
+		OTHER_OBJECTS,
+		TEXTURES,
+		VERTEX_BUFFERS,
+		PROPERTY_SETS,
+		COMPONENTS,
+		ENTITIES,
+		NUM_SUBSYSTEMS
+	};
+
+	/** Counts of subsystem. In difference of snapshots, numObjects and numBytes are changes. */
+	struct SubsystemStats
+	{
+		int		numObjects;
+		int		numBytes;
+		int		highWaterBytes;
+	};
+
+	struct TypeStats
+	{
+		std::string	name;
+		int			numObjects;
+		int			numBytes;
+	};
+
+	struct Snapshot
+	{
+		SubsystemStats			subsystems[NUM_SUBSYSTEMS];
+		int						totalBytes;
+		int						totalHighWaterBytes;
+
+		/** Types in decreasing order of bytes. Empty, if MEMORY_TRACKING is not defined. */
+		std::vector<TypeStats>	types;
+	};
+
+	/** Class for LevelLoadScope. Reports level load from construction to destruction. */
+	class LevelLoadScope
+	{
+	public:
+		explicit LevelLoadScope(const std::string& name) { beginLevelLoad(name); }
+		~LevelLoadScope() { endLevelLoad(); }
+
+	private:
+		LevelLoadScope(const LevelLoadScope&);
+		LevelLoadScope& operator=(const LevelLoadScope&);
+	};
+
+	static const char* getSubsystemName(Subsystem subsystem);
+
+	/** Adds bytes of buffer, which is not an Object, to subsystem. Use negative numBytes, when buffer is freed. */
+	static void addBytes(Subsystem subsystem, int numBytes);
+
+	/** 
+	 * Adds change from accountedBytes to numBytes to subsystem and sets accountedBytes to numBytes. Used for 
+	 * buffers, which grow, with accountedBytes kept as a member of the owner.
+	 */
+	static void updateBytes(Subsystem subsystem, int& accountedBytes, int numBytes);
+
+	/** Returns current bytes of subsystem. */
+	static int getBytes(Subsystem subsystem);
+
+	/** Returns current bytes of all subsystems. */
+	static int getTotalBytes();
+
+	/** Takes snapshot of current counters. */
+	static void takeSnapshot(Snapshot& snapshot);
+
+	/** Sets difference to changes from before to after. High-water marks are the ones of after. */
+	static void diff(const Snapshot& before, const Snapshot& after, Snapshot& difference);
+
+	/** Logs snapshot or difference of snapshots with esLogMessage. Types are logged up to maxTypes. */
+	static void logSnapshot(const Snapshot& snapshot, const char* title, int maxTypes = 20);
+
+	/** 
+	 * Starts level load: resets high-water marks to current bytes. Loads can be nested, only the outermost one is
+	 * reported.
+	 */
+	static void beginLevelLoad(const std::string& name);
+
+	/** Ends level load and stores difference and high-water marks of subsystems during the load. */
+	static void endLevelLoad();
+
+	/** Sets, if endLevelLoad logs the load with logSnapshot. Disabled by default. */
+	static void setLevelLoadLogging(bool enabled);
+
+	/** Sets difference to the last ended level load and returns its name. Name is empty, if no load has ended. */
+	static std::string getLastLevelLoad(Snapshot& difference);
+
+	/** Called by Object. */
+	static void addObject(Subsystem subsystem);
+	static void removeObject(Subsystem subsystem);
+};
+
+}
+
+#endif // MEMORY_STATS_H_
@@ -214,7 +214,7 @@ namespace yam2d {
                 bool parsing = true;
                 while (parsing) {
 
-                    if (Peek(json) == -1) {
+                    if (Peek(json) == std::string::npos) {
                         parsing = false;
                         break;
                     }
@@ -225,7 +225,7 @@ namespace yam2d {
                         parsing = false;
                         break;
                     case '\\':
-                        if (Peek(json) == -1) {
+                        if (Peek(json) == std::string::npos) {
                             parsing = false;
                             break;
                         }
@@ -25,6 +25,10 @@
 
 
 #include <es_assert.h>
+#include <config.h>
+#include <MemoryStats.h>
+#include <stddef.h>
+#include <vector>
 
 namespace yam2d
 {
@@ -34,7 +38,8 @@ namespace yam2d
  *
  * Object class provides functionality for internal object reference
  * counting. Refecence counting can be done using addRef and releaseRef
- * methods.
+ * methods. Objects are counted to subsystems of MemoryStats, and Objects 
+ * allocated with new add their size to it.
  * 
  * @ingroup yam2d
  * @author Mikko Romppainen (mikko@kajakbros.com)
@@ -81,9 +86,44 @@ public:
 		return m_numOfRefs;
 	}
 
+	/** Allocates object and adds its size to OTHER_OBJECTS. Classes can select another subsystem with YAM2D_MEMORY_SUBSYSTEM. */
+	static void* operator new(size_t size) { return allocate(size, MemoryStats::OTHER_OBJECTS); }
+
+	static void operator delete(void* ptr, size_t size) { deallocate(ptr, size, MemoryStats::OTHER_OBJECTS); }
+
+	/** Allocates memory for object of given size and adds the size to subsystem. Called by operator new. */
+	static void* allocate(size_t size, MemoryStats::Subsystem subsystem);
+
+	/** Frees memory allocated with allocate. Size must be the one given to allocate. Called by operator delete. */
+	static void deallocate(void* ptr, size_t size, MemoryStats::Subsystem subsystem);
+
+	/** Returns subsystem, to which the object is counted. */
+	MemoryStats::Subsystem getMemorySubsystem() const { return MemoryStats::Subsystem(m_memorySubsystem); }
+
+	/** 
+	 * Sets live objects by type in decreasing order of bytes. Types are empty, if MEMORY_TRACKING is not defined.
+	 * Objects, which are being constructed or destroyed, are counted with the type of their base class.
+	 */
+	static void getLiveObjectTypes(std::vector<MemoryStats::TypeStats>& types);
+
+protected:
+	/** 
+	 * Moves count of the object to given memory subsystem. Called by constructors of derived classes, which also 
+	 * declare operator new with YAM2D_MEMORY_SUBSYSTEM for the same subsystem.
+	 */
+	void setMemorySubsystem(MemoryStats::Subsystem subsystem);
+
 private:
 	// Member variables
-	int m_numOfRefs;
+	// Reference count and memory subsystem share one int, so that the subsystem does not make derived classes bigger.
+	int m_numOfRefs : 28;
+	int m_memorySubsystem : 4;
+
+#if defined(MEMORY_TRACKING)
+	// Intrusive list of live objects, so that objects are removed in constant time.
+	Object* m_previousObject;
+	Object* m_nextObject;
+#endif
 
 	// Non-allowed methods (declared but not defined anywhere, result link error if used)
 	Object( const Object& );
@@ -93,7 +133,13 @@ private:
 
 }
 
-
+/** 
+ * Declares operator new and delete, which add size of heap allocated objects of the class and its derived classes 
+ * to given MemoryStats subsystem. 
+ */
+#define YAM2D_MEMORY_SUBSYSTEM(subsystem) \
+	static void* operator new(size_t size) { return yam2d::Object::allocate(size, subsystem); } \
+	static void operator delete(void* ptr, size_t size) { yam2d::Object::deallocate(ptr, size, subsystem); }
 
 #endif // OBJECT_H_
 
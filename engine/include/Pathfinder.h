@@ -0,0 +1,265 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef PATHFINDER_H_
+#define PATHFINDER_H_
+
+#include <TileGrid.h>
+#include <Ref.h>
+#include <Thread.h>
+#include <vector>
+#include <deque>
+#include <map>
+
+namespace yam2d
+{
+
+class Pathfinder;
+class PathfinderThread;
+struct PathSearchContext;
+
+/**
+ * Class for PathRequest.
+ *
+ * Handle to path query requested from Pathfinder. Request is pending until the path has been searched in 
+ * Pathfinder::update or on a worker thread and the result has been delivered in Pathfinder::update.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class PathRequest : public Object
+{
+public:
+	enum State
+	{
+		STATE_PENDING = 0,
+		STATE_READY,
+		STATE_FAILED,
+		STATE_CANCELLED
+	};
+
+	virtual ~PathRequest();
+
+	State getState() const { return m_state; }
+
+	/** Returns true, if the request is no longer pending. */
+	bool isDone() const { return m_state != STATE_PENDING; }
+
+	const vec2& getStart() const { return m_start; }
+	const vec2& getGoal() const { return m_goal; }
+
+	/** Returns found path, if state is STATE_READY. See Pathfinder::findPath for format of the path. */
+	const std::vector<vec2>& getPath() const { return m_path; }
+
+	/** Cancels the request. Search, which is already running on worker thread, is finished but the result is thrown away. */
+	void cancel();
+
+private:
+	friend class Pathfinder;
+
+	PathRequest(Pathfinder* pathfinder, const vec2& start, const vec2& goal);
+
+	Pathfinder*				m_pathfinder;
+	State					m_state;
+	vec2					m_start;
+	vec2					m_goal;
+	std::vector<vec2>		m_path;
+	bool					m_found;		// Result of the search, written by the searching thread.
+	bool					m_cancelled;
+
+	// Hidden
+	PathRequest(const PathRequest&);
+	PathRequest& operator=(const PathRequest&);
+};
+
+
+/**
+ * Class for Pathfinder.
+ *
+ * Finds paths over TileGrid. Solid cells are blocked and other cells are walkable. Agents move to 8 directions,
+ * but not diagonally past corners of solid cells. Straight moves cost 1 and diagonal moves sqrt(2).
+ *
+ * Paths inside small area are searched with A* using jump point search, which gives shortest paths. Longer paths
+ * are searched hierarchically (HPA*): the grid is divided to clusters and cluster borders have entrances, between 
+ * which distances are precomputed. Path is first searched over the entrances and then refined to cells with jump
+ * point search inside each cluster. Hierarchical paths are usually at most few percent longer than shortest paths.
+ *
+ * Found paths are cached. Cached path is invalidated, when any cell in clusters along the path changes, and
+ * changed clusters are rebuilt when next needed, so changing tiles does not require rebuilding everything.
+ *
+ * Many paths can be requested with requestPath. Requests are searched in update until given time budget is used,
+ * or on worker threads, if the pathfinder has been created with worker threads. Search holds lock of the 
+ * pathfinder, so worker threads run searches one at a time, but in parallel with the main thread.
+ *
+ * TileGrid must be changed only on the main thread. 
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class Pathfinder : public Object, public TileGrid::ChangeListener
+{
+public:
+	/**
+	 * Creates new pathfinder for given tile grid.
+	 * @param tileGrid		Tile grid, where solid cells are blocked.
+	 * @param clusterSize	Size of hierarchical clusters in cells. If 0, all paths are searched with jump point search.
+	 * @param numThreads	Number of worker threads for requests. If 0, requests are searched in update.
+	 */
+	Pathfinder(TileGrid* tileGrid, int clusterSize = 16, int numThreads = 0);
+
+	/** Stops and joins worker threads. Pending requests are cancelled. */
+	virtual ~Pathfinder();
+
+	TileGrid* getTileGrid() const { return m_tileGrid.ptr(); }
+
+	int getClusterSize() const { return m_clusterSize; }
+
+	/**
+	 * Finds path from start to goal (in map coordinates) immediately. Path contains centers of cells, where path 
+	 * turns, from the first turn after start cell to goal cell. Moving straight between consecutive points never 
+	 * enters solid cells. Path is empty, if start and goal are in same cell. Returns false, if there is no path 
+	 * or start or goal is solid or outside of the grid.
+	 */
+	bool findPath(const vec2& start, const vec2& goal, std::vector<vec2>& path);
+
+	/** Requests path to be searched asynchronously. Result is available from the request after it is done. */
+	PathRequest* requestPath(const vec2& start, const vec2& goal);
+
+	/**
+	 * Searches queued requests until maxMilliseconds has been spent (when there are no worker threads) and 
+	 * delivers results of finished requests. At least one request is searched, if any is waiting. Returns 
+	 * number of completed requests.
+	 */
+	int update(float maxMilliseconds);
+
+	/** Returns number of requests, which are queued or being searched. */
+	int getNumPending() const;
+
+	/** Removes all cached paths. */
+	void clearCache();
+
+	/** Sets maximum number of cached paths. Default is 1024. 0 disables caching. */
+	void setMaxCachedPaths(int maxCachedPaths);
+
+	/** Returns number of findPath calls and requests, which were served from cache. */
+	int getNumCacheHits() const { return m_numCacheHits; }
+
+	/** Returns number of searches made. */
+	int getNumSearches() const { return m_numSearches; }
+
+	/** Called by TileGrid, when cell changes. */
+	virtual void onCellChanged(int x, int y, bool solid);
+
+private:
+	friend class PathRequest;
+	friend class PathfinderThread;
+
+	struct ClusterNode
+	{
+		int							cell;
+		int							partners[2];	// Entrance cells in neighbour clusters.
+		int							numPartners;
+	};
+
+	struct Cluster
+	{
+		int							x0;
+		int							y0;
+		int							x1;
+		int							y1;
+		std::vector<ClusterNode>	nodes;
+		std::vector<float>			costs;			// Costs between nodes inside the cluster, nodes.size() squared.
+		unsigned					version;		// Incremented, when any cell of the cluster changes.
+		bool						dirty;
+	};
+
+	struct CachedPath
+	{
+		std::vector<int>			cells;			// Turning cells after start.
+		std::vector<int>			clusters;		// Clusters, which path goes through,
+		std::vector<unsigned>		versions;		// and their versions, when the path was found.
+		unsigned					globalVersion;	// Version of whole grid, for failed searches.
+		bool						found;
+		unsigned					lastUse;
+	};
+
+	bool searchPath(PathSearchContext* context, int startCell, int goalCell, std::vector<int>& cells);
+	bool searchLocal(PathSearchContext* context, int x0, int y0, int x1, int y1, int startCell, int goalCell, std::vector<int>& cells);
+	bool searchHierarchical(PathSearchContext* context, int startCell, int goalCell, std::vector<int>& cells);
+	float computeCosts(PathSearchContext* context, const Cluster& cluster, int fromCell, float* costs, int targetCell = -1);
+	void rebuildDirtyClusters(PathSearchContext* context);
+	void rebuildCluster(PathSearchContext* context, int clusterIndex);
+	void addBorderEntrances(Cluster& cluster, int x, int y, int dx, int dy, int length, int otherDx, int otherDy);
+	int getClusterIndex(int cell) const;
+	int findNode(const Cluster& cluster, int cell) const;
+
+	bool isWalkable(int x, int y) const
+	{
+		return unsigned(x) < unsigned(m_width) && unsigned(y) < unsigned(m_height) && m_walkable[y*m_width + x] != 0;
+	}
+
+	bool findCachedPath(int startCell, int goalCell, bool& found, std::vector<int>& cells);
+	void addCachedPath(int startCell, int goalCell, bool found, const std::vector<int>& cells);
+	void toPositions(const std::vector<int>& cells, std::vector<vec2>& path) const;
+	bool getCells(const vec2& start, const vec2& goal, int& startCell, int& goalCell) const;
+	bool findPathCells(PathSearchContext* context, int startCell, int goalCell, std::vector<int>& cells);
+
+	void runWorker(PathSearchContext* context);
+	void cancel(PathRequest* request);
+
+	Ref<TileGrid>						m_tileGrid;
+	int									m_width;
+	int									m_height;
+	int									m_clusterSize;
+	int									m_numClustersX;
+	int									m_numClustersY;
+
+	// Guarded by m_mutex: walkability, clusters and cache.
+	mutable Mutex						m_mutex;
+	std::vector<uint8_t>				m_walkable;
+	std::vector<Cluster>				m_clusters;
+	bool								m_hasDirtyClusters;
+	unsigned							m_globalVersion;
+	std::map<unsigned long long, CachedPath>	m_cache;
+	int									m_maxCachedPaths;
+	unsigned							m_useCounter;
+	int									m_numCacheHits;
+	int									m_numSearches;
+	PathSearchContext*					m_mainContext;
+
+	// Guarded by m_queueMutex: requests.
+	mutable Mutex						m_queueMutex;
+	ConditionVariable					m_workAvailable;
+	bool								m_stopping;
+	std::deque< Ref<PathRequest> >		m_queue;
+	std::vector< Ref<PathRequest> >		m_finished;
+	int									m_numSearching;
+	std::vector< Ref<PathfinderThread> >	m_threads;
+
+	// Hidden
+	Pathfinder(const Pathfinder&);
+	Pathfinder& operator=(const Pathfinder&);
+};
+
+}
+
+#endif // PATHFINDER_H_
@@ -0,0 +1,100 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef PHYSICS_BODY_H_
+#define PHYSICS_BODY_H_
+
+#include <GameObject.h>
+#include <Ref.h>
+#include <Box2D/Box2D.h>
+
+namespace yam2d
+{
+
+class PhysicsWorld;
+
+/**
+ * Class for PhysicsBody.
+ *
+ * PhysicsBody connects game object to a Box2D body in PhysicsWorld. Position and rotation of dynamic and 
+ * kinematic bodies are copied to the game object by PhysicsWorld after each update. User data of the Box2D 
+ * body is the PhysicsBody, so game object of a fixture is found in contact listeners with 
+ * ((PhysicsBody*)fixture->GetBody()->GetUserData())->getGameObject().
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class PhysicsBody : public Component
+{
+public:
+	/** Creates dynamic body, which is moved by forces. Initial transform is taken from the game object. */
+	PhysicsBody(GameObject* owner, PhysicsWorld* world, float linearDamping, float angularDamping);
+
+	/** Creates static body at position of the game object. */
+	PhysicsBody(GameObject* owner, PhysicsWorld* world);
+
+	/** Destroys the Box2D body. */
+	virtual ~PhysicsBody();
+
+	/** Adds box fixture. Size is full size of the box. */
+	void setBoxFixture(const vec2& size, const vec2& center, float angle, bool isSensor, float density = 1.0f, float restitution = 1.0f, float friction = 0.9f);
+
+	/** Adds circle fixture. */
+	void setCircleFixture(float radius, bool isSensor, float density = 1.0f, float restitution = 1.0f, float friction = 0.9f);
+
+	b2Body* getBody() const { return m_body; }
+
+	PhysicsWorld* getWorld() const { return m_world.ptr(); }
+
+	/** Moves body and game object immediately, without interpolating from previous position. */
+	void setTransform(const vec2& position, float rotation);
+
+	/** Enables continuous collision against dynamic bodies, so fast body does not tunnel through them. Default is false. */
+	void setBullet(bool isBullet);
+
+	/** Sets, if body may fall asleep, when it has come to rest. Default is true. */
+	void setSleepingAllowed(bool isAllowed);
+
+	GameObject* getGameObject() { return (GameObject*)getOwner(); }
+	const GameObject* getGameObject() const { return (const GameObject*)getOwner(); }
+
+private:
+	friend class PhysicsWorld;
+
+	Ref<PhysicsWorld>	m_world;
+	b2Body*				m_body;
+
+	// Transform before latest step, for interpolating game object transform between steps.
+	vec2				m_previousPosition;
+	float				m_previousAngle;
+	bool				m_wasAwake;
+	int					m_index;			// Index in bodies of PhysicsWorld, or -1 for static bodies.
+
+	// Hidden
+	PhysicsBody();
+	PhysicsBody(const PhysicsBody&);
+	PhysicsBody& operator=(const PhysicsBody&);
+};
+
+}
+
+#endif // PHYSICS_BODY_H_
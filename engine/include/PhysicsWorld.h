@@ -0,0 +1,105 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef PHYSICS_WORLD_H_
+#define PHYSICS_WORLD_H_
+
+#include <GameObject.h>
+#include <Ref.h>
+#include <RenderStats.h>
+#include <Box2D/Box2D.h>
+#include <vector>
+
+namespace yam2d
+{
+
+class PhysicsBody;
+
+/**
+ * Class for PhysicsWorld.
+ *
+ * PhysicsWorld is a component, which owns Box2D world and steps it with fixed time step. Add it to the Map, 
+ * which updates it before game objects of the layers. Frame time is collected to an accumulator and the world 
+ * is stepped as many fixed steps as fit in it, so simulation does not depend on frame rate. Game object 
+ * transforms of PhysicsBodies are interpolated between the last two steps by the time left in the accumulator, 
+ * so movement looks smooth also when frame rate and step rate differ. Only awake bodies are synced.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class PhysicsWorld : public Component, public Updatable
+{
+public:
+	/** Statistics of the latest update. Each update adds them also to RenderStats of the frame. */
+	typedef RenderStats::PhysicsCounters Stats;
+
+	/**
+	 * Creates new physics world.
+	 * @param owner				Owner entity, usually the Map.
+	 * @param gravity			Gravity in map coordinates per second squared.
+	 * @param timeStep			Fixed step length in seconds.
+	 * @param maxStepsPerUpdate	Maximum number of steps in one update. Time beyond that is dropped, so slow 
+	 *							frames do not make following frames even slower.
+	 */
+	PhysicsWorld(Entity* owner, const vec2& gravity = vec2(0.0f, 9.81f), float timeStep = 1.0f/60.0f, int maxStepsPerUpdate = 5);
+
+	virtual ~PhysicsWorld();
+
+	b2World* getWorld() const { return m_world.ptr(); }
+
+	float getTimeStep() const { return m_timeStep; }
+
+	void setIterations(int velocityIterations, int positionIterations);
+
+	/** Steps the world by fixed steps and syncs transforms of awake bodies to their game objects. */
+	virtual void update(float deltaTime);
+
+	/** Returns fraction of the next step, which has elapsed. Game object transforms are interpolated by this. */
+	float getInterpolationAlpha() const { return m_accumulator / m_timeStep; }
+
+	const Stats& getStats() const { return m_stats; }
+
+private:
+	friend class PhysicsBody;
+
+	void addBody(PhysicsBody* body);
+	void removeBody(PhysicsBody* body);
+	void syncBodies(float alpha);
+
+	Ref<b2World>				m_world;
+	float						m_timeStep;
+	int							m_maxStepsPerUpdate;
+	int							m_velocityIterations;
+	int							m_positionIterations;
+	float						m_accumulator;
+	std::vector<PhysicsBody*>	m_bodies;		// Dynamic and kinematic bodies.
+	Stats						m_stats;
+
+	// Hidden
+	PhysicsWorld();
+	PhysicsWorld(const PhysicsWorld&);
+	PhysicsWorld& operator=(const PhysicsWorld&);
+};
+
+}
+
+#endif // PHYSICS_WORLD_H_
@@ -0,0 +1,165 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <config.h>
+#include <vector>
+
+namespace yam2d
+{
+
+/**
+ * Class for Profiler.
+ *
+ * Profiler records time spent in profiling zones, which are marked with YAM2D_PROFILE_ZONE and 
+ * YAM2D_PROFILE_FUNCTION macros. Zones can be nested and can be used from any thread. Each thread records its zones 
+ * to a ring buffer of its own, so recording does not lock. 
+ *
+ * Call YAM2D_PROFILE_FRAME once per frame, which platform main loops do. It collects zones recorded during the 
+ * frame to rolling per-frame summary of each zone. Recorded zones can be written to Chrome trace-event JSON with 
+ * writeChromeTrace and viewed with chrome://tracing.
+ *
+ * endFrame and writeChromeTrace read buffers of all threads, while the threads may keep recording. Zones, which a 
+ * thread overwrites while they are being read, are left out. Buffer of a thread is reused by threads started after 
+ * it has exited, so starting threads again and again does not allocate new buffers.
+ *
+ * Remove YAM2D_PROFILING_ENABLED from config.h for removing zones from the build.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class Profiler
+{
+public:
+	/** Summary of one zone over the frames in history. Times are total time of the zone in a frame in milliseconds. */
+	struct ZoneSummary
+	{
+		const char*		name;
+		int				depth;
+		float			minTime;
+		float			averageTime;
+		float			maxTime;
+		float			averageCalls;
+	};
+
+	/** Number of frames in rolling summary. */
+	static const int HISTORY_SIZE = 120;
+
+	/** Number of zones, which each thread keeps, before oldest zones are overwritten. */
+	static const int BUFFER_SIZE = 16384;
+
+	/** Enables or disables recording. Recording is enabled by default. Set before starting other threads. */
+	static void setEnabled(bool enabled) { s_enabled = enabled; }
+
+	static bool isEnabled() { return s_enabled; }
+
+	/** Sets name of calling thread, which is shown in trace. Name must stay alive. */
+	static void setThreadName(const char* name);
+
+	/** 
+	 * Releases buffer of calling thread for threads started later. Thread calls this, when run has returned. Other 
+	 * threads, which have recorded zones, call this before they exit.
+	 */
+	static void endThread();
+
+	/** Ends frame: adds zones recorded since previous call to summary. Does nothing, when recording is disabled. */
+	static void endFrame();
+
+	/** Returns summary of zones seen in the last HISTORY_SIZE frames, parents before their children. */
+	static void getSummary(std::vector<ZoneSummary>& summary);
+
+	/** Logs summary with esLogMessage. */
+	static void logSummary();
+
+	/** Writes zones in the buffers of all threads to file in Chrome trace-event format. Returns false on error. */
+	static bool writeChromeTrace(const char* fileName);
+
+	/** Removes recorded zones and summary. */
+	static void clear();
+
+	/** Returns current time in ticks of getTicksPerSecond. */
+	static long long getTicks();
+
+	static long long getTicksPerSecond();
+
+	/** Called by ProfileScope. */
+	static long long beginZone();
+	static void endZone(const char* name, long long startTicks);
+
+private:
+	static bool s_enabled;
+};
+
+/**
+ * Class for ProfileScope. Records profiling zone from construction to destruction. Use YAM2D_PROFILE_ZONE instead 
+ * of using this directly.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class ProfileScope
+{
+public:
+	/** Name must be a string literal, or otherwise stay alive until profiler is not used. */
+	explicit ProfileScope(const char* name)
+		: m_name(name)
+		, m_startTicks(Profiler::isEnabled() ? Profiler::beginZone() : -1)
+	{
+	}
+
+	~ProfileScope()
+	{
+		if( m_startTicks >= 0 )
+		{
+			Profiler::endZone(m_name, m_startTicks);
+		}
+	}
+
+private:
+	const char*	m_name;
+	long long	m_startTicks;
+
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+};
+
+}
+
+#define YAM2D_PROFILE_CONCAT_IMPL(a, b) a##b
+#define YAM2D_PROFILE_CONCAT(a, b) YAM2D_PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(YAM2D_PROFILING_ENABLED)
+/** Records zone with given name from this line to the end of the scope. */
+#define YAM2D_PROFILE_ZONE(name) yam2d::ProfileScope YAM2D_PROFILE_CONCAT(profileScope, __LINE__)(name)
+/** Records zone named by the enclosing function to the end of the scope. */
+#define YAM2D_PROFILE_FUNCTION() YAM2D_PROFILE_ZONE(__FUNCTION__)
+/** Ends profiling frame. */
+#define YAM2D_PROFILE_FRAME() yam2d::Profiler::endFrame()
+#else
+#define YAM2D_PROFILE_ZONE(name)
+#define YAM2D_PROFILE_FUNCTION()
+#define YAM2D_PROFILE_FRAME()
+#endif
+
+#endif // PROFILER_H_
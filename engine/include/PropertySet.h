@@ -26,11 +26,17 @@ class PropertySet;
 class Property : public Object
 {
 public:
+	YAM2D_MEMORY_SUBSYSTEM(MemoryStats::PROPERTY_SETS)
+
     class PropertyValueBase : public Object
     {
+    public:
+		YAM2D_MEMORY_SUBSYSTEM(MemoryStats::PROPERTY_SETS)
+
     protected:
         PropertyValueBase()
         {
+			setMemorySubsystem(MemoryStats::PROPERTY_SETS);
         }
     public:
         virtual ~PropertyValueBase()
@@ -251,8 +257,8 @@ private:
 	}
 	
     const std::string getAsString() const;
-    const bool getAsBool() const;
-	const float getAsFloat() const;
+    bool getAsBool() const;
+	float getAsFloat() const;
 	bool isFloat() const;
 
     std::string		m_name;
@@ -308,6 +314,8 @@ inline bool& Property::get()
 class PropertySet : public Object
 {
 public:
+	YAM2D_MEMORY_SUBSYSTEM(MemoryStats::PROPERTY_SETS)
+
     typedef std::vector< Property > PropertySetType;
 	typedef PropertySetType::const_iterator const_iterator;
 	typedef PropertySetType::iterator iterator;
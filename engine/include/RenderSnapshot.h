@@ -0,0 +1,277 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef RENDER_SNAPSHOT_H_
+#define RENDER_SNAPSHOT_H_
+
+#include <Object.h>
+#include <Ref.h>
+#include <Thread.h>
+#include <Sprite.h>
+#include <vec2.h>
+#include <vector>
+
+namespace yam2d
+{
+
+class Camera;
+class Texture;
+class Sprite;
+class Text;
+class SpriteBatchGroup;
+
+/**
+ * Class for RenderSnapshot.
+ *
+ * RenderSnapshot contains everything needed for rendering a map at the end of one update: camera, and for each 
+ * visible layer the sprites and texts with their transforms, clips and colors. Snapshot is written by the update 
+ * thread and is not modified while render thread draws it, so render thread does not need to access the map. 
+ * Static layers are referenced as already batched SpriteBatchGroups, which must not be modified afterwards.
+ * Sprites are stored as quads, which render thread expands to vertices when batching. Vertex data of texts is copied.
+ *
+ * Snapshot holds references to textures and static batches. Reference counts are not thread safe, so they are 
+ * changed only by the update thread, except for the last references, see clear.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class RenderSnapshot : public Object
+{
+public:
+	YAM2D_MEMORY_SUBSYSTEM(MemoryStats::VERTEX_BUFFERS)
+
+	RenderSnapshot();
+
+	virtual ~RenderSnapshot();
+
+	/** 
+	 * Removes all layers and sprites. Textures and batches, which only this snapshot references, are moved to 
+	 * lastReferences, because deleting a texture needs the graphics context. Other references are released.
+	 */
+	void clear(std::vector< Ref<Object> >& lastReferences);
+
+	/** Sets camera, which the snapshot is rendered with. devicePosition is camera position in device coordinates. */
+	void setCamera(const Camera* camera, const vec2& devicePosition);
+
+	/** 
+	 * Starts new layer with given map layer index. Sprites and texts added after this belong to the new layer. If 
+	 * staticBatch is given, it is rendered as the layer instead of sprites.
+	 */
+	void addLayer(int layerIndex, SpriteBatchGroup* staticBatch = 0);
+
+	/** Adds sprite to current layer. Quad of the sprite is copied, so sprite may change afterwards. */
+	void addSprite(Texture* texture, Sprite* sprite, const vec2& position, float rotation, const vec2& scale = vec2(1.0f), const vec2& offset = vec2(0.0f) );
+
+	/** Adds text to current layer. Vertex data of the text is copied, so text may change afterwards. */
+	void addText(Texture* texture, Text* text, const vec2& position, float rotation, const vec2& scale = vec2(1.0f), const vec2& offset = vec2(0.0f) );
+
+	int getNumLayers() const { return (int)m_layers.size(); }
+
+	/** Returns number of sprites and texts in the snapshot. */
+	int getNumSprites() const { return (int)m_sprites.size(); }
+
+	/** Returns number of the update, which published this snapshot, starting from 1. Zero, if not published. */
+	unsigned getSequence() const { return m_sequence; }
+
+private:
+	friend class RenderSnapshotBuffer;
+
+	struct SpriteInstance
+	{
+		Texture*		texture;
+		int				firstVertex; // Copied vertices of text, or -1 for quad.
+		int				numVertices;
+		Sprite::Quad	quad;
+		vec2			position;
+		float			rotation;
+		vec2			scale;
+		vec2			offset;
+	};
+
+	struct LayerInstance
+	{
+		Ref<SpriteBatchGroup>	staticBatch;
+		int						layerIndex;
+		int						firstSprite;
+		int						numSprites;
+	};
+
+	SpriteInstance& addInstance(Texture* texture, const vec2& position, float rotation, const vec2& scale, const vec2& offset);
+
+	void updateMemoryStats();
+
+	int							m_accountedBytes;
+	int							m_screenWidth;
+	int							m_screenHeight;
+	float						m_desiredAspectRatio;
+	float						m_screenUnitSize;
+	vec2						m_cameraPosition;
+	std::vector<LayerInstance>	m_layers;
+	std::vector<SpriteInstance>	m_sprites;
+	std::vector<float>			m_positions;
+	std::vector<float>			m_textureCoords;
+	std::vector<float>			m_colors;
+	std::vector< Ref<Texture> >	m_textures;
+	unsigned					m_sequence;
+};
+
+
+/**
+ * Class for RenderSnapshotBuffer.
+ *
+ * RenderSnapshotBuffer hands render snapshots over from update thread to render thread with triple buffering. 
+ * Update thread writes to snapshot returned by beginWrite and publishes it. Render thread takes the latest 
+ * published snapshot with acquire, or renders it with render. Neither thread waits for the other: snapshots, 
+ * which are published faster than they are rendered, are dropped, and render draws the previous snapshot again, 
+ * if a new one has not been published.
+ *
+ * Queue depth is the number of snapshots published between two acquires: 1 when update and render run in step, 
+ * 0 when render repeats the previous snapshot and more than 1 when snapshots are dropped. Statistics other than 
+ * published and dropped snapshots are kept by the render thread and should be read from it.
+ *
+ * Textures and static batches, which are referenced last by a snapshot cleared in beginWrite, are released by 
+ * the render thread in acquire, so that textures are deleted in the thread, which owns the graphics context.
+ * Buffer should be destroyed in the render thread too, after the update thread has stopped.
+ *
+ * Set buffer to map with Map::setRenderSnapshotBuffer.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class RenderSnapshotBuffer : public Object
+{
+public:
+	YAM2D_MEMORY_SUBSYSTEM(MemoryStats::VERTEX_BUFFERS)
+
+	RenderSnapshotBuffer();
+
+	virtual ~RenderSnapshotBuffer();
+
+	/** 
+	 * Clears and returns snapshot, which update thread can write. Textures and batches referenced last by the 
+	 * snapshot are queued for release in render thread. Called from update thread.
+	 */
+	RenderSnapshot* beginWrite();
+
+	/** Publishes snapshot returned by beginWrite as the latest snapshot. Called from update thread. */
+	void publish();
+
+	/** 
+	 * Takes the latest published snapshot. Returns the previously acquired snapshot, if none has been published 
+	 * since, or empty snapshot before the first publish. Snapshot stays valid until next acquire. Releases textures
+	 * and batches queued by beginWrite. Called from render thread.
+	 */
+	const RenderSnapshot* acquire();
+
+	/** 
+	 * Batches sprites of the acquired snapshot by texture to vertex arrays. Called from render thread. Separate from 
+	 * draw, so that batching can be measured without graphics context.
+	 */
+	void batch();
+
+	/** Draws batched snapshot. Called from render thread, which owns the graphics context. */
+	void draw();
+
+	/** Acquires the latest snapshot, batches and draws it. */
+	void render();
+
+	/** Returns number of published snapshots. */
+	int getNumPublished() const { return m_numPublished.get(); }
+
+	/** Returns number of snapshots, which were replaced by newer ones before they were acquired. */
+	int getNumDropped() const { return m_numDropped.get(); }
+
+	/** Returns number of acquires, which got a new snapshot. */
+	int getNumAcquired() const { return m_numAcquired; }
+
+	/** Returns number of acquires, which got the previous snapshot again. */
+	int getNumRepeated() const { return m_numRepeated; }
+
+	/** Returns maximum queue depth since statistics were reset. */
+	int getMaxQueueDepth() const { return m_maxQueueDepth; }
+
+	/** Returns average queue depth of all acquires since statistics were reset. */
+	float getAverageQueueDepth() const;
+
+	/** Resets statistics. Called from render thread. */
+	void resetStats();
+
+private:
+	enum
+	{
+		INDEX_MASK = 3,
+		NEW_SNAPSHOT = 4
+	};
+
+	struct DrawBatch
+	{
+		Texture*	texture;
+		int			layer;
+		int			numSprites;
+		size_t		firstVertex;
+		size_t		numVertices;
+	};
+
+	struct TextureOrder
+	{
+		TextureOrder(const RenderSnapshot* snapshot) : sprites(&snapshot->m_sprites) {}
+
+		bool operator()(int a, int b) const { return (*sprites)[a].texture < (*sprites)[b].texture; }
+
+		const std::vector<RenderSnapshot::SpriteInstance>* sprites;
+	};
+
+	Ref<RenderSnapshot>		m_snapshots[3];
+
+	// Written only by update thread
+	int						m_writeIndex;
+	unsigned				m_nextSequence;
+
+	// Index of the latest published snapshot and NEW_SNAPSHOT flag, if it has not been acquired
+	AtomicInt				m_latest;
+
+	// Last references queued by update thread for release in render thread
+	Mutex						m_releaseMutex;
+	std::vector< Ref<Object> >	m_releaseQueue;
+
+	// Used only by render thread
+	int						m_accountedBytes;
+	int						m_readIndex;
+	unsigned				m_readSequence;
+	std::vector<int>		m_order;
+	std::vector<DrawBatch>	m_drawBatches;
+	std::vector<float>		m_positions;
+	std::vector<float>		m_textureCoords;
+	std::vector<float>		m_colors;
+	std::vector< Ref<Object> >	m_released;
+
+	AtomicInt				m_numPublished;
+	AtomicInt				m_numDropped;
+	int						m_numAcquired;
+	int						m_numRepeated;
+	int						m_maxQueueDepth;
+	int						m_totalQueueDepth;
+};
+
+}
+
+#endif // RENDER_SNAPSHOT_H_
@@ -0,0 +1,170 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef RENDER_STATS_H_
+#define RENDER_STATS_H_
+
+#include <vector>
+
+namespace yam2d
+{
+
+class Texture;
+
+/**
+ * Class for RenderStats.
+ *
+ * RenderStats collects rendering statistics of each frame broken down by map layer and by texture: sprites 
+ * batched and culled, vertices and draw calls drawn, texture bytes uploaded and time spent building batches. 
+ * Sprite batches, map and textures report to it, so a layer, which is drawn with many draw calls or a texture, 
+ * which is uploaded every frame, can be spotted also in release builds. PhysicsWorld reports its steps and 
+ * bodies, so that physics cost is seen in the same frame history.
+ *
+ * Statistics are recorded to the layer set with setCurrentLayer, which is kept for each thread. Map and 
+ * RenderSnapshotBuffer set it, while they batch and draw layers. Recording can be done from any thread, and is 
+ * locked once per batch, not per sprite.
+ *
+ * Call endFrame once per frame, which platform main loops do. It moves statistics recorded since previous call 
+ * to history of the last HISTORY_SIZE frames. When map is rendered from snapshots, batching of update thread and 
+ * drawing of render thread are counted to the frame, in which they happen to be recorded.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class RenderStats
+{
+public:
+	/** Counters of one frame. */
+	struct Counters
+	{
+		Counters();
+
+		void add(const Counters& other);
+
+		int		numSpritesBatched;
+		int		numSpritesCulled;
+		int		numVertices;
+		int		numDrawCalls;
+		int		numBytesUploaded;
+		float	batchTime; // Milliseconds
+	};
+
+	/** 
+	 * Physics counters of one frame. Steps and step time are summed over PhysicsWorld updates of the frame, other
+	 * counters are those of the latest update.
+	 */
+	struct PhysicsCounters
+	{
+		PhysicsCounters();
+
+		float	stepTime;			// Milliseconds spent in Box2D steps.
+		int		numSteps;
+		int		numBodies;			// Bodies in the world, including static bodies.
+		int		numAwakeBodies;
+		int		numContacts;
+		int		numProxies;			// Broadphase proxies.
+	};
+
+	struct LayerStats
+	{
+		int			layerIndex;
+		Counters	counters;
+	};
+
+	/** Textures are identified by their native id, because texture may be deleted before stats are read. */
+	struct TextureStats
+	{
+		int			nativeId;
+		int			width;
+		int			height;
+		Counters	counters;
+	};
+
+	/** Statistics of one frame. Only layers and textures, which had non-zero counters, are included. */
+	struct FrameStats
+	{
+		int							frameIndex;
+		Counters					total;
+		PhysicsCounters				physics;
+		std::vector<LayerStats>		layers;
+		std::vector<TextureStats>	textures;
+	};
+
+	/** Number of frames in history. */
+	static const int HISTORY_SIZE = 120;
+
+	/** Layer index of statistics recorded outside of layers. */
+	static const int NO_LAYER = -1;
+
+	/** Enables or disables recording. Recording is enabled by default. */
+	static void setEnabled(bool enabled) { s_enabled = enabled; }
+
+	static bool isEnabled() { return s_enabled; }
+
+	/** Sets layer, which statistics recorded by calling thread belong to. Use NO_LAYER, when done with the layer. */
+	static void setCurrentLayer(int layerIndex);
+
+	static int getCurrentLayer();
+
+	/** Adds sprites and texts batched with given texture, which may be 0. */
+	static void addBatched(Texture* texture, int numSprites);
+
+	/** Adds sprites, which were not batched, because they were not visible. */
+	static void addCulled(int numSprites);
+
+	/** Adds time spent in building batches in milliseconds. */
+	static void addBatchTime(float milliseconds);
+
+	/** Adds draw call of given number of vertices with given texture, which may be 0. */
+	static void addDrawCall(Texture* texture, int numVertices);
+
+	/** Adds bytes uploaded to given texture. */
+	static void addTextureUpload(Texture* texture, int numBytes);
+
+	/** Adds counters of physics world update. */
+	static void addPhysics(const PhysicsCounters& counters);
+
+	/** Ends frame: moves statistics recorded since previous call to history. Does nothing, when disabled. */
+	static void endFrame();
+
+	/** Returns number of frames in history. */
+	static int getNumFrames();
+
+	/** 
+	 * Copies statistics of frame, which ended given number of frames ago, 0 being the latest one. Layers are in 
+	 * layer order and textures in decreasing order of vertices. Returns false, if frame is not in history.
+	 */
+	static bool getFrame(int framesAgo, FrameStats& frame);
+
+	/** Logs statistics of given frame with esLogMessage. */
+	static void logFrame(int framesAgo = 0);
+
+	/** Removes history and statistics of the current frame. */
+	static void clear();
+
+private:
+	static bool s_enabled;
+};
+
+}
+
+#endif // RENDER_STATS_H_
@@ -0,0 +1,85 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef RENDER_STATS_OVERLAY_H_
+#define RENDER_STATS_OVERLAY_H_
+
+#include <GameObject.h>
+#include <RenderStats.h>
+#include <vector>
+
+namespace yam2d
+{
+
+class Layer;
+class SpriteSheet;
+class Text;
+
+/**
+ * Class for RenderStatsOverlay.
+ *
+ * RenderStatsOverlay shows RenderStats of the latest frame as lines of Text at the top left corner of the main 
+ * camera of the map: totals of the frame, then each layer and then textures with the most vertices. Overlay is 
+ * meant for spotting layers, which break batching to many draw calls, and textures, which are uploaded every frame,
+ * also in release builds. Lines are drawn like other texts of the layer, so they are included in the statistics.
+ *
+ * Create overlay with create to the topmost visible layer, for example Map::GUILAYER9. Overlay supports orthogonal 
+ * maps.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class RenderStatsOverlay : public Component, public Updatable
+{
+public:
+	/** 
+	 * Creates overlay with given number of text lines drawn with given font to layer. Returns game object, which 
+	 * has the overlay component. Remove the game object from layer for removing the overlay.
+	 */
+	static GameObject* create(Layer* layer, SpriteSheet* font, int numLines = 12);
+
+	RenderStatsOverlay(GameObject* owner, Layer* layer, const std::vector<Text*>& lines);
+
+	virtual ~RenderStatsOverlay();
+
+	/** Sets interval of updating texts in seconds. Lines follow camera every frame. Default is 0.5 seconds. */
+	void setRefreshInterval(float seconds) { m_refreshInterval = seconds; }
+
+	virtual void update(float deltaTime);
+
+private:
+	void updateTexts();
+
+	Layer*							m_layer;
+	std::vector< Ref<Text> >		m_lines;
+	RenderStats::FrameStats			m_frame;
+	float							m_refreshInterval;
+	float							m_timeToRefresh;
+
+	RenderStatsOverlay();
+	RenderStatsOverlay(const RenderStatsOverlay&);
+	RenderStatsOverlay& operator=(const RenderStatsOverlay&);
+};
+
+}
+
+#endif // RENDER_STATS_OVERLAY_H_
@@ -0,0 +1,114 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef SPATIAL_HASH_GRID_H_
+#define SPATIAL_HASH_GRID_H_
+
+#include <Broadphase.h>
+#include <vector>
+
+namespace yam2d
+{
+
+/**
+ * Class for SpatialHashGrid.
+ *
+ * Broadphase, which divides the world to uniform grid of cells. Each game object is stored to each cell it
+ * overlaps, and cells are stored to hash table, so the world does not need to have any bounds. Objects, which 
+ * would cover too many cells (for example big background objects), are stored to separate list, which is
+ * tested in every query. 
+ *
+ * Moving object inside its cells only updates its extents. Grid works best, when objects are about size of a
+ * cell or smaller and are distributed evenly. For worlds with very different object sizes, DynamicAabbTree
+ * may be better choice.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class SpatialHashGrid : public Broadphase
+{
+public:
+	/**
+	 * Creates new grid.
+	 * @param cellSize		Size of grid cell in tiles. Good cell size is about size of typical game object or bit larger.
+	 * @param numBuckets	Initial number of hash buckets. Number of buckets grows with number of objects.
+	 */
+	SpatialHashGrid(float cellSize = 4.0f, int numBuckets = 1024);
+
+	virtual ~SpatialHashGrid();
+
+	float getCellSize() const { return m_cellSize; }
+
+	virtual void clear();
+	virtual int queryAabb(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const;
+	virtual void findOverlappingPairs(PairCallback* callback) const;
+
+protected:
+	virtual int createProxy(GameObject* gameObject, const vec2& topLeft, const vec2& bottomRight);
+	virtual void destroyProxy(int proxyId);
+	virtual void moveProxy(int proxyId, const vec2& topLeft, const vec2& bottomRight);
+
+private:
+	struct Proxy
+	{
+		GameObject*			gameObject;		// 0, if proxy is free.
+		vec2				topLeft;
+		vec2				bottomRight;
+		int					cellX0;
+		int					cellY0;
+		int					cellX1;
+		int					cellY1;
+		bool				isLarge;		// Proxy is in m_largeProxies instead of cells.
+		int					nextFree;
+	};
+
+	struct Entry
+	{
+		int					proxyId;
+		int					cellX;
+		int					cellY;
+	};
+
+	typedef std::vector<Entry> Bucket;
+
+	int getCell(float coordinate) const;
+	size_t getBucketIndex(int cellX, int cellY) const;
+	void insertProxy(int proxyId);
+	void removeProxy(int proxyId);
+	void rehash(size_t numBuckets);
+
+	float								m_cellSize;
+	float								m_inverseCellSize;
+	std::vector<Proxy>					m_proxies;
+	int									m_freeProxy;
+	std::vector<Bucket>					m_buckets;
+	size_t								m_numEntries;
+	std::vector<int>					m_largeProxies;
+
+	// Hidden
+	SpatialHashGrid(const SpatialHashGrid&);
+	SpatialHashGrid& operator=(const SpatialHashGrid&);
+};
+
+}
+
+#endif // SPATIAL_HASH_GRID_H_
@@ -51,6 +51,16 @@ public:
 		vec2int clipSize;
 	};
 
+	/** Color, scale, clip and depth of sprite, from which its vertex data is made. */
+	struct Quad
+	{
+		float	color[4];
+		vec2	scale;
+		vec2	clipStart;
+		vec2	clipSize;
+		float	depth;
+	};
+
 	Sprite(Entity* owner);
 
 	virtual ~Sprite();
@@ -86,6 +96,12 @@ public:
 
 	void getVertexData( std::vector<float>& verts, std::vector<float>& texCoords, std::vector<float>& colors ) const;
 
+	/** Returns quad of this sprite. Quad is much smaller than vertex data, so it is cheaper to copy. */
+	Quad getQuad() const;
+
+	/** Appends vertex data of two triangles of given quad to given arrays. */
+	static void getVertexData( const Quad& quad, std::vector<float>& verts, std::vector<float>& texCoords, std::vector<float>& colors );
+
 	/**
 	 * Sets clip area of this sprite in pixel coordinates.
 	 */
@@ -46,8 +46,11 @@ class Sprite;
 class SpriteBatch : public Object
 {
 public:
+	YAM2D_MEMORY_SUBSYSTEM(MemoryStats::VERTEX_BUFFERS)
+
 	/**
-	 * Resets statistics values to zero.
+	 * Resets statistics values to zero. Statistics are counted from all threads. For statistics of each layer and 
+	 * texture, see RenderStats.
 	 */
 	static void resetStatsValues();
 
@@ -66,6 +69,17 @@ public:
 	 */
 	static int getNumSpritesBatched();
 
+	/**
+	 * Transforms vertices from startVertex to end of positions with given position, rotation, scale and offset. 
+	 * Winding order of triangles is swapped, if scale is negative on one axis. Used by addSprite and addText.
+	 */
+	static void transformVertices(std::vector<float>& positions, std::vector<float>& textureCoords, size_t startVertex, 
+		const vec2& position, float rotation, const vec2& scale = vec2(1.0), const vec2& offset = vec2(0.0) );
+
+	/** Draws triangles of given vertex arrays with texture, which may be 0. */
+	static void draw(Texture* texture, const float* positions, const float* textureCoords, const float* colors, 
+		int numVertices, float aspectRatio = 1.0f);
+
 	SpriteBatch();
 
 	virtual ~SpriteBatch();
@@ -82,7 +96,14 @@ public:
 
 	Texture* getTexture() const;
 
+	/** Returns number of sprites and texts added since last clear. */
+	int getNumSprites() const { return m_numSprites; }
+
 private:
+	void updateMemoryStats();
+
+	int					m_numSprites;
+	int					m_accountedBytes;
 	std::vector<float>	m_positions;
 	std::vector<float>	m_textureCoords;
 	std::vector<float>	m_colors;
@@ -119,6 +140,9 @@ public:
 	/** Renders the content of the Sprite batch to the screen. */
 	void render(float aspectRatio = 1.0f);
 
+	/** Adds number of sprites in each batch to RenderStats of the current layer. */
+	void addBatchedToRenderStats() const;
+
 private:
 	std::map<Texture*,Ref<SpriteBatch> > m_spriteBatches;
 
@@ -0,0 +1,104 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef STATIC_TILE_BODY_H_
+#define STATIC_TILE_BODY_H_
+
+#include <Object.h>
+#include <Ref.h>
+#include <TileGrid.h>
+#include <Box2D/Box2D.h>
+
+namespace yam2d
+{
+
+/**
+ * Class for StaticTileBody.
+ *
+ * StaticTileBody creates Box2D collision geometry of the level from solid cells of TileGrid, see Map::getTileGrid.
+ * Instead of one static body for each solid tile, all tiles are merged to a single static body, which has either 
+ * one box fixture for each rectangle of greedy meshing, or one chain loop fixture for each outline of solid areas.
+ * This reduces number of Box2D broadphase proxies and contacts with static geometry by orders of magnitude on 
+ * tile heavy levels. Box2D coordinates are map coordinates, like in GameObject.
+ *
+ * Geometry is rebuilt in update, if tiles have changed.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class StaticTileBody : public Object, public TileGrid::ChangeListener
+{
+public:
+	enum ShapeType
+	{
+		SHAPE_RECTANGLES,	// Box fixture for each merged rectangle. Dynamic bodies can not get stuck inside tiles.
+		SHAPE_OUTLINES		// Chain loop fixture for each outline. Fewer vertices and no seams between rectangles.
+	};
+
+	/**
+	 * Creates static body for solid cells of given tile grid.
+	 * @param world			Box2D world, where body is created.
+	 * @param tileGrid		Tile grid, where solid cells are collidable.
+	 * @param shapeType		Type of fixtures.
+	 * @param friction		Friction of fixtures.
+	 * @param restitution	Restitution of fixtures.
+	 */
+	StaticTileBody(b2World* world, TileGrid* tileGrid, ShapeType shapeType = SHAPE_RECTANGLES, float friction = 0.9f, float restitution = 0.0f);
+
+	/** Destroys the body. */
+	virtual ~StaticTileBody();
+
+	b2Body* getBody() const { return m_body; }
+
+	TileGrid* getTileGrid() const { return m_tileGrid.ptr(); }
+
+	/** Returns number of fixtures of the body. */
+	int getNumFixtures() const { return m_numFixtures; }
+
+	/** Rebuilds fixtures, if tiles have changed since last build. */
+	void update();
+
+	/** Destroys all fixtures and creates them again from the tile grid. */
+	void rebuild();
+
+	/** Called by TileGrid, when cell changes. */
+	virtual void onCellChanged(int x, int y, bool solid);
+
+private:
+	Ref<b2World>		m_world;
+	Ref<TileGrid>		m_tileGrid;
+	b2Body*				m_body;
+	ShapeType			m_shapeType;
+	float				m_friction;
+	float				m_restitution;
+	int					m_numFixtures;
+	bool				m_dirty;
+
+	// Hidden
+	StaticTileBody();
+	StaticTileBody(const StaticTileBody&);
+	StaticTileBody& operator=(const StaticTileBody&);
+};
+
+}
+
+#endif // STATIC_TILE_BODY_H_
@@ -0,0 +1,208 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef STREAMING_MAP_H_
+#define STREAMING_MAP_H_
+
+#include <Map.h>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+namespace yam2d
+{
+
+class RegionLoader;
+
+/**
+ * Class for streaming TMX-formatted map.
+ *
+ * StreamingTmxMap divides the map to square regions of regionSize x regionSize tiles. On loadMapFile 
+ * only tilesets and layers are created. Tiles and objects are stored as compact region records (in 
+ * memory or, if cache directory is set, in region files) instead of game objects.
+ *
+ * Each update, regions inside load radius around the map camera are decoded on a background thread and
+ * instantiated to the layers, but at most entityBudget game objects are created per frame. Regions
+ * outside of evict radius are evicted: objects of object layers are serialized back to region records
+ * (with their current position and rotation) and all game objects of the region are removed. Evict radius
+ * must be bigger than load radius, so that moving back and forth at region border does not cause
+ * regions to be loaded and evicted repeatedly.
+ *
+ * Tile layers are treated as immutable: tiles are always recreated from original records. Game objects
+ * of object layers, which has property "persistent" set to true, are never evicted. Objects added to
+ * map layers by the game are streamed like map objects, so they must be recreatable by the component 
+ * factory from their properties.
+ *
+ * Region files, which can not be written, are handled without losing objects: records of the region are kept 
+ * in memory on load, and on evict the region stays resident until its records can be written. Region file, 
+ * which can not be read, is loaded as empty. Failures are logged as warnings.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class StreamingTmxMap : public TmxMap
+{
+public:
+	/**
+	 * Creates new streaming map.
+	 * @param regionSize	Width and height of single region in tiles.
+	 */
+	StreamingTmxMap(int regionSize = 32);
+
+	virtual ~StreamingTmxMap();
+
+	/** 
+	 * Loads map file and splits it into regions. Given component factory is used also later for instantiating
+	 * regions, so it must be alive as long as this map.
+	 */
+	bool loadMapFile(const std::string& mapFileName, ComponentFactory* componentFactory);
+
+	/** Updates region streaming and then all map layers. */
+	virtual void update( float deltaTime );
+
+	/**
+	 * Sets directory, where region records are written. If set before loadMapFile, region records are 
+	 * kept on disk instead of memory. Directory must exist and be writable.
+	 */
+	void setRegionCacheDirectory(const std::string& path) { m_cacheDirectory = path; }
+
+	/**
+	 * Sets load and evict radius in regions (Chebyshev distance from camera region). Regions inside 
+	 * load radius are loaded and regions outside evict radius are evicted. Default is 1 and 2.
+	 */
+	void setRegionRadius(int loadRadius, int evictRadius);
+
+	/** Sets maximum number of game objects to be instantiated in one frame. Default is 256. */
+	void setEntityBudget(int maxEntitiesPerFrame) { m_entityBudget = maxEntitiesPerFrame; }
+
+	/** Loads and instantiates all regions inside load radius immediately. Useful at level start or after teleporting camera. */
+	void preloadRegions();
+
+	int getRegionSize() const { return m_regionSize; }
+	int getNumRegionsX() const { return m_numRegionsX; }
+	int getNumRegionsY() const { return m_numRegionsY; }
+
+	/** Returns number of regions, which are loaded or being instantiated. */
+	int getNumResidentRegions() const;
+
+	/** Returns number of regions, which are waiting for the loader thread. */
+	int getNumLoadingRegions() const;
+
+	/** Returns number of game objects waiting for instantiation. */
+	int getNumPendingEntities() const;
+
+protected:
+	virtual void onTileLoaded(ComponentFactory* componentFactory, int layerIndex, int x, int y, int tilesetIndex, unsigned id, bool flippedHorizontally, bool flippedVertically, bool flippedDiagonally);
+	virtual void onObjectLoaded(ComponentFactory* componentFactory, int layerIndex, const PropertySet& properties, int tilesetIndex);
+
+private:
+	friend class RegionLoader;
+
+	enum RegionState
+	{
+		REGION_UNLOADED = 0,
+		REGION_LOADING,
+		REGION_INSTANTIATING,
+		REGION_RESIDENT
+	};
+
+	struct TileRecord
+	{
+		int32_t x;
+		int32_t y;
+		uint16_t layerIndex;
+		uint16_t tilesetIndex;
+		uint32_t idAndFlags;
+	};
+
+	struct ObjectRecord
+	{
+		int layerIndex;
+		int tilesetIndex;
+		std::string json;
+	};
+
+	struct Region
+	{
+		Region();
+
+		RegionState state;
+		bool cancelled;
+		bool inCache;							// Records are in region files instead of memory.
+		std::vector<uint8_t> tileData;			// Tile records, if kept in memory.
+		std::vector<uint8_t> objectData;		// Object records, if kept in memory.
+		std::vector<ObjectRecord> strayObjects;	// Objects moved to this region, when it was not resident.
+		std::vector<TileRecord> pendingTiles;	// Decoded tiles waiting for instantiation.
+		std::vector<ObjectRecord> pendingObjects; // Decoded objects waiting for instantiation.
+		size_t nextPendingTile;
+		size_t nextPendingObject;
+	};
+
+	// Game object found by evictRegions. Stray objects are moved to records of their non-resident region.
+	struct EvictedObject
+	{
+		Layer* layer;
+		GameObject* gameObject;
+		int regionIndex;
+		bool inEvictedRegion;
+		bool isStray;
+		ObjectRecord record;
+	};
+
+	void updateRegions(bool blocking);
+	void requestRegion(int regionIndex, int distance);
+	void evictRegions(const std::vector<int>& regionsToEvict);
+	int instantiatePending(int budget);
+	void setRegionState(int regionIndex, RegionState state);
+
+	int getRegionIndex(const vec2& position) const;
+	int getRegionDistance(int regionIndex, int cameraRegionX, int cameraRegionY) const;
+	std::string getRegionFileName(int regionIndex, const char* type) const;
+
+	static void appendObjectRecord(std::vector<uint8_t>& data, const ObjectRecord& record);
+	static void decodeRegion(const std::vector<uint8_t>& tileData, const std::vector<uint8_t>& objectData, std::vector<TileRecord>& tiles, std::vector<ObjectRecord>& objects);
+	static bool readFile(const std::string& fileName, std::vector<uint8_t>& data);
+	static bool writeFile(const std::string& fileName, const std::vector<uint8_t>& data);
+
+	int								m_regionSize;
+	int								m_numRegionsX;
+	int								m_numRegionsY;
+	int								m_loadRadius;
+	int								m_evictRadius;
+	int								m_entityBudget;
+	int								m_cameraRegion;
+	std::string						m_cacheDirectory;
+	ComponentFactory*				m_componentFactory;
+	std::vector<Region>				m_regions;
+	std::vector<int>				m_activeRegions;		// Regions, which are not unloaded.
+	std::vector<int>				m_instantiateQueue;		// Regions waiting for instantiation, closest first.
+	std::vector<bool>				m_isTileLayer;
+	RegionLoader*					m_loader;
+
+	// Hidden
+	StreamingTmxMap(const StreamingTmxMap&);
+	StreamingTmxMap& operator=(const StreamingTmxMap&);
+};
+
+}
+
+#endif // STREAMING_MAP_H_
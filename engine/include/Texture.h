@@ -38,7 +38,30 @@ namespace yam2d
 class Texture : public Object
 {
 public:
+	YAM2D_MEMORY_SUBSYSTEM(MemoryStats::TEXTURES)
+
+	/** 
+	 * Format of the texture in GPU memory. FORMAT_DEFAULT uploads data as is (8 bits per channel). Other 
+	 * formats are converted at CPU before upload. FORMAT_ETC1 stores RGB as ETC1 and alpha (if the texture
+	 * has transparent pixels) to separate GL_ALPHA texture. If the driver does not support ETC1, RGB565 or 
+	 * RGBA4444 is used instead.
+	 */
+	enum Format
+	{
+		FORMAT_DEFAULT = 0,
+		FORMAT_RGB565,
+		FORMAT_RGBA4444,
+		FORMAT_RGBA5551,
+		FORMAT_ETC1,
+	};
+
 	Texture(const std::string& fileName, bool allowNPOT = false);
+
+	/** 
+	 * Creates texture from already decoded pixel data (3 or 4 bytes per pixel). Data is copied and uploaded
+	 * once with given format. Used by AssetLoader, which decodes images on background threads.
+	 */
+	Texture(const unsigned char* data, int width, int height, int bpp, Format format = FORMAT_DEFAULT, bool dither = false, bool clampToEdge = false);
 	Texture(unsigned int nativeId, int bytesPerPixel);
 	virtual ~Texture();
 
@@ -60,6 +83,29 @@ public:
 
 	void updateData() { updateData(0); }
 
+	/** Sets GPU format of the texture and reuploads texture data. Source data is kept in 8 bits per channel. */
+	void setFormat(Format format, bool dither = false);
+	Format getFormat() const { return m_format; }
+	bool isDithered() const { return m_dither; }
+
+	/** Returns native id of separate alpha texture used with FORMAT_ETC1 or 0 if texture has no alpha texture. */
+	unsigned int getAlphaNativeId() const { return m_alphaNativeId; }
+
+	/** Returns size of the source data in bytes (8 bits per channel). */
+	int getSourceSizeInBytes() const { return m_width*m_height*m_bpp; }
+
+	/** Returns size of the uploaded texture data in GPU memory in bytes, including alpha texture. */
+	int getSizeInBytes() const { return m_sizeInBytes; }
+
+	/** Returns total size of all uploaded textures in bytes. */
+	static int getTotalSizeInBytes();
+
+	/** Converts format name from TMX property ("RGB565", "RGBA4444", "RGBA5551", "ETC1") to Format. */
+	static Format getFormatFromString(const std::string& formatName);
+
+	/** Returns true, if the GLES driver supports GL_OES_compressed_ETC1_RGB8_texture extension. */
+	static bool isETC1Supported();
+
 protected:
 	Texture(int numNativeTextures);
 
@@ -70,12 +116,21 @@ protected:
 private:
 	Texture();
 
+	// Converts and uploads texture data to given native texture. Returns size of uploaded data in bytes.
+	int uploadData(unsigned int nativeId);
+	void setSizeInBytes(int sizeInBytes);
+
 	unsigned int* m_nativeIds;
 	int m_numNativeIds;
 	int m_width;
 	int m_height;
 	int m_bpp;
 	unsigned char* m_data;
+	Format m_format;
+	bool m_dither;
+	bool m_clampToEdge;
+	unsigned int m_alphaNativeId;
+	int m_sizeInBytes;
 };
 
 
@@ -0,0 +1,70 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef TEXTURE_CONVERTER_H_
+#define TEXTURE_CONVERTER_H_
+
+#include <stdint.h>
+
+namespace yam2d
+{
+	/**
+	 * CPU side pixel format converters used by Texture for reduced precision and compressed GPU formats.
+	 *
+	 * All functions take 8 bits per channel source data with 3 (RGB) or 4 (RGBA) bytes per pixel. When
+	 * dither is true, 4x4 ordered (Bayer) dithering is applied before truncating channels, which hides most
+	 * of the banding caused by 4 and 5 bit channels.
+	 *
+	 * @ingroup yam2d
+	 * @author Mikko Romppainen (mikko@kajakbros.com)
+	 */
+
+	/** Converts pixels to GL_UNSIGNED_SHORT_5_6_5. Alpha channel is ignored. dst must hold width*height shorts. */
+	void convertToRGB565(const uint8_t* src, int width, int height, int bpp, bool dither, uint16_t* dst);
+
+	/** Converts pixels to GL_UNSIGNED_SHORT_4_4_4_4. dst must hold width*height shorts. */
+	void convertToRGBA4444(const uint8_t* src, int width, int height, int bpp, bool dither, uint16_t* dst);
+
+	/** Converts pixels to GL_UNSIGNED_SHORT_5_5_5_1. Alpha is thresholded at 50%. dst must hold width*height shorts. */
+	void convertToRGBA5551(const uint8_t* src, int width, int height, int bpp, bool dither, uint16_t* dst);
+
+	/** Returns size in bytes of ETC1 compressed image with given dimensions. */
+	int getETC1DataSize(int width, int height);
+
+	/** Compresses RGB channels to ETC1 blocks. dst must hold getETC1DataSize(width, height) bytes. */
+	void compressETC1(const uint8_t* src, int width, int height, int bpp, uint8_t* dst);
+
+	/** Copies alpha channel of RGBA pixels to 8 bit GL_ALPHA image. dst must hold width*height bytes. */
+	void extractAlpha(const uint8_t* src, int width, int height, int bpp, uint8_t* dst);
+
+	/** Returns true, if any pixel of the image has alpha less than 255. Always false for 3 bytes per pixel. */
+	bool hasTransparentPixels(const uint8_t* src, int width, int height, int bpp);
+
+	/** 
+	 * Converts pixels to RGBA and clears alpha of pixels matching given color. dst must hold width*height*4 bytes. 
+	 * With 4 bytes per pixel src and dst may point to same data.
+	 */
+	void applyTransparentColor(const uint8_t* src, int width, int height, int bpp, uint8_t r, uint8_t g, uint8_t b, uint8_t* dst);
+}
+
+
+#endif
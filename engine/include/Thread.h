@@ -0,0 +1,219 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef THREAD_H_
+#define THREAD_H_
+
+#include <Object.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Storage class for variables, which have separate value in each thread. Only for plain data.
+#if defined(_MSC_VER)
+#define YAM_THREAD_LOCAL __declspec(thread)
+#else
+#define YAM_THREAD_LOCAL __thread
+#endif
+
+namespace yam2d
+{
+
+/**
+ * Class for Mutex. 
+ *
+ * Thin wrapper over CRITICAL_SECTION on Windows and pthread_mutex_t on other platforms.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class Mutex
+{
+public:
+	Mutex();
+	~Mutex();
+
+	void lock();
+	void unlock();
+
+private:
+	friend class ConditionVariable;
+	void* m_handle;
+
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+};
+
+
+/**
+ * Locks given mutex for the lifetime of the ScopedLock object.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class ScopedLock
+{
+public:
+	explicit ScopedLock(Mutex& mutex) : m_mutex(mutex) { m_mutex.lock(); }
+	~ScopedLock() { m_mutex.unlock(); }
+
+private:
+	Mutex& m_mutex;
+
+	ScopedLock(const ScopedLock&);
+	ScopedLock& operator=(const ScopedLock&);
+};
+
+
+/**
+ * Class for ConditionVariable. 
+ *
+ * Wait must be called with the mutex locked. As with all condition variables, spurious 
+ * wakeups are possible, so wait should be called in a loop checking the actual condition.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class ConditionVariable
+{
+public:
+	ConditionVariable();
+	~ConditionVariable();
+
+	void wait(Mutex& mutex);
+	void signal();
+	void broadcast();
+
+private:
+	void* m_handle;
+
+	ConditionVariable(const ConditionVariable&);
+	ConditionVariable& operator=(const ConditionVariable&);
+};
+
+
+/**
+ * Class for AtomicInt. 
+ *
+ * Integer, which can be modified from several threads without locking. All operations are full memory barriers.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class AtomicInt
+{
+public:
+	explicit AtomicInt(int value = 0) : m_value(value) {}
+
+#if defined(_MSC_VER)
+	/** Adds given value and returns the new value. */
+	int add(int value) { return int(_InterlockedExchangeAdd(&m_value, long(value))) + value; }
+
+	/** Sets value to desired, if it is expected. Returns true, if value was set. */
+	bool compareAndSwap(int expected, int desired) { return _InterlockedCompareExchange(&m_value, long(desired), long(expected)) == long(expected); }
+
+	int get() const { return int(_InterlockedOr(const_cast<volatile long*>(&m_value), 0)); }
+
+	void set(int value) { _InterlockedExchange(&m_value, long(value)); }
+
+	/** Sets value and returns the previous value. */
+	int exchange(int value) { return int(_InterlockedExchange(&m_value, long(value))); }
+#else
+	/** Adds given value and returns the new value. */
+	int add(int value) { return __sync_add_and_fetch(&m_value, value); }
+
+	/** Sets value to desired, if it is expected. Returns true, if value was set. */
+	bool compareAndSwap(int expected, int desired) { return __sync_bool_compare_and_swap(&m_value, expected, desired); }
+
+	int get() const { return __atomic_load_n(&m_value, __ATOMIC_SEQ_CST); }
+
+	void set(int value) { __atomic_store_n(&m_value, value, __ATOMIC_SEQ_CST); }
+
+	/** Sets value and returns the previous value. */
+	int exchange(int value) { return __atomic_exchange_n(&m_value, value, __ATOMIC_SEQ_CST); }
+#endif
+
+	/** Increments value and returns the new value. */
+	int increment() { return add(1); }
+
+	/** Decrements value and returns the new value. */
+	int decrement() { return add(-1); }
+
+private:
+#if defined(_MSC_VER)
+	volatile long m_value;
+#else
+	volatile int m_value;
+#endif
+
+	AtomicInt(const AtomicInt&);
+	AtomicInt& operator=(const AtomicInt&);
+};
+
+
+/**
+ * Class for Thread. 
+ *
+ * Derive from Thread and implement run-method. Call start to start the thread and join to wait until
+ * run has returned. Thread must be joined before it is destroyed.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class Thread : public Object
+{
+public:
+	Thread();
+	virtual ~Thread();
+
+	/** Starts the thread. Returns false, if thread could not be created. */
+	bool start();
+
+	/** Waits until the thread has finished. */
+	void join();
+
+	/** Returns true, if thread has been started and not yet joined. */
+	bool isRunning() const { return m_handle != 0; }
+
+	/** Suspends calling thread for given amount of milliseconds. */
+	static void sleep(int milliseconds);
+
+	/** Returns number of processors in the system. */
+	static int getNumProcessors();
+
+protected:
+	/** Thread function. Called from the new thread after start. */
+	virtual void run() = 0;
+
+private:
+	friend void runThreadEntry(Thread* thread);
+
+	void* m_handle;
+
+	Thread(const Thread&);
+	Thread& operator=(const Thread&);
+};
+
+}
+
+#endif // THREAD_H_
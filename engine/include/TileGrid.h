@@ -0,0 +1,198 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef TILE_GRID_H_
+#define TILE_GRID_H_
+
+#include <Object.h>
+#include <vec2.h>
+#include <vector>
+#include <stdint.h>
+
+namespace yam2d
+{
+
+/**
+ * Class for TileGrid.
+ *
+ * TileGrid stores solid cells of the level as a plain grid with one byte for each cell, so collision queries
+ * against level geometry are made directly with tile coordinates instead of testing tile game objects. Cell 
+ * (x,y) covers area from origin+(x,y) to origin+(x+1,y+1) in map coordinates. Cells outside of the grid are 
+ * not solid.
+ *
+ * TmxMap creates tile grid of the map from tiles, which have tileset tile property "solid" set to true, 
+ * see Map::getTileGrid.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class TileGrid : public Object
+{
+public:
+	/** Result of a raycast. */
+	struct RaycastHit
+	{
+		vec2		position;		// Point, where the ray hit solid cell.
+		vec2		normal;			// Normal of the cell side, which was hit. Zero, if ray started inside solid cell.
+		float		fraction;		// Position of the hit along the ray: 0 at start and 1 at end.
+		int			cellX;			// Hit cell or -1, if nothing was hit.
+		int			cellY;
+	};
+
+	/** Rectangle of solid cells, in cells. */
+	struct CellRect
+	{
+		int			x;
+		int			y;
+		int			width;
+		int			height;
+	};
+
+	/** Interface for receiving changes of cell solidity, for example for invalidating cached paths. */
+	class ChangeListener
+	{
+	public:
+		virtual ~ChangeListener() {}
+		virtual void onCellChanged(int x, int y, bool solid) = 0;
+	};
+
+	/**
+	 * Creates new grid with all cells empty.
+	 * @param width			Width of the grid in cells.
+	 * @param height		Height of the grid in cells.
+	 * @param origin		Map coordinates of top left corner of cell (0,0).
+	 */
+	TileGrid(int width, int height, const vec2& origin = vec2(0.0f));
+
+	virtual ~TileGrid();
+
+	int getWidth() const { return m_width; }
+	int getHeight() const { return m_height; }
+	const vec2& getOrigin() const { return m_origin; }
+
+	/** Sets solidity of given cell. Cell must be inside the grid. Change listeners are notified, if solidity changes. */
+	void setSolid(int x, int y, bool solid)
+	{
+		assert( x >= 0 && x < m_width && y >= 0 && y < m_height );
+		uint8_t& cell = m_cells[y*m_width + x];
+		if( cell != (solid ? 1 : 0) )
+		{
+			cell = solid ? 1 : 0;
+			if( !m_listeners.empty() )
+			{
+				notifyCellChanged(x, y, solid);
+			}
+		}
+	}
+
+	/** Returns true, if given cell is solid. Returns false for cells outside of the grid. */
+	bool isSolid(int x, int y) const
+	{
+		return unsigned(x) < unsigned(m_width) && unsigned(y) < unsigned(m_height) && m_cells[y*m_width + x] != 0;
+	}
+
+	/** Adds listener, which is notified each time solidity of a cell changes. */
+	void addChangeListener(ChangeListener* listener);
+	void removeChangeListener(ChangeListener* listener);
+
+	/** Returns cell containing given position (in map coordinates). */
+	int getCellX(float x) const;
+	int getCellY(float y) const;
+
+	/** Returns true, if given position (in map coordinates) is inside solid cell. */
+	bool isSolidAt(const vec2& position) const { return isSolid(getCellX(position.x), getCellY(position.y)); }
+
+	/** 
+	 * Returns true, if given area overlaps any solid cell. Area touching a cell only from outside does not overlap it, 
+	 * so object standing on floor does not overlap the floor.
+	 */
+	bool overlapsSolid(const vec2& topLeft, const vec2& bottomRight) const;
+
+	/**
+	 * Moves given area by delta and stops it at first solid cell on the way. Movement is resolved first along x axis 
+	 * and then along y axis, so objects slide along walls and floors. Solid cells, which area overlaps already, 
+	 * are ignored. Returns movement, which is possible. If hitNormal is given, normal of blocking cell sides is 
+	 * written to it: component is -1 or 1 for blocked axes and 0 for free axes.
+	 */
+	vec2 sweepAabb(const vec2& topLeft, const vec2& bottomRight, const vec2& delta, vec2* hitNormal = 0) const;
+
+	/** 
+	 * Casts ray from start to end through the grid. Returns true, if ray hits solid cell and writes information of
+	 * the first hit to hit, if it is given. Ray starting inside solid cell hits it at start.
+	 */
+	bool raycast(const vec2& start, const vec2& end, RaycastHit* hit = 0) const;
+
+	/** Returns true, if there are no solid cells between start and end. */
+	bool hasLineOfSight(const vec2& start, const vec2& end) const { return !raycast(start, end); }
+
+	/** 
+	 * Casts several rays. Hit of ray i is written to hits[i]. For rays, which do not hit anything, fraction is 1
+	 * and cellX and cellY are -1. Returns number of rays hitting solid cells.
+	 */
+	int raycast(const vec2* starts, const vec2* ends, int numRays, RaycastHit* hits) const;
+
+	/** 
+	 * Tests line of sight from one position to several targets, for example from player to each enemy.
+	 * visible[i] is set to 1, if targets[i] is visible, otherwise 0. Returns number of visible targets.
+	 */
+	int hasLineOfSight(const vec2& start, const vec2* targets, int numTargets, uint8_t* visible) const;
+
+	/** Tests line of sight for several pairs of positions. Returns number of visible pairs. */
+	int hasLineOfSight(const vec2* starts, const vec2* ends, int numRays, uint8_t* visible) const;
+
+	/**
+	 * Covers all solid cells with non-overlapping rectangles using greedy meshing: rectangles are grown first along
+	 * rows and then down while whole row below is solid. Result is usually far fewer rectangles than solid cells,
+	 * for example for making static collision shapes of the level.
+	 */
+	void getSolidRectangles(std::vector<CellRect>& rectangles) const;
+
+	/**
+	 * Traces outlines of solid areas to closed loops of cell corners (in map coordinates). Corners along straight 
+	 * sides are left out. Outer outlines go clockwise and outlines of holes counterclockwise on screen (y down).
+	 * Areas touching each other only diagonally get separate loops.
+	 */
+	void getSolidOutlines(std::vector< std::vector<vec2> >& outlines) const;
+
+private:
+	// Clips line from start to start+delta (in grid coordinates) to grid area. Returns false, if line is outside.
+	// entryNormal is set to normal of grid side, where line enters the grid, if it starts outside.
+	bool clipToGrid(const vec2& start, const vec2& delta, float& t0, float& t1, vec2& entryNormal) const;
+	bool isColumnSolid(int x, int y0, int y1) const;
+	bool isRowSolid(int y, int x0, int x1) const;
+	void notifyCellChanged(int x, int y, bool solid);
+
+	int							m_width;
+	int							m_height;
+	vec2						m_origin;
+	std::vector<uint8_t>		m_cells;
+	std::vector<ChangeListener*>	m_listeners;
+
+	// Hidden
+	TileGrid();
+	TileGrid(const TileGrid&);
+	TileGrid& operator=(const TileGrid&);
+};
+
+}
+
+#endif // TILE_GRID_H_
@@ -0,0 +1,286 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef TMX_READER_H_
+#define TMX_READER_H_
+
+#include <Stream.h>
+#include <Ref.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace yam2d
+{
+
+/**
+ * Class for TmxReader.
+ *
+ * Streaming pull-parser for TMX-formatted map files. Unlike tmx-parser, TmxReader does not build a DOM of
+ * the file: the file is read through a fixed size buffer and the XML is walked once. Each call to next 
+ * returns next event (map, tileset, layer, chunk of tiles or object), after which the data of the event 
+ * can be queried. Tile data (XML, CSV, base64 and zlib/gzip compressed base64) is decoded in chunks of 
+ * at most about chunkSize tiles, so peak memory does not depend on the layer size.
+ *
+ * Event order follows the file: EVENT_MAP first, then tilesets, then layers in file order. Each tile layer
+ * is followed by EVENT_TILES events containing its tiles in row major order, each object layer by 
+ * EVENT_OBJECT events. External tilesets (tsx-files) are read when the tileset is encountered.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class TmxReader
+{
+public:
+	typedef std::map<std::string, std::string> Properties;
+
+	enum Event
+	{
+		EVENT_MAP = 0,		// Map attributes and properties are available.
+		EVENT_TILESET,		// getTileset returns new tileset.
+		EVENT_TILE_LAYER,	// getLayer returns new tile layer.
+		EVENT_TILES,		// getTiles returns next chunk of tiles of current tile layer.
+		EVENT_OBJECT_LAYER,	// getLayer returns new object layer.
+		EVENT_OBJECT,		// getObject returns next object of current object layer.
+		EVENT_END,			// End of map.
+		EVENT_ERROR			// Parse error. getErrorText returns description.
+	};
+
+	enum Orientation
+	{
+		ORIENTATION_ORTHOGONAL = 0,
+		ORIENTATION_ISOMETRIC
+	};
+
+	struct Tileset
+	{
+		Tileset();
+
+		unsigned				firstGid;
+		std::string				name;
+		int						tileWidth;
+		int						tileHeight;
+		int						margin;
+		int						spacing;
+		int						tileOffsetX;
+		int						tileOffsetY;
+		std::string				imageSource;
+		std::string				imageTransparentColor;
+		int						imageWidth;
+		int						imageHeight;
+		Properties				properties;
+		std::map<unsigned, Properties> tileProperties;	// Properties of tiles which have properties, by tile id.
+	};
+
+	struct Layer
+	{
+		Layer();
+
+		std::string				name;
+		int						width;
+		int						height;
+		float					opacity;
+		bool					visible;
+		Properties				properties;
+	};
+
+	struct Object
+	{
+		Object();
+
+		std::string				name;
+		std::string				type;
+		float					x;
+		float					y;
+		float					width;
+		float					height;
+		float					rotation;
+		unsigned				gid;
+		bool					isPolygon;
+		bool					isPolyline;
+		bool					isEllipse;
+		Properties				properties;
+	};
+
+	/** Tile flags stored in the highest bits of global tile ids. */
+	static const unsigned FLIPPED_HORIZONTALLY_FLAG = 0x80000000;
+	static const unsigned FLIPPED_VERTICALLY_FLAG = 0x40000000;
+	static const unsigned FLIPPED_DIAGONALLY_FLAG = 0x20000000;
+	static const unsigned GID_MASK = 0x1fffffff;
+
+	/**
+	 * Creates new reader.
+	 * @param chunkSize		Preferred number of tiles in one EVENT_TILES chunk.
+	 */
+	TmxReader(int chunkSize = 4096);
+
+	~TmxReader();
+
+	/** Opens map file. Returns false, if file could not be opened. */
+	bool open(const std::string& fileName);
+
+	/** Reads the file until next event. */
+	Event next();
+
+	const std::string& getFileName() const { return m_fileName; }
+	const std::string& getErrorText() const { return m_errorText; }
+
+	// Map attributes. Valid after EVENT_MAP.
+	Orientation getOrientation() const { return m_orientation; }
+	int getWidth() const { return m_width; }
+	int getHeight() const { return m_height; }
+	int getTileWidth() const { return m_tileWidth; }
+	int getTileHeight() const { return m_tileHeight; }
+	const Properties& getProperties() const { return m_properties; }
+
+	/** Returns tileset of last EVENT_TILESET. */
+	const Tileset& getTileset() const { return m_tilesets.back(); }
+
+	/** Returns all tilesets read so far. */
+	const std::vector<Tileset>& getTilesets() const { return m_tilesets; }
+
+	/**
+	 * Returns tileset index of global tile id (flags are ignored) or -1, if gid does not belong to any tileset.
+	 * Gids up to the first gid of the last tileset are resolved through a lookup table.
+	 */
+	int findTilesetIndex(unsigned gid) const;
+
+	/** Returns layer of last EVENT_TILE_LAYER or EVENT_OBJECT_LAYER. */
+	const Layer& getLayer() const { return m_layer; }
+
+	/** Returns global tile ids (including flip flags) of last EVENT_TILES. */
+	const std::vector<uint32_t>& getTiles() const { return m_tiles; }
+
+	/** Returns index (y*layerWidth + x) of the first tile of last EVENT_TILES. */
+	int getTilesStartIndex() const { return m_tilesStartIndex; }
+
+	/** Returns object of last EVENT_OBJECT. */
+	const Object& getObject() const { return m_object; }
+
+private:
+	struct Attribute
+	{
+		std::string name;
+		std::string value;
+	};
+
+	enum Encoding
+	{
+		ENCODING_XML = 0,
+		ENCODING_CSV,
+		ENCODING_BASE64
+	};
+
+	enum Token
+	{
+		TOKEN_START = 0,
+		TOKEN_END,
+		TOKEN_EOF,
+		TOKEN_ERROR
+	};
+
+	bool fillBuffer();
+	int getChar();
+	int peekChar();
+	bool skipUntil(const char* terminator);
+	Token readTag();
+	bool readName(std::string& name);
+	void decodeEntities(std::string& value) const;
+
+	const char* getAttribute(const char* name) const;
+	int getIntAttribute(const char* name, int defaultValue) const;
+	float getFloatAttribute(const char* name, float defaultValue) const;
+
+	bool startElement();
+	bool endElement();
+	bool readTileData();
+	void readCsv();
+	bool readBase64Tiles();
+	int readBase64(uint8_t* output, int maxBytes);
+	int inflateData(uint8_t* output, int maxBytes);
+	void addGid(uint32_t gid);
+	void flushTiles();
+	void finishData();
+	bool readExternalTileset(const std::string& fileName, Tileset& tileset);
+	void updateTilesetTable();
+	void setError(const std::string& text);
+	void pushEvent(Event event) { m_events.push_back(event); }
+
+	std::string							m_fileName;
+	std::string							m_path;
+	Ref<Stream>							m_stream;
+	std::vector<char>					m_buffer;
+	int									m_bufferPos;
+	int									m_bufferEnd;
+	int									m_chunkSize;
+
+	// Current tag
+	std::string							m_tagName;
+	std::vector<Attribute>				m_attributes;
+	int									m_numAttributes;
+	bool								m_selfClosing;
+	std::vector<std::string>			m_elements;		// Open elements.
+	Properties*							m_currentProperties;
+	std::vector<Event>					m_events;		// Events waiting to be returned.
+	size_t								m_nextEvent;
+	int									m_finalEvent;	// EVENT_END or EVENT_ERROR, when reading has finished.
+	std::string							m_errorText;
+
+	// Map
+	Orientation							m_orientation;
+	int									m_width;
+	int									m_height;
+	int									m_tileWidth;
+	int									m_tileHeight;
+	Properties							m_properties;
+	bool								m_mapReported;
+	std::vector<Tileset>				m_tilesets;
+	std::vector<int>					m_tilesetTable;	// Tileset index by gid.
+	unsigned							m_currentTileId;
+	Layer								m_layer;
+	bool								m_objectLayerReported;
+	Object								m_object;
+
+	// Tile data
+	bool								m_inData;
+	Encoding							m_encoding;
+	bool								m_compressed;
+	void*								m_inflateStream;	// z_stream of compressed data.
+	bool								m_inflateOutputFull;	// Inflate may have more output without new input.
+	std::vector<uint8_t>				m_dataBytes;	// Decoded base64 bytes of compressed data.
+	std::vector<uint32_t>				m_tiles;
+	int									m_tilesStartIndex;
+	int									m_numTiles;		// Tiles of current layer decoded so far.
+	uint32_t							m_value;		// CSV value or raw bytes of partial gid.
+	int									m_valueBytes;	// Number of CSV digits or gid bytes in m_value.
+	uint32_t							m_base64Bits;
+	int									m_base64NumBits;
+
+	// Hidden
+	TmxReader(const TmxReader&);
+	TmxReader& operator=(const TmxReader&);
+};
+
+}
+
+#endif // TMX_READER_H_
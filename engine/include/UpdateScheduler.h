@@ -0,0 +1,192 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef UPDATE_SCHEDULER_H_
+#define UPDATE_SCHEDULER_H_
+
+#include <Object.h>
+#include <Ref.h>
+#include <GameObject.h>
+#include <JobSystem.h>
+#include <CommandBuffer.h>
+#include <vec2.h>
+#include <vector>
+
+namespace yam2d
+{
+
+class Map;
+class Layer;
+class Camera;
+
+/**
+ * Interface for components, which may be updated less often when far away. Update schedulers pass LodUpdatable
+ * components the time elapsed since their previous update, which can be several frames. Components, which 
+ * implement plain Updatable, are updated every frame, so gameplay critical components are never delayed.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class LodUpdatable : public virtual Updatable
+{
+};
+
+/**
+ * Interface for components, which can be updated in parallel with other game objects. Update of ParallelUpdatable
+ * component may read other game objects, but may modify only its own game object. Queries of the layer broadphase
+ * return extents of game objects from before the parallel update, because moves are applied to the broadphase
+ * after all components have been updated. Structural changes, like 
+ * adding and deleting game objects, must be recorded to command buffer returned by Map::getCommandBuffer.
+ * Reference counts are not thread safe, so new game objects and components are created with
+ * CommandBuffer::Function, when commands are applied.
+ * Component can implement both ParallelUpdatable and LodUpdatable.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class ParallelUpdatable : public virtual Updatable
+{
+};
+
+/**
+ * Class for UpdateScheduler.
+ *
+ * UpdateScheduler updates far away game objects less often. Game objects are put into frequency bands by their 
+ * distance to the map camera and to points of interest, whichever is nearest. Objects of a band with interval N 
+ * are updated every Nth frame and get the time accumulated since their previous update. Objects of a band take 
+ * turns by a phase, which each game object gets when it is scheduled first time, so work of far bands is spread 
+ * evenly over frames instead of all of them updating on the same frame. Adding and deleting game objects does not
+ * change turns of other game objects, so objects staying in a band are updated exactly every Nth frame.
+ *
+ * Only components implementing LodUpdatable are scheduled. Other Updatable components of the same game object
+ * are updated every frame. Objects nearer than the first band are updated every frame.
+ *
+ * Components implementing ParallelUpdatable are updated after other components of the layer, with the job system
+ * if it has been set. Components of one game object are updated in the same thread in their order. Updates of 
+ * the layer broadphase are deferred meanwhile, and game objects moved by the components are updated to it in 
+ * order of the game objects afterwards. Command buffers of all threads are applied at the end of Map::update in 
+ * order of the game objects, so results do not depend on number of threads.
+ *
+ * Set scheduler to map with Map::setUpdateScheduler.
+ *
+ * @ingroup yam2d
+ * @author Mikko Romppainen (mikko@kajakbros.com)
+ */
+class UpdateScheduler : public Object
+{
+public:
+	UpdateScheduler();
+
+	virtual ~UpdateScheduler();
+
+	/** 
+	 * Adds band: objects at least minDistance (in tiles) away are updated every interval frames, unless a band 
+	 * with bigger minDistance applies.
+	 */
+	void addBand(float minDistance, int interval);
+
+	/** Removes all bands, so all objects are updated every frame. */
+	void clearBands();
+
+	int getNumBands() const { return (int)m_bands.size(); }
+
+	/** Adds game object, near which objects are updated more often. Map camera is used in addition, if enabled. */
+	void addPointOfInterest(GameObject* gameObject);
+
+	void removePointOfInterest(GameObject* gameObject);
+
+	/** Sets, if distance to map camera is used. Enabled by default. */
+	void setUseCamera(bool useCamera) { m_useCamera = useCamera; }
+
+	bool getUseCamera() const { return m_useCamera; }
+
+	/** Called by Map before updating layers: takes positions of camera and points of interest for this frame. */
+	void beginFrame(Camera* camera);
+
+	/** Updates game objects of the layer. */
+	void updateLayer(Layer* layer, float deltaTime);
+
+	/** Sets job system for updating ParallelUpdatable components. Set 0 to update them in calling thread. */
+	void setJobSystem(JobSystem* jobSystem);
+
+	JobSystem* getJobSystem() const { return m_jobSystem.ptr(); }
+
+	/** Returns command buffer of calling thread. */
+	CommandBuffer* getCommandBuffer();
+
+	/** Called by Map at the end of update: applies commands of all threads to the map. */
+	void applyCommands(Map* map);
+
+	/** Returns number of game objects, whose LodUpdatable components were updated on the last frame. */
+	int getNumUpdated() const { return m_numUpdated; }
+
+	/** Returns number of game objects, whose LodUpdatable components were delayed on the last frame. */
+	int getNumDelayed() const { return m_numDelayed; }
+
+private:
+	struct Band
+	{
+		float			minDistanceSquared;
+		int				interval;
+	};
+
+	struct ParallelComponent
+	{
+		Updatable*		component;
+		float			deltaTime;
+	};
+
+	// ParallelUpdatable components of one game object.
+	struct ParallelTask
+	{
+		GameObject*		gameObject;
+		unsigned		sortKey;
+		int				firstComponent;
+		int				numComponents;
+	};
+
+	class ParallelUpdate;
+	friend class ParallelUpdate;
+
+	int getInterval(const vec2& position) const;
+	void runParallelTasks(int begin, int end);
+
+	std::vector<Band>				m_bands;
+	std::vector< Ref<GameObject> >	m_pointsOfInterest;
+	std::vector<vec2>				m_positions;
+	std::vector<Updatable*>			m_components;
+	std::vector<LodUpdatable*>		m_lodComponents;
+	std::vector<ParallelComponent>	m_parallelComponents;
+	std::vector<ParallelTask>		m_parallelTasks;
+	Ref<JobSystem>					m_jobSystem;
+	std::vector< Ref<CommandBuffer> > m_commandBuffers;
+	unsigned						m_numObjects; // Game objects updated on this frame so far.
+	bool							m_useCamera;
+	unsigned						m_frameIndex;
+	unsigned						m_lastLodPhase;
+	int								m_numUpdated;
+	int								m_numDelayed;
+};
+
+}
+
+#endif // UPDATE_SCHEDULER_H_
@@ -25,7 +25,14 @@
 
 // Memory leak debugging on object.cpp
 
+// Memory tracking of Objects by type, see MemoryStats.h. Adds links of live objects list to each Object and records 
+// sizes of allocated Objects, so it is not enabled by default. Counts and bytes by subsystem are always accounted. 
+// MEMORY_LEAK_DEBUGGING logs leaked objects by type.
+//#define MEMORY_TRACKING
 //#define MEMORY_LEAK_DEBUGGING
+#if defined(MEMORY_LEAK_DEBUGGING) && !defined(MEMORY_TRACKING)
+#define MEMORY_TRACKING
+#endif
 #define SHOW_LEAKS
 //#define ASSERT_ON_LEAKS
 
@@ -37,6 +44,16 @@
 #define YAM_WRITING_LOGS_TO_FILE "debug_log.txt"
 #endif
 
+// YAM2D_LOG messages below this level are removed from the build, see Logger.h. 0=debug, 1=info, 2=warning, 3=error.
+#if defined(DEBUG_LOGS_ENABLED)
+#define YAM2D_LOG_MIN_LEVEL 0
+#else
+#define YAM2D_LOG_MIN_LEVEL 1
+#endif
+
+// Profiling zones, see Profiler.h. Zones are cheap enough to be left on in release builds. Comment out to remove them.
+#define YAM2D_PROFILING_ENABLED
+
 #if defined(_WIN32)
 // If you disable this flag, then ElapsetTimer uses QueryPerformanceCounter.
 //#define ELAPSED_TIMER_USES_GETTICCOUNT
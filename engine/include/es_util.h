@@ -34,6 +34,7 @@
 
 #include <vector>
 #include <string>
+#include <string.h>
 
 #if defined(ANDROID)
 struct android_app;
@@ -44,13 +45,17 @@ extern "C" void app_dummy();
 #define YAM2D_START app_dummy();
 #endif
 
-#if defined(_WIN32)
+#if defined(_WIN32) || defined(YAM2D_LINUX)
 #define YAM2D_START
 #endif
 
 namespace yam2d
 {
 
+class ElapsedTimer;
+class InputRecorder;
+class InputPlayback;
+
 /**
  * Flags for creating window isong esCreateWindow function. Flags can be combined
  * either using or operator '|' or '+' sign.
@@ -105,12 +110,23 @@ struct ESContext
 
 	bool quitFlag;
 
+	/// Fixed timestep loop, see esSetFixedTimestep and esSetTargetFrameRate. Zero means not in use.
+	float fixedTimeStep;
+	int maxUpdatesPerFrame;
+	float targetFrameTime;
+	float updateAccumulator;
+	float interpolationAlpha;
+	float sleepMargin;
+
 	/// Callbacks
 	bool (*initFunc) ( ESContext* );
 	void (*drawFunc) ( ESContext* );
 	void (*updateFunc) ( ESContext*, float deltaTime );
 	void (*deinitFunc) ( ESContext* );
 	void (*touchEventFunc) ( ESContext*, TouchEventType type, int touchId, int x, int y );
+
+	/// Input recording, see esStartInputRecording. Zero when not recording.
+	InputRecorder* inputRecorder;
 #if defined(_WIN32)
 	/// Window handle
 	EGLNativeWindowType  hWnd;
@@ -120,6 +136,11 @@ struct ESContext
     const ASensor* accelerometerSensor;
 	GLint windowCreateFlags;
     ASensorEventQueue* sensorEventQueue;
+#elif defined(YAM2D_LINUX)
+	/// Headless main loop returns after this many frames, see linuxSetMaxFrames. Zero runs until esQuitApp.
+	int maxFrames;
+	/// Input replay, see linuxSetInputReplay. Zero when not replaying.
+	InputPlayback* inputReplay;
 #endif
 
 };
@@ -172,6 +193,63 @@ void esMainLoop ( ESContext *esContext );
  */
 void esQuitApp(ESContext *esContext);
 
+/**
+ * Sets main loop to call update function with fixed time step. Frame time is collected to an accumulator and
+ * update is called as many times as whole steps fit in it, so simulation does not depend on frame rate. Slow
+ * frames are caught up with at most maxUpdatesPerFrame updates and time beyond that is dropped, so that
+ * falling behind does not make following frames even slower. Frames, where no step fits, call only draw.
+ * Use esGetInterpolationAlpha in draw for interpolating between the last two updates, for example by passing
+ * it to Map::setInterpolationAlpha before Map::render.
+ *
+ * @param esContext Application context
+ * @param timeStep Length of update step in seconds, for example 1.0f/60.0f. Zero restores variable time step.
+ * @param maxUpdatesPerFrame Maximum number of updates in one frame.
+ */
+void esSetFixedTimestep(ESContext *esContext, float timeStep, int maxUpdatesPerFrame = 5);
+
+/**
+ * Sets frame rate, which main loop does not exceed. Rest of each frame is slept and the last moments are 
+ * waited by yielding, so frame rate is hit precisely also when vsync is off.
+ *
+ * @param esContext Application context
+ * @param framesPerSecond Target frame rate. Zero removes the limit.
+ */
+void esSetTargetFrameRate(ESContext *esContext, float framesPerSecond);
+
+/**
+ * Returns fraction of the next fixed time step, which has elapsed, between 0 and 1. Returns 1, when fixed 
+ * time step is not in use.
+ */
+float esGetInterpolationAlpha(const ESContext *esContext);
+
+/**
+ * Called by platform main loops: calls update function for elapsed frame time, either once or with fixed 
+ * time steps. Returns number of update calls.
+ */
+int esRunUpdates(ESContext *esContext, float deltaTime);
+
+/**
+ * Starts recording input state and frame time of each frame of the main loop to binary file, see InputRecorder. 
+ * Frames are recorded, when the main loop runs updates, so recording can be replayed with the same input and 
+ * time steps, for example with linuxSetInputReplay on headless Linux platform.
+ *
+ * @param esContext Application context
+ * @param fileName Name of the recording file to create.
+ *
+ * @return True if recording file was created.
+ */
+bool esStartInputRecording(ESContext *esContext, const char* fileName);
+
+/**
+ * Stops input recording and closes the recording file. Main loops call this when they return.
+ */
+void esStopInputRecording(ESContext *esContext);
+
+/**
+ * Called by platform main loops after draw: waits until target frame time has elapsed since frameTimer was reset.
+ */
+void esLimitFrameRate(ESContext *esContext, const ElapsedTimer& frameTimer);
+
 /**
  * Register a init callback function to be used to init the game.
  *
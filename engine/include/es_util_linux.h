@@ -0,0 +1,109 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#ifndef ESUTIL_LINUX_H_
+#define ESUTIL_LINUX_H_
+
+#include <es_util.h>
+#include <Input.h>
+
+namespace yam2d
+{
+
+/*
+ * Headless Linux platform for running benchmarks and tests on build servers. Build with YAM2D_LINUX defined,
+ * see build/linux/Makefile.
+ *
+ * esCreateWindow does not open a window and GL and EGL calls go to a null backend, which only counts them.
+ * So update, batching and loading can be run and measured without GPU or display. esMainLoop runs frames 
+ * like the other platforms until esQuitApp is called or the number of frames set with linuxSetMaxFrames 
+ * has been run. Input comes only from the functions below.
+ */
+
+/**
+ * Sets number of frames, after which esMainLoop returns. Zero, which is the default, runs until esQuitApp.
+ */
+void linuxSetMaxFrames( ESContext *esContext, int maxFrames );
+
+/**
+ * Replays input recorded with esStartInputRecording. Each frame of esMainLoop sets input state of the next recorded
+ * frame with the functions below and runs updates with its recorded frame time instead of the clock, so the session 
+ * updates like it did when it was recorded, if the application starts from the same state. Frame rate limit is not 
+ * applied and esMainLoop returns after the last recorded frame. 
+ *
+ * Time of update and draw of each frame is kept, see linuxGetReplayFrameTimes, and summary is logged at the end. 
+ * If timingFileName is given, frame times are also written to it as CSV.
+ *
+ * @return True if recording could be opened.
+ */
+bool linuxSetInputReplay( ESContext *esContext, const char* fileName, const char* timingFileName = 0 );
+
+/**
+ * Returns time of update and draw in milliseconds of each frame of the last input replay.
+ */
+const std::vector<float>& linuxGetReplayFrameTimes();
+
+/**
+ * Sets state of a key. Key is seen as pressed or released by Input.h functions during the next update.
+ */
+void keyState( KeyCodes keyCode, bool down );
+
+/**
+ * Sets mouse state.
+ */
+void mouseState( bool leftClicked, bool rightClicked, bool middleClicked, int mouseX, int mouseY );
+void clearInput();
+void mouseWheel( int mouseWheel );
+void touchEventFunc( ESContext* esContext, TouchEventType type, int touchId, int x, int y );
+
+/**
+ * Counters of the null GL backend since the last call to nullGLResetStats.
+ */
+struct NullGLStats
+{
+	/// glDrawArrays and glDrawElements calls.
+	int numDrawCalls;
+	/// Vertices or indices given to draw calls.
+	int numVertices;
+	/// Calls, which changed GL state. Matrix operations and array pointers are always counted as changes.
+	int numStateChanges;
+	/// Calls, which set state to the value it already had.
+	int numRedundantStateChanges;
+	/// glBindTexture calls, which changed the bound texture.
+	int numTextureBinds;
+	/// glTexImage2D, glTexSubImage2D and glCompressedTexImage2D calls and bytes given to them.
+	int numTextureUploads;
+	int numTextureBytes;
+	int numClears;
+	/// eglSwapBuffers calls.
+	int numSwaps;
+};
+
+/** Returns counters of null GL backend. */
+const NullGLStats& nullGLGetStats();
+
+/** Zeroes counters of null GL backend. State, which calls are compared against, is kept. */
+void nullGLResetStats();
+
+}
+
+#endif // ESUTIL_LINUX_H_
@@ -24,7 +24,7 @@
 #define VEC2_H_
 
 //#include <Box2D/Common/b2Math.h>
-#include <slm\slmath.h>
+#include <slm/slmath.h>
 
 namespace yam2d
 {
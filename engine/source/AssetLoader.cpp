@@ -0,0 +1,726 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "AssetLoader.h"
+#include "TextureConverter.h"
+#include "PropertySet.h"
+#include "ElapsedTimer.h"
+#include "es_util.h"
+#include <Logger.h>
+#include <es_assert.h>
+#include "TmxReader.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdint.h>
+
+namespace yam2d
+{
+
+/** Request processed by AssetLoader. Jobs are created and deleted only on the main thread. */
+struct AssetJob
+{
+	enum Type
+	{
+		TYPE_TEXTURE = 0,
+		TYPE_MAP
+	};
+
+	enum State
+	{
+		JOB_QUEUED = 0,
+		JOB_DECODING,
+		JOB_DONE
+	};
+
+	struct TilesetImage
+	{
+		std::string fileName;
+		std::string transparentColor;
+		Texture::Format format;
+		bool dither;
+	};
+
+	AssetJob(Type t, AssetHandle* h)
+		: type(t)
+		, state(JOB_QUEUED)
+		, cancelled(false)
+		, failed(false)
+		, priority(h->getPriority())
+		, sequence(0)
+		, fileName(h->getFileName())
+		, handle(h)
+		, format(Texture::FORMAT_DEFAULT)
+		, dither(false)
+		, hasTransparentColor(false)
+		, width(0)
+		, height(0)
+		, bpp(0)
+	{
+		transparentColor[0] = transparentColor[1] = transparentColor[2] = 0;
+	}
+
+	Type					type;
+	State					state;
+	bool					cancelled;
+	bool					failed;
+	int						priority;
+	unsigned				sequence;
+	std::string				fileName;
+	Ref<AssetHandle>		handle;		// Touched only on the main thread.
+
+	// Texture
+	Texture::Format			format;
+	bool					dither;
+	bool					hasTransparentColor;
+	uint8_t					transparentColor[3];
+	int						width;
+	int						height;
+	int						bpp;
+	std::vector<uint8_t>	pixels;
+
+	// Map
+	std::vector<TilesetImage> tilesets;
+};
+
+
+/** Loader thread of AssetLoader. */
+class AssetLoaderThread : public Thread
+{
+public:
+	AssetLoaderThread(AssetLoader* loader)
+		: Thread()
+		, m_loader(loader)
+	{
+	}
+
+	virtual ~AssetLoaderThread()
+	{
+	}
+
+protected:
+	virtual void run()
+	{
+		m_loader->runWorker();
+	}
+
+private:
+	AssetLoader* m_loader;
+};
+
+
+namespace
+{
+	// Heap ordering: highest priority first, earlier requests first within same priority.
+	bool isLowerPriority(const AssetJob* a, const AssetJob* b)
+	{
+		if( a->priority != b->priority )
+		{
+			return a->priority < b->priority;
+		}
+		return a->sequence > b->sequence;
+	}
+
+	// Returns transparent color given as hex string ("ff00ff") as RGB, or -1 for empty string.
+	int parseTransparentColor(const std::string& transparentColor)
+	{
+		if( transparentColor.length() == 0 )
+		{
+			return -1;
+		}
+
+		int color(0);
+#if defined(_WIN32)
+		sscanf_s( transparentColor.c_str(), "%X", &color );
+#else
+		sscanf( transparentColor.c_str(), "%X", &color );
+#endif
+		return color & 0xffffff;
+	}
+}
+
+
+AssetHandle::AssetHandle(AssetLoader* loader, const std::string& fileName, int priority)
+: Object()
+, m_loader(loader)
+, m_job(0)
+, m_state(STATE_LOADING)
+, m_fileName(fileName)
+, m_priority(priority)
+, m_numRequests(1)
+, m_dependenciesCancelled(false)
+, m_texture()
+, m_dependencies()
+{
+}
+
+
+AssetHandle::~AssetHandle()
+{
+	assert( m_job == 0 );
+}
+
+
+bool AssetHandle::isReady() const
+{
+	if( m_state != STATE_READY )
+	{
+		return false;
+	}
+
+	for( size_t i=0; i<m_dependencies.size(); ++i )
+	{
+		if( !m_dependencies[i]->isReady() )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool AssetHandle::isDone() const
+{
+	if( m_state == STATE_LOADING )
+	{
+		return false;
+	}
+
+	for( size_t i=0; i<m_dependencies.size(); ++i )
+	{
+		if( !m_dependencies[i]->isDone() )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void AssetHandle::cancel()
+{
+	// Loader may release its references to this handle.
+	Ref<AssetHandle> self = this;
+	if( m_state == STATE_LOADING && m_loader != 0 )
+	{
+		assert( m_numRequests > 0 );
+		if( --m_numRequests == 0 )
+		{
+			m_loader->cancel(this);
+		}
+	}
+
+	// Dependencies were requested once by this handle, so their requests are withdrawn only once.
+	if( !m_dependenciesCancelled )
+	{
+		m_dependenciesCancelled = true;
+		for( size_t i=0; i<m_dependencies.size(); ++i )
+		{
+			m_dependencies[i]->cancel();
+		}
+	}
+}
+
+
+bool AssetLoader::TextureKey::operator<(const TextureKey& other) const
+{
+	if( fileName != other.fileName )
+	{
+		return fileName < other.fileName;
+	}
+	if( format != other.format )
+	{
+		return format < other.format;
+	}
+	if( dither != other.dither )
+	{
+		return !dither;
+	}
+	return transparentColor < other.transparentColor;
+}
+
+
+AssetLoader::AssetLoader(int numThreads)
+: Object()
+, m_mutex()
+, m_workAvailable()
+, m_jobDone()
+, m_stopping(false)
+, m_nextSequence(0)
+, m_numPending(0)
+, m_queue()
+, m_decoded()
+, m_threads()
+, m_textures()
+{
+	if( numThreads <= 0 )
+	{
+		numThreads = Thread::getNumProcessors() - 1;
+		if( numThreads < 1 )
+		{
+			numThreads = 1;
+		}
+	}
+
+	for( int i=0; i<numThreads; ++i )
+	{
+		Ref<AssetLoaderThread> thread = new AssetLoaderThread(this);
+		if( !thread->start() )
+		{
+			YAM2D_LOG_WARNING(Logger::CATEGORY_ENGINE, "[%s] Could not start loader thread %d", __FUNCTION__, i);
+			break;
+		}
+		m_threads.push_back(thread);
+	}
+}
+
+
+AssetLoader::~AssetLoader()
+{
+	{
+		ScopedLock lock(m_mutex);
+		m_stopping = true;
+		m_workAvailable.broadcast();
+	}
+
+	for( size_t i=0; i<m_threads.size(); ++i )
+	{
+		m_threads[i]->join();
+	}
+	m_threads.clear();
+
+	// Cancel all unfinished requests.
+	std::vector<AssetJob*> jobs = m_queue;
+	jobs.insert(jobs.end(), m_decoded.begin(), m_decoded.end());
+	m_queue.clear();
+	m_decoded.clear();
+	for( size_t i=0; i<jobs.size(); ++i )
+	{
+		jobs[i]->cancelled = true;
+		complete(jobs[i]);
+	}
+}
+
+
+AssetHandle* AssetLoader::loadTexture(const std::string& fileName, int priority, Texture::Format format, bool dither, const std::string& transparentColor)
+{
+	TextureKey key;
+	key.fileName = fileName;
+	key.format = int(format);
+	key.dither = dither;
+	key.transparentColor = parseTransparentColor(transparentColor);
+
+	TextureCache::iterator it = m_textures.find(key);
+	if( it != m_textures.end() )
+	{
+		AssetHandle* handle = it->second.ptr();
+		++handle->m_numRequests;
+		if( priority > handle->m_priority )
+		{
+			// Raise priority of already requested texture.
+			handle->m_priority = priority;
+			if( handle->m_job != 0 )
+			{
+				ScopedLock lock(m_mutex);
+				handle->m_job->priority = priority;
+				if( handle->m_job->state == AssetJob::JOB_QUEUED )
+				{
+					std::make_heap(m_queue.begin(), m_queue.end(), isLowerPriority);
+				}
+			}
+		}
+		return handle;
+	}
+
+	AssetHandle* handle = new AssetHandle(this, fileName, priority);
+	m_textures[key] = handle;
+
+	AssetJob* job = new AssetJob(AssetJob::TYPE_TEXTURE, handle);
+	job->format = format;
+	job->dither = dither;
+	if( key.transparentColor >= 0 )
+	{
+		const int color = key.transparentColor;
+		job->hasTransparentColor = true;
+		job->transparentColor[0] = (uint8_t)((color&0xff0000) >> 16);
+		job->transparentColor[1] = (uint8_t)((color&0xff00) >> 8);
+		job->transparentColor[2] = (uint8_t)((color&0xff) >> 0);
+	}
+
+	enqueue(job);
+	return handle;
+}
+
+
+AssetHandle* AssetLoader::prefetchMapTilesets(const std::string& mapFileName, int priority)
+{
+	AssetHandle* handle = new AssetHandle(this, mapFileName, priority);
+	enqueue(new AssetJob(AssetJob::TYPE_MAP, handle));
+	return handle;
+}
+
+
+int AssetLoader::update(float maxMilliseconds)
+{
+	ElapsedTimer timer;
+	timer.reset();
+
+	int numProcessed = 0;
+	while( true )
+	{
+		AssetJob* job = 0;
+		{
+			ScopedLock lock(m_mutex);
+			if( m_decoded.empty() )
+			{
+				break;
+			}
+
+			// Upload highest priority first.
+			size_t best = 0;
+			for( size_t i=1; i<m_decoded.size(); ++i )
+			{
+				if( isLowerPriority(m_decoded[best], m_decoded[i]) )
+				{
+					best = i;
+				}
+			}
+			job = m_decoded[best];
+			m_decoded.erase(m_decoded.begin() + best);
+		}
+
+		complete(job);
+		++numProcessed;
+
+		if( timer.getTime()*1000.0f >= maxMilliseconds )
+		{
+			break;
+		}
+	}
+
+	return numProcessed;
+}
+
+
+void AssetLoader::finish(AssetHandle* handle)
+{
+	AssetJob* job = handle->m_job;
+	if( job != 0 )
+	{
+		bool decodeHere = false;
+		{
+			ScopedLock lock(m_mutex);
+			if( job->state == AssetJob::JOB_QUEUED )
+			{
+				// Not yet picked by loader threads, so decode on this thread.
+				removeFromQueue(job);
+				job->state = AssetJob::JOB_DECODING;
+				decodeHere = true;
+			}
+			else
+			{
+				while( job->state != AssetJob::JOB_DONE )
+				{
+					m_jobDone.wait(m_mutex);
+				}
+				m_decoded.erase(std::find(m_decoded.begin(), m_decoded.end(), job));
+			}
+		}
+
+		if( decodeHere )
+		{
+			decode(job);
+			ScopedLock lock(m_mutex);
+			job->state = AssetJob::JOB_DONE;
+			--m_numPending;
+		}
+
+		complete(job);
+	}
+
+	for( size_t i=0; i<handle->m_dependencies.size(); ++i )
+	{
+		finish(handle->m_dependencies[i].ptr());
+	}
+}
+
+
+void AssetLoader::release(const std::string& fileName)
+{
+	TextureCache::iterator it = m_textures.begin();
+	while( it != m_textures.end() )
+	{
+		if( it->first.fileName == fileName )
+		{
+			m_textures.erase(it++);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+
+void AssetLoader::clearCache()
+{
+	m_textures.clear();
+}
+
+
+int AssetLoader::getNumPending() const
+{
+	ScopedLock lock(m_mutex);
+	return m_numPending;
+}
+
+
+int AssetLoader::getNumDecoded() const
+{
+	ScopedLock lock(m_mutex);
+	return (int)m_decoded.size();
+}
+
+
+void AssetLoader::enqueue(AssetJob* job)
+{
+	job->handle->m_job = job;
+
+	ScopedLock lock(m_mutex);
+	job->sequence = m_nextSequence++;
+	m_queue.push_back(job);
+	std::push_heap(m_queue.begin(), m_queue.end(), isLowerPriority);
+	++m_numPending;
+	m_workAvailable.signal();
+}
+
+
+void AssetLoader::cancel(AssetHandle* handle)
+{
+	AssetJob* job = handle->m_job;
+	assert( job != 0 );
+
+	bool removed = false;
+	{
+		ScopedLock lock(m_mutex);
+		job->cancelled = true;
+		if( job->state == AssetJob::JOB_QUEUED )
+		{
+			removed = removeFromQueue(job);
+			job->state = AssetJob::JOB_DONE;
+			--m_numPending;
+		}
+	}
+
+	// Job being decoded is completed as cancelled in update.
+	handle->m_state = AssetHandle::STATE_CANCELLED;
+	removeFromCache(handle);
+
+	if( removed )
+	{
+		complete(job);
+	}
+}
+
+
+void AssetLoader::runWorker()
+{
+	while( true )
+	{
+		AssetJob* job = 0;
+		{
+			ScopedLock lock(m_mutex);
+			while( !m_stopping && m_queue.empty() )
+			{
+				m_workAvailable.wait(m_mutex);
+			}
+
+			if( m_stopping )
+			{
+				return;
+			}
+
+			std::pop_heap(m_queue.begin(), m_queue.end(), isLowerPriority);
+			job = m_queue.back();
+			m_queue.pop_back();
+			job->state = AssetJob::JOB_DECODING;
+		}
+
+		decode(job);
+
+		{
+			ScopedLock lock(m_mutex);
+			job->state = AssetJob::JOB_DONE;
+			--m_numPending;
+			m_decoded.push_back(job);
+			m_jobDone.broadcast();
+		}
+	}
+}
+
+
+void AssetLoader::complete(AssetJob* job)
+{
+	AssetHandle* handle = job->handle.ptr();
+	handle->m_job = 0;
+	handle->m_loader = 0;
+
+	if( job->cancelled )
+	{
+		handle->m_state = AssetHandle::STATE_CANCELLED;
+	}
+	else if( job->failed )
+	{
+		handle->m_state = AssetHandle::STATE_FAILED;
+	}
+	else if( job->type == AssetJob::TYPE_TEXTURE )
+	{
+		handle->m_texture = new Texture(&job->pixels[0], job->width, job->height, job->bpp, job->format, job->dither, job->hasTransparentColor);
+		handle->m_state = AssetHandle::STATE_READY;
+	}
+	else
+	{
+		for( size_t i=0; i<job->tilesets.size(); ++i )
+		{
+			const AssetJob::TilesetImage& image = job->tilesets[i];
+			handle->m_dependencies.push_back(loadTexture(image.fileName, handle->m_priority, image.format, image.dither, image.transparentColor));
+		}
+		handle->m_state = AssetHandle::STATE_READY;
+	}
+
+	if( handle->m_state != AssetHandle::STATE_READY )
+	{
+		// Allow requesting again later.
+		removeFromCache(handle);
+	}
+
+	delete job;
+}
+
+
+bool AssetLoader::removeFromQueue(AssetJob* job)
+{
+	std::vector<AssetJob*>::iterator it = std::find(m_queue.begin(), m_queue.end(), job);
+	if( it == m_queue.end() )
+	{
+		return false;
+	}
+
+	m_queue.erase(it);
+	std::make_heap(m_queue.begin(), m_queue.end(), isLowerPriority);
+	return true;
+}
+
+
+void AssetLoader::removeFromCache(AssetHandle* handle)
+{
+	for( TextureCache::iterator it = m_textures.begin(); it != m_textures.end(); ++it )
+	{
+		if( it->second.ptr() == handle )
+		{
+			m_textures.erase(it);
+			return;
+		}
+	}
+}
+
+
+void AssetLoader::decode(AssetJob* job)
+{
+	// Called from loader threads. esLogEngineError throws, which is caught here and the job marked as failed.
+	try
+	{
+		if( job->type == AssetJob::TYPE_TEXTURE )
+		{
+			if( !esLoadPNG(job->fileName.c_str(), 0, &job->width, &job->height, &job->bpp) || job->width*job->height <= 0 )
+			{
+				job->failed = true;
+				return;
+			}
+
+			job->pixels.resize(job->width*job->height*job->bpp);
+			if( !esLoadPNG(job->fileName.c_str(), &job->pixels[0], &job->width, &job->height, &job->bpp) )
+			{
+				job->failed = true;
+				return;
+			}
+
+			if( job->hasTransparentColor )
+			{
+				const uint8_t* c = job->transparentColor;
+				if( job->bpp == 4 )
+				{
+					applyTransparentColor(&job->pixels[0], job->width, job->height, job->bpp, c[0], c[1], c[2], &job->pixels[0]);
+				}
+				else
+				{
+					std::vector<uint8_t> rgba(job->width*job->height*4);
+					applyTransparentColor(&job->pixels[0], job->width, job->height, job->bpp, c[0], c[1], c[2], &rgba[0]);
+					job->pixels.swap(rgba);
+					job->bpp = 4;
+				}
+			}
+		}
+		else
+		{
+			// Tilesets are before layers in TMX files, so the file is read only until the first layer.
+			TmxReader reader;
+			if( !reader.open(job->fileName) )
+			{
+				job->failed = true;
+				return;
+			}
+
+			std::string path = getPath(job->fileName);
+			TmxReader::Event event = reader.next();
+			while( event == TmxReader::EVENT_MAP || event == TmxReader::EVENT_TILESET )
+			{
+				if( event == TmxReader::EVENT_TILESET )
+				{
+					const TmxReader::Tileset& tileset = reader.getTileset();
+					PropertySet properties;
+					properties.setValues(tileset.properties);
+
+					AssetJob::TilesetImage image;
+					image.fileName = path + tileset.imageSource;
+					image.transparentColor = tileset.imageTransparentColor;
+					image.format = Texture::getFormatFromString(properties.getOrDefault<std::string>("textureFormat", ""));
+					image.dither = properties.getOrDefault<bool>("textureDither", false);
+					job->tilesets.push_back(image);
+				}
+				event = reader.next();
+			}
+
+			if( event == TmxReader::EVENT_ERROR )
+			{
+				YAM2D_LOG_WARNING(Logger::CATEGORY_ASSETS, "[%s] Map file %s could not be parsed: %s", __FUNCTION__, job->fileName.c_str(), reader.getErrorText().c_str());
+				job->failed = true;
+				return;
+			}
+		}
+	}
+	catch( const std::string& )
+	{
+		job->failed = true;
+	}
+}
+
+}
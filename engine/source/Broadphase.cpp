@@ -0,0 +1,105 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "Broadphase.h"
+#include "GameObject.h"
+
+namespace yam2d
+{
+
+Broadphase::Broadphase()
+: Object()
+, m_numGameObjects(0)
+, m_deferUpdates(false)
+{
+}
+
+
+Broadphase::~Broadphase()
+{
+	assert( m_numGameObjects == 0 ); // Derived class must call clear in its destructor.
+}
+
+
+void Broadphase::addGameObject(GameObject* gameObject)
+{
+	assert( gameObject != 0 );
+	assert( gameObject->m_broadphase == 0 ); // Game object can be only in one broadphase at a time.
+	gameObject->m_broadphaseProxy = createProxy(gameObject, vec2(gameObject->getLeft(), gameObject->getTop()), vec2(gameObject->getRight(), gameObject->getBottom()));
+	gameObject->m_broadphase = this;
+	gameObject->m_broadphaseMoved = false;
+	++m_numGameObjects;
+}
+
+
+void Broadphase::removeGameObject(GameObject* gameObject)
+{
+	assert( gameObject != 0 );
+	assert( gameObject->m_broadphase == this );
+	destroyProxy(gameObject->m_broadphaseProxy);
+	detachGameObject(gameObject);
+}
+
+
+void Broadphase::updateGameObject(GameObject* gameObject)
+{
+	assert( gameObject != 0 );
+	assert( gameObject->m_broadphase == this );
+	if( m_deferUpdates )
+	{
+		// Game object is updated only by its own thread, so marking does not race with other threads.
+		gameObject->m_broadphaseMoved = true;
+		return;
+	}
+
+	moveProxy(gameObject->m_broadphaseProxy, vec2(gameObject->getLeft(), gameObject->getTop()), vec2(gameObject->getRight(), gameObject->getBottom()));
+}
+
+
+void Broadphase::flushGameObject(GameObject* gameObject)
+{
+	assert( gameObject != 0 );
+	if( gameObject->m_broadphase == this && gameObject->m_broadphaseMoved )
+	{
+		gameObject->m_broadphaseMoved = false;
+		moveProxy(gameObject->m_broadphaseProxy, vec2(gameObject->getLeft(), gameObject->getTop()), vec2(gameObject->getRight(), gameObject->getBottom()));
+	}
+}
+
+
+void Broadphase::detachGameObject(GameObject* gameObject)
+{
+	assert( gameObject->m_broadphase == this );
+	gameObject->m_broadphase = 0;
+	gameObject->m_broadphaseProxy = -1;
+	gameObject->m_broadphaseMoved = false;
+	--m_numGameObjects;
+}
+
+
+void Broadphase::setProxyId(GameObject* gameObject, int proxyId)
+{
+	assert( gameObject->m_broadphase != 0 );
+	gameObject->m_broadphaseProxy = proxyId;
+}
+
+}
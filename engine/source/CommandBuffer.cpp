@@ -0,0 +1,185 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include <CommandBuffer.h>
+#include <Map.h>
+#include <Layer.h>
+#include <GameObject.h>
+#include <es_assert.h>
+#include <algorithm>
+
+namespace yam2d
+{
+
+CommandBuffer::CommandBuffer()
+	: Object()
+	, m_commands()
+	, m_sortKey(UNSCHEDULED)
+{
+}
+
+CommandBuffer::~CommandBuffer()
+{
+}
+
+void CommandBuffer::addGameObject(Layer* layer, GameObject* gameObject)
+{
+	assert( layer != 0 && gameObject != 0 );
+	push(ADD_GAME_OBJECT, 0, gameObject, layer, 0);
+}
+
+void CommandBuffer::deleteGameObject(GameObject* gameObject)
+{
+	assert( gameObject != 0 );
+	push(DELETE_GAME_OBJECT, gameObject, 0, 0, 0);
+}
+
+void CommandBuffer::moveGameObject(GameObject* gameObject, Layer* layer)
+{
+	assert( layer != 0 && gameObject != 0 );
+	push(MOVE_GAME_OBJECT, gameObject, 0, layer, 0);
+}
+
+void CommandBuffer::addComponent(Entity* entity, Component* component)
+{
+	assert( entity != 0 && component != 0 );
+	push(ADD_COMPONENT, entity, component, 0, 0);
+}
+
+void CommandBuffer::addFunction(Function* function)
+{
+	assert( function != 0 );
+	push(CALL_FUNCTION, 0, 0, 0, function);
+}
+
+void CommandBuffer::push(CommandType type, Entity* entity, Component* component, Layer* layer, Function* function)
+{
+	m_commands.push_back(Command());
+	Command& command = m_commands.back();
+	command.type = type;
+	command.sortKey = m_sortKey;
+	command.sequence = unsigned(m_commands.size());
+	command.entity = entity;
+	command.layer = layer;
+	command.component = component;
+	command.function = function;
+}
+
+void CommandBuffer::apply(Map* map, const std::vector< Ref<CommandBuffer> >& buffers)
+{
+	std::vector<Command*> commands;
+	for( size_t i=0; i<buffers.size(); ++i )
+	{
+		std::vector<Command>& bufferCommands = buffers[i].ptr()->m_commands;
+		for( size_t j=0; j<bufferCommands.size(); ++j )
+		{
+			commands.push_back(&bufferCommands[j]);
+		}
+	}
+
+	std::stable_sort(commands.begin(), commands.end(), CommandOrder());
+	std::vector<GameObject*> deletedGameObjects;
+	std::vector< Ref<GameObject> > keepAlive;
+	for( size_t i=0; i<commands.size(); ++i )
+	{
+		if( commands[i]->type == DELETE_GAME_OBJECT )
+		{
+			GameObject* gameObject = dynamic_cast<GameObject*>(commands[i]->entity);
+			deletedGameObjects.push_back(gameObject);
+			keepAlive.push_back(gameObject);
+		}
+		else
+		{
+			execute(map, *commands[i]);
+		}
+	}
+
+	// Deleting one by one searches the whole layer for each object, so deleted objects are removed from all 
+	// layers at once. They are kept alive until all layers have been searched.
+	if( !deletedGameObjects.empty() )
+	{
+		Map::LayerMap& layers = map->getLayers();
+		for( Map::LayerMap::iterator it = layers.begin(); it != layers.end(); ++it )
+		{
+			if( it->second != 0 )
+			{
+				it->second->removeGameObjects(deletedGameObjects);
+			}
+		}
+	}
+
+	for( size_t i=0; i<buffers.size(); ++i )
+	{
+		buffers[i].ptr()->m_commands.clear();
+	}
+}
+
+void CommandBuffer::execute(Map* map, Command& command)
+{
+	switch( command.type )
+	{
+	case ADD_GAME_OBJECT:
+		command.layer->addGameObject(dynamic_cast<GameObject*>(command.component.ptr()));
+		break;
+
+	case MOVE_GAME_OBJECT:
+		{
+			// Keeps the game object alive, while it is between layers.
+			Ref<GameObject> gameObject = dynamic_cast<GameObject*>(command.entity);
+			Map::LayerMap& layers = map->getLayers();
+			for( Map::LayerMap::iterator it = layers.begin(); it != layers.end(); ++it )
+			{
+				Layer* layer = it->second;
+				if( layer == 0 || layer == command.layer )
+				{
+					continue;
+				}
+
+				Layer::GameObjectList& gameObjects = layer->getGameObjects();
+				for( size_t i=0; i<gameObjects.size(); ++i )
+				{
+					if( gameObjects[i] == gameObject )
+					{
+						layer->removeGameObjects(std::vector<GameObject*>(1, gameObject.ptr()));
+						command.layer->addGameObject(gameObject);
+						return;
+					}
+				}
+			}
+		}
+		break;
+
+	case ADD_COMPONENT:
+		command.entity->addComponent(command.component);
+		break;
+
+	case CALL_FUNCTION:
+		command.function->execute(map);
+		break;
+
+	case DELETE_GAME_OBJECT:
+		// Deleted in apply.
+		break;
+	}
+}
+
+}
@@ -0,0 +1,208 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "DynamicAabbTree.h"
+#include "GameObject.h"
+
+namespace yam2d
+{
+
+namespace
+{
+	b2AABB toAabb(const vec2& topLeft, const vec2& bottomRight)
+	{
+		b2AABB aabb;
+		aabb.lowerBound.Set(topLeft.x, topLeft.y);
+		aabb.upperBound.Set(bottomRight.x, bottomRight.y);
+		return aabb;
+	}
+
+	bool overlapsExtents(const vec2& topLeftA, const vec2& bottomRightA, const vec2& topLeftB, const vec2& bottomRightB)
+	{
+		return topLeftA.x <= bottomRightB.x && topLeftB.x <= bottomRightA.x 
+			&& topLeftA.y <= bottomRightB.y && topLeftB.y <= bottomRightA.y;
+	}
+
+	// Collects game objects, whose actual extents overlap with query area.
+	struct AabbQuery
+	{
+		const b2DynamicTree*	tree;
+		const vec2*				topLefts;
+		const vec2*				bottomRights;
+		vec2					topLeft;
+		vec2					bottomRight;
+		GameObject**			results;
+		int						maxResults;
+		int						numResults;
+
+		bool QueryCallback(int proxyId)
+		{
+			if( overlapsExtents(topLefts[proxyId], bottomRights[proxyId], topLeft, bottomRight) )
+			{
+				GameObject* gameObject = (GameObject*)tree->GetUserData(proxyId);
+				if( numResults < maxResults )
+				{
+					results[numResults] = gameObject;
+				}
+				++numResults;
+			}
+			return true;
+		}
+	};
+
+	// Reports pairs of one game object with objects having larger proxy id.
+	struct PairQuery
+	{
+		const b2DynamicTree*			tree;
+		const vec2*						topLefts;
+		const vec2*						bottomRights;
+		int								proxyId;
+		GameObject*						gameObject;
+		Broadphase::PairCallback*		callback;
+
+		bool QueryCallback(int otherProxyId)
+		{
+			if( otherProxyId <= proxyId )
+			{
+				return true;
+			}
+
+			if( overlapsExtents(topLefts[otherProxyId], bottomRights[otherProxyId], topLefts[proxyId], bottomRights[proxyId]) )
+			{
+				callback->onOverlap(gameObject, (GameObject*)tree->GetUserData(otherProxyId));
+			}
+			return true;
+		}
+	};
+}
+
+
+DynamicAabbTree::DynamicAabbTree()
+: Broadphase()
+, m_tree(new b2DynamicTree())
+, m_proxyIds()
+, m_proxyIndices()
+, m_topLefts()
+, m_bottomRights()
+{
+}
+
+
+DynamicAabbTree::~DynamicAabbTree()
+{
+	clear();
+	delete m_tree;
+}
+
+
+void DynamicAabbTree::clear()
+{
+	for( size_t i=0; i<m_proxyIds.size(); ++i )
+	{
+		detachGameObject((GameObject*)m_tree->GetUserData(m_proxyIds[i]));
+	}
+
+	delete m_tree;
+	m_tree = new b2DynamicTree();
+	m_proxyIds.clear();
+	m_proxyIndices.clear();
+	m_topLefts.clear();
+	m_bottomRights.clear();
+}
+
+
+int DynamicAabbTree::queryAabb(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const
+{
+	AabbQuery callback;
+	callback.tree = m_tree;
+	callback.topLefts = m_topLefts.empty() ? 0 : &m_topLefts[0];
+	callback.bottomRights = m_bottomRights.empty() ? 0 : &m_bottomRights[0];
+	callback.topLeft = topLeft;
+	callback.bottomRight = bottomRight;
+	callback.results = results;
+	callback.maxResults = maxResults;
+	callback.numResults = 0;
+	m_tree->Query(&callback, toAabb(topLeft, bottomRight));
+	return callback.numResults;
+}
+
+
+void DynamicAabbTree::findOverlappingPairs(PairCallback* callback) const
+{
+	assert( callback != 0 );
+	PairQuery pairCallback;
+	pairCallback.tree = m_tree;
+	pairCallback.topLefts = m_topLefts.empty() ? 0 : &m_topLefts[0];
+	pairCallback.bottomRights = m_bottomRights.empty() ? 0 : &m_bottomRights[0];
+	pairCallback.callback = callback;
+	for( size_t i=0; i<m_proxyIds.size(); ++i )
+	{
+		const int proxyId = m_proxyIds[i];
+		pairCallback.proxyId = proxyId;
+		pairCallback.gameObject = (GameObject*)m_tree->GetUserData(proxyId);
+		m_tree->Query(&pairCallback, toAabb(m_topLefts[proxyId], m_bottomRights[proxyId]));
+	}
+}
+
+
+int DynamicAabbTree::createProxy(GameObject* gameObject, const vec2& topLeft, const vec2& bottomRight)
+{
+	const int proxyId = m_tree->CreateProxy(toAabb(topLeft, bottomRight), gameObject);
+	if( proxyId >= (int)m_proxyIndices.size() )
+	{
+		m_proxyIndices.resize(proxyId + 1, -1);
+		m_topLefts.resize(proxyId + 1);
+		m_bottomRights.resize(proxyId + 1);
+	}
+	m_proxyIndices[proxyId] = (int)m_proxyIds.size();
+	m_topLefts[proxyId] = topLeft;
+	m_bottomRights[proxyId] = bottomRight;
+	m_proxyIds.push_back(proxyId);
+	return proxyId;
+}
+
+
+void DynamicAabbTree::destroyProxy(int proxyId)
+{
+	assert( proxyId >= 0 && proxyId < (int)m_proxyIndices.size() && m_proxyIndices[proxyId] >= 0 );
+
+	// Swap last proxy to place of removed one.
+	const int index = m_proxyIndices[proxyId];
+	const int lastProxyId = m_proxyIds.back();
+	m_proxyIds[index] = lastProxyId;
+	m_proxyIndices[lastProxyId] = index;
+	m_proxyIds.pop_back();
+	m_proxyIndices[proxyId] = -1;
+
+	m_tree->DestroyProxy(proxyId);
+}
+
+
+void DynamicAabbTree::moveProxy(int proxyId, const vec2& topLeft, const vec2& bottomRight)
+{
+	// Tree keeps the proxy in place, while it stays inside its enlarged extents.
+	m_topLefts[proxyId] = topLeft;
+	m_bottomRights[proxyId] = bottomRight;
+	m_tree->MoveProxy(proxyId, toAabb(topLeft, bottomRight), b2Vec2(0.0f, 0.0f));
+}
+
+}
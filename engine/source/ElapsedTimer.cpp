@@ -34,6 +34,8 @@ namespace
 {
 #if defined(_WIN32)
 	typedef __int64 YAM_TIME_TYPE;
+#elif defined(YAM2D_LINUX)
+	typedef long long YAM_TIME_TYPE;
 #else
 	typedef long YAM_TIME_TYPE;
 #endif
@@ -103,6 +105,21 @@ namespace
 		clock_gettime(CLOCK_MONOTONIC, &t);
 		return (t.tv_sec * 1000) + (t.tv_nsec / 1000000);
 	}
+
+#elif defined(YAM2D_LINUX)
+
+	inline  YAM_TIME_TYPE getTimeScale()
+	{
+		return 1000000000LL;
+	}
+
+	/** Returns time in nanoseconds */
+	inline YAM_TIME_TYPE getTotalTime()
+	{
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return (YAM_TIME_TYPE(t.tv_sec) * 1000000000LL) + YAM_TIME_TYPE(t.tv_nsec);
+	}
 #else
 You need to have unsigned long getTime() implementation on this platform.
 #endif
@@ -52,6 +52,7 @@ namespace yam2d
 		, m_owner(owner)
 		, m_properties(properties)
 	{
+		setMemorySubsystem(yam2d::MemoryStats::COMPONENTS);
 	}
 
 
@@ -117,6 +118,7 @@ namespace yam2d
 		: Component(owner, properties)
 		, m_components()
 	{
+		setMemorySubsystem(yam2d::MemoryStats::ENTITIES);
 		setAllProperties(componentFactory, properties);
 	}
 
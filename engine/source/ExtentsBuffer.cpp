@@ -0,0 +1,381 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "ExtentsBuffer.h"
+#include "GameObject.h"
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define EXTENTS_BUFFER_SSE
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define EXTENTS_BUFFER_NEON
+#endif
+
+namespace yam2d
+{
+
+namespace
+{
+	static const int MAX_BOXES_PER_PASS = 8;
+	static const int bitCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+	// Box to be tested against extents. Box values are replicated to all lanes once per query.
+	struct QueryBox
+	{
+		float					left;
+		float					top;
+		float					right;
+		float					bottom;
+#if defined(EXTENTS_BUFFER_SSE)
+		__m128					left4;
+		__m128					top4;
+		__m128					right4;
+		__m128					bottom4;
+#elif defined(EXTENTS_BUFFER_NEON)
+		float32x4_t				left4;
+		float32x4_t				top4;
+		float32x4_t				right4;
+		float32x4_t				bottom4;
+#endif
+
+		void set(const vec2& topLeft, const vec2& bottomRight)
+		{
+			left = topLeft.x;
+			top = topLeft.y;
+			right = bottomRight.x;
+			bottom = bottomRight.y;
+#if defined(EXTENTS_BUFFER_SSE)
+			left4 = _mm_set1_ps(left);
+			top4 = _mm_set1_ps(top);
+			right4 = _mm_set1_ps(right);
+			bottom4 = _mm_set1_ps(bottom);
+#elif defined(EXTENTS_BUFFER_NEON)
+			left4 = vdupq_n_f32(left);
+			top4 = vdupq_n_f32(top);
+			right4 = vdupq_n_f32(right);
+			bottom4 = vdupq_n_f32(bottom);
+#endif
+		}
+	};
+
+	// Extents arrays of the buffer.
+	struct Extents
+	{
+		const float*			left;
+		const float*			top;
+		const float*			right;
+		const float*			bottom;
+	};
+
+	// Returns 1, if extents i overlaps with the box. Touching extents are overlapping like in GameObject::collidesTo.
+	inline unsigned overlapMask1(const Extents& e, int i, const QueryBox& box)
+	{
+		return (e.left[i] <= box.right && box.left <= e.right[i] && e.top[i] <= box.bottom && box.top <= e.bottom[i]) ? 1 : 0;
+	}
+
+	// Returns bit mask of extents i...i+3 overlapping with the box.
+	inline unsigned overlapMask4(const Extents& e, int i, const QueryBox& box)
+	{
+#if defined(EXTENTS_BUFFER_SSE)
+		__m128 hitX = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(e.left+i), box.right4), _mm_cmple_ps(box.left4, _mm_loadu_ps(e.right+i)));
+		__m128 hitY = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(e.top+i), box.bottom4), _mm_cmple_ps(box.top4, _mm_loadu_ps(e.bottom+i)));
+		return (unsigned)_mm_movemask_ps(_mm_and_ps(hitX, hitY));
+#elif defined(EXTENTS_BUFFER_NEON)
+		static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+		uint32x4_t hitX = vandq_u32(vcleq_f32(vld1q_f32(e.left+i), box.right4), vcleq_f32(box.left4, vld1q_f32(e.right+i)));
+		uint32x4_t hitY = vandq_u32(vcleq_f32(vld1q_f32(e.top+i), box.bottom4), vcleq_f32(box.top4, vld1q_f32(e.bottom+i)));
+		uint32x4_t bits = vandq_u32(vandq_u32(hitX, hitY), vld1q_u32(laneBits));
+		uint32x2_t pairs = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+		return vget_lane_u32(pairs, 0) | vget_lane_u32(pairs, 1);
+#else
+		return overlapMask1(e, i, box) | (overlapMask1(e, i+1, box) << 1) | (overlapMask1(e, i+2, box) << 2) | (overlapMask1(e, i+3, box) << 3);
+#endif
+	}
+
+	// Same value as GameObject::collidesTo gives to collisionNormalLikeOverlap, when box is the colliding object.
+	inline vec2 normalLikeOverlap(const Extents& e, int i, const QueryBox& box)
+	{
+		float x = ((box.left + box.right) - (e.left[i] + e.right[i])) / ((box.right - box.left) + (e.right[i] - e.left[i]));
+		float y = ((box.top + box.bottom) - (e.top[i] + e.bottom[i])) / ((box.bottom - box.top) + (e.bottom[i] - e.top[i]));
+		return vec2(x, y);
+	}
+
+	// Returns index of lowest set bit.
+	inline int lowestBit(uint32_t mask)
+	{
+		int index = 0;
+		while( (mask & 1) == 0 )
+		{
+			mask >>= 1;
+			++index;
+		}
+		return index;
+	}
+}
+
+
+ExtentsBuffer::ExtentsBuffer()
+: Broadphase()
+, m_left()
+, m_top()
+, m_right()
+, m_bottom()
+, m_gameObjects()
+{
+}
+
+
+ExtentsBuffer::~ExtentsBuffer()
+{
+	clear();
+}
+
+
+int ExtentsBuffer::testOverlap(const vec2& topLeft, const vec2& bottomRight, uint32_t* hitMasks, vec2* collisionNormalLikeOverlaps) const
+{
+	int numExtents = getNumExtents();
+	memset(hitMasks, 0, getNumMaskWords()*sizeof(uint32_t));
+	if( numExtents == 0 )
+	{
+		return 0;
+	}
+
+	Extents e = { &m_left[0], &m_top[0], &m_right[0], &m_bottom[0] };
+	QueryBox box;
+	box.set(topLeft, bottomRight);
+
+	int numHits = 0;
+	int i = 0;
+	for( ; i+4 <= numExtents; i += 4 )
+	{
+		uint32_t mask = overlapMask4(e, i, box);
+		if( mask == 0 )
+			continue;
+
+		hitMasks[i>>5] |= mask << (i&31);
+		numHits += bitCounts[mask];
+		if( collisionNormalLikeOverlaps != 0 )
+		{
+			for( ; mask != 0; mask &= mask-1 )
+			{
+				int index = i + lowestBit(mask);
+				collisionNormalLikeOverlaps[index] = normalLikeOverlap(e, index, box);
+			}
+		}
+	}
+
+	for( ; i<numExtents; ++i )
+	{
+		if( overlapMask1(e, i, box) )
+		{
+			hitMasks[i>>5] |= 1u << (i&31);
+			++numHits;
+			if( collisionNormalLikeOverlaps != 0 )
+			{
+				collisionNormalLikeOverlaps[i] = normalLikeOverlap(e, i, box);
+			}
+		}
+	}
+
+	return numHits;
+}
+
+
+int ExtentsBuffer::testOverlaps(const vec2* topLefts, const vec2* bottomRights, int numBoxes, uint32_t* hitMasks) const
+{
+	int numExtents = getNumExtents();
+	int numMaskWords = getNumMaskWords();
+	memset(hitMasks, 0, numBoxes*numMaskWords*sizeof(uint32_t));
+	if( numExtents == 0 )
+	{
+		return 0;
+	}
+
+	Extents e = { &m_left[0], &m_top[0], &m_right[0], &m_bottom[0] };
+	QueryBox boxes[MAX_BOXES_PER_PASS];
+	int numHits = 0;
+	for( int firstBox=0; firstBox<numBoxes; firstBox += MAX_BOXES_PER_PASS )
+	{
+		int numPassBoxes = numBoxes - firstBox < MAX_BOXES_PER_PASS ? numBoxes - firstBox : MAX_BOXES_PER_PASS;
+		for( int b=0; b<numPassBoxes; ++b )
+		{
+			boxes[b].set(topLefts[firstBox+b], bottomRights[firstBox+b]);
+		}
+
+		uint32_t* passMasks = hitMasks + firstBox*numMaskWords;
+		int i = 0;
+		for( ; i+4 <= numExtents; i += 4 )
+		{
+			for( int b=0; b<numPassBoxes; ++b )
+			{
+				uint32_t mask = overlapMask4(e, i, boxes[b]);
+				if( mask != 0 )
+				{
+					passMasks[b*numMaskWords + (i>>5)] |= mask << (i&31);
+					numHits += bitCounts[mask];
+				}
+			}
+		}
+
+		for( ; i<numExtents; ++i )
+		{
+			for( int b=0; b<numPassBoxes; ++b )
+			{
+				uint32_t mask = overlapMask1(e, i, boxes[b]);
+				passMasks[b*numMaskWords + (i>>5)] |= mask << (i&31);
+				numHits += mask;
+			}
+		}
+	}
+
+	return numHits;
+}
+
+
+void ExtentsBuffer::clear()
+{
+	for( size_t i=0; i<m_gameObjects.size(); ++i )
+	{
+		detachGameObject(m_gameObjects[i]);
+	}
+
+	m_left.clear();
+	m_top.clear();
+	m_right.clear();
+	m_bottom.clear();
+	m_gameObjects.clear();
+}
+
+
+int ExtentsBuffer::queryAabb(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const
+{
+	int numExtents = getNumExtents();
+	if( numExtents == 0 )
+	{
+		return 0;
+	}
+
+	Extents e = { &m_left[0], &m_top[0], &m_right[0], &m_bottom[0] };
+	QueryBox box;
+	box.set(topLeft, bottomRight);
+
+	int numResults = 0;
+	int i = 0;
+	for( ; i+4 <= numExtents; i += 4 )
+	{
+		for( uint32_t mask = overlapMask4(e, i, box); mask != 0; mask &= mask-1 )
+		{
+			addResult(m_gameObjects[i + lowestBit(mask)], results, maxResults, numResults);
+		}
+	}
+
+	for( ; i<numExtents; ++i )
+	{
+		if( overlapMask1(e, i, box) )
+		{
+			addResult(m_gameObjects[i], results, maxResults, numResults);
+		}
+	}
+
+	return numResults;
+}
+
+
+void ExtentsBuffer::findOverlappingPairs(PairCallback* callback) const
+{
+	assert( callback != 0 );
+	int numExtents = getNumExtents();
+	if( numExtents == 0 )
+	{
+		return;
+	}
+
+	Extents e = { &m_left[0], &m_top[0], &m_right[0], &m_bottom[0] };
+	QueryBox box;
+	for( int i=0; i<numExtents; ++i )
+	{
+		box.set(vec2(m_left[i], m_top[i]), vec2(m_right[i], m_bottom[i]));
+		int j = i+1;
+		for( ; j+4 <= numExtents; j += 4 )
+		{
+			for( uint32_t mask = overlapMask4(e, j, box); mask != 0; mask &= mask-1 )
+			{
+				callback->onOverlap(m_gameObjects[i], m_gameObjects[j + lowestBit(mask)]);
+			}
+		}
+
+		for( ; j<numExtents; ++j )
+		{
+			if( overlapMask1(e, j, box) )
+			{
+				callback->onOverlap(m_gameObjects[i], m_gameObjects[j]);
+			}
+		}
+	}
+}
+
+
+int ExtentsBuffer::createProxy(GameObject* gameObject, const vec2& topLeft, const vec2& bottomRight)
+{
+	m_left.push_back(topLeft.x);
+	m_top.push_back(topLeft.y);
+	m_right.push_back(bottomRight.x);
+	m_bottom.push_back(bottomRight.y);
+	m_gameObjects.push_back(gameObject);
+	return getNumExtents() - 1;
+}
+
+
+void ExtentsBuffer::destroyProxy(int proxyId)
+{
+	assert( proxyId >= 0 && proxyId < getNumExtents() );
+	int last = getNumExtents() - 1;
+	if( proxyId != last )
+	{
+		m_left[proxyId] = m_left[last];
+		m_top[proxyId] = m_top[last];
+		m_right[proxyId] = m_right[last];
+		m_bottom[proxyId] = m_bottom[last];
+		m_gameObjects[proxyId] = m_gameObjects[last];
+		setProxyId(m_gameObjects[proxyId], proxyId);
+	}
+
+	m_left.pop_back();
+	m_top.pop_back();
+	m_right.pop_back();
+	m_bottom.pop_back();
+	m_gameObjects.pop_back();
+}
+
+
+void ExtentsBuffer::moveProxy(int proxyId, const vec2& topLeft, const vec2& bottomRight)
+{
+	assert( proxyId >= 0 && proxyId < getNumExtents() );
+	m_left[proxyId] = topLeft.x;
+	m_top[proxyId] = topLeft.y;
+	m_right[proxyId] = bottomRight.x;
+	m_bottom[proxyId] = bottomRight.y;
+}
+
+}
@@ -36,7 +36,7 @@ extern struct android_app* g_androidState;
 namespace yam2d
 {
 
-#if defined(_WIN32)
+#if defined(_WIN32) || defined(YAM2D_LINUX)
 FileStream::FileStream( const char* const fileName, FileOpenMode mode )
 : Stream()
 , m_mode(mode)
@@ -0,0 +1,342 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "FlowField.h"
+#include "ElapsedTimer.h"
+#include <Profiler.h>
+#include <es_assert.h>
+#include <algorithm>
+#include <float.h>
+
+namespace yam2d
+{
+
+namespace
+{
+	const uint8_t NO_DIRECTION = 0xff;
+	const float DIAGONAL_COST = 1.41421356f;
+	const float DIAGONAL_LENGTH = 0.70710678f;
+
+	// Number of cells processed between checks of the time budget.
+	const int CELLS_PER_TIME_CHECK = 256;
+
+	// Opposite directions are pairs, so index of opposite direction is d^1.
+	const int directionsX[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+	const int directionsY[8] = { 0, 0, 1, -1, 1, -1, -1, 1 };
+	const vec2 directionVectors[8] = 
+	{
+		vec2(1.0f, 0.0f), vec2(-1.0f, 0.0f), vec2(0.0f, 1.0f), vec2(0.0f, -1.0f),
+		vec2(DIAGONAL_LENGTH, DIAGONAL_LENGTH), vec2(-DIAGONAL_LENGTH, -DIAGONAL_LENGTH), 
+		vec2(DIAGONAL_LENGTH, -DIAGONAL_LENGTH), vec2(-DIAGONAL_LENGTH, DIAGONAL_LENGTH)
+	};
+
+	template<typename NodeType>
+	bool isWorse(const NodeType& a, const NodeType& b)
+	{
+		return a.cost > b.cost;
+	}
+}
+
+
+FlowField::FlowField(TileGrid* tileGrid)
+: Object()
+, m_tileGrid(tileGrid)
+, m_width(tileGrid->getWidth())
+, m_height(tileGrid->getHeight())
+, m_targets()
+, m_targetCells()
+, m_distances()
+, m_directions()
+, m_buildDistances()
+, m_buildDirections()
+, m_open()
+, m_isReady(false)
+, m_needsBuild(false)
+, m_isBuilding(false)
+, m_buildTime(0.0f)
+, m_pendingBuildTime(0.0f)
+, m_numBuilds(0)
+{
+	m_tileGrid->addChangeListener(this);
+}
+
+
+FlowField::~FlowField()
+{
+	m_tileGrid->removeChangeListener(this);
+}
+
+
+void FlowField::setTarget(const vec2& target)
+{
+	setTargets(&target, 1);
+}
+
+
+void FlowField::setTargets(const vec2* targets, int numTargets)
+{
+	m_targets.assign(targets, targets + numTargets);
+
+	std::vector<int> targetCells;
+	for( int i=0; i<numTargets; ++i )
+	{
+		int cell = getCell(targets[i]);
+		if( cell >= 0 && !m_tileGrid->isSolid(cell % m_width, cell / m_width) )
+		{
+			targetCells.push_back(cell);
+		}
+	}
+	std::sort(targetCells.begin(), targetCells.end());
+	targetCells.erase(std::unique(targetCells.begin(), targetCells.end()), targetCells.end());
+
+	// Targets moving inside their cells do not change the fields.
+	if( targetCells != m_targetCells || !m_isReady )
+	{
+		m_targetCells.swap(targetCells);
+		m_needsBuild = true;
+	}
+}
+
+
+bool FlowField::update(float maxMilliseconds)
+{
+	if( !m_isBuilding && !m_needsBuild )
+	{
+		return m_isReady;
+	}
+
+	if( m_needsBuild )
+	{
+		beginBuild();
+	}
+
+	return continueBuild(maxMilliseconds);
+}
+
+
+void FlowField::build()
+{
+	update(FLT_MAX);
+}
+
+
+vec2 FlowField::getDirection(const vec2& position) const
+{
+	int cell = getCell(position);
+	if( cell < 0 || !m_isReady || m_directions[cell] == NO_DIRECTION )
+	{
+		return vec2(0.0f);
+	}
+
+	return directionVectors[m_directions[cell]];
+}
+
+
+float FlowField::getDistance(const vec2& position) const
+{
+	int cell = getCell(position);
+	if( cell < 0 || !m_isReady || m_distances[cell] == FLT_MAX )
+	{
+		return -1.0f;
+	}
+
+	return m_distances[cell];
+}
+
+
+void FlowField::onCellChanged(int x, int y, bool solid)
+{
+	(void)x;
+	(void)y;
+	(void)solid;
+	m_needsBuild = true;
+}
+
+
+int FlowField::getCell(const vec2& position) const
+{
+	int x = m_tileGrid->getCellX(position.x);
+	int y = m_tileGrid->getCellY(position.y);
+	if( unsigned(x) >= unsigned(m_width) || unsigned(y) >= unsigned(m_height) )
+	{
+		return -1;
+	}
+	return y*m_width + x;
+}
+
+
+void FlowField::beginBuild()
+{
+	// Restarts build, if previous one did not complete yet.
+	ElapsedTimer timer;
+	timer.reset();
+	const size_t numCells = size_t(m_width)*size_t(m_height);
+	m_buildDistances.assign(numCells, FLT_MAX);
+	m_buildDirections.assign(numCells, NO_DIRECTION);
+	m_open.clear();
+	for( size_t i=0; i<m_targetCells.size(); ++i )
+	{
+		m_buildDistances[m_targetCells[i]] = 0.0f;
+		OpenNode node = { 0.0f, m_targetCells[i] };
+		m_open.push_back(node);
+	}
+
+	m_needsBuild = false;
+	m_isBuilding = true;
+	m_pendingBuildTime = 1000.0f*timer.getTime();
+}
+
+
+bool FlowField::continueBuild(float maxMilliseconds)
+{
+	// Dijkstra from targets. Each cell points to the neighbour, from which its cost was set, which is the first 
+	// step of the shortest path. Moves are reversible, so paths from targets are paths to targets reversed.
+	ElapsedTimer timer;
+	timer.reset();
+	const TileGrid* tileGrid = m_tileGrid.ptr();
+	int numCellsUntilCheck = CELLS_PER_TIME_CHECK;
+	while( !m_open.empty() )
+	{
+		if( --numCellsUntilCheck == 0 )
+		{
+			numCellsUntilCheck = CELLS_PER_TIME_CHECK;
+			if( 1000.0f*timer.getTime() >= maxMilliseconds )
+			{
+				m_pendingBuildTime += 1000.0f*timer.getTime();
+				return false;
+			}
+		}
+
+		const OpenNode node = m_open.front();
+		std::pop_heap(m_open.begin(), m_open.end(), isWorse<OpenNode>);
+		m_open.pop_back();
+		if( node.cost > m_buildDistances[node.cell] )
+		{
+			continue;
+		}
+
+		const int x = node.cell % m_width;
+		const int y = node.cell / m_width;
+		for( int d=0; d<8; ++d )
+		{
+			const int nx = x + directionsX[d];
+			const int ny = y + directionsY[d];
+			if( unsigned(nx) >= unsigned(m_width) || unsigned(ny) >= unsigned(m_height) || tileGrid->isSolid(nx, ny) )
+			{
+				continue;
+			}
+
+			if( d >= 4 && (tileGrid->isSolid(nx, y) || tileGrid->isSolid(x, ny)) )
+			{
+				continue;
+			}
+
+			const int neighbour = ny*m_width + nx;
+			const float cost = node.cost + (d >= 4 ? DIAGONAL_COST : 1.0f);
+			if( cost < m_buildDistances[neighbour] )
+			{
+				m_buildDistances[neighbour] = cost;
+				m_buildDirections[neighbour] = uint8_t(d ^ 1);
+				OpenNode next = { cost, neighbour };
+				m_open.push_back(next);
+				std::push_heap(m_open.begin(), m_open.end(), isWorse<OpenNode>);
+			}
+		}
+	}
+
+	m_distances.swap(m_buildDistances);
+	m_directions.swap(m_buildDirections);
+	m_isBuilding = false;
+	m_isReady = true;
+	m_buildTime = m_pendingBuildTime + 1000.0f*timer.getTime();
+	++m_numBuilds;
+	return !m_needsBuild;
+}
+
+
+FlowFieldCache::FlowFieldCache(TileGrid* tileGrid)
+: Object()
+, m_tileGrid(tileGrid)
+, m_flowFields()
+, m_nextUpdate(0)
+{
+}
+
+
+FlowFieldCache::~FlowFieldCache()
+{
+}
+
+
+FlowField* FlowFieldCache::getFlowField(const vec2& target)
+{
+	const int x = m_tileGrid->getCellX(target.x);
+	const int y = m_tileGrid->getCellY(target.y);
+	for( size_t i=0; i<m_flowFields.size(); ++i )
+	{
+		const std::vector<vec2>& targets = m_flowFields[i]->getTargets();
+		if( targets.size() == 1 && m_tileGrid->getCellX(targets[0].x) == x && m_tileGrid->getCellY(targets[0].y) == y )
+		{
+			return m_flowFields[i];
+		}
+	}
+
+	FlowField* flowField = new FlowField(m_tileGrid);
+	flowField->setTarget(target);
+	m_flowFields.push_back(flowField);
+	return flowField;
+}
+
+
+void FlowFieldCache::update(float maxMilliseconds)
+{
+	YAM2D_PROFILE_ZONE("FlowFieldCache::update");
+	for( size_t i=0; i<m_flowFields.size(); )
+	{
+		if( m_flowFields[i]->getRefCount() == 1 )
+		{
+			m_flowFields.erase(m_flowFields.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	// Fields are updated in turns, so that single large build does not starve others.
+	ElapsedTimer timer;
+	timer.reset();
+	for( size_t i=0; i<m_flowFields.size(); ++i )
+	{
+		const float remaining = maxMilliseconds - 1000.0f*timer.getTime();
+		if( remaining <= 0.0f )
+		{
+			break;
+		}
+
+		m_nextUpdate = (m_nextUpdate + 1) % m_flowFields.size();
+		m_flowFields[m_nextUpdate]->update(remaining);
+	}
+}
+
+
+}
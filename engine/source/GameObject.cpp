@@ -22,6 +22,7 @@
 // =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
 #include <GameObject.h>
+#include <Broadphase.h>
 
 namespace yam2d
 {
@@ -34,10 +35,19 @@ GameObject::GameObject(Entity* parent, const PropertySet& properties)
 , m_topLeft(0.0f)
 , m_bottomRight(0.0f)
 , m_rotation(properties.getOrDefault("rotation", 0.0f))
+, m_previousPosition(0.0f)
+, m_previousRotation(0.0f)
 , m_size(vec2(properties.getOrDefault("sizeX", 0.0f), properties.getOrDefault("sizeY", 0.0f)) )
 , m_tileScale(1.0f)
+, m_broadphase(0)
+, m_broadphaseProxy(-1)
+, m_broadphaseMoved(false)
+, m_layerOrder(0)
+, m_delayedUpdateTime(0.0f)
+, m_lodPhase(0)
 {
 	recalcExtens();
+	storePreviousTransform();
 }
 
 
@@ -49,16 +59,29 @@ GameObject::GameObject(Entity* parent, int type, const vec2& position, const vec
 , m_topLeft(0.0f)
 , m_bottomRight(0.0f)
 , m_rotation(0.0f)
+, m_previousPosition(0.0f)
+, m_previousRotation(0.0f)
 , m_size(size)
 , m_tileScale(1.0f)
+, m_broadphase(0)
+, m_broadphaseProxy(-1)
+, m_broadphaseMoved(false)
+, m_layerOrder(0)
+, m_delayedUpdateTime(0.0f)
+, m_lodPhase(0)
 {
 	recalcExtens();
+	storePreviousTransform();
 	(void)type; // Not needed. TODO: Remove someday
 }
 
 
 GameObject::~GameObject()
 {
+	if( m_broadphase != 0 )
+	{
+		m_broadphase->removeGameObject(this);
+	}
 }
 
 
@@ -124,6 +147,37 @@ float GameObject::getRotation() const
 } 
 
 
+void GameObject::storePreviousTransform()
+{
+	m_previousPosition = m_position;
+	m_previousRotation = m_rotation;
+}
+
+
+vec2 GameObject::getInterpolatedPosition(float alpha) const
+{
+	return m_previousPosition + (m_position - m_previousPosition)*alpha;
+}
+
+
+float GameObject::getInterpolatedRotation(float alpha) const
+{
+	// Rotations are between -PI and PI, so turn over the boundary, if it is shorter.
+	static const float PI = 3.14159265f;
+	float delta = m_rotation - m_previousRotation;
+	if( delta > PI )
+	{
+		delta -= 2.0f*PI;
+	}
+	else if( delta < -PI )
+	{
+		delta += 2.0f*PI;
+	}
+
+	return m_previousRotation + delta*alpha;
+}
+
+
 const vec2& GameObject::getSize() const
 { 
 	return m_size;
@@ -225,6 +279,11 @@ void GameObject::recalcExtens()
 	//m_bottomRight.y = /*m_offset.y +*/ m_position.y + (sizeInTiles.y*0.5f);
 	assert(m_topLeft.x <= m_bottomRight.x);
 	assert(m_topLeft.y <= m_bottomRight.y);
+
+	if( m_broadphase != 0 )
+	{
+		m_broadphase->updateGameObject(this);
+	}
 }
 
 
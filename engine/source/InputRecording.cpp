@@ -0,0 +1,520 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <InputRecording.h>
+#include <Logger.h>
+#include <string.h>
+
+namespace yam2d
+{
+
+namespace
+{
+	const char FILE_MAGIC[4] = { 'Y', 'I', 'N', 'P' };
+	const int FILE_VERSION = 1;
+
+	// Flags in the first byte of each frame, which tell what changed since the previous frame.
+	enum FrameFlags
+	{
+		FRAME_DELTA_TIME		= 1,
+		FRAME_KEYS				= 2,
+		FRAME_MOUSE_BUTTONS		= 4,
+		FRAME_MOUSE_POSITION	= 8,
+		FRAME_MOUSE_WHEEL		= 16,
+		FRAME_TOUCHES			= 32,
+		FRAME_ALL_FLAGS			= 63
+	};
+
+	bool touchesEqual(const std::vector<Touch>& a, const std::vector<Touch>& b)
+	{
+		if( a.size() != b.size() )
+		{
+			return false;
+		}
+
+		for( size_t i=0; i<a.size(); ++i )
+		{
+			if( a[i].touchId != b[i].touchId || a[i].pressed != b[i].pressed || a[i].x != b[i].x || a[i].y != b[i].y )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	unsigned getFloatBits(float value)
+	{
+		unsigned bits = 0;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	float getFloat(unsigned bits)
+	{
+		float value = 0.0f;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+}
+
+
+InputFrame::InputFrame()
+	: deltaTime(0.0f)
+	, mouseX(0)
+	, mouseY(0)
+	, mouseWheelDelta(0)
+	, touches()
+{
+	memset(keys, 0, sizeof(keys));
+	for( int i=0; i<NUM_MOUSE_BUTTONS; ++i )
+	{
+		mouseButtons[i] = false;
+	}
+}
+
+
+void InputFrame::capture(float frameTime)
+{
+	deltaTime = frameTime;
+	memset(keys, 0, sizeof(keys));
+	for( int i=0; i<NUM_KEYS; ++i )
+	{
+		if( getKeyState(KeyCodes(i)) != 0 )
+		{
+			setKeyDown(i, true);
+		}
+	}
+
+	for( int i=0; i<NUM_MOUSE_BUTTONS; ++i )
+	{
+		mouseButtons[i] = getMouseButtonState(MouseButtons(i)) != 0;
+	}
+
+	mouseX = getMouseAxisX();
+	mouseY = getMouseAxisY();
+	mouseWheelDelta = getMouseWheelDelta();
+	touches = getActiveTouches();
+}
+
+
+void InputFrame::setKeyDown(int keyCode, bool down)
+{
+	assert( keyCode >= 0 && keyCode < NUM_KEYS );
+	if( down )
+	{
+		keys[keyCode >> 3] |= (unsigned char)(1 << (keyCode & 7));
+	}
+	else
+	{
+		keys[keyCode >> 3] &= (unsigned char)~(1 << (keyCode & 7));
+	}
+}
+
+
+InputRecorder::InputRecorder()
+	: Object()
+	, m_file(0)
+	, m_frame()
+	, m_previousFrame()
+	, m_numFrames(0)
+	, m_numBytes(0)
+{
+}
+
+
+InputRecorder::~InputRecorder()
+{
+	close();
+}
+
+
+bool InputRecorder::open(const char* fileName)
+{
+	close();
+	m_file = fopen(fileName, "wb");
+	if( m_file == 0 )
+	{
+		YAM2D_LOG_WARNING(Logger::CATEGORY_ENGINE, "[%s] Input recording %s could not be created", __FUNCTION__, fileName);
+		return false;
+	}
+
+	m_previousFrame = InputFrame();
+	m_numFrames = 0;
+	m_numBytes = 0;
+	for( int i=0; i<4; ++i )
+	{
+		writeByte(FILE_MAGIC[i]);
+	}
+	writeByte(FILE_VERSION);
+	return true;
+}
+
+
+void InputRecorder::close()
+{
+	if( m_file != 0 )
+	{
+		fclose(m_file);
+		m_file = 0;
+	}
+}
+
+
+void InputRecorder::recordFrame(float deltaTime)
+{
+	m_frame.capture(deltaTime);
+	writeFrame(m_frame);
+}
+
+
+void InputRecorder::writeFrame(const InputFrame& frame)
+{
+	assert( m_file != 0 );
+	const InputFrame& previous = m_previousFrame;
+	int flags = 0;
+	if( getFloatBits(frame.deltaTime) != getFloatBits(previous.deltaTime) )
+	{
+		flags |= FRAME_DELTA_TIME;
+	}
+
+	int numKeysChanged = 0;
+	for( int i=0; i<InputFrame::NUM_KEYS; ++i )
+	{
+		if( frame.isKeyDown(i) != previous.isKeyDown(i) )
+		{
+			++numKeysChanged;
+		}
+	}
+	if( numKeysChanged > 0 )
+	{
+		flags |= FRAME_KEYS;
+	}
+
+	int mouseButtons = 0;
+	int previousMouseButtons = 0;
+	for( int i=0; i<InputFrame::NUM_MOUSE_BUTTONS; ++i )
+	{
+		mouseButtons |= frame.mouseButtons[i] ? (1 << i) : 0;
+		previousMouseButtons |= previous.mouseButtons[i] ? (1 << i) : 0;
+	}
+	if( mouseButtons != previousMouseButtons )
+	{
+		flags |= FRAME_MOUSE_BUTTONS;
+	}
+
+	if( frame.mouseX != previous.mouseX || frame.mouseY != previous.mouseY )
+	{
+		flags |= FRAME_MOUSE_POSITION;
+	}
+
+	if( frame.mouseWheelDelta != previous.mouseWheelDelta )
+	{
+		flags |= FRAME_MOUSE_WHEEL;
+	}
+
+	if( !touchesEqual(frame.touches, previous.touches) )
+	{
+		flags |= FRAME_TOUCHES;
+	}
+
+	writeByte(flags);
+	if( flags & FRAME_DELTA_TIME )
+	{
+		const unsigned bits = getFloatBits(frame.deltaTime);
+		for( int i=0; i<4; ++i )
+		{
+			writeByte((bits >> (8*i)) & 0xff);
+		}
+	}
+
+	if( flags & FRAME_KEYS )
+	{
+		// Key codes, whose state toggled.
+		writeUnsigned(unsigned(numKeysChanged));
+		for( int i=0; i<InputFrame::NUM_KEYS; ++i )
+		{
+			if( frame.isKeyDown(i) != previous.isKeyDown(i) )
+			{
+				writeByte(i);
+			}
+		}
+	}
+
+	if( flags & FRAME_MOUSE_BUTTONS )
+	{
+		writeByte(mouseButtons);
+	}
+
+	if( flags & FRAME_MOUSE_POSITION )
+	{
+		writeSigned(frame.mouseX - previous.mouseX);
+		writeSigned(frame.mouseY - previous.mouseY);
+	}
+
+	if( flags & FRAME_MOUSE_WHEEL )
+	{
+		writeSigned(frame.mouseWheelDelta);
+	}
+
+	if( flags & FRAME_TOUCHES )
+	{
+		writeUnsigned(unsigned(frame.touches.size()));
+		for( size_t i=0; i<frame.touches.size(); ++i )
+		{
+			const Touch& touch = frame.touches[i];
+			writeUnsigned(unsigned(touch.touchId));
+			writeByte(touch.pressed ? 1 : 0);
+			writeSigned(touch.x);
+			writeSigned(touch.y);
+		}
+	}
+
+	m_previousFrame = frame;
+	++m_numFrames;
+}
+
+
+void InputRecorder::writeByte(int value)
+{
+	fputc(value & 0xff, m_file);
+	++m_numBytes;
+}
+
+
+void InputRecorder::writeUnsigned(unsigned value)
+{
+	// 7 bits in each byte, high bit tells that more bytes follow.
+	while( value >= 0x80 )
+	{
+		writeByte(int(value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	writeByte(int(value));
+}
+
+
+void InputRecorder::writeSigned(int value)
+{
+	// Zigzag encoding keeps small negative values small.
+	writeUnsigned((unsigned(value) << 1) ^ unsigned(value >> 31));
+}
+
+
+InputPlayback::InputPlayback()
+	: Object()
+	, m_file(0)
+	, m_previousFrame()
+	, m_numFrames(0)
+{
+}
+
+
+InputPlayback::~InputPlayback()
+{
+	close();
+}
+
+
+bool InputPlayback::open(const char* fileName)
+{
+	close();
+	m_file = fopen(fileName, "rb");
+	if( m_file == 0 )
+	{
+		YAM2D_LOG_WARNING(Logger::CATEGORY_ENGINE, "[%s] Input recording %s could not be opened", __FUNCTION__, fileName);
+		return false;
+	}
+
+	bool isValid = true;
+	for( int i=0; i<4; ++i )
+	{
+		int value = 0;
+		isValid = isValid && readByte(value) && value == FILE_MAGIC[i];
+	}
+
+	int version = 0;
+	if( !isValid || !readByte(version) || version != FILE_VERSION )
+	{
+		YAM2D_LOG_WARNING(Logger::CATEGORY_ENGINE, "[%s] %s is not an input recording of version %d", __FUNCTION__, fileName, FILE_VERSION);
+		close();
+		return false;
+	}
+
+	m_previousFrame = InputFrame();
+	m_numFrames = 0;
+	return true;
+}
+
+
+void InputPlayback::close()
+{
+	if( m_file != 0 )
+	{
+		fclose(m_file);
+		m_file = 0;
+	}
+}
+
+
+bool InputPlayback::readFrame(InputFrame& frame)
+{
+	if( m_file == 0 )
+	{
+		return false;
+	}
+
+	int flags = 0;
+	if( !readByte(flags) )
+	{
+		// End of recording.
+		return false;
+	}
+
+	frame = m_previousFrame;
+	bool isValid = (flags & ~FRAME_ALL_FLAGS) == 0;
+	if( isValid && (flags & FRAME_DELTA_TIME) )
+	{
+		unsigned bits = 0;
+		for( int i=0; i<4 && isValid; ++i )
+		{
+			int value = 0;
+			isValid = readByte(value);
+			bits |= unsigned(value) << (8*i);
+		}
+		frame.deltaTime = getFloat(bits);
+	}
+
+	if( isValid && (flags & FRAME_KEYS) )
+	{
+		unsigned numKeysChanged = 0;
+		isValid = readUnsigned(numKeysChanged);
+		for( unsigned i=0; i<numKeysChanged && isValid; ++i )
+		{
+			int keyCode = 0;
+			isValid = readByte(keyCode) && keyCode < InputFrame::NUM_KEYS;
+			if( isValid )
+			{
+				frame.setKeyDown(keyCode, !frame.isKeyDown(keyCode));
+			}
+		}
+	}
+
+	if( isValid && (flags & FRAME_MOUSE_BUTTONS) )
+	{
+		int mouseButtons = 0;
+		isValid = readByte(mouseButtons);
+		for( int i=0; i<InputFrame::NUM_MOUSE_BUTTONS; ++i )
+		{
+			frame.mouseButtons[i] = (mouseButtons & (1 << i)) != 0;
+		}
+	}
+
+	if( isValid && (flags & FRAME_MOUSE_POSITION) )
+	{
+		int dx = 0;
+		int dy = 0;
+		isValid = readSigned(dx) && readSigned(dy);
+		frame.mouseX += dx;
+		frame.mouseY += dy;
+	}
+
+	if( isValid && (flags & FRAME_MOUSE_WHEEL) )
+	{
+		isValid = readSigned(frame.mouseWheelDelta);
+	}
+
+	if( isValid && (flags & FRAME_TOUCHES) )
+	{
+		unsigned numTouches = 0;
+		isValid = readUnsigned(numTouches);
+		frame.touches.clear();
+		for( unsigned i=0; i<numTouches && isValid; ++i )
+		{
+			unsigned touchId = 0;
+			int pressed = 0;
+			Touch touch;
+			isValid = readUnsigned(touchId) && readByte(pressed) && readSigned(touch.x) && readSigned(touch.y);
+			touch.touchId = int(touchId);
+			touch.pressed = pressed != 0;
+			frame.touches.push_back(touch);
+		}
+	}
+
+	if( !isValid )
+	{
+		YAM2D_LOG_WARNING(Logger::CATEGORY_ENGINE, "[%s] Input recording is corrupted at frame %d", __FUNCTION__, m_numFrames);
+		close();
+		return false;
+	}
+
+	m_previousFrame = frame;
+	++m_numFrames;
+	return true;
+}
+
+
+bool InputPlayback::readByte(int& value)
+{
+	const int c = fgetc(m_file);
+	if( c == EOF )
+	{
+		return false;
+	}
+	value = c;
+	return true;
+}
+
+
+bool InputPlayback::readUnsigned(unsigned& value)
+{
+	value = 0;
+	for( int shift=0; shift<32; shift += 7 )
+	{
+		int byte = 0;
+		if( !readByte(byte) )
+		{
+			return false;
+		}
+
+		value |= unsigned(byte & 0x7f) << shift;
+		if( (byte & 0x80) == 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool InputPlayback::readSigned(int& value)
+{
+	unsigned zigzag = 0;
+	if( !readUnsigned(zigzag) )
+	{
+		return false;
+	}
+	value = int(zigzag >> 1) ^ -int(zigzag & 1);
+	return true;
+}
+
+}
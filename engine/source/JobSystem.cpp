@@ -0,0 +1,370 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include <JobSystem.h>
+#include <Profiler.h>
+#include <es_assert.h>
+#include <stddef.h>
+
+namespace yam2d
+{
+
+// anonymous namespace for internal functions
+namespace
+{
+	// Job system and queue of the worker thread, which is running. Other threads use queue 0.
+	YAM_THREAD_LOCAL JobSystem* currentJobSystem = 0;
+	YAM_THREAD_LOCAL int currentQueueIndex = 0;
+
+	struct ParallelForState
+	{
+		AtomicInt					next;
+		int							end;
+		int							grainSize;
+		JobSystem::RangeFunction*	function;
+	};
+
+	class RangeJob : public Job
+	{
+	public:
+		RangeJob() : Job(), state(0) {}
+
+		virtual void execute()
+		{
+			while( true )
+			{
+				int begin = state->next.add(state->grainSize) - state->grainSize;
+				if( begin >= state->end )
+				{
+					return;
+				}
+
+				int end = begin + state->grainSize;
+				state->function->execute(begin, end < state->end ? end : state->end);
+			}
+		}
+
+		ParallelForState* state;
+	};
+}
+
+
+Job::Job()
+	: m_numPending(1)
+	, m_dependents()
+	, m_counter(0)
+	, m_submitted(false)
+{
+}
+
+Job::~Job()
+{
+}
+
+void Job::addDependency(Job* job)
+{
+	assert( job != 0 && job != this );
+	assert( !m_submitted && !job->m_submitted ); // Dependencies must be added before the jobs are run
+	m_numPending.increment();
+	job->m_dependents.push_back(this);
+}
+
+
+class JobSystem::Worker : public Thread
+{
+public:
+	Worker(JobSystem* jobSystem, int queueIndex)
+		: Thread()
+		, m_jobSystem(jobSystem)
+		, m_queueIndex(queueIndex)
+	{
+	}
+
+protected:
+	virtual void run()
+	{
+		currentJobSystem = m_jobSystem;
+		currentQueueIndex = m_queueIndex;
+		Profiler::setThreadName("JobSystem worker");
+		m_jobSystem->workerLoop(m_queueIndex);
+	}
+
+private:
+	JobSystem*	m_jobSystem;
+	int			m_queueIndex;
+};
+
+
+JobSystem::JobSystem(int numWorkers)
+	: Object()
+	, m_workers()
+	, m_queues()
+	, m_numQueued(0)
+	, m_numSleeping(0)
+	, m_sleepMutex()
+	, m_wakeUp()
+	, m_quit(false)
+{
+	if( numWorkers < 0 )
+	{
+		numWorkers = Thread::getNumProcessors() - 1;
+	}
+
+	for( int i=0; i<numWorkers+1; ++i )
+	{
+		m_queues.push_back(new Queue());
+	}
+
+	for( int i=0; i<numWorkers; ++i )
+	{
+		Worker* worker = new Worker(this, i+1);
+		m_workers.push_back(worker);
+		worker->start();
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	assert( m_numQueued.get() == 0 );
+	{
+		ScopedLock lock(m_sleepMutex);
+		m_quit = true;
+		m_wakeUp.broadcast();
+	}
+
+	for( size_t i=0; i<m_workers.size(); ++i )
+	{
+		if( m_workers[i]->isRunning() )
+		{
+			m_workers[i]->join();
+		}
+	}
+	m_workers.clear();
+
+	for( size_t i=0; i<m_queues.size(); ++i )
+	{
+		delete m_queues[i];
+	}
+}
+
+void JobSystem::run(Job* job, JobCounter* counter)
+{
+	assert( job != 0 );
+	assert( !job->m_submitted ); // Job is already running
+	job->m_submitted = true;
+	if( counter != 0 )
+	{
+		counter->m_count.increment();
+		job->m_counter = counter;
+	}
+
+	if( job->m_numPending.decrement() == 0 )
+	{
+		push(job);
+	}
+}
+
+void JobSystem::wait(JobCounter* counter)
+{
+	assert( counter != 0 );
+	const int queueIndex = getCurrentThreadIndex();
+	while( !counter->isDone() )
+	{
+		Job* job = pop(queueIndex);
+		if( job != 0 )
+		{
+			execute(job);
+		}
+		else
+		{
+			// Remaining jobs are running in other threads. Sleep until a job is queued or the last job of the counter 
+			// has finished, see push and execute.
+			ScopedLock lock(m_sleepMutex);
+			m_numSleeping.increment();
+			while( m_numQueued.get() == 0 && !counter->isDone() )
+			{
+				m_wakeUp.wait(m_sleepMutex);
+			}
+			m_numSleeping.decrement();
+
+			// Wake up meant for a queued job is passed on, if this thread returns without running it.
+			if( counter->isDone() && m_numQueued.get() > 0 )
+			{
+				m_wakeUp.signal();
+			}
+		}
+	}
+}
+
+void JobSystem::parallelFor(int begin, int end, int grainSize, RangeFunction* function)
+{
+	assert( grainSize > 0 );
+	assert( function != 0 );
+	const int numRanges = (end - begin + grainSize - 1) / grainSize;
+	if( numRanges <= 1 || m_workers.empty() )
+	{
+		if( begin < end )
+		{
+			function->execute(begin, end);
+		}
+		return;
+	}
+
+	ParallelForState state;
+	state.next.set(begin);
+	state.end = end;
+	state.grainSize = grainSize;
+	state.function = function;
+
+	// One job per thread is enough, because jobs take ranges until all are taken.
+	const int MAX_JOBS = 64;
+	RangeJob jobs[MAX_JOBS];
+	int numJobs = getNumWorkers() + 1;
+	numJobs = numJobs < numRanges ? numJobs : numRanges;
+	numJobs = numJobs < MAX_JOBS ? numJobs : MAX_JOBS;
+
+	JobCounter counter;
+	for( int i=0; i<numJobs; ++i )
+	{
+		jobs[i].state = &state;
+		run(&jobs[i], &counter);
+	}
+	wait(&counter);
+}
+
+int JobSystem::getCurrentThreadIndex() const
+{
+	return currentJobSystem == this ? currentQueueIndex : 0;
+}
+
+void JobSystem::push(Job* job)
+{
+	Queue* queue = m_queues[getCurrentThreadIndex()];
+	{
+		ScopedLock lock(queue->mutex);
+		queue->jobs.push_back(job);
+	}
+
+	// Sleeping workers check m_numQueued after incrementing m_numSleeping, so either they see the new job or we 
+	// see them sleeping and wake them up.
+	m_numQueued.increment();
+	if( m_numSleeping.get() > 0 )
+	{
+		ScopedLock lock(m_sleepMutex);
+		m_wakeUp.signal();
+	}
+}
+
+Job* JobSystem::pop(int queueIndex)
+{
+	if( m_numQueued.get() == 0 )
+	{
+		return 0;
+	}
+
+	// Newest job of own queue is likely to use same data as the previous job.
+	Queue* queue = m_queues[queueIndex];
+	{
+		ScopedLock lock(queue->mutex);
+		if( !queue->jobs.empty() )
+		{
+			Job* job = queue->jobs.back();
+			queue->jobs.pop_back();
+			m_numQueued.decrement();
+			return job;
+		}
+	}
+
+	// Steal oldest job of another queue, which is likely to spawn more jobs.
+	const int numQueues = (int)m_queues.size();
+	for( int i=1; i<numQueues; ++i )
+	{
+		Queue* victim = m_queues[(queueIndex + i) % numQueues];
+		ScopedLock lock(victim->mutex);
+		if( !victim->jobs.empty() )
+		{
+			Job* job = victim->jobs.front();
+			victim->jobs.pop_front();
+			m_numQueued.decrement();
+			return job;
+		}
+	}
+
+	return 0;
+}
+
+void JobSystem::execute(Job* job)
+{
+	job->execute();
+
+	// Job may be run again or deleted as soon as its counter is decremented or its dependents have run, so it 
+	// is made ready for next run before that.
+	JobCounter* counter = job->m_counter;
+	std::vector<Job*> dependents;
+	dependents.swap(job->m_dependents);
+	job->m_counter = 0;
+	job->m_numPending.set(1);
+	job->m_submitted = false;
+
+	for( size_t i=0; i<dependents.size(); ++i )
+	{
+		if( dependents[i]->m_numPending.decrement() == 0 )
+		{
+			push(dependents[i]);
+		}
+	}
+
+	// Sleeping threads may wait this counter, so all are woken up. Counter may be destroyed as soon as it is done.
+	if( counter != 0 && counter->m_count.decrement() == 0 && m_numSleeping.get() > 0 )
+	{
+		ScopedLock lock(m_sleepMutex);
+		m_wakeUp.broadcast();
+	}
+}
+
+void JobSystem::workerLoop(int queueIndex)
+{
+	while( true )
+	{
+		Job* job = pop(queueIndex);
+		if( job != 0 )
+		{
+			execute(job);
+			continue;
+		}
+
+		ScopedLock lock(m_sleepMutex);
+		m_numSleeping.increment();
+		while( m_numQueued.get() == 0 && !m_quit )
+		{
+			m_wakeUp.wait(m_sleepMutex);
+		}
+		m_numSleeping.decrement();
+
+		if( m_quit )
+		{
+			return;
+		}
+	}
+}
+
+}
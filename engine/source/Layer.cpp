@@ -24,26 +24,100 @@
 #include "Layer.h"
 #include "es_assert.h"
 #include "GameObject.h"
+#include "SpatialHashGrid.h"
+#include "DynamicAabbTree.h"
+#include "ExtentsBuffer.h"
 #include <config.h>
+#include <Logger.h>
 #include <Map.h>
+#include <algorithm>
+#include <math.h>
 
 namespace yam2d
 {
 
 using namespace std;
 
+namespace
+{
+	struct IsRenderedAfter
+	{
+		bool operator()(const GameObject* a, const GameObject* b) const
+		{
+			return a->getLayerOrder() > b->getLayerOrder();
+		}
+	};
+
+	// Separating axis test of game object extents against edge normals of convex polygon.
+	bool overlapsPolygon(const GameObject* gameObject, const vec2* points, int numPoints)
+	{
+		float centerX = 0.5f*(gameObject->getLeft() + gameObject->getRight());
+		float centerY = 0.5f*(gameObject->getTop() + gameObject->getBottom());
+		float halfWidth = 0.5f*(gameObject->getRight() - gameObject->getLeft());
+		float halfHeight = 0.5f*(gameObject->getBottom() - gameObject->getTop());
+		for( int i=0; i<numPoints; ++i )
+		{
+			const vec2& p0 = points[i];
+			const vec2& p1 = points[(i+1)%numPoints];
+			float axisX = p0.y - p1.y;
+			float axisY = p1.x - p0.x;
+
+			float minProj = axisX*points[0].x + axisY*points[0].y;
+			float maxProj = minProj;
+			for( int j=1; j<numPoints; ++j )
+			{
+				float proj = axisX*points[j].x + axisY*points[j].y;
+				minProj = std::min(minProj, proj);
+				maxProj = std::max(maxProj, proj);
+			}
+
+			float center = axisX*centerX + axisY*centerY;
+			float radius = fabsf(axisX)*halfWidth + fabsf(axisY)*halfHeight;
+			if( center + radius < minProj || center - radius > maxProj )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
 Layer::Layer(Map* map, std::string name, float opacity, bool visible, bool isStaticLayer, const PropertySet& properties )
 	: Entity(map, 0, properties)
 //, m_map(map)
 , m_name(name)
 , m_visible(visible)
 , m_gameObjects()
-, m_batch( new SpriteBatchGroup() )
 , m_opacity(opacity)
+, m_batch( new SpriteBatchGroup() )
 , m_static(isStaticLayer)
 , m_isUpdatable(true)
 , m_layerNumber(-1)
+, m_objectsToDelete()
+, m_broadphase()
+, m_nextLayerOrder(0)
+, m_pickBuffer()
 {
+	const std::string broadphase = properties.getOrDefault<std::string>("broadphase", "");
+	if( broadphase == "grid" )
+	{
+		setBroadphase(new SpatialHashGrid(properties.getOrDefault("broadphaseCellSize", 4.0f)));
+	}
+	else if( broadphase == "tree" )
+	{
+		setBroadphase(new DynamicAabbTree());
+	}
+	else if( broadphase == "extents" )
+	{
+		setBroadphase(new ExtentsBuffer());
+	}
+}
+
+
+Layer::~Layer()
+{
+	setBroadphase(0);
 }
 
 
@@ -51,7 +125,12 @@ void Layer::addGameObject(GameObject* gameObject)
 {
 	assert( gameObject != 0 );
 	gameObject->setTileSize(vec2(getMap()->getTileHeight(), getMap()->getTileWidth()));
+	gameObject->m_layerOrder = m_nextLayerOrder++;
 	m_gameObjects.push_back(gameObject);
+	if( m_broadphase != 0 )
+	{
+		m_broadphase->addGameObject(gameObject);
+	}
 	//esLogEngineDebug("Added GameObject: %s to layer: %s", gameObject->getName().c_str(), getName().c_str());
 }
 
@@ -85,6 +164,33 @@ void Layer::deleteGameObjectIfExist(GameObject* gameObject)
 	}
 }
 
+void Layer::removeGameObjects(const std::vector<GameObject*>& gameObjects)
+{
+	if( gameObjects.size() == 0 )
+		return;
+
+	std::vector<GameObject*> sorted(gameObjects);
+	std::sort(sorted.begin(), sorted.end());
+
+	size_t numKept = 0;
+	for( size_t i=0; i<m_gameObjects.size(); ++i )
+	{
+		if( !std::binary_search(sorted.begin(), sorted.end(), m_gameObjects[i].ptr()) )
+		{
+			if( numKept != i )
+			{
+				m_gameObjects[numKept] = m_gameObjects[i];
+			}
+			++numKept;
+		}
+		else if( m_broadphase != 0 && m_gameObjects[i]->getBroadphase() == m_broadphase.ptr() )
+		{
+			m_broadphase->removeGameObject(m_gameObjects[i]);
+		}
+	}
+	m_gameObjects.resize(numKept);
+}
+
 Layer::GameObjectList& Layer::getGameObjects() 
 {
 	return m_gameObjects; 
@@ -96,6 +202,12 @@ SpriteBatchGroup* Layer::getBatch()
 	return m_batch; 
 }
 
+void Layer::setBatch(SpriteBatchGroup* batch)
+{
+	assert( batch != 0 );
+	m_batch = batch;
+}
+
 
 void Layer::setDepth(float depth) 
 {
@@ -123,7 +235,12 @@ void Layer::deleteUnneededObjects()
 			}
 		}
 
-		esLogEngineDebug("Deleting game object: %s from Layer: %s", m_objectsToDelete[i]->getName().c_str(), getName().c_str() );
+		if( m_broadphase != 0 && m_objectsToDelete[i]->getBroadphase() == m_broadphase.ptr() )
+		{
+			m_broadphase->removeGameObject(m_objectsToDelete[i]);
+		}
+
+		YAM2D_LOG_DEBUG(Logger::CATEGORY_ENGINE, "Deleting game object: %s from Layer: %s", m_objectsToDelete[i]->getName().c_str(), getName().c_str() );
 		m_objectsToDelete[i] = 0; // Actual call to destructor.
 	}
 
@@ -179,20 +296,153 @@ bool Layer::isStatic() const
 
 GameObject* Layer::pick(const vec2& pos) const
 {
-	std::vector<GameObject*> res;
-	for (size_t i = 0; i < m_gameObjects.size(); ++i)
+	GameObject* result = 0;
+	pick(pos, &result, 1);
+	return result;
+}
+
+
+int Layer::pick(const vec2& pos, GameObject** results, int maxResults) const
+{
+	return pickSorted(pos, pos, 0, 0, results, maxResults);
+}
+
+
+int Layer::pickRect(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const
+{
+	return pickSorted(topLeft, bottomRight, 0, 0, results, maxResults);
+}
+
+
+int Layer::pickPolygon(const vec2* points, int numPoints, GameObject** results, int maxResults) const
+{
+	assert( points != 0 && numPoints > 0 );
+	vec2 topLeft = points[0];
+	vec2 bottomRight = points[0];
+	for( int i=1; i<numPoints; ++i )
+	{
+		topLeft.x = std::min(topLeft.x, points[i].x);
+		topLeft.y = std::min(topLeft.y, points[i].y);
+		bottomRight.x = std::max(bottomRight.x, points[i].x);
+		bottomRight.y = std::max(bottomRight.y, points[i].y);
+	}
+
+	return pickSorted(topLeft, bottomRight, points, numPoints, results, maxResults);
+}
+
+
+int Layer::pickSorted(const vec2& topLeft, const vec2& bottomRight, const vec2* points, int numPoints, GameObject** results, int maxResults) const
+{
+	int numFound = queryAabb(topLeft, bottomRight, results, maxResults);
+	GameObject** found = results;
+	if( numFound > maxResults )
 	{
-		if ( m_gameObjects[i]->isInside(pos) )
-			res.push_back( m_gameObjects[i].ptr() );
+		// Results do not fit to the buffer, so topmost ones are selected from all found objects. 
+		// Pick buffer is reused between calls and grows only when needed.
+		m_pickBuffer.resize(numFound);
+		numFound = queryAabb(topLeft, bottomRight, &m_pickBuffer[0], numFound);
+		found = &m_pickBuffer[0];
 	}
 
-	if (res.size()==0)
-		return 0;
+	// Bounds of the polygon are already tested by the query, so only polygon edge axes remain.
+	if( points != 0 )
+	{
+		int numInside = 0;
+		for( int i=0; i<numFound; ++i )
+		{
+			if( overlapsPolygon(found[i], points, numPoints) )
+			{
+				found[numInside++] = found[i];
+			}
+		}
+		numFound = numInside;
+	}
 
-	if (res.size() == 1)
-		return res[0];
+	if( found == results )
+	{
+		std::sort(results, results+numFound, IsRenderedAfter());
+	}
+	else
+	{
+		int numResults = std::min(numFound, maxResults);
+		std::partial_sort(found, found+numResults, found+numFound, IsRenderedAfter());
+		std::copy(found, found+numResults, results);
+	}
+
+	return numFound;
+}
+
+
+void Layer::setBroadphase(Broadphase* broadphase)
+{
+	if( m_broadphase != 0 )
+	{
+		m_broadphase->clear();
+	}
+
+	m_broadphase = broadphase;
+	if( m_broadphase != 0 )
+	{
+		for( size_t i=0; i<m_gameObjects.size(); ++i )
+		{
+			m_broadphase->addGameObject(m_gameObjects[i]);
+		}
+	}
+}
 
-	return res[0];
+
+int Layer::queryAabb(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const
+{
+	if( m_broadphase != 0 )
+	{
+		return m_broadphase->queryAabb(topLeft, bottomRight, results, maxResults);
+	}
+
+	int numResults = 0;
+	for( size_t i=0; i<m_gameObjects.size(); ++i )
+	{
+		GameObject* gameObject = m_gameObjects[i].ptr();
+		if( gameObject->getLeft() <= bottomRight.x && topLeft.x <= gameObject->getRight() 
+			&& gameObject->getTop() <= bottomRight.y && topLeft.y <= gameObject->getBottom() )
+		{
+			if( numResults < maxResults )
+			{
+				results[numResults] = gameObject;
+			}
+			++numResults;
+		}
+	}
+	return numResults;
+}
+
+
+int Layer::queryPoint(const vec2& position, GameObject** results, int maxResults) const
+{
+	return queryAabb(position, position, results, maxResults);
+}
+
+
+void Layer::findOverlappingPairs(Broadphase::PairCallback* callback) const
+{
+	assert( callback != 0 );
+	if( m_broadphase != 0 )
+	{
+		m_broadphase->findOverlappingPairs(callback);
+		return;
+	}
+
+	for( size_t i=0; i<m_gameObjects.size(); ++i )
+	{
+		GameObject* a = m_gameObjects[i].ptr();
+		for( size_t j=i+1; j<m_gameObjects.size(); ++j )
+		{
+			GameObject* b = m_gameObjects[j].ptr();
+			if( a->collidesTo(b) )
+			{
+				callback->onOverlap(a, b);
+			}
+		}
+	}
 }
 
 }
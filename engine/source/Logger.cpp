@@ -0,0 +1,858 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <Logger.h>
+#include <Profiler.h>
+#include <Ref.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <new>
+
+#if defined(ANDROID)
+#include <android/log.h>
+#endif
+
+namespace yam2d
+{
+
+volatile int Logger::s_level = Logger::LEVEL_DEBUG;
+volatile int Logger::s_categoryMask = (1 << Logger::NUM_CATEGORIES) - 1;
+volatile int Logger::s_rateLimit = 20;
+
+namespace
+{
+	// Conversion specifications longer than this are not captured, but formatted when written.
+	const int MAX_CONVERSION_LENGTH = 32;
+
+	// Size of formatted line. Messages formatted when written can be longer.
+	const int LINE_SIZE = 4096;
+
+	enum ThreadState
+	{
+		THREAD_NOT_STARTED,
+		THREAD_STARTING,
+		THREAD_RUNNING,
+		THREAD_STOPPED
+	};
+
+	enum ArgumentType
+	{
+		ARGUMENT_NONE,
+		ARGUMENT_INT,
+		ARGUMENT_LONG,
+		ARGUMENT_LONG_LONG,
+		ARGUMENT_SIZE,
+		ARGUMENT_PTRDIFF,
+		ARGUMENT_DOUBLE,
+		ARGUMENT_STRING,
+		ARGUMENT_POINTER,
+		ARGUMENT_UNSUPPORTED
+	};
+
+	/** Conversion specification of printf format string from '%' to conversion character. */
+	struct Conversion
+	{
+		const char*		begin;
+		const char*		end;
+		int				numStars;
+		ArgumentType	type;
+	};
+
+	/** 
+	 * Log record. Sequence tells, if the record is free or written (see claimRecord). Data has copy of format string 
+	 * followed by captured arguments, or formatted message. 
+	 */
+	struct Record
+	{
+		AtomicInt	sequence;
+		char		level;
+		char		category;
+		bool		isFormatted;
+		int			numSuppressed;
+		char*		longText;
+		char		data[Logger::RECORD_DATA_SIZE];
+	};
+
+	class FlushThread;
+
+	struct LogState
+	{
+		LogState()
+			: enqueuePosition(0)
+			, dequeuePosition(0)
+			, numDropped(0)
+			, numDroppedReported(0)
+			, threadState(THREAD_NOT_STARTED)
+			, flushMutex()
+			, isFlushThreadWaiting(0)
+			, wakeMutex()
+			, wakeCondition()
+			, flushThread()
+			, file(0)
+			, isFileOpened(false)
+		{
+			for( int i=0; i<Logger::BUFFER_SIZE; ++i )
+			{
+				records[i].sequence.set(i);
+				records[i].longText = 0;
+			}
+		}
+
+		Record				records[Logger::BUFFER_SIZE];
+		AtomicInt			enqueuePosition;
+		int					dequeuePosition;
+		AtomicInt			numDropped;
+		int					numDroppedReported;
+		AtomicInt			threadState;
+		Mutex				flushMutex;
+		AtomicInt			isFlushThreadWaiting;
+		Mutex				wakeMutex;
+		ConditionVariable	wakeCondition; // Signaled, when record is written and flush thread is waiting.
+		Ref<FlushThread>	flushThread;
+		FILE*				file;
+		bool				isFileOpened;
+		char				line[LINE_SIZE];
+	};
+
+	// State is constructed to static storage and never destroyed, so that destructors of static objects can log.
+	LogState& getState()
+	{
+		static union
+		{
+			char		bytes[sizeof(LogState)];
+			long long	alignLongLong;
+			double		alignDouble;
+			void*		alignPointer;
+		} storage;
+		static LogState* state = new(storage.bytes) LogState();
+		return *state;
+	}
+
+	/** Returns true, if record at dequeue position has been written and can be flushed. */
+	bool hasRecordToFlush(LogState& state)
+	{
+		ScopedLock lock(state.flushMutex);
+		const Record& record = state.records[state.dequeuePosition & (Logger::BUFFER_SIZE - 1)];
+		return record.sequence.get() == int(unsigned(state.dequeuePosition) + 1u);
+	}
+
+	/** Returns true, if record at position has been flushed. */
+	bool isRecordFlushed(LogState& state, int position)
+	{
+		ScopedLock lock(state.flushMutex);
+		return int(unsigned(state.dequeuePosition) - unsigned(position)) > 0;
+	}
+
+	/** Wakes flush thread, if it is waiting for records. */
+	void wakeFlushThread(LogState& state)
+	{
+		if( state.isFlushThreadWaiting.get() != 0 )
+		{
+			ScopedLock lock(state.wakeMutex);
+			state.wakeCondition.signal();
+		}
+	}
+
+	class FlushThread : public Thread
+	{
+	public:
+		FlushThread() : m_stop(0) {}
+
+		void stop() 
+		{
+			m_stop.set(1);
+			LogState& state = getState();
+			ScopedLock lock(state.wakeMutex);
+			state.wakeCondition.signal();
+		}
+
+	protected:
+		virtual void run()
+		{
+			LogState& state = getState();
+			while( m_stop.get() == 0 )
+			{
+				if( Logger::flush() > 0 )
+				{
+					continue;
+				}
+
+				// Writers check the flag after publishing a record, so either they see it and signal, or the record 
+				// is seen here before waiting.
+				ScopedLock lock(state.wakeMutex);
+				state.isFlushThreadWaiting.set(1);
+				while( m_stop.get() == 0 && !hasRecordToFlush(state) )
+				{
+					state.wakeCondition.wait(state.wakeMutex);
+				}
+				state.isFlushThreadWaiting.set(0);
+			}
+		}
+
+	private:
+		AtomicInt m_stop;
+	};
+
+	/** Formats like vsnprintf and returns length of the whole message, even if it was truncated. */
+	int formatV(char* buffer, int size, const char* format, va_list args)
+	{
+#if defined(_WIN32)
+		va_list lengthArgs;
+		va_copy(lengthArgs, args);
+		int length = _vscprintf(format, lengthArgs);
+		va_end(lengthArgs);
+		_vsnprintf_s(buffer, size, _TRUNCATE, format, args);
+		return length;
+#else
+		return vsnprintf(buffer, size, format, args);
+#endif
+	}
+
+	/** Formats like snprintf and returns number of characters written to buffer. */
+	int format(char* buffer, int size, const char* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+		int length = formatV(buffer, size, format, args);
+		va_end(args);
+		if( length < 0 )
+		{
+			return 0;
+		}
+		return (length < size) ? length : size - 1;
+	}
+
+	bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	/** Parses conversion specification starting at '%'. Type is ARGUMENT_NONE for "%%". */
+	void parseConversion(const char* p, Conversion& conversion)
+	{
+		conversion.begin = p;
+		conversion.numStars = 0;
+		conversion.type = ARGUMENT_UNSUPPORTED;
+		++p;
+		if( *p == '%' )
+		{
+			conversion.end = p + 1;
+			conversion.type = ARGUMENT_NONE;
+			return;
+		}
+
+		while( *p != 0 && strchr("-+ #0", *p) != 0 )
+		{
+			++p;
+		}
+
+		if( *p == '*' )
+		{
+			++conversion.numStars;
+			++p;
+		}
+		while( isDigit(*p) )
+		{
+			++p;
+		}
+
+		bool hasPrecision = false;
+		if( *p == '.' )
+		{
+			hasPrecision = true;
+			++p;
+			if( *p == '*' )
+			{
+				++conversion.numStars;
+				++p;
+			}
+			while( isDigit(*p) )
+			{
+				++p;
+			}
+		}
+
+		int numLongs = 0;
+		bool isSize = false;
+		bool isPtrdiff = false;
+		bool isOther = false;
+		for( ;; ++p )
+		{
+			if( *p == 'l' )
+			{
+				++numLongs;
+			}
+			else if( *p == 'z' )
+			{
+				isSize = true;
+			}
+			else if( *p == 't' )
+			{
+				isPtrdiff = true;
+			}
+			else if( *p == 'L' || *p == 'j' || *p == 'q' || *p == 'I' )
+			{
+				isOther = true;
+			}
+			else if( *p != 'h' )
+			{
+				break;
+			}
+		}
+
+		conversion.end = (*p != 0) ? p + 1 : p;
+		if( conversion.end - conversion.begin >= MAX_CONVERSION_LENGTH || isOther )
+		{
+			return;
+		}
+
+		switch( *p )
+		{
+		case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+			if( isSize )
+			{
+				conversion.type = ARGUMENT_SIZE;
+			}
+			else if( isPtrdiff )
+			{
+				conversion.type = ARGUMENT_PTRDIFF;
+			}
+			else
+			{
+				conversion.type = (numLongs >= 2) ? ARGUMENT_LONG_LONG : ((numLongs == 1) ? ARGUMENT_LONG : ARGUMENT_INT);
+			}
+			break;
+		case 'c':
+			conversion.type = (numLongs == 0) ? ARGUMENT_INT : ARGUMENT_UNSUPPORTED;
+			break;
+		case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			conversion.type = ARGUMENT_DOUBLE;
+			break;
+		case 's':
+			// Strings with precision need not be null terminated, so they can not be copied.
+			conversion.type = (numLongs == 0 && !hasPrecision) ? ARGUMENT_STRING : ARGUMENT_UNSUPPORTED;
+			break;
+		case 'p':
+			conversion.type = ARGUMENT_POINTER;
+			break;
+		default:
+			break;
+		}
+	}
+
+	template<typename T>
+	bool put(Record& record, int& position, T value)
+	{
+		if( position + int(sizeof(T)) > Logger::RECORD_DATA_SIZE )
+		{
+			return false;
+		}
+		memcpy(record.data + position, &value, sizeof(T));
+		position += int(sizeof(T));
+		return true;
+	}
+
+	template<typename T>
+	T get(const Record& record, int& position)
+	{
+		T value;
+		memcpy(&value, record.data + position, sizeof(T));
+		position += int(sizeof(T));
+		return value;
+	}
+
+	bool putString(Record& record, int& position, const char* s)
+	{
+		int length = int(strlen(s)) + 1;
+		if( position + length > Logger::RECORD_DATA_SIZE )
+		{
+			return false;
+		}
+		memcpy(record.data + position, s, length);
+		position += length;
+		return true;
+	}
+
+	/** 
+	 * Copies format string and arguments to record. Returns false, if format has conversions, which are not 
+	 * supported, or if they do not fit to the record.
+	 */
+	bool captureArguments(const char* format, va_list args, Record& record)
+	{
+		int position = 0;
+		if( !putString(record, position, format) )
+		{
+			return false;
+		}
+
+		for( const char* p = format; *p != 0; )
+		{
+			if( *p != '%' )
+			{
+				++p;
+				continue;
+			}
+
+			Conversion conversion;
+			parseConversion(p, conversion);
+			p = conversion.end;
+			if( conversion.type == ARGUMENT_UNSUPPORTED )
+			{
+				return false;
+			}
+
+			for( int i=0; i<conversion.numStars; ++i )
+			{
+				if( !put(record, position, va_arg(args, int)) )
+				{
+					return false;
+				}
+			}
+
+			bool isCaptured = true;
+			switch( conversion.type )
+			{
+			case ARGUMENT_INT:			isCaptured = put(record, position, va_arg(args, int)); break;
+			case ARGUMENT_LONG:			isCaptured = put(record, position, va_arg(args, long)); break;
+			case ARGUMENT_LONG_LONG:	isCaptured = put(record, position, va_arg(args, long long)); break;
+			case ARGUMENT_SIZE:			isCaptured = put(record, position, va_arg(args, size_t)); break;
+			case ARGUMENT_PTRDIFF:		isCaptured = put(record, position, va_arg(args, ptrdiff_t)); break;
+			case ARGUMENT_DOUBLE:		isCaptured = put(record, position, va_arg(args, double)); break;
+			case ARGUMENT_POINTER:		isCaptured = put(record, position, va_arg(args, void*)); break;
+			case ARGUMENT_STRING:
+				{
+					const char* s = va_arg(args, const char*);
+					isCaptured = putString(record, position, (s != 0) ? s : "(null)");
+				}
+				break;
+			default:
+				break;
+			}
+
+			if( !isCaptured )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	template<typename T>
+	int formatArgument(char* buffer, int size, const char* conversion, int numStars, const int* stars, T value)
+	{
+		if( numStars == 2 )
+		{
+			return format(buffer, size, conversion, stars[0], stars[1], value);
+		}
+		if( numStars == 1 )
+		{
+			return format(buffer, size, conversion, stars[0], value);
+		}
+		return format(buffer, size, conversion, value);
+	}
+
+	/** Formats message from format string and arguments captured to record. */
+	void formatRecord(const Record& record, char* line, int size)
+	{
+		int position = 0;
+		const char* p = record.data;
+		position += int(strlen(p)) + 1;
+
+		int length = 0;
+		while( *p != 0 && length < size - 1 )
+		{
+			if( *p != '%' )
+			{
+				line[length++] = *p++;
+				continue;
+			}
+
+			Conversion conversion;
+			parseConversion(p, conversion);
+			p = conversion.end;
+			if( conversion.type == ARGUMENT_NONE )
+			{
+				line[length++] = '%';
+				continue;
+			}
+
+			char spec[MAX_CONVERSION_LENGTH];
+			int specLength = int(conversion.end - conversion.begin);
+			memcpy(spec, conversion.begin, specLength);
+			spec[specLength] = 0;
+
+			int stars[2] = { 0, 0 };
+			for( int i=0; i<conversion.numStars; ++i )
+			{
+				stars[i] = get<int>(record, position);
+			}
+
+			char* out = line + length;
+			int outSize = size - length;
+			const int n = conversion.numStars;
+			switch( conversion.type )
+			{
+			case ARGUMENT_INT:			length += formatArgument(out, outSize, spec, n, stars, get<int>(record, position)); break;
+			case ARGUMENT_LONG:			length += formatArgument(out, outSize, spec, n, stars, get<long>(record, position)); break;
+			case ARGUMENT_LONG_LONG:	length += formatArgument(out, outSize, spec, n, stars, get<long long>(record, position)); break;
+			case ARGUMENT_SIZE:			length += formatArgument(out, outSize, spec, n, stars, get<size_t>(record, position)); break;
+			case ARGUMENT_PTRDIFF:		length += formatArgument(out, outSize, spec, n, stars, get<ptrdiff_t>(record, position)); break;
+			case ARGUMENT_DOUBLE:		length += formatArgument(out, outSize, spec, n, stars, get<double>(record, position)); break;
+			case ARGUMENT_POINTER:		length += formatArgument(out, outSize, spec, n, stars, get<void*>(record, position)); break;
+			case ARGUMENT_STRING:
+				{
+					const char* s = record.data + position;
+					position += int(strlen(s)) + 1;
+					length += formatArgument(out, outSize, spec, n, stars, s);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+		line[length] = 0;
+	}
+
+	void writeLine(LogState& state, Logger::Level level, const char* prefix, const char* text)
+	{
+#if defined(ANDROID)
+		static const int priorities[Logger::NUM_LEVELS] = { ANDROID_LOG_DEBUG, ANDROID_LOG_INFO, ANDROID_LOG_WARN, ANDROID_LOG_ERROR };
+		__android_log_print(priorities[level], "yam2d", "%s%s", prefix, text);
+#else
+		(void)level;
+		printf("%s%s\n", prefix, text);
+#endif
+
+#if defined(YAM_WRITING_LOGS_TO_FILE)
+		if( !state.isFileOpened )
+		{
+			const char* const logFileName = YAM_WRITING_LOGS_TO_FILE;
+			state.file = (strlen(logFileName) > 0) ? fopen(logFileName, "w") : 0;
+			state.isFileOpened = true;
+		}
+
+		if( state.file != 0 )
+		{
+			fprintf(state.file, "%s%s\n", prefix, text);
+		}
+#else
+		(void)state;
+#endif
+	}
+
+	void writeRecord(LogState& state, const Record& record)
+	{
+		const Logger::Level level = Logger::Level(record.level);
+		const Logger::Category category = Logger::Category(record.category);
+		char prefix[64];
+		int prefixLength = 0;
+		if( level != Logger::LEVEL_INFO )
+		{
+			prefixLength += format(prefix, sizeof(prefix), "%s: ", Logger::getLevelName(level));
+		}
+		if( category != Logger::CATEGORY_GENERAL )
+		{
+			prefixLength += format(prefix + prefixLength, sizeof(prefix) - prefixLength, "[%s] ", Logger::getCategoryName(category));
+		}
+		prefix[prefixLength] = 0;
+
+		if( record.numSuppressed > 0 )
+		{
+			format(state.line, LINE_SIZE, "(%d similar messages suppressed)", record.numSuppressed);
+			writeLine(state, level, prefix, state.line);
+		}
+
+		if( record.longText != 0 )
+		{
+			writeLine(state, level, prefix, record.longText);
+		}
+		else if( record.isFormatted )
+		{
+			writeLine(state, level, prefix, record.data);
+		}
+		else
+		{
+			formatRecord(record, state.line, LINE_SIZE);
+			writeLine(state, level, prefix, state.line);
+		}
+	}
+
+	/**
+	 * Claims record for writing from the ring buffer. Returns 0, if the buffer is full. 
+	 *
+	 * Record at position is free for writing, when its sequence equals the position. Writer sets sequence to 
+	 * position + 1, when the record is written, and flush sets it to position + BUFFER_SIZE, when it is free again.
+	 */
+	Record* claimRecord(LogState& state, int& position)
+	{
+		position = state.enqueuePosition.get();
+		for( ;; )
+		{
+			Record& record = state.records[position & (Logger::BUFFER_SIZE - 1)];
+			int difference = int(unsigned(record.sequence.get()) - unsigned(position));
+			if( difference == 0 )
+			{
+				if( state.enqueuePosition.compareAndSwap(position, int(unsigned(position) + 1u)) )
+				{
+					return &record;
+				}
+				position = state.enqueuePosition.get();
+			}
+			else if( difference < 0 )
+			{
+				return 0;
+			}
+			else
+			{
+				position = state.enqueuePosition.get();
+			}
+		}
+	}
+
+	void startFlushThread(LogState& state)
+	{
+		if( state.threadState.get() != THREAD_NOT_STARTED 
+			|| !state.threadState.compareAndSwap(THREAD_NOT_STARTED, THREAD_STARTING) )
+		{
+			return;
+		}
+
+		Ref<FlushThread> thread = new FlushThread();
+		if( !thread->start() )
+		{
+			state.threadState.set(THREAD_STOPPED);
+			return;
+		}
+
+		state.flushThread = thread;
+		if( !state.threadState.compareAndSwap(THREAD_STARTING, THREAD_RUNNING) )
+		{
+			// Shut down while starting.
+			thread->stop();
+			thread->join();
+			state.flushThread = 0;
+			return;
+		}
+
+		atexit(Logger::shutdown);
+	}
+}
+
+
+const char* Logger::getLevelName(Level level)
+{
+	static const char* const names[NUM_LEVELS] = { "Debug", "Info", "Warning", "Error" };
+	assert( level >= 0 && level < NUM_LEVELS );
+	return names[level];
+}
+
+
+const char* Logger::getCategoryName(Category category)
+{
+	static const char* const names[NUM_CATEGORIES] = { "general", "engine", "render", "assets", "physics", "network", "game" };
+	assert( category >= 0 && category < NUM_CATEGORIES );
+	return names[category];
+}
+
+
+void Logger::setCategoryEnabled(Category category, bool enabled)
+{
+	assert( category >= 0 && category < NUM_CATEGORIES );
+	if( enabled )
+	{
+		s_categoryMask |= (1 << category);
+	}
+	else
+	{
+		s_categoryMask &= ~(1 << category);
+	}
+}
+
+
+bool Logger::allow(LogSite& site)
+{
+	const int limit = s_rateLimit;
+	if( limit <= 0 )
+	{
+		return true;
+	}
+
+	const int second = int(Profiler::getTicks() / Profiler::getTicksPerSecond());
+	const int siteSecond = site.second.get();
+	if( siteSecond != second && site.second.compareAndSwap(siteSecond, second) )
+	{
+		site.numInSecond.set(0);
+	}
+
+	if( site.numInSecond.increment() <= limit )
+	{
+		return true;
+	}
+
+	site.numSuppressed.increment();
+	return false;
+}
+
+
+void Logger::write(LogSite* site, Level level, Category category, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	writeV(site, level, category, format, args);
+	va_end(args);
+}
+
+
+void Logger::writeV(LogSite* site, Level level, Category category, const char* format, va_list args)
+{
+	assert( level >= 0 && level < NUM_LEVELS );
+	assert( category >= 0 && category < NUM_CATEGORIES );
+	LogState& state = getState();
+	startFlushThread(state);
+
+	int position = 0;
+	Record* record = claimRecord(state, position);
+	while( record == 0 )
+	{
+		if( level != LEVEL_ERROR )
+		{
+			state.numDropped.increment();
+			return;
+		}
+
+		// Errors are never dropped, so make room by writing the buffer from this thread.
+		flush();
+		record = claimRecord(state, position);
+	}
+
+	record->level = char(level);
+	record->category = char(category);
+	record->numSuppressed = (site != 0) ? site->numSuppressed.exchange(0) : 0;
+	record->longText = 0;
+
+	va_list capturedArgs;
+	va_copy(capturedArgs, args);
+	record->isFormatted = !captureArguments(format, capturedArgs, *record);
+	va_end(capturedArgs);
+
+	if( record->isFormatted )
+	{
+		va_list formattedArgs;
+		va_copy(formattedArgs, args);
+		int length = formatV(record->data, RECORD_DATA_SIZE, format, formattedArgs);
+		va_end(formattedArgs);
+		if( length >= RECORD_DATA_SIZE )
+		{
+			record->longText = (char*)malloc(length + 1);
+			if( record->longText != 0 )
+			{
+				formatV(record->longText, length + 1, format, args);
+			}
+		}
+	}
+
+	record->sequence.set(int(unsigned(position) + 1u));
+
+	if( level == LEVEL_ERROR )
+	{
+		// Records claimed earlier by other threads may still be being written, and flush stops at the first one, 
+		// so wait for them to be written until this record has been flushed.
+		while( !isRecordFlushed(state, position) )
+		{
+			if( flush() == 0 )
+			{
+				Thread::sleep(0);
+			}
+		}
+	}
+	else if( state.threadState.get() != THREAD_RUNNING )
+	{
+		flush();
+	}
+	else
+	{
+		wakeFlushThread(state);
+	}
+}
+
+
+int Logger::flush()
+{
+	LogState& state = getState();
+	ScopedLock lock(state.flushMutex);
+	int numWritten = 0;
+	for( ;; )
+	{
+		Record& record = state.records[state.dequeuePosition & (BUFFER_SIZE - 1)];
+		if( record.sequence.get() != int(unsigned(state.dequeuePosition) + 1u) )
+		{
+			break;
+		}
+
+		writeRecord(state, record);
+		free(record.longText);
+		record.longText = 0;
+		record.sequence.set(int(unsigned(state.dequeuePosition) + unsigned(BUFFER_SIZE)));
+		state.dequeuePosition = int(unsigned(state.dequeuePosition) + 1u);
+		++numWritten;
+	}
+
+	const int numDropped = state.numDropped.get();
+	if( numDropped != state.numDroppedReported )
+	{
+		format(state.line, LINE_SIZE, "%d log messages dropped, because log buffer was full", numDropped - state.numDroppedReported);
+		writeLine(state, LEVEL_WARNING, "Warning: ", state.line);
+		state.numDroppedReported = numDropped;
+	}
+
+	if( numWritten > 0 && state.file != 0 )
+	{
+		fflush(state.file);
+	}
+
+	return numWritten;
+}
+
+
+void Logger::shutdown()
+{
+	LogState& state = getState();
+	if( state.threadState.exchange(THREAD_STOPPED) == THREAD_RUNNING )
+	{
+		state.flushThread->stop();
+		state.flushThread->join();
+		state.flushThread = 0;
+	}
+	flush();
+}
+
+
+int Logger::getNumDropped()
+{
+	return getState().numDropped.get();
+}
+
+}
@@ -26,12 +26,17 @@
 #include <Tileset.h>
 #include "Layer.h"
 #include "es_util.h"
-#include <tmx-parser/Tmx.h>
+#include <TmxReader.h>
 #include <Texture.h>
 #include <Camera.h>
 #include <config.h>
 #include <MapController.h>
 #include <ElapsedTimer.h>
+#include <AssetLoader.h>
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <Logger.h>
+#include <algorithm>
 
 
 namespace yam2d
@@ -90,11 +95,11 @@ Entity* DefaultComponentFactory::createNewEntity(ComponentFactory* componentFact
 	{
 		if (type.length() > 0)
 		{
-			esLogMessage("Warning: Creating game object of unknown type: \"%s\".", type.c_str());
+			YAM2D_LOG_WARNING(Logger::CATEGORY_ASSETS, "Creating game object of unknown type: \"%s\".", type.c_str());
 		}
 		else
 		{
-			esLogMessage("Warning: Creating game object of unknown (empty) type.");
+			YAM2D_LOG_WARNING(Logger::CATEGORY_ASSETS, "Creating game object of unknown (empty) type.");
 		}
 	}
 
@@ -104,7 +109,7 @@ Entity* DefaultComponentFactory::createNewEntity(ComponentFactory* componentFact
 // anonymous namespace for internal functions
 namespace
 {	
-	int compareXY(const void* o1, const void* o2)
+/*	int compareXY(const void* o1, const void* o2)
 	{
 		GameObject* go1 = *((GameObject**)o1);
 		GameObject* go2 = *((GameObject**)o2);
@@ -113,7 +118,7 @@ namespace
 		vec2 p2 = Map::isometricToOrthogonal(go2->getLeft(),go2->getTop());
 
 		return int((p1.y-p2.y)*2000.0f);
-	}
+	}*/
 
 	Tileset* defaultCreateNewTileset(void*, const std::string& name, SpriteSheet* spriteSheet, float tileOffsetX, float tileOffsetY, const PropertySet& properties )
 	{
@@ -121,10 +126,10 @@ namespace
 	}
 
 
-	Layer* defaultCreateNewLayer(void*, Map* map, const std::string& name, float opacity, bool visible, const PropertySet& properties)
+/*	Layer* defaultCreateNewLayer(void*, Map* map, const std::string& name, float opacity, bool visible, const PropertySet& properties)
 	{
 		return new Layer(map, name, opacity, visible, false, properties); //create dynamic layer
-	}
+	}*/
 
 	/*
 	GameObject* defaultCreateNewTile(void*, Map* map, Layer* , const vec2& position, Tileset* tileset, unsigned id, bool flippedHorizontally, bool flippedVertically, bool flippedDiagonally, const PropertySet& )
@@ -199,6 +204,11 @@ Map::Map( float tileWidth, float tileHeight, MapOrientation orientation, const P
 	, m_layers()
 	, m_properties(properties)
 	, m_needsBatching(true)
+	, m_tileGrid()
+	, m_updateScheduler()
+	, m_renderSnapshotBuffer()
+	, m_updatableComponents()
+	, m_interpolationAlpha(1.0f)
 {
 }
 
@@ -236,6 +246,22 @@ void Map::deleteGameObject(GameObject* gameObject)
 	}
 }
 
+void Map::setTileGrid(TileGrid* tileGrid)
+{
+	m_tileGrid = tileGrid;
+}
+
+void Map::setUpdateScheduler(UpdateScheduler* updateScheduler)
+{
+	m_updateScheduler = updateScheduler;
+}
+
+void Map::setRenderSnapshotBuffer(RenderSnapshotBuffer* renderSnapshotBuffer)
+{
+	m_renderSnapshotBuffer = renderSnapshotBuffer;
+	m_needsBatching = true;
+}
+
 GameObject* Map::findGameObjectByName(const std::string& name)
 {
 	for( int l=0; l<NUM_LAYERS; ++l )
@@ -257,6 +283,71 @@ GameObject* Map::findGameObjectByName(const std::string& name)
 	return 0;
 }
 
+int Map::pick(const vec2& mapPosition, GameObject** results, int maxResults)
+{
+	return pickRect(mapPosition, mapPosition, results, maxResults);
+}
+
+GameObject* Map::pick(const vec2& mapPosition)
+{
+	GameObject* result = 0;
+	pick(mapPosition, &result, 1);
+	return result;
+}
+
+int Map::pickRect(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults)
+{
+	// Layers with bigger index are rendered on top.
+	int numFound = 0;
+	for( LayerMap::reverse_iterator it = m_layers.rbegin(); it != m_layers.rend(); ++it )
+	{
+		Layer* layer = it->second;
+		if( layer && layer->isVisible() )
+		{
+			int numWritten = std::min(numFound, maxResults);
+			numFound += layer->pickRect(topLeft, bottomRight, results+numWritten, maxResults-numWritten);
+		}
+	}
+
+	return numFound;
+}
+
+int Map::pickScreen(const vec2& screenPosition, GameObject** results, int maxResults)
+{
+	return pick(screenToMapCoordinates(screenPosition), results, maxResults);
+}
+
+int Map::pickScreenRect(const vec2& screenTopLeft, const vec2& screenBottomRight, GameObject** results, int maxResults)
+{
+	vec2 corners[4] = 
+	{
+		screenToMapCoordinates(screenTopLeft.x, screenTopLeft.y),
+		screenToMapCoordinates(screenBottomRight.x, screenTopLeft.y),
+		screenToMapCoordinates(screenBottomRight.x, screenBottomRight.y),
+		screenToMapCoordinates(screenTopLeft.x, screenBottomRight.y)
+	};
+
+	if( m_orientation != ISOMETRIC )
+	{
+		vec2 topLeft(std::min(corners[0].x, corners[2].x), std::min(corners[0].y, corners[2].y));
+		vec2 bottomRight(std::max(corners[0].x, corners[2].x), std::max(corners[0].y, corners[2].y));
+		return pickRect(topLeft, bottomRight, results, maxResults);
+	}
+
+	int numFound = 0;
+	for( LayerMap::reverse_iterator it = m_layers.rbegin(); it != m_layers.rend(); ++it )
+	{
+		Layer* layer = it->second;
+		if( layer && layer->isVisible() )
+		{
+			int numWritten = std::min(numFound, maxResults);
+			numFound += layer->pickPolygon(corners, 4, results+numWritten, maxResults-numWritten);
+		}
+	}
+
+	return numFound;
+}
+
 vec2 Map::tileToScreenCoordinates(float x, float y)
 {
 	if( m_orientation == ISOMETRIC )
@@ -486,7 +577,10 @@ bool Map::isVisible(GameObject* go, Camera* cam)
 
 void Map::batchLayer(Layer* layer, bool cullInvisibleObjects)
 {
+	YAM2D_PROFILE_ZONE("Map::batchLayer");
 	assert( layer->isVisible() );
+	long long startTicks = Profiler::getTicks();
+	RenderStats::setCurrentLayer(layer->getLayerIndex());
 
 	// Clear batch
 	layer->getBatch()->clear();
@@ -518,9 +612,12 @@ void Map::batchLayer(Layer* layer, bool cullInvisibleObjects)
 		}
 	}
 
+	RenderStats::addCulled(int(gameObjects.size() - gameObjectsToBeRendered.size()));
+
 	// Don't render of no objects.
 	if( gameObjectsToBeRendered.size() <= 0 )
 	{
+		RenderStats::setCurrentLayer(RenderStats::NO_LAYER);
 		return;
 	}
 
@@ -540,6 +637,10 @@ void Map::batchLayer(Layer* layer, bool cullInvisibleObjects)
 		layer->setDepth( layer->getDepth()+delta );
 		renderLayerObject(gameObjectsToBeRendered[i],layer);
 	}	
+
+	layer->getBatch()->addBatchedToRenderStats();
+	RenderStats::addBatchTime(float(double(Profiler::getTicks() - startTicks) * 1000.0 / double(Profiler::getTicksPerSecond())));
+	RenderStats::setCurrentLayer(RenderStats::NO_LAYER);
 }
 
 
@@ -548,8 +649,56 @@ void Map::clearMapLayers()
 	m_layers.clear();
 }
 
+void Map::captureRenderSnapshot(RenderSnapshot* snapshot)
+{
+	YAM2D_PROFILE_ZONE("Map::captureRenderSnapshot");
+	snapshot->setCamera(m_mainCamera, tileToDeviceCoordinates(m_mainCamera->getPosition()));
+	updateCameraSize(m_mainCamera, this);
+
+	for( int i=0; i<NUM_LAYERS; ++i )
+	{
+		Layer* layer = m_layers[i];
+		if( layer == 0 || !layer->isVisible() )
+		{
+			continue;
+		}
+
+		layer->setDepth( float(i) );
+		if( layer->isStatic() )
+		{
+			// Render thread may still draw the previous batch, so static layers are batched again to a new one.
+			if( m_needsBatching )
+			{
+				layer->setBatch(new SpriteBatchGroup());
+				batchLayer(layer,false);
+			}
+
+			snapshot->addLayer(i, layer->getBatch());
+		}
+		else
+		{
+			snapshot->addLayer(i);
+			Layer::GameObjectList& gameObjects = layer->getGameObjects();
+			for( size_t j=0; j<gameObjects.size(); ++j )
+			{
+				renderLayerObject(gameObjects[j], layer, snapshot);
+			}
+		}
+	}
+
+	m_needsBatching = false;
+}
+
 void Map::render()
 {
+	YAM2D_PROFILE_ZONE("Map::render");
+	if( m_renderSnapshotBuffer != 0 )
+	{
+		// Map may be updated at the same time, so only the published snapshot is accessed.
+		m_renderSnapshotBuffer->render();
+		return;
+	}
+
 	// Batch static layers
 	if( m_needsBatching )
 	{
@@ -593,16 +742,49 @@ void Map::render()
 
 		if( layer && layer->isVisible() )
 		{
+			RenderStats::setCurrentLayer(i);
 			renderCamera(m_mainCamera,layer);
 			layer->getBatch()->render();
 		}
 	}
+	RenderStats::setCurrentLayer(RenderStats::NO_LAYER);
 }
 
 
 
 void Map::update( float deltaTime )
 {
+	YAM2D_PROFILE_ZONE("Map::update");
+
+	// Transforms before this update are the start point of render interpolation.
+	for( int i=0; i<NUM_LAYERS; ++i )
+	{
+		Layer* layer = m_layers[i];
+		if( layer && !layer->isStatic() )
+		{
+			Layer::GameObjectList& gameObjects = layer->getGameObjects();
+			for( size_t j=0; j<gameObjects.size(); ++j )
+			{
+				gameObjects[j]->storePreviousTransform();
+			}
+		}
+	}
+
+	// Update components of the map, like PhysicsWorld, before game objects, which depend on them.
+	{
+		YAM2D_PROFILE_ZONE("Map::updateComponents");
+		getComponentsOfInterface<Updatable>(m_updatableComponents);
+		for( size_t i=0; i<m_updatableComponents.size(); ++i )
+		{
+			m_updatableComponents[i]->update(deltaTime);
+		}
+	}
+
+	if( m_updateScheduler != 0 )
+	{
+		m_updateScheduler->beginFrame(m_mainCamera);
+	}
+
 	// Update all layers
 	for( int i=0; i<NUM_LAYERS; ++i )
 	{
@@ -610,20 +792,41 @@ void Map::update( float deltaTime )
 
 		if( layer && layer->isUpdatable() )
 		{
-			updateLayer(layer,deltaTime);
+			if( m_updateScheduler != 0 )
+			{
+				m_updateScheduler->updateLayer(layer,deltaTime);
+			}
+			else
+			{
+				updateLayer(layer,deltaTime);
+			}
 		}
 	}
+
+	if( m_updateScheduler != 0 )
+	{
+		m_updateScheduler->applyCommands(this);
+	}
 	
 	// Delete unneeded layer gameobjects
-	for( int i=0; i<NUM_LAYERS; ++i )
 	{
-		Layer* layer = m_layers[i];
-
-		if( layer && !layer->isStatic() )
+		YAM2D_PROFILE_ZONE("Map::deleteUnneededObjects");
+		for( int i=0; i<NUM_LAYERS; ++i )
 		{
-			layer->deleteUnneededObjects();
+			Layer* layer = m_layers[i];
+
+			if( layer && !layer->isStatic() )
+			{
+				layer->deleteUnneededObjects();
+			}
 		}
 	}
+
+	if( m_renderSnapshotBuffer != 0 )
+	{
+		captureRenderSnapshot(m_renderSnapshotBuffer->beginWrite());
+		m_renderSnapshotBuffer->publish();
+	}
 }
 
 /*
@@ -655,45 +858,194 @@ GameObject* TmxMap::MapCreateCallbacks::createNewGameObject( Map* map, Layer* la
 
 bool TmxMap::loadMapFile(const std::string& mapFileName, ComponentFactory* componentFactory)
 {
-
-	yam2d::ElapsedTimer timer;
-	timer.reset();
+	YAM2D_PROFILE_ZONE("TmxMap::loadMapFile");
+	MemoryStats::LevelLoadScope levelLoad(mapFileName);
 	//esLogMessage("Parsing tmx-file");
 	m_loadedMapFileName = mapFileName;
 	std::string path = getPath(mapFileName);	
 
-	Tmx::Map map;
-	map.ParseFile(mapFileName.c_str());
-	
-	if( map.HasError() )
+	// Map is read with streaming reader, so layers and objects are created while the file is being read.
+	TmxReader reader;
+	if( !reader.open(mapFileName) )
 	{
 		esLogEngineError("[%s] Map file: %s could not be found!", __FUNCTION__, mapFileName.c_str() ); 
 		return false;
 	}
 
-	m_orientation = (map.GetOrientation() == Tmx::TMX_MO_ISOMETRIC) ? ISOMETRIC : ORTHOGONAL;
-	m_tileWidth = float(map.GetTileWidth());
-	m_tileHeight = float(map.GetTileHeight());
-	m_width = float(map.GetWidth());
-	m_height = float(map.GetHeight());
 	m_tilesets.clear();
+	m_tilesetTileSizes.clear();
+	m_tileProperties.clear();
+	m_solidTiles.clear();
+	setTileGrid(0);
+
+	int layerIndex = MAPLAYER0 - 1;
+	int layerWidth = 0;
+	TmxReader::Event event = reader.next();
+	while( event != TmxReader::EVENT_END )
+	{
+		switch( event )
+		{
+		case TmxReader::EVENT_MAP:
+			m_orientation = (reader.getOrientation() == TmxReader::ORIENTATION_ISOMETRIC) ? ISOMETRIC : ORTHOGONAL;
+			m_tileWidth = float(reader.getTileWidth());
+			m_tileHeight = float(reader.getTileHeight());
+			m_width = float(reader.getWidth());
+			m_height = float(reader.getHeight());
+			getProperties().setValues(reader.getProperties());
+			break;
+
+		case TmxReader::EVENT_TILESET:
+			{
+				YAM2D_PROFILE_ZONE("TmxMap::createTileset");
+				if( !createTileset(reader, path) )
+				{
+					return false;
+				}
+			}
+			break;
+
+		case TmxReader::EVENT_TILE_LAYER:
+		case TmxReader::EVENT_OBJECT_LAYER:
+			{
+				YAM2D_PROFILE_ZONE("TmxMap::createLayer");
+				if( layerIndex == MAPLAYER0 - 1 )
+				{
+					YAM2D_LOG_DEBUG(Logger::CATEGORY_ASSETS, "[%s] Texture memory in use: %d bytes", __FUNCTION__, Texture::getTotalSizeInBytes());
+				}
+
+				++layerIndex;
+				const TmxReader::Layer& l = reader.getLayer();
+				PropertySet properties;
+				properties.setValues(l.properties);
+				//esLogEngineDebug("Creating layer # MAPLAYER%d : \"%s\" visible: %s", layerIndex-MAPLAYER0, l.name.c_str(), l.visible ? "true":"false" );
+
+				properties["type"] = "Layer";
+				properties["name"] = l.name;
+				properties["layerIndex"] = layerIndex;
+				properties["opacity"] = l.opacity;
+				properties["visible"] = l.visible;
+				addLayer(layerIndex, (Layer*)componentFactory->createNewComponent("Layer", this, properties));
+				assert(getLayers()[layerIndex] != 0); // You must return new Layer in createLayer callback!!
+
+				if( event == TmxReader::EVENT_TILE_LAYER )
+				{
+					layerWidth = l.width;
+					getLayers()[layerIndex]->reserve(l.width*l.height);
+				}
+			}
+			break;
+
+		case TmxReader::EVENT_TILES:
+			{
+				// Chunk of tiles in row major order.
+				YAM2D_PROFILE_ZONE("TmxMap::loadTiles");
+				const std::vector<uint32_t>& tiles = reader.getTiles();
+				const std::vector<TmxReader::Tileset>& tilesets = reader.getTilesets();
+				int x = reader.getTilesStartIndex() % layerWidth;
+				int y = reader.getTilesStartIndex() / layerWidth;
+				for( size_t t=0; t<tiles.size(); ++t )
+				{
+					const uint32_t gid = tiles[t];
+					const int tilesetIndex = gid != 0 ? reader.findTilesetIndex(gid) : -1;
+					if( tilesetIndex >= 0 && tilesetIndex < (int)m_tilesets.size() )
+					{
+						const unsigned id = (gid & TmxReader::GID_MASK) - tilesets[tilesetIndex].firstGid;
+						const std::vector<bool>& solidTiles = m_solidTiles[tilesetIndex];
+						if( id < solidTiles.size() && solidTiles[id] )
+						{
+							setSolidTile(x, y);
+						}
+
+						onTileLoaded(componentFactory, layerIndex, x, y, tilesetIndex, id,
+							(gid & TmxReader::FLIPPED_HORIZONTALLY_FLAG) != 0, (gid & TmxReader::FLIPPED_VERTICALLY_FLAG) != 0, (gid & TmxReader::FLIPPED_DIAGONALLY_FLAG) != 0);
+					}
+
+					if( ++x == layerWidth )
+					{
+						x = 0;
+						++y;
+					}
+				}
+			}
+			break;
+
+		case TmxReader::EVENT_OBJECT:
+			{
+				YAM2D_PROFILE_ZONE("TmxMap::loadObject");
+				loadObject(componentFactory, layerIndex, reader);
+			}
+			break;
+
+		case TmxReader::EVENT_ERROR:
+			esLogEngineError("[%s] Map file: %s could not be parsed: %s", __FUNCTION__, mapFileName.c_str(), reader.getErrorText().c_str() ); 
+			return false;
+
+		default:
+			break;
+		}
+
+		event = reader.next();
+	}
+
+	return true;
+}
 
-	getProperties().setValues(map.GetProperties().GetList());
-	//esLogMessage("Parsing tmx-file done. Time: %2.4f", timer.getTime());
 
-	// Create tilesets
-	timer.reset();
-	//esLogMessage("Creating %d tilesets", (int)m_tilesets.size());
-	m_tilesets.resize(map.GetNumTilesets());
-	for( size_t i=0; i<m_tilesets.size(); ++i )
+bool TmxMap::createTileset(const TmxReader& reader, const std::string& path)
+{
+	const TmxReader::Tileset& tileset = reader.getTileset();
+	m_tilesetTileSizes.push_back(vec2(float(tileset.tileWidth) / float(getTileWidth()), float(tileset.tileHeight) / float(getTileHeight())));
+	m_tileProperties.push_back(std::map<unsigned, PropertySet>());
+	m_solidTiles.push_back(std::vector<bool>());
+	for( std::map<unsigned, TmxReader::Properties>::const_iterator it = tileset.tileProperties.begin(); it != tileset.tileProperties.end(); ++it )
 	{
-		const Tmx::Tileset* tileset = map.GetTileset(i);
-		std::string texFileName = path + tileset->GetImage()->GetSource();
-		//esLogEngineDebug("Creating tileset: %s from texture \"%s\"", tileset->GetName().c_str(), texFileName.c_str() );
-		Texture* texture = new Texture( texFileName.c_str() );
-		
+		PropertySet& tileProperties = m_tileProperties.back()[it->first];
+		tileProperties.setValues(it->second);
+		if( tileProperties.getOrDefault<bool>("solid", false) )
+		{
+			std::vector<bool>& solidTiles = m_solidTiles.back();
+			if( it->first >= solidTiles.size() )
+			{
+				solidTiles.resize(it->first + 1, false);
+			}
+			solidTiles[it->first] = true;
+		}
+	}
+
+	if( tileset.imageSource.length() == 0 )
+	{
+		esLogEngineError("[%s] Tileset %s has no image!", __FUNCTION__, tileset.name.c_str());
+		return false;
+	}
+
+	std::string texFileName = path + tileset.imageSource;
+	const std::string& transparentColor = tileset.imageTransparentColor;
+	PropertySet properties;
+	properties.setValues(tileset.properties);
+
+	// Reduced precision or compressed texture format from tileset properties "textureFormat" and "textureDither".
+	Texture::Format textureFormat = Texture::getFormatFromString(properties.getOrDefault<std::string>("textureFormat", ""));
+	bool textureDither = properties.getOrDefault<bool>("textureDither", false);
+
+	Ref<Texture> texture;
+	if( m_assetLoader != 0 )
+	{
+		// Use texture prefetched by the asset loader or, if not yet loaded, finish loading it now.
+		Ref<AssetHandle> handle = m_assetLoader->loadTexture(texFileName, AssetLoader::PRIORITY_HIGHEST, textureFormat, textureDither, transparentColor);
+		m_assetLoader->finish(handle);
+		texture = handle->getTexture();
+		if( texture.ptr() == 0 )
+		{
+			esLogEngineError("[%s] Tileset texture %s could not be loaded!", __FUNCTION__, texFileName.c_str());
+			return false;
+		}
+	}
+	else
+	{
+		//esLogEngineDebug("Creating tileset: %s from texture \"%s\"", tileset.name.c_str(), texFileName.c_str() );
+		texture = new Texture( texFileName.c_str() );
+	
 		// convert transparent_color
-		std::string transparentColor = tileset->GetImage()->GetTransparentColor();
 		if( transparentColor.length() > 0 )
 		{
 			int color(0);
@@ -704,248 +1056,203 @@ bool TmxMap::loadMapFile(const std::string& mapFileName, ComponentFactory* compo
 #endif
 			texture->setTransparentColor( (unsigned char)((color&0xff0000) >> 16), (unsigned char)((color&0xff00) >> 8), (unsigned char)((color&0xff) >> 0) );
 		}
-		
-		// Create sprite sheet
-		SpriteSheet* spriteSheet = SpriteSheet::generateSpriteSheet(texture, tileset->GetImage()->GetWidth(), tileset->GetImage()->GetHeight(),
-			tileset->GetTileWidth(), tileset->GetTileHeight(),
-			tileset->GetMargin(), tileset->GetMargin(),
-			tileset->GetSpacing(), tileset->GetSpacing() );
-		PropertySet properties;
-		properties.setValues(tileset->GetProperties().GetList());
-		//assert( m_createNewTileset != 0 );
-		m_tilesets[i] = defaultCreateNewTileset(0, tileset->GetName(), spriteSheet, float(tileset->GetTileOffsetX()), float(tileset->GetTileOffsetY()), properties);
-		assert( m_tilesets[i] != 0 ); // You must return new Tileset in createTileset callback!!
+
+		if( textureFormat != Texture::FORMAT_DEFAULT )
+		{
+			texture->setFormat(textureFormat, textureDither);
+		}
 	}
+	
+	// Create sprite sheet
+	SpriteSheet* spriteSheet = SpriteSheet::generateSpriteSheet(texture.ptr(), tileset.imageWidth, tileset.imageHeight,
+		tileset.tileWidth, tileset.tileHeight,
+		tileset.margin, tileset.margin,
+		tileset.spacing, tileset.spacing );
+	//assert( m_createNewTileset != 0 );
+	m_tilesets.push_back(defaultCreateNewTileset(0, tileset.name, spriteSheet, float(tileset.tileOffsetX), float(tileset.tileOffsetY), properties));
+	assert( m_tilesets.back() != 0 ); // You must return new Tileset in createTileset callback!!
+	return true;
+}
 
-	//esLogMessage("Creating tilesets done. Time: %2.4f", timer.getTime());
 
-	// Create layers
+void TmxMap::loadObject(ComponentFactory* componentFactory, int layerIndex, const TmxReader& reader)
+{
+	const TmxReader::Object& o = reader.getObject();
 
-	timer.reset();
-	//esLogMessage("Creating %d layers", map.GetNumLayers());
-	for( int i=0; i<map.GetNumLayers(); ++i )
-	{
-		const Tmx::Layer* l = map.GetLayer(i);
-		PropertySet properties;
-		
-		properties.setValues(l->GetProperties().GetList());
-		//esLogEngineDebug("Creating layer # MAPLAYER%d : \"%s\" visible: %s", i, l->GetName().c_str(), l->IsVisible() ? "true":"false" );
+	// Tiled has different coordinates for objects. In Tiled the tile object has zero in bottom left corner. Adjust accordingly. Also the rotation is reverse and in degrees.
+	vec2 positionInTiles(o.x / float(getTileWidth()), o.y / float(getTileHeight()));
+	vec2 sizeInTiles(o.width / float(getTileWidth()), o.height / float(getTileHeight()));
 
-		properties["type"] = "Layer";
-		properties["name"] = l->GetName();
-		properties["layerIndex"] = (int)MAPLAYER0 + i;
-		properties["opacity"] = l->GetOpacity();
-		properties["visible"] = l->IsVisible();
-		addLayer(MAPLAYER0 + i, (Layer*)componentFactory->createNewComponent("Layer", this, properties));
-		assert(getLayers()[MAPLAYER0+i] != 0); // You must return new Layer in createLayer callback!!
-	}
-	//esLogMessage("Creating layers done. Time: %2.4f", timer.getTime());
+	// COnvert coordinates to yam2d.
+	positionInTiles.x = positionInTiles.x + sizeInTiles.x * 0.5f - 1.0f;
+	positionInTiles.y = positionInTiles.y + sizeInTiles.y * 0.5f - 0.5f;
+
+	PropertySet properties;
+	properties.setValues(o.properties);
 
-	// Create tiles
-	for( int i=0; i<map.GetNumLayers(); ++i )
+	if (o.type.length() > 0)
 	{
-		if( dynamic_cast<const Tmx::TileLayer*>(map.GetLayer(i)) )
-		{
-			int numObjects = 0;
-			const Tmx::TileLayer* const l = dynamic_cast<const Tmx::TileLayer*>(map.GetLayer(i));
-			float timeProperties = 0.0f;
-			float timeCreate = 0.0f;
-			
-			getLayers()[MAPLAYER0 + i]->reserve(l->GetHeight()*l->GetWidth());
+		properties["type"] = o.type;
+	}
+	properties["name"] = o.name;
+	properties["positionX"] = positionInTiles.x;
+	properties["positionY"] = positionInTiles.y;
+	properties["sizeX"] = sizeInTiles.x;
+	properties["sizeY"] = sizeInTiles.y;
+
+	int tilesetIndex = -1;
+	if( o.gid > 0 )
+	{
+		tilesetIndex = reader.findTilesetIndex(o.gid);
+		assert( tilesetIndex >= 0 && tilesetIndex < (int)m_tilesets.size() );
+		const TmxReader::Tileset& ts = reader.getTilesets()[tilesetIndex];
 
-			//esLogMessage("Creating %d tile layer tiles for layer", l->GetHeight()*l->GetWidth());
+		int id = (o.gid & TmxReader::GID_MASK) - ts.firstGid;
+		properties["id"] = id;
 
-			for( int y=0; y<l->GetHeight(); ++y )
+		std::map<unsigned, TmxReader::Properties>::const_iterator tileProperties = ts.tileProperties.find(id);
+		if (tileProperties != ts.tileProperties.end())
+		{
+			const TmxReader::Properties& v = tileProperties->second;
+			for (TmxReader::Properties::const_iterator it = v.begin(); it != v.end(); ++it)
 			{
-				for( int x=0; x<l->GetWidth(); ++x )
-				{
-					timer.reset();
-					const Tmx::MapTile& tile = l->GetTile(x,y);
-					
-					if (tile.tilesetId >= 0 && tile.tilesetId < map.GetNumTilesets())
-					{
-						Tileset* tileset = m_tilesets[tile.tilesetId];
-						const Tmx::Tileset* ts = map.GetTileset(tile.tilesetId);
-						const Tmx::Tile* tileSetTile = ts->GetTile(tile.id);
-						PropertySet properties;
-						if (tileSetTile != 0)
-						{
-							properties.setValues(tileSetTile->GetProperties().GetList());
-						}
-					
-						vec2 sizeInTiles(float(ts->GetTileWidth()) / float(getTileWidth()), float(ts->GetTileHeight()) / float(getTileHeight()));
-						if (!properties.hasProperty("type"))
-						{
-							properties["type"] = "Tile";
-						}
-						properties["positionX"] = (float)x - 1.0f + 0.5f*sizeInTiles.x;
-						properties["positionY"] = (float)y;
-						properties["sizeX"] = sizeInTiles.x;
-						properties["sizeY"] = sizeInTiles.y;
-						properties["id"] = (int)tile.id;
+				properties[it->first] = it->second;
+			}
+		}
 
-						if (tile.flippedHorizontally)
-							properties["flippedHorizontally"] = tile.flippedHorizontally;
+		if (!properties.hasProperty("type"))
+		{
+			std::string type = o.type;
+			if (type == "")
+			{
+				type = "Tile";
+			}
+			
+			properties["type"] = type;
+		}
 
-						if (tile.flippedVertically)
-							properties["flippedVertically"] = tile.flippedVertically;
 
-						if (tile.flippedDiagonally)
-							properties["flippedDiagonally"] = tile.flippedDiagonally;
+		properties["positionY"] = positionInTiles.y - 1.0f;
+		properties["positionX"] = positionInTiles.x;// -0.5f*sizeInTiles.x;
+	}
+	else if( o.isPolygon )
+	{
+		esLogEngineError("Polygons not yet implemented in map load");
+		return;
+	}
+	else if( o.isPolyline )
+	{
+		esLogEngineError("Polylines not yet implemented in map load");
+		return;
+	}
+	else if( o.isEllipse )
+	{
+		esLogEngineError("Ellipses not yet implemented in map load");
+		return;
+	}
 
-						timeProperties += timer.getTime();
-						timer.reset();
-						GameObject* gameObject = (GameObject*)componentFactory->createNewEntity(componentFactory, properties["type"].get<std::string>(), getLayers()[MAPLAYER0 + i], properties);
-						if (gameObject != 0)
-						{
-							gameObject->getComponent<TileComponent>()->setTileSet(tileset);
-							++numObjects;
-							getLayers()[MAPLAYER0 + i]->addGameObject(gameObject);
-						}
-						timeCreate += timer.getTime();
-					}
-				}
-			}
+	// regular game object or tile object
+	onObjectLoaded(componentFactory, layerIndex, properties, tilesetIndex);
+}
 
-			//esLogMessage("numObjects: %d timeCreate: %2.3f, timeProperties: %2.3f objs/s: %4.2f", numObjects, timeCreate, timeProperties,
-			//	(float)numObjects / (timeCreate + timeProperties));
 
-			//esLogEngineDebug("Created %d objects to tile layer \"%s\"", numObjects, l->GetName().c_str() );
+void TmxMap::setSolidTile(int x, int y)
+{
+	if( getTileGrid() == 0 )
+	{
+		// Cell (x,y) of the grid covers same area as tile game object created by createTileGameObject.
+		setTileGrid(new TileGrid(int(m_width), int(m_height), vec2(-1.0f, -0.5f)));
+	}
 
-			//esLogMessage("Creating tile layer tiles done.");
-		}
-		else
-		{
-			//esLogMessage("Creating object layer objects");
-			int numObjects = 0;
-			const Tmx::ObjectLayer* const l = dynamic_cast<const Tmx::ObjectLayer*>(map.GetLayer(i));
-			assert(l);
-			const std::vector< Tmx::Object* > objects = l->GetObjects();
+	TileGrid* tileGrid = getTileGrid();
+	if( x < tileGrid->getWidth() && y < tileGrid->getHeight() )
+	{
+		tileGrid->setSolid(x, y, true);
+	}
+}
 
-			for (size_t x = 0; x < objects.size(); ++x)
-			{
-				const Tmx::Object* o = objects[x];
-				GameObject* tNew = 0;
 
-				// Tiled has different coordinates for objects. In Tiled the tile object has zero in bottom left corner. Adjust accordingly. Also the rotation is reverse and in degrees.
-				vec2 positionInTiles(float(o->GetX()) / float(getTileWidth()), float(o->GetY()) / float(getTileHeight()));
-				vec2 sizeInTiles(float(o->GetWidth()) / float(getTileWidth()), float(o->GetHeight()) / float(getTileHeight()));
+void TmxMap::onTileLoaded(ComponentFactory* componentFactory, int layerIndex, int x, int y, int tilesetIndex, unsigned id, bool flippedHorizontally, bool flippedVertically, bool flippedDiagonally)
+{
+	createTileGameObject(componentFactory, layerIndex, x, y, tilesetIndex, id, flippedHorizontally, flippedVertically, flippedDiagonally);
+}
 
-				// COnvert coordinates to yam2d.
-				positionInTiles.x = positionInTiles.x + sizeInTiles.x * 0.5f - 1.0f;
-				positionInTiles.y = positionInTiles.y + sizeInTiles.y * 0.5f - 0.5f;
 
-				PropertySet properties;
-				properties.setValues(o->GetProperties().GetList());
+void TmxMap::onObjectLoaded(ComponentFactory* componentFactory, int layerIndex, const PropertySet& properties, int tilesetIndex)
+{
+	createObjectGameObject(componentFactory, layerIndex, properties, tilesetIndex);
+}
 
-				if (o->GetType().length() > 0)
-				{
-					properties["type"] = o->GetType();
-				}
-				properties["name"] = o->GetName();
-				properties["positionX"] = positionInTiles.x;
-				properties["positionY"] = positionInTiles.y;
-				properties["sizeX"] = sizeInTiles.x;
-				properties["sizeY"] = sizeInTiles.y;
-	
-				if( o->GetGid() > 0 )
-				{
-					int tilesetIndex = map.FindTilesetIndex(o->GetGid());
 
-					Tileset* tileset = m_tilesets[tilesetIndex];
-					const Tmx::Tileset* ts = map.GetTileset(tilesetIndex);
+GameObject* TmxMap::createTileGameObject(ComponentFactory* componentFactory, int layerIndex, int x, int y, int tilesetIndex, unsigned id, bool flippedHorizontally, bool flippedVertically, bool flippedDiagonally)
+{
+	assert( tilesetIndex >= 0 && tilesetIndex < (int)m_tilesets.size() );
+	Tileset* tileset = m_tilesets[tilesetIndex];
+	PropertySet properties;
+	std::map<unsigned, PropertySet>::const_iterator tileProperties = m_tileProperties[tilesetIndex].find(id);
+	if( tileProperties != m_tileProperties[tilesetIndex].end() )
+	{
+		properties = tileProperties->second;
+	}
 
-					int id = o->GetGid() - ts->GetFirstGid();
-					const Tmx::Tile* tileSetTile = ts->GetTile(id);
+	const vec2& sizeInTiles = m_tilesetTileSizes[tilesetIndex];
+	if (!properties.hasProperty("type"))
+	{
+		properties["type"] = "Tile";
+	}
+	properties["positionX"] = (float)x - 1.0f + 0.5f*sizeInTiles.x;
+	properties["positionY"] = (float)y;
+	properties["sizeX"] = sizeInTiles.x;
+	properties["sizeY"] = sizeInTiles.y;
+	properties["id"] = (int)id;
 
-					properties["id"] = id;
+	if (flippedHorizontally)
+		properties["flippedHorizontally"] = flippedHorizontally;
 
-					if (tileSetTile != 0)
-					{
-						std::map< std::string, std::string > v = tileSetTile->GetProperties().GetList();
-						for (std::map< std::string, std::string >::const_iterator it = v.begin(); it != v.end(); ++it)
-						{
-							properties[it->first] = it->second;
-						}
-					}
+	if (flippedVertically)
+		properties["flippedVertically"] = flippedVertically;
 
-					if (!properties.hasProperty("type"))
-					{
-						std::string type = o->GetType();
-						if (type == "")
-						{
-							type = "Tile";
-						}
-						
-						properties["type"] = type;
-					}
+	if (flippedDiagonally)
+		properties["flippedDiagonally"] = flippedDiagonally;
 
+	Layer* layer = getLayers()[layerIndex];
+	const std::string type = properties["type"].get<std::string>();
+	GameObject* gameObject = (GameObject*)componentFactory->createNewEntity(componentFactory, type, layer, properties);
+	if (gameObject != 0)
+	{
+		gameObject->getComponent<TileComponent>()->setTileSet(tileset);
+		layer->addGameObject(gameObject);
+	}
 
-					properties["positionY"] = positionInTiles.y - 1.0f;
-					properties["positionX"] = positionInTiles.x;// -0.5f*sizeInTiles.x;
-					
-					tNew = (GameObject*)componentFactory->createNewEntity(componentFactory, properties["type"].get<std::string>(), getLayers()[MAPLAYER0 + i], properties);
-					if (tNew != 0)
-					{
-						assert(tNew->getComponent<TileComponent>() != 0); // You need to add Tile component to the game object.
-						tNew->getComponent<TileComponent>()->setTileSet(tileset);
-					}
-				}
-				else if( o->GetPolygon() != 0)
-				{
-					esLogEngineError("Polygons not yet implemented in map load");
-					// polygon
-				/*	size
-					position
-					o->GetPolygon() 
-					o->GetName();
-					o->GetProperties();
-					o->GetType();*/
-				}
-				else if( o->GetPolyline() != 0 )
-				{
-					esLogEngineError("Polylines not yet implemented in map load");
-					/*size
-					position
-					o->GetPolyline() 
-					o->GetName();
-					o->GetProperties();
-					o->GetType();*/
-				}
-				else if( o->isEllipse() )
-				{
-					esLogEngineError("Ellipses not yet implemented in map load");
-					// ellipse
-				/*	size
-					position
-					o->GetPolyline() 
-					o->GetName();
-					o->GetProperties();
-					o->GetType();*/
-				}
-				else
-				{
-					// regular game object
-					tNew = (GameObject*)componentFactory->createNewEntity(componentFactory, o->GetType(), getLayers()[MAPLAYER0 + i], properties);
-				}
+	return gameObject;
+}
 
-				if( tNew != 0 )
-				{
-					++numObjects;
-					tNew->setTileSize(vec2(m_tileWidth, m_tileHeight));
-					tNew->setSize(vec2(float(o->GetWidth()), float(o->GetHeight())));
-					getLayers()[MAPLAYER0+i]->addGameObject(tNew);
-				}
-			}
 
-		//	esLogEngineDebug("Created %d objects to object layer \"%s\"", numObjects, l->GetName().c_str());
-		//	esLogMessage("Creating object layer objects done.");
-		}		
-	}	
-	
-	return true;
+GameObject* TmxMap::createObjectGameObject(ComponentFactory* componentFactory, int layerIndex, const PropertySet& properties, int tilesetIndex)
+{
+	// Type is copied, because string properties are returned in a shared buffer, which the factory may overwrite 
+	// by reading other properties, like name.
+	Layer* layer = getLayers()[layerIndex];
+	const std::string type = properties.getOrDefault<std::string>("type", "");
+	GameObject* gameObject = (GameObject*)componentFactory->createNewEntity(componentFactory, type, layer, properties);
+	if( gameObject == 0 )
+	{
+		return 0;
+	}
+
+	if( tilesetIndex >= 0 )
+	{
+		assert(gameObject->getComponent<TileComponent>() != 0); // You need to add Tile component to the game object.
+		gameObject->getComponent<TileComponent>()->setTileSet(m_tilesets[tilesetIndex]);
+	}
+
+	gameObject->setTileSize(vec2(m_tileWidth, m_tileHeight));
+	gameObject->setSize(vec2(properties.getOrDefault("sizeX", 0.0f)*m_tileWidth, properties.getOrDefault("sizeY", 0.0f)*m_tileHeight));
+	layer->addGameObject(gameObject);
+	return gameObject;
 }
 
+
 TmxMap::TmxMap()
 	: Map( 0, 0, ORTHOGONAL )
 	, m_width( 0 )
@@ -956,7 +1263,11 @@ TmxMap::TmxMap()
 	, m_createNewTile( defaultCreateNewTile )
 	, m_createNewGameObject( defaultCreateNewGameObject )*/
 	, m_tilesets()
+	, m_tilesetTileSizes()
+	, m_tileProperties()
+	, m_solidTiles()
 	, m_loadedMapFileName("")
+	, m_assetLoader(0)
 {
 }
 
@@ -36,6 +36,9 @@
 #include <SpriteSheetComponent.h>
 #include <AnimatedSpriteComponent.h>
 #include <TextComponent.h>
+#include <RenderSnapshot.h>
+#include <MapController.h>
+#include <Profiler.h>
 
 
 namespace yam2d
@@ -47,15 +50,51 @@ using namespace std;
 
 
 
-void Renderer_renderSpriteComponent(SpriteComponent* spriteComponent, Layer* layer);
+void Renderer_renderSpriteComponent(SpriteComponent* spriteComponent, Layer* layer, RenderSnapshot* snapshot);
 
-void Renderer_renderTile(TileComponent* tileComponent, Layer* layer)
+// Adds sprite to render snapshot, if given, otherwise to batch of the layer.
+void Renderer_addSprite(Layer* layer, RenderSnapshot* snapshot, Texture* texture, Sprite* sprite, const vec2& position, float rotation, const vec2& scale = vec2(1.0f), const vec2& offset = vec2(0.0f))
+{
+	if( snapshot != 0 )
+	{
+		snapshot->addSprite(texture, sprite, position, rotation, scale, offset);
+	}
+	else
+	{
+		layer->getBatch()->addSprite(texture, sprite, position, rotation, scale, offset);
+	}
+}
+
+// Returns position of game object in device coordinates. Game objects of dynamic layers, which are batched directly, 
+// are interpolated between the last two updates.
+vec2 Renderer_getPosition(GameObject* gameObject, Layer* layer, RenderSnapshot* snapshot)
+{
+	Map* map = layer->getMap();
+	vec2 position = gameObject->getPosition();
+	if( snapshot == 0 && !layer->isStatic() )
+	{
+		position = gameObject->getInterpolatedPosition(map->getInterpolationAlpha());
+	}
+	return map->tileToDeviceCoordinates(position.x, position.y);
+}
+
+// Returns rotation of game object, interpolated like in Renderer_getPosition.
+float Renderer_getRotation(GameObject* gameObject, Layer* layer, RenderSnapshot* snapshot)
+{
+	if( snapshot == 0 && !layer->isStatic() )
+	{
+		return gameObject->getInterpolatedRotation(layer->getMap()->getInterpolationAlpha());
+	}
+	return gameObject->getRotation();
+}
+
+void Renderer_renderTile(TileComponent* tileComponent, Layer* layer, RenderSnapshot* snapshot)
 {
 	if (tileComponent->getTileset() != 0)
 	{
 		GameObject* gameObject = tileComponent->getGameObject();
 
-		vec2 position = layer->getMap()->tileToDeviceCoordinates(gameObject->getPosition().x, gameObject->getPosition().y);
+		vec2 position = Renderer_getPosition(gameObject, layer, snapshot);
 		tileComponent->getSprite()->setDepth(layer->getDepth());
 		tileComponent->getSprite()->setOpacity(layer->getOpacity());
 		Tileset* tileset = tileComponent->getTileset();
@@ -87,31 +126,25 @@ void Renderer_renderTile(TileComponent* tileComponent, Layer* layer)
 		p.y += layer->getMap()->getTileWidth() * 0.5f;
 		p.x -= layer->getMap()->getTileWidth() * 1.0f;
 
-		if (gameObject->getName() == "Ball")
-		{
-			int i = 0;
-			i;
-		}
-
-		layer->getBatch()->addSprite(tex, tileComponent->getSprite(), p, gameObject->getRotation(), scale, vec2(0,0));
+		Renderer_addSprite(layer, snapshot, tex, tileComponent->getSprite(), p, Renderer_getRotation(gameObject, layer, snapshot), scale, vec2(0,0));
 	}
 }
 
 
-void Renderer_renderSpriteSheet(SpriteSheetComponent* spriteSheetComponent, Layer* layer)
+void Renderer_renderSpriteSheet(SpriteSheetComponent* spriteSheetComponent, Layer* layer, RenderSnapshot* snapshot)
 {
 	Texture* tex = spriteSheetComponent->getSpriteSheet()->getTexture();
 	Sprite::PixelClip clip = spriteSheetComponent->getSpriteSheet()->getClip(spriteSheetComponent->getIdInSpriteSheet());
 	spriteSheetComponent->getSprite()->setClip(float(tex->getWidth()), float(tex->getHeight()), clip);
-	Renderer_renderSpriteComponent(spriteSheetComponent,layer);
+	Renderer_renderSpriteComponent(spriteSheetComponent,layer,snapshot);
 }
 
 
-void Renderer_renderSpriteComponent(SpriteComponent* spriteComponent, Layer* layer)
+void Renderer_renderSpriteComponent(SpriteComponent* spriteComponent, Layer* layer, RenderSnapshot* snapshot)
 {
 	if (spriteComponent->isRenderingEnabled())
 	{
-		vec2 position = layer->getMap()->tileToDeviceCoordinates(spriteComponent->getGameObject()->getPosition().x, spriteComponent->getGameObject()->getPosition().y);
+		vec2 position = Renderer_getPosition(spriteComponent->getGameObject(), layer, snapshot);
 		spriteComponent->getSprite()->setDepth(layer->getDepth());
 		spriteComponent->getSprite()->setOpacity(layer->getOpacity());
 		spriteComponent->getSprite()->setScale(spriteComponent->getGameObject()->getSize());
@@ -121,14 +154,14 @@ void Renderer_renderSpriteComponent(SpriteComponent* spriteComponent, Layer* lay
 
 		position.y += layer->getMap()->getTileWidth() * 0.5f;
 		position.x -= layer->getMap()->getTileHeight() * 1.0f;
-		float rotation = spriteComponent->getRotation() + spriteComponent->getGameObject()->getRotation();
-		layer->getBatch()->addSprite(spriteComponent->getTexture(), spriteComponent->getSprite(), position, -rotation, vec2(spriteComponent->getScaling()));
+		float rotation = spriteComponent->getRotation() + Renderer_getRotation(spriteComponent->getGameObject(), layer, snapshot);
+		Renderer_addSprite(layer, snapshot, spriteComponent->getTexture(), spriteComponent->getSprite(), position, -rotation, vec2(spriteComponent->getScaling()));
 	}
 }
 
-void Renderer_renderSprite(Sprite* sprite, Layer* layer)
+void Renderer_renderSprite(Sprite* sprite, Layer* layer, RenderSnapshot* snapshot)
 {
-	vec2 position = layer->getMap()->tileToDeviceCoordinates(sprite->getGameObject()->getPosition().x, sprite->getGameObject()->getPosition().y);
+	vec2 position = Renderer_getPosition(sprite->getGameObject(), layer, snapshot);
 	sprite->setDepth(layer->getDepth());
 	sprite->setOpacity(layer->getOpacity());
 	sprite->setScale(sprite->getGameObject()->getSize());
@@ -138,45 +171,60 @@ void Renderer_renderSprite(Sprite* sprite, Layer* layer)
 
 	position.y += layer->getMap()->getTileWidth() * 0.5f;
 	position.x -= layer->getMap()->getTileHeight() * 1.0f;
-	layer->getBatch()->addSprite(0, sprite, position, -sprite->getGameObject()->getRotation(), vec2(1.0f));
+	Renderer_addSprite(layer, snapshot, 0, sprite, position, -Renderer_getRotation(sprite->getGameObject(), layer, snapshot), vec2(1.0f));
 }
 
 
-void Renderer_renderText(Text* textComponent, Layer* layer)
+void Renderer_renderText(Text* textComponent, Layer* layer, RenderSnapshot* snapshot)
 {
 	GameObject* go = textComponent->getGameObject();
-	vec2 position = layer->getMap()->tileToDeviceCoordinates(go->getPosition().x, go->getPosition().y);
+	vec2 position = Renderer_getPosition(go, layer, snapshot);
+	const float rotation = Renderer_getRotation(go, layer, snapshot);
 	textComponent->setDepth(layer->getDepth());
 	textComponent->setOpacity(layer->getOpacity());
 
-	layer->getBatch()->addText(textComponent->getFont()->getTexture(), textComponent, position, -go->getRotation());
+	if( snapshot != 0 )
+	{
+		snapshot->addText(textComponent->getFont()->getTexture(), textComponent, position, -rotation);
+	}
+	else
+	{
+		layer->getBatch()->addText(textComponent->getFont()->getTexture(), textComponent, position, -rotation);
+	}
 }
 
 
-void Renderer_renderAnimatedSprite(AnimatedSpriteComponent* animatedSpriteComponent, Layer* layer)
+void Renderer_renderAnimatedSprite(AnimatedSpriteComponent* animatedSpriteComponent, Layer* layer, RenderSnapshot* snapshot)
 {
 	int index = animatedSpriteComponent->getAnimation()->getCurrentClipIndex();
 	if( index >= 0 )
 	{
 		animatedSpriteComponent->setIdInSpriteSheet(index);
 	}
-	Renderer_renderSpriteSheet(animatedSpriteComponent,layer);
+	Renderer_renderSpriteSheet(animatedSpriteComponent,layer,snapshot);
 }
 
 
 void renderCamera(Camera* camera, Layer* layer)
+{
+	vec2 camPos = layer->getMap()->tileToDeviceCoordinates(camera->getPosition());
+	renderCamera(camera->getScreenWidth(), camera->getScreenHeight(), camera->getDesiredAspectRatio(), camera->getScreenUnitSize(), camPos);
+	updateCameraSize(camera, layer->getMap());
+}
+
+void renderCamera(int screenWidth, int screenHeight, float desiredAspectRatio, float screenUnitSize, const vec2& devicePosition)
 {
 //	glClear ( GL_DEPTH_BUFFER_BIT );
 	// Set the viewport with tear edges
-	esViewportTearEdges(camera->getScreenWidth(), camera->getScreenHeight(), camera->getDesiredAspectRatio());
+	esViewportTearEdges(screenWidth, screenHeight, desiredAspectRatio);
 	
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 
-	float left = -0.5f*camera->getDesiredAspectRatio()*camera->getScreenUnitSize();
-	float right = 0.5f*camera->getDesiredAspectRatio()*camera->getScreenUnitSize();
-	float bottom = -0.5f*camera->getScreenUnitSize();
-	float top = 0.5f*camera->getScreenUnitSize();
+	float left = -0.5f*desiredAspectRatio*screenUnitSize;
+	float right = 0.5f*desiredAspectRatio*screenUnitSize;
+	float bottom = -0.5f*screenUnitSize;
+	float top = 0.5f*screenUnitSize;
 	
 	//SCREEN_UNIT_SIZE = esContext->width;
 	//glOrthof( 2.1f*left, 2.1f*right, 2.1f*bottom, 2.1f*top, 1.0f, -1.0f);
@@ -199,16 +247,22 @@ void renderCamera(Camera* camera, Layer* layer)
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 
+	glTranslatef( -devicePosition.x, -devicePosition.y, 0);
+}
 
-	vec2 camPos = layer->getMap()->tileToDeviceCoordinates(camera->getPosition());
-	glTranslatef( -camPos.x, -camPos.y, 0);
+void updateCameraSize(Camera* camera, Map* map)
+{
+	float left = -0.5f*camera->getDesiredAspectRatio()*camera->getScreenUnitSize();
+	float right = 0.5f*camera->getDesiredAspectRatio()*camera->getScreenUnitSize();
+	float bottom = -0.5f*camera->getScreenUnitSize();
+	float top = 0.5f*camera->getScreenUnitSize();
 
 	float sizeX = float(right-left);//m_desiredAspectRatio * (m_screenUnitSize);
 	float sizeY = float(top-bottom);//(m_screenUnitSize);
 
 	vec2 camSizeInTiles = vec2(sizeX,sizeY);
-	camSizeInTiles.x /= layer->getMap()->getTileWidth();
-	camSizeInTiles.y /= layer->getMap()->getTileHeight();
+	camSizeInTiles.x /= map->getTileWidth();
+	camSizeInTiles.y /= map->getTileHeight();
 	camera->setSize(camSizeInTiles);
 }
 
@@ -231,6 +285,7 @@ void updateGameObject(GameObject* gameObject, float deltaTime)
 
 void updateLayer(Layer* layer, float deltaTime)
 {
+	YAM2D_PROFILE_ZONE("updateLayer");
 	Layer::GameObjectList& gameObjects = layer->getGameObjects();
 	for (size_t i = 0; i<gameObjects.size(); ++i)
 	{
@@ -238,14 +293,14 @@ void updateLayer(Layer* layer, float deltaTime)
 	}
 }
 
-void renderLayerObject(GameObject* gameObject, Layer* layer)
+void renderLayerObject(GameObject* gameObject, Layer* layer, RenderSnapshot* snapshot)
 {
 #if 1
 	{
 		std::vector<AnimatedSpriteComponent*> animatedSpriteComponents = gameObject->getComponents<AnimatedSpriteComponent>();
 		for (size_t i = 0; i < animatedSpriteComponents.size(); ++i)
 		{
-			Renderer_renderAnimatedSprite(animatedSpriteComponents[i], layer);
+			Renderer_renderAnimatedSprite(animatedSpriteComponents[i], layer, snapshot);
 		}
 	}
 
@@ -254,7 +309,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		std::vector<SpriteSheetComponent*> spriteSheetComponents = gameObject->getComponents<SpriteSheetComponent>();
 		for (size_t i = 0; i < spriteSheetComponents.size(); ++i)
 		{
-			Renderer_renderSpriteSheet(spriteSheetComponents[i], layer);
+			Renderer_renderSpriteSheet(spriteSheetComponents[i], layer, snapshot);
 		}
 	}
 
@@ -262,7 +317,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		std::vector<SpriteComponent*> spriteComponents = gameObject->getComponents<SpriteComponent>();
 		for (size_t i = 0; i < spriteComponents.size(); ++i)
 		{
-			Renderer_renderSpriteComponent(spriteComponents[i], layer);
+			Renderer_renderSpriteComponent(spriteComponents[i], layer, snapshot);
 		}
 	}
 
@@ -270,7 +325,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		std::vector<Sprite*> sprites = gameObject->getComponents<Sprite>();
 		for (size_t i = 0; i < sprites.size(); ++i)
 		{
-			Renderer_renderSprite(sprites[i], layer);
+			Renderer_renderSprite(sprites[i], layer, snapshot);
 		}
 	}
 
@@ -278,7 +333,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		std::vector<TileComponent*> tileComponents = gameObject->getComponents<TileComponent>();
 		for (size_t i = 0; i < tileComponents.size(); ++i)
 		{
-			Renderer_renderTile(tileComponents[i], layer);
+			Renderer_renderTile(tileComponents[i], layer, snapshot);
 		}
 	}
 
@@ -286,7 +341,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		std::vector < Text*> texts = gameObject->getComponents<Text>();
 		for (size_t i = 0; i < texts.size(); ++i)
 		{
-			Renderer_renderText(texts[i], layer);
+			Renderer_renderText(texts[i], layer, snapshot);
 		}
 	}
 
@@ -294,7 +349,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		std::vector < TextComponent*> texts = gameObject->getComponents<TextComponent>();
 		for (size_t i = 0; i < texts.size(); ++i)
 		{
-			Renderer_renderText(texts[i]->getText(), layer);
+			Renderer_renderText(texts[i]->getText(), layer, snapshot);
 		}
 	}
 #else
@@ -302,7 +357,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		AnimatedSpriteComponent* go = dynamic_cast<AnimatedSpriteComponent*>(gameObject);
 		if (go != 0)
 		{
-			Renderer_renderAnimatedSprite(go, layer);
+			Renderer_renderAnimatedSprite(go, layer, snapshot);
 			return;
 		}
 	}
@@ -311,7 +366,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		SpriteSheetComponent* go = dynamic_cast<SpriteSheetComponent*>(gameObject);
 		if (go != 0)
 		{
-			Renderer_renderSpriteSheet(go, layer);
+			Renderer_renderSpriteSheet(go, layer, snapshot);
 			return;
 		}
 	}
@@ -320,7 +375,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		SpriteComponent* go = dynamic_cast<SpriteComponent*>(gameObject);
 		if (go != 0)
 		{
-			Renderer_renderSprite(go, layer);
+			Renderer_renderSprite(go, layer, snapshot);
 			return;
 		}
 	}
@@ -329,7 +384,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		TileComponent* go = dynamic_cast<TileComponent*>(gameObject);
 		if (go != 0)
 		{
-			Renderer_renderTile(go, layer);
+			Renderer_renderTile(go, layer, snapshot);
 			return;
 		}
 	}
@@ -338,7 +393,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		Text* go = dynamic_cast<Text*>(gameObject);
 		if (go != 0)
 		{
-			Renderer_renderText(go, layer);
+			Renderer_renderText(go, layer, snapshot);
 			return;
 		}
 	}
@@ -347,7 +402,7 @@ void renderLayerObject(GameObject* gameObject, Layer* layer)
 		TextComponent* go = dynamic_cast<TextComponent*>(gameObject);
 		if (go != 0)
 		{
-			Renderer_renderText(go->getText(), layer);
+			Renderer_renderText(go->getText(), layer, snapshot);
 			return;
 		}
 	}
@@ -0,0 +1,303 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <MemoryStats.h>
+#include <Object.h>
+#include <Thread.h>
+#include <es_util.h>
+
+namespace yam2d
+{
+
+// anonymous namespace for internal functions
+namespace
+{
+	struct Counters
+	{
+		AtomicInt	numObjects[MemoryStats::NUM_SUBSYSTEMS];
+		AtomicInt	numBytes[MemoryStats::NUM_SUBSYSTEMS];
+		AtomicInt	highWaterBytes[MemoryStats::NUM_SUBSYSTEMS];
+		AtomicInt	totalBytes;
+		AtomicInt	totalHighWaterBytes;
+	};
+
+	// Objects may be created by static initializers of other files, so counters are created on first use.
+	Counters& getCounters()
+	{
+		static Counters counters;
+		return counters;
+	}
+
+	const char* const subsystemNames[MemoryStats::NUM_SUBSYSTEMS] = 
+	{
+		"other objects",
+		"textures",
+		"vertex buffers",
+		"property sets",
+		"components",
+		"entities"
+	};
+
+	Mutex levelLoadMutex;
+	int levelLoadDepth = 0;
+	std::string levelLoadName;
+	MemoryStats::Snapshot levelLoadStart;
+	std::string lastLevelLoadName;
+	MemoryStats::Snapshot lastLevelLoad;
+	bool levelLoadLogging = false;
+
+	void raiseHighWaterMark(AtomicInt& highWaterBytes, int numBytes)
+	{
+		int highWater = highWaterBytes.get();
+		while( numBytes > highWater && !highWaterBytes.compareAndSwap(highWater, numBytes) )
+		{
+			highWater = highWaterBytes.get();
+		}
+	}
+
+	void add(MemoryStats::Subsystem subsystem, int numObjects, int numBytes)
+	{
+		Counters& counters = getCounters();
+		if( numObjects != 0 )
+		{
+			counters.numObjects[subsystem].add(numObjects);
+		}
+
+		if( numBytes != 0 )
+		{
+			int bytes = counters.numBytes[subsystem].add(numBytes);
+			int totalBytes = counters.totalBytes.add(numBytes);
+			if( numBytes > 0 )
+			{
+				raiseHighWaterMark(counters.highWaterBytes[subsystem], bytes);
+				raiseHighWaterMark(counters.totalHighWaterBytes, totalBytes);
+			}
+		}
+	}
+
+	float toMegabytes(int numBytes)
+	{
+		return float(numBytes) / (1024.0f*1024.0f);
+	}
+}
+
+
+const char* MemoryStats::getSubsystemName(Subsystem subsystem)
+{
+	assert( subsystem >= 0 && subsystem < NUM_SUBSYSTEMS );
+	return subsystemNames[subsystem];
+}
+
+
+void MemoryStats::addBytes(Subsystem subsystem, int numBytes)
+{
+	add(subsystem, 0, numBytes);
+}
+
+
+void MemoryStats::updateBytes(Subsystem subsystem, int& accountedBytes, int numBytes)
+{
+	if( numBytes != accountedBytes )
+	{
+		add(subsystem, 0, numBytes - accountedBytes);
+		accountedBytes = numBytes;
+	}
+}
+
+
+int MemoryStats::getBytes(Subsystem subsystem)
+{
+	return getCounters().numBytes[subsystem].get();
+}
+
+
+int MemoryStats::getTotalBytes()
+{
+	return getCounters().totalBytes.get();
+}
+
+
+void MemoryStats::addObject(Subsystem subsystem)
+{
+	add(subsystem, 1, 0);
+}
+
+
+void MemoryStats::removeObject(Subsystem subsystem)
+{
+	add(subsystem, -1, 0);
+}
+
+
+void MemoryStats::takeSnapshot(Snapshot& snapshot)
+{
+	Counters& counters = getCounters();
+	for( int i=0; i<NUM_SUBSYSTEMS; ++i )
+	{
+		snapshot.subsystems[i].numObjects = counters.numObjects[i].get();
+		snapshot.subsystems[i].numBytes = counters.numBytes[i].get();
+		snapshot.subsystems[i].highWaterBytes = counters.highWaterBytes[i].get();
+	}
+	snapshot.totalBytes = counters.totalBytes.get();
+	snapshot.totalHighWaterBytes = counters.totalHighWaterBytes.get();
+	Object::getLiveObjectTypes(snapshot.types);
+}
+
+
+void MemoryStats::diff(const Snapshot& before, const Snapshot& after, Snapshot& difference)
+{
+	for( int i=0; i<NUM_SUBSYSTEMS; ++i )
+	{
+		difference.subsystems[i].numObjects = after.subsystems[i].numObjects - before.subsystems[i].numObjects;
+		difference.subsystems[i].numBytes = after.subsystems[i].numBytes - before.subsystems[i].numBytes;
+		difference.subsystems[i].highWaterBytes = after.subsystems[i].highWaterBytes;
+	}
+	difference.totalBytes = after.totalBytes - before.totalBytes;
+	difference.totalHighWaterBytes = after.totalHighWaterBytes;
+
+	// Types are matched by name. Types, which did not change, are left out.
+	difference.types.clear();
+	for( size_t i=0; i<after.types.size(); ++i )
+	{
+		TypeStats type = after.types[i];
+		for( size_t j=0; j<before.types.size(); ++j )
+		{
+			if( before.types[j].name == type.name )
+			{
+				type.numObjects -= before.types[j].numObjects;
+				type.numBytes -= before.types[j].numBytes;
+				break;
+			}
+		}
+
+		if( type.numObjects != 0 || type.numBytes != 0 )
+		{
+			difference.types.push_back(type);
+		}
+	}
+
+	for( size_t i=0; i<before.types.size(); ++i )
+	{
+		bool found = false;
+		for( size_t j=0; j<after.types.size() && !found; ++j )
+		{
+			found = after.types[j].name == before.types[i].name;
+		}
+
+		if( !found )
+		{
+			TypeStats type = before.types[i];
+			type.numObjects = -type.numObjects;
+			type.numBytes = -type.numBytes;
+			difference.types.push_back(type);
+		}
+	}
+}
+
+
+void MemoryStats::logSnapshot(const Snapshot& snapshot, const char* title, int maxTypes)
+{
+	esLogMessage("%s: %.2f MB, high-water %.2f MB", title, toMegabytes(snapshot.totalBytes), toMegabytes(snapshot.totalHighWaterBytes));
+	for( int i=0; i<NUM_SUBSYSTEMS; ++i )
+	{
+		const SubsystemStats& subsystem = snapshot.subsystems[i];
+		if( subsystem.numObjects == 0 && subsystem.numBytes == 0 && subsystem.highWaterBytes == 0 )
+		{
+			continue;
+		}
+
+		esLogMessage("  %-16s %8d objects %10.2f MB high-water %10.2f MB", subsystemNames[i], subsystem.numObjects, 
+			toMegabytes(subsystem.numBytes), toMegabytes(subsystem.highWaterBytes));
+	}
+
+	for( int i=0; i<(int)snapshot.types.size() && i<maxTypes; ++i )
+	{
+		const TypeStats& type = snapshot.types[i];
+		esLogMessage("  %8d objects %10d bytes %s", type.numObjects, type.numBytes, type.name.c_str());
+	}
+}
+
+
+void MemoryStats::beginLevelLoad(const std::string& name)
+{
+	ScopedLock lock(levelLoadMutex);
+	if( levelLoadDepth++ > 0 )
+	{
+		return;
+	}
+
+	Counters& counters = getCounters();
+	for( int i=0; i<NUM_SUBSYSTEMS; ++i )
+	{
+		counters.highWaterBytes[i].set(counters.numBytes[i].get());
+	}
+	counters.totalHighWaterBytes.set(counters.totalBytes.get());
+
+	levelLoadName = name;
+	takeSnapshot(levelLoadStart);
+}
+
+
+void MemoryStats::endLevelLoad()
+{
+	ScopedLock lock(levelLoadMutex);
+	assert( levelLoadDepth > 0 );
+	if( --levelLoadDepth > 0 )
+	{
+		return;
+	}
+
+	Snapshot end;
+	takeSnapshot(end);
+	diff(levelLoadStart, end, lastLevelLoad);
+	lastLevelLoadName = levelLoadName;
+	if( levelLoadLogging )
+	{
+		std::string title = "Memory of level load \"" + levelLoadName + "\"";
+		logSnapshot(lastLevelLoad, title.c_str(), 10);
+	}
+}
+
+
+void MemoryStats::setLevelLoadLogging(bool enabled)
+{
+	ScopedLock lock(levelLoadMutex);
+	levelLoadLogging = enabled;
+}
+
+
+std::string MemoryStats::getLastLevelLoad(Snapshot& difference)
+{
+	ScopedLock lock(levelLoadMutex);
+	if( lastLevelLoadName.empty() )
+	{
+		difference = Snapshot();
+	}
+	else
+	{
+		difference = lastLevelLoad;
+	}
+	return lastLevelLoadName;
+}
+
+}
@@ -22,13 +22,22 @@
 // =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
 #include <Object.h>
+#include <Thread.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <typeinfo>
+#include <algorithm>
+#include <map>
+#include <new>
 #include <es_util.h>
 
 #include <config.h>
 
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+
 namespace yam2d
 {
 namespace
@@ -38,6 +47,9 @@ namespace
     public:
         RefCounter()
             : refs(0)
+#if defined(MEMORY_TRACKING)
+            , firstObject(0)
+#endif
         {
         }
 
@@ -45,13 +57,15 @@ namespace
         ~RefCounter()
         {
 #if defined(SHOW_LEAKS)
-            if( refs != 0 )
+            if( refs.get() != 0 )
             {
-				esLogEngineError("[%s] %d Memory leaks detected!\n", __FUNCTION__, refs);
+				esLogEngineError("[%s] %d Memory leaks detected!\n", __FUNCTION__, refs.get());
 #if defined(MEMORY_LEAK_DEBUGGING)
-                for( size_t i=0; i<m_objects.size(); ++i )
+				std::vector<MemoryStats::TypeStats> types;
+				Object::getLiveObjectTypes(types);
+                for( size_t i=0; i<types.size(); ++i )
                 {
-                    esLogMessage(m_objectNames[i].c_str());
+                    esLogMessage("%6d %s", types[i].numObjects, types[i].name.c_str());
                 }
 #endif
             }
@@ -60,64 +74,100 @@ namespace
 				esLogEngineDebug("No memory leaks detected!\n");
             }
 #if defined(ASSERT_ON_LEAKS)
-            assert( refs == 0 );
+            assert( refs.get() == 0 );
 #endif
 #endif
         }
 
-        void add(Object* o, const char* const name)
-        {
-#if defined(MEMORY_LEAK_DEBUGGING)
-            m_objects.push_back(o);
-            m_objectNames.push_back(name);
-#else
-			(void)name;
-			(void)o;
+        // Objects may be created and destroyed on loader threads too, so counter is atomic and list is guarded by mutex.
+        AtomicInt refs;
+#if defined(MEMORY_TRACKING)
+        Mutex mutex;
+        Object* firstObject;
 #endif
-            ++refs;
-        }
+    };
 
-        void release(Object* o)
-        {
-#if defined(MEMORY_LEAK_DEBUGGING)
-            size_t index = 0;
-			
-			for( ; index<m_objects.size(); ++index )
-			{
-				if( m_objects[index] == o )
-				{
-					break;
-				}
-			}
+    static RefCounter refs;
 
-			m_objects.erase( m_objects.begin() + index );
-			m_objectNames.erase( m_objectNames.begin() + index );
-#else
-			(void)o;
+#if defined(MEMORY_TRACKING)
+	// Sizes of Objects allocated with new by allocation address, guarded by mutex of refs. Object is found by the 
+	// address of its complete object, so the lookup works for Objects, which are not the first base of their class.
+	typedef std::map<const void*, size_t> Allocations;
+
+	Allocations& getAllocations()
+	{
+		static Allocations allocations;
+		return allocations;
+	}
+
+	struct ByteOrder
+	{
+		bool operator()(const MemoryStats::TypeStats& a, const MemoryStats::TypeStats& b) const
+		{
+			return a.numBytes != b.numBytes ? a.numBytes > b.numBytes : a.numObjects > b.numObjects;
+		}
+	};
+
+	std::string getTypeName(const char* name)
+	{
+#if defined(__GNUC__)
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(name, 0, 0, &status);
+		if( demangled != 0 )
+		{
+			std::string result(demangled);
+			free(demangled);
+			return result;
+		}
 #endif
-            --refs;
-        }
-
-    private:
-#if defined(MEMORY_LEAK_DEBUGGING)
-        std::vector<Object*> m_objects;
-        std::vector<std::string> m_objectNames;
+		return name;
+	}
 #endif
-        int refs;
-    };
-
-    static RefCounter refs;
 }
 
 Object::Object(/*const char* const name*/)
 : m_numOfRefs(0)
+, m_memorySubsystem(MemoryStats::OTHER_OBJECTS)
 {
-    refs.add(this,"");
+	refs.refs.increment();
+	MemoryStats::addObject(MemoryStats::OTHER_OBJECTS);
+
+#if defined(MEMORY_TRACKING)
+	ScopedLock lock(refs.mutex);
+	m_previousObject = 0;
+	m_nextObject = refs.firstObject;
+	if( m_nextObject != 0 )
+	{
+		m_nextObject->m_previousObject = this;
+	}
+	refs.firstObject = this;
+#endif
 }
 
 Object::~Object()
 {
-    refs.release(this);
+	refs.refs.add(-1);
+	MemoryStats::removeObject(getMemorySubsystem());
+
+#if defined(MEMORY_TRACKING)
+	{
+		ScopedLock lock(refs.mutex);
+		if( m_previousObject != 0 )
+		{
+			m_previousObject->m_nextObject = m_nextObject;
+		}
+		else
+		{
+			refs.firstObject = m_nextObject;
+		}
+
+		if( m_nextObject != 0 )
+		{
+			m_nextObject->m_previousObject = m_previousObject;
+		}
+	}
+#endif
+
     if( this->m_numOfRefs != 0 )
     {
         assert( this->m_numOfRefs == 0 ); // "Can not delete Object, when it have references some where else";
@@ -125,6 +175,75 @@ Object::~Object()
 }
 
 
+void* Object::allocate(size_t size, MemoryStats::Subsystem subsystem)
+{
+	void* ptr = ::operator new(size);
+	MemoryStats::addBytes(subsystem, int(size));
+#if defined(MEMORY_TRACKING)
+	ScopedLock lock(refs.mutex);
+	getAllocations()[ptr] = size;
+#endif
+	return ptr;
+}
+
+
+void Object::deallocate(void* ptr, size_t size, MemoryStats::Subsystem subsystem)
+{
+	if( ptr == 0 )
+	{
+		return;
+	}
+
+#if defined(MEMORY_TRACKING)
+	{
+		ScopedLock lock(refs.mutex);
+		getAllocations().erase(ptr);
+	}
+#endif
+	MemoryStats::addBytes(subsystem, -int(size));
+	::operator delete(ptr);
+}
+
+
+void Object::setMemorySubsystem(MemoryStats::Subsystem subsystem)
+{
+	assert( subsystem >= 0 && subsystem < MemoryStats::NUM_SUBSYSTEMS );
+	MemoryStats::removeObject(getMemorySubsystem());
+	m_memorySubsystem = subsystem;
+	MemoryStats::addObject(subsystem);
+}
+
+
+void Object::getLiveObjectTypes(std::vector<MemoryStats::TypeStats>& types)
+{
+	types.clear();
+#if defined(MEMORY_TRACKING)
+	std::map<const char*, MemoryStats::TypeStats> typesByName;
+	{
+		ScopedLock lock(refs.mutex);
+		const Allocations& allocations = getAllocations();
+		for( const Object* o = refs.firstObject; o != 0; o = o->m_nextObject )
+		{
+			MemoryStats::TypeStats& type = typesByName[typeid(*o).name()];
+			++type.numObjects;
+			Allocations::const_iterator allocation = allocations.find(dynamic_cast<const void*>(o));
+			if( allocation != allocations.end() )
+			{
+				type.numBytes += int(allocation->second);
+			}
+		}
+	}
+
+	for( std::map<const char*, MemoryStats::TypeStats>::iterator it = typesByName.begin(); it != typesByName.end(); ++it )
+	{
+		it->second.name = getTypeName(it->first);
+		types.push_back(it->second);
+	}
+	std::sort(types.begin(), types.end(), ByteOrder());
+#endif
+}
+
+
 
 }
 
@@ -0,0 +1,1130 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "Pathfinder.h"
+#include "ElapsedTimer.h"
+#include "es_util.h"
+#include <es_assert.h>
+#include <Logger.h>
+#include <algorithm>
+#include <float.h>
+#include <stdlib.h>
+
+namespace yam2d
+{
+
+namespace
+{
+	const float DIAGONAL_COST = 1.41421356f;
+
+	// Entrances of longer runs of open border cells are placed to both ends of the run.
+	const int MIN_DOUBLE_ENTRANCE_LENGTH = 6;
+
+	// Cost of shortest 8-directional path without obstacles.
+	float octileDistance(int dx, int dy)
+	{
+		dx = abs(dx);
+		dy = abs(dy);
+		return dx < dy ? DIAGONAL_COST*float(dx) + float(dy - dx) : DIAGONAL_COST*float(dy) + float(dx - dy);
+	}
+
+	void addUnique(std::vector<int>& values, int value)
+	{
+		if( std::find(values.begin(), values.end(), value) == values.end() )
+		{
+			values.push_back(value);
+		}
+	}
+
+	int sign(int value)
+	{
+		return value > 0 ? 1 : (value < 0 ? -1 : 0);
+	}
+
+	struct OpenNode
+	{
+		float	f;
+		int		cell;
+	};
+
+	// Heap ordering: lowest f on top.
+	bool isWorse(const OpenNode& a, const OpenNode& b)
+	{
+		return a.f > b.f;
+	}
+
+	const int directionsX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	const int directionsY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+}
+
+
+/** Search state of one thread. Per cell arrays are reset with stamps instead of clearing. */
+struct PathSearchContext
+{
+	std::vector<float>		g;
+	std::vector<int>		parent;
+	std::vector<unsigned>	visited;
+	std::vector<unsigned>	closed;
+	unsigned				stamp;
+	std::vector<OpenNode>	open;
+	std::vector<float>		startCosts;
+	std::vector<float>		goalCosts;
+	std::vector<int>		abstractPath;
+	std::vector<int>		segment;
+
+	PathSearchContext() : stamp(0) {}
+
+	void begin(size_t numCells)
+	{
+		if( g.size() != numCells )
+		{
+			g.resize(numCells);
+			parent.resize(numCells);
+			visited.assign(numCells, 0);
+			closed.assign(numCells, 0);
+			stamp = 0;
+		}
+
+		if( ++stamp == 0 )
+		{
+			std::fill(visited.begin(), visited.end(), 0);
+			std::fill(closed.begin(), closed.end(), 0);
+			stamp = 1;
+		}
+		open.clear();
+	}
+
+	bool isVisited(int cell) const { return visited[cell] == stamp; }
+	bool isClosed(int cell) const { return closed[cell] == stamp; }
+	void close(int cell) { closed[cell] = stamp; }
+
+	// Sets cost of the cell, if it is lower than current cost, and adds the cell to open list.
+	void relax(int cell, float cost, int parentCell, float heuristic)
+	{
+		if( isClosed(cell) || (isVisited(cell) && g[cell] <= cost) )
+		{
+			return;
+		}
+
+		visited[cell] = stamp;
+		g[cell] = cost;
+		parent[cell] = parentCell;
+		OpenNode node = { cost + heuristic, cell };
+		open.push_back(node);
+		std::push_heap(open.begin(), open.end(), isWorse);
+	}
+
+	// Pops lowest cost cell, which is not closed yet. Returns -1, if open list is empty.
+	int pop()
+	{
+		while( !open.empty() )
+		{
+			int cell = open.front().cell;
+			std::pop_heap(open.begin(), open.end(), isWorse);
+			open.pop_back();
+			if( !isClosed(cell) )
+			{
+				return cell;
+			}
+		}
+		return -1;
+	}
+
+	float peekCost() const { return open.empty() ? FLT_MAX : open.front().f; }
+};
+
+
+/** Worker thread of Pathfinder. */
+class PathfinderThread : public Thread
+{
+public:
+	PathfinderThread(Pathfinder* pathfinder)
+		: Thread()
+		, m_pathfinder(pathfinder)
+		, m_context()
+	{
+	}
+
+	virtual ~PathfinderThread()
+	{
+	}
+
+protected:
+	virtual void run()
+	{
+		m_pathfinder->runWorker(&m_context);
+	}
+
+private:
+	Pathfinder*			m_pathfinder;
+	PathSearchContext	m_context;
+};
+
+
+PathRequest::PathRequest(Pathfinder* pathfinder, const vec2& start, const vec2& goal)
+: Object()
+, m_pathfinder(pathfinder)
+, m_state(STATE_PENDING)
+, m_start(start)
+, m_goal(goal)
+, m_path()
+, m_found(false)
+, m_cancelled(false)
+{
+}
+
+
+PathRequest::~PathRequest()
+{
+}
+
+
+void PathRequest::cancel()
+{
+	if( m_state == STATE_PENDING && m_pathfinder != 0 )
+	{
+		m_pathfinder->cancel(this);
+	}
+}
+
+
+Pathfinder::Pathfinder(TileGrid* tileGrid, int clusterSize, int numThreads)
+: Object()
+, m_tileGrid(tileGrid)
+, m_width(tileGrid->getWidth())
+, m_height(tileGrid->getHeight())
+, m_clusterSize(clusterSize)
+, m_numClustersX(0)
+, m_numClustersY(0)
+, m_mutex()
+, m_walkable(size_t(tileGrid->getWidth())*size_t(tileGrid->getHeight()))
+, m_clusters()
+, m_hasDirtyClusters(false)
+, m_globalVersion(0)
+, m_cache()
+, m_maxCachedPaths(1024)
+, m_useCounter(0)
+, m_numCacheHits(0)
+, m_numSearches(0)
+, m_mainContext(new PathSearchContext())
+, m_queueMutex()
+, m_workAvailable()
+, m_stopping(false)
+, m_queue()
+, m_finished()
+, m_numSearching(0)
+, m_threads()
+{
+	assert( clusterSize == 0 || clusterSize >= 4 );
+	for( int y=0; y<m_height; ++y )
+	{
+		for( int x=0; x<m_width; ++x )
+		{
+			m_walkable[y*m_width + x] = tileGrid->isSolid(x, y) ? 0 : 1;
+		}
+	}
+
+	if( m_clusterSize > 0 )
+	{
+		m_numClustersX = (m_width + m_clusterSize - 1) / m_clusterSize;
+		m_numClustersY = (m_height + m_clusterSize - 1) / m_clusterSize;
+		m_clusters.resize(m_numClustersX*m_numClustersY);
+		for( int cy=0; cy<m_numClustersY; ++cy )
+		{
+			for( int cx=0; cx<m_numClustersX; ++cx )
+			{
+				Cluster& cluster = m_clusters[cy*m_numClustersX + cx];
+				cluster.x0 = cx*m_clusterSize;
+				cluster.y0 = cy*m_clusterSize;
+				cluster.x1 = std::min(cluster.x0 + m_clusterSize, m_width) - 1;
+				cluster.y1 = std::min(cluster.y0 + m_clusterSize, m_height) - 1;
+				cluster.version = 0;
+				cluster.dirty = true;
+			}
+		}
+		m_hasDirtyClusters = true;
+	}
+
+	m_tileGrid->addChangeListener(this);
+
+	for( int i=0; i<numThreads; ++i )
+	{
+		Ref<PathfinderThread> thread = new PathfinderThread(this);
+		if( !thread->start() )
+		{
+			YAM2D_LOG_WARNING(Logger::CATEGORY_ENGINE, "[%s] Could not start pathfinder thread %d", __FUNCTION__, i);
+			break;
+		}
+		m_threads.push_back(thread);
+	}
+}
+
+
+Pathfinder::~Pathfinder()
+{
+	{
+		ScopedLock lock(m_queueMutex);
+		m_stopping = true;
+		m_workAvailable.broadcast();
+	}
+
+	for( size_t i=0; i<m_threads.size(); ++i )
+	{
+		m_threads[i]->join();
+	}
+	m_threads.clear();
+
+	for( size_t i=0; i<m_queue.size(); ++i )
+	{
+		m_queue[i]->m_state = PathRequest::STATE_CANCELLED;
+		m_queue[i]->m_pathfinder = 0;
+	}
+	for( size_t i=0; i<m_finished.size(); ++i )
+	{
+		m_finished[i]->m_state = PathRequest::STATE_CANCELLED;
+		m_finished[i]->m_pathfinder = 0;
+	}
+
+	m_tileGrid->removeChangeListener(this);
+	delete m_mainContext;
+}
+
+
+bool Pathfinder::findPath(const vec2& start, const vec2& goal, std::vector<vec2>& path)
+{
+	path.clear();
+	int startCell, goalCell;
+	if( !getCells(start, goal, startCell, goalCell) )
+	{
+		return false;
+	}
+
+	std::vector<int> cells;
+	if( !findPathCells(m_mainContext, startCell, goalCell, cells) )
+	{
+		return false;
+	}
+
+	toPositions(cells, path);
+	return true;
+}
+
+
+PathRequest* Pathfinder::requestPath(const vec2& start, const vec2& goal)
+{
+	PathRequest* request = new PathRequest(this, start, goal);
+	ScopedLock lock(m_queueMutex);
+	m_queue.push_back(request);
+	m_workAvailable.signal();
+	return request;
+}
+
+
+int Pathfinder::update(float maxMilliseconds)
+{
+	ElapsedTimer timer;
+	timer.reset();
+
+	if( m_threads.empty() )
+	{
+		while( true )
+		{
+			Ref<PathRequest> request;
+			{
+				ScopedLock lock(m_queueMutex);
+				if( m_queue.empty() )
+				{
+					break;
+				}
+				request = m_queue.front();
+				m_queue.pop_front();
+			}
+
+			request->m_found = findPath(request->m_start, request->m_goal, request->m_path);
+			{
+				ScopedLock lock(m_queueMutex);
+				m_finished.push_back(request);
+			}
+
+			if( timer.getTime()*1000.0f >= maxMilliseconds )
+			{
+				break;
+			}
+		}
+	}
+
+	std::vector< Ref<PathRequest> > finished;
+	{
+		ScopedLock lock(m_queueMutex);
+		finished.swap(m_finished);
+	}
+
+	for( size_t i=0; i<finished.size(); ++i )
+	{
+		PathRequest* request = finished[i];
+		if( request->m_cancelled )
+		{
+			request->m_state = PathRequest::STATE_CANCELLED;
+			request->m_path.clear();
+		}
+		else
+		{
+			request->m_state = request->m_found ? PathRequest::STATE_READY : PathRequest::STATE_FAILED;
+		}
+	}
+
+	return (int)finished.size();
+}
+
+
+int Pathfinder::getNumPending() const
+{
+	ScopedLock lock(m_queueMutex);
+	return int(m_queue.size()) + m_numSearching;
+}
+
+
+void Pathfinder::clearCache()
+{
+	ScopedLock lock(m_mutex);
+	m_cache.clear();
+}
+
+
+void Pathfinder::setMaxCachedPaths(int maxCachedPaths)
+{
+	ScopedLock lock(m_mutex);
+	m_maxCachedPaths = maxCachedPaths;
+	if( m_maxCachedPaths <= 0 )
+	{
+		m_cache.clear();
+	}
+}
+
+
+void Pathfinder::onCellChanged(int x, int y, bool solid)
+{
+	ScopedLock lock(m_mutex);
+	m_walkable[y*m_width + x] = solid ? 0 : 1;
+	++m_globalVersion;
+	if( m_clusterSize == 0 )
+	{
+		return;
+	}
+
+	// Entrances on cluster borders depend on cells of both clusters.
+	int cx = x / m_clusterSize;
+	int cy = y / m_clusterSize;
+	Cluster& cluster = m_clusters[cy*m_numClustersX + cx];
+	++cluster.version;
+	cluster.dirty = true;
+	if( x == cluster.x0 && cx > 0 )
+		m_clusters[cy*m_numClustersX + cx-1].dirty = true;
+	if( x == cluster.x1 && cx < m_numClustersX-1 )
+		m_clusters[cy*m_numClustersX + cx+1].dirty = true;
+	if( y == cluster.y0 && cy > 0 )
+		m_clusters[(cy-1)*m_numClustersX + cx].dirty = true;
+	if( y == cluster.y1 && cy < m_numClustersY-1 )
+		m_clusters[(cy+1)*m_numClustersX + cx].dirty = true;
+	m_hasDirtyClusters = true;
+}
+
+
+bool Pathfinder::getCells(const vec2& start, const vec2& goal, int& startCell, int& goalCell) const
+{
+	int startX = m_tileGrid->getCellX(start.x);
+	int startY = m_tileGrid->getCellY(start.y);
+	int goalX = m_tileGrid->getCellX(goal.x);
+	int goalY = m_tileGrid->getCellY(goal.y);
+	if( unsigned(startX) >= unsigned(m_width) || unsigned(startY) >= unsigned(m_height) 
+		|| unsigned(goalX) >= unsigned(m_width) || unsigned(goalY) >= unsigned(m_height) )
+	{
+		return false;
+	}
+
+	startCell = startY*m_width + startX;
+	goalCell = goalY*m_width + goalX;
+	return true;
+}
+
+
+void Pathfinder::toPositions(const std::vector<int>& cells, std::vector<vec2>& path) const
+{
+	const vec2& origin = m_tileGrid->getOrigin();
+	path.resize(cells.size());
+	for( size_t i=0; i<cells.size(); ++i )
+	{
+		path[i] = origin + vec2(float(cells[i] % m_width) + 0.5f, float(cells[i] / m_width) + 0.5f);
+	}
+}
+
+
+bool Pathfinder::findPathCells(PathSearchContext* context, int startCell, int goalCell, std::vector<int>& cells)
+{
+	ScopedLock lock(m_mutex);
+	cells.clear();
+	if( m_walkable[startCell] == 0 || m_walkable[goalCell] == 0 )
+	{
+		return false;
+	}
+
+	bool found = false;
+	if( findCachedPath(startCell, goalCell, found, cells) )
+	{
+		++m_numCacheHits;
+		return found;
+	}
+
+	rebuildDirtyClusters(context);
+	++m_numSearches;
+	found = searchPath(context, startCell, goalCell, cells);
+	addCachedPath(startCell, goalCell, found, cells);
+	return found;
+}
+
+
+bool Pathfinder::searchPath(PathSearchContext* context, int startCell, int goalCell, std::vector<int>& cells)
+{
+	cells.clear();
+	if( startCell == goalCell )
+	{
+		return true;
+	}
+
+	if( m_clusterSize == 0 )
+	{
+		return searchLocal(context, 0, 0, m_width-1, m_height-1, startCell, goalCell, cells);
+	}
+
+	// Paths between neighbouring clusters are usually found inside the clusters.
+	const Cluster& startCluster = m_clusters[getClusterIndex(startCell)];
+	const Cluster& goalCluster = m_clusters[getClusterIndex(goalCell)];
+	if( abs(startCluster.x0 - goalCluster.x0) <= m_clusterSize && abs(startCluster.y0 - goalCluster.y0) <= m_clusterSize )
+	{
+		if( searchLocal(context, std::min(startCluster.x0, goalCluster.x0), std::min(startCluster.y0, goalCluster.y0), 
+			std::max(startCluster.x1, goalCluster.x1), std::max(startCluster.y1, goalCluster.y1), startCell, goalCell, cells) )
+		{
+			return true;
+		}
+	}
+
+	return searchHierarchical(context, startCell, goalCell, cells);
+}
+
+
+bool Pathfinder::searchLocal(PathSearchContext* context, int x0, int y0, int x1, int y1, int startCell, int goalCell, std::vector<int>& cells)
+{
+	// A* with jump point search, where diagonal moves past corners are not allowed. Cells outside of the 
+	// area are treated as blocked.
+	struct Area
+	{
+		const Pathfinder* pathfinder;
+		int x0, y0, x1, y1;
+		int goalX, goalY;
+
+		bool isWalkable(int x, int y) const
+		{
+			return x >= x0 && x <= x1 && y >= y0 && y <= y1 && pathfinder->isWalkable(x, y);
+		}
+
+		// Returns true, if straight move from x,y in direction dx,dy stops to a jump point.
+		bool jumpStraight(int x, int y, int dx, int dy, int& jumpX, int& jumpY) const
+		{
+			for( ; isWalkable(x, y); x += dx, y += dy )
+			{
+				if( (x == goalX && y == goalY) 
+					|| (dx != 0 && ((isWalkable(x, y-1) && !isWalkable(x-dx, y-1)) || (isWalkable(x, y+1) && !isWalkable(x-dx, y+1))))
+					|| (dy != 0 && ((isWalkable(x-1, y) && !isWalkable(x-1, y-dy)) || (isWalkable(x+1, y) && !isWalkable(x+1, y-dy)))) )
+				{
+					jumpX = x;
+					jumpY = y;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool jump(int x, int y, int dx, int dy, int& jumpX, int& jumpY) const
+		{
+			if( dx == 0 || dy == 0 )
+			{
+				return jumpStraight(x, y, dx, dy, jumpX, jumpY);
+			}
+
+			for( ; isWalkable(x, y); x += dx, y += dy )
+			{
+				int straightX, straightY;
+				if( (x == goalX && y == goalY) || jumpStraight(x+dx, y, dx, 0, straightX, straightY) || jumpStraight(x, y+dy, 0, dy, straightX, straightY) )
+				{
+					jumpX = x;
+					jumpY = y;
+					return true;
+				}
+
+				if( !isWalkable(x+dx, y) || !isWalkable(x, y+dy) )
+				{
+					return false;
+				}
+			}
+			return false;
+		}
+	};
+
+	Area area = { this, x0, y0, x1, y1, goalCell % m_width, goalCell / m_width };
+	context->begin(m_walkable.size());
+	context->relax(startCell, 0.0f, -1, octileDistance(startCell % m_width - area.goalX, startCell / m_width - area.goalY));
+
+	for( int cell = context->pop(); cell >= 0; cell = context->pop() )
+	{
+		context->close(cell);
+		if( cell == goalCell )
+		{
+			for( int c = goalCell; c != startCell; c = context->parent[c] )
+			{
+				cells.push_back(c);
+			}
+			std::reverse(cells.begin(), cells.end());
+			return true;
+		}
+
+		const int x = cell % m_width;
+		const int y = cell / m_width;
+		int directionsToTest[8][2];
+		int numDirections = 0;
+		const int parentCell = context->parent[cell];
+		if( parentCell < 0 )
+		{
+			for( int d=0; d<8; ++d )
+			{
+				directionsToTest[numDirections][0] = directionsX[d];
+				directionsToTest[numDirections][1] = directionsY[d];
+				++numDirections;
+			}
+		}
+		else
+		{
+			// Natural and forced neighbours of the move from parent.
+			const int dx = sign(x - parentCell % m_width);
+			const int dy = sign(y - parentCell / m_width);
+			if( dx != 0 && dy != 0 )
+			{
+				const bool verticalOpen = area.isWalkable(x, y+dy);
+				const bool horizontalOpen = area.isWalkable(x+dx, y);
+				if( verticalOpen ) { directionsToTest[numDirections][0] = 0; directionsToTest[numDirections][1] = dy; ++numDirections; }
+				if( horizontalOpen ) { directionsToTest[numDirections][0] = dx; directionsToTest[numDirections][1] = 0; ++numDirections; }
+				if( verticalOpen && horizontalOpen ) { directionsToTest[numDirections][0] = dx; directionsToTest[numDirections][1] = dy; ++numDirections; }
+			}
+			else
+			{
+				// Side directions perpendicular to the move.
+				const int sideX = dy != 0 ? 1 : 0;
+				const int sideY = dx != 0 ? 1 : 0;
+				const bool nextOpen = area.isWalkable(x+dx, y+dy);
+				const bool side0Open = area.isWalkable(x+sideX, y+sideY);
+				const bool side1Open = area.isWalkable(x-sideX, y-sideY);
+				if( nextOpen )
+				{
+					directionsToTest[numDirections][0] = dx; directionsToTest[numDirections][1] = dy; ++numDirections;
+					if( side0Open ) { directionsToTest[numDirections][0] = dx+sideX; directionsToTest[numDirections][1] = dy+sideY; ++numDirections; }
+					if( side1Open ) { directionsToTest[numDirections][0] = dx-sideX; directionsToTest[numDirections][1] = dy-sideY; ++numDirections; }
+				}
+				if( side0Open ) { directionsToTest[numDirections][0] = sideX; directionsToTest[numDirections][1] = sideY; ++numDirections; }
+				if( side1Open ) { directionsToTest[numDirections][0] = -sideX; directionsToTest[numDirections][1] = -sideY; ++numDirections; }
+			}
+		}
+
+		for( int d=0; d<numDirections; ++d )
+		{
+			const int dx = directionsToTest[d][0];
+			const int dy = directionsToTest[d][1];
+
+			// Diagonal moves past corners are not allowed.
+			if( dx != 0 && dy != 0 && (!area.isWalkable(x+dx, y) || !area.isWalkable(x, y+dy)) )
+			{
+				continue;
+			}
+
+			int jumpX, jumpY;
+			if( area.jump(x+dx, y+dy, dx, dy, jumpX, jumpY) )
+			{
+				const int jumpCell = jumpY*m_width + jumpX;
+				context->relax(jumpCell, context->g[cell] + octileDistance(jumpX - x, jumpY - y), cell, octileDistance(jumpX - area.goalX, jumpY - area.goalY));
+			}
+		}
+	}
+
+	return false;
+}
+
+
+bool Pathfinder::searchHierarchical(PathSearchContext* context, int startCell, int goalCell, std::vector<int>& cells)
+{
+	const int startClusterIndex = getClusterIndex(startCell);
+	const int goalClusterIndex = getClusterIndex(goalCell);
+	const Cluster& startCluster = m_clusters[startClusterIndex];
+	const Cluster& goalCluster = m_clusters[goalClusterIndex];
+
+	// Connect start and goal to entrances of their clusters.
+	context->startCosts.resize(startCluster.nodes.size() + 1);
+	context->goalCosts.resize(goalCluster.nodes.size() + 1);
+	computeCosts(context, goalCluster, goalCell, &context->goalCosts[0]);
+	float bestCost = computeCosts(context, startCluster, startCell, &context->startCosts[0], 
+		startClusterIndex == goalClusterIndex ? goalCell : -1);
+	int bestLastNode = -1;		// Last entrance before goal, or -1 for path inside start cluster.
+
+	// A* over entrances.
+	const int goalX = goalCell % m_width;
+	const int goalY = goalCell / m_width;
+	context->begin(m_walkable.size());
+	for( size_t i=0; i<startCluster.nodes.size(); ++i )
+	{
+		const int cell = startCluster.nodes[i].cell;
+		if( context->startCosts[i] < FLT_MAX )
+		{
+			context->relax(cell, context->startCosts[i], -1, octileDistance(cell % m_width - goalX, cell / m_width - goalY));
+		}
+	}
+
+	while( context->peekCost() < bestCost )
+	{
+		const int cell = context->pop();
+		if( cell < 0 )
+		{
+			break;
+		}
+		context->close(cell);
+
+		const int clusterIndex = getClusterIndex(cell);
+		const Cluster& cluster = m_clusters[clusterIndex];
+		const int nodeIndex = findNode(cluster, cell);
+		if( nodeIndex < 0 )
+		{
+			continue;
+		}
+
+		const float cost = context->g[cell];
+		if( clusterIndex == goalClusterIndex && context->goalCosts[nodeIndex] < FLT_MAX && cost + context->goalCosts[nodeIndex] < bestCost )
+		{
+			bestCost = cost + context->goalCosts[nodeIndex];
+			bestLastNode = cell;
+		}
+
+		const ClusterNode& node = cluster.nodes[nodeIndex];
+		const int numNodes = (int)cluster.nodes.size();
+		for( int i=0; i<numNodes; ++i )
+		{
+			const float edgeCost = cluster.costs[nodeIndex*numNodes + i];
+			if( i != nodeIndex && edgeCost < FLT_MAX )
+			{
+				const int other = cluster.nodes[i].cell;
+				context->relax(other, cost + edgeCost, cell, octileDistance(other % m_width - goalX, other / m_width - goalY));
+			}
+		}
+
+		for( int i=0; i<node.numPartners; ++i )
+		{
+			const int other = node.partners[i];
+			context->relax(other, cost + 1.0f, cell, octileDistance(other % m_width - goalX, other / m_width - goalY));
+		}
+	}
+
+	if( bestCost == FLT_MAX )
+	{
+		return false;
+	}
+
+	// Path of entrances from start to goal.
+	std::vector<int>& abstractPath = context->abstractPath;
+	abstractPath.clear();
+	abstractPath.push_back(goalCell);
+	for( int cell = bestLastNode; cell >= 0; cell = context->parent[cell] )
+	{
+		abstractPath.push_back(cell);
+	}
+	abstractPath.push_back(startCell);
+	std::reverse(abstractPath.begin(), abstractPath.end());
+
+	// Refine each step to cells. Steps between clusters are single moves to the neighbour entrance.
+	cells.clear();
+	for( size_t i=1; i<abstractPath.size(); ++i )
+	{
+		const int from = abstractPath[i-1];
+		const int to = abstractPath[i];
+		if( from == to )
+		{
+			continue;
+		}
+
+		const int clusterIndex = getClusterIndex(from);
+		if( clusterIndex != getClusterIndex(to) )
+		{
+			cells.push_back(to);
+			continue;
+		}
+
+		const Cluster& cluster = m_clusters[clusterIndex];
+		std::vector<int>& segment = context->segment;
+		segment.clear();
+		if( !searchLocal(context, cluster.x0, cluster.y0, cluster.x1, cluster.y1, from, to, segment) )
+		{
+			assert(0); // Costs of the cluster are out of date.
+			return false;
+		}
+		cells.insert(cells.end(), segment.begin(), segment.end());
+	}
+
+	// Remove points, where path does not turn.
+	size_t numKept = 0;
+	int previous = startCell;
+	for( size_t i=0; i<cells.size(); ++i )
+	{
+		if( i+1 < cells.size() )
+		{
+			const int next = cells[i+1];
+			if( sign(cells[i] % m_width - previous % m_width) == sign(next % m_width - cells[i] % m_width)
+				&& sign(cells[i] / m_width - previous / m_width) == sign(next / m_width - cells[i] / m_width) )
+			{
+				continue;
+			}
+		}
+		cells[numKept++] = cells[i];
+		previous = cells[i];
+	}
+	cells.resize(numKept);
+	return true;
+}
+
+
+float Pathfinder::computeCosts(PathSearchContext* context, const Cluster& cluster, int fromCell, float* costs, int targetCell)
+{
+	// Dijkstra inside the cluster. Costs of nodes are written to costs and cost to target cell is returned.
+	context->begin(m_walkable.size());
+	context->relax(fromCell, 0.0f, -1, 0.0f);
+	for( int cell = context->pop(); cell >= 0; cell = context->pop() )
+	{
+		context->close(cell);
+		const int x = cell % m_width;
+		const int y = cell / m_width;
+		for( int d=0; d<8; ++d )
+		{
+			const int nx = x + directionsX[d];
+			const int ny = y + directionsY[d];
+			if( nx < cluster.x0 || nx > cluster.x1 || ny < cluster.y0 || ny > cluster.y1 || !isWalkable(nx, ny) )
+			{
+				continue;
+			}
+
+			if( d >= 4 && (!isWalkable(nx, y) || !isWalkable(x, ny)) )
+			{
+				continue;
+			}
+
+			context->relax(ny*m_width + nx, context->g[cell] + (d >= 4 ? DIAGONAL_COST : 1.0f), cell, 0.0f);
+		}
+	}
+
+	for( size_t i=0; i<cluster.nodes.size(); ++i )
+	{
+		const int cell = cluster.nodes[i].cell;
+		costs[i] = context->isVisited(cell) ? context->g[cell] : FLT_MAX;
+	}
+
+	return (targetCell >= 0 && context->isVisited(targetCell)) ? context->g[targetCell] : FLT_MAX;
+}
+
+
+void Pathfinder::rebuildDirtyClusters(PathSearchContext* context)
+{
+	if( !m_hasDirtyClusters )
+	{
+		return;
+	}
+
+	// Entrances of all dirty clusters are found before costs, because costs of a cluster do not depend on
+	// its neighbours, but partners of entrances do.
+	for( size_t i=0; i<m_clusters.size(); ++i )
+	{
+		if( m_clusters[i].dirty )
+		{
+			rebuildCluster(context, (int)i);
+		}
+	}
+	m_hasDirtyClusters = false;
+}
+
+
+void Pathfinder::rebuildCluster(PathSearchContext* context, int clusterIndex)
+{
+	Cluster& cluster = m_clusters[clusterIndex];
+	cluster.nodes.clear();
+	const int width = cluster.x1 - cluster.x0 + 1;
+	const int height = cluster.y1 - cluster.y0 + 1;
+	if( cluster.y0 > 0 )
+		addBorderEntrances(cluster, cluster.x0, cluster.y0, 1, 0, width, 0, -1);
+	if( cluster.y1 < m_height-1 )
+		addBorderEntrances(cluster, cluster.x0, cluster.y1, 1, 0, width, 0, 1);
+	if( cluster.x0 > 0 )
+		addBorderEntrances(cluster, cluster.x0, cluster.y0, 0, 1, height, -1, 0);
+	if( cluster.x1 < m_width-1 )
+		addBorderEntrances(cluster, cluster.x1, cluster.y0, 0, 1, height, 1, 0);
+
+	const size_t numNodes = cluster.nodes.size();
+	cluster.costs.resize(numNodes*numNodes);
+	for( size_t i=0; i<numNodes; ++i )
+	{
+		computeCosts(context, cluster, cluster.nodes[i].cell, &cluster.costs[i*numNodes]);
+	}
+	cluster.dirty = false;
+}
+
+
+void Pathfinder::addBorderEntrances(Cluster& cluster, int x, int y, int dx, int dy, int length, int otherDx, int otherDy)
+{
+	// Neighbour cluster walks the same border in same order, so both sides get matching entrances.
+	int runStart = -1;
+	for( int i=0; i<=length; ++i )
+	{
+		const int cx = x + dx*i;
+		const int cy = y + dy*i;
+		const bool open = i < length && isWalkable(cx, cy) && isWalkable(cx + otherDx, cy + otherDy);
+		if( open && runStart < 0 )
+		{
+			runStart = i;
+		}
+
+		if( open || runStart < 0 )
+		{
+			continue;
+		}
+
+		int entrances[2];
+		int numEntrances = 0;
+		if( i - runStart >= MIN_DOUBLE_ENTRANCE_LENGTH )
+		{
+			entrances[numEntrances++] = runStart;
+			entrances[numEntrances++] = i - 1;
+		}
+		else
+		{
+			entrances[numEntrances++] = runStart + (i - runStart) / 2;
+		}
+		runStart = -1;
+
+		for( int e=0; e<numEntrances; ++e )
+		{
+			const int cell = (y + dy*entrances[e])*m_width + x + dx*entrances[e];
+			const int partner = cell + otherDy*m_width + otherDx;
+			int nodeIndex = findNode(cluster, cell);
+			if( nodeIndex < 0 )
+			{
+				ClusterNode node = { cell, { -1, -1 }, 0 };
+				cluster.nodes.push_back(node);
+				nodeIndex = (int)cluster.nodes.size() - 1;
+			}
+
+			ClusterNode& node = cluster.nodes[nodeIndex];
+			assert( node.numPartners < 2 );
+			node.partners[node.numPartners++] = partner;
+		}
+	}
+}
+
+
+int Pathfinder::getClusterIndex(int cell) const
+{
+	return ((cell / m_width) / m_clusterSize)*m_numClustersX + (cell % m_width) / m_clusterSize;
+}
+
+
+int Pathfinder::findNode(const Cluster& cluster, int cell) const
+{
+	for( size_t i=0; i<cluster.nodes.size(); ++i )
+	{
+		if( cluster.nodes[i].cell == cell )
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+
+bool Pathfinder::findCachedPath(int startCell, int goalCell, bool& found, std::vector<int>& cells)
+{
+	if( m_maxCachedPaths <= 0 )
+	{
+		return false;
+	}
+
+	std::map<unsigned long long, CachedPath>::iterator it = m_cache.find((unsigned long long)startCell << 32 | (unsigned)goalCell);
+	if( it == m_cache.end() )
+	{
+		return false;
+	}
+
+	// Failed searches depend on whole grid, found paths only on clusters along the path.
+	CachedPath& cachedPath = it->second;
+	bool valid = true;
+	if( !cachedPath.found || m_clusterSize == 0 )
+	{
+		valid = cachedPath.globalVersion == m_globalVersion;
+	}
+	else
+	{
+		for( size_t i=0; i<cachedPath.clusters.size() && valid; ++i )
+		{
+			valid = m_clusters[cachedPath.clusters[i]].version == cachedPath.versions[i];
+		}
+	}
+
+	if( !valid )
+	{
+		m_cache.erase(it);
+		return false;
+	}
+
+	cachedPath.lastUse = ++m_useCounter;
+	found = cachedPath.found;
+	cells = cachedPath.cells;
+	return true;
+}
+
+
+void Pathfinder::addCachedPath(int startCell, int goalCell, bool found, const std::vector<int>& cells)
+{
+	if( m_maxCachedPaths <= 0 )
+	{
+		return;
+	}
+
+	// Evict least recently used path.
+	if( (int)m_cache.size() >= m_maxCachedPaths )
+	{
+		std::map<unsigned long long, CachedPath>::iterator oldest = m_cache.begin();
+		for( std::map<unsigned long long, CachedPath>::iterator it = m_cache.begin(); it != m_cache.end(); ++it )
+		{
+			if( it->second.lastUse < oldest->second.lastUse )
+			{
+				oldest = it;
+			}
+		}
+		m_cache.erase(oldest);
+	}
+
+	CachedPath& cachedPath = m_cache[(unsigned long long)startCell << 32 | (unsigned)goalCell];
+	cachedPath.cells = cells;
+	cachedPath.clusters.clear();
+	cachedPath.versions.clear();
+	cachedPath.globalVersion = m_globalVersion;
+	cachedPath.found = found;
+	cachedPath.lastUse = ++m_useCounter;
+	if( !found || m_clusterSize == 0 )
+	{
+		return;
+	}
+
+	// Walk the path and collect clusters, which it goes through. Diagonal moves depend also on cells beside them.
+	int x = startCell % m_width;
+	int y = startCell / m_width;
+	addUnique(cachedPath.clusters, getClusterIndex(startCell));
+	for( size_t i=0; i<cells.size(); ++i )
+	{
+		const int targetX = cells[i] % m_width;
+		const int targetY = cells[i] / m_width;
+		const int dx = sign(targetX - x);
+		const int dy = sign(targetY - y);
+		while( x != targetX || y != targetY )
+		{
+			if( dx != 0 && dy != 0 )
+			{
+				addUnique(cachedPath.clusters, getClusterIndex(y*m_width + x + dx));
+				addUnique(cachedPath.clusters, getClusterIndex((y + dy)*m_width + x));
+			}
+			x += dx;
+			y += dy;
+			addUnique(cachedPath.clusters, getClusterIndex(y*m_width + x));
+		}
+	}
+
+	cachedPath.versions.resize(cachedPath.clusters.size());
+	for( size_t i=0; i<cachedPath.clusters.size(); ++i )
+	{
+		cachedPath.versions[i] = m_clusters[cachedPath.clusters[i]].version;
+	}
+}
+
+
+void Pathfinder::runWorker(PathSearchContext* context)
+{
+	while( true )
+	{
+		Ref<PathRequest> request;
+		{
+			ScopedLock lock(m_queueMutex);
+			while( m_queue.empty() && !m_stopping )
+			{
+				m_workAvailable.wait(m_queueMutex);
+			}
+
+			if( m_stopping )
+			{
+				return;
+			}
+
+			request = m_queue.front();
+			m_queue.pop_front();
+			++m_numSearching;
+		}
+
+		int startCell, goalCell;
+		std::vector<int> cells;
+		request->m_found = getCells(request->m_start, request->m_goal, startCell, goalCell) 
+			&& findPathCells(context, startCell, goalCell, cells);
+		if( request->m_found )
+		{
+			toPositions(cells, request->m_path);
+		}
+
+		ScopedLock lock(m_queueMutex);
+		m_finished.push_back(request);
+		--m_numSearching;
+	}
+}
+
+
+void Pathfinder::cancel(PathRequest* request)
+{
+	ScopedLock lock(m_queueMutex);
+	std::deque< Ref<PathRequest> >::iterator it = std::find(m_queue.begin(), m_queue.end(), request);
+	if( it != m_queue.end() )
+	{
+		m_queue.erase(it);
+		request->m_state = PathRequest::STATE_CANCELLED;
+		return;
+	}
+
+	// Request is being searched or waits for delivery in update.
+	request->m_cancelled = true;
+}
+
+
+}
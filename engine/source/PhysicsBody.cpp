@@ -0,0 +1,128 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "PhysicsBody.h"
+#include "PhysicsWorld.h"
+
+namespace yam2d
+{
+
+PhysicsBody::PhysicsBody(GameObject* owner, PhysicsWorld* world, float linearDamping, float angularDamping)
+: Component(owner, Component::getDefaultProperties())
+, m_world(world)
+, m_body(0)
+, m_previousPosition(owner->getPosition())
+, m_previousAngle(-owner->getRotation())
+, m_wasAwake(true)
+, m_index(-1)
+{
+	b2BodyDef bodyDef;
+	bodyDef.type = b2_dynamicBody;
+	bodyDef.position = owner->getPosition();
+	bodyDef.angle = -owner->getRotation();
+	bodyDef.userData = this;
+	bodyDef.linearDamping = linearDamping;
+	bodyDef.angularDamping = angularDamping;
+	m_body = m_world->getWorld()->CreateBody(&bodyDef);
+	m_world->addBody(this);
+}
+
+
+PhysicsBody::PhysicsBody(GameObject* owner, PhysicsWorld* world)
+: Component(owner, Component::getDefaultProperties())
+, m_world(world)
+, m_body(0)
+, m_previousPosition(owner->getPosition())
+, m_previousAngle(-owner->getRotation())
+, m_wasAwake(false)
+, m_index(-1)
+{
+	b2BodyDef bodyDef;
+	bodyDef.type = b2_staticBody;
+	bodyDef.position = owner->getPosition();
+	bodyDef.angle = -owner->getRotation();
+	bodyDef.userData = this;
+	m_body = m_world->getWorld()->CreateBody(&bodyDef);
+}
+
+
+PhysicsBody::~PhysicsBody()
+{
+	if( m_index >= 0 )
+	{
+		m_world->removeBody(this);
+	}
+	m_world->getWorld()->DestroyBody(m_body);
+}
+
+
+void PhysicsBody::setBoxFixture(const vec2& size, const vec2& center, float angle, bool isSensor, float density, float restitution, float friction)
+{
+	b2PolygonShape shape;
+	shape.SetAsBox(size.x/2, size.y/2, center, angle);
+	b2FixtureDef fixtureDef;
+	fixtureDef.shape = &shape;
+	fixtureDef.isSensor = isSensor;
+	fixtureDef.density = density;
+	fixtureDef.restitution = restitution;
+	fixtureDef.friction = friction;
+	m_body->CreateFixture(&fixtureDef);
+}
+
+
+void PhysicsBody::setCircleFixture(float radius, bool isSensor, float density, float restitution, float friction)
+{
+	b2CircleShape shape;
+	shape.m_radius = radius;
+	b2FixtureDef fixtureDef;
+	fixtureDef.shape = &shape;
+	fixtureDef.isSensor = isSensor;
+	fixtureDef.density = density;
+	fixtureDef.restitution = restitution;
+	fixtureDef.friction = friction;
+	m_body->CreateFixture(&fixtureDef);
+}
+
+
+void PhysicsBody::setTransform(const vec2& position, float rotation)
+{
+	m_body->SetTransform(position, -rotation);
+	m_body->SetAwake(true);
+	m_previousPosition = position;
+	m_previousAngle = -rotation;
+	getGameObject()->setPosition(position);
+	getGameObject()->setRotation(rotation);
+}
+
+
+void PhysicsBody::setBullet(bool isBullet)
+{
+	m_body->SetBullet(isBullet);
+}
+
+
+void PhysicsBody::setSleepingAllowed(bool isAllowed)
+{
+	m_body->SetSleepingAllowed(isAllowed);
+}
+
+}
@@ -0,0 +1,150 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "PhysicsWorld.h"
+#include "PhysicsBody.h"
+#include "ElapsedTimer.h"
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <es_assert.h>
+#include <math.h>
+
+namespace yam2d
+{
+
+PhysicsWorld::PhysicsWorld(Entity* owner, const vec2& gravity, float timeStep, int maxStepsPerUpdate)
+: Component(owner, Component::getDefaultProperties())
+, m_world(new b2World(gravity))
+, m_timeStep(timeStep)
+, m_maxStepsPerUpdate(maxStepsPerUpdate)
+, m_velocityIterations(8)
+, m_positionIterations(3)
+, m_accumulator(0.0f)
+, m_bodies()
+, m_stats()
+{
+	assert( timeStep > 0.0f && maxStepsPerUpdate > 0 );
+}
+
+
+PhysicsWorld::~PhysicsWorld()
+{
+	// Bodies hold reference to the world, so all bodies have been destroyed already.
+	assert( m_bodies.empty() );
+}
+
+
+void PhysicsWorld::setIterations(int velocityIterations, int positionIterations)
+{
+	m_velocityIterations = velocityIterations;
+	m_positionIterations = positionIterations;
+}
+
+
+void PhysicsWorld::update(float deltaTime)
+{
+	YAM2D_PROFILE_ZONE("PhysicsWorld::update");
+	ElapsedTimer timer;
+	timer.reset();
+	m_accumulator += deltaTime;
+	int numSteps = 0;
+	while( m_accumulator >= m_timeStep && numSteps < m_maxStepsPerUpdate )
+	{
+		// Transform before the last step is the start point of interpolation. Sleeping bodies are stored too,
+		// because a contact may wake them during the step and they must not interpolate from where they fell asleep.
+		for( size_t i=0; i<m_bodies.size(); ++i )
+		{
+			const b2Body* body = m_bodies[i]->m_body;
+			m_bodies[i]->m_previousPosition = vec2(body->GetPosition().x, body->GetPosition().y);
+			m_bodies[i]->m_previousAngle = body->GetAngle();
+		}
+
+		m_world->Step(m_timeStep, m_velocityIterations, m_positionIterations);
+		m_accumulator -= m_timeStep;
+		++numSteps;
+	}
+
+	if( m_accumulator >= m_timeStep )
+	{
+		m_accumulator = fmodf(m_accumulator, m_timeStep);
+	}
+
+	m_stats.stepTime = 1000.0f*timer.getTime();
+	m_stats.numSteps = numSteps;
+	m_stats.numBodies = m_world->GetBodyCount();
+	m_stats.numContacts = m_world->GetContactCount();
+	m_stats.numProxies = m_world->GetProxyCount();
+	syncBodies(m_accumulator / m_timeStep);
+	RenderStats::addPhysics(m_stats);
+}
+
+
+void PhysicsWorld::syncBodies(float alpha)
+{
+	int numAwakeBodies = 0;
+	for( size_t i=0; i<m_bodies.size(); ++i )
+	{
+		PhysicsBody* physicsBody = m_bodies[i];
+		const b2Body* body = physicsBody->m_body;
+		const bool isAwake = body->IsAwake();
+
+		// Body, which fell asleep during this update, is synced once more to its final transform.
+		if( !isAwake && !physicsBody->m_wasAwake )
+		{
+			continue;
+		}
+		physicsBody->m_wasAwake = isAwake;
+
+		vec2 position(body->GetPosition().x, body->GetPosition().y);
+		float angle = body->GetAngle();
+		if( isAwake )
+		{
+			position = physicsBody->m_previousPosition + (position - physicsBody->m_previousPosition)*alpha;
+			angle = physicsBody->m_previousAngle + (angle - physicsBody->m_previousAngle)*alpha;
+			++numAwakeBodies;
+		}
+
+		GameObject* gameObject = physicsBody->getGameObject();
+		gameObject->setPosition(position);
+		gameObject->setRotation(-angle);
+	}
+	m_stats.numAwakeBodies = numAwakeBodies;
+}
+
+
+void PhysicsWorld::addBody(PhysicsBody* body)
+{
+	body->m_index = (int)m_bodies.size();
+	m_bodies.push_back(body);
+}
+
+
+void PhysicsWorld::removeBody(PhysicsBody* body)
+{
+	assert( body->m_index >= 0 && m_bodies[body->m_index] == body );
+	m_bodies[body->m_index] = m_bodies.back();
+	m_bodies[body->m_index]->m_index = body->m_index;
+	m_bodies.pop_back();
+	body->m_index = -1;
+}
+
+}
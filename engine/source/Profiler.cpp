@@ -0,0 +1,535 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include <Profiler.h>
+#include <Thread.h>
+#include <es_util.h>
+#include <es_assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace yam2d
+{
+
+bool Profiler::s_enabled = true;
+
+// anonymous namespace for internal functions
+namespace
+{
+	struct Event
+	{
+		const char*	name;
+		long long	start;
+		long long	end;
+		int			depth;
+		int			thread;
+	};
+
+	struct ThreadBuffer
+	{
+		explicit ThreadBuffer(int index)
+			: index(index)
+			, name(0)
+			, depth(0)
+			, events(Profiler::BUFFER_SIZE)
+			, numWritten(0)
+			, numProcessed(0)
+			, numCleared(0)
+			, isFree(false)
+		{
+		}
+
+		int					index;
+		const char*			name;
+		int					depth;
+
+		// Ring buffer, which is allocated up front, so that it is not reallocated while being read. Counters wrap, 
+		// so they are used as unsigned.
+		std::vector<Event>	events;
+		AtomicInt			numWritten;
+		unsigned			numProcessed;
+		unsigned			numCleared;
+		bool				isFree;			// Thread of the buffer has exited.
+	};
+
+	struct ZoneHistory
+	{
+		const char*	name;
+		int			depth;
+		long long	frameTicks;
+		int			frameCalls;
+		float		times[Profiler::HISTORY_SIZE];
+		int			calls[Profiler::HISTORY_SIZE];
+	};
+
+	struct NameLess
+	{
+		bool operator()(const char* a, const char* b) const { return strcmp(a, b) < 0; }
+	};
+
+	struct EventOrder
+	{
+		bool operator()(const Event& a, const Event& b) const
+		{
+			return a.thread != b.thread ? a.thread < b.thread : (a.start != b.start ? a.start < b.start : a.depth < b.depth);
+		}
+	};
+
+#if defined(_WIN32)
+	long long queryTicksPerSecond()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return frequency.QuadPart;
+	}
+#else
+	long long queryTicksPerSecond()
+	{
+		return 1000000000LL;
+	}
+#endif
+
+	const long long ticksPerSecond = queryTicksPerSecond();
+
+	Mutex profilerMutex;
+	std::vector<ThreadBuffer*> buffers;
+	YAM_THREAD_LOCAL ThreadBuffer* currentBuffer = 0;
+
+	// Zones in summary order, parents before their children.
+	std::vector<ZoneHistory> zones;
+	std::map<const char*, int, NameLess> zoneIndices;
+	ZoneHistory frameZone;
+	long long frameStartTicks = -1;
+	int numFrames = 0;
+	int historyIndex = 0;
+	std::vector<Event> frameEvents;
+
+	float ticksToMilliseconds(long long ticks)
+	{
+		return float(double(ticks) * 1000.0 / double(ticksPerSecond));
+	}
+
+	ThreadBuffer* getCurrentBuffer()
+	{
+		if( currentBuffer == 0 )
+		{
+			ScopedLock lock(profilerMutex);
+			for( size_t i=0; i<buffers.size() && currentBuffer == 0; ++i )
+			{
+				if( buffers[i]->isFree )
+				{
+					currentBuffer = buffers[i];
+					currentBuffer->isFree = false;
+				}
+			}
+
+			if( currentBuffer == 0 )
+			{
+				currentBuffer = new ThreadBuffer(int(buffers.size()));
+				buffers.push_back(currentBuffer);
+			}
+		}
+
+		return currentBuffer;
+	}
+
+	/** 
+	 * Appends events of buffer from index first to the latest one to events and returns number of events written to 
+	 * the buffer. Owner thread may keep recording, so events, which it overwrote during copying, are left out.
+	 */
+	unsigned copyEvents(ThreadBuffer* buffer, unsigned first, std::vector<Event>& events)
+	{
+		const unsigned bufferSize = unsigned(Profiler::BUFFER_SIZE);
+		const unsigned numWritten = unsigned(buffer->numWritten.get());
+		if( numWritten - first > bufferSize )
+		{
+			// Thread recorded more than fits to its buffer, so oldest zones were overwritten.
+			first = numWritten - bufferSize;
+		}
+
+		const size_t start = events.size();
+		for( unsigned j=first; j != numWritten; ++j )
+		{
+			events.push_back(buffer->events[j % bufferSize]);
+		}
+
+		// Event j shares its slot with event j + BUFFER_SIZE, which is being written, when numWritten has reached it. 
+		// add(0) is a full memory barrier, so the counter is read again only after the events have been copied.
+		const unsigned numWrittenAfter = unsigned(buffer->numWritten.add(0));
+		if( numWrittenAfter - first >= bufferSize )
+		{
+			const unsigned numOverwritten = std::min(numWrittenAfter - first - bufferSize + 1, numWritten - first);
+			events.erase(events.begin() + start, events.begin() + start + numOverwritten);
+		}
+
+		return numWritten;
+	}
+
+	void initZone(ZoneHistory& zone, const char* name, int depth)
+	{
+		zone.name = name;
+		zone.depth = depth;
+		zone.frameTicks = 0;
+		zone.frameCalls = 0;
+		memset(zone.times, 0, sizeof(zone.times));
+		memset(zone.calls, 0, sizeof(zone.calls));
+	}
+
+	/** Adds zone after the subtree of its parent, so that summary stays in tree order. */
+	void addZone(const char* name, int depth, const char* parentName)
+	{
+		size_t index = zones.size();
+		std::map<const char*, int, NameLess>::iterator parent = parentName != 0 ? zoneIndices.find(parentName) : zoneIndices.end();
+		if( parent != zoneIndices.end() )
+		{
+			int parentDepth = zones[parent->second].depth;
+			index = size_t(parent->second) + 1;
+			while( index < zones.size() && zones[index].depth > parentDepth )
+			{
+				++index;
+			}
+		}
+
+		ZoneHistory zone;
+		initZone(zone, name, depth);
+		zones.insert(zones.begin() + index, zone);
+
+		zoneIndices.clear();
+		for( size_t i=0; i<zones.size(); ++i )
+		{
+			zoneIndices[zones[i].name] = int(i);
+		}
+	}
+
+	/** Adds zones, which have not been seen before, in order of the frame events. */
+	void addNewZones()
+	{
+		std::sort(frameEvents.begin(), frameEvents.end(), EventOrder());
+
+		// Stack of enclosing events of the current thread.
+		std::vector<const Event*> stack;
+		for( size_t i=0; i<frameEvents.size(); ++i )
+		{
+			const Event& event = frameEvents[i];
+			while( !stack.empty() && (stack.back()->thread != event.thread || stack.back()->end <= event.start) )
+			{
+				stack.pop_back();
+			}
+
+			if( zoneIndices.find(event.name) == zoneIndices.end() )
+			{
+				addZone(event.name, event.depth, stack.empty() ? 0 : stack.back()->name);
+			}
+
+			stack.push_back(&event);
+		}
+	}
+
+	void writeEscaped(FILE* file, const char* str)
+	{
+		for( ; *str != 0; ++str )
+		{
+			if( *str == '"' || *str == '\\' )
+			{
+				fputc('\\', file);
+			}
+
+			if( (unsigned char)*str >= 0x20 )
+			{
+				fputc(*str, file);
+			}
+		}
+	}
+}
+
+
+void Profiler::setThreadName(const char* name)
+{
+	ThreadBuffer* buffer = getCurrentBuffer();
+	ScopedLock lock(profilerMutex);
+	buffer->name = name;
+}
+
+
+void Profiler::endThread()
+{
+	if( currentBuffer == 0 )
+	{
+		return;
+	}
+
+	// Zones of the exited thread stay in the buffer, until they are overwritten by the next thread.
+	ScopedLock lock(profilerMutex);
+	currentBuffer->name = 0;
+	currentBuffer->depth = 0;
+	currentBuffer->isFree = true;
+	currentBuffer = 0;
+}
+
+
+long long Profiler::getTicks()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER ticks;
+	QueryPerformanceCounter(&ticks);
+	return ticks.QuadPart;
+#else
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (long long)t.tv_sec * 1000000000LL + (long long)t.tv_nsec;
+#endif
+}
+
+
+long long Profiler::getTicksPerSecond()
+{
+	return ticksPerSecond;
+}
+
+
+long long Profiler::beginZone()
+{
+	++getCurrentBuffer()->depth;
+	return getTicks();
+}
+
+
+void Profiler::endZone(const char* name, long long startTicks)
+{
+	Event event;
+	event.name = name;
+	event.start = startTicks;
+	event.end = getTicks();
+
+	ThreadBuffer* buffer = currentBuffer;
+	event.depth = --buffer->depth;
+	event.thread = buffer->index;
+
+	// Only this thread writes, so the counter is published after the event has been written.
+	unsigned numWritten = unsigned(buffer->numWritten.get());
+	buffer->events[numWritten % BUFFER_SIZE] = event;
+	buffer->numWritten.set(int(numWritten + 1));
+}
+
+
+void Profiler::endFrame()
+{
+	if( !s_enabled )
+	{
+		return;
+	}
+
+	long long frameEndTicks = getTicks();
+	ScopedLock lock(profilerMutex);
+
+	frameEvents.clear();
+	for( size_t i=0; i<buffers.size(); ++i )
+	{
+		buffers[i]->numProcessed = copyEvents(buffers[i], buffers[i]->numProcessed, frameEvents);
+	}
+
+	bool hasNewZones = false;
+	for( size_t i=0; i<frameEvents.size() && !hasNewZones; ++i )
+	{
+		hasNewZones = zoneIndices.find(frameEvents[i].name) == zoneIndices.end();
+	}
+
+	// Length of the first frame is not known, so it only starts timing of frames.
+	if( frameStartTicks < 0 )
+	{
+		initZone(frameZone, "Frame", 0);
+		frameStartTicks = frameEndTicks;
+		return;
+	}
+
+	if( hasNewZones )
+	{
+		addNewZones();
+	}
+
+	for( size_t i=0; i<frameEvents.size(); ++i )
+	{
+		ZoneHistory& zone = zones[zoneIndices[frameEvents[i].name]];
+		zone.frameTicks += frameEvents[i].end - frameEvents[i].start;
+		++zone.frameCalls;
+	}
+
+	frameZone.frameTicks = frameEndTicks - frameStartTicks;
+	frameZone.frameCalls = 1;
+	frameStartTicks = frameEndTicks;
+
+	for( size_t i=0; i<=zones.size(); ++i )
+	{
+		ZoneHistory& zone = (i < zones.size()) ? zones[i] : frameZone;
+		zone.times[historyIndex] = ticksToMilliseconds(zone.frameTicks);
+		zone.calls[historyIndex] = zone.frameCalls;
+		zone.frameTicks = 0;
+		zone.frameCalls = 0;
+	}
+
+	historyIndex = (historyIndex + 1) % HISTORY_SIZE;
+	if( numFrames < HISTORY_SIZE )
+	{
+		++numFrames;
+	}
+}
+
+
+void Profiler::getSummary(std::vector<ZoneSummary>& summary)
+{
+	ScopedLock lock(profilerMutex);
+	summary.clear();
+	if( numFrames == 0 )
+	{
+		return;
+	}
+
+	// Frame is the root, so other zones are one level deeper.
+	for( int i=-1; i<(int)zones.size(); ++i )
+	{
+		const ZoneHistory& zone = (i < 0) ? frameZone : zones[i];
+		ZoneSummary zoneSummary;
+		zoneSummary.name = zone.name;
+		zoneSummary.depth = (i < 0) ? 0 : zone.depth + 1;
+		zoneSummary.minTime = zone.times[0];
+		zoneSummary.maxTime = zone.times[0];
+		float totalTime = 0.0f;
+		int totalCalls = 0;
+		for( int j=0; j<numFrames; ++j )
+		{
+			zoneSummary.minTime = std::min(zoneSummary.minTime, zone.times[j]);
+			zoneSummary.maxTime = std::max(zoneSummary.maxTime, zone.times[j]);
+			totalTime += zone.times[j];
+			totalCalls += zone.calls[j];
+		}
+		zoneSummary.averageTime = totalTime / float(numFrames);
+		zoneSummary.averageCalls = float(totalCalls) / float(numFrames);
+		summary.push_back(zoneSummary);
+	}
+}
+
+
+void Profiler::logSummary()
+{
+	std::vector<ZoneSummary> summary;
+	getSummary(summary);
+	esLogMessage("Profile of %d frames (ms per frame):", numFrames);
+	for( size_t i=0; i<summary.size(); ++i )
+	{
+		const ZoneSummary& zone = summary[i];
+		esLogMessage("%*s%-*s min %8.3f avg %8.3f max %8.3f calls %8.1f", 2*zone.depth, "", 40 - 2*zone.depth, zone.name,
+			zone.minTime, zone.averageTime, zone.maxTime, zone.averageCalls);
+	}
+}
+
+
+bool Profiler::writeChromeTrace(const char* fileName)
+{
+	ScopedLock lock(profilerMutex);
+	FILE* file = fopen(fileName, "w");
+	if( file == 0 )
+	{
+		esLogEngineError("[%s] Trace file: %s could not be opened!", __FUNCTION__, fileName);
+		return false;
+	}
+
+	// Trace starts from the oldest zone in the buffers.
+	std::vector<Event> events;
+	for( size_t i=0; i<buffers.size(); ++i )
+	{
+		copyEvents(buffers[i], buffers[i]->numCleared, events);
+	}
+
+	long long origin = -1;
+	for( size_t i=0; i<events.size(); ++i )
+	{
+		if( origin < 0 || events[i].start < origin )
+		{
+			origin = events[i].start;
+		}
+	}
+
+	const double ticksToMicroseconds = 1000000.0 / double(ticksPerSecond);
+	fprintf(file, "{\"traceEvents\":[\n");
+	const char* separator = "";
+	for( size_t i=0; i<buffers.size(); ++i )
+	{
+		ThreadBuffer* buffer = buffers[i];
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"", separator, buffer->index);
+		if( buffer->name != 0 )
+		{
+			writeEscaped(file, buffer->name);
+		}
+		else
+		{
+			fprintf(file, "Thread %d", buffer->index);
+		}
+		fprintf(file, "\"}}");
+		separator = ",\n";
+	}
+
+	for( size_t i=0; i<events.size(); ++i )
+	{
+		const Event& event = events[i];
+		fprintf(file, "%s{\"name\":\"", separator);
+		writeEscaped(file, event.name);
+		fprintf(file, "\",\"cat\":\"yam2d\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", event.thread,
+			double(event.start - origin)*ticksToMicroseconds, double(event.end - event.start)*ticksToMicroseconds);
+	}
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+	if( !ok )
+	{
+		esLogEngineError("[%s] Trace file: %s could not be written!", __FUNCTION__, fileName);
+	}
+	return ok;
+}
+
+
+void Profiler::clear()
+{
+	ScopedLock lock(profilerMutex);
+	for( size_t i=0; i<buffers.size(); ++i )
+	{
+		unsigned numWritten = unsigned(buffers[i]->numWritten.get());
+		buffers[i]->numProcessed = numWritten;
+		buffers[i]->numCleared = numWritten;
+	}
+
+	zones.clear();
+	zoneIndices.clear();
+	frameStartTicks = -1;
+	numFrames = 0;
+	historyIndex = 0;
+}
+
+}
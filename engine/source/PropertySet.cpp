@@ -5,6 +5,7 @@
 #include <cstdarg>
 #include <MiniJSON.h>
 #include <FileStream.h>
+#include <Logger.h>
 
 namespace yam2d
 {
@@ -53,6 +54,7 @@ Property::Property(const std::string& name)
 	, m_property(0)
     //, m_attributes(0)
 {
+	setMemorySubsystem(MemoryStats::PROPERTY_SETS);
 }
 
 Property::~Property()
@@ -67,6 +69,7 @@ Property::Property(const Property& o)
 	, m_property(o.m_property)
     //, m_attributes(0)
 {
+	setMemorySubsystem(MemoryStats::PROPERTY_SETS);
     //if( o.m_attributes.ptr() )
     //{
     //	setAttributes(*o.m_attributes);
@@ -188,7 +191,7 @@ const std::string Property::getAsString() const
 	return res;
 }
 
-const bool Property::getAsBool() const
+bool Property::getAsBool() const
 {	
 	if( isTypeOf<int>() )
 	{
@@ -210,7 +213,7 @@ const bool Property::getAsBool() const
     return false;
 }
 
-const float Property::getAsFloat() const
+float Property::getAsFloat() const
 {
     assert_message(this->m_property != 0, "Null property in \"" + getName() + "\"" );
 
@@ -257,12 +260,14 @@ PropertySet::PropertySet()
 	: Object()
 	, m_properties()
 {
+	setMemorySubsystem(MemoryStats::PROPERTY_SETS);
 }
 
 PropertySet::PropertySet(const PropertySet& o)
 	: Object()
     , m_properties(o.m_properties)
 {
+	setMemorySubsystem(MemoryStats::PROPERTY_SETS);
    // std::string json = Json::Serialize(o);
    // PropertySet ps = Json::Deserialize(json);
    // m_properties = ps.m_properties;
@@ -509,7 +514,7 @@ PropertySet PropertySet::readFromFile(const std::string& filename)
 
     if ( jsonString.length() < 4 )
     {
-		esLogMessage( "File: \"%s\" does not have enought data for json\n", filename.c_str() );
+		YAM2D_LOG_WARNING( Logger::CATEGORY_ASSETS, "File: \"%s\" does not have enought data for json", filename.c_str() );
         return PropertySet();
     }
 
@@ -525,7 +530,7 @@ void PropertySet::writeToFile(const PropertySet& properties,const std::string& f
 	
 	if (fs == 0)
 	{
-		esLogMessage( "File: \"%s\" could not be opened\n", filename.c_str() );
+		YAM2D_LOG_WARNING( Logger::CATEGORY_ASSETS, "File: \"%s\" could not be opened", filename.c_str() );
 		return;		
 	}
 	
@@ -0,0 +1,396 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include <RenderSnapshot.h>
+#include <SpriteBatch.h>
+#include <Sprite.h>
+#include <Text.h>
+#include <SpriteSheet.h>
+#include <Texture.h>
+#include <Camera.h>
+#include <MapController.h>
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <es_assert.h>
+#include <algorithm>
+
+namespace yam2d
+{
+
+// anonymous namespace for internal functions
+namespace
+{
+	template<class T>
+	int getCapacityInBytes(const std::vector<T>& v)
+	{
+		return int(v.capacity()*sizeof(T));
+	}
+
+	// Releases reference. The last reference is moved to lastReferences instead.
+	template<class T>
+	void releaseReference(Ref<T>& ref, std::vector< Ref<Object> >& lastReferences)
+	{
+		if( ref.ptr() != 0 && ref->getRefCount() == 1 )
+		{
+			lastReferences.push_back(ref.ptr());
+		}
+		ref = 0;
+	}
+}
+
+RenderSnapshot::RenderSnapshot()
+	: Object()
+	, m_accountedBytes(0)
+	, m_screenWidth(0)
+	, m_screenHeight(0)
+	, m_desiredAspectRatio(1.0f)
+	, m_screenUnitSize(1.0f)
+	, m_cameraPosition(0.0f)
+	, m_layers()
+	, m_sprites()
+	, m_positions()
+	, m_textureCoords()
+	, m_colors()
+	, m_textures()
+	, m_sequence(0)
+{
+	setMemorySubsystem(MemoryStats::VERTEX_BUFFERS);
+}
+
+RenderSnapshot::~RenderSnapshot()
+{
+	MemoryStats::updateBytes(MemoryStats::VERTEX_BUFFERS, m_accountedBytes, 0);
+}
+
+void RenderSnapshot::updateMemoryStats()
+{
+	int numBytes = getCapacityInBytes(m_layers) + getCapacityInBytes(m_sprites) + getCapacityInBytes(m_positions) + 
+		getCapacityInBytes(m_textureCoords) + getCapacityInBytes(m_colors) + getCapacityInBytes(m_textures);
+	MemoryStats::updateBytes(MemoryStats::VERTEX_BUFFERS, m_accountedBytes, numBytes);
+}
+
+void RenderSnapshot::clear(std::vector< Ref<Object> >& lastReferences)
+{
+	// References are released one by one, so that the last one is found also when a texture is referenced twice.
+	for( size_t i=0; i<m_layers.size(); ++i )
+	{
+		releaseReference(m_layers[i].staticBatch, lastReferences);
+	}
+	for( size_t i=0; i<m_textures.size(); ++i )
+	{
+		releaseReference(m_textures[i], lastReferences);
+	}
+
+	// Vectors keep their capacity, so snapshots of following frames do not allocate.
+	m_layers.clear();
+	m_sprites.clear();
+	m_positions.clear();
+	m_textureCoords.clear();
+	m_colors.clear();
+	m_textures.clear();
+	m_sequence = 0;
+}
+
+void RenderSnapshot::setCamera(const Camera* camera, const vec2& devicePosition)
+{
+	m_screenWidth = camera->getScreenWidth();
+	m_screenHeight = camera->getScreenHeight();
+	m_desiredAspectRatio = camera->getDesiredAspectRatio();
+	m_screenUnitSize = camera->getScreenUnitSize();
+	m_cameraPosition = devicePosition;
+}
+
+void RenderSnapshot::addLayer(int layerIndex, SpriteBatchGroup* staticBatch)
+{
+	LayerInstance layer;
+	layer.staticBatch = staticBatch;
+	layer.layerIndex = layerIndex;
+	layer.firstSprite = (int)m_sprites.size();
+	layer.numSprites = 0;
+	m_layers.push_back(layer);
+}
+
+void RenderSnapshot::addSprite(Texture* texture, Sprite* sprite, const vec2& position, float rotation, const vec2& scale, const vec2& offset)
+{
+	// Vertices are made by render thread in RenderSnapshotBuffer::batch.
+	SpriteInstance& instance = addInstance(texture, position, rotation, scale, offset);
+	instance.quad = sprite->getQuad();
+	instance.numVertices = 6;
+}
+
+void RenderSnapshot::addText(Texture* texture, Text* text, const vec2& position, float rotation, const vec2& scale, const vec2& offset)
+{
+	int firstVertex = int(m_positions.size()/3);
+	text->getVertexData(m_positions, m_textureCoords, m_colors);
+	SpriteInstance& instance = addInstance(texture, position, rotation, scale, offset);
+	instance.firstVertex = firstVertex;
+	instance.numVertices = int(m_positions.size()/3) - firstVertex;
+}
+
+RenderSnapshot::SpriteInstance& RenderSnapshot::addInstance(Texture* texture, const vec2& position, float rotation, const vec2& scale, const vec2& offset)
+{
+	assert( !m_layers.empty() && m_layers.back().staticBatch == 0 );
+
+	SpriteInstance sprite;
+	sprite.texture = texture;
+	sprite.firstVertex = -1;
+	sprite.numVertices = 0;
+	sprite.position = position;
+	sprite.rotation = rotation;
+	sprite.scale = scale;
+	sprite.offset = offset;
+	m_sprites.push_back(sprite);
+	++m_layers.back().numSprites;
+
+	// Sprites of a layer mostly share few textures, so comparing to the previous one is enough for keeping 
+	// references small. Textures must stay alive until render thread has drawn the snapshot.
+	if( texture != 0 && (m_textures.empty() || m_textures.back().ptr() != texture) )
+	{
+		m_textures.push_back(texture);
+	}
+	return m_sprites.back();
+}
+
+
+RenderSnapshotBuffer::RenderSnapshotBuffer()
+	: Object()
+	, m_writeIndex(0)
+	, m_nextSequence(0)
+	, m_latest(1)
+	, m_releaseMutex()
+	, m_releaseQueue()
+	, m_accountedBytes(0)
+	, m_readIndex(2)
+	, m_readSequence(0)
+	, m_order()
+	, m_drawBatches()
+	, m_positions()
+	, m_textureCoords()
+	, m_colors()
+	, m_released()
+	, m_numPublished(0)
+	, m_numDropped(0)
+	, m_numAcquired(0)
+	, m_numRepeated(0)
+	, m_maxQueueDepth(0)
+	, m_totalQueueDepth(0)
+{
+	setMemorySubsystem(MemoryStats::VERTEX_BUFFERS);
+	for( int i=0; i<3; ++i )
+	{
+		m_snapshots[i] = new RenderSnapshot();
+	}
+}
+
+RenderSnapshotBuffer::~RenderSnapshotBuffer()
+{
+	MemoryStats::updateBytes(MemoryStats::VERTEX_BUFFERS, m_accountedBytes, 0);
+}
+
+RenderSnapshot* RenderSnapshotBuffer::beginWrite()
+{
+	RenderSnapshot* snapshot = m_snapshots[m_writeIndex];
+	ScopedLock lock(m_releaseMutex);
+	snapshot->clear(m_releaseQueue);
+	return snapshot;
+}
+
+void RenderSnapshotBuffer::publish()
+{
+	m_snapshots[m_writeIndex]->m_sequence = ++m_nextSequence;
+	m_snapshots[m_writeIndex]->updateMemoryStats();
+
+	// Exchange is a full barrier, so render thread sees the written snapshot, when it sees the new index.
+	int previous = m_latest.exchange(m_writeIndex | NEW_SNAPSHOT);
+	if( (previous & NEW_SNAPSHOT) != 0 )
+	{
+		m_numDropped.increment();
+	}
+
+	m_writeIndex = previous & INDEX_MASK;
+	m_numPublished.increment();
+}
+
+const RenderSnapshot* RenderSnapshotBuffer::acquire()
+{
+	// Nothing else references the queued objects, so they can be released here without locking reference counts.
+	{
+		ScopedLock lock(m_releaseMutex);
+		m_released.swap(m_releaseQueue);
+	}
+	m_released.clear();
+
+	if( (m_latest.get() & NEW_SNAPSHOT) != 0 )
+	{
+		m_readIndex = m_latest.exchange(m_readIndex) & INDEX_MASK;
+
+		unsigned sequence = m_snapshots[m_readIndex]->m_sequence;
+		int queueDepth = int(sequence - m_readSequence);
+		m_readSequence = sequence;
+
+		++m_numAcquired;
+		m_totalQueueDepth += queueDepth;
+		if( queueDepth > m_maxQueueDepth )
+		{
+			m_maxQueueDepth = queueDepth;
+		}
+	}
+	else
+	{
+		++m_numRepeated;
+	}
+
+	return m_snapshots[m_readIndex];
+}
+
+void RenderSnapshotBuffer::batch()
+{
+	YAM2D_PROFILE_ZONE("RenderSnapshotBuffer::batch");
+	const RenderSnapshot* snapshot = m_snapshots[m_readIndex];
+	m_drawBatches.clear();
+	m_positions.clear();
+	m_textureCoords.clear();
+	m_colors.clear();
+
+	for( size_t i=0; i<snapshot->m_layers.size(); ++i )
+	{
+		const RenderSnapshot::LayerInstance& layer = snapshot->m_layers[i];
+		if( layer.staticBatch != 0 )
+		{
+			continue;
+		}
+
+		// Sprites are drawn grouped by texture in texture order, like SpriteBatchGroup does.
+		long long startTicks = Profiler::getTicks();
+		size_t firstDrawBatch = m_drawBatches.size();
+		m_order.clear();
+		for( int j=0; j<layer.numSprites; ++j )
+		{
+			m_order.push_back(layer.firstSprite + j);
+		}
+		std::stable_sort(m_order.begin(), m_order.end(), TextureOrder(snapshot));
+
+		for( size_t j=0; j<m_order.size(); ++j )
+		{
+			const RenderSnapshot::SpriteInstance& sprite = snapshot->m_sprites[m_order[j]];
+			size_t startVertex = m_positions.size()/3;
+			if( m_drawBatches.empty() || m_drawBatches.back().layer != int(i) || m_drawBatches.back().texture != sprite.texture )
+			{
+				DrawBatch drawBatch;
+				drawBatch.texture = sprite.texture;
+				drawBatch.layer = int(i);
+				drawBatch.numSprites = 0;
+				drawBatch.firstVertex = startVertex;
+				drawBatch.numVertices = 0;
+				m_drawBatches.push_back(drawBatch);
+			}
+
+			if( sprite.firstVertex < 0 )
+			{
+				Sprite::getVertexData(sprite.quad, m_positions, m_textureCoords, m_colors);
+			}
+			else
+			{
+				size_t first = size_t(sprite.firstVertex);
+				size_t end = first + size_t(sprite.numVertices);
+				m_positions.insert(m_positions.end(), snapshot->m_positions.begin() + first*3, snapshot->m_positions.begin() + end*3);
+				m_textureCoords.insert(m_textureCoords.end(), snapshot->m_textureCoords.begin() + first*2, snapshot->m_textureCoords.begin() + end*2);
+				m_colors.insert(m_colors.end(), snapshot->m_colors.begin() + first*4, snapshot->m_colors.begin() + end*4);
+			}
+			SpriteBatch::transformVertices(m_positions, m_textureCoords, startVertex, sprite.position, sprite.rotation, sprite.scale, sprite.offset);
+			m_drawBatches.back().numVertices += size_t(sprite.numVertices);
+			++m_drawBatches.back().numSprites;
+		}
+
+		if( RenderStats::isEnabled() )
+		{
+			RenderStats::setCurrentLayer(layer.layerIndex);
+			for( size_t j=firstDrawBatch; j<m_drawBatches.size(); ++j )
+			{
+				RenderStats::addBatched(m_drawBatches[j].texture, m_drawBatches[j].numSprites);
+			}
+			RenderStats::addBatchTime(float(double(Profiler::getTicks() - startTicks) * 1000.0 / double(Profiler::getTicksPerSecond())));
+		}
+	}
+	RenderStats::setCurrentLayer(RenderStats::NO_LAYER);
+
+	int numBytes = getCapacityInBytes(m_order) + getCapacityInBytes(m_drawBatches) + getCapacityInBytes(m_positions) + 
+		getCapacityInBytes(m_textureCoords) + getCapacityInBytes(m_colors);
+	MemoryStats::updateBytes(MemoryStats::VERTEX_BUFFERS, m_accountedBytes, numBytes);
+}
+
+void RenderSnapshotBuffer::draw()
+{
+	YAM2D_PROFILE_ZONE("RenderSnapshotBuffer::draw");
+	const RenderSnapshot* snapshot = m_snapshots[m_readIndex];
+	if( snapshot->m_layers.empty() )
+	{
+		return;
+	}
+
+	renderCamera(snapshot->m_screenWidth, snapshot->m_screenHeight, snapshot->m_desiredAspectRatio, snapshot->m_screenUnitSize, snapshot->m_cameraPosition);
+
+	size_t drawBatchIndex = 0;
+	for( size_t i=0; i<snapshot->m_layers.size(); ++i )
+	{
+		const RenderSnapshot::LayerInstance& layer = snapshot->m_layers[i];
+		RenderStats::setCurrentLayer(layer.layerIndex);
+		if( layer.staticBatch != 0 )
+		{
+			layer.staticBatch.ptr()->render();
+			continue;
+		}
+
+		for( ; drawBatchIndex<m_drawBatches.size() && m_drawBatches[drawBatchIndex].layer == int(i); ++drawBatchIndex )
+		{
+			const DrawBatch& drawBatch = m_drawBatches[drawBatchIndex];
+			SpriteBatch::draw(drawBatch.texture, &m_positions[drawBatch.firstVertex*3], &m_textureCoords[drawBatch.firstVertex*2],
+				&m_colors[drawBatch.firstVertex*4], int(drawBatch.numVertices));
+		}
+	}
+	RenderStats::setCurrentLayer(RenderStats::NO_LAYER);
+}
+
+void RenderSnapshotBuffer::render()
+{
+	acquire();
+	batch();
+	draw();
+}
+
+float RenderSnapshotBuffer::getAverageQueueDepth() const
+{
+	int numAcquires = m_numAcquired + m_numRepeated;
+	return numAcquires > 0 ? float(m_totalQueueDepth) / float(numAcquires) : 0.0f;
+}
+
+void RenderSnapshotBuffer::resetStats()
+{
+	m_numPublished.set(0);
+	m_numDropped.set(0);
+	m_numAcquired = 0;
+	m_numRepeated = 0;
+	m_maxQueueDepth = 0;
+	m_totalQueueDepth = 0;
+}
+
+}
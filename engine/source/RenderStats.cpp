@@ -0,0 +1,353 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <RenderStats.h>
+#include <Texture.h>
+#include <Thread.h>
+#include <es_util.h>
+#include <algorithm>
+#include <map>
+
+namespace yam2d
+{
+
+bool RenderStats::s_enabled = true;
+
+// anonymous namespace for internal functions
+namespace
+{
+	struct TextureRecord
+	{
+		int						width;
+		int						height;
+		RenderStats::Counters	counters;
+	};
+
+	struct VertexOrder
+	{
+		bool operator()(const RenderStats::TextureStats& a, const RenderStats::TextureStats& b) const
+		{
+			return a.counters.numVertices != b.counters.numVertices ? a.counters.numVertices > b.counters.numVertices : a.nativeId < b.nativeId;
+		}
+	};
+
+	Mutex statsMutex;
+	YAM_THREAD_LOCAL int currentLayer = RenderStats::NO_LAYER;
+
+	// Records of the current frame. Records are kept between frames and only their counters are reset, so that 
+	// recording does not allocate every frame.
+	RenderStats::Counters totalCounters;
+	RenderStats::PhysicsCounters physicsCounters;
+	std::map<int, RenderStats::Counters> layerCounters;
+	std::map<int, TextureRecord> textureRecords;
+
+	std::vector<RenderStats::FrameStats> history;
+	int numFrames = 0;
+	int historyIndex = 0;
+	int frameIndex = 0;
+
+	bool isZero(const RenderStats::Counters& counters)
+	{
+		return counters.numSpritesBatched == 0 && counters.numSpritesCulled == 0 && counters.numVertices == 0 && 
+			counters.numDrawCalls == 0 && counters.numBytesUploaded == 0 && counters.batchTime == 0.0f;
+	}
+
+	/** Adds counters to total, current layer of calling thread and given texture, which may be 0. */
+	void addCounters(Texture* texture, const RenderStats::Counters& counters)
+	{
+		int layer = currentLayer;
+		ScopedLock lock(statsMutex);
+		totalCounters.add(counters);
+		if( layer != RenderStats::NO_LAYER )
+		{
+			layerCounters[layer].add(counters);
+		}
+
+		if( texture != 0 )
+		{
+			TextureRecord& record = textureRecords[texture->getNativeId()];
+			record.width = texture->getWidth();
+			record.height = texture->getHeight();
+			record.counters.add(counters);
+		}
+	}
+}
+
+
+RenderStats::Counters::Counters()
+	: numSpritesBatched(0)
+	, numSpritesCulled(0)
+	, numVertices(0)
+	, numDrawCalls(0)
+	, numBytesUploaded(0)
+	, batchTime(0.0f)
+{
+}
+
+
+void RenderStats::Counters::add(const Counters& other)
+{
+	numSpritesBatched += other.numSpritesBatched;
+	numSpritesCulled += other.numSpritesCulled;
+	numVertices += other.numVertices;
+	numDrawCalls += other.numDrawCalls;
+	numBytesUploaded += other.numBytesUploaded;
+	batchTime += other.batchTime;
+}
+
+
+RenderStats::PhysicsCounters::PhysicsCounters()
+	: stepTime(0.0f)
+	, numSteps(0)
+	, numBodies(0)
+	, numAwakeBodies(0)
+	, numContacts(0)
+	, numProxies(0)
+{
+}
+
+
+void RenderStats::setCurrentLayer(int layerIndex)
+{
+	currentLayer = layerIndex;
+}
+
+
+int RenderStats::getCurrentLayer()
+{
+	return currentLayer;
+}
+
+
+void RenderStats::addBatched(Texture* texture, int numSprites)
+{
+	if( !s_enabled || numSprites == 0 )
+	{
+		return;
+	}
+
+	Counters counters;
+	counters.numSpritesBatched = numSprites;
+	addCounters(texture, counters);
+}
+
+
+void RenderStats::addCulled(int numSprites)
+{
+	if( !s_enabled || numSprites == 0 )
+	{
+		return;
+	}
+
+	Counters counters;
+	counters.numSpritesCulled = numSprites;
+	addCounters(0, counters);
+}
+
+
+void RenderStats::addBatchTime(float milliseconds)
+{
+	if( !s_enabled )
+	{
+		return;
+	}
+
+	Counters counters;
+	counters.batchTime = milliseconds;
+	addCounters(0, counters);
+}
+
+
+void RenderStats::addDrawCall(Texture* texture, int numVertices)
+{
+	if( !s_enabled )
+	{
+		return;
+	}
+
+	Counters counters;
+	counters.numVertices = numVertices;
+	counters.numDrawCalls = 1;
+	addCounters(texture, counters);
+}
+
+
+void RenderStats::addTextureUpload(Texture* texture, int numBytes)
+{
+	if( !s_enabled )
+	{
+		return;
+	}
+
+	Counters counters;
+	counters.numBytesUploaded = numBytes;
+	addCounters(texture, counters);
+}
+
+
+void RenderStats::addPhysics(const PhysicsCounters& counters)
+{
+	if( !s_enabled )
+	{
+		return;
+	}
+
+	ScopedLock lock(statsMutex);
+	const float stepTime = physicsCounters.stepTime + counters.stepTime;
+	const int numSteps = physicsCounters.numSteps + counters.numSteps;
+	physicsCounters = counters;
+	physicsCounters.stepTime = stepTime;
+	physicsCounters.numSteps = numSteps;
+}
+
+
+void RenderStats::endFrame()
+{
+	if( !s_enabled )
+	{
+		return;
+	}
+
+	ScopedLock lock(statsMutex);
+	if( history.empty() )
+	{
+		history.resize(HISTORY_SIZE);
+	}
+
+	// Vectors of the overwritten frame keep their capacity.
+	FrameStats& frame = history[historyIndex];
+	frame.frameIndex = frameIndex++;
+	frame.total = totalCounters;
+	frame.physics = physicsCounters;
+	frame.layers.clear();
+	frame.textures.clear();
+	totalCounters = Counters();
+	physicsCounters = PhysicsCounters();
+
+	for( std::map<int, Counters>::iterator it = layerCounters.begin(); it != layerCounters.end(); ++it )
+	{
+		if( !isZero(it->second) )
+		{
+			LayerStats layer;
+			layer.layerIndex = it->first;
+			layer.counters = it->second;
+			frame.layers.push_back(layer);
+			it->second = Counters();
+		}
+	}
+
+	for( std::map<int, TextureRecord>::iterator it = textureRecords.begin(); it != textureRecords.end(); ++it )
+	{
+		if( !isZero(it->second.counters) )
+		{
+			TextureStats texture;
+			texture.nativeId = it->first;
+			texture.width = it->second.width;
+			texture.height = it->second.height;
+			texture.counters = it->second.counters;
+			frame.textures.push_back(texture);
+			it->second.counters = Counters();
+		}
+	}
+	std::sort(frame.textures.begin(), frame.textures.end(), VertexOrder());
+
+	historyIndex = (historyIndex + 1) % HISTORY_SIZE;
+	if( numFrames < HISTORY_SIZE )
+	{
+		++numFrames;
+	}
+}
+
+
+int RenderStats::getNumFrames()
+{
+	ScopedLock lock(statsMutex);
+	return numFrames;
+}
+
+
+bool RenderStats::getFrame(int framesAgo, FrameStats& frame)
+{
+	ScopedLock lock(statsMutex);
+	if( framesAgo < 0 || framesAgo >= numFrames )
+	{
+		return false;
+	}
+
+	frame = history[(historyIndex - 1 - framesAgo + 2*HISTORY_SIZE) % HISTORY_SIZE];
+	return true;
+}
+
+
+void RenderStats::logFrame(int framesAgo)
+{
+	FrameStats frame;
+	if( !getFrame(framesAgo, frame) )
+	{
+		esLogMessage("Render stats: no frame %d", framesAgo);
+		return;
+	}
+
+	const Counters& total = frame.total;
+	esLogMessage("Render stats of frame %d: sprites %d culled %d vertices %d draw calls %d uploaded %d bytes batching %.3f ms", 
+		frame.frameIndex, total.numSpritesBatched, total.numSpritesCulled, total.numVertices, total.numDrawCalls, 
+		total.numBytesUploaded, total.batchTime);
+
+	const PhysicsCounters& physics = frame.physics;
+	if( physics.numBodies > 0 )
+	{
+		esLogMessage("  physics:           steps %d step time %.3f ms bodies %d awake %d contacts %d proxies %d", physics.numSteps, 
+			physics.stepTime, physics.numBodies, physics.numAwakeBodies, physics.numContacts, physics.numProxies);
+	}
+
+	for( size_t i=0; i<frame.layers.size(); ++i )
+	{
+		const Counters& counters = frame.layers[i].counters;
+		esLogMessage("  layer %2d:          sprites %6d culled %6d vertices %7d draw calls %4d batching %.3f ms", frame.layers[i].layerIndex, 
+			counters.numSpritesBatched, counters.numSpritesCulled, counters.numVertices, counters.numDrawCalls, counters.batchTime);
+	}
+
+	for( size_t i=0; i<frame.textures.size(); ++i )
+	{
+		const TextureStats& texture = frame.textures[i];
+		esLogMessage("  texture %3d %4dx%-4d sprites %6d vertices %7d draw calls %4d uploaded %d bytes", texture.nativeId, 
+			texture.width, texture.height, texture.counters.numSpritesBatched, texture.counters.numVertices, 
+			texture.counters.numDrawCalls, texture.counters.numBytesUploaded);
+	}
+}
+
+
+void RenderStats::clear()
+{
+	ScopedLock lock(statsMutex);
+	totalCounters = Counters();
+	physicsCounters = PhysicsCounters();
+	layerCounters.clear();
+	textureRecords.clear();
+	history.clear();
+	numFrames = 0;
+	historyIndex = 0;
+}
+
+
+}
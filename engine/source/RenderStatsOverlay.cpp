@@ -0,0 +1,151 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include <RenderStatsOverlay.h>
+#include <TextComponent.h>
+#include <Camera.h>
+#include <Layer.h>
+#include <Map.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace yam2d
+{
+
+// anonymous namespace for internal functions
+namespace
+{
+	/** Formats text to buffer of given size. Text, which does not fit, is truncated. */
+	void formatLine(char* buffer, size_t size, const char* format, ...)
+	{
+		va_list args;
+		va_start(args, format);
+#if defined(_WIN32)
+		vsnprintf_s(buffer, size, _TRUNCATE, format, args);
+#else
+		vsnprintf(buffer, size, format, args);
+#endif
+		va_end(args);
+	}
+}
+
+GameObject* RenderStatsOverlay::create(Layer* layer, SpriteSheet* font, int numLines)
+{
+	assert( numLines > 0 );
+
+	// Each line is a game object of its own, because texts are drawn at the position of their game object.
+	std::vector<Text*> lines;
+	for( int i=0; i<numLines; ++i )
+	{
+		GameObject* gameObject = new GameObject(layer);
+		TextComponent* textComponent = new TextComponent(gameObject, font);
+		gameObject->addComponent(textComponent);
+		layer->addGameObject(gameObject);
+		lines.push_back(textComponent->getText());
+	}
+
+	GameObject* owner = lines[0]->getGameObject();
+	owner->addComponent(new RenderStatsOverlay(owner, layer, lines));
+	return owner;
+}
+
+
+RenderStatsOverlay::RenderStatsOverlay(GameObject* owner, Layer* layer, const std::vector<Text*>& lines)
+	: Component(owner, Component::getDefaultProperties())
+	, m_layer(layer)
+	, m_lines(lines.begin(), lines.end())
+	, m_frame()
+	, m_refreshInterval(0.5f)
+	, m_timeToRefresh(0.0f)
+{
+}
+
+
+RenderStatsOverlay::~RenderStatsOverlay()
+{
+}
+
+
+void RenderStatsOverlay::update(float deltaTime)
+{
+	m_timeToRefresh -= deltaTime;
+	if( m_timeToRefresh <= 0.0f )
+	{
+		updateTexts();
+		m_timeToRefresh = m_refreshInterval;
+	}
+
+	// Texts are centered to their position, so they are moved by half of their width for aligning them left.
+	Map* map = m_layer->getMap();
+	Camera* camera = map->getCamera();
+	vec2 topLeft = camera->getPosition() - 0.5f*camera->getSize();
+	float lineHeight = float(m_lines[0]->getFont()->getClip(0).clipSize.y) / map->getTileHeight();
+	for( size_t i=0; i<m_lines.size(); ++i )
+	{
+		Text* text = m_lines[i];
+		float x = topLeft.x + 0.5f*float(text->getWidth())/map->getTileWidth();
+		float y = topLeft.y + (float(i) + 0.5f)*lineHeight;
+		text->getGameObject()->setPosition(x, y);
+	}
+}
+
+
+void RenderStatsOverlay::updateTexts()
+{
+	char str[128];
+	size_t line = 0;
+	if( RenderStats::getFrame(0, m_frame) )
+	{
+		const RenderStats::Counters& total = m_frame.total;
+		formatLine(str, sizeof(str), "Frame %d: sprites %d culled %d vertices %d draws %d upload %d B batch %.2f ms", m_frame.frameIndex, 
+			total.numSpritesBatched, total.numSpritesCulled, total.numVertices, total.numDrawCalls, total.numBytesUploaded, 
+			total.batchTime);
+		m_lines[line++]->setText(str);
+
+		for( size_t i=0; i<m_frame.layers.size() && line<m_lines.size(); ++i )
+		{
+			const RenderStats::Counters& counters = m_frame.layers[i].counters;
+			formatLine(str, sizeof(str), "Layer %d: sprites %d culled %d vertices %d draws %d batch %.2f ms", m_frame.layers[i].layerIndex, 
+				counters.numSpritesBatched, counters.numSpritesCulled, counters.numVertices, counters.numDrawCalls, 
+				counters.batchTime);
+			m_lines[line++]->setText(str);
+		}
+
+		// Textures are in decreasing order of vertices, so the most expensive ones are shown.
+		for( size_t i=0; i<m_frame.textures.size() && line<m_lines.size(); ++i )
+		{
+			const RenderStats::TextureStats& texture = m_frame.textures[i];
+			formatLine(str, sizeof(str), "Texture %d (%dx%d): sprites %d vertices %d draws %d upload %d B", texture.nativeId, texture.width, 
+				texture.height, texture.counters.numSpritesBatched, texture.counters.numVertices, texture.counters.numDrawCalls, 
+				texture.counters.numBytesUploaded);
+			m_lines[line++]->setText(str);
+		}
+	}
+
+	for( ; line<m_lines.size(); ++line )
+	{
+		m_lines[line]->setText("");
+	}
+}
+
+}
@@ -0,0 +1,361 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "SpatialHashGrid.h"
+#include "GameObject.h"
+#include <math.h>
+
+namespace yam2d
+{
+
+namespace
+{
+	// Objects covering more cells are stored to list of large objects.
+	const int MAX_CELLS_PER_PROXY = 16;
+
+	// Cell coordinates are clamped to this range to avoid integer overflow with objects far away.
+	const float MAX_CELL_COORDINATE = 1000000.0f;
+
+	size_t roundUpToPowerOfTwo(size_t value)
+	{
+		size_t result = 1;
+		while( result < value )
+		{
+			result *= 2;
+		}
+		return result;
+	}
+}
+
+
+SpatialHashGrid::SpatialHashGrid(float cellSize, int numBuckets)
+: Broadphase()
+, m_cellSize(cellSize)
+, m_inverseCellSize(1.0f / cellSize)
+, m_proxies()
+, m_freeProxy(-1)
+, m_buckets(roundUpToPowerOfTwo(numBuckets > 0 ? numBuckets : 1))
+, m_numEntries(0)
+, m_largeProxies()
+{
+	assert( cellSize > 0.0f );
+}
+
+
+SpatialHashGrid::~SpatialHashGrid()
+{
+	clear();
+}
+
+
+void SpatialHashGrid::clear()
+{
+	for( size_t i=0; i<m_proxies.size(); ++i )
+	{
+		if( m_proxies[i].gameObject != 0 )
+		{
+			detachGameObject(m_proxies[i].gameObject);
+		}
+	}
+
+	m_proxies.clear();
+	m_freeProxy = -1;
+	for( size_t i=0; i<m_buckets.size(); ++i )
+	{
+		m_buckets[i].clear();
+	}
+	m_numEntries = 0;
+	m_largeProxies.clear();
+}
+
+
+int SpatialHashGrid::queryAabb(const vec2& topLeft, const vec2& bottomRight, GameObject** results, int maxResults) const
+{
+	int numResults = 0;
+	const int cellX0 = getCell(topLeft.x);
+	const int cellY0 = getCell(topLeft.y);
+	const int cellX1 = getCell(bottomRight.x);
+	const int cellY1 = getCell(bottomRight.y);
+
+	if( float(cellX1 - cellX0 + 1) * float(cellY1 - cellY0 + 1) > float(m_proxies.size()) )
+	{
+		// Query area covers more cells than there are objects. Testing each object is faster.
+		for( size_t i=0; i<m_proxies.size(); ++i )
+		{
+			const Proxy& proxy = m_proxies[i];
+			if( proxy.gameObject != 0 && overlaps(topLeft, bottomRight, proxy.topLeft, proxy.bottomRight) )
+			{
+				addResult(proxy.gameObject, results, maxResults, numResults);
+			}
+		}
+		return numResults;
+	}
+
+	for( int cellY = cellY0; cellY <= cellY1; ++cellY )
+	{
+		for( int cellX = cellX0; cellX <= cellX1; ++cellX )
+		{
+			const Bucket& bucket = m_buckets[getBucketIndex(cellX, cellY)];
+			for( size_t i=0; i<bucket.size(); ++i )
+			{
+				const Entry& entry = bucket[i];
+				if( entry.cellX != cellX || entry.cellY != cellY )
+				{
+					continue;
+				}
+
+				// Object in several cells is reported only in the first cell, which is covered by both query and object.
+				const Proxy& proxy = m_proxies[entry.proxyId];
+				const int firstCellX = proxy.cellX0 > cellX0 ? proxy.cellX0 : cellX0;
+				const int firstCellY = proxy.cellY0 > cellY0 ? proxy.cellY0 : cellY0;
+				if( cellX == firstCellX && cellY == firstCellY && overlaps(topLeft, bottomRight, proxy.topLeft, proxy.bottomRight) )
+				{
+					addResult(proxy.gameObject, results, maxResults, numResults);
+				}
+			}
+		}
+	}
+
+	for( size_t i=0; i<m_largeProxies.size(); ++i )
+	{
+		const Proxy& proxy = m_proxies[m_largeProxies[i]];
+		if( overlaps(topLeft, bottomRight, proxy.topLeft, proxy.bottomRight) )
+		{
+			addResult(proxy.gameObject, results, maxResults, numResults);
+		}
+	}
+
+	return numResults;
+}
+
+
+void SpatialHashGrid::findOverlappingPairs(PairCallback* callback) const
+{
+	assert( callback != 0 );
+
+	// Pairs sharing a cell. Pair sharing several cells is reported only in the first shared cell.
+	for( size_t b=0; b<m_buckets.size(); ++b )
+	{
+		const Bucket& bucket = m_buckets[b];
+		for( size_t i=0; i<bucket.size(); ++i )
+		{
+			const Entry& entryA = bucket[i];
+			const Proxy& a = m_proxies[entryA.proxyId];
+			for( size_t j=i+1; j<bucket.size(); ++j )
+			{
+				const Entry& entryB = bucket[j];
+				if( entryA.cellX != entryB.cellX || entryA.cellY != entryB.cellY )
+				{
+					continue;
+				}
+
+				const Proxy& b = m_proxies[entryB.proxyId];
+				const int firstCellX = a.cellX0 > b.cellX0 ? a.cellX0 : b.cellX0;
+				const int firstCellY = a.cellY0 > b.cellY0 ? a.cellY0 : b.cellY0;
+				if( entryA.cellX == firstCellX && entryA.cellY == firstCellY && overlaps(a.topLeft, a.bottomRight, b.topLeft, b.bottomRight) )
+				{
+					callback->onOverlap(a.gameObject, b.gameObject);
+				}
+			}
+		}
+	}
+
+	// Pairs with large objects.
+	for( size_t i=0; i<m_largeProxies.size(); ++i )
+	{
+		const int largeId = m_largeProxies[i];
+		const Proxy& a = m_proxies[largeId];
+		for( size_t j=0; j<m_proxies.size(); ++j )
+		{
+			const Proxy& b = m_proxies[j];
+			if( b.gameObject == 0 || (b.isLarge && int(j) <= largeId) )
+			{
+				continue;
+			}
+
+			if( overlaps(a.topLeft, a.bottomRight, b.topLeft, b.bottomRight) )
+			{
+				callback->onOverlap(a.gameObject, b.gameObject);
+			}
+		}
+	}
+}
+
+
+int SpatialHashGrid::createProxy(GameObject* gameObject, const vec2& topLeft, const vec2& bottomRight)
+{
+	int proxyId = m_freeProxy;
+	if( proxyId >= 0 )
+	{
+		m_freeProxy = m_proxies[proxyId].nextFree;
+	}
+	else
+	{
+		proxyId = (int)m_proxies.size();
+		m_proxies.push_back(Proxy());
+	}
+
+	Proxy& proxy = m_proxies[proxyId];
+	proxy.gameObject = gameObject;
+	proxy.topLeft = topLeft;
+	proxy.bottomRight = bottomRight;
+	proxy.nextFree = -1;
+	insertProxy(proxyId);
+	return proxyId;
+}
+
+
+void SpatialHashGrid::destroyProxy(int proxyId)
+{
+	assert( proxyId >= 0 && proxyId < (int)m_proxies.size() );
+	removeProxy(proxyId);
+	Proxy& proxy = m_proxies[proxyId];
+	proxy.gameObject = 0;
+	proxy.nextFree = m_freeProxy;
+	m_freeProxy = proxyId;
+}
+
+
+void SpatialHashGrid::moveProxy(int proxyId, const vec2& topLeft, const vec2& bottomRight)
+{
+	assert( proxyId >= 0 && proxyId < (int)m_proxies.size() );
+	Proxy& proxy = m_proxies[proxyId];
+	proxy.topLeft = topLeft;
+	proxy.bottomRight = bottomRight;
+
+	if( getCell(topLeft.x) == proxy.cellX0 && getCell(topLeft.y) == proxy.cellY0 
+		&& getCell(bottomRight.x) == proxy.cellX1 && getCell(bottomRight.y) == proxy.cellY1 )
+	{
+		// Still in same cells.
+		return;
+	}
+
+	removeProxy(proxyId);
+	insertProxy(proxyId);
+}
+
+
+int SpatialHashGrid::getCell(float coordinate) const
+{
+	float cell = floorf(coordinate * m_inverseCellSize);
+	if( cell < -MAX_CELL_COORDINATE ) cell = -MAX_CELL_COORDINATE;
+	if( cell > MAX_CELL_COORDINATE ) cell = MAX_CELL_COORDINATE;
+	return int(cell);
+}
+
+
+size_t SpatialHashGrid::getBucketIndex(int cellX, int cellY) const
+{
+	const unsigned hash = (unsigned(cellX) * 73856093u) ^ (unsigned(cellY) * 19349663u);
+	return hash & (m_buckets.size() - 1);
+}
+
+
+void SpatialHashGrid::insertProxy(int proxyId)
+{
+	Proxy& proxy = m_proxies[proxyId];
+	proxy.cellX0 = getCell(proxy.topLeft.x);
+	proxy.cellY0 = getCell(proxy.topLeft.y);
+	proxy.cellX1 = getCell(proxy.bottomRight.x);
+	proxy.cellY1 = getCell(proxy.bottomRight.y);
+
+	const float numCells = float(proxy.cellX1 - proxy.cellX0 + 1) * float(proxy.cellY1 - proxy.cellY0 + 1);
+	proxy.isLarge = numCells > float(MAX_CELLS_PER_PROXY);
+	if( proxy.isLarge )
+	{
+		m_largeProxies.push_back(proxyId);
+		return;
+	}
+
+	if( m_numEntries + size_t(numCells) > 2*m_buckets.size() )
+	{
+		rehash(2*m_buckets.size());
+	}
+
+	for( int cellY = proxy.cellY0; cellY <= proxy.cellY1; ++cellY )
+	{
+		for( int cellX = proxy.cellX0; cellX <= proxy.cellX1; ++cellX )
+		{
+			Entry entry;
+			entry.proxyId = proxyId;
+			entry.cellX = cellX;
+			entry.cellY = cellY;
+			m_buckets[getBucketIndex(cellX, cellY)].push_back(entry);
+			++m_numEntries;
+		}
+	}
+}
+
+
+void SpatialHashGrid::removeProxy(int proxyId)
+{
+	const Proxy& proxy = m_proxies[proxyId];
+	if( proxy.isLarge )
+	{
+		for( size_t i=0; i<m_largeProxies.size(); ++i )
+		{
+			if( m_largeProxies[i] == proxyId )
+			{
+				m_largeProxies[i] = m_largeProxies.back();
+				m_largeProxies.pop_back();
+				return;
+			}
+		}
+		assert(0); // Large proxy not found
+		return;
+	}
+
+	for( int cellY = proxy.cellY0; cellY <= proxy.cellY1; ++cellY )
+	{
+		for( int cellX = proxy.cellX0; cellX <= proxy.cellX1; ++cellX )
+		{
+			Bucket& bucket = m_buckets[getBucketIndex(cellX, cellY)];
+			for( size_t i=0; i<bucket.size(); ++i )
+			{
+				if( bucket[i].proxyId == proxyId && bucket[i].cellX == cellX && bucket[i].cellY == cellY )
+				{
+					bucket[i] = bucket.back();
+					bucket.pop_back();
+					--m_numEntries;
+					break;
+				}
+			}
+		}
+	}
+}
+
+
+void SpatialHashGrid::rehash(size_t numBuckets)
+{
+	std::vector<Bucket> oldBuckets(numBuckets);
+	oldBuckets.swap(m_buckets);
+	for( size_t b=0; b<oldBuckets.size(); ++b )
+	{
+		const Bucket& bucket = oldBuckets[b];
+		for( size_t i=0; i<bucket.size(); ++i )
+		{
+			m_buckets[getBucketIndex(bucket[i].cellX, bucket[i].cellY)].push_back(bucket[i]);
+		}
+	}
+}
+
+}
@@ -96,18 +96,36 @@ const vec2& Sprite::getScale() const
 
 
 void Sprite::getVertexData( std::vector<float>& verts, std::vector<float>& texCoords, std::vector<float>& colors ) const
+{
+	getVertexData(getQuad(), verts, texCoords, colors);
+}
+
+
+Sprite::Quad Sprite::getQuad() const
+{
+	Quad quad;
+	memcpy(quad.color, m_color, sizeof(m_color));
+	quad.scale = m_scale;
+	quad.clipStart = m_cropStart;
+	quad.clipSize = m_cropSize;
+	quad.depth = m_depth;
+	return quad;
+}
+
+
+void Sprite::getVertexData( const Quad& quad, std::vector<float>& verts, std::vector<float>& texCoords, std::vector<float>& colors )
 {
 	{
 		size_t startIndex = verts.size();
 		static const float S = 0.5f;
 		static const size_t DS = 3*6;
 		float v [DS] = {
-			-S*m_scale.x,		-S*m_scale.y,		m_depth,
-			 S*m_scale.x,		 S*m_scale.y,		m_depth,
-			-S*m_scale.x,		 S*m_scale.y,		m_depth,
-			-S*m_scale.x,		-S*m_scale.y,		m_depth,
-			 S*m_scale.x,		-S*m_scale.y,		m_depth,
-			 S*m_scale.x,		 S*m_scale.y,		m_depth
+			-S*quad.scale.x,		-S*quad.scale.y,		quad.depth,
+			 S*quad.scale.x,		 S*quad.scale.y,		quad.depth,
+			-S*quad.scale.x,		 S*quad.scale.y,		quad.depth,
+			-S*quad.scale.x,		-S*quad.scale.y,		quad.depth,
+			 S*quad.scale.x,		-S*quad.scale.y,		quad.depth,
+			 S*quad.scale.x,		 S*quad.scale.y,		quad.depth
 		};
 
 		verts.resize( verts.size()+DS );
@@ -118,12 +136,12 @@ void Sprite::getVertexData( std::vector<float>& verts, std::vector<float>& texCo
 		size_t startIndex = texCoords.size();
 		static const size_t DS = 2*6;
 		float v [DS] = {
-			m_cropStart.x,					(m_cropStart.y+m_cropSize.y),
-			m_cropStart.x+m_cropSize.x,		(m_cropStart.y),
-			m_cropStart.x,					(m_cropStart.y),
-			m_cropStart.x,					(m_cropStart.y+m_cropSize.y),
-			m_cropStart.x+m_cropSize.x,		(m_cropStart.y+m_cropSize.y),
-			m_cropStart.x+m_cropSize.x,		(m_cropStart.y),
+			quad.clipStart.x,					(quad.clipStart.y+quad.clipSize.y),
+			quad.clipStart.x+quad.clipSize.x,	(quad.clipStart.y),
+			quad.clipStart.x,					(quad.clipStart.y),
+			quad.clipStart.x,					(quad.clipStart.y+quad.clipSize.y),
+			quad.clipStart.x+quad.clipSize.x,	(quad.clipStart.y+quad.clipSize.y),
+			quad.clipStart.x+quad.clipSize.x,	(quad.clipStart.y),
 		};
 
 
@@ -135,7 +153,7 @@ void Sprite::getVertexData( std::vector<float>& verts, std::vector<float>& texCo
 	{
 		size_t startIndex = colors.size();
 		colors.resize( colors.size()+4 );
-		memcpy(&colors[startIndex], &m_color, sizeof(m_color) );
+		memcpy(&colors[startIndex], &quad.color, sizeof(quad.color) );
 	}
 }
 
@@ -27,6 +27,9 @@
 #include <Texture.h>
 #include <Sprite.h>
 #include <SpriteSheet.h>
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <Thread.h>
 
 namespace yam2d
 {
@@ -34,9 +37,9 @@ namespace yam2d
 // anonymous namespace for internal functions
 namespace
 {
-	int numTriangles = 0;
-	int numDrawCalls = 0;
-	int numSpritesBatched = 0;
+	AtomicInt numTriangles;
+	AtomicInt numDrawCalls;
+	AtomicInt numSpritesBatched;
 	
 	void swap(float& v1, float& v2)
 	{
@@ -45,45 +48,61 @@ namespace
 		v2 = temp;
 	}
 
+	int getCapacityInBytes(const std::vector<float>& v)
+	{
+		return int(v.capacity()*sizeof(float));
+	}
+
 }
 
 
 void SpriteBatch::resetStatsValues()
 {
-	numTriangles = 0;
-	numDrawCalls = 0;
-	numSpritesBatched = 0;
+	numTriangles.set(0);
+	numDrawCalls.set(0);
+	numSpritesBatched.set(0);
 }
 
 
 int SpriteBatch::getNumTriangles()
 {
-	return numTriangles;
+	return numTriangles.get();
 }
 
 
 int SpriteBatch::getNumDrawCalls()
 {
-	return numDrawCalls;
+	return numDrawCalls.get();
 }
 
 
 int SpriteBatch::getNumSpritesBatched()
 {
-	return numSpritesBatched;
+	return numSpritesBatched.get();
 }
 
 
 SpriteBatch::SpriteBatch()
-: m_positions()
+: m_numSprites(0)
+, m_accountedBytes(0)
+, m_positions()
 , m_textureCoords()
 , m_texture(0)
 {
+	setMemorySubsystem(MemoryStats::VERTEX_BUFFERS);
 }
 
 
 SpriteBatch::~SpriteBatch()
 {
+	MemoryStats::updateBytes(MemoryStats::VERTEX_BUFFERS, m_accountedBytes, 0);
+}
+
+
+void SpriteBatch::updateMemoryStats()
+{
+	int numBytes = getCapacityInBytes(m_positions) + getCapacityInBytes(m_textureCoords) + getCapacityInBytes(m_colors);
+	MemoryStats::updateBytes(MemoryStats::VERTEX_BUFFERS, m_accountedBytes, numBytes);
 }
 
 
@@ -93,113 +112,76 @@ void SpriteBatch::setTexture(Texture* texture)
 }
 
 
-void SpriteBatch::addSprite(Sprite* sprite, const vec2& position, float rotation, const vec2& scale, const vec2& offset )
+void SpriteBatch::transformVertices(std::vector<float>& positions, std::vector<float>& textureCoords, size_t startVertex, 
+	const vec2& position, float rotation, const vec2& scale, const vec2& offset )
 {
-	size_t start = m_positions.size();
-	size_t startTex = m_textureCoords.size();
-
-	sprite->getVertexData(m_positions,m_textureCoords,m_colors);
+	size_t start = startVertex*3;
 
 	// If negative scale (rotate triangles winding order)
 	if( scale.x*scale.y < 0.0f )
 	{
-		for(size_t i=start; i<m_positions.size(); i += 2*3*3 )
+		for(size_t i=start; i<positions.size(); i += 2*3*3 )
 		{
-			swap( m_positions[i+ 0], m_positions[i+ 3] );
-			swap( m_positions[i+ 1], m_positions[i+ 4] );
-			swap( m_positions[i+ 2], m_positions[i+ 5] );
+			swap( positions[i+ 0], positions[i+ 3] );
+			swap( positions[i+ 1], positions[i+ 4] );
+			swap( positions[i+ 2], positions[i+ 5] );
 
-			swap( m_positions[i+ 9], m_positions[i+12] );
-			swap( m_positions[i+10], m_positions[i+13] );
-			swap( m_positions[i+11], m_positions[i+14] );
+			swap( positions[i+ 9], positions[i+12] );
+			swap( positions[i+10], positions[i+13] );
+			swap( positions[i+11], positions[i+14] );
 		}
 
-		for(size_t i=startTex; i<m_textureCoords.size(); i += 2*3*2 )
+		for(size_t i=startVertex*2; i<textureCoords.size(); i += 2*3*2 )
 		{
-			swap( m_textureCoords[i+ 0], m_textureCoords[i+ 2] );
-			swap( m_textureCoords[i+ 1], m_textureCoords[i+ 3] );
+			swap( textureCoords[i+ 0], textureCoords[i+ 2] );
+			swap( textureCoords[i+ 1], textureCoords[i+ 3] );
 
-			swap( m_textureCoords[i+ 6], m_textureCoords[i+ 8] );
-			swap( m_textureCoords[i+ 7], m_textureCoords[i+ 9] );
+			swap( textureCoords[i+ 6], textureCoords[i+ 8] );
+			swap( textureCoords[i+ 7], textureCoords[i+ 9] );
 		}
 	}
 
-	for( ; start<m_positions.size(); start += 3 )
+	float sinAngle = sinf(rotation);
+	float cosAngle = cosf(rotation);
+	for( ; start<positions.size(); start += 3 )
 	{
-		float x0 = offset.x + (m_positions[start + 0] * scale.x);
-		float y0 = offset.y + (m_positions[start + 1] * scale.y);
-		
-		float sinAngle = sinf(rotation);
-		float cosAngle = cosf(rotation);
+		float x0 = offset.x + (positions[start + 0] * scale.x);
+		float y0 = offset.y + (positions[start + 1] * scale.y);
 
 		// Rotation
 		float x = x0*cosAngle - y0*sinAngle;
 		float y = x0*sinAngle + y0*cosAngle;
 
 		// Translation
-		m_positions[start+0] = position.x + x;
-		m_positions[start+1] = position.y + y;
-		m_positions[start+2] = m_positions[start+2];
+		positions[start+0] = position.x + x;
+		positions[start+1] = position.y + y;
 	}
+}
+
 
-	++numSpritesBatched;
+void SpriteBatch::addSprite(Sprite* sprite, const vec2& position, float rotation, const vec2& scale, const vec2& offset )
+{
+	size_t startVertex = m_positions.size()/3;
+	sprite->getVertexData(m_positions,m_textureCoords,m_colors);
+	transformVertices(m_positions, m_textureCoords, startVertex, position, rotation, scale, offset);
+	++m_numSprites;
+	numSpritesBatched.increment();
 }
 
 
 void SpriteBatch::addText(Text* text, const vec2& position, float rotation, const vec2& scale, const vec2& offset )
 {
-	size_t start = m_positions.size();
-	size_t startTex = m_textureCoords.size();
-
+	size_t startVertex = m_positions.size()/3;
 	text->getVertexData(m_positions,m_textureCoords,m_colors);
-
-	// If negative scale (rotate triangles winding order)
-	if( scale.x*scale.y < 0.0f )
-	{
-		for(size_t i=start; i<m_positions.size(); i += 2*3*3 )
-		{
-			swap( m_positions[i+ 0], m_positions[i+ 3] );
-			swap( m_positions[i+ 1], m_positions[i+ 4] );
-			swap( m_positions[i+ 2], m_positions[i+ 5] );
-
-			swap( m_positions[i+ 9], m_positions[i+12] );
-			swap( m_positions[i+10], m_positions[i+13] );
-			swap( m_positions[i+11], m_positions[i+14] );
-		}
-
-		for(size_t i=startTex; i<m_textureCoords.size(); i += 2*3*2 )
-		{
-			swap( m_textureCoords[i+ 0], m_textureCoords[i+ 2] );
-			swap( m_textureCoords[i+ 1], m_textureCoords[i+ 3] );
-
-			swap( m_textureCoords[i+ 6], m_textureCoords[i+ 8] );
-			swap( m_textureCoords[i+ 7], m_textureCoords[i+ 9] );
-		}
-	}
-
-	for( ; start<m_positions.size(); start += 3 )
-	{
-		float x0 = offset.x+m_positions[start+0]*scale.x;
-		float y0 = offset.y+m_positions[start+1]*scale.y;
-		
-		float sinAngle = sinf(rotation);
-		float cosAngle = cosf(rotation);
-
-		// Rotation
-		float x = x0*cosAngle - y0*sinAngle;
-		float y = x0*sinAngle + y0*cosAngle;
-
-		// Translation
-		m_positions[start+0] = position.x + x;
-		m_positions[start+1] = position.y + y;
-		m_positions[start+2] = m_positions[start+2];
-	}
-
+	transformVertices(m_positions, m_textureCoords, startVertex, position, rotation, scale, offset);
+	++m_numSprites;
+	numSpritesBatched.increment();
 }
 
 
 void SpriteBatch::clear()
 {
+	m_numSprites = 0;
 	m_positions.clear();
 	m_textureCoords.clear();
 	m_colors.clear();
@@ -208,34 +190,78 @@ void SpriteBatch::clear()
 
 void SpriteBatch::render(float aspectRatio)
 {
+	YAM2D_PROFILE_ZONE("SpriteBatch::render");
+	updateMemoryStats();
 	if( m_positions.size() == 0 )
 		return;
 
+	draw(m_texture, &m_positions[0], &m_textureCoords[0], &m_colors[0], int(m_positions.size()/3), aspectRatio);
+}
+
+
+void SpriteBatch::draw(Texture* texture, const float* positions, const float* textureCoords, const float* colors, 
+	int numVertices, float aspectRatio)
+{
+	if( numVertices == 0 )
+		return;
+
 	glEnableClientState(GL_VERTEX_ARRAY);
-	glVertexPointer(3, GL_FLOAT, 0, &m_positions[0]);
+	glVertexPointer(3, GL_FLOAT, 0, positions);
 
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-	glTexCoordPointer(2, GL_FLOAT, 0, &m_textureCoords[0]);
+	glTexCoordPointer(2, GL_FLOAT, 0, textureCoords);
 
 	glEnableClientState(GL_COLOR_ARRAY);
-	glColorPointer(4, GL_FLOAT, 0, &m_colors[0]);
+	glColorPointer(4, GL_FLOAT, 0, colors);
 
-	if( m_texture )
+	if( texture )
 	{
 		glEnable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, m_texture->getNativeId());
+		glBindTexture(GL_TEXTURE_2D, texture->getNativeId());
+	}
+
+	bool hasAlphaTexture = texture && texture->getAlphaNativeId() != 0;
+	if( hasAlphaTexture )
+	{
+		// ETC1 texture has alpha in separate texture. Take rgb from previous stage and 
+		// modulate alpha of the previous stage with alpha texture.
+		glActiveTexture(GL_TEXTURE1);
+		glEnable(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, texture->getAlphaNativeId());
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+		glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_REPLACE);
+		glTexEnvi(GL_TEXTURE_ENV, GL_SRC0_RGB, GL_PREVIOUS);
+		glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_RGB, GL_SRC_COLOR);
+		glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_MODULATE);
+		glTexEnvi(GL_TEXTURE_ENV, GL_SRC0_ALPHA, GL_PREVIOUS);
+		glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_ALPHA, GL_SRC_ALPHA);
+		glTexEnvi(GL_TEXTURE_ENV, GL_SRC1_ALPHA, GL_TEXTURE);
+		glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_ALPHA, GL_SRC_ALPHA);
+		glClientActiveTexture(GL_TEXTURE1);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, 0, textureCoords);
 	}
 
 	glMatrixMode(GL_MODELVIEW);
 	glPushMatrix();
 	glScalef(1,aspectRatio,1);
-	numTriangles += m_positions.size()/3;
-	++numDrawCalls;
-	glDrawArrays(GL_TRIANGLES, 0, m_positions.size()/3);
+	numTriangles.add(numVertices);
+	numDrawCalls.increment();
+	RenderStats::addDrawCall(texture, numVertices);
+	glDrawArrays(GL_TRIANGLES, 0, numVertices);
 
 	glPopMatrix();
 
-	if( m_texture )
+	if( hasAlphaTexture )
+	{
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		glClientActiveTexture(GL_TEXTURE0);
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		glDisable(GL_TEXTURE_2D);
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	if( texture )
 	{
 		glDisable(GL_TEXTURE_2D);
 	}
@@ -295,6 +321,15 @@ void SpriteBatchGroup::render(float aspectRatio)
 }
 
 
+void SpriteBatchGroup::addBatchedToRenderStats() const
+{
+	for( std::map<Texture*, Ref<SpriteBatch> >::const_iterator it = m_spriteBatches.begin(); it != m_spriteBatches.end(); ++it )
+	{
+		RenderStats::addBatched(it->first, it->second->getNumSprites());
+	}
+}
+
+
 SpriteBatch* SpriteBatchGroup::getBatch(Texture* texture)
 {
 	SpriteBatch* batch = m_spriteBatches[texture];
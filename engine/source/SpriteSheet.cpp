@@ -203,10 +203,8 @@ namespace
 		first.clipSize.x = w;
 		first.clipSize.y = h;
 		res.push_back(first);
-		bool hasChanged = true;
 		for( std::list<Sprite::PixelClip>::iterator it = res.begin(); it != res.end(); )
 		{
-			hasChanged = false;
 			// Trim clip area
 			*it = trimClipArea(*it,texture,isPixel);
 			Sprite::PixelClip clip = *it;
@@ -215,8 +213,6 @@ namespace
 			int nextEmptyLineY = findNextEmptyLineY(clip,texture,isPixel);
 			if( nextEmptyLineY <= (clip.topLeft.y+clip.clipSize.y) )
 			{ 
-				hasChanged = true;
-
 				// Divide horizontally (cut according to y-axis)
 				Sprite::PixelClip top = clip;
 				top.clipSize.y = nextEmptyLineY-top.topLeft.y;
@@ -237,7 +233,6 @@ namespace
 			int nextEmptyLineX = findNextEmptyLineX(clip,texture,isPixel);
 			if( nextEmptyLineX <= (clip.topLeft.x+clip.clipSize.x) )
 			{ 
-				hasChanged = true;
 			
 				// Divide vertically (cut according to x-axis)
 				Sprite::PixelClip left = clip;
@@ -261,7 +256,6 @@ namespace
 
 		for( std::list<Sprite::PixelClip>::iterator it = res.begin(); it != res.end(); ++it )
 		{
-			Sprite::PixelClip clip = *it;
 			ret.push_back(*it);
 		}
 
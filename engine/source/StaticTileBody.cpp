@@ -0,0 +1,121 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "StaticTileBody.h"
+#include <vector>
+
+namespace yam2d
+{
+
+StaticTileBody::StaticTileBody(b2World* world, TileGrid* tileGrid, ShapeType shapeType, float friction, float restitution)
+: Object()
+, m_world(world)
+, m_tileGrid(tileGrid)
+, m_body(0)
+, m_shapeType(shapeType)
+, m_friction(friction)
+, m_restitution(restitution)
+, m_numFixtures(0)
+, m_dirty(false)
+{
+	b2BodyDef bodyDef;
+	bodyDef.type = b2_staticBody;
+	bodyDef.userData = this;
+	m_body = m_world->CreateBody(&bodyDef);
+	rebuild();
+	m_tileGrid->addChangeListener(this);
+}
+
+
+StaticTileBody::~StaticTileBody()
+{
+	m_tileGrid->removeChangeListener(this);
+	m_world->DestroyBody(m_body);
+}
+
+
+void StaticTileBody::update()
+{
+	if( m_dirty )
+	{
+		rebuild();
+	}
+}
+
+
+void StaticTileBody::rebuild()
+{
+	while( m_body->GetFixtureList() != 0 )
+	{
+		m_body->DestroyFixture(m_body->GetFixtureList());
+	}
+	m_numFixtures = 0;
+	m_dirty = false;
+
+	b2FixtureDef fixtureDef;
+	fixtureDef.density = 0.0f;
+	fixtureDef.friction = m_friction;
+	fixtureDef.restitution = m_restitution;
+	const vec2& origin = m_tileGrid->getOrigin();
+	if( m_shapeType == SHAPE_RECTANGLES )
+	{
+		std::vector<TileGrid::CellRect> rectangles;
+		m_tileGrid->getSolidRectangles(rectangles);
+		for( size_t i=0; i<rectangles.size(); ++i )
+		{
+			const TileGrid::CellRect& r = rectangles[i];
+			const vec2 halfSize(0.5f*float(r.width), 0.5f*float(r.height));
+			b2PolygonShape shape;
+			shape.SetAsBox(halfSize.x, halfSize.y, origin + vec2(float(r.x), float(r.y)) + halfSize, 0.0f);
+			fixtureDef.shape = &shape;
+			m_body->CreateFixture(&fixtureDef);
+			++m_numFixtures;
+		}
+	}
+	else
+	{
+		std::vector< std::vector<vec2> > outlines;
+		m_tileGrid->getSolidOutlines(outlines);
+		std::vector<b2Vec2> vertices;
+		for( size_t i=0; i<outlines.size(); ++i )
+		{
+			vertices.assign(outlines[i].begin(), outlines[i].end());
+			b2ChainShape shape;
+			shape.CreateLoop(&vertices[0], (int32)vertices.size());
+			fixtureDef.shape = &shape;
+			m_body->CreateFixture(&fixtureDef);
+			++m_numFixtures;
+		}
+	}
+}
+
+
+void StaticTileBody::onCellChanged(int x, int y, bool solid)
+{
+	(void)x;
+	(void)y;
+	(void)solid;
+	m_dirty = true;
+}
+
+
+}
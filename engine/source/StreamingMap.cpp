@@ -0,0 +1,889 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "StreamingMap.h"
+#include <Thread.h>
+#include <Layer.h>
+#include <GameObject.h>
+#include <Camera.h>
+#include <TileComponent.h>
+#include <Tileset.h>
+#include <Logger.h>
+#include <es_util.h>
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+namespace yam2d
+{
+
+// anonymous namespace for internal functions
+namespace
+{
+	// Tile flip flags, same as in TMX format.
+	const uint32_t FLIPPED_HORIZONTALLY_FLAG = 0x80000000;
+	const uint32_t FLIPPED_VERTICALLY_FLAG = 0x40000000;
+	const uint32_t FLIPPED_DIAGONALLY_FLAG = 0x20000000;
+
+	void appendInt(std::vector<uint8_t>& data, int32_t value)
+	{
+		const uint8_t* p = (const uint8_t*)&value;
+		data.insert(data.end(), p, p+sizeof(value));
+	}
+
+	int32_t readInt(const std::vector<uint8_t>& data, size_t& offset)
+	{
+		int32_t value = 0;
+		assert( offset+sizeof(value) <= data.size() );
+		memcpy(&value, &data[offset], sizeof(value));
+		offset += sizeof(value);
+		return value;
+	}
+
+	int floorDiv(float v, int d)
+	{
+		int i = int(v);
+		if( float(i) > v )
+			--i;
+		return i >= 0 ? i / d : -((-i + d - 1) / d);
+	}
+}
+
+
+/**
+ * Background thread, which reads and decodes region records for StreamingTmxMap. Requests are served 
+ * in priority order (closest region first).
+ */
+class RegionLoader : public Thread
+{
+public:
+	struct Request
+	{
+		int regionIndex;
+		int priority;
+		const std::vector<uint8_t>* tileData;	// Used, if region is kept in memory
+		const std::vector<uint8_t>* objectData;
+		std::string tileFileName;				// Used, if region is kept on disk
+		std::string objectFileName;
+	};
+
+	struct Result
+	{
+		int regionIndex;
+		std::vector<StreamingTmxMap::TileRecord> tiles;
+		std::vector<StreamingTmxMap::ObjectRecord> objects;
+	};
+
+	RegionLoader()
+		: Thread()
+		, m_mutex()
+		, m_requestAvailable()
+		, m_idle()
+		, m_requests()
+		, m_results()
+		, m_busy(false)
+		, m_quit(false)
+	{
+	}
+
+	virtual ~RegionLoader()
+	{
+		stop();
+	}
+
+	void addRequest(const Request& request)
+	{
+		ScopedLock lock(m_mutex);
+		m_requests.push_back(request);
+		m_requestAvailable.signal();
+	}
+
+	/** Moves all completed results to given vector. */
+	void takeResults(std::vector<Result*>& results)
+	{
+		ScopedLock lock(m_mutex);
+		results.insert(results.end(), m_results.begin(), m_results.end());
+		m_results.clear();
+	}
+
+	int getNumRequests()
+	{
+		ScopedLock lock(m_mutex);
+		return int(m_requests.size()) + (m_busy ? 1 : 0);
+	}
+
+	void waitUntilIdle()
+	{
+		ScopedLock lock(m_mutex);
+		while( m_requests.size() > 0 || m_busy )
+		{
+			m_idle.wait(m_mutex);
+		}
+	}
+
+	void stop()
+	{
+		{
+			ScopedLock lock(m_mutex);
+			m_quit = true;
+			m_requestAvailable.broadcast();
+		}
+		join();
+
+		for( size_t i=0; i<m_results.size(); ++i )
+		{
+			delete m_results[i];
+		}
+		m_results.clear();
+	}
+
+protected:
+	virtual void run()
+	{
+		while( true )
+		{
+			Request request;
+			{
+				ScopedLock lock(m_mutex);
+				while( m_requests.size() == 0 && !m_quit )
+				{
+					m_requestAvailable.wait(m_mutex);
+				}
+
+				if( m_quit )
+				{
+					return;
+				}
+
+				// Take the request with the highest priority (smallest distance to camera).
+				size_t best = 0;
+				for( size_t i=1; i<m_requests.size(); ++i )
+				{
+					if( m_requests[i].priority < m_requests[best].priority )
+						best = i;
+				}
+				request = m_requests[best];
+				m_requests.erase(m_requests.begin()+best);
+				m_busy = true;
+			}
+
+			Result* result = new Result();
+			result->regionIndex = request.regionIndex;
+			if( request.tileData != 0 )
+			{
+				StreamingTmxMap::decodeRegion(*request.tileData, *request.objectData, result->tiles, result->objects);
+			}
+			else
+			{
+				// File, which can not be read, is left empty, so its region is loaded without its tiles or objects.
+				std::vector<uint8_t> tileData;
+				std::vector<uint8_t> objectData;
+				StreamingTmxMap::readFile(request.tileFileName, tileData);
+				StreamingTmxMap::readFile(request.objectFileName, objectData);
+				StreamingTmxMap::decodeRegion(tileData, objectData, result->tiles, result->objects);
+			}
+
+			{
+				ScopedLock lock(m_mutex);
+				m_results.push_back(result);
+				m_busy = false;
+				m_idle.broadcast();
+			}
+		}
+	}
+
+private:
+	Mutex					m_mutex;
+	ConditionVariable		m_requestAvailable;
+	ConditionVariable		m_idle;
+	std::vector<Request>	m_requests;
+	std::vector<Result*>	m_results;
+	bool					m_busy;
+	bool					m_quit;
+};
+
+
+StreamingTmxMap::Region::Region()
+	: state(REGION_UNLOADED)
+	, cancelled(false)
+	, inCache(false)
+	, tileData()
+	, objectData()
+	, strayObjects()
+	, pendingTiles()
+	, pendingObjects()
+	, nextPendingTile(0)
+	, nextPendingObject(0)
+{
+}
+
+
+StreamingTmxMap::StreamingTmxMap(int regionSize)
+	: TmxMap()
+	, m_regionSize(regionSize)
+	, m_numRegionsX(0)
+	, m_numRegionsY(0)
+	, m_loadRadius(1)
+	, m_evictRadius(2)
+	, m_entityBudget(256)
+	, m_cameraRegion(-1)
+	, m_cacheDirectory("")
+	, m_componentFactory(0)
+	, m_regions()
+	, m_activeRegions()
+	, m_instantiateQueue()
+	, m_isTileLayer(NUM_LAYERS, false)
+	, m_loader(new RegionLoader())
+{
+	assert( regionSize > 0 );
+	m_loader->start();
+}
+
+
+StreamingTmxMap::~StreamingTmxMap()
+{
+	delete m_loader;
+}
+
+
+bool StreamingTmxMap::loadMapFile(const std::string& mapFileName, ComponentFactory* componentFactory)
+{
+	assert( m_regions.size() == 0 ); // Map can be loaded only once.
+	m_componentFactory = componentFactory;
+
+	if( !TmxMap::loadMapFile(mapFileName, componentFactory) )
+	{
+		return false;
+	}
+
+	if( m_regions.size() == 0 )
+	{
+		// Map without tiles and objects.
+		return true;
+	}
+
+	// Tile layers have reserved space for all tiles. Release it.
+	for( LayerMap::iterator it = getLayers().begin(); it != getLayers().end(); ++it )
+	{
+		if( it->second != 0 )
+		{
+			Layer::GameObjectList(it->second->getGameObjects()).swap(it->second->getGameObjects());
+		}
+	}
+
+	// Move region records to disk, if cache directory is set. Records of regions, which can not be written, are 
+	// kept in memory.
+	size_t numBytes = 0;
+	for( size_t i=0; i<m_regions.size(); ++i )
+	{
+		Region& region = m_regions[i];
+		numBytes += region.tileData.size() + region.objectData.size();
+		if( m_cacheDirectory.length() > 0
+			&& writeFile(getRegionFileName(int(i), "tiles"), region.tileData)
+			&& writeFile(getRegionFileName(int(i), "objects"), region.objectData) )
+		{
+			region.inCache = true;
+			std::vector<uint8_t>().swap(region.tileData);
+			std::vector<uint8_t>().swap(region.objectData);
+		}
+	}
+
+	YAM2D_LOG_DEBUG(Logger::CATEGORY_ASSETS, "[%s] Map split to %dx%d regions of %d tiles. Region records: %d bytes%s", __FUNCTION__,
+		m_numRegionsX, m_numRegionsY, m_regionSize, int(numBytes), m_cacheDirectory.length() > 0 ? " (on disk)" : "");
+	return true;
+}
+
+
+void StreamingTmxMap::update( float deltaTime )
+{
+	updateRegions(false);
+	TmxMap::update(deltaTime);
+}
+
+
+void StreamingTmxMap::setRegionRadius(int loadRadius, int evictRadius)
+{
+	assert( loadRadius >= 0 );
+	assert( evictRadius > loadRadius ); // Evict radius must be bigger than load radius.
+	m_loadRadius = loadRadius;
+	m_evictRadius = evictRadius;
+}
+
+
+void StreamingTmxMap::preloadRegions()
+{
+	updateRegions(true);
+}
+
+
+int StreamingTmxMap::getNumResidentRegions() const
+{
+	int res = 0;
+	for( size_t i=0; i<m_activeRegions.size(); ++i )
+	{
+		RegionState state = m_regions[m_activeRegions[i]].state;
+		if( state == REGION_RESIDENT || state == REGION_INSTANTIATING )
+			++res;
+	}
+	return res;
+}
+
+
+int StreamingTmxMap::getNumLoadingRegions() const
+{
+	return m_loader->getNumRequests();
+}
+
+
+int StreamingTmxMap::getNumPendingEntities() const
+{
+	int res = 0;
+	for( size_t i=0; i<m_instantiateQueue.size(); ++i )
+	{
+		const Region& region = m_regions[m_instantiateQueue[i]];
+		res += int(region.pendingTiles.size() - region.nextPendingTile);
+		res += int(region.pendingObjects.size() - region.nextPendingObject);
+	}
+	return res;
+}
+
+
+void StreamingTmxMap::onTileLoaded(ComponentFactory*, int layerIndex, int x, int y, int tilesetIndex, unsigned id, bool flippedHorizontally, bool flippedVertically, bool flippedDiagonally)
+{
+	if( m_regions.size() == 0 )
+	{
+		m_numRegionsX = (int(getWidth()) + m_regionSize - 1) / m_regionSize;
+		m_numRegionsY = (int(getHeight()) + m_regionSize - 1) / m_regionSize;
+		m_regions.resize(m_numRegionsX*m_numRegionsY);
+	}
+
+	m_isTileLayer[layerIndex] = true;
+
+	TileRecord record;
+	record.x = x;
+	record.y = y;
+	record.layerIndex = uint16_t(layerIndex);
+	record.tilesetIndex = uint16_t(tilesetIndex);
+	record.idAndFlags = id & ~(FLIPPED_HORIZONTALLY_FLAG | FLIPPED_VERTICALLY_FLAG | FLIPPED_DIAGONALLY_FLAG);
+	if( flippedHorizontally )
+		record.idAndFlags |= FLIPPED_HORIZONTALLY_FLAG;
+	if( flippedVertically )
+		record.idAndFlags |= FLIPPED_VERTICALLY_FLAG;
+	if( flippedDiagonally )
+		record.idAndFlags |= FLIPPED_DIAGONALLY_FLAG;
+
+	int regionIndex = (y / m_regionSize)*m_numRegionsX + (x / m_regionSize);
+	const uint8_t* p = (const uint8_t*)&record;
+	std::vector<uint8_t>& data = m_regions[regionIndex].tileData;
+	data.insert(data.end(), p, p+sizeof(record));
+}
+
+
+void StreamingTmxMap::onObjectLoaded(ComponentFactory*, int layerIndex, const PropertySet& properties, int tilesetIndex)
+{
+	if( m_regions.size() == 0 )
+	{
+		m_numRegionsX = (int(getWidth()) + m_regionSize - 1) / m_regionSize;
+		m_numRegionsY = (int(getHeight()) + m_regionSize - 1) / m_regionSize;
+		m_regions.resize(m_numRegionsX*m_numRegionsY);
+	}
+
+	ObjectRecord record;
+	record.layerIndex = layerIndex;
+	record.tilesetIndex = tilesetIndex;
+	record.json = properties.toString();
+
+	vec2 position(properties.getOrDefault("positionX", 0.0f), properties.getOrDefault("positionY", 0.0f));
+	appendObjectRecord(m_regions[getRegionIndex(position)].objectData, record);
+}
+
+
+void StreamingTmxMap::updateRegions(bool blocking)
+{
+	if( m_regions.size() == 0 )
+		return;
+
+	if( blocking )
+	{
+		m_loader->waitUntilIdle();
+	}
+
+	const vec2& cameraPosition = getCamera()->getPosition();
+	int cameraRegion = getRegionIndex(cameraPosition);
+	int cameraRegionX = cameraRegion % m_numRegionsX;
+	int cameraRegionY = cameraRegion / m_numRegionsX;
+
+	// Find regions to load and evict.
+	std::vector<int> regionsToEvict;
+	for( size_t i=0; i<m_activeRegions.size(); ++i )
+	{
+		int regionIndex = m_activeRegions[i];
+		Region& region = m_regions[regionIndex];
+		if( getRegionDistance(regionIndex, cameraRegionX, cameraRegionY) <= m_evictRadius )
+			continue;
+
+		if( region.state == REGION_LOADING )
+		{
+			// Result is dropped, when it arrives.
+			region.cancelled = true;
+		}
+		else
+		{
+			regionsToEvict.push_back(regionIndex);
+		}
+	}
+
+	for( int y = cameraRegionY-m_loadRadius; y <= cameraRegionY+m_loadRadius; ++y )
+	{
+		for( int x = cameraRegionX-m_loadRadius; x <= cameraRegionX+m_loadRadius; ++x )
+		{
+			if( x < 0 || y < 0 || x >= m_numRegionsX || y >= m_numRegionsY )
+				continue;
+
+			int regionIndex = y*m_numRegionsX + x;
+			Region& region = m_regions[regionIndex];
+			if( region.state == REGION_UNLOADED )
+			{
+				requestRegion(regionIndex, getRegionDistance(regionIndex, cameraRegionX, cameraRegionY));
+			}
+			else if( region.state == REGION_LOADING )
+			{
+				region.cancelled = false;
+			}
+		}
+	}
+
+	// Evict far away regions and objects, which has moved to non resident regions.
+	bool modified = false;
+	if( regionsToEvict.size() > 0 || cameraRegion != m_cameraRegion )
+	{
+		evictRegions(regionsToEvict);
+		m_cameraRegion = cameraRegion;
+		modified = true;
+	}
+
+	if( blocking )
+	{
+		m_loader->waitUntilIdle();
+	}
+
+	// Take loaded regions to instantiation queue.
+	std::vector<RegionLoader::Result*> results;
+	m_loader->takeResults(results);
+	for( size_t i=0; i<results.size(); ++i )
+	{
+		RegionLoader::Result* result = results[i];
+		Region& region = m_regions[result->regionIndex];
+		assert( region.state == REGION_LOADING );
+		if( region.cancelled )
+		{
+			region.cancelled = false;
+			setRegionState(result->regionIndex, REGION_UNLOADED);
+		}
+		else
+		{
+			region.pendingTiles.swap(result->tiles);
+			region.pendingObjects.swap(result->objects);
+			region.pendingObjects.insert(region.pendingObjects.end(), region.strayObjects.begin(), region.strayObjects.end());
+			std::vector<ObjectRecord>().swap(region.strayObjects);
+			region.nextPendingTile = 0;
+			region.nextPendingObject = 0;
+			setRegionState(result->regionIndex, REGION_INSTANTIATING);
+			m_instantiateQueue.push_back(result->regionIndex);
+		}
+		delete result;
+	}
+
+	// Instantiate closest regions first.
+	if( m_instantiateQueue.size() > 0 )
+	{
+		for( size_t i=1; i<m_instantiateQueue.size(); ++i )
+		{
+			int regionIndex = m_instantiateQueue[i];
+			int distance = getRegionDistance(regionIndex, cameraRegionX, cameraRegionY);
+			size_t j = i;
+			while( j > 0 && getRegionDistance(m_instantiateQueue[j-1], cameraRegionX, cameraRegionY) > distance )
+			{
+				m_instantiateQueue[j] = m_instantiateQueue[j-1];
+				--j;
+			}
+			m_instantiateQueue[j] = regionIndex;
+		}
+
+		instantiatePending(blocking ? 0x7fffffff : m_entityBudget);
+		modified = true;
+	}
+
+	if( modified )
+	{
+		invalidateStaticBatches();
+	}
+}
+
+
+void StreamingTmxMap::requestRegion(int regionIndex, int distance)
+{
+	Region& region = m_regions[regionIndex];
+	assert( region.state == REGION_UNLOADED );
+
+	RegionLoader::Request request;
+	request.regionIndex = regionIndex;
+	request.priority = distance;
+	if( region.inCache )
+	{
+		request.tileData = 0;
+		request.objectData = 0;
+		request.tileFileName = getRegionFileName(regionIndex, "tiles");
+		request.objectFileName = getRegionFileName(regionIndex, "objects");
+	}
+	else
+	{
+		// Region data is not modified while region is loading, so loader can read it directly.
+		request.tileData = &region.tileData;
+		request.objectData = &region.objectData;
+	}
+
+	region.cancelled = false;
+	setRegionState(regionIndex, REGION_LOADING);
+	m_loader->addRequest(request);
+}
+
+
+void StreamingTmxMap::evictRegions(const std::vector<int>& regionsToEvict)
+{
+	std::vector<bool> evict(m_regions.size(), false);
+	std::vector< std::vector<uint8_t> > objectData(regionsToEvict.size());
+	std::vector<int> evictIndices(m_regions.size(), -1);
+	for( size_t i=0; i<regionsToEvict.size(); ++i )
+	{
+		int regionIndex = regionsToEvict[i];
+		const Region& region = m_regions[regionIndex];
+		evict[regionIndex] = true;
+		evictIndices[regionIndex] = int(i);
+
+		// Objects, which were not yet instantiated, are written back as is. Tiles are always restored from original records.
+		for( size_t j=region.nextPendingObject; j<region.pendingObjects.size(); ++j )
+		{
+			appendObjectRecord(objectData[i], region.pendingObjects[j]);
+		}
+	}
+
+	// Find game objects of evicted regions and game objects, which has moved outside of resident regions. Objects 
+	// are removed only after records of their regions have been written.
+	std::vector<EvictedObject> evictedObjects;
+	for( int layerIndex=MAPLAYER0; layerIndex<=MAPLAYER29; ++layerIndex )
+	{
+		LayerMap::iterator it = getLayers().find(layerIndex);
+		if( it == getLayers().end() || it->second == 0 )
+			continue;
+
+		Layer* layer = it->second;
+		Layer::GameObjectList& gameObjects = layer->getGameObjects();
+		for( size_t i=0; i<gameObjects.size(); ++i )
+		{
+			GameObject* gameObject = gameObjects[i];
+			int regionIndex = getRegionIndex(gameObject->getPosition());
+			RegionState state = m_regions[regionIndex].state;
+			bool isResident = !evict[regionIndex] && (state == REGION_RESIDENT || state == REGION_INSTANTIATING);
+			if( isResident )
+				continue;
+
+			EvictedObject evicted;
+			evicted.layer = layer;
+			evicted.gameObject = gameObject;
+			evicted.regionIndex = regionIndex;
+			evicted.inEvictedRegion = evict[regionIndex];
+			evicted.isStray = false;
+			if( m_isTileLayer[layerIndex] )
+			{
+				evictedObjects.push_back(evicted);
+				continue;
+			}
+
+			PropertySet properties = gameObject->Component::getProperties();
+			if( properties.getOrDefault<bool>("persistent", false) )
+				continue;
+
+			// Serialize current state of the object.
+			properties["positionX"] = gameObject->getPosition().x;
+			properties["positionY"] = gameObject->getPosition().y;
+			properties["rotation"] = gameObject->getRotation();
+
+			ObjectRecord record;
+			record.layerIndex = layerIndex;
+			record.tilesetIndex = -1;
+			record.json = properties.toString();
+
+			TileComponent* tileComponent = gameObject->getComponent<TileComponent>();
+			if( tileComponent != 0 )
+			{
+				for( int t=0; t<getNumTilesets(); ++t )
+				{
+					if( getTileset(t) == tileComponent->getTileset() )
+						record.tilesetIndex = t;
+				}
+			}
+
+			if( evict[regionIndex] )
+			{
+				appendObjectRecord(objectData[evictIndices[regionIndex]], record);
+			}
+			else
+			{
+				evicted.isStray = true;
+				evicted.record = record;
+			}
+			evictedObjects.push_back(evicted);
+		}
+	}
+
+	// Region, whose records can not be written, stays resident with its game objects and is tried again later.
+	for( size_t i=0; i<regionsToEvict.size(); ++i )
+	{
+		int regionIndex = regionsToEvict[i];
+		Region& region = m_regions[regionIndex];
+		if( region.inCache )
+		{
+			if( !writeFile(getRegionFileName(regionIndex, "objects"), objectData[i]) )
+			{
+				evict[regionIndex] = false;
+				continue;
+			}
+			std::vector<uint8_t>().swap(region.objectData);
+		}
+		else
+		{
+			region.objectData.swap(objectData[i]);
+		}
+
+		std::vector<TileRecord>().swap(region.pendingTiles);
+		std::vector<ObjectRecord>().swap(region.pendingObjects);
+		region.nextPendingTile = 0;
+		region.nextPendingObject = 0;
+		m_instantiateQueue.erase(std::remove(m_instantiateQueue.begin(), m_instantiateQueue.end(), regionIndex), m_instantiateQueue.end());
+		setRegionState(regionIndex, REGION_UNLOADED);
+	}
+
+	// Evicted objects are grouped by layer, so each layer removes its objects at once.
+	std::vector<GameObject*> objectsToRemove;
+	for( size_t i=0; i<evictedObjects.size(); )
+	{
+		Layer* layer = evictedObjects[i].layer;
+		objectsToRemove.clear();
+		for( ; i<evictedObjects.size() && evictedObjects[i].layer == layer; ++i )
+		{
+			const EvictedObject& evicted = evictedObjects[i];
+			if( evicted.inEvictedRegion && !evict[evicted.regionIndex] )
+			{
+				continue;
+			}
+
+			if( evicted.isStray )
+			{
+				m_regions[evicted.regionIndex].strayObjects.push_back(evicted.record);
+			}
+			objectsToRemove.push_back(evicted.gameObject);
+		}
+		layer->removeGameObjects(objectsToRemove);
+	}
+}
+
+
+int StreamingTmxMap::instantiatePending(int budget)
+{
+	int numCreated = 0;
+	while( numCreated < budget && m_instantiateQueue.size() > 0 )
+	{
+		int regionIndex = m_instantiateQueue[0];
+		Region& region = m_regions[regionIndex];
+
+		while( numCreated < budget && region.nextPendingTile < region.pendingTiles.size() )
+		{
+			const TileRecord& tile = region.pendingTiles[region.nextPendingTile++];
+			unsigned id = tile.idAndFlags & ~(FLIPPED_HORIZONTALLY_FLAG | FLIPPED_VERTICALLY_FLAG | FLIPPED_DIAGONALLY_FLAG);
+			createTileGameObject(m_componentFactory, tile.layerIndex, tile.x, tile.y, tile.tilesetIndex, id,
+				(tile.idAndFlags & FLIPPED_HORIZONTALLY_FLAG) != 0,
+				(tile.idAndFlags & FLIPPED_VERTICALLY_FLAG) != 0,
+				(tile.idAndFlags & FLIPPED_DIAGONALLY_FLAG) != 0 );
+			++numCreated;
+		}
+
+		while( numCreated < budget && region.nextPendingObject < region.pendingObjects.size() )
+		{
+			const ObjectRecord& object = region.pendingObjects[region.nextPendingObject++];
+			PropertySet properties = PropertySet::createFromJson(object.json);
+			createObjectGameObject(m_componentFactory, object.layerIndex, properties, object.tilesetIndex);
+			++numCreated;
+		}
+
+		if( region.nextPendingTile >= region.pendingTiles.size() && region.nextPendingObject >= region.pendingObjects.size() )
+		{
+			std::vector<TileRecord>().swap(region.pendingTiles);
+			std::vector<ObjectRecord>().swap(region.pendingObjects);
+			region.nextPendingTile = 0;
+			region.nextPendingObject = 0;
+			setRegionState(regionIndex, REGION_RESIDENT);
+			m_instantiateQueue.erase(m_instantiateQueue.begin());
+		}
+	}
+
+	return numCreated;
+}
+
+
+void StreamingTmxMap::setRegionState(int regionIndex, RegionState state)
+{
+	Region& region = m_regions[regionIndex];
+	if( region.state == REGION_UNLOADED && state != REGION_UNLOADED )
+	{
+		m_activeRegions.push_back(regionIndex);
+	}
+	else if( region.state != REGION_UNLOADED && state == REGION_UNLOADED )
+	{
+		m_activeRegions.erase(std::remove(m_activeRegions.begin(), m_activeRegions.end(), regionIndex), m_activeRegions.end());
+	}
+	region.state = state;
+}
+
+
+int StreamingTmxMap::getRegionIndex(const vec2& position) const
+{
+	// Tile at (x,y) has position (x-0.5,y), so round to nearest tile first.
+	int x = floorDiv(position.x + 0.5f, m_regionSize);
+	int y = floorDiv(position.y + 0.5f, m_regionSize);
+	x = x < 0 ? 0 : (x >= m_numRegionsX ? m_numRegionsX-1 : x);
+	y = y < 0 ? 0 : (y >= m_numRegionsY ? m_numRegionsY-1 : y);
+	return y*m_numRegionsX + x;
+}
+
+
+int StreamingTmxMap::getRegionDistance(int regionIndex, int cameraRegionX, int cameraRegionY) const
+{
+	int dx = abs(regionIndex % m_numRegionsX - cameraRegionX);
+	int dy = abs(regionIndex / m_numRegionsX - cameraRegionY);
+	return dx > dy ? dx : dy;
+}
+
+
+std::string StreamingTmxMap::getRegionFileName(int regionIndex, const char* type) const
+{
+	char buffer[64];
+#if defined(_WIN32)
+	sprintf_s(buffer, "/region_%d_%d.%s", regionIndex % m_numRegionsX, regionIndex / m_numRegionsX, type);
+#else
+	sprintf(buffer, "/region_%d_%d.%s", regionIndex % m_numRegionsX, regionIndex / m_numRegionsX, type);
+#endif
+	return m_cacheDirectory + buffer;
+}
+
+
+void StreamingTmxMap::appendObjectRecord(std::vector<uint8_t>& data, const ObjectRecord& record)
+{
+	appendInt(data, record.layerIndex);
+	appendInt(data, record.tilesetIndex);
+	appendInt(data, int32_t(record.json.length()));
+	data.insert(data.end(), record.json.begin(), record.json.end());
+}
+
+
+void StreamingTmxMap::decodeRegion(const std::vector<uint8_t>& tileData, const std::vector<uint8_t>& objectData, std::vector<TileRecord>& tiles, std::vector<ObjectRecord>& objects)
+{
+	assert( tileData.size() % sizeof(TileRecord) == 0 );
+	tiles.resize(tileData.size() / sizeof(TileRecord));
+	if( tiles.size() > 0 )
+	{
+		memcpy(&tiles[0], &tileData[0], tileData.size());
+	}
+
+	size_t offset = 0;
+	while( offset < objectData.size() )
+	{
+		ObjectRecord record;
+		record.layerIndex = readInt(objectData, offset);
+		record.tilesetIndex = readInt(objectData, offset);
+		int32_t length = readInt(objectData, offset);
+		assert( offset + length <= objectData.size() );
+		record.json.assign((const char*)&objectData[offset], length);
+		offset += length;
+		objects.push_back(record);
+	}
+}
+
+
+bool StreamingTmxMap::readFile(const std::string& fileName, std::vector<uint8_t>& data)
+{
+	data.clear();
+	FILE* file = fopen(fileName.c_str(), "rb");
+	if( file == 0 )
+	{
+		// Called from the loader thread, so don't use esLogEngineError, which throws.
+		YAM2D_LOG_WARNING(Logger::CATEGORY_ASSETS, "[%s] Region file %s could not be opened", __FUNCTION__, fileName.c_str());
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	bool success = size >= 0;
+	if( size > 0 )
+	{
+		data.resize(size);
+		success = fread(&data[0], 1, size, file) == size_t(size);
+	}
+	fclose(file);
+
+	if( !success )
+	{
+		// Partial records can not be decoded, so file is read as empty.
+		YAM2D_LOG_WARNING(Logger::CATEGORY_ASSETS, "[%s] Region file %s could not be read", __FUNCTION__, fileName.c_str());
+		data.clear();
+	}
+	return success;
+}
+
+
+bool StreamingTmxMap::writeFile(const std::string& fileName, const std::vector<uint8_t>& data)
+{
+	// Called during update, so don't use esLogEngineError, which throws. Caller keeps the records on failure.
+	FILE* file = fopen(fileName.c_str(), "wb");
+	bool success = file != 0;
+	if( success && data.size() > 0 )
+	{
+		success = fwrite(&data[0], 1, data.size(), file) == data.size();
+	}
+
+	if( file != 0 && fclose(file) != 0 )
+	{
+		success = false;
+	}
+
+	if( !success )
+	{
+		YAM2D_LOG_WARNING(Logger::CATEGORY_ASSETS, "[%s] Region file %s could not be written", __FUNCTION__, fileName.c_str());
+	}
+	return success;
+}
+
+}
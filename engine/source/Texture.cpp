@@ -22,10 +22,19 @@
 // =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
 #include "Texture.h"
+#include "TextureConverter.h"
 #include "es_util.h"
 #include <es_assert.h>
+#include <RenderStats.h>
+#include <Logger.h>
 #include <config.h>
 #include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
 
 namespace yam2d
 {
@@ -41,16 +50,48 @@ namespace yam2d
 			return w==h && isNPot(w) && isNPot(h);
 
 		}
+
+		// Total size of all uploaded textures
+		int totalSizeInBytes = 0;
+
+#if YAM2D_LOG_MIN_LEVEL <= 0
+		// Only used in debug logs.
+		const char* getFormatName(Texture::Format format)
+		{
+			switch(format)
+			{
+			case Texture::FORMAT_RGB565: return "RGB565";
+			case Texture::FORMAT_RGBA4444: return "RGBA4444";
+			case Texture::FORMAT_RGBA5551: return "RGBA5551";
+			case Texture::FORMAT_ETC1: return "ETC1";
+			default: return "DEFAULT";
+			}
+		}
+#endif
+
+		void setTextureParameters(bool clampToEdge)
+		{
+			glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, clampToEdge ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+			glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, clampToEdge ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+		}
 	}
 
 Texture::Texture(const std::string& fileName, bool allowNPOT)
 : m_nativeIds(0)
+, m_numNativeIds(1)
 , m_width(0)
 , m_height(0)
 , m_bpp(0)
 , m_data(0)
-, m_numNativeIds(1)
+, m_format(FORMAT_DEFAULT)
+, m_dither(false)
+, m_clampToEdge(false)
+, m_alphaNativeId(0)
+, m_sizeInBytes(0)
 {
+	setMemorySubsystem(MemoryStats::TEXTURES);
 	m_nativeIds = (unsigned int*)new int[m_numNativeIds];	
 	glGenTextures(m_numNativeIds, m_nativeIds);
 
@@ -61,7 +102,7 @@ Texture::Texture(const std::string& fileName, bool allowNPOT)
 	
 	if( allowNPOT==false && !isNpotSquare(m_width,m_height) )
 	{
-		esLogEngineDebug("Image %s, is not NPOT Square texture (w:%d, h:%d, bpp:%d)",
+		YAM2D_LOG_DEBUG(Logger::CATEGORY_RENDER, "Image %s, is not NPOT Square texture (w:%d, h:%d, bpp:%d)",
 			fileName.c_str(), m_width, m_height, m_bpp );
 	}
 
@@ -71,20 +112,46 @@ Texture::Texture(const std::string& fileName, bool allowNPOT)
 		return;
 	}
 
-	esLogEngineDebug("[%s] Image loaded w:%d, h:%d, bpp:%d", __FUNCTION__, m_width, m_height, m_bpp);
+	YAM2D_LOG_DEBUG(Logger::CATEGORY_RENDER, "[%s] Image loaded w:%d, h:%d, bpp:%d", __FUNCTION__, m_width, m_height, m_bpp);
 	
 	setData(m_data,m_width,m_height,m_bpp,0);
 }
 
 
+Texture::Texture(const unsigned char* data, int width, int height, int bpp, Format format, bool dither, bool clampToEdge)
+: m_nativeIds(0)
+, m_numNativeIds(1)
+, m_width(0)
+, m_height(0)
+, m_bpp(0)
+, m_data(0)
+, m_format(format)
+, m_dither(dither)
+, m_clampToEdge(clampToEdge)
+, m_alphaNativeId(0)
+, m_sizeInBytes(0)
+{
+	setMemorySubsystem(MemoryStats::TEXTURES);
+	m_nativeIds = (unsigned int*)new int[m_numNativeIds];	
+	glGenTextures(m_numNativeIds, m_nativeIds);
+	setData(data,width,height,bpp,0);
+}
+
+
 Texture::Texture(unsigned int nativeId, int bytesPerPixel)
 : m_nativeIds(0)
+, m_numNativeIds(1)
 , m_width(0)
 , m_height(0)
 , m_bpp(bytesPerPixel)
 , m_data(0)
-, m_numNativeIds(1)
+, m_format(FORMAT_DEFAULT)
+, m_dither(false)
+, m_clampToEdge(false)
+, m_alphaNativeId(0)
+, m_sizeInBytes(0)
 {
+	setMemorySubsystem(MemoryStats::TEXTURES);
 	m_nativeIds = (unsigned int*)new int[m_numNativeIds];
 	glGenTextures(m_numNativeIds, m_nativeIds);
 	m_nativeIds[0] = nativeId;
@@ -93,21 +160,34 @@ Texture::Texture(unsigned int nativeId, int bytesPerPixel)
 
 Texture::Texture(int numNativeIds)
 : m_nativeIds(0)
+, m_numNativeIds(numNativeIds)
 , m_width(0)
 , m_height(0)
 , m_bpp(0)
 , m_data(0)
-, m_numNativeIds(numNativeIds)
+, m_format(FORMAT_DEFAULT)
+, m_dither(false)
+, m_clampToEdge(false)
+, m_alphaNativeId(0)
+, m_sizeInBytes(0)
 {
+	setMemorySubsystem(MemoryStats::TEXTURES);
 	m_nativeIds = (unsigned int*)new int[m_numNativeIds];
 	glGenTextures(m_numNativeIds, m_nativeIds);
 }
 
 Texture::~Texture()
 {
+	setSizeInBytes(0);
 	glDeleteTextures(m_numNativeIds, m_nativeIds);
 	delete [] m_nativeIds;
 
+	if( m_alphaNativeId != 0 )
+	{
+		glDeleteTextures(1, &m_alphaNativeId);
+		m_alphaNativeId = 0;
+	}
+
 	if( m_data != 0 )
 	{
 		delete [] m_data;
@@ -156,29 +236,172 @@ void Texture::setData(const unsigned char* data, int width, int height, int bpp,
 
 void Texture::updateData(int nativeIdIndex)
 {
-	GLenum fmt;
-	if (m_bpp == 4)
+	assert( nativeIdIndex < m_numNativeIds );
+	int sizeInBytes = uploadData(m_nativeIds[nativeIdIndex]);
+	RenderStats::addTextureUpload(this, sizeInBytes);
+	if( nativeIdIndex == 0 && sizeInBytes > 0 )
 	{
-		fmt = GL_RGBA;
+		setSizeInBytes(sizeInBytes);
 	}
-	else if (m_bpp == 3)
+}
+
+
+int Texture::uploadData(unsigned int nativeId)
+{
+	if( m_bpp != 4 && m_bpp != 3 )
 	{
-		fmt = GL_RGB;
+		YAM2D_LOG_WARNING(Logger::CATEGORY_RENDER, "[%s] Unsupported bytes per pixel: %d", __FUNCTION__, m_bpp);
+		return 0;
 	}
-	else
+
+	GLenum fmt = (m_bpp == 4) ? GL_RGBA : GL_RGB;
+	const int numPixels = m_width*m_height;
+	bool hasAlpha = m_format == FORMAT_ETC1 && hasTransparentPixels(m_data, m_width, m_height, m_bpp);
+	
+	Format format = m_format;
+	if( format == FORMAT_ETC1 && (!isETC1Supported() || (hasAlpha && nativeId != m_nativeIds[0])) )
 	{
-		yam2d::esLogMessage("[%s] Unsupported bytes per pixel: %d", __FUNCTION__, m_bpp);
-		return;
+		// Fallback to 16 bit format, which keeps the alpha channel if needed.
+		format = hasAlpha ? FORMAT_RGBA4444 : FORMAT_RGB565;
 	}
 
-	glBindTexture(GL_TEXTURE_2D, m_nativeIds[nativeIdIndex]);
-	glTexImage2D(GL_TEXTURE_2D, 0, fmt, m_width, m_height, 0, fmt, GL_UNSIGNED_BYTE, m_data);
-	glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	int sizeInBytes = 0;
+	glBindTexture(GL_TEXTURE_2D, nativeId);
+	switch( format )
+	{
+	case FORMAT_RGB565:
+		{
+			std::vector<uint16_t> converted(numPixels);
+			convertToRGB565(m_data, m_width, m_height, m_bpp, m_dither, &converted[0]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, &converted[0]);
+			sizeInBytes = numPixels*2;
+		}
+		break;
+	case FORMAT_RGBA4444:
+		{
+			std::vector<uint16_t> converted(numPixels);
+			convertToRGBA4444(m_data, m_width, m_height, m_bpp, m_dither, &converted[0]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, &converted[0]);
+			sizeInBytes = numPixels*2;
+		}
+		break;
+	case FORMAT_RGBA5551:
+		{
+			std::vector<uint16_t> converted(numPixels);
+			convertToRGBA5551(m_data, m_width, m_height, m_bpp, m_dither, &converted[0]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, &converted[0]);
+			sizeInBytes = numPixels*2;
+		}
+		break;
+	case FORMAT_ETC1:
+		{
+			int dataSize = getETC1DataSize(m_width, m_height);
+			std::vector<uint8_t> compressed(dataSize);
+			compressETC1(m_data, m_width, m_height, m_bpp, &compressed[0]);
+			glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_ETC1_RGB8_OES, m_width, m_height, 0, dataSize, &compressed[0]);
+			sizeInBytes = dataSize;
+
+			if( hasAlpha )
+			{
+				if( m_alphaNativeId == 0 )
+				{
+					glGenTextures(1, &m_alphaNativeId);
+				}
+
+				std::vector<uint8_t> alpha(numPixels);
+				extractAlpha(m_data, m_width, m_height, m_bpp, &alpha[0]);
+				glBindTexture(GL_TEXTURE_2D, m_alphaNativeId);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, m_width, m_height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, &alpha[0]);
+				setTextureParameters(m_clampToEdge);
+				glBindTexture(GL_TEXTURE_2D, nativeId);
+				sizeInBytes += numPixels;
+			}
+		}
+		break;
+	default:
+		glTexImage2D(GL_TEXTURE_2D, 0, fmt, m_width, m_height, 0, fmt, GL_UNSIGNED_BYTE, m_data);
+		sizeInBytes = numPixels*m_bpp;
+		break;
+	}
+
+	if( format != FORMAT_ETC1 && m_alphaNativeId != 0 && nativeId == m_nativeIds[0] )
+	{
+		// Alpha texture is not needed anymore.
+		glDeleteTextures(1, &m_alphaNativeId);
+		m_alphaNativeId = 0;
+	}
+
+	setTextureParameters(m_clampToEdge);
+
+	if( format != FORMAT_DEFAULT )
+	{
+		YAM2D_LOG_DEBUG(Logger::CATEGORY_RENDER, "[%s] Texture w:%d, h:%d uploaded as %s%s: %d bytes -> %d bytes", __FUNCTION__, 
+			m_width, m_height, getFormatName(format), m_dither ? " (dithered)" : "", getSourceSizeInBytes(), sizeInBytes);
+	}
+
+	return sizeInBytes;
 }
 
+
+void Texture::setFormat(Format format, bool dither)
+{
+	m_format = format;
+	m_dither = dither;
+	if( m_data != 0 )
+	{
+		updateData(0);
+	}
+}
+
+
+void Texture::setSizeInBytes(int sizeInBytes)
+{
+	totalSizeInBytes += sizeInBytes - m_sizeInBytes;
+	MemoryStats::addBytes(MemoryStats::TEXTURES, sizeInBytes - m_sizeInBytes);
+	m_sizeInBytes = sizeInBytes;
+}
+
+
+int Texture::getTotalSizeInBytes()
+{
+	return totalSizeInBytes;
+}
+
+
+Texture::Format Texture::getFormatFromString(const std::string& formatName)
+{
+	if( formatName == "RGB565" )
+		return FORMAT_RGB565;
+	if( formatName == "RGBA4444" )
+		return FORMAT_RGBA4444;
+	if( formatName == "RGBA5551" )
+		return FORMAT_RGBA5551;
+	if( formatName == "ETC1" )
+		return FORMAT_ETC1;
+	if( formatName.length() > 0 && formatName != "RGBA8888" && formatName != "DEFAULT" )
+	{
+		YAM2D_LOG_DEBUG(Logger::CATEGORY_RENDER, "[%s] Unknown texture format \"%s\". Using default format.", __FUNCTION__, formatName.c_str());
+	}
+	return FORMAT_DEFAULT;
+}
+
+
+bool Texture::isETC1Supported()
+{
+	static int supported = -1;
+	if( supported < 0 )
+	{
+		const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+		supported = (extensions != 0 && strstr(extensions, "GL_OES_compressed_ETC1_RGB8_texture") != 0) ? 1 : 0;
+		if( !supported )
+		{
+			YAM2D_LOG_DEBUG(Logger::CATEGORY_RENDER, "[%s] GL_OES_compressed_ETC1_RGB8_texture is not supported by the driver", __FUNCTION__);
+		}
+	}
+	return supported == 1;
+}
+
+
 int Texture::getWidth() const
 {
 	return m_width;
@@ -194,45 +417,15 @@ int Texture::getHeight() const
 void Texture::setTransparentColor(unsigned char r, unsigned char g, unsigned char b)
 {
 	assert( m_data != 0 );
-	GLenum fmt;
 	if( getBytesPerPixel() == 4 )
-	{	
-		fmt = GL_RGBA;
-		for( int y=0; y<getHeight(); ++y )
-		{
-			for( int x=0; x<getWidth(); ++x )
-			{
-				unsigned char* data = getPixel(x,y);
-				if( data[0] == r && data[1] == g && data[2] == b )
-				{
-					data[3] = 0;
-				}
-			}
-		}
+	{
+		applyTransparentColor(m_data, m_width, m_height, m_bpp, r, g, b, m_data);
 	}
 	else if( getBytesPerPixel() == 3 )
 	{		
 		unsigned char* newData = new unsigned char[m_width*m_height*4];
-		
-		for( int y=0; y<getHeight(); ++y )
-		{
-			for( int x=0; x<getWidth(); ++x )
-			{
-				unsigned char* data = getPixel(x,y);
-				unsigned char* d = &newData[(y*getWidth()+x)*4];
-				d[0] = data[0];
-				d[1] = data[1];
-				d[2] = data[2];
-				d[3] = 0xff;
-				if( data[0] == r && data[1] == g && data[2] == b )
-				{
-					d[3] = 0x00;
-				}
-			}
-		}
-
+		applyTransparentColor(m_data, m_width, m_height, m_bpp, r, g, b, newData);
 		m_bpp = 4;
-		fmt = GL_RGBA;
 		delete [] m_data;
 		m_data = newData;
 	}
@@ -242,12 +435,8 @@ void Texture::setTransparentColor(unsigned char r, unsigned char g, unsigned cha
 		return;
 	}
 	
-	glBindTexture(GL_TEXTURE_2D, getNativeId());
-	glTexImage2D(GL_TEXTURE_2D, 0, fmt, m_width, m_height, 0,  fmt, GL_UNSIGNED_BYTE, m_data );
-	glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameterx(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	m_clampToEdge = true;
+	updateData(0);
 }
 
 }
@@ -0,0 +1,360 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "TextureConverter.h"
+#include <es_assert.h>
+#include <string.h>
+
+namespace yam2d
+{
+
+// anonymous namespace for internal functions
+namespace
+{
+	// 4x4 Bayer matrix for ordered dithering, values 0..15.
+	const int bayer4x4[4][4] =
+	{
+		{  0,  8,  2, 10 },
+		{ 12,  4, 14,  6 },
+		{  3, 11,  1,  9 },
+		{ 15,  7, 13,  5 },
+	};
+
+	// ETC1 intensity modifier tables. Each table has values {a, b}, which gives modifiers {a, b, -a, -b}.
+	const int etc1Modifiers[8][2] =
+	{
+		{  2,   8 },
+		{  5,  17 },
+		{  9,  29 },
+		{ 13,  42 },
+		{ 18,  60 },
+		{ 24,  80 },
+		{ 33, 106 },
+		{ 47, 183 },
+	};
+
+	inline int clamp255(int v)
+	{
+		return v < 0 ? 0 : (v > 255 ? 255 : v);
+	}
+
+	// Quantizes 8 bit value to given number of bits. Dither offset is added before truncating.
+	inline int quantize(int v, int bits, int x, int y, bool dither)
+	{
+		if( dither )
+		{
+			// Offset range is half of quantization step to each direction.
+			int step = 1 << (8-bits);
+			v = clamp255(v + ((bayer4x4[y&3][x&3]*2 - 15) * step) / 32);
+		}
+		return v >> (8-bits);
+	}
+
+	inline int getAlpha(const uint8_t* p, int bpp)
+	{
+		return bpp == 4 ? p[3] : 0xff;
+	}
+
+	inline void readBlockPixel(const uint8_t* src, int width, int height, int bpp, int x, int y, int* rgb)
+	{
+		// Pixels outside of the image are clamped to edge.
+		if( x >= width ) x = width-1;
+		if( y >= height ) y = height-1;
+		const uint8_t* p = &src[(y*width + x)*bpp];
+		rgb[0] = p[0];
+		rgb[1] = p[1];
+		rgb[2] = p[2];
+	}
+
+	inline bool isInFirstSubBlock(int x, int y, bool flip)
+	{
+		return flip ? (y < 2) : (x < 2);
+	}
+
+	// Encodes one sub block of 8 pixels with given 4 bit base color. Returns total squared error and writes 
+	// selected modifier table and per pixel indices.
+	int encodeSubBlock(const int pixels[4][4][3], bool flip, bool first, const int base[3], int* tableOut, int indices[4][4])
+	{
+		int bestError = 0x7fffffff;
+		int bestIndices[4][4] = {};
+		for( int t=0; t<8; ++t )
+		{
+			const int modifiers[4] = { etc1Modifiers[t][0], etc1Modifiers[t][1], -etc1Modifiers[t][0], -etc1Modifiers[t][1] };
+			int tableError = 0;
+			int tableIndices[4][4] = {};
+			for( int y=0; y<4; ++y )
+			{
+				for( int x=0; x<4; ++x )
+				{
+					if( isInFirstSubBlock(x,y,flip) != first )
+						continue;
+
+					int bestPixelError = 0x7fffffff;
+					for( int i=0; i<4; ++i )
+					{
+						int pixelError = 0;
+						for( int c=0; c<3; ++c )
+						{
+							int d = clamp255(base[c] + modifiers[i]) - pixels[y][x][c];
+							pixelError += d*d;
+						}
+						if( pixelError < bestPixelError )
+						{
+							bestPixelError = pixelError;
+							tableIndices[y][x] = i;
+						}
+					}
+					tableError += bestPixelError;
+				}
+			}
+
+			if( tableError < bestError )
+			{
+				bestError = tableError;
+				*tableOut = t;
+				memcpy(bestIndices, tableIndices, sizeof(bestIndices));
+			}
+		}
+
+		for( int y=0; y<4; ++y )
+		{
+			for( int x=0; x<4; ++x )
+			{
+				if( isInFirstSubBlock(x,y,flip) == first )
+					indices[y][x] = bestIndices[y][x];
+			}
+		}
+		return bestError;
+	}
+
+	// Calculates average color of sub block and quantizes it to 4 bits per channel.
+	void averageSubBlock(const int pixels[4][4][3], bool flip, bool first, int base4[3])
+	{
+		int sum[3] = { 0, 0, 0 };
+		for( int y=0; y<4; ++y )
+		{
+			for( int x=0; x<4; ++x )
+			{
+				if( isInFirstSubBlock(x,y,flip) != first )
+					continue;
+				for( int c=0; c<3; ++c )
+					sum[c] += pixels[y][x][c];
+			}
+		}
+
+		for( int c=0; c<3; ++c )
+		{
+			int avg = (sum[c] + 4) / 8;
+			base4[c] = (avg*15 + 127) / 255;
+		}
+	}
+
+	// Encodes 4x4 pixels using ETC1 individual mode. Both flip orientations are tried.
+	void encodeETC1Block(const int pixels[4][4][3], uint8_t* dst)
+	{
+		uint32_t bestHigh = 0;
+		uint32_t bestLow = 0;
+		int bestError = 0x7fffffff;
+
+		for( int f=0; f<2; ++f )
+		{
+			bool flip = f == 1;
+			int base4[2][3];
+			int base[2][3];
+			int tables[2] = { 0, 0 };
+			int indices[4][4] = {};
+			int error = 0;
+			for( int s=0; s<2; ++s )
+			{
+				averageSubBlock(pixels, flip, s==0, base4[s]);
+				for( int c=0; c<3; ++c )
+					base[s][c] = (base4[s][c] << 4) | base4[s][c];
+				error += encodeSubBlock(pixels, flip, s==0, base[s], &tables[s], indices);
+			}
+
+			if( error >= bestError )
+				continue;
+			bestError = error;
+
+			bestHigh = (base4[0][0] << 28) | (base4[1][0] << 24) 
+				| (base4[0][1] << 20) | (base4[1][1] << 16) 
+				| (base4[0][2] << 12) | (base4[1][2] << 8)
+				| (tables[0] << 5) | (tables[1] << 2) 
+				| (0 << 1) // individual mode
+				| (flip ? 1 : 0);
+
+			// Modifier index is stored as two bit planes. Pixel indices goes in column major order.
+			// Index mapping: 0 -> +a (00), 1 -> +b (01), 2 -> -a (10), 3 -> -b (11)
+			bestLow = 0;
+			for( int x=0; x<4; ++x )
+			{
+				for( int y=0; y<4; ++y )
+				{
+					int bit = x*4 + y;
+					int index = indices[y][x];
+					bestLow |= ((index >> 1) & 1) << (bit+16);
+					bestLow |= (index & 1) << bit;
+				}
+			}
+		}
+
+		// ETC1 blocks are stored in big endian byte order.
+		dst[0] = uint8_t(bestHigh >> 24);
+		dst[1] = uint8_t(bestHigh >> 16);
+		dst[2] = uint8_t(bestHigh >> 8);
+		dst[3] = uint8_t(bestHigh);
+		dst[4] = uint8_t(bestLow >> 24);
+		dst[5] = uint8_t(bestLow >> 16);
+		dst[6] = uint8_t(bestLow >> 8);
+		dst[7] = uint8_t(bestLow);
+	}
+}
+
+
+void convertToRGB565(const uint8_t* src, int width, int height, int bpp, bool dither, uint16_t* dst)
+{
+	assert( bpp == 3 || bpp == 4 );
+	for( int y=0; y<height; ++y )
+	{
+		for( int x=0; x<width; ++x )
+		{
+			const uint8_t* p = &src[(y*width + x)*bpp];
+			int r = quantize(p[0], 5, x, y, dither);
+			int g = quantize(p[1], 6, x, y, dither);
+			int b = quantize(p[2], 5, x, y, dither);
+			dst[y*width + x] = uint16_t((r << 11) | (g << 5) | b);
+		}
+	}
+}
+
+
+void convertToRGBA4444(const uint8_t* src, int width, int height, int bpp, bool dither, uint16_t* dst)
+{
+	assert( bpp == 3 || bpp == 4 );
+	for( int y=0; y<height; ++y )
+	{
+		for( int x=0; x<width; ++x )
+		{
+			const uint8_t* p = &src[(y*width + x)*bpp];
+			int r = quantize(p[0], 4, x, y, dither);
+			int g = quantize(p[1], 4, x, y, dither);
+			int b = quantize(p[2], 4, x, y, dither);
+			int a = quantize(getAlpha(p,bpp), 4, x, y, dither);
+			dst[y*width + x] = uint16_t((r << 12) | (g << 8) | (b << 4) | a);
+		}
+	}
+}
+
+
+void convertToRGBA5551(const uint8_t* src, int width, int height, int bpp, bool dither, uint16_t* dst)
+{
+	assert( bpp == 3 || bpp == 4 );
+	for( int y=0; y<height; ++y )
+	{
+		for( int x=0; x<width; ++x )
+		{
+			const uint8_t* p = &src[(y*width + x)*bpp];
+			int r = quantize(p[0], 5, x, y, dither);
+			int g = quantize(p[1], 5, x, y, dither);
+			int b = quantize(p[2], 5, x, y, dither);
+			int a = getAlpha(p,bpp) >= 128 ? 1 : 0;
+			dst[y*width + x] = uint16_t((r << 11) | (g << 6) | (b << 1) | a);
+		}
+	}
+}
+
+
+int getETC1DataSize(int width, int height)
+{
+	return ((width+3)/4) * ((height+3)/4) * 8;
+}
+
+
+void compressETC1(const uint8_t* src, int width, int height, int bpp, uint8_t* dst)
+{
+	assert( bpp == 3 || bpp == 4 );
+	int pixels[4][4][3];
+	for( int by=0; by<height; by += 4 )
+	{
+		for( int bx=0; bx<width; bx += 4 )
+		{
+			for( int y=0; y<4; ++y )
+			{
+				for( int x=0; x<4; ++x )
+				{
+					readBlockPixel(src, width, height, bpp, bx+x, by+y, pixels[y][x]);
+				}
+			}
+
+			encodeETC1Block(pixels, dst);
+			dst += 8;
+		}
+	}
+}
+
+
+void extractAlpha(const uint8_t* src, int width, int height, int bpp, uint8_t* dst)
+{
+	assert( bpp == 3 || bpp == 4 );
+	for( int i=0; i<width*height; ++i )
+	{
+		dst[i] = uint8_t(getAlpha(&src[i*bpp],bpp));
+	}
+}
+
+
+bool hasTransparentPixels(const uint8_t* src, int width, int height, int bpp)
+{
+	if( bpp != 4 )
+		return false;
+
+	for( int i=0; i<width*height; ++i )
+	{
+		if( src[i*4+3] != 0xff )
+			return true;
+	}
+	return false;
+}
+
+
+
+void applyTransparentColor(const uint8_t* src, int width, int height, int bpp, uint8_t r, uint8_t g, uint8_t b, uint8_t* dst)
+{
+	assert( bpp == 3 || bpp == 4 );
+	for( int i=0; i<width*height; ++i )
+	{
+		const uint8_t* s = &src[i*bpp];
+		uint8_t* d = &dst[i*4];
+		uint8_t a = (bpp == 4) ? s[3] : 0xff;
+		if( s[0] == r && s[1] == g && s[2] == b )
+		{
+			a = 0x00;
+		}
+		d[0] = s[0];
+		d[1] = s[1];
+		d[2] = s[2];
+		d[3] = a;
+	}
+}
+
+}
@@ -0,0 +1,277 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "Thread.h"
+#include "Profiler.h"
+#include "es_util.h"
+#include <config.h>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#endif
+
+namespace yam2d
+{
+
+void runThreadEntry(Thread* thread)
+{
+	thread->run();
+	Profiler::endThread();
+}
+
+// anonymous namespace for internal functions
+namespace
+{
+#if defined(_WIN32)
+	DWORD WINAPI threadEntry(LPVOID param)
+	{
+		runThreadEntry((Thread*)param);
+		return 0;
+	}
+#else
+	void* threadEntry(void* param)
+	{
+		runThreadEntry((Thread*)param);
+		return 0;
+	}
+#endif
+}
+
+
+#if defined(_WIN32)
+
+Mutex::Mutex()
+: m_handle(new CRITICAL_SECTION())
+{
+	InitializeCriticalSection((CRITICAL_SECTION*)m_handle);
+}
+
+
+Mutex::~Mutex()
+{
+	DeleteCriticalSection((CRITICAL_SECTION*)m_handle);
+	delete (CRITICAL_SECTION*)m_handle;
+}
+
+
+void Mutex::lock()
+{
+	EnterCriticalSection((CRITICAL_SECTION*)m_handle);
+}
+
+
+void Mutex::unlock()
+{
+	LeaveCriticalSection((CRITICAL_SECTION*)m_handle);
+}
+
+
+ConditionVariable::ConditionVariable()
+: m_handle(new CONDITION_VARIABLE())
+{
+	InitializeConditionVariable((CONDITION_VARIABLE*)m_handle);
+}
+
+
+ConditionVariable::~ConditionVariable()
+{
+	delete (CONDITION_VARIABLE*)m_handle;
+}
+
+
+void ConditionVariable::wait(Mutex& mutex)
+{
+	SleepConditionVariableCS((CONDITION_VARIABLE*)m_handle, (CRITICAL_SECTION*)mutex.m_handle, INFINITE);
+}
+
+
+void ConditionVariable::signal()
+{
+	WakeConditionVariable((CONDITION_VARIABLE*)m_handle);
+}
+
+
+void ConditionVariable::broadcast()
+{
+	WakeAllConditionVariable((CONDITION_VARIABLE*)m_handle);
+}
+
+
+bool Thread::start()
+{
+	assert( m_handle == 0 ); // Thread already started
+	m_handle = CreateThread(0, 0, threadEntry, this, 0, 0);
+	if( m_handle == 0 )
+	{
+		esLogEngineError("[%s] Could not create thread", __FUNCTION__);
+		return false;
+	}
+	return true;
+}
+
+
+void Thread::join()
+{
+	if( m_handle == 0 )
+		return;
+
+	WaitForSingleObject((HANDLE)m_handle, INFINITE);
+	CloseHandle((HANDLE)m_handle);
+	m_handle = 0;
+}
+
+
+void Thread::sleep(int milliseconds)
+{
+	Sleep(milliseconds);
+}
+
+
+int Thread::getNumProcessors()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return int(info.dwNumberOfProcessors);
+}
+
+#else
+
+Mutex::Mutex()
+: m_handle(new pthread_mutex_t())
+{
+	pthread_mutex_init((pthread_mutex_t*)m_handle, 0);
+}
+
+
+Mutex::~Mutex()
+{
+	pthread_mutex_destroy((pthread_mutex_t*)m_handle);
+	delete (pthread_mutex_t*)m_handle;
+}
+
+
+void Mutex::lock()
+{
+	pthread_mutex_lock((pthread_mutex_t*)m_handle);
+}
+
+
+void Mutex::unlock()
+{
+	pthread_mutex_unlock((pthread_mutex_t*)m_handle);
+}
+
+
+ConditionVariable::ConditionVariable()
+: m_handle(new pthread_cond_t())
+{
+	pthread_cond_init((pthread_cond_t*)m_handle, 0);
+}
+
+
+ConditionVariable::~ConditionVariable()
+{
+	pthread_cond_destroy((pthread_cond_t*)m_handle);
+	delete (pthread_cond_t*)m_handle;
+}
+
+
+void ConditionVariable::wait(Mutex& mutex)
+{
+	pthread_cond_wait((pthread_cond_t*)m_handle, (pthread_mutex_t*)mutex.m_handle);
+}
+
+
+void ConditionVariable::signal()
+{
+	pthread_cond_signal((pthread_cond_t*)m_handle);
+}
+
+
+void ConditionVariable::broadcast()
+{
+	pthread_cond_broadcast((pthread_cond_t*)m_handle);
+}
+
+
+bool Thread::start()
+{
+	assert( m_handle == 0 ); // Thread already started
+	pthread_t* thread = new pthread_t();
+	if( pthread_create(thread, 0, threadEntry, this) != 0 )
+	{
+		delete thread;
+		esLogEngineError("[%s] Could not create thread", __FUNCTION__);
+		return false;
+	}
+	m_handle = thread;
+	return true;
+}
+
+
+void Thread::join()
+{
+	if( m_handle == 0 )
+		return;
+
+	pthread_join(*(pthread_t*)m_handle, 0);
+	delete (pthread_t*)m_handle;
+	m_handle = 0;
+}
+
+
+void Thread::sleep(int milliseconds)
+{
+	timespec t;
+	t.tv_sec = milliseconds / 1000;
+	t.tv_nsec = (milliseconds % 1000) * 1000000;
+	nanosleep(&t, 0);
+}
+
+
+int Thread::getNumProcessors()
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? int(n) : 1;
+}
+
+#endif
+
+
+Thread::Thread()
+: Object()
+, m_handle(0)
+{
+}
+
+
+Thread::~Thread()
+{
+	assert( m_handle == 0 ); // You must call join before destroying the thread.
+}
+
+}
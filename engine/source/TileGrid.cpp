@@ -0,0 +1,544 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "TileGrid.h"
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+namespace yam2d
+{
+
+namespace
+{
+	// Limits cell coordinates, so that far away positions do not overflow int.
+	const float MAX_CELL_COORDINATE = 1.0e9f;
+
+	int toCell(float coordinate)
+	{
+		if( coordinate < -MAX_CELL_COORDINATE ) coordinate = -MAX_CELL_COORDINATE;
+		if( coordinate > MAX_CELL_COORDINATE ) coordinate = MAX_CELL_COORDINATE;
+		return int(floorf(coordinate));
+	}
+
+	// Returns index of first cell starting at or after given coordinate.
+	int toCellAbove(float coordinate)
+	{
+		return -toCell(-coordinate);
+	}
+
+	// Returns range of cells overlapping with interval from a to b (in grid coordinates). Cells only touching
+	// the interval are not included, except for zero length interval, which overlaps the cell containing it.
+	void getCellRange(float a, float b, int& c0, int& c1)
+	{
+		c0 = toCell(a);
+		c1 = toCellAbove(b) - 1;
+		if( c1 < c0 )
+		{
+			c1 = c0;
+		}
+	}
+
+	// Clips line against one side of the grid (Liang-Barsky).
+	bool clipSide(float p, float q, float& t0, float& t1, vec2& entryNormal, const vec2& sideNormal)
+	{
+		if( p == 0.0f )
+		{
+			return q >= 0.0f;
+		}
+
+		float r = q / p;
+		if( p < 0.0f )
+		{
+			if( r > t1 )
+				return false;
+			if( r > t0 )
+			{
+				t0 = r;
+				entryNormal = sideNormal;
+			}
+		}
+		else
+		{
+			if( r < t0 )
+				return false;
+			if( r < t1 )
+				t1 = r;
+		}
+		return true;
+	}
+
+	void setNoHit(TileGrid::RaycastHit* hit, const vec2& end)
+	{
+		if( hit != 0 )
+		{
+			hit->position = end;
+			hit->normal = vec2(0.0f);
+			hit->fraction = 1.0f;
+			hit->cellX = -1;
+			hit->cellY = -1;
+		}
+	}
+}
+
+
+TileGrid::TileGrid(int width, int height, const vec2& origin)
+: Object()
+, m_width(width)
+, m_height(height)
+, m_origin(origin)
+, m_cells(size_t(width)*size_t(height), 0)
+, m_listeners()
+{
+	assert( width >= 0 && height >= 0 );
+}
+
+
+TileGrid::~TileGrid()
+{
+}
+
+
+void TileGrid::addChangeListener(ChangeListener* listener)
+{
+	assert( listener != 0 );
+	m_listeners.push_back(listener);
+}
+
+
+void TileGrid::removeChangeListener(ChangeListener* listener)
+{
+	std::vector<ChangeListener*>::iterator it = std::find(m_listeners.begin(), m_listeners.end(), listener);
+	if( it != m_listeners.end() )
+	{
+		m_listeners.erase(it);
+	}
+}
+
+
+void TileGrid::notifyCellChanged(int x, int y, bool solid)
+{
+	for( size_t i=0; i<m_listeners.size(); ++i )
+	{
+		m_listeners[i]->onCellChanged(x, y, solid);
+	}
+}
+
+
+int TileGrid::getCellX(float x) const
+{
+	return toCell(x - m_origin.x);
+}
+
+
+int TileGrid::getCellY(float y) const
+{
+	return toCell(y - m_origin.y);
+}
+
+
+bool TileGrid::isColumnSolid(int x, int y0, int y1) const
+{
+	if( x < 0 || x >= m_width )
+	{
+		return false;
+	}
+
+	if( y0 < 0 ) y0 = 0;
+	if( y1 >= m_height ) y1 = m_height-1;
+	for( int y=y0; y<=y1; ++y )
+	{
+		if( m_cells[y*m_width + x] != 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool TileGrid::isRowSolid(int y, int x0, int x1) const
+{
+	if( y < 0 || y >= m_height )
+	{
+		return false;
+	}
+
+	if( x0 < 0 ) x0 = 0;
+	if( x1 >= m_width ) x1 = m_width-1;
+	const uint8_t* row = &m_cells[y*m_width];
+	for( int x=x0; x<=x1; ++x )
+	{
+		if( row[x] != 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool TileGrid::overlapsSolid(const vec2& topLeft, const vec2& bottomRight) const
+{
+	int x0, x1, y0, y1;
+	getCellRange(topLeft.x - m_origin.x, bottomRight.x - m_origin.x, x0, x1);
+	getCellRange(topLeft.y - m_origin.y, bottomRight.y - m_origin.y, y0, y1);
+	if( y0 < 0 ) y0 = 0;
+	if( y1 >= m_height ) y1 = m_height-1;
+	for( int y=y0; y<=y1; ++y )
+	{
+		if( isRowSolid(y, x0, x1) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+vec2 TileGrid::sweepAabb(const vec2& topLeft, const vec2& bottomRight, const vec2& delta, vec2* hitNormal) const
+{
+	float left = topLeft.x - m_origin.x;
+	float right = bottomRight.x - m_origin.x;
+	float top = topLeft.y - m_origin.y;
+	float bottom = bottomRight.y - m_origin.y;
+	vec2 movement(delta);
+	vec2 normal(0.0f);
+
+	// Move along x axis. Columns, which area already overlaps, are not tested.
+	if( movement.x != 0.0f )
+	{
+		int y0, y1;
+		getCellRange(top, bottom, y0, y1);
+		if( movement.x > 0.0f )
+		{
+			int xStart = std::max(toCellAbove(right), 0);
+			int xEnd = std::min(toCellAbove(right + movement.x) - 1, m_width-1);
+			for( int x=xStart; x<=xEnd; ++x )
+			{
+				if( isColumnSolid(x, y0, y1) )
+				{
+					movement.x = float(x) - right;
+					normal.x = -1.0f;
+					break;
+				}
+			}
+		}
+		else
+		{
+			int xStart = std::min(toCell(left) - 1, m_width-1);
+			int xEnd = std::max(toCell(left + movement.x), 0);
+			for( int x=xStart; x>=xEnd; --x )
+			{
+				if( isColumnSolid(x, y0, y1) )
+				{
+					movement.x = float(x+1) - left;
+					normal.x = 1.0f;
+					break;
+				}
+			}
+		}
+
+		left += movement.x;
+		right += movement.x;
+	}
+
+	// Move along y axis from the new x position.
+	if( movement.y != 0.0f )
+	{
+		int x0, x1;
+		getCellRange(left, right, x0, x1);
+		if( movement.y > 0.0f )
+		{
+			int yStart = std::max(toCellAbove(bottom), 0);
+			int yEnd = std::min(toCellAbove(bottom + movement.y) - 1, m_height-1);
+			for( int y=yStart; y<=yEnd; ++y )
+			{
+				if( isRowSolid(y, x0, x1) )
+				{
+					movement.y = float(y) - bottom;
+					normal.y = -1.0f;
+					break;
+				}
+			}
+		}
+		else
+		{
+			int yStart = std::min(toCell(top) - 1, m_height-1);
+			int yEnd = std::max(toCell(top + movement.y), 0);
+			for( int y=yStart; y>=yEnd; --y )
+			{
+				if( isRowSolid(y, x0, x1) )
+				{
+					movement.y = float(y+1) - top;
+					normal.y = 1.0f;
+					break;
+				}
+			}
+		}
+	}
+
+	if( hitNormal != 0 )
+	{
+		*hitNormal = normal;
+	}
+
+	return movement;
+}
+
+
+bool TileGrid::clipToGrid(const vec2& start, const vec2& delta, float& t0, float& t1, vec2& entryNormal) const
+{
+	return clipSide(-delta.x, start.x, t0, t1, entryNormal, vec2(-1.0f, 0.0f))
+		&& clipSide(delta.x, float(m_width) - start.x, t0, t1, entryNormal, vec2(1.0f, 0.0f))
+		&& clipSide(-delta.y, start.y, t0, t1, entryNormal, vec2(0.0f, -1.0f))
+		&& clipSide(delta.y, float(m_height) - start.y, t0, t1, entryNormal, vec2(0.0f, 1.0f));
+}
+
+
+bool TileGrid::raycast(const vec2& start, const vec2& end, RaycastHit* hit) const
+{
+	const vec2 p = start - m_origin;
+	const vec2 d = end - start;
+	float t0 = 0.0f;
+	float t1 = 1.0f;
+	vec2 normal(0.0f);
+	if( m_width == 0 || m_height == 0 || !clipToGrid(p, d, t0, t1, normal) )
+	{
+		setNoHit(hit, end);
+		return false;
+	}
+
+	// Walk cells along the ray (Amanatides & Woo). Times are fractions of the whole ray.
+	int x = toCell(p.x + d.x*t0);
+	int y = toCell(p.y + d.y*t0);
+	x = x < 0 ? 0 : (x >= m_width ? m_width-1 : x);
+	y = y < 0 ? 0 : (y >= m_height ? m_height-1 : y);
+
+	const int stepX = d.x > 0.0f ? 1 : (d.x < 0.0f ? -1 : 0);
+	const int stepY = d.y > 0.0f ? 1 : (d.y < 0.0f ? -1 : 0);
+	const float tDeltaX = stepX != 0 ? fabsf(1.0f / d.x) : FLT_MAX;
+	const float tDeltaY = stepY != 0 ? fabsf(1.0f / d.y) : FLT_MAX;
+	float tMaxX = stepX != 0 ? (float(x + (stepX > 0 ? 1 : 0)) - p.x) / d.x : FLT_MAX;
+	float tMaxY = stepY != 0 ? (float(y + (stepY > 0 ? 1 : 0)) - p.y) / d.y : FLT_MAX;
+	float t = t0;
+
+	for(;;)
+	{
+		if( m_cells[y*m_width + x] != 0 )
+		{
+			if( hit != 0 )
+			{
+				hit->position = start + d*t;
+				hit->normal = normal;
+				hit->fraction = t;
+				hit->cellX = x;
+				hit->cellY = y;
+			}
+			return true;
+		}
+
+		if( tMaxX < tMaxY )
+		{
+			if( tMaxX > t1 )
+				break;
+			t = tMaxX;
+			tMaxX += tDeltaX;
+			x += stepX;
+			normal = vec2(float(-stepX), 0.0f);
+			if( x < 0 || x >= m_width )
+				break;
+		}
+		else
+		{
+			if( tMaxY > t1 )
+				break;
+			t = tMaxY;
+			tMaxY += tDeltaY;
+			y += stepY;
+			normal = vec2(0.0f, float(-stepY));
+			if( y < 0 || y >= m_height )
+				break;
+		}
+	}
+
+	setNoHit(hit, end);
+	return false;
+}
+
+
+int TileGrid::raycast(const vec2* starts, const vec2* ends, int numRays, RaycastHit* hits) const
+{
+	int numHits = 0;
+	for( int i=0; i<numRays; ++i )
+	{
+		if( raycast(starts[i], ends[i], &hits[i]) )
+		{
+			++numHits;
+		}
+	}
+	return numHits;
+}
+
+
+int TileGrid::hasLineOfSight(const vec2& start, const vec2* targets, int numTargets, uint8_t* visible) const
+{
+	int numVisible = 0;
+	for( int i=0; i<numTargets; ++i )
+	{
+		visible[i] = raycast(start, targets[i]) ? 0 : 1;
+		numVisible += visible[i];
+	}
+	return numVisible;
+}
+
+
+int TileGrid::hasLineOfSight(const vec2* starts, const vec2* ends, int numRays, uint8_t* visible) const
+{
+	int numVisible = 0;
+	for( int i=0; i<numRays; ++i )
+	{
+		visible[i] = raycast(starts[i], ends[i]) ? 0 : 1;
+		numVisible += visible[i];
+	}
+	return numVisible;
+}
+
+
+
+void TileGrid::getSolidRectangles(std::vector<CellRect>& rectangles) const
+{
+	rectangles.clear();
+	std::vector<uint8_t> used(m_cells.size(), 0);
+	for( int y=0; y<m_height; ++y )
+	{
+		for( int x=0; x<m_width; ++x )
+		{
+			if( m_cells[y*m_width + x] == 0 || used[y*m_width + x] != 0 )
+			{
+				continue;
+			}
+
+			int width = 1;
+			while( x + width < m_width && m_cells[y*m_width + x + width] != 0 && used[y*m_width + x + width] == 0 )
+			{
+				++width;
+			}
+
+			int height = 1;
+			while( y + height < m_height )
+			{
+				const int row = (y + height)*m_width + x;
+				int i = 0;
+				while( i < width && m_cells[row + i] != 0 && used[row + i] == 0 )
+				{
+					++i;
+				}
+
+				if( i < width )
+				{
+					break;
+				}
+				++height;
+			}
+
+			for( int j=0; j<height; ++j )
+			{
+				std::fill(used.begin() + (y + j)*m_width + x, used.begin() + (y + j)*m_width + x + width, uint8_t(1));
+			}
+
+			CellRect rectangle = { x, y, width, height };
+			rectangles.push_back(rectangle);
+		}
+	}
+}
+
+
+void TileGrid::getSolidOutlines(std::vector< std::vector<vec2> >& outlines) const
+{
+	// Boundary edges between solid and empty cells go along cell sides clockwise around solid areas. Each corner
+	// has bit for each direction of edge starting from it: 0 = +x, 1 = +y, 2 = -x, 3 = -y. Turning right is
+	// next direction.
+	static const int directionsX[4] = { 1, 0, -1, 0 };
+	static const int directionsY[4] = { 0, 1, 0, -1 };
+	outlines.clear();
+	const int numCornersX = m_width + 1;
+	std::vector<uint8_t> edges(size_t(numCornersX)*size_t(m_height + 1), 0);
+	for( int y=0; y<m_height; ++y )
+	{
+		for( int x=0; x<m_width; ++x )
+		{
+			if( !isSolid(x, y) )
+			{
+				continue;
+			}
+
+			if( !isSolid(x, y-1) ) edges[y*numCornersX + x] |= 1;
+			if( !isSolid(x+1, y) ) edges[y*numCornersX + x+1] |= 2;
+			if( !isSolid(x, y+1) ) edges[(y+1)*numCornersX + x+1] |= 4;
+			if( !isSolid(x-1, y) ) edges[(y+1)*numCornersX + x] |= 8;
+		}
+	}
+
+	for( size_t startCorner=0; startCorner<edges.size(); ++startCorner )
+	{
+		while( edges[startCorner] != 0 )
+		{
+			// Follow edges until back at start. At corners, where two areas touch diagonally, turning right keeps
+			// going around the same area.
+			std::vector<vec2> outline;
+			int corner = (int)startCorner;
+			int direction = 0;
+			while( (edges[corner] & (1 << direction)) == 0 )
+			{
+				++direction;
+			}
+
+			const int startDirection = direction;
+			do
+			{
+				edges[corner] &= ~(1 << direction);
+				corner += directionsY[direction]*numCornersX + directionsX[direction];
+
+				const int right = (direction + 1) & 3;
+				const int left = (direction + 3) & 3;
+				int next = direction;
+				if( corner == (int)startCorner )
+					next = startDirection;
+				else if( edges[corner] & (1 << right) )
+					next = right;
+				else if( (edges[corner] & (1 << direction)) == 0 )
+					next = left;
+
+				if( next != direction )
+				{
+					outline.push_back(m_origin + vec2(float(corner % numCornersX), float(corner / numCornersX)));
+				}
+				direction = next;
+			} while( corner != (int)startCorner );
+
+			outlines.push_back(outline);
+		}
+	}
+}
+
+}
@@ -33,9 +33,9 @@ using namespace std;
 Tileset::Tileset(const std::string name, SpriteSheet* spriteSheet, float tileOffsetX, float tileOffsetY, const PropertySet& properties )
 : m_name(name)
 , m_properties(properties)
-, m_spriteSheet(spriteSheet)
 , m_tileOffsetX(tileOffsetX)
 , m_tileOffsetY(tileOffsetY)
+, m_spriteSheet(spriteSheet)
 {
 }
 
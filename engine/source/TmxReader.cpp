@@ -0,0 +1,1285 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include "TmxReader.h"
+#include "FileStream.h"
+#include "es_util.h"
+#include <es_assert.h>
+#include <zlib-1.2.7/zlib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TMX_READER_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TMX_READER_NEON
+#endif
+
+namespace yam2d
+{
+
+namespace
+{
+	const int READ_BUFFER_SIZE = 16*1024;
+	const int DATA_BUFFER_SIZE = 4096;
+	const int MAX_TILESET_TABLE_SIZE = 64*1024;
+	const uint8_t BASE64_INVALID = 0x80;
+
+	bool isSpace(int c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+
+	// Value of base64 character, or BASE64_INVALID for whitespace, padding and other characters.
+	const uint8_t base64Values[256] = 
+	{
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3e, 0x80, 0x80, 0x80, 0x3f,
+		0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+		0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+		0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+		0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+	};
+
+	bool isLittleEndian()
+	{
+		const uint32_t one = 1;
+		return *(const uint8_t*)&one == 1;
+	}
+
+#if defined(TMX_READER_SSE2)
+	// Characters and bytes decoded at a time by decodeBase64Block, and bytes it writes to output.
+	const int BASE64_BLOCK_CHARS = 16;
+	const int BASE64_BLOCK_BYTES = 12;
+	const int BASE64_BLOCK_STORE = 16;
+
+	// Returns mask of bytes between lo and hi. Bytes above 127 are negative, so they are never in range.
+	inline __m128i inRange(__m128i c, char lo, char hi)
+	{
+		return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(char(lo-1))), _mm_cmplt_epi8(c, _mm_set1_epi8(char(hi+1))));
+	}
+
+	// Decodes block of base64 characters to bytes. Returns false without writing anything, if the block has 
+	// whitespace, padding or other characters, which are not part of base64 alphabet.
+	bool decodeBase64Block(const uint8_t* input, uint8_t* output)
+	{
+		const __m128i c = _mm_loadu_si128((const __m128i*)input);
+		const __m128i upper = inRange(c, 'A', 'Z');
+		const __m128i lower = inRange(c, 'a', 'z');
+		const __m128i digit = inRange(c, '0', '9');
+		const __m128i plus = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+		const __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+		const __m128i valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)), slash);
+		if( _mm_movemask_epi8(valid) != 0xffff )
+		{
+			return false;
+		}
+
+		// Character to its 6 bit value by adding offset of its range.
+		__m128i offset = _mm_and_si128(upper, _mm_set1_epi8(char(-'A')));
+		offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(char(26-'a'))));
+		offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(char(52-'0'))));
+		offset = _mm_or_si128(offset, _mm_and_si128(plus, _mm_set1_epi8(char(62-'+'))));
+		offset = _mm_or_si128(offset, _mm_and_si128(slash, _mm_set1_epi8(char(63-'/'))));
+		const __m128i v = _mm_add_epi8(c, offset);
+
+		// Each 32 bit lane has values a, b, c and d from lowest byte up. Merge them to a<<18 | b<<12 | c<<6 | d.
+		const __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00ff)), 6), _mm_srli_epi16(v, 8));
+		const __m128i values = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(pairs, _mm_set1_epi32(0xffff)), 12), _mm_srli_epi32(pairs, 16));
+
+		// Swap bytes of each value to output order and pack 12 bytes of the four lanes to the start of the register. 
+		// Four bytes after them are written too, so output must have room for BASE64_BLOCK_STORE bytes.
+		const __m128i swapped = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(values, 16), _mm_and_si128(values, _mm_set1_epi32(0xff00))),
+			_mm_slli_epi32(_mm_and_si128(values, _mm_set1_epi32(0xff)), 16));
+		const __m128i pairs64 = _mm_or_si128(_mm_and_si128(swapped, _mm_set_epi32(0, 0x00ffffff, 0, 0x00ffffff)),
+			_mm_and_si128(_mm_srli_epi64(swapped, 8), _mm_set_epi32(0x0000ffff, int(0xff000000), 0x0000ffff, int(0xff000000))));
+		const __m128i packed = _mm_or_si128(_mm_and_si128(pairs64, _mm_set_epi32(0, 0, 0x0000ffff, -1)),
+			_mm_and_si128(_mm_srli_si128(pairs64, 2), _mm_set_epi32(0, -1, int(0xffff0000), 0)));
+		_mm_storeu_si128((__m128i*)output, packed);
+		return true;
+	}
+#elif defined(TMX_READER_NEON)
+	const int BASE64_BLOCK_CHARS = 64;
+	const int BASE64_BLOCK_BYTES = 48;
+	const int BASE64_BLOCK_STORE = 48;
+
+	inline uint8x16_t inRange(uint8x16_t c, uint8_t lo, uint8_t hi)
+	{
+		return vandq_u8(vcgeq_u8(c, vdupq_n_u8(lo)), vcleq_u8(c, vdupq_n_u8(hi)));
+	}
+
+	// Returns 6 bit values of base64 characters and adds characters not in base64 alphabet to invalid.
+	inline uint8x16_t getBase64Values(uint8x16_t c, uint8x16_t& invalid)
+	{
+		const uint8x16_t upper = inRange(c, 'A', 'Z');
+		const uint8x16_t lower = inRange(c, 'a', 'z');
+		const uint8x16_t digit = inRange(c, '0', '9');
+		const uint8x16_t plus = vceqq_u8(c, vdupq_n_u8('+'));
+		const uint8x16_t slash = vceqq_u8(c, vdupq_n_u8('/'));
+		const uint8x16_t valid = vorrq_u8(vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(digit, plus)), slash);
+		invalid = vorrq_u8(invalid, vmvnq_u8(valid));
+
+		uint8x16_t offset = vandq_u8(upper, vdupq_n_u8(uint8_t(-'A')));
+		offset = vorrq_u8(offset, vandq_u8(lower, vdupq_n_u8(uint8_t(26-'a'))));
+		offset = vorrq_u8(offset, vandq_u8(digit, vdupq_n_u8(uint8_t(52-'0'))));
+		offset = vorrq_u8(offset, vandq_u8(plus, vdupq_n_u8(uint8_t(62-'+'))));
+		offset = vorrq_u8(offset, vandq_u8(slash, vdupq_n_u8(uint8_t(63-'/'))));
+		return vaddq_u8(c, offset);
+	}
+
+	// Decodes block of base64 characters to bytes. Loads deinterleave characters of 16 groups of four and stores
+	// interleave their three bytes. Returns false without writing anything, if the block has other characters.
+	bool decodeBase64Block(const uint8_t* input, uint8_t* output)
+	{
+		const uint8x16x4_t c = vld4q_u8(input);
+		uint8x16_t invalid = vdupq_n_u8(0);
+		const uint8x16_t a = getBase64Values(c.val[0], invalid);
+		const uint8x16_t b = getBase64Values(c.val[1], invalid);
+		const uint8x16_t d = getBase64Values(c.val[2], invalid);
+		const uint8x16_t e = getBase64Values(c.val[3], invalid);
+		const uint64x2_t mask = vreinterpretq_u64_u8(invalid);
+		if( (vgetq_lane_u64(mask, 0) | vgetq_lane_u64(mask, 1)) != 0 )
+		{
+			return false;
+		}
+
+		uint8x16x3_t bytes;
+		bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+		bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(d, 2));
+		bytes.val[2] = vorrq_u8(vshlq_n_u8(d, 6), e);
+		vst3q_u8(output, bytes);
+		return true;
+	}
+#endif
+
+	const std::string emptyString;
+}
+
+
+TmxReader::Tileset::Tileset()
+: firstGid(0)
+, name()
+, tileWidth(0)
+, tileHeight(0)
+, margin(0)
+, spacing(0)
+, tileOffsetX(0)
+, tileOffsetY(0)
+, imageSource()
+, imageTransparentColor()
+, imageWidth(0)
+, imageHeight(0)
+, properties()
+, tileProperties()
+{
+}
+
+
+TmxReader::Layer::Layer()
+: name()
+, width(0)
+, height(0)
+, opacity(1.0f)
+, visible(true)
+, properties()
+{
+}
+
+
+TmxReader::Object::Object()
+: name()
+, type()
+, x(0.0f)
+, y(0.0f)
+, width(0.0f)
+, height(0.0f)
+, rotation(0.0f)
+, gid(0)
+, isPolygon(false)
+, isPolyline(false)
+, isEllipse(false)
+, properties()
+{
+}
+
+
+TmxReader::TmxReader(int chunkSize)
+: m_fileName()
+, m_path()
+, m_stream()
+, m_buffer(READ_BUFFER_SIZE)
+, m_bufferPos(0)
+, m_bufferEnd(0)
+, m_chunkSize(chunkSize > 0 ? chunkSize : 1)
+, m_tagName()
+, m_attributes()
+, m_numAttributes(0)
+, m_selfClosing(false)
+, m_elements()
+, m_currentProperties(0)
+, m_events()
+, m_nextEvent(0)
+, m_finalEvent(-1)
+, m_errorText()
+, m_orientation(ORIENTATION_ORTHOGONAL)
+, m_width(0)
+, m_height(0)
+, m_tileWidth(0)
+, m_tileHeight(0)
+, m_properties()
+, m_mapReported(false)
+, m_tilesets()
+, m_tilesetTable()
+, m_currentTileId(0)
+, m_layer()
+, m_objectLayerReported(false)
+, m_object()
+, m_inData(false)
+, m_encoding(ENCODING_XML)
+, m_compressed(false)
+, m_inflateStream(0)
+, m_inflateOutputFull(false)
+, m_dataBytes(DATA_BUFFER_SIZE)
+, m_tiles()
+, m_tilesStartIndex(0)
+, m_numTiles(0)
+, m_value(0)
+, m_valueBytes(0)
+, m_base64Bits(0)
+, m_base64NumBits(0)
+{
+	// One extra element for the partial gid decoded after full chunk.
+	m_tiles.reserve(m_chunkSize + 1);
+}
+
+
+TmxReader::~TmxReader()
+{
+	finishData();
+}
+
+
+bool TmxReader::open(const std::string& fileName)
+{
+	m_fileName = fileName;
+	m_path = getPath(fileName);
+	m_stream = new FileStream(fileName.c_str(), FileStream::READ_ONLY);
+	if( m_stream->available() <= 0 )
+	{
+		m_stream = 0;
+		return false;
+	}
+	return true;
+}
+
+
+TmxReader::Event TmxReader::next()
+{
+	if( m_nextEvent < m_events.size() )
+	{
+		return m_events[m_nextEvent++];
+	}
+
+	if( m_finalEvent >= 0 )
+	{
+		return Event(m_finalEvent);
+	}
+
+	m_events.clear();
+	m_nextEvent = 0;
+	m_tiles.clear();
+
+	if( m_stream.ptr() == 0 )
+	{
+		setError("File is not open");
+	}
+
+	while( m_events.empty() )
+	{
+		if( m_inData && m_encoding != ENCODING_XML )
+		{
+			if( !readTileData() || !m_events.empty() )
+			{
+				break;
+			}
+		}
+
+		switch( readTag() )
+		{
+		case TOKEN_START:
+			if( startElement() && m_selfClosing )
+			{
+				endElement();
+			}
+			break;
+		case TOKEN_END:
+			if( m_elements.empty() || m_elements.back() != m_tagName )
+			{
+				setError("Mismatched end tag </" + m_tagName + ">");
+				break;
+			}
+			endElement();
+			break;
+		case TOKEN_EOF:
+			setError("Unexpected end of file");
+			break;
+		default:
+			setError("Invalid XML");
+			break;
+		}
+	}
+
+	return m_events[m_nextEvent++];
+}
+
+
+int TmxReader::findTilesetIndex(unsigned gid) const
+{
+	gid &= GID_MASK;
+	if( gid < m_tilesetTable.size() )
+	{
+		return m_tilesetTable[gid];
+	}
+
+	if( m_tilesets.empty() || gid >= m_tilesets.back().firstGid )
+	{
+		return (int)m_tilesets.size() - 1;
+	}
+
+	// Tilesets are sorted by first gid, so binary search the last tileset with firstGid <= gid.
+	int first = 0;
+	int last = (int)m_tilesets.size();
+	while( first < last )
+	{
+		int middle = (first + last) / 2;
+		if( m_tilesets[middle].firstGid <= gid )
+		{
+			first = middle + 1;
+		}
+		else
+		{
+			last = middle;
+		}
+	}
+	return first - 1;
+}
+
+
+void TmxReader::updateTilesetTable()
+{
+	// Table covers gids up to the first gid of the last tileset. Larger gids belong to the last tileset.
+	unsigned size = m_tilesets.empty() ? 0 : m_tilesets.back().firstGid + 1;
+	if( size > (unsigned)MAX_TILESET_TABLE_SIZE )
+	{
+		size = MAX_TILESET_TABLE_SIZE;
+	}
+
+	m_tilesetTable.resize(size);
+	int tilesetIndex = -1;
+	for( unsigned gid=0; gid<size; ++gid )
+	{
+		while( tilesetIndex+1 < (int)m_tilesets.size() && m_tilesets[tilesetIndex+1].firstGid <= gid )
+		{
+			++tilesetIndex;
+		}
+		m_tilesetTable[gid] = tilesetIndex;
+	}
+}
+
+
+bool TmxReader::fillBuffer()
+{
+	int numBytes = m_stream->available();
+	if( numBytes <= 0 )
+	{
+		return false;
+	}
+
+	if( numBytes > (int)m_buffer.size() )
+	{
+		numBytes = (int)m_buffer.size();
+	}
+	m_bufferEnd = m_stream->read(&m_buffer[0], numBytes);
+	m_bufferPos = 0;
+	if( m_bufferEnd <= 0 )
+	{
+		m_bufferEnd = 0;
+		return false;
+	}
+	return true;
+}
+
+
+int TmxReader::getChar()
+{
+	if( m_bufferPos == m_bufferEnd && !fillBuffer() )
+	{
+		return -1;
+	}
+
+	return (unsigned char)m_buffer[m_bufferPos++];
+}
+
+
+int TmxReader::peekChar()
+{
+	int c = getChar();
+	if( c >= 0 )
+	{
+		--m_bufferPos;
+	}
+	return c;
+}
+
+
+bool TmxReader::skipUntil(const char* terminator)
+{
+	const int length = (int)strlen(terminator);
+	int matched = 0;
+	while( matched < length )
+	{
+		int c = getChar();
+		if( c < 0 )
+		{
+			return false;
+		}
+
+		if( c == terminator[matched] )
+		{
+			++matched;
+		}
+		else
+		{
+			matched = (c == terminator[0]) ? 1 : 0;
+		}
+	}
+	return true;
+}
+
+
+TmxReader::Token TmxReader::readTag()
+{
+	while( true )
+	{
+		// Skip text content
+		while( true )
+		{
+			if( m_bufferPos == m_bufferEnd && !fillBuffer() )
+			{
+				return TOKEN_EOF;
+			}
+
+			const char* begin = &m_buffer[0];
+			const char* lt = (const char*)memchr(begin + m_bufferPos, '<', m_bufferEnd - m_bufferPos);
+			if( lt != 0 )
+			{
+				m_bufferPos = int(lt - begin) + 1;
+				break;
+			}
+			m_bufferPos = m_bufferEnd;
+		}
+
+		int c = getChar();
+		if( c == '?' )
+		{
+			if( !skipUntil("?>") ) return TOKEN_ERROR;
+			continue;
+		}
+
+		if( c == '!' )
+		{
+			c = peekChar();
+			const char* terminator = (c == '-') ? "-->" : ((c == '[') ? "]]>" : ">");
+			if( !skipUntil(terminator) ) return TOKEN_ERROR;
+			continue;
+		}
+
+		if( c == '/' )
+		{
+			if( !readName(m_tagName) || !skipUntil(">") ) return TOKEN_ERROR;
+			return TOKEN_END;
+		}
+
+		if( c < 0 )
+		{
+			return TOKEN_ERROR;
+		}
+
+		--m_bufferPos;
+		if( !readName(m_tagName) )
+		{
+			return TOKEN_ERROR;
+		}
+
+		// Read attributes
+		m_numAttributes = 0;
+		m_selfClosing = false;
+		while( true )
+		{
+			c = getChar();
+			while( isSpace(c) )
+			{
+				c = getChar();
+			}
+
+			if( c == '>' )
+			{
+				return TOKEN_START;
+			}
+
+			if( c == '/' )
+			{
+				m_selfClosing = true;
+				return (getChar() == '>') ? TOKEN_START : TOKEN_ERROR;
+			}
+
+			if( c < 0 )
+			{
+				return TOKEN_ERROR;
+			}
+
+			--m_bufferPos;
+			if( m_numAttributes == (int)m_attributes.size() )
+			{
+				m_attributes.push_back(Attribute());
+			}
+			Attribute& attribute = m_attributes[m_numAttributes++];
+			if( !readName(attribute.name) )
+			{
+				return TOKEN_ERROR;
+			}
+
+			c = getChar();
+			while( isSpace(c) )
+			{
+				c = getChar();
+			}
+			if( c != '=' )
+			{
+				return TOKEN_ERROR;
+			}
+
+			int quote = getChar();
+			while( isSpace(quote) )
+			{
+				quote = getChar();
+			}
+			if( quote != '"' && quote != '\'' )
+			{
+				return TOKEN_ERROR;
+			}
+
+			attribute.value.clear();
+			bool hasEntities = false;
+			for( c = getChar(); c >= 0 && c != quote; c = getChar() )
+			{
+				hasEntities |= (c == '&');
+				attribute.value += char(c);
+			}
+
+			if( c < 0 )
+			{
+				return TOKEN_ERROR;
+			}
+
+			if( hasEntities )
+			{
+				decodeEntities(attribute.value);
+			}
+		}
+	}
+}
+
+
+bool TmxReader::readName(std::string& name)
+{
+	name.clear();
+	int c = peekChar();
+	while( c >= 0 && !isSpace(c) && c != '=' && c != '>' && c != '/' )
+	{
+		name += char(getChar());
+		c = peekChar();
+	}
+	return !name.empty();
+}
+
+
+void TmxReader::decodeEntities(std::string& value) const
+{
+	std::string result;
+	result.reserve(value.length());
+	for( size_t i=0; i<value.length(); ++i )
+	{
+		size_t end = (value[i] == '&') ? value.find(';', i) : std::string::npos;
+		if( end == std::string::npos )
+		{
+			result += value[i];
+			continue;
+		}
+
+		std::string entity = value.substr(i+1, end-i-1);
+		if( entity == "amp" ) result += '&';
+		else if( entity == "lt" ) result += '<';
+		else if( entity == "gt" ) result += '>';
+		else if( entity == "quot" ) result += '"';
+		else if( entity == "apos" ) result += '\'';
+		else if( entity.length() > 1 && entity[0] == '#' )
+		{
+			unsigned long code = (entity[1] == 'x') ? strtoul(entity.c_str()+2, 0, 16) : strtoul(entity.c_str()+1, 0, 10);
+			// Encode as UTF-8
+			if( code < 0x80 )
+			{
+				result += char(code);
+			}
+			else if( code < 0x800 )
+			{
+				result += char(0xc0 | (code >> 6));
+				result += char(0x80 | (code & 0x3f));
+			}
+			else
+			{
+				result += char(0xe0 | ((code >> 12) & 0x0f));
+				result += char(0x80 | ((code >> 6) & 0x3f));
+				result += char(0x80 | (code & 0x3f));
+			}
+		}
+		else
+		{
+			// Unknown entity, keep as is.
+			result += value.substr(i, end-i+1);
+		}
+		i = end;
+	}
+	value.swap(result);
+}
+
+
+const char* TmxReader::getAttribute(const char* name) const
+{
+	for( int i=0; i<m_numAttributes; ++i )
+	{
+		if( m_attributes[i].name == name )
+		{
+			return m_attributes[i].value.c_str();
+		}
+	}
+	return 0;
+}
+
+
+int TmxReader::getIntAttribute(const char* name, int defaultValue) const
+{
+	const char* value = getAttribute(name);
+	return value ? atoi(value) : defaultValue;
+}
+
+
+float TmxReader::getFloatAttribute(const char* name, float defaultValue) const
+{
+	const char* value = getAttribute(name);
+	return value ? float(atof(value)) : defaultValue;
+}
+
+
+bool TmxReader::startElement()
+{
+	const std::string& parent = m_elements.empty() ? emptyString : m_elements.back();
+	const std::string& name = m_tagName;
+
+	if( parent == "map" && !m_mapReported && name != "properties" )
+	{
+		// Map properties are read, report map before first tileset or layer.
+		m_mapReported = true;
+		pushEvent(EVENT_MAP);
+	}
+
+	if( name == "map" && parent.empty() )
+	{
+		const char* orientation = getAttribute("orientation");
+		m_orientation = (orientation != 0 && strcmp(orientation, "isometric") == 0) ? ORIENTATION_ISOMETRIC : ORIENTATION_ORTHOGONAL;
+		m_width = getIntAttribute("width", 0);
+		m_height = getIntAttribute("height", 0);
+		m_tileWidth = getIntAttribute("tilewidth", 0);
+		m_tileHeight = getIntAttribute("tileheight", 0);
+	}
+	else if( name == "properties" )
+	{
+		m_currentProperties = 0;
+		if( parent == "map" ) m_currentProperties = &m_properties;
+		else if( parent == "tileset" && !m_tilesets.empty() ) m_currentProperties = &m_tilesets.back().properties;
+		else if( parent == "tile" && !m_inData && !m_tilesets.empty() ) m_currentProperties = &m_tilesets.back().tileProperties[m_currentTileId];
+		else if( parent == "layer" || parent == "objectgroup" ) m_currentProperties = &m_layer.properties;
+		else if( parent == "object" ) m_currentProperties = &m_object.properties;
+	}
+	else if( name == "property" )
+	{
+		const char* propertyName = getAttribute("name");
+		const char* propertyValue = getAttribute("value");
+		if( parent == "properties" && m_currentProperties != 0 && propertyName != 0 )
+		{
+			(*m_currentProperties)[propertyName] = propertyValue ? propertyValue : "";
+		}
+	}
+	else if( name == "tileset" && (parent == "map" || parent.empty()) )
+	{
+		m_tilesets.push_back(Tileset());
+		Tileset& tileset = m_tilesets.back();
+		const char* source = getAttribute("source");
+		if( source != 0 )
+		{
+			// External tileset. Source is relative to the map file.
+			if( !readExternalTileset(m_path + source, tileset) )
+			{
+				setError("External tileset " + m_path + source + " could not be read");
+				return false;
+			}
+		}
+		else
+		{
+			tileset.name = getAttribute("name") ? getAttribute("name") : "";
+			tileset.tileWidth = getIntAttribute("tilewidth", 0);
+			tileset.tileHeight = getIntAttribute("tileheight", 0);
+			tileset.margin = getIntAttribute("margin", 0);
+			tileset.spacing = getIntAttribute("spacing", 0);
+		}
+		tileset.firstGid = (unsigned)getIntAttribute("firstgid", 1);
+	}
+	else if( name == "image" && parent == "tileset" && !m_tilesets.empty() )
+	{
+		Tileset& tileset = m_tilesets.back();
+		tileset.imageSource = getAttribute("source") ? getAttribute("source") : "";
+		tileset.imageTransparentColor = getAttribute("trans") ? getAttribute("trans") : "";
+		tileset.imageWidth = getIntAttribute("width", 0);
+		tileset.imageHeight = getIntAttribute("height", 0);
+	}
+	else if( name == "tileoffset" && parent == "tileset" && !m_tilesets.empty() )
+	{
+		m_tilesets.back().tileOffsetX = getIntAttribute("x", 0);
+		m_tilesets.back().tileOffsetY = getIntAttribute("y", 0);
+	}
+	else if( name == "tile" && parent == "tileset" )
+	{
+		m_currentTileId = (unsigned)getIntAttribute("id", 0);
+	}
+	else if( name == "tile" && parent == "data" && m_inData )
+	{
+		const char* gid = getAttribute("gid");
+		addGid(gid ? (uint32_t)strtoul(gid, 0, 10) : 0);
+		if( (int)m_tiles.size() >= m_chunkSize )
+		{
+			flushTiles();
+		}
+	}
+	else if( (name == "layer" || name == "objectgroup") && parent == "map" )
+	{
+		m_layer = Layer();
+		m_layer.name = getAttribute("name") ? getAttribute("name") : "";
+		m_layer.width = getIntAttribute("width", 0);
+		m_layer.height = getIntAttribute("height", 0);
+		m_layer.opacity = getFloatAttribute("opacity", 1.0f);
+		m_layer.visible = getIntAttribute("visible", 1) != 0;
+		m_objectLayerReported = false;
+	}
+	else if( name == "data" && parent == "layer" )
+	{
+		const char* encoding = getAttribute("encoding");
+		const char* compression = getAttribute("compression");
+		m_encoding = ENCODING_XML;
+		if( encoding != 0 && strcmp(encoding, "base64") == 0 ) m_encoding = ENCODING_BASE64;
+		else if( encoding != 0 && strcmp(encoding, "csv") == 0 ) m_encoding = ENCODING_CSV;
+
+		m_compressed = false;
+		if( compression != 0 )
+		{
+			if( m_encoding != ENCODING_BASE64 || (strcmp(compression, "zlib") != 0 && strcmp(compression, "gzip") != 0) )
+			{
+				setError(std::string("Unsupported tile layer compression: ") + compression);
+				return false;
+			}
+
+			// zlib and gzip headers are detected automatically.
+			z_stream* stream = new z_stream;
+			memset(stream, 0, sizeof(z_stream));
+			if( inflateInit2(stream, 15 + 32) != Z_OK )
+			{
+				delete stream;
+				setError("Could not initialize zlib");
+				return false;
+			}
+			m_inflateStream = stream;
+			m_compressed = true;
+		}
+
+		m_inData = !m_selfClosing;
+		m_inflateOutputFull = false;
+		m_numTiles = 0;
+		m_value = 0;
+		m_valueBytes = 0;
+		m_base64Bits = 0;
+		m_base64NumBits = 0;
+		pushEvent(EVENT_TILE_LAYER);
+	}
+	else if( name == "object" && parent == "objectgroup" )
+	{
+		if( !m_objectLayerReported )
+		{
+			m_objectLayerReported = true;
+			pushEvent(EVENT_OBJECT_LAYER);
+		}
+
+		m_object = Object();
+		m_object.name = getAttribute("name") ? getAttribute("name") : "";
+		m_object.type = getAttribute("type") ? getAttribute("type") : "";
+		m_object.x = getFloatAttribute("x", 0.0f);
+		m_object.y = getFloatAttribute("y", 0.0f);
+		m_object.width = getFloatAttribute("width", 0.0f);
+		m_object.height = getFloatAttribute("height", 0.0f);
+		m_object.rotation = getFloatAttribute("rotation", 0.0f);
+		m_object.gid = getAttribute("gid") ? (unsigned)strtoul(getAttribute("gid"), 0, 10) : 0;
+	}
+	else if( parent == "object" )
+	{
+		m_object.isPolygon |= (name == "polygon");
+		m_object.isPolyline |= (name == "polyline");
+		m_object.isEllipse |= (name == "ellipse");
+	}
+
+	m_elements.push_back(name);
+	return true;
+}
+
+
+bool TmxReader::endElement()
+{
+	assert( !m_elements.empty() );
+	std::string name = m_elements.back();
+	m_elements.pop_back();
+	const std::string& parent = m_elements.empty() ? emptyString : m_elements.back();
+
+	if( name == "properties" )
+	{
+		m_currentProperties = 0;
+	}
+	else if( name == "tileset" && (parent == "map" || parent.empty()) )
+	{
+		updateTilesetTable();
+		pushEvent(EVENT_TILESET);
+	}
+	else if( name == "data" && parent == "layer" )
+	{
+		finishData();
+		flushTiles();
+	}
+	else if( name == "object" && parent == "objectgroup" )
+	{
+		pushEvent(EVENT_OBJECT);
+	}
+	else if( name == "objectgroup" && parent == "map" && !m_objectLayerReported )
+	{
+		// Empty object layer
+		m_objectLayerReported = true;
+		pushEvent(EVENT_OBJECT_LAYER);
+	}
+	else if( name == "map" && parent.empty() )
+	{
+		if( !m_mapReported )
+		{
+			m_mapReported = true;
+			pushEvent(EVENT_MAP);
+		}
+		pushEvent(EVENT_END);
+		m_finalEvent = EVENT_END;
+	}
+	return true;
+}
+
+
+bool TmxReader::readTileData()
+{
+	bool result = true;
+	if( m_encoding == ENCODING_CSV )
+	{
+		readCsv();
+	}
+	else
+	{
+		assert( m_encoding == ENCODING_BASE64 );
+		result = readBase64Tiles();
+	}
+
+	if( (int)m_tiles.size() >= m_chunkSize )
+	{
+		flushTiles();
+	}
+	return result;
+}
+
+
+void TmxReader::readCsv()
+{
+	while( (int)m_tiles.size() < m_chunkSize )
+	{
+		if( m_bufferPos == m_bufferEnd && !fillBuffer() )
+		{
+			return;
+		}
+
+		// Parse straight from the read buffer.
+		const char* data = &m_buffer[0];
+		int pos = m_bufferPos;
+		uint32_t value = m_value;
+		int numDigits = m_valueBytes;
+		bool endOfData = false;
+		while( pos < m_bufferEnd && (int)m_tiles.size() < m_chunkSize )
+		{
+			const char c = data[pos];
+			if( c == '<' )
+			{
+				endOfData = true;
+				break;
+			}
+			++pos;
+
+			const unsigned digit = unsigned((unsigned char)c) - unsigned('0');
+			if( digit < 10 )
+			{
+				value = value*10 + digit;
+				++numDigits;
+			}
+			else if( numDigits > 0 )
+			{
+				addGid(value);
+				value = 0;
+				numDigits = 0;
+			}
+		}
+
+		m_bufferPos = pos;
+		m_value = value;
+		m_valueBytes = numDigits;
+		if( endOfData )
+		{
+			return;
+		}
+	}
+}
+
+
+bool TmxReader::readBase64Tiles()
+{
+	const int numOldTiles = (int)m_tiles.size();
+	if( numOldTiles >= m_chunkSize )
+	{
+		return true;
+	}
+
+	// Tile bytes are decoded or inflated straight into tile storage. Bytes of gid, which did not
+	// fit to previous chunk, are kept in m_value and are copied to the beginning of the storage.
+	m_tiles.resize(m_chunkSize + 1);
+	uint8_t* tileBytes = (uint8_t*)&m_tiles[0];
+	const int maxBytes = m_chunkSize*4;
+	int numBytes = numOldTiles*4;
+	memcpy(tileBytes + numBytes, &m_value, m_valueBytes);
+	numBytes += m_valueBytes;
+
+	bool result = true;
+	while( numBytes < maxBytes )
+	{
+		if( !m_compressed )
+		{
+			const int numDecoded = readBase64(tileBytes + numBytes, maxBytes - numBytes);
+			if( numDecoded == 0 )
+			{
+				break;
+			}
+			numBytes += numDecoded;
+			continue;
+		}
+
+		z_stream* stream = (z_stream*)m_inflateStream;
+		if( stream != 0 && (stream->avail_in > 0 || m_inflateOutputFull) )
+		{
+			const int numInflated = inflateData(tileBytes + numBytes, maxBytes - numBytes);
+			if( numInflated < 0 )
+			{
+				result = false;
+				break;
+			}
+			numBytes += numInflated;
+			continue;
+		}
+
+		const int numDecoded = readBase64(&m_dataBytes[0], (int)m_dataBytes.size());
+		if( numDecoded == 0 )
+		{
+			break;
+		}
+
+		if( stream != 0 )
+		{
+			stream->next_in = &m_dataBytes[0];
+			stream->avail_in = numDecoded;
+		}
+		// else: Bytes after end of compressed stream are ignored.
+	}
+
+	// Keep bytes of the last partial gid for the next chunk.
+	const int numTiles = numBytes / 4;
+	m_valueBytes = numBytes % 4;
+	m_value = 0;
+	memcpy(&m_value, tileBytes + numTiles*4, m_valueBytes);
+
+	if( !isLittleEndian() )
+	{
+		// Gids are little endian 32 bit integers.
+		for( int i=numOldTiles; i<numTiles; ++i )
+		{
+			const uint8_t* bytes = tileBytes + i*4;
+			m_tiles[i] = uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+		}
+	}
+
+	// Tiles beyond layer size are ignored.
+	int numNewTiles = numTiles - numOldTiles;
+	const int numTilesLeft = m_layer.width*m_layer.height - m_numTiles;
+	if( numNewTiles > numTilesLeft )
+	{
+		numNewTiles = numTilesLeft > 0 ? numTilesLeft : 0;
+	}
+	m_tiles.resize(numOldTiles + numNewTiles);
+	m_numTiles += numNewTiles;
+	return result;
+}
+
+
+int TmxReader::readBase64(uint8_t* output, int maxBytes)
+{
+	int numBytes = 0;
+	while( numBytes < maxBytes )
+	{
+		if( m_bufferPos == m_bufferEnd && !fillBuffer() )
+		{
+			break;
+		}
+
+		// Decode straight from the read buffer.
+		const uint8_t* data = (const uint8_t*)&m_buffer[0];
+		int pos = m_bufferPos;
+		const int end = m_bufferEnd;
+		uint32_t bits = m_base64Bits;
+		int numBits = m_base64NumBits;
+		bool endOfData = false;
+		while( pos < end && numBytes < maxBytes )
+		{
+#if defined(TMX_READER_SSE2) || defined(TMX_READER_NEON)
+			// SIMD path: block of valid characters at a time.
+			if( numBits == 0 && pos + BASE64_BLOCK_CHARS <= end && numBytes + BASE64_BLOCK_STORE <= maxBytes
+				&& decodeBase64Block(data + pos, output + numBytes) )
+			{
+				numBytes += BASE64_BLOCK_BYTES;
+				pos += BASE64_BLOCK_CHARS;
+				continue;
+			}
+#endif
+
+			// Fast path: four valid characters to three bytes.
+			if( numBits == 0 && pos + 4 <= end && numBytes + 3 <= maxBytes )
+			{
+				const uint32_t a = base64Values[data[pos]];
+				const uint32_t b = base64Values[data[pos+1]];
+				const uint32_t c = base64Values[data[pos+2]];
+				const uint32_t d = base64Values[data[pos+3]];
+				if( ((a | b | c | d) & BASE64_INVALID) == 0 )
+				{
+					const uint32_t value = (a << 18) | (b << 12) | (c << 6) | d;
+					output[numBytes] = uint8_t(value >> 16);
+					output[numBytes+1] = uint8_t(value >> 8);
+					output[numBytes+2] = uint8_t(value);
+					numBytes += 3;
+					pos += 4;
+					continue;
+				}
+			}
+
+			// Slow path: whitespace, padding or end of data.
+			const uint8_t c = data[pos];
+			if( c == '<' )
+			{
+				endOfData = true;
+				break;
+			}
+			++pos;
+
+			const uint32_t value = base64Values[c];
+			if( value & BASE64_INVALID )
+			{
+				continue;
+			}
+
+			bits = (bits << 6) | value;
+			numBits += 6;
+			if( numBits >= 8 )
+			{
+				numBits -= 8;
+				output[numBytes++] = uint8_t(bits >> numBits);
+				bits &= (1u << numBits) - 1;
+			}
+		}
+
+		m_bufferPos = pos;
+		m_base64Bits = bits;
+		m_base64NumBits = numBits;
+		if( endOfData )
+		{
+			break;
+		}
+	}
+	return numBytes;
+}
+
+
+int TmxReader::inflateData(uint8_t* output, int maxBytes)
+{
+	z_stream* stream = (z_stream*)m_inflateStream;
+	assert( stream != 0 );
+
+	stream->next_out = output;
+	stream->avail_out = maxBytes;
+	uInt availIn = stream->avail_in;
+	int result = inflate(stream, Z_NO_FLUSH);
+	int numBytes = maxBytes - (int)stream->avail_out;
+	m_inflateOutputFull = stream->avail_out == 0;
+
+	if( result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR )
+	{
+		setError("Corrupted compressed tile layer data");
+		return -1;
+	}
+
+	if( result == Z_BUF_ERROR && numBytes == 0 && stream->avail_in == availIn && !m_inflateOutputFull )
+	{
+		// No progress possible. Wait for more input.
+		m_inflateOutputFull = false;
+		if( stream->avail_in > 0 )
+		{
+			setError("Corrupted compressed tile layer data");
+			return -1;
+		}
+	}
+
+	if( result == Z_STREAM_END )
+	{
+		inflateEnd(stream);
+		delete stream;
+		m_inflateStream = 0;
+		m_inflateOutputFull = false;
+	}
+	return numBytes;
+}
+
+
+void TmxReader::addGid(uint32_t gid)
+{
+	if( m_numTiles < m_layer.width*m_layer.height )
+	{
+		m_tiles.push_back(gid);
+		++m_numTiles;
+	}
+}
+
+
+void TmxReader::flushTiles()
+{
+	if( !m_tiles.empty() )
+	{
+		m_tilesStartIndex = m_numTiles - (int)m_tiles.size();
+		pushEvent(EVENT_TILES);
+	}
+}
+
+
+void TmxReader::finishData()
+{
+	if( m_inData && m_encoding == ENCODING_CSV && m_valueBytes > 0 )
+	{
+		addGid(m_value);
+	}
+
+	if( m_inflateStream != 0 )
+	{
+		z_stream* stream = (z_stream*)m_inflateStream;
+		inflateEnd(stream);
+		delete stream;
+		m_inflateStream = 0;
+	}
+
+	m_inData = false;
+	m_inflateOutputFull = false;
+	m_value = 0;
+	m_valueBytes = 0;
+}
+
+
+bool TmxReader::readExternalTileset(const std::string& fileName, Tileset& tileset)
+{
+	TmxReader reader(m_chunkSize);
+	if( !reader.open(fileName) )
+	{
+		return false;
+	}
+
+	Event event = reader.next();
+	while( event != EVENT_TILESET && event != EVENT_END && event != EVENT_ERROR )
+	{
+		event = reader.next();
+	}
+
+	if( event != EVENT_TILESET )
+	{
+		return false;
+	}
+
+	tileset = reader.getTileset();
+	return true;
+}
+
+
+void TmxReader::setError(const std::string& text)
+{
+	m_errorText = text;
+	m_events.push_back(EVENT_ERROR);
+	m_finalEvent = EVENT_ERROR;
+}
+
+}
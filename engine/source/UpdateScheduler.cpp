@@ -0,0 +1,343 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+#include <UpdateScheduler.h>
+#include <Layer.h>
+#include <Camera.h>
+#include <Profiler.h>
+#include <es_assert.h>
+#include <algorithm>
+
+namespace yam2d
+{
+
+namespace
+{
+	template<class Band>
+	bool compareMinDistance(const Band& a, const Band& b)
+	{
+		return a.minDistanceSquared < b.minDistanceSquared;
+	}
+
+	float distanceSquared(const vec2& a, const vec2& b)
+	{
+		float dx = a.x - b.x;
+		float dy = a.y - b.y;
+		return dx*dx + dy*dy;
+	}
+}
+
+class UpdateScheduler::ParallelUpdate : public JobSystem::RangeFunction
+{
+public:
+	ParallelUpdate(UpdateScheduler* scheduler) : m_scheduler(scheduler) {}
+
+	virtual void execute(int begin, int end)
+	{
+		m_scheduler->runParallelTasks(begin, end);
+	}
+
+private:
+	UpdateScheduler* m_scheduler;
+};
+
+UpdateScheduler::UpdateScheduler()
+	: Object()
+	, m_bands()
+	, m_pointsOfInterest()
+	, m_positions()
+	, m_components()
+	, m_lodComponents()
+	, m_parallelComponents()
+	, m_parallelTasks()
+	, m_jobSystem()
+	, m_commandBuffers(1, new CommandBuffer())
+	, m_numObjects(0)
+	, m_useCamera(true)
+	, m_frameIndex(0)
+	, m_lastLodPhase(0)
+	, m_numUpdated(0)
+	, m_numDelayed(0)
+{
+}
+
+UpdateScheduler::~UpdateScheduler()
+{
+}
+
+void UpdateScheduler::addBand(float minDistance, int interval)
+{
+	assert( minDistance >= 0.0f );
+	assert( interval >= 1 );
+	Band band;
+	band.minDistanceSquared = minDistance*minDistance;
+	band.interval = interval;
+	m_bands.push_back(band);
+	std::stable_sort(m_bands.begin(), m_bands.end(), compareMinDistance<Band>);
+}
+
+void UpdateScheduler::clearBands()
+{
+	m_bands.clear();
+}
+
+void UpdateScheduler::addPointOfInterest(GameObject* gameObject)
+{
+	assert( gameObject != 0 );
+	m_pointsOfInterest.push_back(gameObject);
+}
+
+void UpdateScheduler::removePointOfInterest(GameObject* gameObject)
+{
+	for( size_t i=0; i<m_pointsOfInterest.size(); ++i )
+	{
+		if( m_pointsOfInterest[i].ptr() == gameObject )
+		{
+			m_pointsOfInterest.erase(m_pointsOfInterest.begin()+i);
+			return;
+		}
+	}
+}
+
+void UpdateScheduler::beginFrame(Camera* camera)
+{
+	++m_frameIndex;
+	m_numObjects = 0;
+	m_numUpdated = 0;
+	m_numDelayed = 0;
+
+	m_positions.clear();
+	if( m_useCamera && camera != 0 )
+	{
+		m_positions.push_back(camera->getPosition());
+	}
+
+	for( size_t i=0; i<m_pointsOfInterest.size(); ++i )
+	{
+		m_positions.push_back(m_pointsOfInterest[i]->getPosition());
+	}
+}
+
+int UpdateScheduler::getInterval(const vec2& position) const
+{
+	if( m_bands.empty() || m_positions.empty() )
+	{
+		return 1;
+	}
+
+	float nearestSquared = distanceSquared(m_positions[0], position);
+	for( size_t i=1; i<m_positions.size(); ++i )
+	{
+		float squared = distanceSquared(m_positions[i], position);
+		if( squared < nearestSquared )
+		{
+			nearestSquared = squared;
+		}
+	}
+
+	for( size_t i=m_bands.size(); i>0; --i )
+	{
+		if( nearestSquared >= m_bands[i-1].minDistanceSquared )
+		{
+			return m_bands[i-1].interval;
+		}
+	}
+
+	return 1;
+}
+
+void UpdateScheduler::updateLayer(Layer* layer, float deltaTime)
+{
+	YAM2D_PROFILE_ZONE("UpdateScheduler::updateLayer");
+	CommandBuffer* commandBuffer = getCommandBuffer();
+	m_parallelComponents.clear();
+	m_parallelTasks.clear();
+
+	Layer::GameObjectList& gameObjects = layer->getGameObjects();
+	for( size_t i=0; i<gameObjects.size(); ++i )
+	{
+		GameObject* gameObject = gameObjects[i];
+		gameObject->getComponentsOfInterface<Updatable>(m_components);
+		m_lodComponents.resize(m_components.size());
+		bool hasLodComponents = false;
+		for( size_t j=0; j<m_components.size(); ++j )
+		{
+			m_lodComponents[j] = dynamic_cast<LodUpdatable*>(m_components[j]);
+			hasLodComponents = hasLodComponents || m_lodComponents[j] != 0;
+		}
+
+		// Band is needed only for objects with LodUpdatable components. Objects take turns by their phase, so 
+		// only every interval:th object of a band is updated on each frame. Phases are given in order of first 
+		// update and never change, so objects added to or deleted from the layer do not shift turns of others.
+		bool lodUpdateDue = true;
+		if( hasLodComponents )
+		{
+			if( gameObject->m_lodPhase == 0 )
+			{
+				// 0 means not scheduled yet.
+				if( ++m_lastLodPhase == 0 )
+				{
+					++m_lastLodPhase;
+				}
+				gameObject->m_lodPhase = m_lastLodPhase;
+			}
+
+			unsigned interval = unsigned(getInterval(gameObject->getPosition()));
+			lodUpdateDue = interval == 1 || ((m_frameIndex + gameObject->m_lodPhase) % interval) == 0;
+		}
+
+		float lodDeltaTime = gameObject->m_delayedUpdateTime + deltaTime;
+		if( hasLodComponents )
+		{
+			if( lodUpdateDue )
+			{
+				gameObject->m_delayedUpdateTime = 0.0f;
+				++m_numUpdated;
+			}
+			else
+			{
+				gameObject->m_delayedUpdateTime = lodDeltaTime;
+				++m_numDelayed;
+			}
+		}
+
+		// Each game object gets two sort keys: one for commands of serial and one for parallel components.
+		const unsigned sortKey = 2*m_numObjects++;
+		commandBuffer->setSortKey(sortKey);
+
+		ParallelTask task;
+		task.gameObject = gameObject;
+		task.sortKey = sortKey + 1;
+		task.firstComponent = (int)m_parallelComponents.size();
+		task.numComponents = 0;
+		for( size_t j=0; j<m_components.size(); ++j )
+		{
+			if( m_lodComponents[j] != 0 && !lodUpdateDue )
+			{
+				continue;
+			}
+
+			const float componentDeltaTime = (m_lodComponents[j] != 0) ? lodDeltaTime : deltaTime;
+			if( dynamic_cast<ParallelUpdatable*>(m_components[j]) != 0 )
+			{
+				ParallelComponent parallelComponent;
+				parallelComponent.component = m_components[j];
+				parallelComponent.deltaTime = componentDeltaTime;
+				m_parallelComponents.push_back(parallelComponent);
+				++task.numComponents;
+			}
+			else
+			{
+				m_components[j]->update(componentDeltaTime);
+			}
+		}
+
+		if( task.numComponents > 0 )
+		{
+			m_parallelTasks.push_back(task);
+		}
+	}
+	commandBuffer->setSortKey(CommandBuffer::UNSCHEDULED);
+
+	const int numTasks = (int)m_parallelTasks.size();
+	if( numTasks == 0 )
+	{
+		return;
+	}
+
+	// Components move their game objects from several threads, so broadphase only marks them moved. Moves are 
+	// applied in order of the game objects also without job system, so that results do not depend on threads.
+	Broadphase* broadphase = layer->getBroadphase();
+	if( broadphase != 0 )
+	{
+		broadphase->setDeferUpdates(true);
+	}
+
+	if( m_jobSystem != 0 )
+	{
+		ParallelUpdate parallelUpdate(this);
+		m_jobSystem->parallelFor(0, numTasks, 32, &parallelUpdate);
+	}
+	else
+	{
+		runParallelTasks(0, numTasks);
+	}
+
+	if( broadphase != 0 )
+	{
+		YAM2D_PROFILE_ZONE("UpdateScheduler::flushBroadphase");
+		for( int i=0; i<numTasks; ++i )
+		{
+			broadphase->flushGameObject(m_parallelTasks[i].gameObject);
+		}
+		broadphase->setDeferUpdates(false);
+	}
+}
+
+void UpdateScheduler::setJobSystem(JobSystem* jobSystem)
+{
+	for( size_t i=0; i<m_commandBuffers.size(); ++i )
+	{
+		assert( m_commandBuffers[i]->isEmpty() ); // Commands must be applied before changing threads.
+	}
+
+	m_jobSystem = jobSystem;
+	const int numThreads = (jobSystem != 0) ? jobSystem->getNumWorkers() + 1 : 1;
+	m_commandBuffers.resize(numThreads);
+	for( int i=0; i<numThreads; ++i )
+	{
+		if( m_commandBuffers[i] == 0 )
+		{
+			m_commandBuffers[i] = new CommandBuffer();
+		}
+	}
+}
+
+CommandBuffer* UpdateScheduler::getCommandBuffer()
+{
+	return m_commandBuffers[(m_jobSystem != 0) ? m_jobSystem->getCurrentThreadIndex() : 0];
+}
+
+void UpdateScheduler::applyCommands(Map* map)
+{
+	YAM2D_PROFILE_ZONE("UpdateScheduler::applyCommands");
+	CommandBuffer::apply(map, m_commandBuffers);
+}
+
+void UpdateScheduler::runParallelTasks(int begin, int end)
+{
+	YAM2D_PROFILE_ZONE("UpdateScheduler::runParallelTasks");
+	CommandBuffer* commandBuffer = getCommandBuffer();
+	for( int i=begin; i<end; ++i )
+	{
+		const ParallelTask& task = m_parallelTasks[i];
+		commandBuffer->setSortKey(task.sortKey);
+		for( int j=0; j<task.numComponents; ++j )
+		{
+			const ParallelComponent& parallelComponent = m_parallelComponents[task.firstComponent + j];
+			parallelComponent.component->update(parallelComponent.deltaTime);
+		}
+	}
+	commandBuffer->setSortKey(CommandBuffer::UNSCHEDULED);
+}
+
+}
@@ -1,6 +1,7 @@
 #include "../../include/XBOXController.h"
 #include "vec2.h"
 #include <es_util.h>
+#include <Logger.h>
 
 
 
@@ -15,7 +16,7 @@ XBOXController::~XBOXController(void)
 {
 	if (joyReleaseCapture(m_joyID))
 	{
-		yam2d::esLogMessage("Joystick(%d) release fails", m_joyID);
+		YAM2D_LOG_WARNING(yam2d::Logger::CATEGORY_ENGINE, "Joystick(%d) release fails", m_joyID);
 	}
 }
 
@@ -66,27 +67,27 @@ bool XBOXController::isConnected()
 		}
 		else if (MMSYSERR_NODRIVER == res)
 		{
-			yam2d::esLogMessage("Joystick(%d) The joystick driver is not present.", m_joyID);
+			YAM2D_LOG_WARNING(yam2d::Logger::CATEGORY_ENGINE, "Joystick(%d) The joystick driver is not present.", m_joyID);
 		}
 		else if (MMSYSERR_INVALPARAM == res)
 		{
-			yam2d::esLogMessage("Joystick(%d) An invalid parameter was passed.", m_joyID);
+			YAM2D_LOG_WARNING(yam2d::Logger::CATEGORY_ENGINE, "Joystick(%d) An invalid parameter was passed.", m_joyID);
 		}
 		else if (MMSYSERR_BADDEVICEID == res)
 		{
-			yam2d::esLogMessage("Joystick(%d) The specified joystick identifier is invalid.", m_joyID);
+			YAM2D_LOG_WARNING(yam2d::Logger::CATEGORY_ENGINE, "Joystick(%d) The specified joystick identifier is invalid.", m_joyID);
 		}
 		else if (JOYERR_UNPLUGGED == res)
 		{
-			yam2d::esLogMessage("Joystick(%d) The specified joystick is not connected to the system.", m_joyID);
+			YAM2D_LOG_WARNING(yam2d::Logger::CATEGORY_ENGINE, "Joystick(%d) The specified joystick is not connected to the system.", m_joyID);
 		}
 		else if (JOYERR_PARMS == res)
 		{
-			yam2d::esLogMessage("Joystick(%d) The specified joystick identifier is invalid.", m_joyID);
+			YAM2D_LOG_WARNING(yam2d::Logger::CATEGORY_ENGINE, "Joystick(%d) The specified joystick identifier is invalid.", m_joyID);
 		}
 		else
 		{
-			yam2d::esLogMessage("Joystick(%d) unknown error", m_joyID);
+			YAM2D_LOG_WARNING(yam2d::Logger::CATEGORY_ENGINE, "Joystick(%d) unknown error", m_joyID);
 		}
 	}
 
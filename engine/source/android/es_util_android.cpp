@@ -28,6 +28,8 @@
 #include <es_util.h>
 #include <es_assert.h>
 #include <ElapsedTimer.h>
+#include <Profiler.h>
+#include <RenderStats.h>
 #include <config.h>
 #include "Input.h"
 #define LOGI(...) ((void)__android_log_print(ANDROID_LOG_INFO, "native-activity", __VA_ARGS__))
@@ -212,6 +214,7 @@ static void engine_draw_frame(ESContext* engine)
         return;
     }
 
+	YAM2D_PROFILE_ZONE("draw");
 	if( engine->drawFunc != 0 )
 		engine->drawFunc(engine);
 
@@ -416,6 +419,7 @@ void esMainLoop( ESContext *esContext )
             if (g_androidState->destroyRequested != 0)
 			{
                 engine_term_display(esContext);
+                esStopInputRecording(esContext);
                 return;
             }
         }
@@ -428,7 +432,7 @@ void esMainLoop( ESContext *esContext )
 		{
 			if( deltaTime > 0.0f )
 			{
-				esContext->updateFunc ( esContext, deltaTime );
+				esRunUpdates( esContext, deltaTime );
 	//			clearInput();
 			}	
 
@@ -443,6 +447,9 @@ void esMainLoop( ESContext *esContext )
 				// Drawing is throttled to the screen update rate, so there
 				// is no need to do timing here.
 				engine_draw_frame(esContext);
+				esLimitFrameRate(esContext, timer);
+				YAM2D_PROFILE_FRAME();
+				RenderStats::endFrame();
 			}
 		}
     }
@@ -26,16 +26,16 @@
 #include "es_util_win32.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <OGLES/Include/GLES/gl.h>
 #include <OGLES/Include/EGL/egl.h>
 #include <config.h>
-
-#if defined(ANDROID)
-#include <android/log.h>
-#define printLog(...) ((void)__android_log_print(ANDROID_LOG_INFO, "yam2d", __VA_ARGS__))
-#else
-#define printLog printf
-#endif
+#include <ElapsedTimer.h>
+#include <Thread.h>
+#include <Profiler.h>
+#include <Logger.h>
+#include <InputRecording.h>
+#include <math.h>
 
 namespace yam2d
 {
@@ -43,16 +43,11 @@ namespace yam2d
 // anonymous namespace for internal functions
 namespace
 {
-#if defined(ANDROID)
+#if defined(ANDROID) || defined(YAM2D_LINUX)
 template <class _Tp>
 inline const _Tp& (max)(const _Tp& __a, const _Tp& __b) {  return  __a < __b ? __b : __a; }
 #endif
 
-#if defined(YAM_WRITING_LOGS_TO_FILE)
-	const char* const logFileName = 	YAM_WRITING_LOGS_TO_FILE;
-	FILE* logFileHandle = (strlen(logFileName) > 0) ? fopen (logFileName,"w") : NULL;
-#endif
-
 	int toInteger(double v)
 	{
 		return int(v+0.5);
@@ -91,27 +86,128 @@ void esRegisterTouchEventFunc ( ESContext *esContext, void (*touchEventFunc) ( E
 	esContext->touchEventFunc = touchEventFunc;
 }
 
-void esLogMessage ( const char *formatStr, ... )
+void esSetFixedTimestep(ESContext *esContext, float timeStep, int maxUpdatesPerFrame)
 {
-	va_list params;
-	char buf[10*1024];
+	assert( timeStep >= 0.0f );
+	assert( maxUpdatesPerFrame > 0 );
+	esContext->fixedTimeStep = timeStep;
+	esContext->maxUpdatesPerFrame = maxUpdatesPerFrame;
+	esContext->updateAccumulator = 0.0f;
+	esContext->interpolationAlpha = 1.0f;
+}
 
-	va_start ( params, formatStr );
-#if defined(_WIN32)
-	vsprintf_s ( buf, sizeof(buf),  formatStr, params );
-#else
-	vsprintf( buf,  formatStr, params );
-#endif
+void esSetTargetFrameRate(ESContext *esContext, float framesPerSecond)
+{
+	assert( framesPerSecond >= 0.0f );
+	esContext->targetFrameTime = framesPerSecond > 0.0f ? 1.0f / framesPerSecond : 0.0f;
+}
 
-	printLog( "%s\n", buf );
-    
-#if defined(YAM_WRITING_LOGS_TO_FILE)
-	if( logFileHandle != NULL )
+float esGetInterpolationAlpha(const ESContext *esContext)
+{
+	return esContext->fixedTimeStep > 0.0f ? esContext->interpolationAlpha : 1.0f;
+}
+
+int esRunUpdates(ESContext *esContext, float deltaTime)
+{
+	if( esContext->inputRecorder != 0 )
 	{
-		fprintf(logFileHandle, "%s\n", buf );
+		esContext->inputRecorder->recordFrame(deltaTime);
 	}
-#endif
 
+	if( esContext->updateFunc == NULL )
+	{
+		return 0;
+	}
+
+	if( esContext->fixedTimeStep <= 0.0f )
+	{
+		YAM2D_PROFILE_ZONE("update");
+		esContext->updateFunc(esContext, deltaTime);
+		return 1;
+	}
+
+	const float timeStep = esContext->fixedTimeStep;
+	esContext->updateAccumulator += deltaTime;
+	int numUpdates = 0;
+	while( esContext->updateAccumulator >= timeStep && numUpdates < esContext->maxUpdatesPerFrame && !esContext->quitFlag )
+	{
+		YAM2D_PROFILE_ZONE("update");
+		esContext->updateFunc(esContext, timeStep);
+		esContext->updateAccumulator -= timeStep;
+		++numUpdates;
+	}
+
+	// Could not catch up: drop whole steps, which were left over, instead of trying to run them in next frames.
+	if( esContext->updateAccumulator >= timeStep )
+	{
+		esContext->updateAccumulator = fmodf(esContext->updateAccumulator, timeStep);
+	}
+
+	esContext->interpolationAlpha = esContext->updateAccumulator / timeStep;
+	return numUpdates;
+}
+
+bool esStartInputRecording(ESContext *esContext, const char* fileName)
+{
+	esStopInputRecording(esContext);
+	InputRecorder* recorder = new InputRecorder();
+	if( !recorder->open(fileName) )
+	{
+		delete recorder;
+		return false;
+	}
+
+	esContext->inputRecorder = recorder;
+	return true;
+}
+
+void esStopInputRecording(ESContext *esContext)
+{
+	delete esContext->inputRecorder;
+	esContext->inputRecorder = 0;
+}
+
+void esLimitFrameRate(ESContext *esContext, const ElapsedTimer& frameTimer)
+{
+	YAM2D_PROFILE_ZONE("esLimitFrameRate");
+	const float targetFrameTime = esContext->targetFrameTime;
+	if( targetFrameTime <= 0.0f )
+	{
+		return;
+	}
+
+	// Sleeps may last longer than asked, so the longest recent sleep is kept as margin and the last moments 
+	// of the frame are waited by yielding. Margin decays, so a single late wake up does not stay in effect.
+	const float minSleepMargin = 0.001f;
+	esContext->sleepMargin *= 0.99f;
+	if( esContext->sleepMargin < minSleepMargin )
+	{
+		esContext->sleepMargin = minSleepMargin;
+	}
+
+	while( targetFrameTime - frameTimer.getTime() > esContext->sleepMargin )
+	{
+		float sleepStart = frameTimer.getTime();
+		Thread::sleep(1);
+		float sleepTime = frameTimer.getTime() - sleepStart;
+		if( sleepTime > esContext->sleepMargin )
+		{
+			esContext->sleepMargin = sleepTime;
+		}
+	}
+
+	while( frameTimer.getTime() < targetFrameTime )
+	{
+		Thread::sleep(0);
+	}
+}
+
+void esLogMessage ( const char *formatStr, ... )
+{
+	va_list params;
+
+	va_start ( params, formatStr );
+	Logger::writeV( 0, Logger::LEVEL_INFO, Logger::CATEGORY_GENERAL, formatStr, params );
 	va_end ( params );
 }
 
@@ -129,17 +225,11 @@ void esLogEngineError( const char *formatStr, ... )
 	vsprintf( buf,  formatStr, params );
 #endif
     
-	printLog( "Error: %s\n", buf );
-
-#if defined(YAM_WRITING_LOGS_TO_FILE)
-	if( logFileHandle != NULL )
-	{
-		fprintf(logFileHandle, "Error: %s\n", buf );
-	}
-#endif
-
 	va_end ( params );
 
+	// Errors are written before write returns, so the message is in the log before throwing.
+	Logger::write( 0, Logger::LEVEL_ERROR, Logger::CATEGORY_ENGINE, "%s", buf );
+
 	std::string s = buf;
 	throw std::string(s);
 #else
@@ -151,17 +241,9 @@ void esLogEngineDebug( const char *formatStr, ... )
 {
 #if defined(DEBUG_LOGS_ENABLED)
 	va_list params;
-	char buf[BUFSIZ];
 
 	va_start ( params, formatStr );
-#if defined(_WIN32)
-	vsprintf_s ( buf, sizeof(buf),  formatStr, params );
-#else
-	vsprintf( buf,  formatStr, params );
-#endif
-    
-	printLog( "Engine: %s\n", buf );
-    
+	Logger::writeV( 0, Logger::LEVEL_DEBUG, Logger::CATEGORY_ENGINE, formatStr, params );
 	va_end ( params );
 #else
 	(void)formatStr;
@@ -0,0 +1,284 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#include "es_util.h"
+#include "es_util_linux.h"
+#include <es_assert.h>
+#include <config.h>
+#include <ElapsedTimer.h>
+#include <Profiler.h>
+#include <RenderStats.h>
+#include <InputRecording.h>
+#include <Logger.h>
+#include <stdio.h>
+#include <algorithm>
+#include <exception>
+
+namespace yam2d
+{
+
+// anonymous namespace for internal functions
+namespace
+{
+	ESContext* g_lastCtx = 0;
+
+	// Handles for null EGL, which only need to differ from EGL_NO_DISPLAY etc.
+	int nullDisplay = 0;
+	int nullSurface = 0;
+	int nullContext = 0;
+
+	// Frame times of input replay, see linuxSetInputReplay.
+	FILE* replayTimingFile = 0;
+	std::vector<float> replayFrameTimes;
+
+	/** Sets input state to recorded frame with the input functions of es_util_linux.h. */
+	void applyInputFrame( ESContext* esContext, const InputFrame& frame )
+	{
+		for( int i=0; i<InputFrame::NUM_KEYS; ++i )
+		{
+			keyState( KeyCodes(i), frame.isKeyDown(i) );
+		}
+
+		mouseState( frame.mouseButtons[0], frame.mouseButtons[1], frame.mouseButtons[2], frame.mouseX, frame.mouseY );
+		mouseWheel( frame.mouseWheelDelta - getMouseWheelDelta() );
+
+		// Changed touches are sent as touch events, so that touch callback of the application sees them too.
+		for( size_t i=0; i<frame.touches.size(); ++i )
+		{
+			const Touch touch = frame.touches[i];
+			const std::vector<Touch>& touches = getActiveTouches();
+			bool wasPressed = false;
+			bool isChanged = true;
+			if( size_t(touch.touchId) < touches.size() )
+			{
+				const Touch& current = touches[touch.touchId];
+				wasPressed = current.pressed;
+				isChanged = current.pressed != touch.pressed || current.x != touch.x || current.y != touch.y;
+			}
+
+			if( isChanged && (touch.pressed || wasPressed) )
+			{
+				TouchEventType type = touch.pressed ? (wasPressed ? TOUCH_MOVE : TOUCH_BEGIN) : TOUCH_END;
+				touchEventFunc( esContext, type, touch.touchId, touch.x, touch.y );
+			}
+		}
+	}
+
+	void logReplaySummary()
+	{
+		if( replayFrameTimes.empty() )
+		{
+			esLogMessage("Input replay: no frames");
+			return;
+		}
+
+		std::vector<float> times = replayFrameTimes;
+		std::sort(times.begin(), times.end());
+		float total = 0.0f;
+		for( size_t i=0; i<times.size(); ++i )
+		{
+			total += times[i];
+		}
+
+		const int last = int(times.size()) - 1;
+		esLogMessage("Input replay: %d frames in %.1f ms, frame time avg %.3f min %.3f median %.3f 95%% %.3f 99%% %.3f max %.3f ms",
+			int(times.size()), total, total/float(times.size()), times[0], times[last/2], times[(last*95)/100], 
+			times[(last*99)/100], times[last]);
+	}
+}
+
+ESContext *esGetCurrentContext()
+{
+	return g_lastCtx;
+}
+
+void linuxSetMaxFrames( ESContext *esContext, int maxFrames )
+{
+	assert( maxFrames >= 0 );
+	esContext->maxFrames = maxFrames;
+}
+
+bool linuxSetInputReplay( ESContext *esContext, const char* fileName, const char* timingFileName )
+{
+	assert( esContext != 0 );
+	delete esContext->inputReplay;
+	esContext->inputReplay = new InputPlayback();
+	if( !esContext->inputReplay->open(fileName) )
+	{
+		delete esContext->inputReplay;
+		esContext->inputReplay = 0;
+		return false;
+	}
+
+	if( replayTimingFile != 0 )
+	{
+		fclose(replayTimingFile);
+		replayTimingFile = 0;
+	}
+
+	if( timingFileName != 0 )
+	{
+		replayTimingFile = fopen(timingFileName, "w");
+		if( replayTimingFile == 0 )
+		{
+			YAM2D_LOG_WARNING(Logger::CATEGORY_ENGINE, "[%s] Timing file %s could not be created", __FUNCTION__, timingFileName);
+		}
+		else
+		{
+			fprintf(replayTimingFile, "frame,delta time ms,updates,frame time ms\n");
+		}
+	}
+
+	replayFrameTimes.clear();
+	return true;
+}
+
+const std::vector<float>& linuxGetReplayFrameTimes()
+{
+	return replayFrameTimes;
+}
+
+GLboolean esCreateWindow ( ESContext *esContext, const char* title, GLint width, GLint height, GLint flags )
+{
+	assert( esContext != 0 );
+	(void)flags;
+	g_lastCtx = esContext;
+	esContext->width = width;
+	esContext->height = height;
+	esContext->eglDisplay = (EGLDisplay)&nullDisplay;
+	esContext->eglSurface = (EGLSurface)&nullSurface;
+	esContext->eglContext = (EGLContext)&nullContext;
+	YAM2D_LOG_DEBUG(Logger::CATEGORY_ENGINE, "[%s] Headless window \"%s\" %dx%d", __FUNCTION__, title, width, height);
+	return GL_TRUE;
+}
+
+
+void esMainLoop ( ESContext *esContext )
+{
+	assert( esContext != 0 );
+	if( esContext->initFunc != 0 && false == esContext->initFunc(esContext) )
+	{
+		return;
+	}
+
+	ElapsedTimer timer;
+	timer.reset();
+	ElapsedTimer frameTimer;
+	InputFrame replayFrame;
+	bool done = false;
+	int numFrames = 0;
+	while( !done )
+	{
+		try
+		{
+			float deltaTime = timer.getTime();
+			timer.reset();
+			if( esContext->inputReplay != 0 )
+			{
+				if( !esContext->inputReplay->readFrame(replayFrame) )
+				{
+					done = true;
+					continue;
+				}
+
+				applyInputFrame( esContext, replayFrame );
+				deltaTime = replayFrame.deltaTime;
+			}
+
+			frameTimer.reset();
+			int numUpdates = 0;
+			if( deltaTime > 0.0f )
+			{
+				numUpdates = esRunUpdates( esContext, deltaTime );
+				if( numUpdates > 0 )
+				{
+					clearInput();
+				}
+			}
+
+			if( !esContext->quitFlag && esContext->drawFunc != 0 )
+			{
+				YAM2D_PROFILE_ZONE("draw");
+				esContext->drawFunc( esContext );
+				eglSwapBuffers( esContext->eglDisplay, esContext->eglSurface );
+			}
+
+			if( esContext->inputReplay != 0 )
+			{
+				const float frameTime = 1000.0f*frameTimer.getTime();
+				if( replayTimingFile != 0 )
+				{
+					fprintf(replayTimingFile, "%d,%.4f,%d,%.4f\n", int(replayFrameTimes.size()), 1000.0f*deltaTime, numUpdates, frameTime);
+				}
+				replayFrameTimes.push_back(frameTime);
+			}
+		}
+		catch (std::exception& e)
+		{
+			printf("std::exception: %s\n", e.what());
+			done = true;
+		}
+		catch (...)
+		{
+			printf("Unknown exception ocurred!\n");
+			done = true;
+		}
+
+		++numFrames;
+		if( esContext->quitFlag || (esContext->maxFrames > 0 && numFrames >= esContext->maxFrames) )
+		{
+			done = true;
+		}
+
+		if( !done )
+		{
+			if( esContext->inputReplay == 0 )
+			{
+				esLimitFrameRate( esContext, timer );
+			}
+			YAM2D_PROFILE_FRAME();
+			RenderStats::endFrame();
+		}
+	}
+
+	if ( esContext->deinitFunc != NULL )
+	{
+		esContext->deinitFunc ( esContext );
+	}
+
+	if( esContext->inputReplay != 0 )
+	{
+		logReplaySummary();
+		delete esContext->inputReplay;
+		esContext->inputReplay = 0;
+		if( replayTimingFile != 0 )
+		{
+			fclose(replayTimingFile);
+			replayTimingFile = 0;
+		}
+	}
+
+	esStopInputRecording( esContext );
+}
+
+}
@@ -0,0 +1,385 @@
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+// http://code.google.com/p/yam2d/
+//
+// Copyright (c) 2013 Mikko Romppainen
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in the
+// Software without restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+// and to permit persons to whom the Software is furnished to do so, subject to the
+// following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies
+// or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+// FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+// OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+// Null GL ES 1.1 and EGL backend of headless Linux platform. Calls do not draw anything, but are counted to
+// NullGLStats. Calls, which set state, are compared against the previous value of the state, so that redundant
+// state changes can be told apart. Functions, which the engine and examples do not use, are left out.
+
+#include "es_util.h"
+#include "es_util_linux.h"
+#include <es_assert.h>
+#include <string.h>
+#include <map>
+#include <utility>
+
+namespace yam2d
+{
+
+// anonymous namespace for internal functions
+namespace
+{
+	enum StateKey
+	{
+		STATE_ENABLE,
+		STATE_CLIENT_STATE,
+		STATE_ACTIVE_TEXTURE,
+		STATE_CLIENT_ACTIVE_TEXTURE,
+		STATE_TEXTURE,
+		STATE_TEX_ENV,
+		STATE_BLEND_FUNC,
+		STATE_ALPHA_FUNC,
+		STATE_DEPTH_FUNC,
+		STATE_DEPTH_MASK,
+		STATE_COLOR_MASK,
+		STATE_CULL_FACE,
+		STATE_FRONT_FACE,
+		STATE_SHADE_MODEL,
+		STATE_MATRIX_MODE,
+		STATE_HINT,
+		STATE_COLOR,
+		STATE_CLEAR_COLOR,
+		STATE_VIEWPORT,
+		STATE_SCISSOR,
+		STATE_PIXEL_STORE,
+		STATE_LINE_WIDTH,
+		STATE_POINT_SIZE
+	};
+
+	// State key and target of the state, like capability or texture unit.
+	typedef std::pair<int, unsigned> StateId;
+
+	std::map<StateId, unsigned long long> states;
+	NullGLStats stats;
+	GLuint numTextureNames = 0;
+	GLuint numBufferNames = 0;
+	GLenum activeTexture = GL_TEXTURE0;
+	GLint viewport[4];
+
+	/** FNV-1a hash of values of a call, which is compared against the previous call. */
+	unsigned long long hashBytes(const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		unsigned long long hash = 14695981039346656037ULL;
+		for( size_t i=0; i<size; ++i )
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	/** Sets state and returns true, if it changed. */
+	bool setState(int key, unsigned target, unsigned long long value)
+	{
+		std::pair<std::map<StateId, unsigned long long>::iterator, bool> res = states.insert(std::make_pair(StateId(key, target), value));
+		if( !res.second && res.first->second == value )
+		{
+			++stats.numRedundantStateChanges;
+			return false;
+		}
+
+		res.first->second = value;
+		++stats.numStateChanges;
+		return true;
+	}
+
+	bool setState4f(int key, unsigned target, GLfloat a, GLfloat b, GLfloat c, GLfloat d)
+	{
+		const GLfloat values[4] = { a, b, c, d };
+		return setState(key, target, hashBytes(values, sizeof(values)));
+	}
+
+	/** For states, which are not compared, like matrices and array pointers. */
+	void changeState()
+	{
+		++stats.numStateChanges;
+	}
+
+	int getBytesPerPixel(GLenum format, GLenum type)
+	{
+		if( type == GL_UNSIGNED_SHORT_5_6_5 || type == GL_UNSIGNED_SHORT_4_4_4_4 || type == GL_UNSIGNED_SHORT_5_5_5_1 )
+		{
+			return 2;
+		}
+
+		switch( format )
+		{
+		case GL_RGBA:				return 4;
+		case GL_RGB:				return 3;
+		case GL_LUMINANCE_ALPHA:	return 2;
+		default:					return 1;
+		}
+	}
+
+	void textureUploaded(int numBytes)
+	{
+		++stats.numTextureUploads;
+		stats.numTextureBytes += numBytes;
+	}
+}
+
+const NullGLStats& nullGLGetStats()
+{
+	return stats;
+}
+
+void nullGLResetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+}
+
+
+using namespace yam2d;
+
+// GL
+
+void GL_APIENTRY glActiveTexture (GLenum texture) { setState(STATE_ACTIVE_TEXTURE, 0, texture); activeTexture = texture; }
+void GL_APIENTRY glAlphaFunc (GLenum func, GLclampf ref) { setState4f(STATE_ALPHA_FUNC, 0, GLfloat(func), ref, 0.0f, 0.0f); }
+void GL_APIENTRY glBlendFunc (GLenum sfactor, GLenum dfactor) { setState(STATE_BLEND_FUNC, 0, ((unsigned long long)sfactor << 32) | dfactor); }
+void GL_APIENTRY glClear (GLbitfield mask) { (void)mask; ++stats.numClears; }
+void GL_APIENTRY glClearColor (GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha) { setState4f(STATE_CLEAR_COLOR, 0, red, green, blue, alpha); }
+void GL_APIENTRY glClientActiveTexture (GLenum texture) { setState(STATE_CLIENT_ACTIVE_TEXTURE, 0, texture); }
+void GL_APIENTRY glColor4f (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) { setState4f(STATE_COLOR, 0, red, green, blue, alpha); }
+void GL_APIENTRY glColor4ub (GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha) { glColor4f(red/255.0f, green/255.0f, blue/255.0f, alpha/255.0f); }
+void GL_APIENTRY glColorMask (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) { setState(STATE_COLOR_MASK, 0, (red<<3)|(green<<2)|(blue<<1)|alpha); }
+void GL_APIENTRY glCullFace (GLenum mode) { setState(STATE_CULL_FACE, 0, mode); }
+void GL_APIENTRY glDepthFunc (GLenum func) { setState(STATE_DEPTH_FUNC, 0, func); }
+void GL_APIENTRY glDepthMask (GLboolean flag) { setState(STATE_DEPTH_MASK, 0, flag); }
+void GL_APIENTRY glDisable (GLenum cap) { setState(STATE_ENABLE, cap, 0); }
+void GL_APIENTRY glDisableClientState (GLenum array) { setState(STATE_CLIENT_STATE, array, 0); }
+void GL_APIENTRY glEnable (GLenum cap) { setState(STATE_ENABLE, cap, 1); }
+void GL_APIENTRY glEnableClientState (GLenum array) { setState(STATE_CLIENT_STATE, array, 1); }
+void GL_APIENTRY glFrontFace (GLenum mode) { setState(STATE_FRONT_FACE, 0, mode); }
+void GL_APIENTRY glHint (GLenum target, GLenum mode) { setState(STATE_HINT, target, mode); }
+void GL_APIENTRY glLineWidth (GLfloat width) { setState4f(STATE_LINE_WIDTH, 0, width, 0.0f, 0.0f, 0.0f); }
+void GL_APIENTRY glMatrixMode (GLenum mode) { setState(STATE_MATRIX_MODE, 0, mode); }
+void GL_APIENTRY glPixelStorei (GLenum pname, GLint param) { setState(STATE_PIXEL_STORE, pname, param); }
+void GL_APIENTRY glPointSize (GLfloat size) { setState4f(STATE_POINT_SIZE, 0, size, 0.0f, 0.0f, 0.0f); }
+void GL_APIENTRY glScissor (GLint x, GLint y, GLsizei width, GLsizei height) { setState4f(STATE_SCISSOR, 0, GLfloat(x), GLfloat(y), GLfloat(width), GLfloat(height)); }
+void GL_APIENTRY glShadeModel (GLenum mode) { setState(STATE_SHADE_MODEL, 0, mode); }
+void GL_APIENTRY glTexEnvf (GLenum target, GLenum pname, GLfloat param) { setState4f(STATE_TEX_ENV, activeTexture, GLfloat(target), GLfloat(pname), param, 0.0f); }
+void GL_APIENTRY glTexEnvi (GLenum target, GLenum pname, GLint param) { glTexEnvf(target, pname, GLfloat(param)); }
+void GL_APIENTRY glTexEnvx (GLenum target, GLenum pname, GLfixed param) { glTexEnvf(target, pname, GLfloat(param)); }
+
+void GL_APIENTRY glViewport (GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	setState4f(STATE_VIEWPORT, 0, GLfloat(x), GLfloat(y), GLfloat(width), GLfloat(height));
+	viewport[0] = x;
+	viewport[1] = y;
+	viewport[2] = width;
+	viewport[3] = height;
+}
+
+void GL_APIENTRY glBindTexture (GLenum target, GLuint texture)
+{
+	(void)target;
+	if( setState(STATE_TEXTURE, activeTexture, texture) )
+	{
+		++stats.numTextureBinds;
+	}
+}
+
+// Texture parameters belong to texture objects, so they are not compared.
+void GL_APIENTRY glTexParameterf (GLenum target, GLenum pname, GLfloat param) { (void)target; (void)pname; (void)param; changeState(); }
+void GL_APIENTRY glTexParameteri (GLenum target, GLenum pname, GLint param) { (void)target; (void)pname; (void)param; changeState(); }
+void GL_APIENTRY glTexParameterx (GLenum target, GLenum pname, GLfixed param) { (void)target; (void)pname; (void)param; changeState(); }
+
+// Matrices and array pointers are assumed to change on each call.
+void GL_APIENTRY glLoadIdentity (void) { changeState(); }
+void GL_APIENTRY glLoadMatrixf (const GLfloat *m) { (void)m; changeState(); }
+void GL_APIENTRY glMultMatrixf (const GLfloat *m) { (void)m; changeState(); }
+void GL_APIENTRY glOrthof (GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat zNear, GLfloat zFar) { (void)left; (void)right; (void)bottom; (void)top; (void)zNear; (void)zFar; changeState(); }
+void GL_APIENTRY glFrustumf (GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat zNear, GLfloat zFar) { (void)left; (void)right; (void)bottom; (void)top; (void)zNear; (void)zFar; changeState(); }
+void GL_APIENTRY glPushMatrix (void) { changeState(); }
+void GL_APIENTRY glPopMatrix (void) { changeState(); }
+void GL_APIENTRY glRotatef (GLfloat angle, GLfloat x, GLfloat y, GLfloat z) { (void)angle; (void)x; (void)y; (void)z; changeState(); }
+void GL_APIENTRY glScalef (GLfloat x, GLfloat y, GLfloat z) { (void)x; (void)y; (void)z; changeState(); }
+void GL_APIENTRY glTranslatef (GLfloat x, GLfloat y, GLfloat z) { (void)x; (void)y; (void)z; changeState(); }
+void GL_APIENTRY glColorPointer (GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) { (void)size; (void)type; (void)stride; (void)pointer; changeState(); }
+void GL_APIENTRY glNormalPointer (GLenum type, GLsizei stride, const GLvoid *pointer) { (void)type; (void)stride; (void)pointer; changeState(); }
+void GL_APIENTRY glTexCoordPointer (GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) { (void)size; (void)type; (void)stride; (void)pointer; changeState(); }
+void GL_APIENTRY glVertexPointer (GLint size, GLenum type, GLsizei stride, const GLvoid *pointer) { (void)size; (void)type; (void)stride; (void)pointer; changeState(); }
+
+void GL_APIENTRY glDrawArrays (GLenum mode, GLint first, GLsizei count)
+{
+	(void)mode;
+	(void)first;
+	++stats.numDrawCalls;
+	stats.numVertices += count;
+}
+
+void GL_APIENTRY glDrawElements (GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+{
+	(void)mode;
+	(void)type;
+	(void)indices;
+	++stats.numDrawCalls;
+	stats.numVertices += count;
+}
+
+void GL_APIENTRY glGenTextures (GLsizei n, GLuint *textures)
+{
+	for( GLsizei i=0; i<n; ++i )
+	{
+		textures[i] = ++numTextureNames;
+	}
+}
+
+void GL_APIENTRY glDeleteTextures (GLsizei n, const GLuint *textures)
+{
+	// Deleted textures are unbound.
+	for( GLsizei i=0; i<n; ++i )
+	{
+		for( std::map<StateId, unsigned long long>::iterator it = states.begin(); it != states.end(); ++it )
+		{
+			if( it->first.first == STATE_TEXTURE && it->second == textures[i] )
+			{
+				it->second = 0;
+			}
+		}
+	}
+}
+
+GLboolean GL_APIENTRY glIsTexture (GLuint texture)
+{
+	return (texture != 0 && texture <= numTextureNames) ? GL_TRUE : GL_FALSE;
+}
+
+void GL_APIENTRY glTexImage2D (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *pixels)
+{
+	(void)target;
+	(void)level;
+	(void)internalformat;
+	(void)border;
+	textureUploaded(pixels != 0 ? width*height*getBytesPerPixel(format, type) : 0);
+}
+
+void GL_APIENTRY glTexSubImage2D (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *pixels)
+{
+	(void)target;
+	(void)level;
+	(void)xoffset;
+	(void)yoffset;
+	(void)pixels;
+	textureUploaded(width*height*getBytesPerPixel(format, type));
+}
+
+void GL_APIENTRY glCompressedTexImage2D (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const GLvoid *data)
+{
+	(void)target;
+	(void)level;
+	(void)internalformat;
+	(void)width;
+	(void)height;
+	(void)border;
+	(void)data;
+	textureUploaded(imageSize);
+}
+
+void GL_APIENTRY glGenBuffers (GLsizei n, GLuint *buffers)
+{
+	for( GLsizei i=0; i<n; ++i )
+	{
+		buffers[i] = ++numBufferNames;
+	}
+}
+
+void GL_APIENTRY glDeleteBuffers (GLsizei n, const GLuint *buffers) { (void)n; (void)buffers; }
+void GL_APIENTRY glBindBuffer (GLenum target, GLuint buffer) { (void)target; (void)buffer; changeState(); }
+void GL_APIENTRY glBufferData (GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage) { (void)target; (void)size; (void)data; (void)usage; }
+void GL_APIENTRY glBufferSubData (GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data) { (void)target; (void)offset; (void)size; (void)data; }
+
+void GL_APIENTRY glFinish (void) {}
+void GL_APIENTRY glFlush (void) {}
+GLenum GL_APIENTRY glGetError (void) { return GL_NO_ERROR; }
+
+GLboolean GL_APIENTRY glIsEnabled (GLenum cap)
+{
+	std::map<StateId, unsigned long long>::iterator it = states.find(StateId(STATE_ENABLE, cap));
+	return (it != states.end() && it->second != 0) ? GL_TRUE : GL_FALSE;
+}
+
+void GL_APIENTRY glGetIntegerv (GLenum pname, GLint *params)
+{
+	switch( pname )
+	{
+	case GL_MAX_TEXTURE_SIZE:	params[0] = 4096; break;
+	case GL_MAX_TEXTURE_UNITS:	params[0] = 2; break;
+	case GL_VIEWPORT:			memcpy(params, viewport, sizeof(viewport)); break;
+	default:					params[0] = 0; break;
+	}
+}
+
+void GL_APIENTRY glGetFloatv (GLenum pname, GLfloat *params)
+{
+	(void)pname;
+	params[0] = 0.0f;
+}
+
+const GLubyte * GL_APIENTRY glGetString (GLenum name)
+{
+	switch( name )
+	{
+	case GL_VENDOR:		return (const GLubyte*)"yam2d";
+	case GL_RENDERER:	return (const GLubyte*)"Null GL";
+	case GL_VERSION:	return (const GLubyte*)"OpenGL ES-CM 1.1";
+	default:			return (const GLubyte*)"";
+	}
+}
+
+void GL_APIENTRY glReadPixels (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels)
+{
+	(void)x;
+	(void)y;
+	memset(pixels, 0, width*height*getBytesPerPixel(format, type));
+}
+
+// EGL
+
+EGLint EGLAPIENTRY eglGetError(void) { return EGL_SUCCESS; }
+EGLBoolean EGLAPIENTRY eglSwapInterval(EGLDisplay dpy, EGLint interval) { (void)dpy; (void)interval; return EGL_TRUE; }
+EGLContext EGLAPIENTRY eglGetCurrentContext(void) { ESContext* esContext = esGetCurrentContext(); return esContext != 0 ? esContext->eglContext : EGL_NO_CONTEXT; }
+EGLDisplay EGLAPIENTRY eglGetCurrentDisplay(void) { ESContext* esContext = esGetCurrentContext(); return esContext != 0 ? esContext->eglDisplay : EGL_NO_DISPLAY; }
+
+EGLBoolean EGLAPIENTRY eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+{
+	(void)dpy;
+	(void)surface;
+	++stats.numSwaps;
+	return EGL_TRUE;
+}
+
+EGLBoolean EGLAPIENTRY eglQuerySurface(EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint *value)
+{
+	(void)dpy;
+	(void)surface;
+	ESContext* esContext = esGetCurrentContext();
+	if( esContext == 0 || (attribute != EGL_WIDTH && attribute != EGL_HEIGHT) )
+	{
+		return EGL_FALSE;
+	}
+
+	*value = (attribute == EGL_WIDTH) ? esContext->width : esContext->height;
+	return EGL_TRUE;
+}
@@ -28,6 +28,8 @@
 #include <es_assert.h>
 #include <config.h>
 #include <ElapsedTimer.h>
+#include <Profiler.h>
+#include <RenderStats.h>
 
 namespace yam2d
 {
@@ -70,6 +72,7 @@ LRESULT WINAPI ESWindowProc ( HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam
 				{
 					if ( esContext->drawFunc && esContext->width > 0 && esContext->height > 0)
 					{
+						YAM2D_PROFILE_ZONE("draw");
 						esContext->drawFunc ( esContext );
 						eglSwapBuffers ( esContext->eglDisplay, esContext->eglSurface );
 					}   
@@ -398,9 +401,12 @@ void winLoop ( ESContext *esContext )
 				{
 					try
 					{
-						esContext->updateFunc ( esContext, deltaTime );
-						g_firstUpdateDone = true;
-						clearInput();
+						// With fixed time step, frames without update keep input for the next update.
+						if( esRunUpdates( esContext, deltaTime ) > 0 )
+						{
+							g_firstUpdateDone = true;
+							clearInput();
+						}
 					}
 					catch (std::exception& e)
 					{
@@ -423,6 +429,9 @@ void winLoop ( ESContext *esContext )
 			if( !done )
 			{
 				SendMessage( esContext->hWnd, WM_PAINT, 0, 0 );
+				esLimitFrameRate( esContext, timer );
+				YAM2D_PROFILE_FRAME();
+				RenderStats::endFrame();
 			}
 		}
 	}
@@ -431,6 +440,8 @@ void winLoop ( ESContext *esContext )
 	{
 		esContext->deinitFunc ( esContext );
 	}
+
+	esStopInputRecording( esContext );
 }
 
 EGLBoolean CreateEGL11Context ( EGLNativeWindowType hWnd, EGLDisplay* eglDisplay,